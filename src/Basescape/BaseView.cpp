@@ -49,6 +49,7 @@ BaseView::BaseView(int width, int height, int x, int y) : InteractiveSurface(wid
 	for (int x = 0; x < BASE_SIZE; x++)
 		for (int y = 0; y < BASE_SIZE; y++)
 			_facilities[x][y] = 0;
+	_occupied = _built = 0;
 
 	_timer = new Timer(100);
 	_timer->onTimer((SurfaceHandler)&BaseView::blink);
@@ -91,6 +92,7 @@ void BaseView::setBase(Base *base)
 	for (int x = 0; x < BASE_SIZE; x++)
 		for (int y = 0; y < BASE_SIZE; y++)
 			_facilities[x][y] = 0;
+	_occupied = _built = 0;
 
 	// Fill grid with base facilities
 	for (std::vector<BaseFacility*>::iterator i = _base->getFacilities()->begin(); i != _base->getFacilities()->end(); i++)
@@ -102,9 +104,48 @@ void BaseView::setBase(Base *base)
 				_facilities[x][y] = *i;
 			}
 		}
+		Uint64 area = areaMask((*i)->getX(), (*i)->getY(), (*i)->getRules()->getSize());
+		_occupied |= area;
+		if ((*i)->getBuildTime() == 0)
+		{
+			_built |= area;
+		}
+	}
+
+	// The view keeps what it drew, so only redraw it when the base looks different
+	std::vector<int> layout = getLayout();
+	if (layout != _drawnLayout)
+	{
+		_drawnLayout = layout;
+		draw();
 	}
+}
 
-	draw();
+/**
+ * Returns everything about the current base that shows up
+ * in the view: where each facility is, what it looks like and
+ * how long it has left to build, and the crafts in the hangars.
+ * @return List of values, the same for bases that look the same.
+ */
+std::vector<int> BaseView::getLayout() const
+{
+	std::vector<int> layout;
+	for (std::vector<BaseFacility*>::const_iterator i = _base->getFacilities()->begin(); i != _base->getFacilities()->end(); i++)
+	{
+		layout.push_back((*i)->getX());
+		layout.push_back((*i)->getY());
+		layout.push_back((*i)->getRules()->getSize());
+		layout.push_back((*i)->getRules()->getSpriteShape());
+		layout.push_back((*i)->getRules()->getSpriteFacility());
+		layout.push_back((*i)->getRules()->getCrafts());
+		layout.push_back((*i)->getBuildTime());
+	}
+	layout.push_back(-1);
+	for (std::vector<Craft*>::const_iterator i = _base->getCrafts()->begin(); i != _base->getCrafts()->end(); i++)
+	{
+		layout.push_back((*i)->getRules()->getSprite());
+	}
+	return layout;
 }
 
 /**
@@ -185,121 +226,138 @@ void BaseView::setSelectable(int size)
  */
 bool BaseView::isPlaceable(RuleBaseFacility *rule) const
 {
-	// Check if square isn't occupied
-	for (int y = _gridY; y < _gridY + rule->getSize(); y++)
+	int size = rule->getSize();
+	if (_gridX < 0 || _gridY < 0 || _gridX + size > BASE_SIZE || _gridY + size > BASE_SIZE)
 	{
-		for (int x = _gridX; x < _gridX + rule->getSize(); x++)
-		{
-			if (x < 0 || x >= BASE_SIZE || y < 0 || y >= BASE_SIZE)
-			{
-				return false;
-			}
-			if (_facilities[x][y] != 0)
-			{
-				return false;
-			}
-		}
+		return false;
 	}
 
-	// Check for another facility to connect to
-	for (int i = 0; i < rule->getSize(); i++)
+	// Check if square isn't occupied
+	Uint64 area = areaMask(_gridX, _gridY, size);
+	if ((area & _occupied) != 0)
 	{
-		if ((_gridX > 0 && _facilities[_gridX - 1][_gridY + i] != 0 && _facilities[_gridX - 1][_gridY + i]->getBuildTime() == 0) ||
-			(_gridY > 0 && _facilities[_gridX + i][_gridY - 1] != 0 && _facilities[_gridX + i][_gridY - 1]->getBuildTime() == 0) ||
-			(_gridX + rule->getSize() < BASE_SIZE && _facilities[_gridX + rule->getSize()][_gridY + i] != 0 && _facilities[_gridX + rule->getSize()][_gridY + i]->getBuildTime() == 0) ||
-			(_gridY + rule->getSize() < BASE_SIZE && _facilities[_gridX + i][_gridY + rule->getSize()] != 0 && _facilities[_gridX + i][_gridY + rule->getSize()]->getBuildTime() == 0))
-		{
-			return true;
-		}
+		return false;
 	}
 
-	return false;
+	// Check for another facility to connect to
+	return (spreadMask(area) & _built) != 0;
 }
 
 /**
  * Counts all the occupied squares connected to a certain position in the
  * grid inclusive, but ignoring facilities under construction.
  * Mostly used to ensure a base stays connected to the Access Lift.
- * -1 = Unoccupied, 0 = Occupied, 1 = Connected.
+ * The grid is kept as bit masks, so this is just a flood fill
+ * of a few shifts, without any allocations.
  * @param x X position in grid.
  * @param y Y position in grid.
- * @param grid Pointer to connection grid (Null to create one from scratch).
  * @param remove Facility to ignore (in case of facility dismantling).
  * @return Number of squares connected to the starting position.
  */
-int BaseView::countConnected(int x, int y, int **grid, BaseFacility *remove) const
+int BaseView::countConnected(int x, int y, BaseFacility *remove) const
 {
-	bool newgrid = (grid == 0);
-
-	// Create connection grid
-	if (newgrid)
+	if (x < 0 || x >= BASE_SIZE || y < 0 || y >= BASE_SIZE || _facilities[x][y] == 0 || _facilities[x][y] == remove)
 	{
-		grid = new int*[BASE_SIZE];
+		return 0;
+	}
 
-		for (int xx = 0; xx < BASE_SIZE; xx++)
-		{
-			grid[xx] = new int[BASE_SIZE];
-			for (int yy = 0; yy < BASE_SIZE; yy++)
-			{
-				if (_facilities[xx][yy] == 0 || _facilities[xx][yy] == remove)
-				{
-					grid[xx][yy] = -1;
-				}
-				else
-				{
-					grid[xx][yy] = 0;
-				}
-			}
-		}
+	Uint64 occupied = _occupied, built = _built;
+	if (remove != 0)
+	{
+		Uint64 area = areaMask(remove->getX(), remove->getY(), remove->getRules()->getSize());
+		occupied &= ~area;
+		built &= ~area;
 	}
 
-	if (x < 0 || x >= BASE_SIZE || y < 0 || y >= BASE_SIZE || grid[x][y] != 0)
+	// Facilities under construction don't connect anything but themselves
+	if (_facilities[x][y]->getBuildTime() > 0)
 	{
-		return 0;
+		return countSquares(areaMask(_facilities[x][y]->getX(), _facilities[x][y]->getY(), _facilities[x][y]->getRules()->getSize()));
 	}
 
-	// Add connected facilities to grid
-	int total = 1;
-	grid[x][y]++;
+	Uint64 connected = squareMask(x, y), last = 0;
+	while (connected != last)
+	{
+		last = connected;
+		connected = spreadMask(connected) & built;
+	}
 
-	// Check for facilities under construction bigger than a square
-	if (_facilities[x][y]->getBuildTime() > 0)
+	// Add the facilities under construction next to the connected ones
+	Uint64 edge = spreadMask(connected) & occupied & ~built;
+	for (std::vector<BaseFacility*>::iterator i = _base->getFacilities()->begin(); i != _base->getFacilities()->end() && edge != 0; i++)
 	{
-		if (x > 0 && _facilities[x - 1][y] == _facilities[x][y])
+		Uint64 area = areaMask((*i)->getX(), (*i)->getY(), (*i)->getRules()->getSize());
+		if ((area & edge) != 0)
 		{
-			total += countConnected(x - 1, y, grid, remove);
+			connected |= area;
+			edge &= ~area;
 		}
-		if (y > 0 && _facilities[x][y - 1] == _facilities[x][y])
-		{
-			total += countConnected(x, y - 1, grid, remove);
-		}
-		if (x < BASE_SIZE - 1 && _facilities[x + 1][y] == _facilities[x][y])
-		{
-			total += countConnected(x + 1, y, grid, remove);
-		}
-		if (y < BASE_SIZE - 1 && _facilities[x][y + 1] == _facilities[x][y])
-		{
-			total += countConnected(x, y + 1, grid, remove);
-		}
-		return total;
 	}
 
-	total += countConnected(x - 1, y, grid, remove);
-	total += countConnected(x, y - 1, grid, remove);
-	total += countConnected(x + 1, y, grid, remove);
-	total += countConnected(x, y + 1, grid, remove);
+	return countSquares(connected);
+}
+
+/**
+ * Returns the bit of a grid square in the base masks,
+ * which have a bit for each square, row by row.
+ * @param x X position in grid.
+ * @param y Y position in grid.
+ * @return Base mask.
+ */
+Uint64 BaseView::squareMask(int x, int y)
+{
+	return (Uint64)1 << (y * BASE_SIZE + x);
+}
+
+/**
+ * Returns the base mask of a square area of the grid,
+ * like the one a facility takes.
+ * @param x X position of the top left square.
+ * @param y Y position of the top left square.
+ * @param size Size of the area in squares.
+ * @return Base mask.
+ */
+Uint64 BaseView::areaMask(int x, int y, int size)
+{
+	Uint64 row = (((Uint64)1 << size) - 1) << x, mask = 0;
+	for (int i = y; i < y + size; i++)
+	{
+		mask |= row << (i * BASE_SIZE);
+	}
+	return mask;
+}
 
-	// Delete connection grid
-	if (newgrid)
+/**
+ * Grows a base mask by one square up, down, left and right,
+ * without wrapping around the edges of the grid.
+ * @param mask Base mask.
+ * @return Grown base mask.
+ */
+Uint64 BaseView::spreadMask(Uint64 mask)
+{
+	Uint64 left = 0, right = 0;
+	for (int y = 0; y < BASE_SIZE; y++)
 	{
-		for (int xx = 0; xx < BASE_SIZE; xx++)
-		{
-			delete[] grid[xx];
-		}
-		delete[] grid;
+		left |= squareMask(0, y);
+		right |= squareMask(BASE_SIZE - 1, y);
 	}
+	Uint64 all = areaMask(0, 0, BASE_SIZE);
+	return (mask | ((mask & ~right) << 1) | ((mask & ~left) >> 1) | (mask << BASE_SIZE) | (mask >> BASE_SIZE)) & all;
+}
 
-	return total;
+/**
+ * Counts the squares set in a base mask.
+ * @param mask Base mask.
+ * @return Number of squares.
+ */
+int BaseView::countSquares(Uint64 mask)
+{
+	int count = 0;
+	for (; mask != 0; mask &= mask - 1)
+	{
+		count++;
+	}
+	return count;
 }
 
 /**
@@ -319,27 +377,13 @@ void BaseView::blink()
 
 	if (_selSize > 0)
 	{
-		SDL_Rect r;
 		if (_blink)
 		{
-			r.w = _selector->getWidth();
-			r.h = _selector->getHeight();
-			r.x = 0;
-			r.y = 0;
-            _selector->drawRect(&r, Palette::blockOffset(1)); 
-			r.w -= 2;
-			r.h -= 2;
-			r.x++;
-			r.y++;
-            _selector->drawRect(&r, 0);
+			_selector->show();
 		}
 		else
 		{
-			r.w = _selector->getWidth();
-			r.h = _selector->getHeight();
-			r.x = 0;
-			r.y = 0;
-            _selector->drawRect(&r, 0); 
+			_selector->hide();
 		}
 	}
 }
@@ -19,6 +19,7 @@
 #ifndef OPENXCOM_BASEVIEW_H
 #define OPENXCOM_BASEVIEW_H
 
+#include <vector>
 #include "../Engine/InteractiveSurface.h"
 
 namespace OpenXcom
@@ -44,11 +45,16 @@ private:
 	Base *_base;
 	SurfaceSet *_texture;
 	BaseFacility *_facilities[BASE_SIZE][BASE_SIZE], *_selFacility;
+	Uint64 _occupied, _built;
 	Font *_big, *_small;
 	int _gridX, _gridY, _selSize;
 	Surface *_selector;
 	bool _blink;
 	Timer *_timer;
+	std::vector<int> _drawnLayout;
+
+	/// Gets everything about the base that shows up in the view.
+	std::vector<int> getLayout() const;
 public:
 	/// Creates a new base view at the specified position and size.
 	BaseView(int width, int height, int x = 0, int y = 0);
@@ -71,7 +77,15 @@ public:
 	/// Checks if a facility can be placed.
 	bool isPlaceable(RuleBaseFacility *rule) const;
 	/// Counts the squares connected to a grid position.
-	int countConnected(int x, int y, int **grid, BaseFacility *remove = 0) const;
+	int countConnected(int x, int y, BaseFacility *remove = 0) const;
+	/// Gets the bit of a grid square in a base mask.
+	static Uint64 squareMask(int x, int y);
+	/// Gets the mask of a square area of the grid.
+	static Uint64 areaMask(int x, int y, int size);
+	/// Gets a base mask grown by one square in every direction.
+	static Uint64 spreadMask(Uint64 mask);
+	/// Counts the squares in a base mask.
+	static int countSquares(Uint64 mask);
 	/// Handles the timers.
 	void think();
 	/// Blinks the selector.
@@ -55,7 +55,7 @@ namespace OpenXcom
  * @param base Pointer to the base to get info from.
  * @param globe Pointer to the Geoscape globe.
  */
-BasescapeState::BasescapeState(Game *game, Base *base, Globe *globe) : State(game), _base(base), _globe(globe)
+BasescapeState::BasescapeState(Game *game, Base *base, Globe *globe) : State(game), _base(base), _globe(globe), _ownsBase(false)
 {
 	// Create objects
 	_view = new BaseView(192, 192, 0, 8);
@@ -175,16 +175,8 @@ BasescapeState::BasescapeState(Game *game, Base *base, Globe *globe) : State(gam
  */
 BasescapeState::~BasescapeState()
 {
-	// Clean up any temporary bases
-	bool exists = false;
-	for (std::vector<Base*>::iterator i = _game->getSavedGame()->getBases()->begin(); i != _game->getSavedGame()->getBases()->end() && !exists; i++)
-	{
-		if (*i == _base)
-		{
-			exists = true;
-		}
-	}
-	if (!exists)
+	// Clean up the blank base, if there's one
+	if (_ownsBase)
 	{
 		delete _base;
 	}
@@ -196,6 +188,9 @@ BasescapeState::~BasescapeState()
  */
 void BasescapeState::init()
 {
+	// Set palette
+	_game->setPalette(_game->getResourcePack()->getPalette("PALETTES.DAT_1")->getColors());
+
 	if (_game->getSavedGame()->getBases()->size() > 0)
 	{
 		bool exists = false;
@@ -209,6 +204,11 @@ void BasescapeState::init()
 		// If base was removed, select first one
 		if (!exists)
 		{
+			if (_ownsBase)
+			{
+				delete _base;
+				_ownsBase = false;
+			}
 			_base = _game->getSavedGame()->getBases()->front();
 			_mini->setSelectedBase(0);
 		}
@@ -216,7 +216,11 @@ void BasescapeState::init()
 	else
 	{
 		// Use a blank base for special case when player has no bases
-		_base = new Base(_game->getRuleset());
+		if (!_ownsBase)
+		{
+			_base = new Base(_game->getRuleset());
+			_ownsBase = true;
+		}
 	}
 
 	_view->setBase(_base);
@@ -224,23 +228,30 @@ void BasescapeState::init()
 	_txtBase->setText(_base->getName());
 
 	// Get area
-	for (std::vector<Region*>::iterator i = _game->getSavedGame()->getRegions()->begin(); i != _game->getSavedGame()->getRegions()->end(); i++)
+	Region *region = _game->getSavedGame()->locateRegion(_base->getLongitude(), _base->getLatitude());
+	if (region != 0)
 	{
-		if ((*i)->getRules()->insideRegion(_base->getLongitude(), _base->getLatitude()))
-		{
-			_txtLocation->setText(_game->getLanguage()->getString((*i)->getRules()->getType()));
-			break;
-		}
+		_txtLocation->setText(_game->getLanguage()->getString(region->getRules()->getType()));
 	}
 
 	std::wstring s = _game->getLanguage()->getString("STR_FUNDS");
 	s += Text::formatFunding(_game->getSavedGame()->getFunds());
 	_txtFunds->setText(s);
 
-	if (_game->getSavedGame()->getBases()->size() == 8)
-	{
-		_btnNewBase->setVisible(false);
-	}
+	_btnNewBase->setVisible(_game->getSavedGame()->getBases()->size() < 8);
+}
+
+/**
+ * The screen can be reused as long as it's showing
+ * one of the player's bases, a blank base is only
+ * cleaned up along with the screen. Only the blank base
+ * belongs to the screen, any other base might be gone
+ * by the time a cached screen is deleted.
+ * @return Reusable?
+ */
+bool BasescapeState::isReusable() const
+{
+	return !_ownsBase;
 }
 
 /**
@@ -390,7 +401,7 @@ void BasescapeState::viewClick(Action *action)
 			_game->pushState(new BasescapeErrorState(_game, "STR_FACILITY_IN_USE"));
 		}
 		// Would base become disconnected? (ocuppied squares connected to Access Lift < total squares occupied by base)
-		else if (_view->countConnected(x, y, 0, fac) < squares)
+		else if (_view->countConnected(x, y, fac) < squares)
 		{
 			_game->pushState(new BasescapeErrorState(_game, "STR_CANNOT_DISMANTLE_FACILITY"));
 		}
@@ -44,6 +44,7 @@ private:
 	TextButton *_btnNewBase, *_btnBaseInfo, *_btnSoldiers, *_btnCrafts, *_btnFacilities, *_btnResearch, *_btnManufacture, *_btnTransfer, *_btnPurchase, *_btnSell, *_btnGeoscape;
 	Base *_base;
 	Globe *_globe;
+	bool _ownsBase;
 public:
 	/// Creates the Basescape state.
 	BasescapeState(Game *game, Base *base, Globe *globe);
@@ -51,6 +52,8 @@ public:
 	~BasescapeState();
 	/// Updates the base stats.
 	void init();
+	/// Checks if the screen can be reused.
+	bool isReusable() const;
 	/// Sets a new base to display.
 	void setBase(Base *base);
 	/// Handler for clicking the Build New Base button.
@@ -208,7 +208,7 @@ void PurchaseState::btnOkClick(Action *action)
 				{
 					Transfer *t = new Transfer(_game->getRuleset()->getPersonnelTime());
 					t->setSoldier(new Soldier(_game->getRuleset()->getSoldier("XCOM"), _game->getRuleset()->getArmor("STR_NONE_UC"), _game->getRuleset()->getPools()));
-					_base->getTransfers()->push_back(t);
+					_game->getSavedGame()->addTransfer(_base, t);
 				}
 			}
 			// Buy scientists
@@ -216,14 +216,14 @@ void PurchaseState::btnOkClick(Action *action)
 			{
 				Transfer *t = new Transfer(_game->getRuleset()->getPersonnelTime());
 				t->setScientists(_qtys[i]);
-				_base->getTransfers()->push_back(t);
+				_game->getSavedGame()->addTransfer(_base, t);
 			}
 			// Buy engineers
 			else if (i == 2)
 			{
 				Transfer *t = new Transfer(_game->getRuleset()->getPersonnelTime());
 				t->setEngineers(_qtys[i]);
-				_base->getTransfers()->push_back(t);
+				_game->getSavedGame()->addTransfer(_base, t);
 			}
 			// Buy crafts
 			else if (i >= 3 && i < 3 + _crafts.size())
@@ -233,7 +233,7 @@ void PurchaseState::btnOkClick(Action *action)
 					RuleCraft *rc = _game->getRuleset()->getCraft(_crafts[i - 3]);
 					Transfer *t = new Transfer(rc->getTransferTime());
 					t->setCraft(new Craft(rc, _base, _game->getSavedGame()->getCraftIds()));
-					_base->getTransfers()->push_back(t);
+					_game->getSavedGame()->addTransfer(_base, t);
 				}
 			}
 			// Buy items
@@ -242,7 +242,7 @@ void PurchaseState::btnOkClick(Action *action)
 				RuleItem *ri = _game->getRuleset()->getItem(_items[i - 3 - _crafts.size()]);
 				Transfer *t = new Transfer(ri->getTransferTime());
 				t->setItems(_items[i - 3 - _crafts.size()], _qtys[i]);
-				_base->getTransfers()->push_back(t);
+				_game->getSavedGame()->addTransfer(_base, t);
 			}
 		}
 	}
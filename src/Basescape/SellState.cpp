@@ -139,7 +139,7 @@ SellState::SellState(Game *game, Base *base) : State(game), _base(base), _qtys()
 	}
 	for (std::vector<Craft*>::iterator i = _base->getCrafts()->begin(); i != _base->getCrafts()->end(); i++)
 	{
-		if ((*i)->getStatus() != "STR_OUT")
+		if ((*i)->getStatus() != CRAFT_OUT)
 		{
 			_qtys.push_back(0);
 			_crafts.push_back(*i);
@@ -162,7 +162,7 @@ SellState::SellState(Game *game, Base *base) : State(game), _base(base), _qtys()
 		ss << _base->getAvailableEngineers();
 		_lstItems->addRow(4, _game->getLanguage()->getString("STR_ENGINEER").c_str(), ss.str().c_str(), L"0", Text::formatFunding(0).c_str());
 	}
-	for (std::map<std::string, int>::iterator i = _base->getItems()->getContents()->begin(); i != _base->getItems()->getContents()->end(); i++)
+	for (std::map<std::string, int>::const_iterator i = _base->getItems()->getContents().begin(); i != _base->getItems()->getContents().end(); i++)
 	{
 		_qtys.push_back(0);
 		_items.push_back(i->first);
@@ -238,7 +238,7 @@ void SellState::btnOkClick(Action *action)
 				}
 
 				// Remove items from craft
-				for (std::map<std::string, int>::iterator it = craft->getItems()->getContents()->begin(); it != craft->getItems()->getContents()->end(); it++)
+				for (std::map<std::string, int>::const_iterator it = craft->getItems()->getContents().begin(); it != craft->getItems()->getContents().end(); it++)
 				{
 					_base->getItems()->addItem(it->first, it->second);
 				}
@@ -92,7 +92,7 @@ StoresState::StoresState(Game *game, Base *base) : State(game), _base(base)
 	_lstStores->setBackground(_window);
 	_lstStores->setMargin(2);
 
-	for (std::map<std::string, int>::iterator i = _base->getItems()->getContents()->begin(); i != _base->getItems()->getContents()->end(); i++)
+	for (std::map<std::string, int>::const_iterator i = _base->getItems()->getContents().begin(); i != _base->getItems()->getContents().end(); i++)
 	{
 		RuleItem *rule = _game->getRuleset()->getItem(i->first);
 		std::wstringstream ss, ss2;
@@ -105,13 +105,10 @@ TransferBaseState::TransferBaseState(Game *game, Base *base) : State(game), _bas
 		{
 			// Get area
 			std::wstring area = L"";
-			for (std::vector<Region*>::iterator j = _game->getSavedGame()->getRegions()->begin(); j != _game->getSavedGame()->getRegions()->end(); j++)
+			Region *region = _game->getSavedGame()->locateRegion((*i)->getLongitude(), (*i)->getLatitude());
+			if (region != 0)
 			{
-				if ((*j)->getRules()->insideRegion((*i)->getLongitude(), (*i)->getLatitude()))
-				{
-					area = _game->getLanguage()->getString((*j)->getRules()->getType());
-					break;
-				}
+				area = _game->getLanguage()->getString(region->getRules()->getType());
 			}
 
 			_lstBases->addRow(2, (*i)->getName().c_str(), area.c_str());
@@ -129,7 +129,7 @@ TransferItemsState::TransferItemsState(Game *game, Base *baseFrom, Base *baseTo)
 	}
 	for (std::vector<Craft*>::iterator i = _baseFrom->getCrafts()->begin(); i != _baseFrom->getCrafts()->end(); i++)
 	{
-		if ((*i)->getStatus() != "STR_OUT")
+		if ((*i)->getStatus() != CRAFT_OUT)
 		{
 			_qtys.push_back(0);
 			_crafts.push_back(*i);
@@ -154,7 +154,7 @@ TransferItemsState::TransferItemsState(Game *game, Base *baseFrom, Base *baseTo)
 		ss2 << _baseTo->getAvailableEngineers();
 		_lstItems->addRow(4, _game->getLanguage()->getString("STR_ENGINEER").c_str(), ss.str().c_str(), L"0", ss2.str().c_str());
 	}
-	for (std::map<std::string, int>::iterator i = _baseFrom->getItems()->getContents()->begin(); i != _baseFrom->getItems()->getContents()->end(); i++)
+	for (std::map<std::string, int>::const_iterator i = _baseFrom->getItems()->getContents().begin(); i != _baseFrom->getItems()->getContents().end(); i++)
 	{
 		_qtys.push_back(0);
 		_items.push_back(i->first);
@@ -226,7 +226,7 @@ void TransferItemsState::completeTransfer()
 						_baseFrom->getSoldiers()->erase(s);
 						Transfer *t = new Transfer(time);
 						t->setSoldier(*s);
-						_baseTo->getTransfers()->push_back(t);
+						_game->getSavedGame()->addTransfer(_baseTo, t);
 						break;
 					}
 				}
@@ -244,7 +244,7 @@ void TransferItemsState::completeTransfer()
 						_baseFrom->getSoldiers()->erase(s);
 						Transfer *t = new Transfer(time);
 						t->setSoldier(*s);
-						_baseTo->getTransfers()->push_back(t);
+						_game->getSavedGame()->addTransfer(_baseTo, t);
 					}
 				}
 
@@ -256,7 +256,7 @@ void TransferItemsState::completeTransfer()
 						_baseFrom->getCrafts()->erase(c);
 						Transfer *t = new Transfer(time);
 						t->setCraft(*c);
-						_baseTo->getTransfers()->push_back(t);
+						_game->getSavedGame()->addTransfer(_baseTo, t);
 						break;
 					}
 				}
@@ -267,7 +267,7 @@ void TransferItemsState::completeTransfer()
 				_baseFrom->setScientists(_baseFrom->getScientists() - _qtys[i]);
 				Transfer *t = new Transfer(time);
 				t->setScientists(_qtys[i]);
-				_baseTo->getTransfers()->push_back(t);
+				_game->getSavedGame()->addTransfer(_baseTo, t);
 			}
 			// Transfer engineers
 			else if (_baseFrom->getAvailableEngineers() > 0 && i == _soldiers.size() + _crafts.size() + _sOffset)
@@ -275,7 +275,7 @@ void TransferItemsState::completeTransfer()
 				_baseFrom->setEngineers(_baseFrom->getEngineers() - _qtys[i]);
 				Transfer *t = new Transfer(time);
 				t->setEngineers(_qtys[i]);
-				_baseTo->getTransfers()->push_back(t);
+				_game->getSavedGame()->addTransfer(_baseTo, t);
 			}
 			// Transfer items
 			else
@@ -283,7 +283,7 @@ void TransferItemsState::completeTransfer()
 				_baseFrom->getItems()->removeItem(_items[i - _soldiers.size() - _crafts.size() - _sOffset - _eOffset], _qtys[i]);
 				Transfer *t = new Transfer(time);
 				t->setItems(_items[i - _soldiers.size() - _crafts.size() - _sOffset - _eOffset], _qtys[i]);
-				_baseTo->getTransfers()->push_back(t);
+				_game->getSavedGame()->addTransfer(_baseTo, t);
 			}
 		}
 	}
@@ -96,7 +96,7 @@ TransfersState::TransfersState(Game *game, Base *base) : State(game), _base(base
 	{
 		std::wstringstream ss, ss2;
 		ss << (*i)->getQuantity();
-		ss2 << (*i)->getHours();
+		ss2 << (*i)->getHours(_game->getSavedGame()->getHoursPassed());
 		_lstTransfers->addRow(3, (*i)->getName(_game->getLanguage()).c_str(), ss.str().c_str(), ss2.str().c_str());
 	}
 }
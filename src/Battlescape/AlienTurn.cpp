@@ -0,0 +1,233 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AlienTurn.h"
+#include <algorithm>
+#include "TerrainModifier.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Savegame/Tile.h"
+#include "../Savegame/Node.h"
+#include "../Engine/RNG.h"
+#include "../Engine/Profiler.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Sets up an AlienTurn.
+ * @param save Pointer to the battle game.
+ */
+AlienTurn::AlienTurn(SavedBattleGame *save) : _save(save)
+{
+}
+
+/**
+ * Deletes the AlienTurn.
+ */
+AlienTurn::~AlienTurn()
+{
+}
+
+/**
+ * Gets the node nearest to a position, on any level.
+ * @param pos Position on the map.
+ * @return Pointer to the node, 0 if the map has none.
+ */
+Node *AlienTurn::getNearestNode(const Position &pos)
+{
+	Node *nearest = 0;
+	int best = 0;
+	for (std::vector<Node*>::iterator i = _save->getNodes()->begin(); i != _save->getNodes()->end(); i++)
+	{
+		int dx = (*i)->getPosition().x - pos.x;
+		int dy = (*i)->getPosition().y - pos.y;
+		int dz = (*i)->getPosition().z - pos.z;
+		int distance = dx * dx + dy * dy + dz * dz * 4;
+		if (nearest == 0 || distance < best)
+		{
+			nearest = *i;
+			best = distance;
+		}
+	}
+	return nearest;
+}
+
+/**
+ * Picks the node a unit patrols to this turn: one of the
+ * nodes linked to the node it's at, or any node it can reach
+ * if that one doesn't lead anywhere. Nodes where one of the
+ * known enemies would see the unit are only picked if they all are.
+ * @param unit Pointer to the unit.
+ * @param enemies Enemies the aliens see.
+ * @return Pointer to the node, 0 if the map has none.
+ */
+Node *AlienTurn::getPatrolNode(BattleUnit *unit, const std::vector<BattleUnit*> &enemies)
+{
+	std::vector<Node*> *nodes = _save->getNodes();
+	Node *node = getNearestNode(unit->getPosition());
+	if (node == 0)
+		return 0;
+
+	std::vector<Node*> linked;
+	for (int i = 0; i < 5; i++)
+	{
+		int id = node->getNodeLink(i).getConnectedNodeID();
+		if (id >= 0 && id < (int)nodes->size())
+		{
+			linked.push_back(nodes->at(id));
+		}
+	}
+	if (linked.empty())
+	{
+		for (std::vector<Node*>::iterator i = nodes->begin(); i != nodes->end(); i++)
+		{
+			if (*i != node && _save->getNodeDistance(node, *i) != -1)
+			{
+				linked.push_back(*i);
+			}
+		}
+	}
+	if (linked.empty())
+	{
+		return nodes->at(RNG::generate(0, nodes->size() - 1, RNG_AI));
+	}
+	if (!enemies.empty())
+	{
+		std::vector<Node*> hidden;
+		for (std::vector<Node*>::iterator i = linked.begin(); i != linked.end(); i++)
+		{
+			std::vector<BattleUnit*> spotters;
+			_save->getTerrainModifier()->getSpotters(unit, (*i)->getPosition(), enemies, &spotters);
+			if (spotters.empty())
+			{
+				hidden.push_back(*i);
+			}
+		}
+		if (!hidden.empty())
+		{
+			linked.swap(hidden);
+		}
+	}
+	return linked.at(RNG::generate(0, linked.size() - 1, RNG_AI));
+}
+
+/**
+ * Moves a unit one step straight away, opening doors on the way,
+ * and updates what it sees.
+ * @param unit Pointer to the unit.
+ * @param direction Direction of the step.
+ * @return Whether the unit could make the step.
+ */
+bool AlienTurn::step(BattleUnit *unit, int direction)
+{
+	Position destination;
+	int tu = _save->getPathfinding()->getTUCost(unit->getPosition(), direction, &destination, unit);
+	if (tu > unit->getTimeUnits())
+		return false;
+
+	// flying up or down keeps the unit facing the same way, there are no doors on the way
+	if (direction < 8)
+	{
+		unit->setDirection(direction);
+		int door = _save->getTerrainModifier()->unitOpensDoor(unit);
+		if (door == 1 || door == 3)
+			return false; // ufo doors take a while to open, walk through next turn
+	}
+	if (!unit->spendTimeUnits(tu, false))
+		return false;
+
+	_save->getTile(unit->getPosition())->setUnit(0);
+	unit->setPosition(destination);
+	_save->getTile(destination)->setUnit(unit);
+	_save->updateUnitBucket(unit);
+	_save->getTerrainModifier()->calculateFOV(unit);
+	return true;
+}
+
+/**
+ * Plays the turn of every alien that can still act. Aliens stop
+ * walking when they spot someone or run out of time units. When
+ * an alien is about to step where the player can see it, it stops,
+ * and the rest of its walk is handed back to be animated.
+ * @param shown The aliens to animate and where they walk to.
+ * @param threads Number of threads to calculate the paths with.
+ */
+void AlienTurn::run(std::vector<PathRequest> *shown, int threads)
+{
+	TraceMarker trace("alien turn");
+
+	// the enemies any alien sees are known to all of them
+	std::vector<BattleUnit*> enemies;
+	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
+	{
+		if ((*i)->getFaction() != FACTION_HOSTILE || (*i)->isOut())
+			continue;
+		for (std::vector<BattleUnit*>::iterator j = (*i)->getVisibleUnits()->begin(); j != (*i)->getVisibleUnits()->end(); j++)
+		{
+			if (std::find(enemies.begin(), enemies.end(), *j) == enemies.end())
+			{
+				enemies.push_back(*j);
+			}
+		}
+	}
+
+	std::vector<PathRequest> requests;
+	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
+	{
+		if ((*i)->getFaction() != FACTION_HOSTILE || (*i)->isOut() || (*i)->getTimeUnits() == 0)
+			continue;
+		// aliens that already see someone hold their position
+		if (!(*i)->getVisibleUnits()->empty())
+			continue;
+		Node *node = getPatrolNode(*i, enemies);
+		if (node == 0 || node->getPosition() == (*i)->getPosition() || _save->getTile(node->getPosition()) == 0)
+			continue;
+		PathRequest request;
+		request.unit = *i;
+		request.target = node->getPosition();
+		requests.push_back(request);
+	}
+	_save->getPathfinding()->calculate(&requests, threads);
+
+	for (std::vector<PathRequest>::iterator i = requests.begin(); i != requests.end(); i++)
+	{
+		// the path is stored backwards, the first step last
+		while (!i->path.empty())
+		{
+			int direction = i->path.back();
+			Position vector, next;
+			Pathfinding::directionToVector(direction, &vector);
+			next = i->unit->getPosition() + vector;
+			if (_save->isTileVisible(FACTION_PLAYER, _save->getTileIndex(i->unit->getPosition())) ||
+				(_save->getTile(next) && _save->isTileVisible(FACTION_PLAYER, _save->getTileIndex(next))))
+			{
+				shown->push_back(*i);
+				break;
+			}
+			if (!step(i->unit, direction))
+				break;
+			i->path.pop_back();
+			if (!i->unit->getSpottedUnits()->empty())
+				break;
+		}
+	}
+	_save->getTerrainModifier()->calculateUnitLighting();
+}
+
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_ALIENTURN_H
+#define OPENXCOM_ALIENTURN_H
+
+#include <vector>
+#include "Pathfinding.h"
+
+#define ALIEN_PATH_THREADS 4
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class BattleUnit;
+class Node;
+
+/**
+ * Plays the alien side's turn without drawing it. Every alien patrols
+ * to a node linked to the one it's nearest to, and stops when it spots
+ * someone, while aliens that already see someone stay put. Nodes the
+ * enemies the aliens know about could see are avoided. All the paths
+ * are calculated in one batch, and the moves are made straight on the
+ * map, except for the ones the player can see, which are left for the
+ * battlescape to animate.
+ */
+class AlienTurn
+{
+private:
+	SavedBattleGame *_save;
+	/// Gets the node nearest to a position.
+	Node *getNearestNode(const Position &pos);
+	/// Picks the node a unit patrols to.
+	Node *getPatrolNode(BattleUnit *unit, const std::vector<BattleUnit*> &enemies);
+	/// Moves a unit one step along its path.
+	bool step(BattleUnit *unit, int direction);
+public:
+	/// Creates a new AlienTurn class.
+	AlienTurn(SavedBattleGame *save);
+	/// Cleans up the AlienTurn.
+	~AlienTurn();
+	/// Plays the alien turn, returning the moves the player gets to watch.
+	void run(std::vector<PathRequest> *shown, int threads = ALIEN_PATH_THREADS);
+};
+
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "BattleRecorder.h"
+#include "../Engine/Exception.h"
+#include "../Savegame/SavedGame.h"
+
+#define RECORD_VERSION 1
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a recorder with nothing recorded or loaded.
+ */
+BattleRecorder::BattleRecorder() : _out(), _actions(), _next(0)
+{
+}
+
+/**
+ *
+ */
+BattleRecorder::~BattleRecorder()
+{
+	if (_out.is_open())
+	{
+		_out.close();
+	}
+}
+
+/**
+ * Starts recording the current battle, saving the game
+ * as it is now and starting a new recording file
+ * of the same name.
+ * @param save Pointer to the saved game, with the battle in it.
+ * @param filename Save and recording filename, without extension.
+ */
+void BattleRecorder::record(SavedGame *save, const std::string &filename)
+{
+	save->save(filename);
+	std::string s = USER_DIR + filename + ".rec";
+	_out.open(s.c_str());
+	if (!_out)
+	{
+		throw Exception("Failed to record battle");
+	}
+	_out << "OXREC " << RECORD_VERSION << std::endl;
+}
+
+/**
+ * Records a player action at the end of the file.
+ * @param action Action done.
+ */
+void BattleRecorder::add(const RecordedAction &action)
+{
+	if (!_out.is_open())
+		return;
+	_out << action.type << " " << action.unit << " "
+		 << action.target.x << " " << action.target.y << " " << action.target.z << " "
+		 << action.slot << " " << action.action << std::endl;
+}
+
+/**
+ * Loads the actions of a recording to replay. The game
+ * it starts from is loaded like any other save.
+ * @param filename Recording filename, without extension.
+ */
+void BattleRecorder::load(const std::string &filename)
+{
+	std::string s = USER_DIR + filename + ".rec";
+	std::ifstream in(s.c_str());
+	if (!in)
+	{
+		throw Exception("Failed to load recording");
+	}
+	std::string magic;
+	int version;
+	in >> magic >> version;
+	if (magic != "OXREC" || version != RECORD_VERSION)
+	{
+		throw Exception("Version mismatch");
+	}
+	_actions.clear();
+	_next = 0;
+	RecordedAction action;
+	int type;
+	while (in >> type >> action.unit >> action.target.x >> action.target.y >> action.target.z >> action.slot >> action.action)
+	{
+		action.type = (RecordedActionType)type;
+		_actions.push_back(action);
+	}
+	in.close();
+}
+
+/**
+ * Returns the next action of the recording to replay.
+ * @return Pointer to the action, or 0 if they're all done.
+ */
+const RecordedAction *BattleRecorder::next()
+{
+	if (_next >= _actions.size())
+		return 0;
+	return &_actions[_next++];
+}
+
+/**
+ * Returns the number of actions in the loaded recording.
+ * @return Number of actions.
+ */
+int BattleRecorder::getTotalActions() const
+{
+	return _actions.size();
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_BATTLERECORDER_H
+#define OPENXCOM_BATTLERECORDER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class SavedGame;
+
+/**
+ * The player actions that change the battle.
+ */
+enum RecordedActionType { RA_WALK, RA_TURN, RA_FIRE, RA_KNEEL, RA_END_TURN };
+
+/**
+ * A player action on the battlescape, with everything
+ * needed to do it again: the unit, what it targets and,
+ * for shots and throws, the hand and kind of action.
+ */
+struct RecordedAction
+{
+	RecordedActionType type;
+	int unit;
+	Position target;
+	int slot, action;
+};
+
+/**
+ * Records the player actions of a battle, to replay them later
+ * exactly the same. The game the battle starts from is saved
+ * next to the recording, with the state of all the random streams,
+ * so everything the actions lead to, alien turns included, comes
+ * out the same. Each action is a line in a small text file,
+ * written as soon as it's done so a crash doesn't lose it.
+ */
+class BattleRecorder
+{
+private:
+	std::ofstream _out;
+	std::vector<RecordedAction> _actions;
+	size_t _next;
+public:
+	/// Creates an empty recorder.
+	BattleRecorder();
+	/// Cleans up the recorder.
+	~BattleRecorder();
+	/// Starts recording a battle.
+	void record(SavedGame *save, const std::string &filename);
+	/// Records a player action.
+	void add(const RecordedAction &action);
+	/// Loads a recording to replay.
+	void load(const std::string &filename);
+	/// Gets the next action to replay.
+	const RecordedAction *next();
+	/// Gets the number of actions loaded.
+	int getTotalActions() const;
+};
+
+}
+
+#endif
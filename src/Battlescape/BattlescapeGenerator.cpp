@@ -18,6 +18,9 @@
  */
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <new>
 #include "BattlescapeGenerator.h"
 #include "TerrainModifier.h"
 #include "../Savegame/SavedGame.h"
@@ -35,6 +38,7 @@
 #include "../Savegame/NodeLink.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Exception.h"
+#include "../Engine/Profiler.h"
 #include "../Ruleset/MapBlock.h"
 #include "../Ruleset/MapDataSet.h"
 #include "../Ruleset/RuleUfo.h"
@@ -50,24 +54,121 @@
 namespace OpenXcom
 {
 
+std::map<std::string, std::vector<char> > BattlescapeGenerator::_blockFiles;
+std::list<std::string> BattlescapeGenerator::_recentBlockFiles;
+
 /**
- * Sets up a BattlescapeGenerator.
+ * Sets up a BattlescapeGenerator, with a new battle game of its
+ * own that only becomes the current battle once it's installed.
  * @param game pointer to Game object.
  */
 BattlescapeGenerator::BattlescapeGenerator(Game *game) : _game(game)
 {
-	_save = _game->getSavedGame()->getBattleGame();
+	_save = new SavedBattleGame();
 	_res = _game->getResourcePack();
 	_ufo = 0;
 	_craft = 0;
+	_progress = 0;
+	_progressMutex = SDL_CreateMutex();
 }
 
 /**
- * Deletes the BattlescapeGenerator.
+ * Deletes the BattlescapeGenerator, after any background generation is done.
+ * A battle game that was never installed is deleted too.
  */
 BattlescapeGenerator::~BattlescapeGenerator()
 {
+	wait();
+	delete _save;
+	SDL_DestroyMutex(_progressMutex);
+}
+
+/**
+ * Generates the battlescape on the job pool, so the game can
+ * show something else meanwhile. Until wait() returns nothing may touch
+ * the battle game being generated.
+ */
+void BattlescapeGenerator::start()
+{
+	JobPool::run(&_job, runThread, this);
+}
+
+/**
+ * Waits for the battlescape started with start() to be generated.
+ */
+void BattlescapeGenerator::wait()
+{
+	JobPool::wait(&_job);
+}
+
+/**
+ * Returns how far along the generation is, so the game
+ * can show it while it runs in the background.
+ * @return Progress from 0 to GENERATE_DONE.
+ */
+int BattlescapeGenerator::getProgress() const
+{
+	SDL_mutexP(_progressMutex);
+	int progress = _progress;
+	SDL_mutexV(_progressMutex);
+	return progress;
+}
 
+/**
+ * Reports how far along the generation is. Only the generating
+ * thread writes it, under a lock since the main thread
+ * reads it meanwhile.
+ * @param progress Progress from 0 to GENERATE_DONE.
+ */
+void BattlescapeGenerator::setProgress(int progress)
+{
+	SDL_mutexP(_progressMutex);
+	_progress = progress;
+	SDL_mutexV(_progressMutex);
+}
+
+/**
+ * Waits for the generation to finish and makes the generated
+ * battle game the current one, all at once, so nothing ever
+ * sees a half generated battlescape.
+ * Errors in the background generation are passed on here.
+ */
+void BattlescapeGenerator::install()
+{
+	wait();
+	if (!_error.empty())
+	{
+		throw Exception(_error);
+	}
+	_game->getSavedGame()->setBattleGame(_save);
+	_save = 0;
+}
+
+/**
+ * Entry point of the background generation job.
+ * Errors are kept for install() to throw again on the
+ * main thread, since nothing can catch them on this one.
+ * @param generator Pointer to the BattlescapeGenerator.
+ * @return 0
+ */
+int BattlescapeGenerator::runThread(void *generator)
+{
+	BattlescapeGenerator *bgen = (BattlescapeGenerator*)generator;
+	try
+	{
+		bgen->run();
+	}
+	catch (std::exception &e)
+	{
+		bgen->_error = e.what();
+		bgen->setProgress(GENERATE_DONE);
+	}
+	catch (...)
+	{
+		bgen->_error = "Unknown error generating the battlescape";
+		bgen->setProgress(GENERATE_DONE);
+	}
+	return 0;
 }
 
 /**
@@ -123,6 +224,7 @@ void BattlescapeGenerator::setMissionType(MissionType missionType)
  */
 void BattlescapeGenerator::run()
 {
+	TraceMarker trace("generate battle");
 	_width = 50;
 	_length = 50;
 	_height = 4;
@@ -189,9 +291,13 @@ void BattlescapeGenerator::run()
 	// creates the tile objects
 	_save->initMap(_width, _length, _height);
 	_save->initUtilities(_res);
+	setProgress(10);
 
 	// lets generate the map now and store it inside the tile objects
 	generateMap();
+	// the node links don't change anymore, so the AI can look up routes
+	_save->calculateNodeDistances();
+	setProgress(75);
 
 	if (_craft != 0)
 	{
@@ -233,6 +339,7 @@ void BattlescapeGenerator::run()
 	addAlien(_game->getRuleset()->getAlien("SECTOID_SOLDIER"), _game->getRuleset()->getArmor("SECTOID_ARMOR0"), SCOUT);
 	addAlien(_game->getRuleset()->getAlien("SECTOID_SOLDIER"), _game->getRuleset()->getArmor("SECTOID_ARMOR0"), SCOUT);
 	addAlien(_game->getRuleset()->getAlien("SECTOID_SOLDIER"), _game->getRuleset()->getArmor("SECTOID_ARMOR0"), SCOUT);
+	setProgress(85);
 
 	// set shade (alien bases are a little darker, sites depend on worldshade)
 	int worldshades[8] = { 0, 1, 2, 3, 5, 7, 9 , 15 };
@@ -241,6 +348,7 @@ void BattlescapeGenerator::run()
 	_save->getTerrainModifier()->calculateSunShading();
 	_save->getTerrainModifier()->calculateTerrainLighting();
 	_save->getTerrainModifier()->calculateUnitLighting();
+	setProgress(GENERATE_DONE);
 }
 
 /**
@@ -272,6 +380,7 @@ void BattlescapeGenerator::addSoldier(Soldier *soldier)
 	}
 
 	_save->getUnits()->push_back(unit);
+	_save->updateUnitBucket(unit);
 }
 
 /**
@@ -283,52 +392,40 @@ void BattlescapeGenerator::addSoldier(Soldier *soldier)
 void BattlescapeGenerator::addAlien(RuleAlien *rules, RuleArmor *armor, NodeRank rank)
 {
 	BattleUnit *unit = new BattleUnit(new Alien(rules, armor, _game->getLanguage()), FACTION_HOSTILE);
-	Node *node;
+	Tile *tile;
 	bool bFound = false;
 	unit->setId(_unitCount++);
 
 	// find a place to spawn, going from highest priority to lowest
-	// some randomness is added
-	for (int priority=10; priority > 0 && !bFound; priority--)
+	// some randomness is added, the second try is without randomness in case we still haven't found a place
+	// only the nodes of the rank and priority are checked, a node is taken when its tile has a unit
+	for (int pass = 0; pass < 2 && !bFound; pass++)
 	{
-		for (std::vector<Node*>::iterator i = _save->getNodes()->begin(); i != _save->getNodes()->end() && !bFound; i++)
+		for (int priority = 10; priority > 0 && !bFound; priority--)
 		{
-			node = *i;
-			if (node->getRank() == rank
-				&& node->getPriority() == priority
-				&& _save->selectUnit(node->getPosition()) == 0
-				&& (RNG::generate(0,2) == 1))
+			std::map<std::pair<int, int>, std::vector<Node*> >::iterator nodes = _spawnNodes.find(std::make_pair((int)rank, priority));
+			if (nodes == _spawnNodes.end())
 			{
-				unit->setPosition(node->getPosition());
-				_save->getTile(node->getPosition())->setUnit(unit);
-				bFound = true;
+				continue;
 			}
-		}
-	}
-
-	// second try in case we still haven't found a place to spawn
-	// this time without randomness
-	for (int priority = 10; priority > 0 && !bFound; priority--)
-	{
-		for (std::vector<Node*>::iterator i = _save->getNodes()->begin(); i != _save->getNodes()->end() && !bFound; i++)
-		{
-			node = *i;
-			if (node->getRank() == rank
-				&& node->getPriority() == priority
-				&& _save->selectUnit(node->getPosition()) == 0
-				)
+			for (std::vector<Node*>::iterator i = nodes->second.begin(); i != nodes->second.end() && !bFound; i++)
 			{
-				unit->setPosition(node->getPosition());
-				_save->getTile(node->getPosition())->setUnit(unit);
-				bFound = true;
-				break;
+				tile = _save->getTile((*i)->getPosition());
+				if (tile && tile->getUnit() == 0
+					&& (pass == 1 || RNG::generate(0, 2, RNG_BATTLE) == 1))
+				{
+					unit->setPosition((*i)->getPosition());
+					tile->setUnit(unit);
+					bFound = true;
+				}
 			}
 		}
 	}
 
-	unit->setDirection(RNG::generate(0,7));
+	unit->setDirection(RNG::generate(0, 7, RNG_BATTLE));
 
 	_save->getUnits()->push_back(unit);
+	_save->updateUnitBucket(unit);
 }
 
 /**
@@ -337,7 +434,7 @@ void BattlescapeGenerator::addAlien(RuleAlien *rules, RuleArmor *armor, NodeRank
  */
 void BattlescapeGenerator::addItem(RuleItem *item)
 {
-	BattleItem *bi = new BattleItem(item);
+	BattleItem *bi = _save->createItem(item);
 
 	if (item->getBattleType() == BT_AMMO)
 	{
@@ -365,8 +462,6 @@ void BattlescapeGenerator::addItem(RuleItem *item)
 			}
 		}
 	}
-
-	_save->getItems()->push_back(bi);
 }
 
 /** 
@@ -397,22 +492,14 @@ void BattlescapeGenerator::generateMap()
 
 	blocksToDo = (_width / 10) * (_length / 10);
 
-	/* create tile objects */
-	for (int i = 0; i < _height * _length * _width; i++)
-	{
-		Position pos;
-		_save->getTileCoords(i, &pos.x, &pos.y, &pos.z);
-		_save->getTiles()[i] = new Tile(pos);
-	}
-
 	/* Determine UFO landingzone (do this first because ufo is generally bigger) */
 	if (_ufo != 0)
 	{
 		// crafts always consist of 1 mapblock, but can have all sorts of sizes
 		ufoMap = _ufo->getRules()->getBattlescapeTerrainData()->getMapBlocks()->at(0);
 
-		ufoX = RNG::generate(0, (_length / 10) - ufoMap->getWidth() / 10);
-		ufoY = RNG::generate(0, (_width / 10) - ufoMap->getLength() / 10);
+		ufoX = RNG::generate(0, (_length / 10) - ufoMap->getWidth() / 10, RNG_BATTLE);
+		ufoY = RNG::generate(0, (_width / 10) - ufoMap->getLength() / 10, RNG_BATTLE);
 
 		for (int i = 0; i < ufoMap->getWidth() / 10; i++)
 		{
@@ -430,8 +517,8 @@ void BattlescapeGenerator::generateMap()
 		craftMap = _craft->getRules()->getBattlescapeTerrainData()->getMapBlocks()->at(0);
 		while (!placed)
 		{
-			craftX = RNG::generate(0, (_length/10)- craftMap->getWidth() / 10);
-			craftY = RNG::generate(0, (_width/10)- craftMap->getLength() / 10);
+			craftX = RNG::generate(0, (_length/10)- craftMap->getWidth() / 10, RNG_BATTLE);
+			craftY = RNG::generate(0, (_width/10)- craftMap->getLength() / 10, RNG_BATTLE);
 			placed = true;
 			// check if this place is ok
 			for (int i = 0; i < craftMap->getWidth() / 10; i++)
@@ -500,8 +587,7 @@ void BattlescapeGenerator::generateMap()
 
 	for (std::vector<MapDataSet*>::iterator i = _terrain->getMapDataSets()->begin(); i != _terrain->getMapDataSets()->end(); i++)
 	{
-		(*i)->load(_res);
-		_save->getMapDataSets()->push_back(*i);
+		_save->addMapDataSet(*i, _res);
 	}
 
 	/* now load them up */
@@ -518,14 +604,14 @@ void BattlescapeGenerator::generateMap()
 				}
 			}
 		}
+		setProgress(10 + (itY + 1) * 5);
 	}
 
 	if (_ufo != 0)
 	{
 		for (std::vector<MapDataSet*>::iterator i = _ufo->getRules()->getBattlescapeTerrainData()->getMapDataSets()->begin(); i != _ufo->getRules()->getBattlescapeTerrainData()->getMapDataSets()->end(); i++)
 		{
-			(*i)->load(_res);
-			_save->getMapDataSets()->push_back(*i);
+			_save->addMapDataSet(*i, _res);
 		}
 		loadMAP(ufoMap, ufoX * 10, ufoY * 10, _ufo->getRules()->getBattlescapeTerrainData());
 		loadRMP(ufoMap, ufoX * 10, ufoY * 10);
@@ -535,8 +621,7 @@ void BattlescapeGenerator::generateMap()
 	{
 		for (std::vector<MapDataSet*>::iterator i = _craft->getRules()->getBattlescapeTerrainData()->getMapDataSets()->begin(); i != _craft->getRules()->getBattlescapeTerrainData()->getMapDataSets()->end(); i++)
 		{
-			(*i)->load(_res);
-			_save->getMapDataSets()->push_back(*i);
+			_save->addMapDataSet(*i, _res);
 		}
 		loadMAP(craftMap, craftX * 10, craftY * 10, _craft->getRules()->getBattlescapeTerrainData(), true);
 		loadRMP(craftMap, craftX * 10, craftY * 10);
@@ -552,6 +637,63 @@ void BattlescapeGenerator::generateMap()
 }
 
 
+/**
+ * Gets the whole contents of a MAP or RMP file. Map blocks
+ * never change, so each file is only read from disk the first
+ * time a battle uses it, and kept for later battles, but only
+ * the BLOCKFILE_CACHE most recently used files are kept.
+ * The contents stay valid until the next file is loaded.
+ * Only one battle is generated at a time, so this is safe to
+ * call from the generator's thread.
+ * @param filename Filename of the file.
+ * @param error Message to throw if the file can't be loaded.
+ * @return Contents of the file.
+ */
+const std::vector<char> &BattlescapeGenerator::loadBlockFile(const std::string &filename, const char *error)
+{
+	std::map<std::string, std::vector<char> >::iterator i = _blockFiles.find(filename);
+	if (i != _blockFiles.end())
+	{
+		if (_recentBlockFiles.front() != filename)
+		{
+			_recentBlockFiles.remove(filename);
+			_recentBlockFiles.push_front(filename);
+		}
+		return i->second;
+	}
+
+	// Load the whole file at once
+	std::ifstream file (ResourcePack::insensitive(filename).c_str(), std::ios::in| std::ios::binary);
+	if (!file)
+	{
+		throw Exception(error);
+	}
+	file.seekg(0, std::ios::end);
+	std::streamoff size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	std::vector<char> data((size_t)size);
+	if (size > 0 && !file.read(&data[0], size))
+	{
+		throw Exception("Invalid data from file");
+	}
+	file.close();
+
+	// Make room by dropping the least recently used file
+	while (_recentBlockFiles.size() >= BLOCKFILE_CACHE)
+	{
+		std::map<std::string, std::vector<char> >::iterator old = _blockFiles.find(_recentBlockFiles.back());
+		Profiler::addMemory(MEM_MAPCACHE, -(long)old->second.size());
+		_blockFiles.erase(old);
+		_recentBlockFiles.pop_back();
+	}
+
+	std::vector<char> &cached = _blockFiles[filename];
+	cached.swap(data);
+	_recentBlockFiles.push_front(filename);
+	Profiler::addMemory(MEM_MAPCACHE, (long)cached.size());
+	return cached;
+}
+
 /**
  * Loads a X-Com format MAP file into the tiles of the battlegame.
  * @param mapblock Pointer to MapBlock.
@@ -567,68 +709,61 @@ void BattlescapeGenerator::generateMap()
 int BattlescapeGenerator::loadMAP(MapBlock *mapblock, int xoff, int yoff, RuleTerrain *terrain, bool discovered)
 {
 	int width, length, height;
-	int x = xoff, y = yoff, z = 0;
-	char size[3];
-	unsigned char value[4];
 	std::stringstream filename;
 	filename << _res->getFolder() << "MAPS/" << mapblock->getName() << ".MAP";
-	std::string mapDataFileName;
-	int terrainObjectID;
-
-	// Load file
-	std::ifstream mapFile (ResourcePack::insensitive(filename.str()).c_str(), std::ios::in| std::ios::binary);
-	if (!mapFile)
+	const std::vector<char> &data = loadBlockFile(filename.str(), "Failed to load MAP");
+	int size = data.size();
+	if (size < 3)
 	{
-		throw Exception("Failed to load MAP");
+		throw Exception("Invalid data from file");
 	}
-	
-	mapFile.read((char*)&size, sizeof(size));
-	length = (int)size[0];
-	width = (int)size[1];
-	height = (int)size[2];
-	z += height - 1;
-	y += length - 1;
+
+	length = (int)(unsigned char)data[0];
+	width = (int)(unsigned char)data[1];
+	height = (int)(unsigned char)data[2];
 	mapblock->setHeight(height);
+	if (xoff + width > _save->getWidth() || yoff + length > _save->getLength() || height > _save->getHeight())
+	{
+		throw Exception("Invalid data from file");
+	}
 
-	while (mapFile.read((char*)&value, sizeof(value)))
+	// Cells go from the top level down, rows from the far end of the block,
+	// so they're written straight into the tile array by index
+	Tile **tiles = _save->getTiles();
+	int rowSize = _save->getWidth(), levelSize = _save->getWidth() * _save->getLength();
+	int cells = std::min((size - 3) / 4, width * length * height);
+	// the same object IDs come up over and over, so they're only looked up once
+	MapData *objects[256];
+	bool found[256] = {false};
+	for (int cell = 0; cell < cells; cell++)
 	{
+		const unsigned char *value = (const unsigned char*)&data[3 + cell * 4];
+		int x = xoff + cell % width;
+		int y = yoff + length - 1 - (cell / width) % length;
+		int z = height - 1 - cell / (width * length);
+		Tile *tile = tiles[z * levelSize + y * rowSize + x];
 		for (int part = 0; part < 4; part++)
 		{
-			terrainObjectID = (int)((unsigned char)value[part]);
-			if (terrainObjectID>0)
+			int terrainObjectID = (int)value[part];
+			if (terrainObjectID > 0)
 			{
-				_save->getTile(Position(x, y, z))->setMapData(terrain->getMapData(terrainObjectID),part);
+				if (!found[terrainObjectID])
+				{
+					objects[terrainObjectID] = terrain->getMapData(terrainObjectID);
+					found[terrainObjectID] = true;
+				}
+				tile->setMapData(objects[terrainObjectID], part);
 			}
 			// if the part is empty and it's not a floor, remove it
 			// it prevents growing grass in UFOs
 			if (terrainObjectID == 0 && part > 0)
 			{
-				_save->getTile(Position(x, y, z))->setMapData(0,part);
+				tile->setMapData(0, part);
 			}
 		}
-		_save->getTile(Position(x, y, z))->setDiscovered(discovered);
-
-		x++;
-
-		if (x == (width + xoff))
-		{
-			x = xoff;
-			y--;
-		}
-		if (y == yoff - 1)
-		{
-			y = length - 1 + yoff;
-			z--;
-		}
+		tile->setDiscovered(discovered);
 	}
 
-	if (!mapFile.eof())
-	{
-		throw Exception("Invalid data from file");
-	}
-
-	mapFile.close();
-
 	return height;
 }
 
@@ -641,23 +776,24 @@ int BattlescapeGenerator::loadMAP(MapBlock *mapblock, int xoff, int yoff, RuleTe
  */
 void BattlescapeGenerator::loadRMP(MapBlock *mapblock, int xoff, int yoff)
 {
-	int id = 0;
-	char value[24];
 	std::stringstream filename;
 	filename << _res->getFolder() << "ROUTES/" << mapblock->getName() << ".RMP";
-
-	// Load file
-	std::ifstream mapFile (ResourcePack::insensitive(filename.str()).c_str(), std::ios::in| std::ios::binary);
-	if (!mapFile)
+	const std::vector<char> &data = loadBlockFile(filename.str(), "Failed to load RMP");
+	int count = data.size() / 24;
+	if (count == 0)
 	{
-		throw Exception("Failed to load RMP");
+		return;
 	}
 
 	int nodeOffset = _save->getNodes()->size();
+	// all nodes of the block are built in one go, with their links inside them
+	Node *nodes = _save->allocateNodes(count);
+	_save->getNodes()->reserve(nodeOffset + count);
 
-	while (mapFile.read((char*)&value, sizeof(value)))
+	for (int id = 0; id < count; id++)
 	{
-		Node *node = new Node(nodeOffset + id, Position(xoff + (int)value[1], yoff + (mapblock->getLength() - 1 - (int)value[0]), mapblock->getHeight() - 1 - (int)value[2]), (int)value[3], (int)value[19], (int)value[20], (int)value[21], (int)value[22], (int)value[23]);
+		const char *value = &data[id * 24];
+		Node *node = new (&nodes[id]) Node(nodeOffset + id, Position(xoff + (int)value[1], yoff + (mapblock->getLength() - 1 - (int)value[0]), mapblock->getHeight() - 1 - (int)value[2]), (int)value[3], (int)value[19], (int)value[20], (int)value[21], (int)value[22], (int)value[23]);
 		for (int j=0;j<5;j++)
 		{
 			int connectID = (int)((signed char)value[4 + j*3]);
@@ -665,18 +801,11 @@ void BattlescapeGenerator::loadRMP(MapBlock *mapblock, int xoff, int yoff)
 			{
 				connectID += nodeOffset;
 			}
-			node->assignNodeLink(new NodeLink(connectID, (int)value[5 + j*3], (int)value[6 + j*3]), j);
+			node->assignNodeLink(NodeLink(connectID, (int)value[5 + j*3], (int)value[6 + j*3]), j);
 		}
 		_save->getNodes()->push_back(node);
-		id++;
+		_spawnNodes[std::make_pair((int)node->getRank(), node->getPriority())].push_back(node);
 	}
-
-	if (!mapFile.eof())
-	{
-		throw Exception("Invalid data from file");
-	}
-
-	mapFile.close();
 }
 
 }
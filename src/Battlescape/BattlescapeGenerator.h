@@ -19,9 +19,21 @@
 #ifndef OPENXCOM_BATTLESCAPEGENERATOR_H
 #define OPENXCOM_BATTLESCAPEGENERATOR_H
 
+#include <map>
+#include <list>
+#include <string>
+#include <vector>
+#include "SDL.h"
+#include "../Engine/JobPool.h"
 #include "../Savegame/Node.h"
 #include "../Savegame/SavedBattleGame.h"
 
+#ifdef DINGOO
+#define BLOCKFILE_CACHE 16
+#else
+#define BLOCKFILE_CACHE 64
+#endif
+
 namespace OpenXcom
 {
 
@@ -53,7 +65,20 @@ private:
 	int _worldTexture, _worldShade;
 	MissionType _missionType;
 	int _unitCount;
+	JobGroup _job;
+	int _progress;
+	SDL_mutex *_progressMutex;
+	std::string _error;
+	static std::map<std::string, std::vector<char> > _blockFiles;
+	static std::list<std::string> _recentBlockFiles;
+	std::map<std::pair<int, int>, std::vector<Node*> > _spawnNodes;
 
+	/// Gets the contents of a MAP or RMP file, cached for later battles.
+	static const std::vector<char> &loadBlockFile(const std::string &filename, const char *error);
+	/// Runs a generator on a background thread.
+	static int runThread(void *generator);
+	/// Reports how far along the generation is.
+	void setProgress(int progress);
 	/// Generate a new battlescape map.
 	void generateMap();
 	/// links tiles with terrainobjects, for easier/faster lookup
@@ -69,10 +94,20 @@ private:
 	/// loads an XCOM RMP file
 	void loadRMP(MapBlock *mapblock, int xoff, int yoff);
 public:
+	/// Progress reported once the generation is over.
+	static const int GENERATE_DONE = 100;
 	/// Creates a new BattlescapeGenerator class
 	BattlescapeGenerator(Game *game);
 	/// Cleans up the BattlescapeGenerator.
 	~BattlescapeGenerator();
+	/// Starts generating the battlescape on a background thread.
+	void start();
+	/// Waits for the background generation to finish.
+	void wait();
+	/// Gets how far along the generation is.
+	int getProgress() const;
+	/// Hands the generated battlescape over to the saved game.
+	void install();
 	/// Sets the xcom craft.
 	void setCraft(Craft *craft);
 	/// Sets the ufo.
@@ -22,12 +22,14 @@
 #include <cmath>
 #include "ActionMenuItem.h"
 #include "Map.h"
+#include "MiniMap.h"
 #include "BattlescapeState.h"
 #include "BattleState.h"
 #include "UnitTurnBState.h"
 #include "UnitWalkBState.h"
 #include "ProjectileFlyBState.h"
 #include "TerrainModifier.h"
+#include "AlienTurn.h"
 #include "../Engine/Game.h"
 #include "../Engine/Music.h"
 #include "../Engine/Language.h"
@@ -39,6 +41,7 @@
 #include "../Engine/SoundSet.h"
 #include "../Engine/Sound.h"
 #include "../Engine/Action.h"
+#include "../Engine/Exception.h"
 #include "../Resource/ResourcePack.h"
 #include "../Interface/Cursor.h"
 #include "../Interface/Text.h"
@@ -61,6 +64,10 @@
 namespace OpenXcom
 {
 
+FastCombat BattlescapeState::_fastCombat = FAST_COMBAT_OFF;
+std::string BattlescapeState::_recordName = "";
+std::string BattlescapeState::_replayName = "";
+
 /**
  * Initializes all the elements in the Battlescape screen.
  * @param game Pointer to the core game.
@@ -69,6 +76,7 @@ BattlescapeState::BattlescapeState(Game *game) : State(game)
 {
 	// Create the battlemap view
 	_map = new Map(320, 200, 0, 0);
+	_miniMap = new MiniMap(320, 144, 0, 0, _game->getSavedGame()->getBattleGame(), _game->getResourcePack()->getSurfaceSet("SCANG.DAT"));
 
 	// Create buttonbar
 	_icons = new Surface(320, 200, 0, 0);
@@ -80,6 +88,7 @@ BattlescapeState::BattlescapeState(Game *game) : State(game)
 	_btnEndTurn = new InteractiveSurface(32, 16, 240, 144);
 	_btnMapUp = new InteractiveSurface(32, 16, 80, 144);
 	_btnMapDown = new InteractiveSurface(32, 16, 80, 160);
+	_btnShowMap = new InteractiveSurface(32, 16, 112, 144);
 	_btnNextSoldier = new InteractiveSurface(32, 16, 176, 144);
 	_btnCenter = new InteractiveSurface(32, 16, 145, 160);
 	_btnReserveNone = new ImageButton(28, 11, 49, 177);
@@ -152,6 +161,7 @@ BattlescapeState::BattlescapeState(Game *game) : State(game)
 	_game->getFpsCounter()->setColor(Palette::blockOffset(9));
 
 	add(_map);
+	add(_miniMap);
 	add(_icons);
 	add(_numLayers);
 	add(_rank);
@@ -159,6 +169,7 @@ BattlescapeState::BattlescapeState(Game *game) : State(game)
 	add(_btnEndTurn);
 	add(_btnMapUp);
 	add(_btnMapDown);
+	add(_btnShowMap);
 	add(_btnNextSoldier);
 	add(_btnCenter);
 	add(_btnKneel);
@@ -200,6 +211,8 @@ BattlescapeState::BattlescapeState(Game *game) : State(game)
 	_map->setSavedGame(_battleGame, _game);
 	_map->init();
 	_map->onMouseClick((ActionHandler)&BattlescapeState::mapClick);
+	_miniMap->onMouseClick((ActionHandler)&BattlescapeState::miniMapClick);
+	_miniMap->setVisible(false);
 
 	_numLayers->setColor(Palette::blockOffset(1)-2);
 	_numLayers->setValue(1);
@@ -214,6 +227,7 @@ BattlescapeState::BattlescapeState(Game *game) : State(game)
 	_btnEndTurn->onMouseClick((ActionHandler)&BattlescapeState::btnEndTurnClick);
 	_btnMapUp->onMouseClick((ActionHandler)&BattlescapeState::btnMapUpClick);
 	_btnMapDown->onMouseClick((ActionHandler)&BattlescapeState::btnMapDownClick);
+	_btnShowMap->onMouseClick((ActionHandler)&BattlescapeState::btnShowMapClick);
 	_btnNextSoldier->onMouseClick((ActionHandler)&BattlescapeState::btnNextSoldierClick);
 	_btnCenter->onMouseClick((ActionHandler)&BattlescapeState::btnCenterClick);
 	_btnKneel->onMouseClick((ActionHandler)&BattlescapeState::btnKneelClick);
@@ -284,6 +298,31 @@ BattlescapeState::BattlescapeState(Game *game) : State(game)
 	_animTimer->start();
 
 	_selectedAction = BA_NONE;
+
+	_recorder = 0;
+	_replay = 0;
+	try
+	{
+		if (!_recordName.empty())
+		{
+			_recorder = new BattleRecorder();
+			_recorder->record(_game->getSavedGame(), _recordName);
+		}
+		if (!_replayName.empty())
+		{
+			_replay = new BattleRecorder();
+			_replay->load(_replayName);
+		}
+	}
+	catch (Exception &e)
+	{
+		// carry on with the battle, without the recording
+		delete _recorder;
+		delete _replay;
+		_recorder = 0;
+		_replay = 0;
+		showWarningMessage(Language::utf8ToWstr(e.what()));
+	}
 }
 
 /**
@@ -293,6 +332,8 @@ BattlescapeState::~BattlescapeState()
 {
 	delete _stateTimer;
 	delete _animTimer;
+	delete _recorder;
+	delete _replay;
 }
 
 void BattlescapeState::init()
@@ -312,6 +353,10 @@ void BattlescapeState::think()
 	_stateTimer->think(this, 0);
 	_animTimer->think(this, 0);
 	_map->think();
+	if (_replay != 0 && !isBusy())
+	{
+		replayNext();
+	}
 }
 
 /**
@@ -390,10 +435,18 @@ void BattlescapeState::blinkWarningMessage()
   */
 void BattlescapeState::showWarningMessage(std::string message)
 {
-	std::wstring messageText = _game->getLanguage()->getString(message);
+	showWarningMessage(_game->getLanguage()->getString(message));
+}
+
+/**
+  * Show warning message.
+  * @param message already translated
+  */
+void BattlescapeState::showWarningMessage(const std::wstring &message)
+{
 	_warningMessageBackground->setVisible(true);
 	_txtWarningMessage->setVisible(true);
-	_txtWarningMessage->setText(messageText);
+	_txtWarningMessage->setText(message);
 }
 
 /**
@@ -403,6 +456,9 @@ void BattlescapeState::showWarningMessage(std::string message)
  */
 void BattlescapeState::mapClick(Action *action)
 {
+	// the minimap is on top of the map
+	if (_miniMap->getVisible()) return;
+
 	// right-click aborts walking state
 	if (action->getDetails()->button.button == SDL_BUTTON_RIGHT)
 	{
@@ -443,11 +499,8 @@ void BattlescapeState::mapClick(Action *action)
 		if (_targeting && _battleGame->getSelectedUnit())
 		{
 			//  -= fire weapon =-
-			_target = pos;
-			_map->setCursorType(CT_NONE);
-			_game->getCursor()->setVisible(false);
-			statePushBack(new UnitTurnBState(this));
-			statePushBack(new ProjectileFlyBState(this));
+			RecordedAction fire = { RA_FIRE, _battleGame->getSelectedUnit()->getId(), pos, _selectedItem->getSlot(), _selectedAction };
+			perform(fire);
 		}
 		else
 		{
@@ -464,18 +517,16 @@ void BattlescapeState::mapClick(Action *action)
 			else if (_battleGame->getSelectedUnit())
 			{
 			//  -= start walking =-
-				_target = pos;
-				_map->setCursorType(CT_NONE);
-				_game->getCursor()->setVisible(false);
-				statePushBack(new UnitWalkBState(this));
+				RecordedAction walk = { RA_WALK, _battleGame->getSelectedUnit()->getId(), pos, 0, BA_NONE };
+				perform(walk);
 			}
 		}
 	}
 	else if (action->getDetails()->button.button == SDL_BUTTON_RIGHT && _battleGame->getSelectedUnit())
 	{
 		//  -= turn to or open door =-
-		_target = pos;
-		statePushBack(new UnitTurnBState(this));
+		RecordedAction turn = { RA_TURN, _battleGame->getSelectedUnit()->getId(), pos, 0, BA_NONE };
+		perform(turn);
 	}
 
 }
@@ -514,6 +565,10 @@ void BattlescapeState::btnMapUpClick(Action *action)
 {
 	if (_popup) return;
 	_map->up();
+	if (_miniMap->getVisible())
+	{
+		_miniMap->setLevel(_map->getViewHeight());
+	}
 }
 
 /**
@@ -524,6 +579,10 @@ void BattlescapeState::btnMapDownClick(Action *action)
 {
 	if (_popup) return;
 	_map->down();
+	if (_miniMap->getVisible())
+	{
+		_miniMap->setLevel(_map->getViewHeight());
+	}
 }
 
 /**
@@ -533,6 +592,33 @@ void BattlescapeState::btnMapDownClick(Action *action)
 void BattlescapeState::btnShowMapClick(Action *action)
 {
 	if (_popup) return;
+	if (_miniMap->getVisible())
+	{
+		_miniMap->setVisible(false);
+		return;
+	}
+	Position pos = _battleGame->getSelectedUnit() ? _battleGame->getSelectedUnit()->getPosition() : Position(_battleGame->getWidth() / 2, _battleGame->getLength() / 2, 0);
+	pos.z = _map->getViewHeight();
+	_miniMap->centerOnPosition(pos);
+	_miniMap->setVisible(true);
+}
+
+/**
+ * Centers the map on the tile clicked on the minimap with the left button,
+ * and goes back to the map.
+ * @param action Pointer to an action.
+ */
+void BattlescapeState::miniMapClick(Action *action)
+{
+	if (action->getDetails()->button.button == SDL_BUTTON_LEFT)
+	{
+		Position pos = _miniMap->getPosition((int)(action->getXMouse() / action->getXScale()) - _miniMap->getX(), (int)(action->getYMouse() / action->getYScale()) - _miniMap->getY());
+		if (_battleGame->getTile(pos))
+		{
+			_map->centerOnPosition(pos);
+		}
+	}
+	_miniMap->setVisible(false);
 }
 
 /**
@@ -546,12 +632,8 @@ void BattlescapeState::btnKneelClick(Action *action)
 	BattleUnit *bu = _battleGame->getSelectedUnit();
 	if (bu)
 	{
-		if (bu->spendTimeUnits(bu->isKneeled()?8:4, _battleGame->getDebugMode()))
-		{
-			bu->kneel(!bu->isKneeled());
-			_map->cacheUnits();
-			updateSoldierInfo(bu);
-		}
+		RecordedAction kneel = { RA_KNEEL, bu->getId(), bu->getPosition(), 0, BA_NONE };
+		perform(kneel);
 	}
 }
 
@@ -624,6 +706,17 @@ void BattlescapeState::btnEndTurnClick(Action *action)
 {
 	if (_popup) return;
 
+	RecordedAction end = { RA_END_TURN, -1, Position(), 0, BA_NONE };
+	perform(end);
+}
+
+/**
+ * Ends the current side's turn. The alien turn is played
+ * straight away and ends itself once the player has seen
+ * the moves they get to watch.
+ */
+void BattlescapeState::endTurn()
+{
 	if (_battleGame->getTerrainModifier()->closeUfoDoors())
 	{
 		_game->getResourcePack()->getSoundSet("BATTLE.CAT")->getSound(21)->play(); // ufo door closed
@@ -636,13 +729,25 @@ void BattlescapeState::btnEndTurnClick(Action *action)
 		_map->centerOnPosition(_battleGame->getSelectedUnit()->getPosition());
 	}
 
-	if (_battleGame->getSide() == FACTION_HOSTILE)
+	if (_battleGame->getSide() == FACTION_HOSTILE && !_battleGame->getDebugMode())
 	{
-		// do AI stuff
-
-		if (!_battleGame->getDebugMode())
+		// the aliens make their moves out of sight straight away,
+		// the ones the player can see are walked before the turn ends
+		std::vector<PathRequest> shown;
+		AlienTurn(_battleGame).run(&shown);
+		_map->cacheUnits();
+		for (std::vector<PathRequest>::iterator i = shown.begin(); i != shown.end(); i++)
 		{
-			btnEndTurnClick(action);
+			statePushBack(new UnitWalkBState(this, i->unit, i->target));
+		}
+		if (_states.empty())
+		{
+			endTurn();
+		}
+		else
+		{
+			_map->setCursorType(CT_NONE);
+			_game->getCursor()->setVisible(false);
 		}
 	}
 
@@ -746,10 +851,6 @@ void BattlescapeState::btnActionMenuItemClick(Action *action)
 	if (btnID != -1)
 	{
 		_selectedAction = _actionMenu[btnID]->getAction();
-		if (_selectedAction == BA_AUTOSHOT)
-		{
-			_autoShot = 1;
-		}
 		_map->setCursorType(CT_AIM);
 		_targeting = true;
 		hidePopup();
@@ -940,10 +1041,47 @@ void BattlescapeState::handleState()
 	if (!_states.empty())
 	{
 		_states.front()->think();
-		_map->draw(true); // redraw map
+		// fast combat keeps going without waiting for the timer, up to a limit so the game stays responsive
+		for (int i = 1; i < FAST_COMBAT_STEPS && !_states.empty() && isFastCombat(); i++)
+		{
+			_states.front()->think();
+		}
+		_map->draw(false); // redraw what changed
+	}
+}
+
+/**
+ * Checks if the current action is played out at full speed,
+ * which depends on the fast combat setting and on whether
+ * the player can see the unit doing it.
+ * @return True if the action doesn't wait for the timer.
+ */
+bool BattlescapeState::isFastCombat() const
+{
+	switch (_fastCombat)
+	{
+	case FAST_COMBAT_ALL:
+		return true;
+	case FAST_COMBAT_HIDDEN:
+		{
+			BattleUnit *unit = _battleGame->getSelectedUnit();
+			return unit != 0 && !_battleGame->isTileVisible(FACTION_PLAYER, _battleGame->getTileIndex(unit->getPosition()));
+		}
+	default:
+		return false;
 	}
 }
 
+/**
+ * Sets which actions are played out at full speed. Their effects
+ * are all worked out, but the map is only drawn where they end up.
+ * @param fastCombat Fast combat setting.
+ */
+void BattlescapeState::setFastCombat(FastCombat fastCombat)
+{
+	_fastCombat = fastCombat;
+}
+
 /**
  * Animate map objects on the map, also smoke,fire,....
  */
@@ -952,6 +1090,10 @@ void BattlescapeState::animate()
 	_animFrame++;
 	if (_animFrame == 8) _animFrame = 0;
 	_map->animate();
+	if (_miniMap->getVisible())
+	{
+		_miniMap->draw();
+	}
 
 	blinkVisibleUnitButtons();
 	blinkWarningMessage();
@@ -1053,26 +1195,12 @@ void BattlescapeState::popState()
 {
 	if (_states.empty()) return;
 
-	if (_states.front()->getResult().length() > 0)
+	if (_states.front()->getResult().length() > 0 && _battleGame->getSide() == FACTION_PLAYER)
 	{
 		showWarningMessage(_states.front()->getResult());
 	}
 	_states.pop_front();
 
-	if (_states.empty() && _selectedAction == BA_AUTOSHOT)
-	{
-		_autoShot++;
-		if (_autoShot <= 3)
-		{
-			// shoot another try
-			statePushBack(new ProjectileFlyBState(this));
-		}
-		else
-		{
-			_autoShot = 1;
-		}
-	}
-
 	// if all states are empty - give the mouse back to the player
 	if (_states.empty())
 	{
@@ -1100,6 +1228,135 @@ void BattlescapeState::popState()
 		_battleGame->setSelectedUnit(0);
 	}
 	updateSoldierInfo(_battleGame->getSelectedUnit());
+
+	// the aliens the player could see are done walking, so their turn is over
+	if (_states.empty() && _battleGame->getSide() == FACTION_HOSTILE && !_battleGame->getDebugMode())
+	{
+		endTurn();
+	}
+}
+
+/**
+ * Does a player action on the battle, recording it first if
+ * the battle is being recorded. All the player actions that
+ * change the battle go through here, whether they come from
+ * the player or from a replay, so both play out the same.
+ * @param action Action to do.
+ */
+void BattlescapeState::perform(const RecordedAction &action)
+{
+	if (_recorder != 0)
+	{
+		_recorder->add(action);
+	}
+	if (action.type == RA_END_TURN)
+	{
+		endTurn();
+		return;
+	}
+
+	BattleUnit *unit = 0;
+	for (std::vector<BattleUnit*>::iterator i = _battleGame->getUnits()->begin(); i != _battleGame->getUnits()->end(); i++)
+	{
+		if ((*i)->getId() == action.unit)
+		{
+			unit = *i;
+			break;
+		}
+	}
+	if (unit == 0 || unit->isOut())
+		return;
+	if (unit != _battleGame->getSelectedUnit())
+	{
+		_battleGame->setSelectedUnit(unit);
+		updateSoldierInfo(unit);
+	}
+
+	switch (action.type)
+	{
+	case RA_WALK:
+		_target = action.target;
+		_map->setCursorType(CT_NONE);
+		_game->getCursor()->setVisible(false);
+		statePushBack(new UnitWalkBState(this));
+		break;
+	case RA_TURN:
+		_target = action.target;
+		statePushBack(new UnitTurnBState(this));
+		break;
+	case RA_FIRE:
+		_selectedItem = _battleGame->getItemFromUnit(unit, (InventorySlot)action.slot);
+		if (_selectedItem == 0)
+			return;
+		_selectedAction = (BattleActionType)action.action;
+		_targeting = true;
+		_target = action.target;
+		_map->setCursorType(CT_NONE);
+		_game->getCursor()->setVisible(false);
+		statePushBack(new UnitTurnBState(this));
+		statePushBack(new ProjectileFlyBState(this));
+		break;
+	case RA_KNEEL:
+		if (unit->spendTimeUnits(unit->isKneeled()?8:4, _battleGame->getDebugMode()))
+		{
+			unit->kneel(!unit->isKneeled());
+			_map->cacheUnits();
+			updateSoldierInfo(unit);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Does the next action of the recording being replayed.
+ * Should only be called once the previous one is played out.
+ * @param type Pointer to store the type of action done, or 0.
+ * @return False if there's nothing left to replay.
+ */
+bool BattlescapeState::replayNext(RecordedActionType *type)
+{
+	const RecordedAction *action = (_replay != 0) ? _replay->next() : 0;
+	if (action == 0)
+		return false;
+	if (type != 0)
+	{
+		*type = action->type;
+	}
+	perform(*action);
+	return true;
+}
+
+/**
+ * Checks if an action is still being played out,
+ * so nothing new can be done yet.
+ * @return True if there are battle states left.
+ */
+bool BattlescapeState::isBusy() const
+{
+	return !_states.empty() || _popup;
+}
+
+/**
+ * Sets the file that the battles started from now on are
+ * recorded to. The game they start from is saved under
+ * the same name, to replay the battle from.
+ * @param filename Recording filename, without extension, or empty for none.
+ */
+void BattlescapeState::setRecording(const std::string &filename)
+{
+	_recordName = filename;
+}
+
+/**
+ * Sets the recording that the battles started from now on
+ * replay, once the game it was recorded from is loaded.
+ * @param filename Recording filename, without extension, or empty for none.
+ */
+void BattlescapeState::setReplay(const std::string &filename)
+{
+	_replayName = filename;
 }
 
 /**
@@ -21,13 +21,16 @@
 
 #include "../Engine/State.h"
 #include "Position.h"
+#include "BattleRecorder.h"
 #include <list>
+#include <string>
 
 namespace OpenXcom
 {
 
 class Surface;
 class Map;
+class MiniMap;
 class ImageButton;
 class InteractiveSurface;
 class Text;
@@ -46,6 +49,14 @@ enum BattleActionType { BA_NONE, BA_THROW, BA_AUTOSHOT, BA_SNAPSHOT, BA_AIMEDSHO
 #define DEFAULT_WALK_SPEED 40
 #define DEFAULT_BULLET_SPEED 20
 #define DEFAULT_ANIM_SPEED 100
+#define FAST_COMBAT_STEPS 1000
+
+/**
+ * Which actions are played out at full speed, with only
+ * where they end up drawn: none, the ones done out of the
+ * player's view, or all of them.
+ */
+enum FastCombat { FAST_COMBAT_OFF, FAST_COMBAT_HIDDEN, FAST_COMBAT_ALL };
 
 /**
  * Battlescape screen which shows the tactical battle
@@ -55,6 +66,7 @@ class BattlescapeState : public State
 private:
 	Surface *_icons, *_rank;
 	Map *_map;
+	MiniMap *_miniMap;
 	InteractiveSurface *_btnUnitUp, *_btnUnitDown, *_btnMapUp, *_btnMapDown, *_btnShowMap, *_btnKneel;
 	InteractiveSurface *_btnSoldier, *_btnCenter, *_btnNextSoldier, *_btnNextStop, *_btnShowLayers, *_btnHelp;
 	InteractiveSurface *_btnEndTurn, *_btnAbort;
@@ -77,19 +89,25 @@ private:
 
 	ActionMenuItem *_actionMenu[5];
 	BattleActionType _selectedAction;
-	int _autoShot;
 	BattleItem *_selectedItem;
 	Position _target;
 	std::list<BattleState*> _states;
 	bool _targeting, _popup;
+	static FastCombat _fastCombat;
+	BattleRecorder *_recorder, *_replay;
+	static std::string _recordName, _replayName;
 
 	void checkActionFinished();
+	bool isFastCombat() const;
 	void handleItemClick(BattleItem *item);
 	void drawItemSprite(BattleItem *item, Surface *surface);
 	void blinkVisibleUnitButtons();
 	void blinkWarningMessage();
 	void showWarningMessage(std::string message);
+	void showWarningMessage(const std::wstring &message);
 	void hidePopup();
+	void perform(const RecordedAction &action);
+	void endTurn();
 public:
 	/// Creates the Battlescape state.
 	BattlescapeState(Game *game);
@@ -101,6 +119,8 @@ public:
 	void think();
 	/// Handler for clicking the map.
 	void mapClick(Action *action);
+	/// Handler for clicking the minimap.
+	void miniMapClick(Action *action);
 	/// Handler for clicking the Unit Up button.
 	void btnUnitUpClick(Action *action);
 	/// Handler for clicking the Unit Down button.
@@ -167,6 +187,16 @@ public:
 	void debug(const std::wstring message);
 	/// Handle keypresses.
 	void handle(Action *action);
+	/// Set which actions are played out at full speed.
+	static void setFastCombat(FastCombat fastCombat);
+	/// Set the recording battles are recorded to.
+	static void setRecording(const std::string &filename);
+	/// Set the recording battles are replayed from.
+	static void setReplay(const std::string &filename);
+	/// Replays the next recorded action.
+	bool replayNext(RecordedActionType *type = 0);
+	/// Checks if an action is still being played out.
+	bool isBusy() const;
 };
 
 }
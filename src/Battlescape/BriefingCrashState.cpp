@@ -29,16 +29,19 @@
 #include "../Savegame/Craft.h"
 #include "../Engine/Music.h"
 #include "../Battlescape/BattlescapeState.h"
+#include "../Battlescape/BattlescapeGenerator.h"
 
 namespace OpenXcom
 {
 
 /**
  * Initializes all the elements in the Crash Briefing screen.
+ * The battlescape is generated in the background while it's shown.
  * @param game Pointer to the core game.
  * @param craft Pointer to the craft.
+ * @param generator Pointer to the set up battlescape generator, deleted by the state.
  */
-BriefingCrashState::BriefingCrashState(Game *game, Craft *craft) : State(game), _craft(craft)
+BriefingCrashState::BriefingCrashState(Game *game, Craft *craft, BattlescapeGenerator *generator) : State(game), _craft(craft), _generator(generator), _progress(-1)
 {
 	// Create objects
 	_window = new Window(this, 320, 200, 0, 0);
@@ -63,7 +66,6 @@ BriefingCrashState::BriefingCrashState(Game *game, Craft *craft) : State(game),
 	_window->setBackground(_game->getResourcePack()->getSurface("BACK16.SCR"));
 
 	_btnOk->setColor(Palette::blockOffset(8)+8);
-	_btnOk->setText(_game->getLanguage()->getString("STR_OK"));
 	_btnOk->onMouseClick((ActionHandler)&BriefingCrashState::btnOkClick);
 
 	_txtTitle->setColor(Palette::blockOffset(8)+5);
@@ -86,22 +88,52 @@ BriefingCrashState::BriefingCrashState(Game *game, Craft *craft) : State(game),
 
 	// Set music
 	_game->getResourcePack()->getMusic("GMDEFEND")->play();
+
+	// everything this screen needs is loaded, so the battle can be generated meanwhile
+	_generator->start();
 }
 
 /**
- *
+ * Makes sure the battlescape is done generating.
  */
 BriefingCrashState::~BriefingCrashState()
 {
-	
+	delete _generator;
+}
+
+/**
+ * Shows how far along the battlescape is on the Ok
+ * button, until it's ready to be played.
+ */
+void BriefingCrashState::think()
+{
+	State::think();
+
+	int progress = _generator->getProgress();
+	if (progress == _progress)
+		return;
+	_progress = progress;
+	if (progress < BattlescapeGenerator::GENERATE_DONE)
+	{
+		std::wstringstream ss;
+		ss << progress << L"%";
+		_btnOk->setText(ss.str());
+	}
+	else
+	{
+		_btnOk->setText(_game->getLanguage()->getString("STR_OK"));
+	}
 }
 
 /**
- * Closes the window.
+ * Closes the window, once the battlescape is ready.
  * @param action Pointer to an action.
  */
 void BriefingCrashState::btnOkClick(Action *action)
 {
+	if (_generator->getProgress() < BattlescapeGenerator::GENERATE_DONE)
+		return;
+	_generator->install();
 	_game->popState();
 	_game->pushState(new BattlescapeState(_game));
 }
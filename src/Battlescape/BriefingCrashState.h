@@ -29,6 +29,7 @@ class TextButton;
 class Window;
 class Text;
 class Craft;
+class BattlescapeGenerator;
 
 /**
  * Briefing screen which displays info
@@ -41,11 +42,15 @@ private:
 	Window *_window;
 	Text *_txtTitle, *_txtUfo, *_txtCraft, *_txtBriefing;
 	Craft *_craft;
+	BattlescapeGenerator *_generator;
+	int _progress;
 public:
 	/// Creates the Crash Briefing state.
-	BriefingCrashState(Game *game, Craft *craft);
+	BriefingCrashState(Game *game, Craft *craft, BattlescapeGenerator *generator);
 	/// Cleans up the Crash Briefing state.
 	~BriefingCrashState();
+	/// Shows how far along the battlescape is.
+	void think();
 	/// Handler for clicking the Ok button.
 	void btnOkClick(Action *action);
 };
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <sstream>
 #include "ExplosionBState.h"
 #include "BattlescapeState.h"
 #include "Explosion.h"
@@ -98,6 +99,9 @@ void ExplosionBState::think()
 				SavedBattleGame *save = _parent->getGame()->getSavedGame()->getBattleGame();
 				// after the animation is done, the real explosion takes place
 				save->getTerrainModifier()->explode(_center, _item->getAmmoItem()->getRules()->getPower(), _item->getAmmoItem()->getRules()->getDamageType(), 100, save->getSelectedUnit());
+				std::wstringstream ss;
+				ss << L"FOV skipped for " << save->getTerrainModifier()->getSkippedFOV() << L" units";
+				_parent->debug(ss.str());
 
 				// now check for new casualties
 				for (std::vector<BattleUnit*>::iterator j = save->getUnits()->begin(); j != save->getUnits()->end(); j++)
@@ -18,7 +18,11 @@
  */
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <algorithm>
+#include <map>
 #include "Map.h"
 #include "UnitSprite.h"
 #include "Position.h"
@@ -36,6 +40,7 @@
 #include "../Engine/Palette.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Game.h"
+#include "../Engine/Profiler.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
 #include "../Savegame/BattleUnit.h"
@@ -74,7 +79,7 @@ namespace OpenXcom
  * @param x X position in pixels.
  * @param y Y position in pixels.
  */
-Map::Map(int width, int height, int x, int y) : InteractiveSurface(width, height, x, y), _mapOffsetX(-250), _mapOffsetY(250), _viewHeight(0), _cursorType(CT_NORMAL), _animFrame(0), _scrollX(0), _scrollY(0), _RMBDragging(false)
+Map::Map(int width, int height, int x, int y) : InteractiveSurface(width, height, x, y), _atlasFloor(0), _unitSprite(0), _mapOffsetX(-250), _mapOffsetY(250), _viewHeight(0), _selectorX(0), _selectorY(0), _cursorType(CT_NORMAL), _animFrame(0), _scrollX(0), _scrollY(0), _RMBDragging(false), _recomposite(false), _maskSurface(0), _selectorMaskValid(false)
 {
 	_scrollTimer = new Timer(50);
 	_scrollTimer->onTimer((SurfaceHandler)&Map::scroll);
@@ -87,21 +92,30 @@ Map::~Map()
 {
 	delete _scrollTimer;
 
-	for (int i = 0; i < _tileCount; i++)
+	delete[] _tilePieces;
+	for (std::vector<Surface*>::iterator i = _atlasPages.begin(); i != _atlasPages.end(); i++)
+	{
+		delete *i;
+	}
+
+	for (std::map<std::pair<SurfaceSet*, int>, Surface*>::iterator i = _unitFrames.begin(); i != _unitFrames.end(); i++)
+	{
+		delete i->second;
+	}
+	for (std::map<std::pair<SurfaceSet*, int>, Surface*>::iterator i = _unitPoses.begin(); i != _unitPoses.end(); i++)
 	{
-		delete _tileFloorCache[i];
-		delete _tileWallsCache[i];
+		delete i->second;
 	}
-	delete[] _tileFloorCache;
-	delete[] _tileWallsCache;
+	delete _unitSprite;
 
-	for (std::vector<Surface*>::iterator i = _unitCache.begin(); i != _unitCache.end(); i++)
+	for (std::vector<Surface*>::iterator i = _levels.begin(); i != _levels.end(); i++)
 	{
 		delete *i;
 	}
 
 	delete _arrow;
 	delete _buffer;
+	delete _maskSurface;
 
 	for (int i = 0; i < 36; i++)
 	{
@@ -119,6 +133,11 @@ void Map::setResourcePack(ResourcePack *res)
 	_res = res;
 	_spriteWidth = res->getSurfaceSet("BLANKS.PCK")->getFrame(0)->getWidth();
 	_spriteHeight = res->getSurfaceSet("BLANKS.PCK")->getFrame(0)->getHeight();
+	// look these up once, they are needed for every tile drawn
+	_cursorSet = res->getSurfaceSet("CURSOR.PCK");
+	_smokeSet = res->getSurfaceSet("SMOKE.PCK");
+	_floorobSet = res->getSurfaceSet("FLOOROB.PCK");
+	_handobSet = res->getSurfaceSet("HANDOB.PCK");
 }
 
 /**
@@ -131,17 +150,23 @@ void Map::setSavedGame(SavedBattleGame *save, Game *game)
 	_save = save;
 	_game = game;
 	_tileCount = _save->getHeight() * _save->getLength() * _save->getWidth();
-	_tileFloorCache = new Surface*[_tileCount];
-	_tileWallsCache = new Surface*[_tileCount];
+	_tilePieces = new SpritePiece[_tileCount * TILE_PIECES];
 	_unitCache.clear();
-	for (int i = 0; i < _tileCount; i++)
+	_unitRects.clear();
+	_unitLevels.clear();
+	_dirtyRects.assign(_save->getHeight(), std::vector<SDL_Rect>());
+	_staleLevels.assign(_save->getHeight(), true);
+	_effectRects.clear();
+	for (int i = 0; i < _tileCount * TILE_PIECES; i++)
 	{
-		_tileFloorCache[i] = 0;
-		_tileWallsCache[i] = 0;
+		_tilePieces[i].page = 0;
 	}
+	SDL_Rect empty = {0, 0, 0, 0};
 	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
 	{
 		_unitCache.push_back(0);
+		_unitRects.push_back(empty);
+		_unitLevels.push_back((*i)->getPosition().z);
 	}
 
 	for (std::vector<MapDataSet*>::const_iterator i = _save->getMapDataSets()->begin(); i != _save->getMapDataSets()->end(); i++)
@@ -179,6 +204,16 @@ void Map::init()
 
 	_buffer = new Surface(this->getWidth() + _spriteWidth*4, this->getHeight() + _spriteHeight*4);
 	_buffer->setPalette(this->getPalette());
+	_maskSurface = new Surface(_buffer->getWidth(), _buffer->getHeight());
+	_maskSurface->setMemoryTag(MEM_MAPCACHE);
+	for (int z = 0; z < _save->getHeight(); z++)
+	{
+		Surface *level = new Surface(_buffer->getWidth(), _buffer->getHeight());
+		level->setMemoryTag(MEM_MAPCACHE);
+		level->setPalette(this->getPalette());
+		_levels.push_back(level);
+	}
+	_tileIds.assign(_levels.size(), std::vector<Uint16>(_buffer->getWidth() * _buffer->getHeight(), 0));
 
 	for (int i = 0; i < 36; i++)
 	{
@@ -203,322 +238,835 @@ void Map::think()
 }
 
 /**
- * Draws the whole map, part by part.
- * todo: work with dirty rects
+ * Draws the map. Every level is kept on its own surface, and the whole map is
+ * only drawn when forced, otherwise just the areas that changed since the last
+ * draw, and the strips that scrolled into the buffer.
+ * @param forceRedraw Redraw the whole map.
  */
 void Map::draw(bool forceRedraw)
 {
 	static int lastX, lastY;
 
-	if (((_mapOffsetX - lastX) < -_spriteWidth*2 ||
-		(_mapOffsetX - lastX) > _spriteWidth*2 ||
-		(_mapOffsetY - lastY) < -_spriteWidth*2 ||
-		(_mapOffsetY - lastY) > _spriteWidth*2) || forceRedraw)
+	// pick up everything that changed, so it gets drawn in either case
+	cacheTileSprites();
+	markMovingDirty();
+
+	// the buffer moves along with the view
+	_bufOffsetX += (_mapOffsetX - lastX);
+	_bufOffsetY += (_mapOffsetY - lastY);
+	if (forceRedraw)
 	{
-		// if the screen moved outside the buffer region, redraw it
-		_buffer->clear();
 		_bufOffsetX = -_spriteWidth*2;
 		_bufOffsetY = -_spriteHeight*2;
-		drawTerrain(_buffer);
+		for (int z = 0; z < (int)_levels.size(); z++)
+		{
+			_staleLevels[z] = true;
+		}
 	}
-	else
+	else if (_bufOffsetX > 0 || _bufOffsetY > 0 ||
+		_bufOffsetX < this->getWidth() - _buffer->getWidth() ||
+		_bufOffsetY < this->getHeight() - _buffer->getHeight())
 	{
-		// if we are still inside buffer region just move the buffer.
-		_bufOffsetX += (_mapOffsetX - lastX);
-		_bufOffsetY += (_mapOffsetY - lastY);
+		// if the screen moved outside the buffer region, center it again
+		shiftBuffers(_bufOffsetX + _spriteWidth*2, _bufOffsetY + _spriteHeight*2);
 	}
+	drawLevels();
 	_buffer->setX(_bufOffsetX);
 	_buffer->setY(_bufOffsetY);
 	this->clear();
 	_buffer->blit(this);
+	drawOverlay();
 
 	lastX = _mapOffsetX;
 	lastY = _mapOffsetY;
 }
 
 /**
-* Draw the terrain.
-*/
-void Map::drawTerrain(Surface *surface)
+ * Marks an area of the map to be redrawn on the next draw.
+ * @param rect Area in map pixels, without the view offset.
+ * @param level Level the change is on (all levels if -1).
+ */
+void Map::markDirty(const SDL_Rect &rect, int level)
+{
+	if (!rect.w || !rect.h || level >= (int)_dirtyRects.size())
+		return;
+	if (level < 0)
+	{
+		for (std::vector<std::vector<SDL_Rect> >::iterator i = _dirtyRects.begin(); i != _dirtyRects.end(); i++)
+		{
+			i->push_back(rect);
+		}
+	}
+	else
+	{
+		_dirtyRects[level].push_back(rect);
+	}
+}
+
+/**
+ * Marks the area covered by a tile's sprites to be redrawn.
+ * @param mapPos Position of the tile.
+ */
+void Map::markTileDirty(const Position &mapPos)
+{
+	Position screenPos;
+	convertMapToScreen(mapPos, &screenPos);
+	SDL_Rect rect;
+	rect.x = screenPos.x;
+	rect.y = screenPos.y;
+	rect.w = _spriteWidth;
+	rect.h = _spriteHeight;
+	markDirty(rect, mapPos.z);
+}
+
+/**
+ * Marks the area of a unit to be redrawn, on its own level and on
+ * the level above, where it shows through when standing on stairs.
+ * @param rect Area in map pixels.
+ * @param level Level the unit is on.
+ */
+void Map::markUnitDirty(const SDL_Rect &rect, int level)
+{
+	markDirty(rect, level);
+	markDirty(rect, level + 1);
+}
+
+/**
+ * Gets the area a unit is drawn on.
+ * @param unit Pointer to the unit.
+ * @return Area in map pixels.
+ */
+SDL_Rect Map::getUnitRect(BattleUnit *unit)
+{
+	Position screenPos, offset;
+	convertMapToScreen(unit->getPosition(), &screenPos);
+	calculateWalkingOffset(unit, &offset);
+	SDL_Rect rect;
+	rect.x = screenPos.x + offset.x;
+	rect.y = screenPos.y + offset.y;
+	rect.w = _spriteWidth;
+	rect.h = _spriteHeight;
+	return rect;
+}
+
+/**
+ * Marks everything that moves by itself to be redrawn: units that changed position
+ * and the projectile and explosions, both where they are now and where they were drawn before.
+ */
+void Map::markMovingDirty()
+{
+	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
+	{
+		SDL_Rect rect = getUnitRect(*i);
+		SDL_Rect &last = _unitRects.at((*i)->getId());
+		int &lastLevel = _unitLevels.at((*i)->getId());
+		if (rect.x != last.x || rect.y != last.y || rect.w != last.w || lastLevel != (*i)->getPosition().z)
+		{
+			markUnitDirty(last, lastLevel);
+			markUnitDirty(rect, (*i)->getPosition().z);
+			last = rect;
+			lastLevel = (*i)->getPosition().z;
+		}
+	}
+
+	std::vector<SDL_Rect> effects;
+	Position screenPos;
+	if (_projectile)
+	{
+		for (int i = 1; i <= _projectile->getParticle(0); i++)
+		{
+			Position voxelPos = _projectile->getPosition(1-i);
+			Position tilePos = Position(voxelPos.x / 16, voxelPos.y / 16, voxelPos.z / 24);
+			convertMapToScreen(tilePos, &screenPos);
+			SDL_Rect rect;
+			rect.x = screenPos.x;
+			rect.y = screenPos.y;
+			rect.w = _spriteWidth;
+			rect.h = _spriteHeight;
+			effects.push_back(rect);
+			// and the shadow on the floor
+			tilePos.z = 0;
+			convertMapToScreen(tilePos, &screenPos);
+			rect.x = screenPos.x;
+			rect.y = screenPos.y;
+			effects.push_back(rect);
+		}
+	}
+	for (std::set<Explosion*>::const_iterator i = _explosions.begin(); i != _explosions.end(); i++)
+	{
+		if (!(*i)->isBig())
+		{
+			Surface *frame = _smokeSet->getFrame((*i)->getCurrentFrame());
+			convertVoxelToScreen((*i)->getPosition(), &screenPos);
+			SDL_Rect rect;
+			rect.x = screenPos.x - 15 - (_mapOffsetX - _bufOffsetX);
+			rect.y = screenPos.y - 15 - (_mapOffsetY - _bufOffsetY);
+			rect.w = frame->getWidth();
+			rect.h = frame->getHeight();
+			effects.push_back(rect);
+		}
+	}
+	for (std::vector<SDL_Rect>::iterator i = _effectRects.begin(); i != _effectRects.end(); i++)
+	{
+		markDirty(*i);
+	}
+	for (std::vector<SDL_Rect>::iterator i = effects.begin(); i != effects.end(); i++)
+	{
+		markDirty(*i);
+	}
+	_effectRects.swap(effects);
+}
+
+/**
+ * Turns areas marked dirty into the areas of the buffer to redraw.
+ * Overlapping areas are merged first, and if there are still too many
+ * only their bounding box is redrawn.
+ * @param dirty Areas in map pixels.
+ * @param rects Vector to add the areas to, in buffer coordinates.
+ */
+void Map::mergeDirtyRects(const std::vector<SDL_Rect> &dirty, std::vector<SDL_Rect> *rects)
 {
+	for (std::vector<SDL_Rect>::const_iterator i = dirty.begin(); i != dirty.end(); i++)
+	{
+		// move into buffer coordinates and clip to the buffer
+		int x1 = std::max(i->x + _mapOffsetX - _bufOffsetX, 0);
+		int y1 = std::max(i->y + _mapOffsetY - _bufOffsetY, 0);
+		int x2 = std::min(i->x + i->w + _mapOffsetX - _bufOffsetX, _buffer->getWidth());
+		int y2 = std::min(i->y + i->h + _mapOffsetY - _bufOffsetY, _buffer->getHeight());
+		if (x1 >= x2 || y1 >= y2)
+			continue;
+
+		// grow the area by everything it overlaps, until nothing overlaps anymore
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+			for (std::vector<SDL_Rect>::iterator j = rects->begin(); j != rects->end(); j++)
+			{
+				if (x1 < j->x + j->w && j->x < x2 && y1 < j->y + j->h && j->y < y2)
+				{
+					x1 = std::min(x1, (int)j->x);
+					y1 = std::min(y1, (int)j->y);
+					x2 = std::max(x2, j->x + j->w);
+					y2 = std::max(y2, j->y + j->h);
+					rects->erase(j);
+					merged = true;
+					break;
+				}
+			}
+		}
+		SDL_Rect rect;
+		rect.x = x1;
+		rect.y = y1;
+		rect.w = x2 - x1;
+		rect.h = y2 - y1;
+		rects->push_back(rect);
+	}
+
+	if (rects->size() > MAX_DIRTY_RECTS)
+	{
+		int x1 = _buffer->getWidth(), y1 = _buffer->getHeight(), x2 = 0, y2 = 0;
+		for (std::vector<SDL_Rect>::iterator i = rects->begin(); i != rects->end(); i++)
+		{
+			x1 = std::min(x1, (int)i->x);
+			y1 = std::min(y1, (int)i->y);
+			x2 = std::max(x2, i->x + i->w);
+			y2 = std::max(y2, i->y + i->h);
+		}
+		SDL_Rect rect;
+		rect.x = x1;
+		rect.y = y1;
+		rect.w = x2 - x1;
+		rect.h = y2 - y1;
+		rects->clear();
+		rects->push_back(rect);
+	}
+}
+
+/**
+ * Brings the level surfaces up to date and stacks the ones shown
+ * into the buffer. A level only redraws what changed on it, hidden levels
+ * are redrawn in full the next time they are shown.
+ */
+void Map::drawLevels()
+{
+	std::vector<SDL_Rect> changed;
+	for (int z = 0; z < (int)_levels.size(); z++)
+	{
+		Surface *level = _levels[z];
+		if (z > _viewHeight)
+		{
+			if (!_dirtyRects[z].empty())
+			{
+				_staleLevels[z] = true;
+				_dirtyRects[z].clear();
+			}
+			continue;
+		}
+		// the tile picking buffer is drawn along with the level
+		Uint16 *ids = &_tileIds[z][0];
+		int width = level->getWidth();
+		if (_staleLevels[z])
+		{
+			level->clear();
+			std::fill(_tileIds[z].begin(), _tileIds[z].end(), 0);
+			drawTerrain(level, z, 0, 0, ids);
+			_staleLevels[z] = false;
+			_recomposite = true;
+		}
+		else if (!_dirtyRects[z].empty())
+		{
+			std::vector<SDL_Rect> rects;
+			mergeDirtyRects(_dirtyRects[z], &rects);
+			for (std::vector<SDL_Rect>::iterator i = rects.begin(); i != rects.end(); i++)
+			{
+				SDL_SetClipRect(level->getSurface(), &(*i));
+				SDL_FillRect(level->getSurface(), &(*i), 0);
+				for (int y = i->y; y < i->y + i->h; y++)
+				{
+					std::fill(ids + y * width + i->x, ids + y * width + i->x + i->w, 0);
+				}
+				drawTerrain(level, z, &(*i), 0, ids);
+			}
+			SDL_SetClipRect(level->getSurface(), 0);
+			changed.insert(changed.end(), _dirtyRects[z].begin(), _dirtyRects[z].end());
+		}
+		_dirtyRects[z].clear();
+	}
+
+	// what hides the cursor may have changed
+	for (std::vector<SDL_Rect>::iterator i = changed.begin(); i != changed.end() && _selectorMaskValid; i++)
+	{
+		_selectorMaskValid = !overlapsSelector(*i);
+	}
+	if (_recomposite)
+	{
+		_selectorMaskValid = false;
+	}
+
+	// the levels are drawn bottom to top, same as a single pass over the map would
+	if (_recomposite)
+	{
+		_buffer->clear();
+		for (int z = 0; z <= _viewHeight; z++)
+		{
+			_levels[z]->blit(_buffer);
+		}
+		_recomposite = false;
+	}
+	else if (!changed.empty())
+	{
+		std::vector<SDL_Rect> rects;
+		mergeDirtyRects(changed, &rects);
+		for (std::vector<SDL_Rect>::iterator i = rects.begin(); i != rects.end(); i++)
+		{
+			SDL_SetClipRect(_buffer->getSurface(), &(*i));
+			SDL_FillRect(_buffer->getSurface(), &(*i), 0);
+			for (int z = 0; z <= _viewHeight; z++)
+			{
+				_levels[z]->blit(_buffer);
+			}
+		}
+		SDL_SetClipRect(_buffer->getSurface(), 0);
+	}
+}
+
+/**
+ * Checks if an area overlaps the cursor, on any of the levels it is drawn on.
+ * @param rect Area in map pixels.
+ * @return True if it overlaps.
+ */
+bool Map::overlapsSelector(const SDL_Rect &rect)
+{
+	for (int z = 0; z <= _viewHeight; z++)
+	{
+		Position screenPos;
+		convertMapToScreen(Position(_selectorY, _selectorX, z), &screenPos);
+		if (rect.x < screenPos.x + _spriteWidth && screenPos.x < rect.x + rect.w &&
+			rect.y < screenPos.y + _spriteHeight && screenPos.y < rect.y + rect.h)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Finds out which pixels of the cursor are hidden, on every level it is drawn on.
+ * The back of the cursor is hidden by anything drawn after the floor of its tile,
+ * the front only by the smoke and fire of its tile and anything drawn after it.
+ * Both are hidden by the levels above. This is kept until the cursor moves
+ * or something around it is redrawn.
+ */
+void Map::updateSelectorMask()
+{
+	if (_selectorMaskValid)
+		return;
+
+	int size = _spriteWidth * _spriteHeight;
+	_selectorMask.assign(size * _levels.size(), 0);
+	for (int z = 0; z <= _viewHeight; z++)
+	{
+		Position mapPos(_selectorY, _selectorX, z), screenPos;
+		convertMapToScreen(mapPos, &screenPos);
+		SDL_Rect rect;
+		rect.x = screenPos.x + _mapOffsetX - _bufOffsetX;
+		rect.y = screenPos.y + _mapOffsetY - _bufOffsetY;
+		rect.w = _spriteWidth;
+		rect.h = _spriteHeight;
+		int stage = (mapPos.x * _save->getLength() + _save->getLength() - 1 - mapPos.y) * TILE_STAGES;
+		Uint8 *mask = &_selectorMask[z * size];
+
+		// draw what comes after each part of the cursor on its own level
+		Uint8 parts[2] = {SELECTOR_BACK, SELECTOR_FRONT};
+		for (int part = 0; part < 2; part++)
+		{
+			SDL_SetClipRect(_maskSurface->getSurface(), &rect);
+			SDL_FillRect(_maskSurface->getSurface(), &rect, 0);
+			drawTerrain(_maskSurface, z, &rect, stage + 1 + part);
+			SDL_SetClipRect(_maskSurface->getSurface(), 0);
+			for (int y = 0; y < _spriteHeight; y++)
+			{
+				for (int x = 0; x < _spriteWidth; x++)
+				{
+					int bx = rect.x + x, by = rect.y + y;
+					if (bx >= 0 && by >= 0 && bx < _maskSurface->getWidth() && by < _maskSurface->getHeight() && _maskSurface->getPixel(bx, by))
+					{
+						mask[y * _spriteWidth + x] |= parts[part];
+					}
+				}
+			}
+		}
+
+		// the levels above are stacked on top
+		for (int above = z + 1; above <= _viewHeight; above++)
+		{
+			for (int y = 0; y < _spriteHeight; y++)
+			{
+				for (int x = 0; x < _spriteWidth; x++)
+				{
+					int bx = rect.x + x, by = rect.y + y;
+					if (bx >= 0 && by >= 0 && bx < _levels[above]->getWidth() && by < _levels[above]->getHeight() && _levels[above]->getPixel(bx, by))
+					{
+						mask[y * _spriteWidth + x] |= SELECTOR_BACK | SELECTOR_FRONT;
+					}
+				}
+			}
+		}
+	}
+	_selectorMaskValid = true;
+}
+
+/**
+ * Draws a part of the cursor over the map, leaving out the pixels hidden behind terrain.
+ * @param frame Cursor frame.
+ * @param screenPos Position on the map surface.
+ * @param mask What hides the cursor on this level.
+ * @param part Part of the cursor, SELECTOR_BACK or SELECTOR_FRONT.
+ */
+void Map::drawMasked(Surface *frame, const Position &screenPos, const Uint8 *mask, Uint8 part)
+{
+	int width = std::min(frame->getWidth(), _spriteWidth), height = std::min(frame->getHeight(), _spriteHeight);
+	frame->lock();
+	this->lock();
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			Uint8 pixel = frame->getPixel(x, y);
+			if (pixel && !(mask[y * _spriteWidth + x] & part))
+			{
+				setPixel(screenPos.x + x, screenPos.y + y, pixel);
+			}
+		}
+	}
+	this->unlock();
+	frame->unlock();
+}
+
+/**
+ * Draws the 3D cursor and the arrow above the selected unit over the map, so
+ * they never have to be drawn into the levels, and moving the mouse doesn't redraw
+ * any terrain. The cursor is hidden where the terrain was drawn over it,
+ * the arrow stays on top.
+ */
+void Map::drawOverlay()
+{
+	if (_cursorType == CT_NONE)
+		return;
+
+	updateSelectorMask();
+	int size = _spriteWidth * _spriteHeight;
+	for (int z = 0; z <= _viewHeight; z++)
+	{
+		Position mapPos(_selectorY, _selectorX, z), screenPos;
+		BattleUnit *unit = _save->getTile(mapPos)->getUnit();
+		int back = 0, front = 3;
+		if (_viewHeight == z)
+		{
+			if (_cursorType == CT_AIM)
+			{
+				if (unit)
+					back = front = 7 + (_animFrame / 2); // yellow animated crosshairs
+				else
+					back = front = 6; // red static crosshairs
+			}
+			else if (unit)
+			{
+				back = 1; // yellow box
+				front = 4;
+			}
+		}
+		else
+		{
+			back = 2; // blue box
+			front = 5;
+		}
+		convertMapToScreen(mapPos, &screenPos);
+		screenPos.x += _mapOffsetX;
+		screenPos.y += _mapOffsetY;
+		drawMasked(_cursorSet->getFrame(back), screenPos, &_selectorMask[z * size], SELECTOR_BACK);
+		drawMasked(_cursorSet->getFrame(front), screenPos, &_selectorMask[z * size], SELECTOR_FRONT);
+	}
+
+	BattleUnit *selected = _save->getSelectedUnit();
+	if (selected && selected->getPosition().z <= _viewHeight && _unitCache.at(selected->getId()))
+	{
+		Position screenPos, offset;
+		convertMapToScreen(selected->getPosition(), &screenPos);
+		calculateWalkingOffset(selected, &offset);
+		drawArrow(screenPos + offset + Position(_mapOffsetX, _mapOffsetY, 0), this);
+	}
+}
+
+/**
+ * Moves what's drawn on a surface by a number of pixels. What was drawn
+ * where the pixels moved out from is left there, to be drawn over.
+ * @param surface Surface to move the pixels of.
+ * @param dx Pixels to move right (left if negative).
+ * @param dy Pixels to move down (up if negative).
+ */
+void Map::shiftSurface(Surface *surface, int dx, int dy)
+{
+	SDL_Surface *s = surface->getSurface();
+	int width = s->w - abs(dx), rows = s->h - abs(dy);
+	if (width <= 0 || rows <= 0)
+		return;
+
+	surface->lock();
+	Uint8 *pixels = (Uint8*)s->pixels;
+	for (int i = 0; i < rows; i++)
+	{
+		// rows are copied against the direction they move in, so none is overwritten before it's copied
+		int y = dy > 0 ? rows - 1 - i : i - dy;
+		memmove(pixels + (y + dy) * s->pitch + std::max(dx, 0), pixels + y * s->pitch + std::max(-dx, 0), width);
+	}
+	surface->unlock();
+}
+
+/**
+ * Moves the contents of a tile picking buffer, like shiftSurface does.
+ * @param ids Pointer to the buffer.
+ * @param width Width of the buffer in pixels.
+ * @param dx Pixels to move right.
+ * @param dy Pixels to move down.
+ */
+void Map::shiftTileIds(std::vector<Uint16> *ids, int width, int dx, int dy)
+{
+	int height = ids->size() / width;
+	int columns = width - abs(dx), rows = height - abs(dy);
+	if (columns <= 0 || rows <= 0)
+		return;
+
+	Uint16 *pixels = &(*ids)[0];
+	for (int i = 0; i < rows; i++)
+	{
+		int y = dy > 0 ? rows - 1 - i : i - dy;
+		memmove(pixels + (y + dy) * width + std::max(dx, 0), pixels + y * width + std::max(-dx, 0), columns * sizeof(Uint16));
+	}
+}
+
+/**
+ * Centers the view in the buffer again, after it scrolled out of it.
+ * What's drawn on the level surfaces and the buffer moves along, so
+ * only the strips that scrolled in have to be drawn, instead of the whole map.
+ * @param dx Pixels the drawn map moves right in the buffer.
+ * @param dy Pixels the drawn map moves down in the buffer.
+ */
+void Map::shiftBuffers(int dx, int dy)
+{
+	_bufOffsetX -= dx;
+	_bufOffsetY -= dy;
+	int width = _buffer->getWidth(), height = _buffer->getHeight();
+	if (abs(dx) >= width || abs(dy) >= height)
+	{
+		for (int z = 0; z < (int)_levels.size(); z++)
+		{
+			_staleLevels[z] = true;
+		}
+		return;
+	}
+
+	// hidden levels are redrawn when they're shown anyway
+	for (int z = 0; z <= _viewHeight; z++)
+	{
+		if (!_staleLevels[z])
+		{
+			shiftSurface(_levels[z], dx, dy);
+			shiftTileIds(&_tileIds[z], width, dx, dy);
+		}
+	}
+	shiftSurface(_buffer, dx, dy);
+
+	// a full width strip at the top or bottom, and the rest of the side, so they don't overlap and get merged
+	SDL_Rect strips[2];
+	strips[0].x = 0;
+	strips[0].y = dy > 0 ? 0 : height + dy;
+	strips[0].w = width;
+	strips[0].h = abs(dy);
+	strips[1].x = dx > 0 ? 0 : width + dx;
+	strips[1].y = dy > 0 ? dy : 0;
+	strips[1].w = abs(dx);
+	strips[1].h = height - abs(dy);
+	for (int i = 0; i < 2; i++)
+	{
+		// back from buffer coordinates to map pixels
+		strips[i].x -= _mapOffsetX - _bufOffsetX;
+		strips[i].y -= _mapOffsetY - _bufOffsetY;
+		markDirty(strips[i]);
+	}
+}
+
+/**
+ * Draw one level of the terrain.
+ * @param surface Surface to draw on.
+ * @param level Level to draw.
+ * @param clip Only draw the tiles reaching into this area, in surface coordinates (all if 0).
+ * @param from Only draw from this stage on, counting TILE_STAGES per tile in the order they are drawn (all if 0).
+ * @param ids Tile picking buffer the size of the surface, to mark the pixels of the tiles and units drawn in (none if 0).
+ */
+void Map::drawTerrain(Surface *surface, int level, const SDL_Rect *clip, int from, Uint16 *ids)
+{
+	ProfileMarker marker(PROF_TERRAIN);
 	int frameNumber = 0;
 	Surface *frame;
 	Tile *tile;
 	int beginX = 0, endX = _save->getWidth() - 1;
     int beginY = 0, endY = _save->getLength() - 1;
-    int beginZ = 0, endZ = _viewHeight;
+    int beginZ = level, endZ = level;
 	Position mapPosition, screenPosition, bulletPositionScreen;
-	int bulletLowX=16000, bulletLowY=16000, bulletLowZ=16000, bulletHighX=0, bulletHighY=0, bulletHighZ=0;
 	int index;
 	bool dirty;
 
-	// if we got bullet, get the highest x and y tiles to draw it on
+	// sort the projectile particles and explosions into the tiles they are drawn on, anything
+	// above the view height is drawn on top of the highest layer shown
+	std::multimap<int, int> bullets, shadows;
+	std::multimap<int, Explosion*> explosions;
 	if (_projectile)
 	{
 		for (int i = 1; i <= _projectile->getParticle(0); i++)
 		{
-			if (_projectile->getPosition(1-i).x < bulletLowX)
-				bulletLowX = _projectile->getPosition(1-i).x;
-			if (_projectile->getPosition(1-i).y < bulletLowY)
-				bulletLowY = _projectile->getPosition(1-i).y;
-			if (_projectile->getPosition(1-i).z < bulletLowZ)
-				bulletLowZ = _projectile->getPosition(1-i).z;
-			if (_projectile->getPosition(1-i).x > bulletHighX)
-				bulletHighX = _projectile->getPosition(1-i).x;
-			if (_projectile->getPosition(1-i).y > bulletHighY)
-				bulletHighY = _projectile->getPosition(1-i).y;
-			if (_projectile->getPosition(1-i).z > bulletHighZ)
-				bulletHighZ = _projectile->getPosition(1-i).z;
+			if (_projectile->getParticle(i) != 0xFF)
+			{
+				Position voxelPos = _projectile->getPosition(1-i);
+				mapPosition = Position(voxelPos.x / 16, voxelPos.y / 16, std::min(voxelPos.z / 24, _viewHeight));
+				if (_save->getTile(mapPosition))
+				{
+					bullets.insert(std::make_pair(_save->getTileIndex(mapPosition), i));
+					mapPosition.z = 0;
+					shadows.insert(std::make_pair(_save->getTileIndex(mapPosition), i));
+				}
+			}
+		}
+	}
+	for (std::set<Explosion*>::const_iterator i = _explosions.begin(); i != _explosions.end(); i++)
+	{
+		if (!(*i)->isBig())
+		{
+			Position voxelPos = (*i)->getPosition();
+			mapPosition = Position(voxelPos.x / 16, voxelPos.y / 16, std::min(voxelPos.z / 24, _viewHeight));
+			if (_save->getTile(mapPosition))
+			{
+				explosions.insert(std::make_pair(_save->getTileIndex(mapPosition), *i));
+			}
 		}
 	}
-	// divide by 16 to go from voxel to tile position
-	bulletLowX = bulletLowX / 16;
-	bulletLowY = bulletLowY / 16;
-	bulletLowZ = bulletLowZ / 24;
-	bulletHighX = bulletHighX / 16;
-	bulletHighY = bulletHighY / 16;
-	bulletHighZ = bulletHighZ / 24;
+
+	// a cell is drawn when its sprite position lies strictly inside these bounds
+	int left = -_spriteWidth, right = surface->getWidth() + _spriteWidth;
+	int top = -_spriteHeight, bottom = surface->getHeight() + _spriteHeight;
+	if (clip)
+	{
+		// cells that can reach into the clipped area, allowing for walking units and explosions
+		left = std::max(left, clip->x - _spriteWidth * 2);
+		right = std::min(right, clip->x + clip->w + _spriteWidth);
+		top = std::max(top, clip->y - _spriteHeight * 2);
+		bottom = std::min(bottom, clip->y + clip->h + _spriteHeight);
+	}
+	int offsetX = _mapOffsetX - _bufOffsetX, offsetY = _mapOffsetY - _bufOffsetY;
+	int levelHeight = (_spriteHeight + _spriteWidth / 4) / 2;
 
     for (int itZ = beginZ; itZ <= endZ; itZ++)
 	{
-        for (int itX = beginX; itX <= endX; itX++)
+		// invert the isometric projection: screen x depends on x+y, screen y on x-y and z
+		int sumMin = (int)floor((double)(left - offsetX) / (_spriteWidth / 2));
+		int sumMax = (int)ceil((double)(right - offsetX) / (_spriteWidth / 2));
+		int diffMin = (int)floor((double)(top - offsetY + itZ * levelHeight) / (_spriteWidth / 4));
+		int diffMax = (int)ceil((double)(bottom - offsetY + itZ * levelHeight) / (_spriteWidth / 4));
+		int firstX = std::max(beginX, (int)floor((sumMin + diffMin) / 2.0));
+		int lastX = std::min(endX, (int)ceil((sumMax + diffMax) / 2.0));
+
+        for (int itX = firstX; itX <= lastX; itX++)
 		{
-            for (int itY = endY; itY >= beginY; itY--)
+			int firstY = std::max(beginY, std::max(sumMin - itX, itX - diffMax));
+			int lastY = std::min(endY, std::min(sumMax - itX, itX - diffMin));
+
+            for (int itY = lastY; itY >= firstY; itY--)
 			{
 				mapPosition = Position(itX, itY, itZ);
 				convertMapToScreen(mapPosition, &screenPosition);
 				screenPosition.x += _mapOffsetX - _bufOffsetX;
 				screenPosition.y += _mapOffsetY - _bufOffsetY;
 
-				// only render cells that are inside the surface
-				if (screenPosition.x > -_spriteWidth && screenPosition.x < surface->getWidth() + _spriteWidth &&
-					screenPosition.y > -_spriteHeight && screenPosition.y < surface->getHeight() + _spriteHeight )
+				// the ranges above are rounded outwards, so check the cell itself too
+				if (screenPosition.x > left && screenPosition.x < right &&
+					screenPosition.y > top && screenPosition.y < bottom)
 				{
 					index = _save->getTileIndex(mapPosition); // index used for tile cache
 
 					dirty = cacheTileSprites(index);
 
+					// the stages of the tiles in the order they are drawn in
+					int stage = (itX * _save->getLength() + endY - itY) * TILE_STAGES;
+
 					tile = _save->getTile(mapPosition);
 					// Draw floor
-					if (tile)
+					if (tile && stage >= from)
 					{
-						frame = _tileFloorCache[index];
-						if (frame)
-						{
-							frame->setX(screenPosition.x);
-							frame->setY(screenPosition.y);
-							frame->blit(surface);
-						}
+						drawPiece(_tilePieces[index * TILE_PIECES], screenPosition, surface, ids, index + 1);
 					}
 
 					BattleUnit *unit = tile->getUnit();
 
-					// Draw cursor back
-					if (_selectorX == itY && _selectorY == itX && _cursorType != CT_NONE)
+					// Draw walls, object, item, units, projectile and explosions
+					if (stage + 1 >= from)
 					{
-						if (_viewHeight == itZ)
+						// Draw walls, object and item
+						if (tile)
 						{
-							if (_cursorType == CT_NORMAL)
-							{
-								if (unit)
-									frameNumber = 1; // yellow box
-								else
-									frameNumber = 0; // red box
-							}
-							if (_cursorType == CT_AIM)
+							for (int piece = 1; piece < TILE_PIECES; piece++)
 							{
-								if (unit)
-									frameNumber = 7 + (_animFrame / 2); // yellow animated crosshairs
-								else
-									frameNumber = 6; // red static crosshairs
+								drawPiece(_tilePieces[index * TILE_PIECES + piece], screenPosition, surface, ids, index + 1);
 							}
 						}
-						else if (_viewHeight > itZ)
-						{
-							frameNumber = 2; // blue box
-						}
-						frame = _res->getSurfaceSet("CURSOR.PCK")->getFrame(frameNumber);
-						frame->setX(screenPosition.x);
-						frame->setY(screenPosition.y);
-						frame->blit(surface);
-					}
-
-					// Draw walls
-					if (tile)
-					{
-						frame = _tileWallsCache[index];
-						if (frame)
-						{
-							frame->setX(screenPosition.x);
-							frame->setY(screenPosition.y);
-							frame->blit(surface);
-						}
-					}
 
-					// Draw soldier
-					if (unit)
-					{
-						frame = _unitCache.at(unit->getId());
-						if (frame)
-						{
-							Position offset;
-							calculateWalkingOffset(unit, &offset);
-							frame->setX(screenPosition.x + offset.x);
-							frame->setY(screenPosition.y + offset.y);
-							frame->blit(surface);
-							if (unit == (BattleUnit*)_save->getSelectedUnit() && _cursorType != CT_NONE)
-							{
-								drawArrow(screenPosition + offset, surface);
-							}
-						}
-					}
-					// if we can see through the floor, draw the soldier below it if it is on stairs
-					if (itZ > 0 && tile->hasNoFloor())
-					{
-						unit = _save->selectUnit(mapPosition + Position(0, 0, -1));
-						tile = _save->getTile(mapPosition + Position(0, 0, -1));
-						if (unit && tile->getTerrainLevel() < 0)
+						// Draw soldier
+						if (unit)
 						{
 							frame = _unitCache.at(unit->getId());
 							if (frame)
 							{
 								Position offset;
 								calculateWalkingOffset(unit, &offset);
-								offset.y += 24;
 								frame->setX(screenPosition.x + offset.x);
 								frame->setY(screenPosition.y + offset.y);
 								frame->blit(surface);
-								if (unit == (BattleUnit*)_save->getSelectedUnit() && _cursorType != CT_NONE)
+								if (ids)
 								{
-									drawArrow(screenPosition + offset, surface);
+									markTileIds(frame, 0, frame->getX(), frame->getY(), surface, ids, index + 1);
 								}
 							}
 						}
-					}
-					unit = tile->getUnit();
-
-					// check if we got bullet
-					if (_projectile)
-					{
-						// draw bullet on the correct tile
-						if (itX >= bulletLowX && itX <= bulletHighX && itY >= bulletLowY && itY <= bulletHighY)
+						// if we can see through the floor, draw the soldier below it if it is on stairs
+						if (itZ > 0 && tile->hasNoFloor())
 						{
-							if (itZ == 0)
+							unit = _save->selectUnit(mapPosition + Position(0, 0, -1));
+							tile = _save->getTile(mapPosition + Position(0, 0, -1));
+							if (unit && tile->getTerrainLevel() < 0)
 							{
-								// draw shadow on the floor
-								for (int i = 1; i <= _projectile->getParticle(0); i++)
+								frame = _unitCache.at(unit->getId());
+								if (frame)
 								{
-									if (_projectile->getParticle(i) != 0xFF)
+									Position offset;
+									calculateWalkingOffset(unit, &offset);
+									offset.y += 24;
+									frame->setX(screenPosition.x + offset.x);
+									frame->setY(screenPosition.y + offset.y);
+									frame->blit(surface);
+									if (ids)
 									{
-										Position voxelPos = _projectile->getPosition(1-i);
-										voxelPos.z = 0;
-										if (voxelPos.x / 16 == mapPosition.x &&
-											voxelPos.y / 16 == mapPosition.y)
-										{
-											convertVoxelToScreen(voxelPos, &bulletPositionScreen);
-											_bulletShadow[_projectile->getParticle(i)]->setX(bulletPositionScreen.x);
-											_bulletShadow[_projectile->getParticle(i)]->setY(bulletPositionScreen.y);
-											_bulletShadow[_projectile->getParticle(i)]->blit(surface);
-										}
-									}
-								}
-							}
-
-							for (int i = 1; i <= _projectile->getParticle(0); i++)
-							{
-								if (_projectile->getParticle(i) != 0xFF)
-								{
-									Position voxelPos = _projectile->getPosition(1-i);
-									if (voxelPos.x / 16 == mapPosition.x &&
-										voxelPos.y / 16 == mapPosition.y )
-									{
-										convertVoxelToScreen(voxelPos, &bulletPositionScreen);
-										_bullet[_projectile->getParticle(i)]->setX(bulletPositionScreen.x);
-										_bullet[_projectile->getParticle(i)]->setY(bulletPositionScreen.y);
-										_bullet[_projectile->getParticle(i)]->blit(surface);
+										markTileIds(frame, 0, frame->getX(), frame->getY(), surface, ids, index + 1);
 									}
 								}
 							}
 						}
-					}
 
-					// check if we gots explosions
-					for (std::set<Explosion*>::const_iterator i = _explosions.begin(); i != _explosions.end(); i++)
-					{
-						if (!(*i)->isBig())
+						// draw the projectile's shadows and particles in this tile
+						std::pair<std::multimap<int, int>::const_iterator, std::multimap<int, int>::const_iterator> particles = shadows.equal_range(index);
+						for (std::multimap<int, int>::const_iterator i = particles.first; i != particles.second; i++)
 						{
-							Position voxelPos = (*i)->getPosition();
+							Position voxelPos = _projectile->getPosition(1-i->second);
+							voxelPos.z = 0;
 							convertVoxelToScreen(voxelPos, &bulletPositionScreen);
-							frame = _res->getSurfaceSet("SMOKE.PCK")->getFrame((*i)->getCurrentFrame());
+							_bulletShadow[_projectile->getParticle(i->second)]->setX(bulletPositionScreen.x);
+							_bulletShadow[_projectile->getParticle(i->second)]->setY(bulletPositionScreen.y);
+							_bulletShadow[_projectile->getParticle(i->second)]->blit(surface);
+						}
+						particles = bullets.equal_range(index);
+						for (std::multimap<int, int>::const_iterator i = particles.first; i != particles.second; i++)
+						{
+							convertVoxelToScreen(_projectile->getPosition(1-i->second), &bulletPositionScreen);
+							_bullet[_projectile->getParticle(i->second)]->setX(bulletPositionScreen.x);
+							_bullet[_projectile->getParticle(i->second)]->setY(bulletPositionScreen.y);
+							_bullet[_projectile->getParticle(i->second)]->blit(surface);
+						}
+
+						// draw the explosions in this tile
+						std::pair<std::multimap<int, Explosion*>::const_iterator, std::multimap<int, Explosion*>::const_iterator> blasts = explosions.equal_range(index);
+						for (std::multimap<int, Explosion*>::const_iterator i = blasts.first; i != blasts.second; i++)
+						{
+							convertVoxelToScreen(i->second->getPosition(), &bulletPositionScreen);
+							frame = _smokeSet->getFrame(i->second->getCurrentFrame());
 							frame->setX(bulletPositionScreen.x - 15);
 							frame->setY(bulletPositionScreen.y - 15);
 							frame->blit(surface);
 						}
 					}
 
-					// Draw cursor front
-					if (_selectorX == itY && _selectorY == itX && _cursorType != CT_NONE)
+					// Draw smoke/fire
+					if (stage + 2 >= from)
 					{
-						if (_viewHeight == itZ)
+						tile = _save->getTile(mapPosition);
+						if (tile->getFire() && tile->isDiscovered())
 						{
-							if (_cursorType == CT_NORMAL)
+							frameNumber = 0; // see http://www.ufopaedia.org/images/c/cb/Smoke.gif
+							if ((_animFrame / 2) + tile->getAnimationOffset() > 3)
 							{
-								if (unit)
-									frameNumber = 4; // yellow box
-								else
-									frameNumber = 3; // red box
+								frameNumber += ((_animFrame / 2) + tile->getAnimationOffset() - 4);
 							}
-							if (_cursorType == CT_AIM)
+							else
 							{
-								if (unit)
-									frameNumber = 7 + (_animFrame / 2); // yellow animated crosshairs
-								else
-									frameNumber = 6; // red static crosshairs
+								frameNumber += (_animFrame / 2) + tile->getAnimationOffset();
 							}
+							frame = _smokeSet->getFrame(frameNumber);
+							frame->setX(screenPosition.x);
+							frame->setY(screenPosition.y);
+							frame->blit(surface);
 						}
-						else if (_viewHeight > itZ)
-						{
-							frameNumber = 5; // blue box
-						}
-						frame = _res->getSurfaceSet("CURSOR.PCK")->getFrame(frameNumber);
-						frame->setX(screenPosition.x);
-						frame->setY(screenPosition.y);
-						frame->blit(surface);
-					}
-
-					tile = _save->getTile(mapPosition);
-					// Draw smoke/fire
-					if (tile->getFire() && tile->isDiscovered())
-					{
-						frameNumber = 0; // see http://www.ufopaedia.org/images/c/cb/Smoke.gif
-						if ((_animFrame / 2) + tile->getAnimationOffset() > 3)
-						{
-							frameNumber += ((_animFrame / 2) + tile->getAnimationOffset() - 4);
-						}
-						else
-						{
-							frameNumber += (_animFrame / 2) + tile->getAnimationOffset();
-						}
-						frame = _res->getSurfaceSet("SMOKE.PCK")->getFrame(frameNumber);
-						frame->setX(screenPosition.x);
-						frame->setY(screenPosition.y);
-						frame->blit(surface);
-					}
-					if (tile->getSmoke() && tile->isDiscovered())
-					{
-						frameNumber = 8 + int(floor((tile->getSmoke() / 5.0) - 0.1)); // see http://www.ufopaedia.org/images/c/cb/Smoke.gif
-						if ((_animFrame / 2) + tile->getAnimationOffset() > 3)
-						{
-							frameNumber += ((_animFrame / 2) + tile->getAnimationOffset() - 4);
-						}
-						else
+						if (tile->getSmoke() && tile->isDiscovered())
 						{
-							frameNumber += (_animFrame / 2) + tile->getAnimationOffset();
+							frameNumber = 8 + int(floor((tile->getSmoke() / 5.0) - 0.1)); // see http://www.ufopaedia.org/images/c/cb/Smoke.gif
+							if ((_animFrame / 2) + tile->getAnimationOffset() > 3)
+							{
+								frameNumber += ((_animFrame / 2) + tile->getAnimationOffset() - 4);
+							}
+							else
+							{
+								frameNumber += (_animFrame / 2) + tile->getAnimationOffset();
+							}
+							frame = _smokeSet->getFrame(frameNumber);
+							frame->setX(screenPosition.x);
+							frame->setY(screenPosition.y);
+							frame->blit(surface);
 						}
-						frame = _res->getSurfaceSet("SMOKE.PCK")->getFrame(frameNumber);
-						frame->setX(screenPosition.x);
-						frame->setY(screenPosition.y);
-						frame->blit(surface);
 					}
 				}
 			}
@@ -682,14 +1230,34 @@ void Map::setSelectorPosition(int mx, int my)
 	int oldX = _selectorX, oldY = _selectorY;
 
 	if (!mx && !my) return; // cursor is offscreen
-	convertScreenToMap(mx, my, &_selectorX, &_selectorY);
+
+	// the tile drawn on top of the pixel on the level shown, so walls and objects reaching into
+	// other tiles pick their own, only empty spots are worked out from the isometric projection
+	int bx = mx - _bufOffsetX, by = my - _bufOffsetY, id = 0;
+	if (bx >= 0 && by >= 0 && bx < _buffer->getWidth() && by < _buffer->getHeight() && !_staleLevels[_viewHeight])
+	{
+		id = _tileIds[_viewHeight][by * _buffer->getWidth() + bx];
+	}
+	if (id)
+	{
+		int x, y, z;
+		_save->getTileCoords(id - 1, &x, &y, &z);
+		// the selector has x and y the other way around
+		_selectorX = y;
+		_selectorY = x;
+	}
+	else
+	{
+		convertScreenToMap(mx, my, &_selectorX, &_selectorY);
+	}
 	minMaxInt(&_selectorX, 0, _save->getWidth() - 1);
 	minMaxInt(&_selectorY, 0, _save->getLength() - 1);
 
 	if (oldX != _selectorX || oldY != _selectorY)
 	{
-		//draw(false);
-		// todo: when working with dirty rects we can implement smooth mouse movement
+		// the cursor is drawn over the map, only what hides it has to be found again
+		_selectorMaskValid = false;
+		draw(false);
 	}
 }
 
@@ -743,12 +1311,32 @@ void Map::animate()
 	_animFrame++;
 	if (_animFrame == 8) _animFrame = 0;
 
-	for (int i = 0; i < _tileCount; i++)
+	// only the tiles with animated objects change, the rest keep their cache
+	std::set<int> *animated = _save->getAnimatedTiles();
+	for (std::set<int>::iterator i = animated->begin(); i != animated->end();)
 	{
-		_save->getTiles()[i]->animate();
+		Tile *tile = _save->getTiles()[*i];
+		tile->animate();
+		if (tile->isAnimated())
+		{
+			i++;
+		}
+		else
+		{
+			animated->erase(i++);
+		}
 	}
-	cacheTileSprites();
-	draw(true);
+
+	// fire and smoke animate without touching the tile caches, the cursor and arrow are drawn over the map anyway
+	for (std::set<int>::const_iterator i = _save->getActiveTiles()->begin(); i != _save->getActiveTiles()->end(); i++)
+	{
+		Tile *tile = _save->getTiles()[*i];
+		if ((tile->getFire() || tile->getSmoke()) && tile->isDiscovered())
+		{
+			markTileDirty(tile->getPosition());
+		}
+	}
+	draw(false);
 }
 
 /**
@@ -758,9 +1346,9 @@ void Map::up()
 {
 	if (_viewHeight < _save->getHeight() - 1)
 	{
-		_viewHeight++;
 		_mapOffsetY += _spriteHeight / 2;
-		draw(true);
+		changeViewHeight(_viewHeight + 1);
+		draw(false);
 	}
 }
 
@@ -771,9 +1359,9 @@ void Map::down()
 {
 	if (_viewHeight > 0)
 	{
-		_viewHeight--;
 		_mapOffsetY -= _spriteHeight / 2;
-		draw(true);
+		changeViewHeight(_viewHeight - 1);
+		draw(false);
 	}
 }
 
@@ -783,9 +1371,35 @@ void Map::down()
  */
 void Map::setViewHeight(int viewheight)
 {
+	minMaxInt(&viewheight, 0, _save->getHeight()-1);
+	changeViewHeight(viewheight);
+	draw(false);
+}
+
+/**
+ * Gets the highest level shown.
+ * @return view height
+ */
+int Map::getViewHeight() const
+{
+	return _viewHeight;
+}
+
+/**
+ * Changes the highest level shown. The levels keep their contents,
+ * only what depends on the view height is marked to be redrawn.
+ * @param viewheight New view height.
+ */
+void Map::changeViewHeight(int viewheight)
+{
+	// the cursor changes colour and the projectile and explosions move with the view height
 	_viewHeight = viewheight;
-	minMaxInt(&_viewHeight, 0, _save->getHeight()-1);
-	draw(true);
+	_selectorMaskValid = false;
+	for (std::vector<SDL_Rect>::iterator i = _effectRects.begin(); i != _effectRects.end(); i++)
+	{
+		markDirty(*i);
+	}
+	_recomposite = true;
 }
 
 
@@ -873,10 +1487,12 @@ void Map::calculateWalkingOffset(BattleUnit *unit, Position *offset)
 	int offsetY[8] = { 1, 0, -1, -1, -1, 0, 1, 1 };
 	int phase = unit->getWalkingPhase() + unit->getDiagonalWalkingPhase();
 	int dir = unit->getDirection();
-	int midphase = 4 + 4 * (dir % 2);
-	int endphase = 8 + 8 * (dir % 2);
+	bool vertical = unit->getVerticalDirection() != 0;
+	int midphase = 4 + 4 * (dir % 2 && !vertical);
+	int endphase = 8 + 8 * (dir % 2 && !vertical);
 
-	if (unit->getStatus() == STATUS_WALKING)
+	// flying up or down only changes the level, that's interpolated below
+	if (unit->getStatus() == STATUS_WALKING && !vertical)
 	{
 		if (phase < midphase)
 		{
@@ -956,11 +1572,25 @@ CursorType Map::getCursorType() const
  */
 void Map::cacheTileSprites()
 {
-	for (int i = 0; i < _tileCount; i++)
+	// over budget the atlas starts over with just the sprites the map uses now,
+	// if those don't fit either the budget grows to them so it doesn't start over every time
+	if (MAX_ATLAS_PAGES > 0 && _atlasPages.size() > std::max((unsigned int)MAX_ATLAS_PAGES, _atlasFloor))
 	{
-		cacheTileSprites(i);
+		releaseAtlas();
 	}
 
+	// only the tiles that changed since the last time need to be cached
+	std::vector<int> uncached;
+	uncached.swap(*_save->getUncachedTiles());
+	bool rebuilt = _atlasPages.empty();
+	for (std::vector<int>::iterator i = uncached.begin(); i != uncached.end(); i++)
+	{
+		cacheTileSprites(*i);
+	}
+	if (rebuilt)
+	{
+		_atlasFloor = _atlasPages.size();
+	}
 }
 
 /**
@@ -976,115 +1606,68 @@ bool Map::cacheTileSprites(int i)
 
 	if(tile && !tile->isCached())
 	{
+		SpritePiece *pieces = &_tilePieces[i * TILE_PIECES];
+		for (int piece = 0; piece < TILE_PIECES; piece++)
+		{
+			pieces[piece].page = 0;
+		}
+		int shade = tile->isDiscovered()?tile->getShade():16;
 
-		/* draw a floor object on the cache (if any) */
+		/* the floor object (if any) */
 		object = tile->getMapData(O_FLOOR);
-
 		if (object)
 		{
-			if (_tileFloorCache[i] == 0)
-			{
-				_tileFloorCache[i] = new Surface(_spriteWidth, _spriteHeight);
-				_tileFloorCache[i]->setPalette(this->getPalette());
-			}
-			else
-			{
-				_tileFloorCache[i]->clear();
-			}
-
-			// Draw floor
 			frame = tile->getSprite(O_FLOOR);
-			frame->setX(0);
-			frame->setY(-object->getYOffset());
-			frame->blit(_tileFloorCache[i]);
-
-			_tileFloorCache[i]->setShade(tile->isDiscovered()?tile->getShade():16);
+			setTilePiece(&pieces[0], frame, shade, 0, -object->getYOffset(), 0, frame->getWidth());
 		}
-		else if (_tileFloorCache[i] != 0)
+
+		/* terrain objects (if any) */
+		object = tile->getMapData(O_NORTHWALL) ? tile->getMapData(O_NORTHWALL) : tile->getMapData(O_WESTWALL);
+		door = object && (object->isDoor() || object->isUFODoor());
+		if (door && tile->getShade() > 8 && tile->isDiscovered()) // don't shade doors too dark, so you can still see them
 		{
-			_tileFloorCache[i]->clear();
+			shade = 8;
 		}
 
-		/* draw terrain objects on the cache (if any) */
-		if (tile->getMapData(O_WESTWALL) != 0 || tile->getMapData(O_NORTHWALL) != 0 || tile->getMapData(O_OBJECT) != 0 || tile->getTopItemSprite() != -1)
+		// west wall
+		object = tile->getMapData(O_WESTWALL);
+		if (object)
 		{
-			if (_tileWallsCache[i] == 0)
+			frame = tile->getSprite(O_WESTWALL);
+			setTilePiece(&pieces[1], frame, shade, 0, -object->getYOffset(), 0, frame->getWidth());
+		}
+		// north wall
+		object = tile->getMapData(O_NORTHWALL);
+		if (object)
+		{
+			frame = tile->getSprite(O_NORTHWALL);
+			// if there is a westwall, cut off some of the north wall (otherwise it will overlap)
+			if (tile->getMapData(O_WESTWALL))
 			{
-				_tileWallsCache[i] = new Surface(_spriteWidth, _spriteHeight);
-				_tileWallsCache[i]->setPalette(this->getPalette());
+				setTilePiece(&pieces[2], frame, shade, frame->getWidth() / 2, -object->getYOffset(), frame->getWidth() / 2, frame->getWidth() / 2);
 			}
 			else
 			{
-				_tileWallsCache[i]->clear();
-			}
-
-			// Draw west wall
-			object = tile->getMapData(O_WESTWALL);
-			if (object)
-			{
-				frame = tile->getSprite(O_WESTWALL);
-				frame->setX(0);
-				frame->setY(-object->getYOffset());
-				frame->blit(_tileWallsCache[i]);
-				door = object->isDoor() || object->isUFODoor();
-			}
-			// Draw north wall
-			object = tile->getMapData(O_NORTHWALL);
-			if (object)
-			{
-				frame = tile->getSprite(O_NORTHWALL);
-				frame->setX(0);
-				frame->setY(-object->getYOffset());
-				// if there is a westwall, cut off some of the north wall (otherwise it will overlap)
-				if (tile->getMapData(O_WESTWALL))
-				{
-					frame->setX(frame->getWidth() / 2);
-					frame->getCrop()->x = frame->getWidth() / 2;
-					frame->getCrop()->w = frame->getWidth() / 2;
-					frame->getCrop()->h = frame->getHeight();
-				}else
-				{
-					frame->getCrop()->w = 0;
-					frame->getCrop()->h = 0;
-				}
-				frame->blit(_tileWallsCache[i]);
-				door = object->isDoor() || object->isUFODoor();
-			}
-			// Draw object
-			object = tile->getMapData(O_OBJECT);
-			if (object)
-			{
-				frame = tile->getSprite(O_OBJECT);
-				frame->setX(0);
-				frame->setY(-object->getYOffset());
-				frame->blit(_tileWallsCache[i]);
+				setTilePiece(&pieces[2], frame, shade, 0, -object->getYOffset(), 0, frame->getWidth());
 			}
-
-			// draw an item on top of the floor (if any)
-			int sprite = tile->getTopItemSprite();
-			if (sprite != -1)
-			{
-				frame = _res->getSurfaceSet("FLOOROB.PCK")->getFrame(sprite);
-				frame->setX(0);
-				if (object == 0)
-				{
-					object = tile->getMapData(O_FLOOR);
-				}
-				frame->setY(object->getTerrainLevel());
-				frame->blit(_tileWallsCache[i]);
-			}
-
-			if (door && tile->getShade() > 8 && tile->isDiscovered()) // don't shade doors too dark, so you can still see them
-			{
-				_tileWallsCache[i]->setShade(8);
-			}
-			else
+		}
+		// object
+		object = tile->getMapData(O_OBJECT);
+		if (object)
+		{
+			frame = tile->getSprite(O_OBJECT);
+			setTilePiece(&pieces[3], frame, shade, 0, -object->getYOffset(), 0, frame->getWidth());
+		}
+		// an item on top of the floor
+		int sprite = tile->getTopItemSprite();
+		if (sprite != -1)
+		{
+			if (object == 0)
 			{
-				_tileWallsCache[i]->setShade(tile->isDiscovered()?tile->getShade():16);
+				object = tile->getMapData(O_FLOOR);
 			}
-		}else if (_tileWallsCache[i] != 0)
-		{
-			_tileWallsCache[i]->clear();
+			frame = _floorobSet->getFrame(sprite);
+			setTilePiece(&pieces[4], frame, shade, 0, object->getTerrainLevel(), 0, frame->getWidth());
 		}
 
 		// if lighting changed for a tile, then it also does for a unit standing on it
@@ -1094,6 +1677,7 @@ bool Map::cacheTileSprites(int i)
 		}
 
 		tile->setCached(true);
+		markTileDirty(tile->getPosition());
 		return true;
 	}
 	else
@@ -1102,28 +1686,213 @@ bool Map::cacheTileSprites(int i)
 	}
 }
 
+/**
+ * Gets a shaded copy of a sprite from the atlas, adding it
+ * to a free slot on one of the atlas pages when it's not there yet.
+ * @param sprite Pointer to the sprite.
+ * @param shade Shade level of the copy.
+ * @return Page and position of the copy.
+ */
+const Map::SpritePiece &Map::getAtlasSprite(Surface *sprite, int shade)
+{
+	std::pair<Surface*, int> key = std::make_pair(sprite, shade);
+	std::map<std::pair<Surface*, int>, SpritePiece>::iterator i = _atlas.find(key);
+	if (i != _atlas.end())
+	{
+		return i->second;
+	}
+
+	int columns = ATLAS_PAGE_SIZE / _spriteWidth;
+	int slots = columns * (ATLAS_PAGE_SIZE / _spriteHeight);
+	int slot = _atlas.size() % slots;
+	if (slot == 0)
+	{
+		Surface *page = new Surface(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+		page->setMemoryTag(MEM_MAPCACHE);
+		page->setPalette(this->getPalette());
+		_atlasPages.push_back(page);
+	}
+
+	SpritePiece copy;
+	copy.page = _atlasPages.back();
+	copy.crop.x = (slot % columns) * _spriteWidth;
+	copy.crop.y = (slot / columns) * _spriteHeight;
+	copy.crop.w = _spriteWidth;
+	copy.crop.h = _spriteHeight;
+	copy.x = 0;
+	copy.y = 0;
+
+	// copy the whole sprite, but keep it inside its slot
+	SDL_Rect crop = *sprite->getCrop();
+	sprite->resetCrop();
+	sprite->setX(copy.crop.x);
+	sprite->setY(copy.crop.y);
+	SDL_SetClipRect(copy.page->getSurface(), &copy.crop);
+	sprite->blitRemapped(copy.page, Surface::getShadeTable(shade));
+	SDL_SetClipRect(copy.page->getSurface(), 0);
+	*sprite->getCrop() = crop;
+
+	return _atlas.insert(std::make_pair(key, copy)).first->second;
+}
+
+/**
+ * Throws away the atlas, so every tile is cached again
+ * and every level redrawn with the new copies.
+ */
+void Map::releaseAtlas()
+{
+	for (std::vector<Surface*>::iterator i = _atlasPages.begin(); i != _atlasPages.end(); i++)
+	{
+		delete *i;
+	}
+	_atlasPages.clear();
+	_atlas.clear();
+	for (int i = 0; i < _tileCount; i++)
+	{
+		for (int piece = 0; piece < TILE_PIECES; piece++)
+		{
+			_tilePieces[i * TILE_PIECES + piece].page = 0;
+		}
+		if (_save->getTiles()[i])
+		{
+			_save->getTiles()[i]->setCached(false);
+		}
+	}
+	_staleLevels.assign(_staleLevels.size(), true);
+}
+
+/**
+ * Sets a piece of a tile's graphics to part of a shaded sprite. The piece
+ * is cut off at the tile's sprite area, as sprites always used to be
+ * composed within it.
+ * @param piece Pointer to the piece.
+ * @param sprite Pointer to the sprite.
+ * @param shade Shade level.
+ * @param x X position of the sprite part within the tile.
+ * @param y Y position of the sprite part within the tile.
+ * @param srcX First column of the sprite to use.
+ * @param width Number of columns of the sprite to use.
+ */
+void Map::setTilePiece(SpritePiece *piece, Surface *sprite, int shade, int x, int y, int srcX, int width)
+{
+	const SpritePiece &copy = getAtlasSprite(sprite, shade);
+	int srcY = 0, height = std::min(sprite->getHeight(), _spriteHeight);
+	width = std::min(width, _spriteWidth - srcX);
+	if (x < 0)
+	{
+		srcX -= x;
+		width += x;
+		x = 0;
+	}
+	if (y < 0)
+	{
+		srcY -= y;
+		height += y;
+		y = 0;
+	}
+	width = std::min(width, _spriteWidth - x);
+	height = std::min(height, _spriteHeight - y);
+	if (width <= 0 || height <= 0)
+	{
+		piece->page = 0;
+		return;
+	}
+	piece->page = copy.page;
+	piece->crop.x = copy.crop.x + srcX;
+	piece->crop.y = copy.crop.y + srcY;
+	piece->crop.w = width;
+	piece->crop.h = height;
+	piece->x = x;
+	piece->y = y;
+}
+
+/**
+ * Draws a piece of a tile's graphics.
+ * @param piece The piece.
+ * @param screenPos Position of the tile on the surface.
+ * @param surface Surface to draw on.
+ * @param ids Tile picking buffer of the surface to mark the piece's pixels in (none if 0).
+ * @param id Tile index + 1 to mark them with.
+ */
+void Map::drawPiece(const SpritePiece &piece, const Position &screenPos, Surface *surface, Uint16 *ids, int id)
+{
+	if (piece.page)
+	{
+		*piece.page->getCrop() = piece.crop;
+		piece.page->setX(screenPos.x + piece.x);
+		piece.page->setY(screenPos.y + piece.y);
+		piece.page->blit(surface);
+		if (ids)
+		{
+			markTileIds(piece.page, &piece.crop, screenPos.x + piece.x, screenPos.y + piece.y, surface, ids, id);
+		}
+	}
+}
+
+/**
+ * Marks the pixels a sprite was just drawn on in a tile picking buffer,
+ * so the tile on top of every pixel is known without working it out.
+ * Only the opaque pixels inside the clipping area of the surface are marked.
+ * @param sprite Sprite that was drawn.
+ * @param crop Part of the sprite that was drawn (all of it if 0).
+ * @param x X position it was drawn at.
+ * @param y Y position it was drawn at.
+ * @param surface Surface it was drawn on.
+ * @param ids Tile picking buffer the size of the surface.
+ * @param id Tile index + 1 to mark the pixels with.
+ */
+void Map::markTileIds(Surface *sprite, const SDL_Rect *crop, int x, int y, Surface *surface, Uint16 *ids, int id)
+{
+	SDL_Surface *src = sprite->getSurface(), *dst = surface->getSurface();
+	int cropX = crop ? crop->x : 0, cropY = crop ? crop->y : 0;
+	int cropW = crop ? crop->w : src->w, cropH = crop ? crop->h : src->h;
+	const SDL_Rect &clip = dst->clip_rect;
+	int x1 = std::max(x, (int)clip.x), y1 = std::max(y, (int)clip.y);
+	int x2 = std::min(x + cropW, clip.x + clip.w), y2 = std::min(y + cropH, clip.y + clip.h);
+	if (x1 >= x2 || y1 >= y2)
+		return;
+
+	sprite->lock();
+	for (int py = y1; py < y2; py++)
+	{
+		const Uint8 *row = (Uint8*)src->pixels + (cropY + py - y) * src->pitch + cropX - x;
+		Uint16 *out = ids + py * dst->w;
+		for (int px = x1; px < x2; px++)
+		{
+			if (row[px])
+			{
+				out[px] = id;
+			}
+		}
+	}
+	sprite->unlock();
+}
+
 /**
  * Check all units if they need to be redrawn.
+ * Frames are kept per armour sheet, pose, hand item and shade,
+ * so a unit changing pose normally just picks up an existing frame.
+ * Every pose is only composed from its body parts once, a new
+ * shade of it is remapped from the composed pose.
  */
 void Map::cacheUnits()
 {
-	UnitSprite *unitSprite = new UnitSprite(_spriteWidth, _spriteHeight, 0, 0);
-	//unitSprite->setSurfaces();
+	if (_unitSprite == 0)
+	{
+		_unitSprite = new UnitSprite(_spriteWidth, _spriteHeight, 0, 0);
+	}
+	UnitSprite *unitSprite = _unitSprite;
 	unitSprite->setPalette(this->getPalette());
+	if (MAX_UNIT_FRAMES > 0 && _unitFrames.size() > MAX_UNIT_FRAMES)
+	{
+		releaseUnitFrames();
+	}
 
 	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
 	{
 		if (!(*i)->isCached())
 		{
-			if (_unitCache.at((*i)->getId()) == 0)
-			{
-				_unitCache.at((*i)->getId()) = new Surface(_spriteWidth, _spriteHeight);
-				_unitCache.at((*i)->getId())->setPalette(this->getPalette());
-			}
-			else
-			{
-				_unitCache.at((*i)->getId())->clear();
-			}
+			markUnitDirty(_unitRects.at((*i)->getId()), _unitLevels.at((*i)->getId()));
 			unitSprite->setBattleUnit((*i));
 			BattleItem *handItem = _save->getItemFromUnit((*i), RIGHT_HAND);
 			if (handItem)
@@ -1134,16 +1903,60 @@ void Map::cacheUnits()
 			{
 				unitSprite->setBattleItem(0);
 			}
-			unitSprite->setSurfaces(_res->getSurfaceSet((*i)->getUnit()->getArmor()->getSpriteSheet()),
-									_res->getSurfaceSet("HANDOB.PCK"));
-			unitSprite->draw();
-			unitSprite->blit(_unitCache.at((*i)->getId()));
-
-			_unitCache.at((*i)->getId())->setShade(_save->getTile((*i)->getPosition())->getShade());
+			// units in the same pose share one frame, only compose it the first time it's seen
+			SurfaceSet *unitSet = _res->getSurfaceSet((*i)->getUnit()->getArmor()->getSpriteSheet());
+			int shade = _save->getTile((*i)->getPosition())->getShade();
+			int pose = unitSprite->getFrameKey();
+			std::pair<SurfaceSet*, int> key(unitSet, (pose << 5) | shade);
+			std::map<std::pair<SurfaceSet*, int>, Surface*>::iterator frame = _unitFrames.find(key);
+			if (frame == _unitFrames.end())
+			{
+				std::pair<SurfaceSet*, int> poseKey(unitSet, pose);
+				std::map<std::pair<SurfaceSet*, int>, Surface*>::iterator composed = _unitPoses.find(poseKey);
+				if (composed == _unitPoses.end())
+				{
+					Surface *surface = new Surface(_spriteWidth, _spriteHeight);
+					surface->setMemoryTag(MEM_MAPCACHE);
+					surface->setPalette(this->getPalette());
+					unitSprite->setSurfaces(unitSet, _handobSet);
+					unitSprite->draw();
+					surface->copy(unitSprite);
+					composed = _unitPoses.insert(std::make_pair(poseKey, surface)).first;
+				}
+				Surface *surface = new Surface(_spriteWidth, _spriteHeight);
+				surface->setMemoryTag(MEM_MAPCACHE);
+				surface->setPalette(this->getPalette());
+				composed->second->blitRemapped(surface, Surface::getShadeTable(shade));
+				surface->encodeRle();
+				frame = _unitFrames.insert(std::make_pair(key, surface)).first;
+			}
+			_unitCache.at((*i)->getId()) = frame->second;
 			(*i)->setCached(true);
 		}
 	}
-	delete unitSprite;
+}
+
+/**
+ * Throws away the unit frames and composed poses,
+ * so every unit is drawn again the next time they're cached.
+ */
+void Map::releaseUnitFrames()
+{
+	for (std::map<std::pair<SurfaceSet*, int>, Surface*>::iterator i = _unitFrames.begin(); i != _unitFrames.end(); i++)
+	{
+		delete i->second;
+	}
+	_unitFrames.clear();
+	for (std::map<std::pair<SurfaceSet*, int>, Surface*>::iterator i = _unitPoses.begin(); i != _unitPoses.end(); i++)
+	{
+		delete i->second;
+	}
+	_unitPoses.clear();
+	_unitCache.assign(_unitCache.size(), 0);
+	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
+	{
+		(*i)->setCached(false);
+	}
 }
 
 /**
@@ -21,6 +21,8 @@
 
 #include "../Engine/InteractiveSurface.h"
 #include <set>
+#include <map>
+#include <vector>
 
 namespace OpenXcom
 {
@@ -29,6 +31,7 @@ class ResourcePack;
 class SavedBattleGame;
 class Timer;
 class Surface;
+class SurfaceSet;
 class MapData;
 class Position;
 class Tile;
@@ -36,9 +39,29 @@ class BattleUnit;
 class BulletSprite;
 class Projectile;
 class Explosion;
+class UnitSprite;
 
 // below Y 140 the buttons area starts
 #define BUTTONS_AREA 140
+// above this many separate dirty areas the map redraws their bounding box in one go
+#define MAX_DIRTY_RECTS 16
+// width and height of the surfaces shaded tile sprites are packed into
+#define ATLAS_PAGE_SIZE 512
+// pages of the atlas and unit frames kept before they're all thrown away and made again (0 for no limit)
+#ifdef DINGOO
+#define MAX_ATLAS_PAGES 4
+#define MAX_UNIT_FRAMES 64
+#else
+#define MAX_ATLAS_PAGES 0
+#define MAX_UNIT_FRAMES 0
+#endif
+// floor, west wall, north wall, object and item
+#define TILE_PIECES 5
+// floor, then walls, objects and units, then smoke and fire: the cursor is drawn in between
+#define TILE_STAGES 3
+// parts of the cursor shown over the map, and what hides them
+#define SELECTOR_BACK 1
+#define SELECTOR_FRONT 2
 
 enum CursorType { CT_NONE, CT_NORMAL, CT_AIM, CT_PSI, CT_WAYPOINT, CT_THROW };
 
@@ -50,13 +73,25 @@ class Map : public InteractiveSurface
 private:
 	SavedBattleGame *_save;
 	ResourcePack *_res;
+	SurfaceSet *_cursorSet, *_smokeSet, *_floorobSet, *_handobSet;
 	Timer *_scrollTimer;
 	Surface *_arrow;
 	Game *_game;
-	Surface **_tileFloorCache;
-	Surface **_tileWallsCache;
+	/// Part of a shaded sprite in the atlas, and where it goes within a tile.
+	struct SpritePiece
+	{
+		Surface *page;
+		SDL_Rect crop;
+		int x, y;
+	};
+	std::vector<Surface*> _atlasPages;
+	std::map<std::pair<Surface*, int>, SpritePiece> _atlas;
+	SpritePiece *_tilePieces;
 	int _tileCount;
+	unsigned int _atlasFloor;
 	std::vector<Surface *> _unitCache;
+	std::map<std::pair<SurfaceSet*, int>, Surface*> _unitFrames, _unitPoses;
+	UnitSprite *_unitSprite;
 	int _mapOffsetX, _mapOffsetY, _viewHeight;
 	int _bufOffsetX, _bufOffsetY;
 	int _RMBClickX, _RMBClickY;
@@ -72,11 +107,41 @@ private:
 	BulletSprite *_bulletShadow[36];
 	Projectile *_projectile;
 	std::set<Explosion *> _explosions;
-
+	std::vector<Surface*> _levels;
+	std::vector<std::vector<Uint16> > _tileIds;
+	std::vector<std::vector<SDL_Rect> > _dirtyRects;
+	std::vector<bool> _staleLevels;
+	std::vector<SDL_Rect> _unitRects, _effectRects;
+	std::vector<int> _unitLevels;
+	bool _recomposite;
+	Surface *_maskSurface;
+	std::vector<Uint8> _selectorMask;
+	bool _selectorMaskValid;
 
 	void minMaxInt(int *value, const int minValue, const int maxValue);
 	bool cacheTileSprites(int i);
+	const SpritePiece &getAtlasSprite(Surface *sprite, int shade);
+	void releaseAtlas();
+	void releaseUnitFrames();
+	void setTilePiece(SpritePiece *piece, Surface *sprite, int shade, int x, int y, int srcX, int width);
+	void drawPiece(const SpritePiece &piece, const Position &screenPos, Surface *surface, Uint16 *ids = 0, int id = 0);
+	void markTileIds(Surface *sprite, const SDL_Rect *crop, int x, int y, Surface *surface, Uint16 *ids, int id);
 	void convertScreenToMap(int screenX, int screenY, int *mapX, int *mapY);
+	void markDirty(const SDL_Rect &rect, int level = -1);
+	void markTileDirty(const Position &mapPos);
+	void markUnitDirty(const SDL_Rect &rect, int level);
+	SDL_Rect getUnitRect(BattleUnit *unit);
+	void markMovingDirty();
+	void mergeDirtyRects(const std::vector<SDL_Rect> &dirty, std::vector<SDL_Rect> *rects);
+	void drawLevels();
+	bool overlapsSelector(const SDL_Rect &rect);
+	void updateSelectorMask();
+	void drawMasked(Surface *frame, const Position &screenPos, const Uint8 *mask, Uint8 part);
+	void drawOverlay();
+	static void shiftSurface(Surface *surface, int dx, int dy);
+	static void shiftTileIds(std::vector<Uint16> *ids, int width, int dx, int dy);
+	void shiftBuffers(int dx, int dy);
+	void changeViewHeight(int viewheight);
 public:
 	/// Creates a new map at the specified position and size.
 	Map(int width, int height, int x, int y);
@@ -92,8 +157,8 @@ public:
 	void think();
 	/// draw the surface
 	void draw(bool forceRedraw);
-	/// draws the terrain
-	void drawTerrain(Surface *surface);
+	/// draws one level of the terrain
+	void drawTerrain(Surface *surface, int level, const SDL_Rect *clip = 0, int from = 0, Uint16 *ids = 0);
 	/// Special handling for mouse clicks.
 	void mouseClick(Action *action, State *state);
 	/// Special handling for mous over
@@ -110,6 +175,8 @@ public:
 	void down();
 	/// set view height
 	void setViewHeight(int viewheight);
+	/// get view height
+	int getViewHeight() const;
 	/// Center map on a unit.
 	void centerOnPosition(const Position &pos);
 	/// Converts map coordinates to screen coordinates.
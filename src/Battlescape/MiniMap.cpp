@@ -0,0 +1,189 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MiniMap.h"
+#include "../Engine/SurfaceSet.h"
+#include "../Engine/Palette.h"
+#include "../Engine/Profiler.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/Tile.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Ruleset/MapData.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Sets up a minimap of a battle.
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @param x X position in pixels.
+ * @param y Y position in pixels.
+ * @param save Pointer to the battle game.
+ * @param set Pointer to the minimap sprites (SCANG.DAT).
+ */
+MiniMap::MiniMap(int width, int height, int x, int y, SavedBattleGame *save, SurfaceSet *set) : InteractiveSurface(width, height, x, y), _save(save), _set(set), _levels(), _center(0, 0, 0)
+{
+}
+
+/**
+ * Deletes the pre-rendered levels.
+ */
+MiniMap::~MiniMap()
+{
+	for (std::vector<Surface*>::iterator i = _levels.begin(); i != _levels.end(); i++)
+	{
+		delete *i;
+	}
+}
+
+/**
+ * Draws the block of a tile on its level: the blocks of its floor,
+ * walls and object on top of each other, or nothing if it wasn't discovered yet.
+ * @param index Tile index.
+ */
+void MiniMap::drawBlock(int index)
+{
+	Tile *tile = _save->getTiles()[index];
+	const Position &pos = tile->getPosition();
+	Surface *level = _levels[pos.z];
+
+	SDL_Rect rect;
+	rect.x = pos.x * MINIMAP_BLOCK_SIZE;
+	rect.y = pos.y * MINIMAP_BLOCK_SIZE;
+	rect.w = MINIMAP_BLOCK_SIZE;
+	rect.h = MINIMAP_BLOCK_SIZE;
+	level->drawRect(&rect, 0);
+
+	if (!tile->isDiscovered())
+		return;
+
+	for (int part = 0; part < 4; part++)
+	{
+		MapData *data = tile->getMapData(part);
+		if (data == 0 || data->getMiniMapIndex() == 0 || data->getMiniMapIndex() + MINIMAP_FIRST_BLOCK >= _set->getTotalFrames())
+			continue;
+		Surface *frame = _set->getFrame(data->getMiniMapIndex() + MINIMAP_FIRST_BLOCK);
+		frame->setX(rect.x);
+		frame->setY(rect.y);
+		frame->blit(level);
+	}
+}
+
+/**
+ * Brings the pre-rendered levels up to date. The first time every tile is drawn,
+ * after that only the tiles whose objects changed or that got discovered since.
+ */
+void MiniMap::update()
+{
+	std::vector<int> *changed = _save->getMiniMapTiles();
+	if (_levels.empty())
+	{
+		for (int z = 0; z < _save->getHeight(); z++)
+		{
+			Surface *level = new Surface(_save->getWidth() * MINIMAP_BLOCK_SIZE, _save->getLength() * MINIMAP_BLOCK_SIZE);
+			level->setMemoryTag(MEM_MAPCACHE);
+			level->setPalette(getPalette());
+			_levels.push_back(level);
+		}
+		for (int i = 0; i < _save->getHeight() * _save->getLength() * _save->getWidth(); i++)
+		{
+			drawBlock(i);
+		}
+	}
+	else
+	{
+		for (std::vector<int>::iterator i = changed->begin(); i != changed->end(); i++)
+		{
+			drawBlock(*i);
+		}
+	}
+	for (std::vector<int>::iterator i = changed->begin(); i != changed->end(); i++)
+	{
+		_save->setTileFlag(LAYER_MINIMAP, *i, false);
+	}
+	changed->clear();
+}
+
+/**
+ * Draws the level the minimap is centered on, with
+ * the player's units and the enemies they see on top.
+ */
+void MiniMap::draw()
+{
+	update();
+	clear();
+
+	int offsetX = getWidth() / 2 - _center.x * MINIMAP_BLOCK_SIZE - MINIMAP_BLOCK_SIZE / 2;
+	int offsetY = getHeight() / 2 - _center.y * MINIMAP_BLOCK_SIZE - MINIMAP_BLOCK_SIZE / 2;
+	Surface *level = _levels[_center.z];
+	level->setX(offsetX);
+	level->setY(offsetY);
+	level->blit(this);
+
+	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
+	{
+		const Position &pos = (*i)->getPosition();
+		if ((*i)->isOut() || pos.z != _center.z)
+			continue;
+		bool player = (*i)->getFaction() == FACTION_PLAYER;
+		if (!player && !_save->isTileVisible(FACTION_PLAYER, _save->getTileIndex(pos)))
+			continue;
+		SDL_Rect rect;
+		rect.x = offsetX + pos.x * MINIMAP_BLOCK_SIZE + 1;
+		rect.y = offsetY + pos.y * MINIMAP_BLOCK_SIZE + 1;
+		rect.w = MINIMAP_BLOCK_SIZE - 2;
+		rect.h = MINIMAP_BLOCK_SIZE - 2;
+		drawRect(&rect, player ? Palette::blockOffset(4) : Palette::blockOffset(2));
+	}
+}
+
+/**
+ * Centers the minimap on a position, and shows its level.
+ * @param pos Tile position.
+ */
+void MiniMap::centerOnPosition(const Position &pos)
+{
+	_center = pos;
+	draw();
+}
+
+/**
+ * Shows another level, centered on the same spot.
+ * @param level Map level.
+ */
+void MiniMap::setLevel(int level)
+{
+	_center.z = level;
+	draw();
+}
+
+/**
+ * Gets the tile position shown at a point of the minimap, on the level it shows.
+ * @param x X position in pixels, relative to the minimap.
+ * @param y Y position in pixels, relative to the minimap.
+ * @return Tile position.
+ */
+Position MiniMap::getPosition(int x, int y) const
+{
+	int offsetX = getWidth() / 2 - _center.x * MINIMAP_BLOCK_SIZE - MINIMAP_BLOCK_SIZE / 2;
+	int offsetY = getHeight() / 2 - _center.y * MINIMAP_BLOCK_SIZE - MINIMAP_BLOCK_SIZE / 2;
+	return Position((x - offsetX) / MINIMAP_BLOCK_SIZE, (y - offsetY) / MINIMAP_BLOCK_SIZE, _center.z);
+}
+
+}
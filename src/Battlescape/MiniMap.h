@@ -0,0 +1,69 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_MINIMAP_H
+#define OPENXCOM_MINIMAP_H
+
+#include "../Engine/InteractiveSurface.h"
+#include "Position.h"
+#include <vector>
+
+#define MINIMAP_BLOCK_SIZE 4
+#define MINIMAP_FIRST_BLOCK 35
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class SurfaceSet;
+
+/**
+ * Overview of the whole battlefield, one level at a time, with a block of
+ * pixels for every tile that was discovered. The blocks of every level are
+ * kept pre-rendered, and only the ones of tiles that changed or got discovered
+ * are drawn again, so showing the minimap is mostly a blit.
+ */
+class MiniMap : public InteractiveSurface
+{
+private:
+	SavedBattleGame *_save;
+	SurfaceSet *_set;
+	std::vector<Surface*> _levels;
+	Position _center;
+	/// Draws the block of a tile on its level.
+	void drawBlock(int index);
+public:
+	/// Creates a new minimap.
+	MiniMap(int width, int height, int x, int y, SavedBattleGame *save, SurfaceSet *set);
+	/// Cleans up the minimap.
+	~MiniMap();
+	/// Draws the blocks of the tiles that changed.
+	void update();
+	/// Draws the minimap.
+	void draw();
+	/// Centers the minimap on a position.
+	void centerOnPosition(const Position &pos);
+	/// Shows another level.
+	void setLevel(int level);
+	/// Gets the position shown at a point of the minimap.
+	Position getPosition(int x, int y) const;
+};
+
+}
+
+#endif
@@ -16,33 +16,84 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
-#include <list>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <new>
 #include "Pathfinding.h"
 #include "PathfindingNode.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
 #include "../Ruleset/MapData.h"
+#include "../Ruleset/MapDataSet.h"
 #include "../Savegame/BattleUnit.h"
+#include "../Savegame/Unit.h"
+#include "../Ruleset/RuleArmor.h"
+#include "../Engine/Profiler.h"
+#include "../Engine/JobPool.h"
 
 namespace OpenXcom
 {
 
+#define STEP_KNOWN 1
+#define STEP_FALL 2
+#define NODE_ALIGNMENT 64
+
+/**
+ * Part of a batch of path queries, calculated by one worker thread.
+ */
+struct BatchPart
+{
+	Pathfinding *pathfinding;
+	std::vector<PathRequest> *requests;
+	int first, step;
+};
+
+/**
+ * Calculates every step'th path of a batch, starting at the first one.
+ * @param data pointer to the BatchPart.
+ * @return 0
+ */
+static int calculateBatchPart(void *data)
+{
+	BatchPart *part = (BatchPart*)data;
+	for (int i = part->first; i < (int)part->requests->size(); i += part->step)
+	{
+		PathRequest *request = &part->requests->at(i);
+		part->pathfinding->abortPath();
+		part->pathfinding->calculate(request->unit, request->target);
+		part->pathfinding->getPath(&request->path);
+	}
+	return 0;
+}
+
 /**
  * Sets up a Pathfinding.
  * @param save pointer to SavedBattleGame object.
  */
-Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _nodes()
+Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _nodes(0), _nodeBuffer(0), _movementType(MT_WALK), _generation(0), _stepCosts(_ownStepCosts), _ignoreUnits(false), _reachable(), _reachablePrev(), _reachableDirs(), _reachableUnit(0), _reachablePos(), _reachableTUs(-1)
 {
 	_size = _save->getHeight() * _save->getLength() * _save->getWidth();
-	/* allocate the array and the objects in it */
-	_nodes = new PathfindingNode*[_size];
-	int x, y, z;
-	for (int i = 0; i < _size; i++)
+	for (int type = 0; type < 3; type++)
 	{
-		_save->getTileCoords(i, &x, &y, &z);
-		_nodes[i] = new PathfindingNode(Position(x, y, z));
+		_minTUCost[type] = -1;
 	}
+	allocateNodes();
+}
 
+/**
+ * Sets up a Pathfinding for a worker thread. It has its own nodes, but uses the step costs of the other Pathfinding,
+ * which have to be calculated already, so the workers only read them.
+ * @param shared Pathfinding to share the cost graph with.
+ */
+Pathfinding::Pathfinding(Pathfinding *shared) : _save(shared->_save), _nodes(0), _nodeBuffer(0), _size(shared->_size), _movementType(MT_WALK), _generation(0), _stepCosts(shared->_stepCosts), _ignoreUnits(false), _reachable(), _reachablePrev(), _reachableDirs(), _reachableUnit(0), _reachablePos(), _reachableTUs(-1)
+{
+	for (int type = 0; type < 3; type++)
+	{
+		_minTUCost[type] = shared->_minTUCost[type];
+	}
+	allocateNodes();
 }
 
 /**
@@ -52,12 +103,27 @@ Pathfinding::~Pathfinding()
 {
 	for (int i = 0; i < _size; i++)
 	{
-		delete _nodes[i];
+		_nodes[i].~PathfindingNode();
 	}
-	delete[] _nodes;
+	delete[] _nodeBuffer;
+	Profiler::addMemory(MEM_PATHFINDING, -(long)(_size * sizeof(PathfindingNode) + NODE_ALIGNMENT - 1));
 
 }
 
+/**
+ * Allocates all nodes in one block, aligned to a cache line, in tile index order.
+ */
+void Pathfinding::allocateNodes()
+{
+	_nodeBuffer = new char[_size * sizeof(PathfindingNode) + NODE_ALIGNMENT - 1];
+	Profiler::addMemory(MEM_PATHFINDING, _size * sizeof(PathfindingNode) + NODE_ALIGNMENT - 1);
+	_nodes = (PathfindingNode*)(((size_t)_nodeBuffer + NODE_ALIGNMENT - 1) & ~(size_t)(NODE_ALIGNMENT - 1));
+	for (int i = 0; i < _size; i++)
+	{
+		new (&_nodes[i]) PathfindingNode();
+	}
+}
+
 /** 
  * Gets the Node on a given position on the map.
  * @param pos position
@@ -65,22 +131,23 @@ Pathfinding::~Pathfinding()
  */
 PathfindingNode *Pathfinding::getNode(const Position& pos)
 {
-	return _nodes[_save->getTileIndex(pos)];
+	return &_nodes[_save->getTileIndex(pos)];
 }
 
 /**
- * Calculate the shortest path using a simple A-Star algorithm.
+ * Calculate the shortest path using the A-Star algorithm.
+ * The open list is a binary heap ordered by the TU cost so far plus the lowest possible TU cost to the destination.
  * @param unit
  * @param endPosition
  */
-
 void Pathfinding::calculate(BattleUnit *unit, Position &endPosition)
 {
-	std::list<PathfindingNode*> openList;
+	ProfileMarker marker(PROF_PATHFINDING);
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >, std::greater<std::pair<int, int> > > openList;
 	Position currentPos, nextPos, startPosition = unit->getPosition();
-	int tuCost;
+	int tuCost, x, y, z;
 
-	_movementType = MT_WALK; // should be parameter
+	_movementType = getMovementType(unit);
 	_unit = unit;
 
 	Tile *destinationTile = _save->getTile(endPosition);
@@ -106,68 +173,318 @@ void Pathfinding::calculate(BattleUnit *unit, Position &endPosition)
 
 	_path.clear();
 
-	// reset every node, so we have to check them all
-	for (int i = 0; i < _size; i++)
-		_nodes[i]->reset();
+	// nodes checked by an earlier search have an older generation, so we don't have to reset them
+	_generation++;
+
+	PathfindingNode *goal = getNode(endPosition);
 
 	// start position is the first one in our "open" list
-    openList.push_back(getNode(startPosition));
-    openList.front()->check(0, 0, 0, 0);
+	getNode(startPosition)->check(0, 0, -1, 0, _generation);
+	openList.push(std::make_pair(estimateTUCost(startPosition, endPosition), _save->getTileIndex(startPosition)));
 
 	// if the open list is empty, we've reached the end
-    while(!openList.empty())
+	while (!openList.empty())
 	{
-		// this algorithm expands in all directions
-        for (int direction = 0; direction < 8; direction++)
+		int index = openList.top().second;
+		int estimate = openList.top().first;
+		PathfindingNode *current = &_nodes[index];
+		openList.pop();
+		_save->getTileCoords(index, &x, &y, &z);
+		currentPos = Position(x, y, z);
+
+		// this node was reached cheaper after it was put in the list, it's already been expanded
+		if (estimate > current->getTUCost() + estimateTUCost(currentPos, endPosition))
+			continue;
+
+		// the estimate never overrates the cost, so the first time we take the goal from the list it is the cheapest way
+		if (current == goal)
+			break;
+
+		for (int direction = 0; direction < getDirections(); direction++)
 		{
-			currentPos = openList.front()->getPosition();
-            tuCost = getTUCost(currentPos, direction, &nextPos, unit);
-            if(tuCost < 255)
+			tuCost = getTUCost(currentPos, direction, &nextPos, unit);
+			if (tuCost < 255)
 			{
-				if( (!getNode(nextPos)->isChecked() ||
-                getNode(nextPos)->getTUCost() > getNode(currentPos)->getTUCost() + tuCost) &&
-                (!getNode(endPosition)->isChecked() ||
-                getNode(endPosition)->getTUCost() > getNode(currentPos)->getTUCost() + tuCost)
-                )
+				PathfindingNode *next = getNode(nextPos);
+				int cost = current->getTUCost() + tuCost;
+				if (!next->isChecked(_generation) || next->getTUCost() > cost)
 				{
-					getNode(nextPos)->check(getNode(currentPos)->getTUCost() + tuCost, 
-											getNode(currentPos)->getStepsNum() + 1,
-											getNode(currentPos),
-											direction);
-					openList.push_back(getNode(nextPos));
-                }
-            }
-        }
-		openList.pop_front();
-    }
-
-    if(!getNode(endPosition)->isChecked()) return;
-
-    //Backward tracking of the path
-    PathfindingNode* pf = getNode(endPosition);
-    for (int i = getNode(endPosition)->getStepsNum(); i > 0; i--)
+					next->check(cost, current->getStepsNum() + 1, index, direction, _generation);
+					openList.push(std::make_pair(cost + estimateTUCost(nextPos, endPosition), _save->getTileIndex(nextPos)));
+				}
+			}
+		}
+	}
+
+	if(!goal->isChecked(_generation)) return;
+
+	//Backward tracking of the path
+	PathfindingNode* pf = goal;
+	for (int i = goal->getStepsNum(); i > 0; i--)
 	{
 		_path.push_back(pf->getPrevDir());
-        pf=pf->getPrevNode();
-    }
+		pf = &_nodes[pf->getPrevIndex()];
+	}
 
 }
 
 /**
- * Get's the TU cost to move from 1 tile to the other(ONE STEP ONLY). But also updates the endPosition, because it is possible
- * the unit goes upstairs or falls down while walking.
+ * Calculate the shortest paths of several units against the same map. The units on the map must not move meanwhile,
+ * because they block each other's paths. The paths can be calculated in parallel: every worker thread gets its own nodes,
+ * and they all share the step costs, which are calculated for the whole map first.
+ * The current path of this Pathfinding is kept.
+ * @param requests the units and their targets, the paths are stored in them.
+ * @param threads number of worker threads, 1 calculates the paths in this thread.
+ */
+void Pathfinding::calculate(std::vector<PathRequest> *requests, int threads)
+{
+	ProfileMarker marker(PROF_PATHFINDING);
+	threads = std::max(1, std::min(threads, (int)requests->size()));
+	std::vector<int> path = _path;
+
+	if (threads == 1)
+	{
+		BatchPart part = { this, requests, 0, 1 };
+		calculateBatchPart(&part);
+		_path = path;
+		return;
+	}
+
+	// the workers only read the step costs, so they're calculated for every way of moving in the batch first
+	bool built[3] = {false, false, false};
+	for (std::vector<PathRequest>::iterator i = requests->begin(); i != requests->end(); i++)
+	{
+		_movementType = getMovementType(i->unit);
+		if (!built[_movementType])
+		{
+			buildStepCosts();
+			built[_movementType] = true;
+		}
+	}
+
+	std::vector<Pathfinding*> workers;
+	std::vector<BatchPart> parts;
+	for (int i = 0; i < threads; i++)
+	{
+		workers.push_back(i == 0 ? this : new Pathfinding(this));
+		BatchPart part = { workers.back(), requests, i, threads };
+		parts.push_back(part);
+	}
+	// the first part is done by this thread
+	JobGroup group;
+	for (int i = 1; i < threads; i++)
+	{
+		JobPool::run(&group, calculateBatchPart, &parts[i]);
+	}
+	calculateBatchPart(&parts[0]);
+	JobPool::wait(&group);
+	for (int i = 1; i < threads; i++)
+	{
+		delete workers[i];
+	}
+	_path = path;
+}
+
+/**
+ * Set the path to follow, for example one that was calculated in a batch.
+ * @param path directions, the last one is the first step.
+ */
+void Pathfinding::setPath(const std::vector<int> &path)
+{
+	_path = path;
+}
+
+/**
+ * Gets the current path.
+ * @param path vector to copy the directions to, the last one is the first step.
+ */
+void Pathfinding::getPath(std::vector<int> *path) const
+{
+	*path = _path;
+}
+
+/**
+ * Gets the TU cost to reach every tile of the map with the unit's remaining TUs, using one Dijkstra search from the unit.
+ * The result is kept until the unit moves, its TUs change or the map changes (terrain or units moving).
+ * @param unit
+ * @return TU cost for every tile index - 255 if the tile can't be reached
+ */
+const std::vector<Uint8> &Pathfinding::getReachable(BattleUnit *unit)
+{
+	int maxTUs = std::min(unit->getTimeUnits(), 254);
+	if (unit == _reachableUnit && unit->getPosition() == _reachablePos && maxTUs == _reachableTUs)
+		return _reachable;
+
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >, std::greater<std::pair<int, int> > > openList;
+	Position nextPos, startPosition = unit->getPosition();
+	int x, y, z;
+
+	_movementType = getMovementType(unit);
+	_unit = unit;
+	_reachableUnit = unit;
+	_reachablePos = startPosition;
+	_reachableTUs = maxTUs;
+	_reachable.assign(_size, 255);
+	_reachablePrev.assign(_size, -1);
+	_reachableDirs.assign(_size, -1);
+
+	_generation++;
+
+	getNode(startPosition)->check(0, 0, -1, 0, _generation);
+	openList.push(std::make_pair(0, _save->getTileIndex(startPosition)));
+
+	while (!openList.empty())
+	{
+		int cost = openList.top().first;
+		int index = openList.top().second;
+		PathfindingNode *current = &_nodes[index];
+		openList.pop();
+
+		// this node was reached cheaper after it was put in the list
+		if (cost > current->getTUCost())
+			continue;
+
+		_reachable[index] = cost;
+		// keep the way here, the nodes get reused by other searches
+		_reachablePrev[index] = current->getPrevIndex();
+		_reachableDirs[index] = current->getPrevDir();
+		_save->getTileCoords(index, &x, &y, &z);
+		Position currentPos(x, y, z);
+
+		for (int direction = 0; direction < getDirections(); direction++)
+		{
+			int tuCost = getTUCost(currentPos, direction, &nextPos, unit);
+			if (tuCost < 255 && cost + tuCost <= maxTUs)
+			{
+				PathfindingNode *next = getNode(nextPos);
+				if (!next->isChecked(_generation) || next->getTUCost() > cost + tuCost)
+				{
+					next->check(cost + tuCost, current->getStepsNum() + 1, index, direction, _generation);
+					openList.push(std::make_pair(cost + tuCost, _save->getTileIndex(nextPos)));
+				}
+			}
+		}
+	}
+
+	return _reachable;
+}
+
+/**
+ * Gets the path to a tile the unit can reach with its remaining TUs, by following the search tree of getReachable back
+ * from the tile, so nothing has to be searched while the tree is still valid. Good for previewing moves under the cursor.
+ * @param unit
+ * @param target
+ * @param path directions, the last one is the first step, empty if the tile can't be reached.
+ * @return TU cost to reach the tile - 255 if it can't be reached
+ */
+int Pathfinding::getReachablePath(BattleUnit *unit, const Position &target, std::vector<int> *path)
+{
+	path->clear();
+	if (_save->getTile(target) == 0)
+		return 255;
+
+	getReachable(unit);
+	int index = _save->getTileIndex(target);
+	if (_reachable[index] == 255)
+		return 255;
+
+	for (int i = index; _reachablePrev[i] != -1; i = _reachablePrev[i])
+	{
+		path->push_back(_reachableDirs[i]);
+	}
+	return _reachable[index];
+}
+
+/**
+ * Forget the cached reachable tiles, because something on the map changed.
+ */
+void Pathfinding::invalidateReachable()
+{
+	_reachableUnit = 0;
+}
+
+/**
+ * Gets the lowest TU cost a single straight step can have on this map for the current movement type. This is the lowest
+ * cost of all terrain objects, or zero if a unit could fall onto a ground tile without floor.
+ * Flying units don't fall, but flying through the air costs FLY_STEP_COST, so that's the most it can be for them.
+ * The terrain objects don't change during a battle and ground tiles don't lose their floor, so this is calculated only once.
+ * @return TU cost
+ */
+int Pathfinding::getMinTUCost()
+{
+	int *minTUCost = &_minTUCost[_movementType];
+	if (*minTUCost != -1)
+		return *minTUCost;
+
+	*minTUCost = 255;
+	for (std::vector<MapDataSet*>::iterator i = _save->getMapDataSets()->begin(); i != _save->getMapDataSets()->end(); i++)
+	{
+		for (std::vector<MapData*>::iterator j = (*i)->getObjects()->begin(); j != (*i)->getObjects()->end(); j++)
+		{
+			*minTUCost = std::min(*minTUCost, (*j)->getTUCost(_movementType));
+		}
+	}
+	*minTUCost = std::min(*minTUCost, MapDataSet::getScourgedEarthTile()->getTUCost(_movementType));
+
+	if (_movementType == MT_FLY)
+	{
+		*minTUCost = std::min(*minTUCost, FLY_STEP_COST);
+		return *minTUCost;
+	}
+
+	for (int x = 0; x < _save->getWidth() && *minTUCost > 0; x++)
+	{
+		for (int y = 0; y < _save->getLength() && *minTUCost > 0; y++)
+		{
+			if (_save->getTile(Position(x, y, 0))->getMapData(O_FLOOR) == 0)
+			{
+				*minTUCost = 0;
+			}
+		}
+	}
+
+	return *minTUCost;
+}
+
+/**
+ * Gets the lowest possible TU cost to go from one position to another (octile distance).
+ * Level changes are free for walking units, because they can take stairs or fall down. Flying units don't fall,
+ * so every step changes the level by one at most, either flying up or down or taking stairs on the way.
+ * @param startPosition
+ * @param endPosition
+ * @return TU cost
+ */
+int Pathfinding::estimateTUCost(const Position &startPosition, const Position &endPosition)
+{
+	int dx = abs(endPosition.x - startPosition.x);
+	int dy = abs(endPosition.y - startPosition.y);
+	int straight = getMinTUCost();
+	// diagonal steps cost 50% more, unless two straight steps are cheaper
+	int diagonal = std::min((int)((double)straight * 1.5), straight * 2);
+	int horizontal = std::min(dx, dy) * diagonal + abs(dx - dy) * straight;
+	if (_movementType != MT_FLY)
+		return horizontal;
+
+	// stairs change the level on a horizontal step, so the levels can't be added to the distance
+	int levels = abs(endPosition.z - startPosition.z);
+	return std::max(horizontal, levels * std::min(straight, FLY_LEVEL_COST));
+}
+
+/**
+ * Calculates the TU cost to move from 1 tile to the other(ONE STEP ONLY). But also updates the endPosition, because it is possible
+ * the unit goes upstairs or falls down while walking. Units are taken into account, unless _ignoreUnits is set.
  * @param startPosition
  * @param direction
  * @param endPosition pointer
- * @param unit
+ * @param fell pointer, set to whether the unit falls down (can be null)
  * @return TU cost - 255 if movement impossible
  */
-int Pathfinding::getTUCost(const Position &startPosition, int direction, Position *endPosition, BattleUnit *unit)
+int Pathfinding::calculateTUCost(const Position &startPosition, const int direction, Position *endPosition, bool *fell)
 {
-	_unit = unit;
 	directionToVector(direction, endPosition);
 	*endPosition += startPosition;
 	bool fellDown = false;
+	if (fell) *fell = false;
 
 	Tile *startTile = _save->getTile(startPosition);
 	Tile *destinationTile = _save->getTile(*endPosition);
@@ -180,6 +497,16 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 	if (isBlocked(destinationTile, O_FLOOR) || isBlocked(destinationTile, O_OBJECT))
 		return 255;
 
+	// flying straight up goes through the floor of the tile above, down through the floor of this one
+	if (direction >= DIR_UP)
+	{
+		if (_movementType != MT_FLY)
+			return 255;
+		Tile *upperTile = direction == DIR_UP ? destinationTile : startTile;
+		if (!upperTile->hasNoFloor())
+			return 255;
+		return FLY_LEVEL_COST;
+	}
 
 	// check if we can go this way
 	if (isBlocked(startTile, destinationTile, direction))
@@ -203,9 +530,10 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 		destinationTile = _save->getTile(*endPosition);
 		fellDown = true;
 	}
+	if (fell) *fell = fellDown;
 
-	// if we don't want to fall down and there is no floor, it ends here
-	if (!fellDown && destinationTile->hasNoFloor())
+	// if we don't want to fall down and there is no floor, it ends here, unless we fly
+	if (!fellDown && destinationTile->hasNoFloor() && _movementType != MT_FLY)
 	{
 		return 255;
 	}
@@ -217,10 +545,17 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 	}
 
 	// calculate the cost by adding floor walk cost and object walk cost
-	int cost = destinationTile->getTUCost(O_FLOOR, _movementType);
+	int index = _save->getTileIndex(*endPosition);
+	int cost = _save->getTerrainTUCost(_save->getTileObject(index, O_FLOOR), _movementType);
 	if (!fellDown)
 	{
-		cost += destinationTile->getTUCost(O_OBJECT, _movementType);
+		cost += _save->getTerrainTUCost(_save->getTileObject(index, O_OBJECT), _movementType);
+	}
+
+	// flying through the air isn't free
+	if (_movementType == MT_FLY)
+	{
+		cost = std::max(cost, FLY_STEP_COST);
 	}
 	
 	// diagonal walking (uneven directions) costs 50% more tu's
@@ -229,21 +564,200 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 		cost = (int)((double)cost * 1.5);
 	}
 
-	return cost;
+	return std::min(cost, 255);
+}
+
+/**
+ * Calculates the terrain cost of every step on the map for the current movement type, so the cache is only read afterwards.
+ */
+void Pathfinding::buildStepCosts()
+{
+	int x, y, z;
+	for (int i = 0; i < _size; i++)
+	{
+		_save->getTileCoords(i, &x, &y, &z);
+		for (int direction = 0; direction < getDirections(); direction++)
+		{
+			getStepCost(Position(x, y, z), direction);
+		}
+	}
+	getMinTUCost();
+}
+
+/**
+ * Gets the way a unit moves, which depends on its armor.
+ * @param unit
+ * @return movement type
+ */
+MovementType Pathfinding::getMovementType(BattleUnit *unit)
+{
+	return unit->getUnit()->getArmor()->getMovementType();
+}
+
+/**
+ * Gets the number of directions a unit with the current movement type can step in.
+ * Flying units can also go straight up (DIR_UP) and down (DIR_DOWN).
+ * @return number of directions
+ */
+int Pathfinding::getDirections() const
+{
+	return _movementType == MT_FLY ? PATH_DIRECTIONS : 8;
+}
+
+/**
+ * Gets the terrain cost of one step from the cache, calculating it first when it's not known yet.
+ * @param startPosition
+ * @param direction
+ * @return reference to the cached step
+ */
+const Pathfinding::StepCost &Pathfinding::getStepCost(const Position &startPosition, const int direction)
+{
+	std::vector<StepCost> *costs = &_stepCosts[_movementType];
+	if (costs->empty())
+	{
+		StepCost unknown = { 255, 0, 0 };
+		costs->resize(_size * PATH_DIRECTIONS, unknown);
+	}
+
+	StepCost *step = &costs->at(_save->getTileIndex(startPosition) * PATH_DIRECTIONS + direction);
+	if (!(step->flags & STEP_KNOWN))
+	{
+		Position endPosition, vector;
+		bool fell;
+
+		_ignoreUnits = true;
+		step->cost = calculateTUCost(startPosition, direction, &endPosition, &fell);
+		_ignoreUnits = false;
+
+		// flying up or down changes the level already, only stairs and falling are counted here
+		directionToVector(direction, &vector);
+		step->levelChange = endPosition.z - startPosition.z - vector.z;
+		step->flags = STEP_KNOWN;
+		if (fell)
+		{
+			step->flags |= STEP_FALL;
+		}
+	}
+	return *step;
+}
+
+/**
+ * Get's the TU cost to move from 1 tile to the other(ONE STEP ONLY). But also updates the endPosition, because it is possible
+ * the unit goes upstairs or falls down while walking.
+ * The terrain part of the cost comes from the cache, only the units in the way are checked every time.
+ * @param startPosition
+ * @param direction
+ * @param endPosition pointer
+ * @param unit
+ * @return TU cost - 255 if movement impossible
+ */
+int Pathfinding::getTUCost(const Position &startPosition, int direction, Position *endPosition, BattleUnit *unit)
+{
+	_unit = unit;
+	_movementType = getMovementType(unit);
+
+	const StepCost &step = getStepCost(startPosition, direction);
+
+	directionToVector(direction, endPosition);
+	*endPosition += startPosition;
+
+	if (step.cost == 255)
+		return 255;
+
+	// a unit standing in the way
+	if (isBlocked(_save->getTile(*endPosition), O_FLOOR))
+		return 255;
+
+	if (step.flags & STEP_FALL)
+	{
+		// units below us stop us from falling, that's too complicated for the cache
+		for (int z = endPosition->z + step.levelChange; z <= endPosition->z; z++)
+		{
+			BattleUnit *below = _save->getTile(Position(endPosition->x, endPosition->y, z))->getUnit();
+			if (below && below != _unit)
+			{
+				return calculateTUCost(startPosition, direction, endPosition, 0);
+			}
+		}
+		endPosition->z += step.levelChange;
+		return step.cost;
+	}
+
+	endPosition->z += step.levelChange;
+
+	// a unit standing at the top of the stairs
+	if (step.levelChange && isBlocked(_save->getTile(*endPosition), O_FLOOR))
+		return 255;
+
+	return step.cost;
+}
+
+/**
+ * Forget the cached TU costs of all steps that could be affected by a changed tile. Steps check the walls of the
+ * tiles around them and can fall down any number of levels, so this is every step starting next to the tile, on all levels.
+ * @param position
+ */
+void Pathfinding::invalidateTUCosts(const Position &position)
+{
+	invalidateReachable();
+
+	for (int type = 0; type < 3; type++)
+	{
+		if (_stepCosts[type].empty())
+			continue;
+
+		for (int x = position.x - 1; x <= position.x + 1; x++)
+		{
+			for (int y = position.y - 1; y <= position.y + 1; y++)
+			{
+				for (int z = 0; z < _save->getHeight(); z++)
+				{
+					if (!_save->getTile(Position(x, y, z)))
+						continue;
+
+					int index = _save->getTileIndex(Position(x, y, z)) * PATH_DIRECTIONS;
+					for (int direction = 0; direction < PATH_DIRECTIONS; direction++)
+					{
+						_stepCosts[type][index + direction].flags = 0;
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Forget the cached results that depend on a changed tile: new objects can change the TU costs
+ * of the steps around them, and units block the way. Doors that open don't change any cost.
+ * @param change
+ */
+void Pathfinding::changeTerrain(const TerrainChange &change)
+{
+	if (change.type == CHANGE_OBJECT)
+	{
+		Position position;
+		_save->getTileCoords(change.index, &position.x, &position.y, &position.z);
+		invalidateTUCosts(position);
+	}
+	else if (change.type == CHANGE_UNIT)
+	{
+		invalidateReachable();
+	}
 }
 
 /*
- * Converts direction to a vector. Direction starts north = 0 and goes clockwise.
+ * Converts direction to a vector. Direction starts north = 0 and goes clockwise, then up (DIR_UP) and down (DIR_DOWN).
  * @param direction
  * @param vector pointer to a position (which acts as a vector)
  */
 void Pathfinding::directionToVector(const int direction, Position *vector)
 {
-	int x[8] = {0, 1, 1, 1, 0, -1, -1, -1};
-	int y[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+	int x[PATH_DIRECTIONS] = {0, 1, 1, 1, 0, -1, -1, -1, 0, 0};
+	int y[PATH_DIRECTIONS] = {1, 1, 0, -1, -1, -1, 0, 1, 0, 0};
+	int z[PATH_DIRECTIONS] = {0, 0, 0, 0, 0, 0, 0, 0, 1, -1};
 	vector->x = x[direction];
 	vector->y = y[direction];
-	vector->z = 0;
+	vector->z = z[direction];
 }
 
 /*
@@ -287,12 +801,13 @@ bool Pathfinding::isBlocked(Tile *tile, const int part)
 {
 	if (tile == 0) return true; // probably outside the map here
 
-	if (tile->getTUCost(part, _movementType) == 255) return true; // blocking part
+	int index = _save->getTileIndex(tile->getPosition());
+	if (_save->getTerrainTUCost(_save->getTileObject(index, part), _movementType) == 255) return true; // blocking part
 
 	BattleUnit *unit = tile->getUnit();
-	if (unit != 0 && unit != _unit && (part==0 || part==3)) return true;
+	if (!_ignoreUnits && unit != 0 && unit != _unit && (part==0 || part==3)) return true;
 
-	if (tile->isBigWall()) return true; // big walls block every part
+	if (_save->getTerrainFlags(_save->getTileObject(index, O_OBJECT)) & TERRAIN_BIG_WALL) return true; // big walls block every part
 
 	return false;
 }
@@ -359,18 +874,21 @@ bool Pathfinding::isBlocked(Tile *startTile, Tile *endTile, const int direction)
 
 /**
  * We can fall down here, if the tile does not exist, the tile has no floor
- * the current position is higher than 0, if there is no unit standing below us
+ * the current position is higher than 0, if there is no unit standing below us and we don't fly
  * @param here
  * @return bool
  */
 bool Pathfinding::canFallDown(Tile *here)
 {
-	if (here->getPosition().z == 0)
+	if (here->getPosition().z == 0 || _movementType == MT_FLY)
 		return false;
 
-	if (_save->selectUnit(here->getPosition() + Position(0, 0, -1)) &&
-		_save->selectUnit(here->getPosition() + Position(0, 0, -1)) != _unit)
-		return false;
+	if (!_ignoreUnits)
+	{
+		BattleUnit *below = _save->selectUnit(here->getPosition() + Position(0, 0, -1));
+		if (below && below != _unit)
+			return false;
+	}
 
 	if (!here || here->hasNoFloor())
 		return true;
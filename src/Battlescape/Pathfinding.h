@@ -22,6 +22,13 @@
 #include <vector>
 #include "Position.h"
 #include "../Ruleset/MapData.h"
+#include "SDL.h"
+
+#define DIR_UP 8
+#define DIR_DOWN 9
+#define PATH_DIRECTIONS 10
+#define FLY_STEP_COST 4
+#define FLY_LEVEL_COST 8
 
 namespace OpenXcom
 {
@@ -31,6 +38,17 @@ class SavedBattleGame;
 class PathfindingNode;
 class Tile;
 class BattleUnit;
+struct TerrainChange;
+
+/**
+ * A path to calculate for a unit, as part of a batch of path queries.
+ */
+struct PathRequest
+{
+	BattleUnit *unit;
+	Position target;
+	std::vector<int> path;
+};
 
 /**
  * A utility class that calculates the shortest path between two points on the battlescape map.
@@ -38,11 +56,32 @@ class BattleUnit;
 class Pathfinding
 {
 private:
+	/// Cached terrain cost of one step, without taking units into account.
+	struct StepCost
+	{
+		Uint8 cost;
+		Sint8 levelChange;
+		Uint8 flags;
+	};
 	SavedBattleGame *_save;
-	PathfindingNode **_nodes;
+	PathfindingNode *_nodes;
+	char *_nodeBuffer;
 	int _size;
 	std::vector<int> _path;
 	MovementType _movementType;
+	int _generation;
+	int _minTUCost[3];
+	std::vector<StepCost> _ownStepCosts[3];
+	std::vector<StepCost> *_stepCosts;
+	bool _ignoreUnits;
+	std::vector<Uint8> _reachable;
+	std::vector<int> _reachablePrev;
+	std::vector<Sint8> _reachableDirs;
+	BattleUnit *_reachableUnit;
+	Position _reachablePos;
+	int _reachableTUs;
+	/// Allocates the nodes of the map.
+	void allocateNodes();
 	/// Gets the node at certain position.
 	PathfindingNode *getNode(const Position& pos);
 	/// whether a tile blocks a certain movementType
@@ -50,6 +89,22 @@ private:
 	bool isBlocked(Tile *startTile, Tile *endTile, const int direction);
 	bool canFallDown(Tile *destinationTile);
 	bool isOnStairs(const Position &startPosition, const Position &endPosition);
+	/// Calculates the TU cost of one step, checking walls, stairs and falling.
+	int calculateTUCost(const Position &startPosition, const int direction, Position *endPosition, bool *fell);
+	/// Gets the cached terrain cost of one step.
+	const StepCost &getStepCost(const Position &startPosition, const int direction);
+	/// Calculates the terrain cost of every step on the map.
+	void buildStepCosts();
+	/// Gets the way a unit moves.
+	static MovementType getMovementType(BattleUnit *unit);
+	/// Gets the number of directions a unit can move in.
+	int getDirections() const;
+	/// Creates a Pathfinding for a worker thread, sharing the cost graph of another one.
+	Pathfinding(Pathfinding *shared);
+	/// Lowest possible TU cost of a single step.
+	int getMinTUCost();
+	/// Lowest possible TU cost between two positions.
+	int estimateTUCost(const Position &startPosition, const Position &endPosition);
 	BattleUnit *_unit;
 public:
 	/// Creates a new Pathfinding class
@@ -58,6 +113,12 @@ public:
 	~Pathfinding();
 	/// Calculate the shortest path.
 	void calculate(BattleUnit *unit, Position &endPosition);
+	/// Calculate the shortest paths of several units.
+	void calculate(std::vector<PathRequest> *requests, int threads = 1);
+	/// Set the path to follow.
+	void setPath(const std::vector<int> &path);
+	/// Get the current path.
+	void getPath(std::vector<int> *path) const;
 	/// Converts direction to a vector.
 	static void directionToVector(const int direction, Position *vector);
 	/// Check whether a path is ready gives the first direction.
@@ -68,6 +129,16 @@ public:
 	int getTUCost(const Position &startPosition, const int direction, Position *endPosition, BattleUnit *unit);
 	/// Abort the current path.
 	void abortPath();
+	/// Forget the cached TU costs of steps that could be affected by a changed tile.
+	void invalidateTUCosts(const Position &position);
+	/// Forget the cached results that depend on a changed tile.
+	void changeTerrain(const TerrainChange &change);
+	/// Get the TU cost to reach every tile with the unit's remaining TUs.
+	const std::vector<Uint8> &getReachable(BattleUnit *unit);
+	/// Get the path and TU cost to a tile the unit can reach, from the cached reachable tiles.
+	int getReachablePath(BattleUnit *unit, const Position &target, std::vector<int> *path);
+	/// Forget the cached reachable tiles.
+	void invalidateReachable();
 };
 
 }
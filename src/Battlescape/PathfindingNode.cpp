@@ -17,16 +17,14 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "PathfindingNode.h"
-#include "Position.h"
 
 namespace OpenXcom
 {
 
 /**
  * Sets up a PathfindingNode.
- * @param pos Position.
  */
-PathfindingNode::PathfindingNode(Position pos) : _pos(pos)
+PathfindingNode::PathfindingNode() : _generation(0), _tuCost(0), _prevIndex(-1), _stepsNum(0), _prevDir(-1)
 {
 
 }
@@ -39,80 +37,23 @@ PathfindingNode::~PathfindingNode()
 
 }
 
-/**
-* Get the node position
-* @return node position
-*/
-const Position &PathfindingNode::getPosition()
-{
-	return _pos;
-}
-/**
- * Reset node.
- */
-void PathfindingNode::reset()
-{
-	_checked = false;
-}
 /**
 * Check node. The pathfinding marks every node as checked, storing some additional info.
+* The node is only checked for the search with the same generation, so nodes don't need
+* to be reset before every search.
 * @param tuCost
 * @param stepsNum
-* @param prevNode
+* @param prevIndex tile index of the previous node
 * @param prevDir
+* @param generation
 */
-void PathfindingNode::check(int tuCost, int stepsNum, PathfindingNode* prevNode, int prevDir)
+void PathfindingNode::check(int tuCost, int stepsNum, int prevIndex, int prevDir, int generation)
 {
-	_checked = true;
+	_generation = generation;
 	_tuCost = tuCost;
 	_stepsNum = stepsNum;
-	_prevNode = prevNode;
+	_prevIndex = prevIndex;
 	_prevDir = prevDir;
 }
 
-/**
-* Is checked?
-* @return bool 
-*/
-bool PathfindingNode::isChecked()
-{
-	return _checked;
-}
-
-/** 
- * Get TU cost.
- * @return cost
- */
-int PathfindingNode::getTUCost()
-{
-	return _tuCost;
-}
-
-/**
- * Get steps num
- * @return steps num
- */
-int PathfindingNode::getStepsNum()
-{
-	return _stepsNum;
-}
-
-/**
- * Get previous node
- * @return pointer to previous node
- */
-PathfindingNode* PathfindingNode::getPrevNode()
-{
-	return _prevNode;
-}
-
-/**
- * Get previous walking direction how we got on this node.
- * @return previous vector
- */
-int PathfindingNode::getPrevDir()
-{
-	return _prevDir;
-}
-
 }
@@ -19,43 +19,40 @@
 #ifndef OPENXCOM_PATHFINDINGNODE_H
 #define OPENXCOM_PATHFINDINGNODE_H
 
-#include "Position.h"
+#include "SDL.h"
 
 namespace OpenXcom
 {
 
 /**
  * A class that holds pathfinding info for a certain node on the map.
+ * The nodes of a map are kept in one array in tile index order, so a node is 16 bytes and refers to other nodes by index.
  */
 class PathfindingNode
 {
 private:
-	Position _pos;
-	bool _checked;
-	int _tuCost, _stepsNum;
-	PathfindingNode* _prevNode;
-	int _prevDir;
+	int _generation;
+	int _tuCost;
+	int _prevIndex;
+	Uint16 _stepsNum;
+	Sint8 _prevDir;
 public:
 	/// Creates a new PathfindingNode class
-	PathfindingNode(Position pos);
+	PathfindingNode();
 	/// Cleans up the PathfindingNode.
 	~PathfindingNode();
-	/// Get the node position
-	const Position &getPosition();
-	/// Reset node.
-	void reset();
 	/// Check node.
-	void check(int tuCost, int stepsNum, PathfindingNode* prevNode, int prevDir);
-	/// is checked?
-	bool isChecked();
+	void check(int tuCost, int stepsNum, int prevIndex, int prevDir, int generation);
+	/// is checked in this search?
+	bool isChecked(int generation) const { return _generation == generation; }
 	/// get TU cost
-	int getTUCost();
+	int getTUCost() const { return _tuCost; }
 	/// get steps num
-	int getStepsNum();
-	/// get previous node
-	PathfindingNode* getPrevNode();
+	int getStepsNum() const { return _stepsNum; }
+	/// get tile index of the previous node
+	int getPrevIndex() const { return _prevIndex; }
 	/// get previous walking direction
-	int getPrevDir();
+	int getPrevDir() const { return _prevDir; }
 };
 
 }
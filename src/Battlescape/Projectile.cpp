@@ -61,7 +61,7 @@ const int Projectile::_trail[11][36] = {
  * @param target Projectile's target position in tile x/y/z.
  * @param bulletType A number that corresponds to the type of bullet this is.
  */
-Projectile::Projectile(ResourcePack *res, SavedBattleGame *save, Position origin, Position target, int bulletType) : _res(res), _save(save), _origin(origin), _target(target), _position(0), _bulletType(bulletType)
+Projectile::Projectile(ResourcePack *res, SavedBattleGame *save, Position origin, Position target, int bulletType) : _res(res), _save(save), _origin(origin), _target(target), _trajectory(), _position(0), _voxels(0), _length(0), _ended(false), _bulletType(bulletType)
 {
 
 }
@@ -140,8 +140,17 @@ bool Projectile::calculateTrajectory(double accuracy)
 	// This will results in a new target voxel
 	applyAccuracy(originVoxel, &targetVoxel, accuracy);
 
-	// finally do a line calculation and store this trajectory.
-	_save->getTerrainModifier()->calculateLine(originVoxel, targetVoxel, true, &_trajectory, bu);
+	// finally do a line calculation, to resolve where the shot lands right away.
+	// the flight follows the same line without checking the voxels again, so the
+	// result doesn't change with whatever happens on the map in the meantime.
+	VoxelLine line(_save->getTerrainModifier(), originVoxel, targetVoxel, bu);
+	_impact = originVoxel;
+	while (line.next(&_impact))
+	{
+		_length++;
+	}
+	_trajectory = VoxelLine(0, originVoxel, targetVoxel, 0);
+	reach(0);
 
 	return true;
 }
@@ -165,8 +174,8 @@ void Projectile::applyAccuracy(const Position& origin, Position *target, double
 	double rotation, tilt;
 	double baseDeviation = (maxDeviation - (maxDeviation * accuracy)) + minDeviation;
 	// the angle deviations are spread using a normal distribution between 0 and baseDeviation
-	dRot = RNG::boxMuller(0, baseDeviation);
-	dTilt = RNG::boxMuller(0, baseDeviation / 10.0);
+	dRot = RNG::boxMuller(0, baseDeviation, RNG_COMBAT);
+	dTilt = RNG::boxMuller(0, baseDeviation / 10.0, RNG_COMBAT);
 	rotation = atan2(double(target->y - origin.y), double(target->x - origin.x)) * 180 / M_PI;
 	tilt = atan2(double(target->z - origin.z),
 		sqrt(double(target->x - origin.x)*double(target->x - origin.x)+double(target->y - origin.y)*double(target->y - origin.y))) * 180 / M_PI;
@@ -184,6 +193,28 @@ void Projectile::applyAccuracy(const Position& origin, Position *target, double
 	target->z = (int)(origin.z + maxRange * sin_fi);
 }
 
+/**
+ * Works out the voxels of the trajectory up to a certain one,
+ * unless the trajectory ends before that.
+ * @param position Index of the voxel in the trajectory.
+ * @return false if the trajectory doesn't get that far.
+ */
+bool Projectile::reach(unsigned int position)
+{
+	while (_voxels <= position && !_ended)
+	{
+		if (_voxels < _length && _trajectory.next(&_history[_voxels % PROJECTILE_HISTORY]))
+		{
+			_voxels++;
+		}
+		else
+		{
+			_ended = true;
+		}
+	}
+	return position < _voxels;
+}
+
 /**
  * Move further in the trajectory.
  * @return false if the trajectory is finished - no new position exists in the trajectory.
@@ -191,13 +222,13 @@ void Projectile::applyAccuracy(const Position& origin, Position *target, double
 bool Projectile::move()
 {
 	_position++;
-	if (_position == _trajectory.size())
+	if (!reach(_position))
 	{
 		_position--;
 		return false;
 	}
 	_position++;
-	if (_position == _trajectory.size())
+	if (!reach(_position))
 	{
 		_position--;
 		return false;
@@ -210,15 +241,27 @@ bool Projectile::move()
 
 /**
  * Get the current position in voxel space.
+ * Only the last PROJECTILE_HISTORY voxels are kept.
  * @param offset
  * @return position in voxel space.
  */
 Position Projectile::getPosition(int offset) const
 {
-	if (_position + offset >= 0 && _position + offset < _trajectory.size())
-		return _trajectory.at(_position + offset);
+	int position = (int)_position + offset;
+	if (position >= 0 && position < (int)_voxels && position > (int)_voxels - PROJECTILE_HISTORY)
+		return _history[position % PROJECTILE_HISTORY];
 	else
-		return _trajectory.at(_position);
+		return _history[_position % PROJECTILE_HISTORY];
+}
+
+/**
+ * Get the voxel where the projectile lands, which
+ * is known as soon as the trajectory is calculated.
+ * @return position in voxel space.
+ */
+Position Projectile::getImpact() const
+{
+	return _impact;
 }
 
 /**
@@ -19,8 +19,11 @@
 #ifndef OPENXCOM_PROJECTILE_H
 #define OPENXCOM_PROJECTILE_H
 
-#include <vector>
 #include "Position.h"
+#include "VoxelLine.h"
+
+// enough voxels to draw the longest bullet trail
+#define PROJECTILE_HISTORY 64
 
 namespace OpenXcom
 {
@@ -31,7 +34,9 @@ class SavedBattleGame;
 
 /**
  * A class that represents a projectile. Map is the owner of an instance of this class during it's short life.
- * It calculates it's own trajectory and then moves along this precalculated trajectory in voxel space.
+ * It works out where it lands as soon as its trajectory is calculated, against the map as it is then,
+ * and then moves along that trajectory in voxel space. The voxels of the trajectory are only worked
+ * out as the projectile gets to them, and only the last few are kept, for the trail.
  */
 class Projectile
 {
@@ -40,11 +45,15 @@ private:
 	SavedBattleGame *_save;
 	BattleItem *_item;
 	Position _origin, _target;
-	std::vector<Position> _trajectory;
-	unsigned int _position;
+	VoxelLine _trajectory;
+	Position _history[PROJECTILE_HISTORY];
+	unsigned int _position, _voxels, _length;
+	Position _impact;
+	bool _ended;
 	static const int _trail[11][36];
 	int _bulletType;
 	void applyAccuracy(const Position& origin, Position *target, double accuracy);
+	bool reach(unsigned int position);
 public:
 	/// Creates a new Projectile.
 	Projectile(ResourcePack *res, SavedBattleGame *save, Position _origin, Position _target, int bulletType);
@@ -52,6 +61,8 @@ public:
 	~Projectile();
 	/// Calculates the trajectory.
 	bool calculateTrajectory(double accuracy);
+	/// Get the voxel where the projectile lands.
+	Position getImpact() const;
 	/// Move the projectile one step in it's trajectory.
 	bool move();
 	/// Get the current position in voxel space.
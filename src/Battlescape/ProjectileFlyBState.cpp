@@ -38,23 +38,28 @@ namespace OpenXcom
 /**
  * Sets up an ProjectileFlyBState.
  */
-ProjectileFlyBState::ProjectileFlyBState(BattlescapeState *parent) : BattleState(parent)
+ProjectileFlyBState::ProjectileFlyBState(BattlescapeState *parent) : BattleState(parent), _unit(0), _current(0)
 {
 
 }
 
 /**
- * Deletes the ProjectileFlyBState.
+ * Deletes the ProjectileFlyBState, along with
+ * the rounds that didn't fly yet.
  */
 ProjectileFlyBState::~ProjectileFlyBState()
 {
-
+	for (unsigned int i = _current + 1; i < _projectiles.size(); i++)
+	{
+		delete _projectiles[i];
+	}
 }
 
 /**
  * init sequence:
- * - create a projectile sprite & add it to the map
- * - calculate it's trajectory
+ * - create the projectiles of all rounds and calculate their trajectories,
+ *   against the map as it is before any of them lands
+ * - add the first projectile sprite to the map
  */
 void ProjectileFlyBState::init()
 {
@@ -84,38 +89,53 @@ void ProjectileFlyBState::init()
         baseAcc = 0;
 	}
 
-	// create a new projectile
-	Projectile *projectile = new Projectile(_parent->getGame()->getResourcePack(),
-									_parent->getGame()->getSavedGame()->getBattleGame(),
-									_unit->getPosition(),
-									_parent->getTarget(),
-									_parent->getSelectedItem()->getRules()->getBulletSprite()
-									);
-	// add the projectile on the map
-	_parent->getMap()->setProjectile(projectile);
-	// let it calculate a trajectory
-	if (projectile->calculateTrajectory(_unit->getFiringAccuracy(baseAcc)))
+	// create the projectiles and let them calculate a trajectory
+	int rounds = _parent->getSelectedAction() == BA_AUTOSHOT ? AUTOSHOT_ROUNDS : 1;
+	for (int i = 0; i < rounds; i++)
 	{
-		// set the soldier in an aiming position
-		_unit->aim(true);
-		_parent->getMap()->cacheUnits();
-		// and we have a lift-off
-		_parent->getGame()->getResourcePack()->getSoundSet("BATTLE.CAT")->getSound(_parent->getSelectedItem()->getRules()->getFireSound())->play();
+		Projectile *projectile = new Projectile(_parent->getGame()->getResourcePack(),
+										_parent->getGame()->getSavedGame()->getBattleGame(),
+										_unit->getPosition(),
+										_parent->getTarget(),
+										_parent->getSelectedItem()->getRules()->getBulletSprite()
+										);
+		if (!projectile->calculateTrajectory(_unit->getFiringAccuracy(baseAcc)))
+		{
+			// no line of fire
+			delete projectile;
+			break;
+		}
+		_projectiles.push_back(projectile);
 	}
-	else
+
+	if (_projectiles.empty())
 	{
-		// no line of fire
-		delete projectile;
-		_parent->getMap()->setProjectile(0);
 		_result = "STR_NO_LINE_OF_FIRE";
 		_parent->popState();
+		return;
 	}
+
+	// set the soldier in an aiming position
+	_unit->aim(true);
+	_parent->getMap()->cacheUnits();
+	launch();
+}
+
+/**
+ * Adds the current projectile on the map and plays the fire sound.
+ */
+void ProjectileFlyBState::launch()
+{
+	_parent->getMap()->setProjectile(_projectiles[_current]);
+	// and we have a lift-off
+	_parent->getGame()->getResourcePack()->getSoundSet("BATTLE.CAT")->getSound(_parent->getSelectedItem()->getRules()->getFireSound())->play();
 }
 
 /**
  * Animates the projectile (move to the next point in it's trajectory).
- * If the animation is finished the projectile sprite is removed from the map.
- * And this state is finished.
+ * If the animation is finished the projectile sprite is removed from the map
+ * and the next round is fired. After the last round this state is finished,
+ * and the impacts are handled in the order the rounds landed.
  */
 void ProjectileFlyBState::think()
 {
@@ -130,10 +150,22 @@ void ProjectileFlyBState::think()
 		{
 			offset = -1;
 		}
-		_parent->statePushNext(new ExplosionBState(_parent, _parent->getMap()->getProjectile()->getPosition(offset), _parent->getSelectedItem()));
+		_impacts.push_back(_parent->getMap()->getProjectile()->getPosition(offset));
 
 		delete _parent->getMap()->getProjectile();
 		_parent->getMap()->setProjectile(0);
+
+		if (++_current < _projectiles.size())
+		{
+			launch();
+			return;
+		}
+
+		// every state goes right after this one, so push the last impact first
+		for (std::vector<Position>::reverse_iterator i = _impacts.rbegin(); i != _impacts.rend(); i++)
+		{
+			_parent->statePushNext(new ExplosionBState(_parent, *i, _parent->getSelectedItem()));
+		}
 		_parent->popState();
 	}
 }
@@ -19,19 +19,31 @@
 #ifndef OPENXCOM_PROJECTILEFLYBSTATE_H
 #define OPENXCOM_PROJECTILEFLYBSTATE_H
 
+#include <vector>
 #include "BattleState.h"
 #include "Position.h"
 
+#define AUTOSHOT_ROUNDS 3
+
 namespace OpenXcom
 {
 
 class BattlescapeState;
 class BattleUnit;
+class Projectile;
 
+/**
+ * Fires a shot, which can be several rounds. Where every round lands is
+ * worked out at once, then the rounds fly one after the other.
+ */
 class ProjectileFlyBState : public BattleState
 {
 private:
 	BattleUnit *_unit;
+	std::vector<Projectile*> _projectiles;
+	unsigned int _current;
+	std::vector<Position> _impacts;
+	void launch();
 public:
 	/// Creates a new ProjectileFly class
 	ProjectileFlyBState(BattlescapeState *parent);
@@ -18,7 +18,15 @@
  */
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <algorithm>
+#include <iterator>
+#include <queue>
+#include <map>
+#include <set>
+#include <cstdlib>
 #include "TerrainModifier.h"
+#include "VoxelLine.h"
+#include "Pathfinding.h"
 #include "SDL.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
@@ -26,6 +34,8 @@
 #include "../Savegame/Soldier.h"
 #include "../Savegame/Alien.h"
 #include "../Engine/RNG.h"
+#include "../Engine/Profiler.h"
+#include "../Engine/JobPool.h"
 #include "../Ruleset/MapDataSet.h"
 #include "../Ruleset/MapData.h"
 #include "../Ruleset/RuleAlien.h"
@@ -35,13 +45,21 @@
 namespace OpenXcom
 {
 
+TerrainModifier::RayStep TerrainModifier::_fovRays[FOV_PITCHES][RAY_HEADINGS][MAX_VIEW_DISTANCE];
+bool TerrainModifier::_raysBuilt = false;
+std::vector<TerrainModifier::LightStencil> TerrainModifier::_lightStencils;
+
 /**
  * Sets up a TerrainModifier.
  * @param save pointer to SavedBattleGame object.
+ * @param lofts pointer to the packed voxel shapes.
  */
-TerrainModifier::TerrainModifier(SavedBattleGame *save, std::vector<Uint16> *voxelData) : _save(save), _voxelData(voxelData)
+TerrainModifier::TerrainModifier(SavedBattleGame *save, const Uint16 *lofts) : _save(save), _lofts(lofts), _skippedFOV(0), _sightLines(), _sightLinesTurn(-1), _sightLinesVersion(-1)
 {
-
+	if (!_raysBuilt)
+	{
+		buildRays();
+	}
 }
 
 /**
@@ -53,11 +71,42 @@ TerrainModifier::~TerrainModifier()
 }
 
 
+/**
+ * Precalculates the tiles every ray passes, so raytracing doesn't need any trigonometry.
+ * Field of view rays go every 6 degrees from -90 to 60 up and down, and every 3 degrees around.
+ * They start in the middle of the unit's tile, halfway up.
+ */
+void TerrainModifier::buildRays()
+{
+	for (int fi = -90; fi <= 60; fi += 6)
+	{
+		double cos_fi = cos(fi * M_PI / 180.0);
+		double sin_fi = sin(fi * M_PI / 180.0);
+
+		for (int te = 0; te <= 360; te += 3)
+		{
+			double cos_te = cos(te * M_PI / 180.0);
+			double sin_te = sin(te * M_PI / 180.0);
+			RayStep *ray = _fovRays[(fi + 90) / 6][te / 3];
+
+			for (int l = 1; l <= MAX_VIEW_DISTANCE; l++)
+			{
+				ray[l - 1].x = (Sint8)floor(0.5 + l * cos_te * cos_fi);
+				ray[l - 1].y = (Sint8)floor(0.5 + l * sin_te * cos_fi);
+				ray[l - 1].z = (Sint8)floor((1.5 + l * sin_fi) / 2.0);
+			}
+		}
+	}
+
+	_raysBuilt = true;
+}
+
 /**
   * Calculate sun shading for the whole terrain.
   */
 void TerrainModifier::calculateSunShading()
 {
+	ProfileMarker marker(PROF_LIGHTING);
 	for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
 	{
 		calculateSunShading(_save->getTiles()[i]);
@@ -77,7 +126,8 @@ void TerrainModifier::calculateSunShading(Tile *tile)
 	// At night/dusk sun isn't dropping shades
 	if (_save->getGlobalShade() <= 5)
 	{
-		if (verticalBlockage(_save->getTile(Position(tile->getPosition().x, tile->getPosition().y, _save->getHeight() - 1)), tile, DT_NONE))
+		// a floor above the tile blocks the sun
+		if (tile->getPosition().z < _save->getSkyLevel(tile->getPosition().x, tile->getPosition().y))
 		{
 			power-=2;
 		}
@@ -91,48 +141,88 @@ void TerrainModifier::calculateSunShading(Tile *tile)
   */
 void TerrainModifier::calculateTerrainLighting()
 {
+	ProfileMarker marker(PROF_LIGHTING);
 	const int layer = 1; // Static lighting layer.
-	const int fireLightPower = 15; // amount of light a fire generates
 
 	// during daytime don't calculate lighting
 	if (_save->getGlobalShade() < 1)
 		return;
 
-	// reset all light to 0 first
+	std::vector<LightSource> sources;
+
+	// add lighting of terrain
 	for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
 	{
-		_save->getTiles()[i]->resetLight(layer);
+		addTerrainLightSources(_save->getTiles()[i], &sources);
 	}
 
-	// add lighting of terrain
-	for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
+	// todo: add lighting of items (flares)
+
+	updateLight(layer, &sources);
+}
+
+/**
+  * Recalculate lighting for the terrain, when only some tiles changed (for example by an explosion).
+  * The light sources on the other tiles are kept.
+  * @param tiles The changed tiles.
+  */
+void TerrainModifier::calculateTerrainLighting(const std::vector<Tile*> &tiles)
+{
+	ProfileMarker marker(PROF_LIGHTING);
+	const int layer = 1; // Static lighting layer.
+
+	// during daytime don't calculate lighting
+	if (_save->getGlobalShade() < 1)
+		return;
+
+	std::set<int> changed;
+	for (std::vector<Tile*>::const_iterator i = tiles.begin(); i != tiles.end(); i++)
 	{
-		// only floors and objects can light up
-		if (_save->getTiles()[i]->getMapData(O_FLOOR)
-			&& _save->getTiles()[i]->getMapData(O_FLOOR)->getLightSource())
-		{
-			addLight(_save->getTiles()[i]->getPosition(), _save->getTiles()[i]->getMapData(O_FLOOR)->getLightSource(), layer);
-		}
-		if (_save->getTiles()[i]->getMapData(O_OBJECT)
-			&& _save->getTiles()[i]->getMapData(O_OBJECT)->getLightSource())
+		changed.insert(_save->getTileIndex((*i)->getPosition()));
+	}
+
+	std::vector<LightSource> sources;
+	for (std::vector<LightSource>::iterator i = _lightSources[layer].begin(); i != _lightSources[layer].end(); i++)
+	{
+		if (!changed.count(_save->getTileIndex(i->position)))
 		{
-			addLight(_save->getTiles()[i]->getPosition(), _save->getTiles()[i]->getMapData(O_OBJECT)->getLightSource(), layer);
+			sources.push_back(*i);
 		}
+	}
+	for (std::vector<Tile*>::const_iterator i = tiles.begin(); i != tiles.end(); i++)
+	{
+		addTerrainLightSources(*i, &sources);
+	}
+
+	updateLight(layer, &sources);
+}
 
-		// fires
-		if (_save->getTiles()[i]->getFire())
+/**
+  * Adds the light sources of a tile to a list: lit floors and objects, and fire.
+  * @param tile
+  * @param sources
+  */
+void TerrainModifier::addTerrainLightSources(Tile *tile, std::vector<LightSource> *sources)
+{
+	const int fireLightPower = 15; // amount of light a fire generates
+
+	// only floors and objects can light up
+	int index = _save->getTileIndex(tile->getPosition());
+	for (int part = O_FLOOR; part <= O_OBJECT; part += O_OBJECT)
+	{
+		int power = _save->getTerrainLight(_save->getTileObject(index, part));
+		if (power)
 		{
-			addLight(_save->getTiles()[i]->getPosition(), fireLightPower, layer);
+			LightSource light = { tile->getPosition(), power };
+			sources->push_back(light);
 		}
-
 	}
 
-	// todo: add lighting of items (flares)
-
-	// set changed light tiles to uncached
-	for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
+	// fires
+	if (tile->getFire())
 	{
-		_save->getTiles()[i]->checkForChangedLight(layer);
+		LightSource light = { tile->getPosition(), fireLightPower };
+		sources->push_back(light);
 	}
 }
 
@@ -141,6 +231,7 @@ void TerrainModifier::calculateTerrainLighting()
   */
 void TerrainModifier::calculateUnitLighting()
 {
+	ProfileMarker marker(PROF_LIGHTING);
 	const int layer = 2; // Dynamic lighting layer.
 	const int personalLightPower = 15; // amount of light a unit generates
 
@@ -148,93 +239,307 @@ void TerrainModifier::calculateUnitLighting()
 	if (_save->getGlobalShade() < 1)
 		return;
 
-	// reset all light to 0 first
-	for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
-	{
-		_save->getTiles()[i]->resetLight(layer);
-	}
+	std::vector<LightSource> sources;
 
 	// add lighting of soldiers
 	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
 	{
 		if ((*i)->getFaction() == FACTION_PLAYER && !(*i)->isOut())
 		{
-			addLight((*i)->getPosition(), personalLightPower, layer);
+			LightSource light = { (*i)->getPosition(), personalLightPower };
+			sources.push_back(light);
 		}
 	}
 
-	// set changed light tiles to uncached
-	for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
+	updateLight(layer, &sources);
+}
+
+/**
+ * Orders light sources by position and power, so two lists of them can be compared.
+ */
+bool TerrainModifier::lightSourceLess(const LightSource &a, const LightSource &b)
+{
+	if (a.position.x != b.position.x) return a.position.x < b.position.x;
+	if (a.position.y != b.position.y) return a.position.y < b.position.y;
+	if (a.position.z != b.position.z) return a.position.z < b.position.z;
+	return a.power < b.power;
+}
+
+/**
+ * Updates a light layer to a new list of light sources. Only the area lit by sources that were added or removed
+ * since the last update is recalculated: light of a layer is the brightest of the sources, so that area is reset
+ * and every source reaching it lights it again. Moving a unit one tile only touches the 31x31 area around it.
+ * @param layer Light is seperated in 3 layers: Ambient, Static and Dynamic.
+ * @param sources The new light sources, they are sorted and kept for the next update.
+ */
+void TerrainModifier::updateLight(int layer, std::vector<LightSource> *sources)
+{
+	std::vector<LightSource> *oldSources = &_lightSources[layer];
+	std::vector<LightSource> changed;
+
+	std::sort(sources->begin(), sources->end(), lightSourceLess);
+	std::set_symmetric_difference(oldSources->begin(), oldSources->end(), sources->begin(), sources->end(), std::back_inserter(changed), lightSourceLess);
+
+	if (changed.empty())
+		return;
+
+	// light goes through all levels, so mark the columns lit by the changed sources
+	std::vector<bool> columns(_save->getWidth() * _save->getLength(), false);
+	int minX = _save->getWidth(), minY = _save->getLength(), maxX = -1, maxY = -1;
+	for (std::vector<LightSource>::iterator i = changed.begin(); i != changed.end(); i++)
 	{
-		_save->getTiles()[i]->checkForChangedLight(layer);
+		int x1 = std::max(0, i->position.x - i->power), x2 = std::min(_save->getWidth() - 1, i->position.x + i->power);
+		int y1 = std::max(0, i->position.y - i->power), y2 = std::min(_save->getLength() - 1, i->position.y + i->power);
+		for (int x = x1; x <= x2; x++)
+		{
+			for (int y = y1; y <= y2; y++)
+			{
+				columns[y * _save->getWidth() + x] = true;
+			}
+		}
+		minX = std::min(minX, x1); maxX = std::max(maxX, x2);
+		minY = std::min(minY, y1); maxY = std::max(maxY, y2);
 	}
+
+	// keep the reset tiles, they are the only ones that can change
+	std::vector<Tile*> relit;
+	for (int x = minX; x <= maxX; x++)
+	{
+		for (int y = minY; y <= maxY; y++)
+		{
+			if (!columns[y * _save->getWidth() + x])
+				continue;
+			for (int z = 0; z < _save->getHeight(); z++)
+			{
+				Tile *tile = _save->getTile(Position(x, y, z));
+				tile->resetLight(layer);
+				relit.push_back(tile);
+			}
+		}
+	}
+
+	for (std::vector<LightSource>::iterator i = sources->begin(); i != sources->end(); i++)
+	{
+		if (i->position.x + i->power >= minX && i->position.x - i->power <= maxX
+			&& i->position.y + i->power >= minY && i->position.y - i->power <= maxY)
+		{
+			addLight(i->position, i->power, layer, &columns);
+		}
+	}
+
+	// set the changed tiles to uncached and invalidate the field of view around them
+	int changedMinX = _save->getWidth(), changedMinY = _save->getLength(), changedMaxX = -1, changedMaxY = -1;
+	for (std::vector<Tile*>::iterator i = relit.begin(); i != relit.end(); i++)
+	{
+		if ((*i)->checkForChangedLight(layer))
+		{
+			const Position &pos = (*i)->getPosition();
+			changedMinX = std::min(changedMinX, pos.x);
+			changedMinY = std::min(changedMinY, pos.y);
+			changedMaxX = std::max(changedMaxX, pos.x);
+			changedMaxY = std::max(changedMaxY, pos.y);
+		}
+	}
+
+	if (changedMaxX != -1)
+	{
+		int radius = std::max(changedMaxX - changedMinX, changedMaxY - changedMinY) / 2 + 1;
+		invalidateFOV(Position((changedMinX + changedMaxX) / 2, (changedMinY + changedMaxY) / 2, 0), radius);
+	}
+
+	oldSources->swap(*sources);
 }
 
 /**
  * Calculates line of sight of a soldier. For every visible tile fog of war is removed.
+ * The visible tiles are cached on the unit, as long as the unit doesn't move or turn and the terrain
+ * around it doesn't change, we only check these tiles for units that came into view.
  * @param unit
  */
 void TerrainModifier::calculateFOV(BattleUnit *unit)
+{
+	std::vector<BattleUnit*> units(1, unit);
+	calculateFOV(&units, 1);
+}
+
+/**
+ * Calculates line of sight of several soldiers at once. The rays of the units that need to raytrace
+ * only read the terrain, so they can be traced in parallel: every worker thread keeps its own checked
+ * tiles and the tiles to discover. Fog of war is removed and the units in view are checked afterwards,
+ * one unit after the other, like calculateFOV(unit) does.
+ * @param units the units to calculate the field of view of.
+ * @param threads number of worker threads, 1 traces the rays in this thread.
+ */
+void TerrainModifier::calculateFOV(std::vector<BattleUnit*> *units, int threads)
+{
+	ProfileMarker marker(PROF_FOV);
+	std::vector<BattleUnit*> traced;
+	std::vector<int> turns;
+	for (std::vector<BattleUnit*>::iterator i = units->begin(); i != units->end(); i++)
+	{
+		// we see the tile we are standing on
+		if ((*i)->getFaction() == FACTION_PLAYER)
+		{
+			_save->getTile((*i)->getPosition())->setDiscovered(true);
+		}
+
+		(*i)->clearVisibleUnits();
+
+		// nothing changed since the last time, so we can skip the raytracing
+		if (!(*i)->isFOVCached())
+		{
+			// after turning a step only the sector that came into view needs rays
+			int turn = (*i)->getFOVTurn();
+			if (turn != 0)
+			{
+				turnFOV(*i, turn);
+			}
+			else
+			{
+				(*i)->clearVisibleTiles();
+			}
+			_save->setVisibleTilesDirty((*i)->getFaction());
+			traced.push_back(*i);
+			turns.push_back(turn);
+		}
+	}
+
+	threads = std::max(1, std::min(threads, (int)traced.size()));
+	std::vector<FOVPart> parts(threads);
+	for (int i = 0; i < threads; i++)
+	{
+		parts[i].terrain = this;
+		parts[i].units = &traced;
+		parts[i].turns = &turns;
+		parts[i].first = i;
+		parts[i].step = threads;
+	}
+	// the first part is done by this thread
+	JobGroup group;
+	for (int i = 1; i < threads; i++)
+	{
+		JobPool::run(&group, traceFOVPart, &parts[i]);
+	}
+	traceFOVPart(&parts[0]);
+	JobPool::wait(&group);
+
+	// merge the results
+	for (std::vector<FOVPart>::iterator i = parts.begin(); i != parts.end(); i++)
+	{
+		for (std::vector<Tile*>::iterator j = i->discovered.begin(); j != i->discovered.end(); j++)
+		{
+			(*j)->setDiscovered(true);
+		}
+	}
+	for (std::vector<BattleUnit*>::iterator i = units->begin(); i != units->end(); i++)
+	{
+		checkForVisibleUnits(*i);
+		(*i)->finishVisibleUnits();
+		(*i)->setFOVCached(true);
+	}
+}
+
+/**
+ * Traces the rays of every step'th unit of a batch, starting at the first one.
+ * @param data pointer to the FOVPart.
+ * @return 0
+ */
+int TerrainModifier::traceFOVPart(void *data)
+{
+	FOVPart *part = (FOVPart*)data;
+	for (int i = part->first; i < (int)part->units->size(); i += part->step)
+	{
+		part->terrain->traceFOV(part->units->at(i), part->turns->at(i), &part->checked, &part->discovered);
+	}
+	return 0;
+}
+
+/**
+ * Keeps the visible tiles of a unit that turned a step which are still seen by the rays the old
+ * and the new direction share. Every tile knows which of the FOV_HEADINGS headings saw it,
+ * turning a step moves the headings over by FOV_TURN_HEADINGS (45 degrees).
+ * @param unit
+ * @param turn 1 if the unit turned clockwise, -1 if it turned counter-clockwise.
+ */
+void TerrainModifier::turnFOV(BattleUnit *unit, int turn)
+{
+	std::vector<Tile*> *tiles = unit->getVisibleTiles();
+	std::vector<unsigned int> *rays = unit->getVisibleRays();
+	const unsigned int all = (1u << FOV_HEADINGS) - 1;
+	size_t kept = 0;
+	for (size_t i = 0; i < tiles->size(); i++)
+	{
+		unsigned int r = turn > 0 ? ((*rays)[i] << FOV_TURN_HEADINGS) & all : (*rays)[i] >> FOV_TURN_HEADINGS;
+		if (r != 0)
+		{
+			(*tiles)[kept] = (*tiles)[i];
+			(*rays)[kept] = r;
+			kept++;
+		}
+	}
+	tiles->resize(kept);
+	rays->resize(kept);
+}
+
+/**
+ * Traces the rays of a unit, storing the tiles it sees on the unit.
+ * The terrain isn't changed, so several units can be traced at the same time.
+ * @param unit
+ * @param turn 0 to trace all rays, otherwise the unit kept the tiles of its last direction
+ * it still sees and only the sector that came into view by turning is traced.
+ * @param checked scratch space to find the tiles already seen in the unit's list.
+ * @param discovered the tiles the player discovers are added to this.
+ */
+void TerrainModifier::traceFOV(BattleUnit *unit, int turn, std::vector<int> *checked, std::vector<Tile*> *discovered)
 {
 	// units see 90 degrees sidewards.
-	double startAngle[8] = { 45, 0, -45, 270, 225, 180, 135, 90 };
-	double endAngle[8] = { 135, 90, 45, 360, 315, 270, 225, 180 };
+	int startAngle[8] = { 45, 0, -45, 270, 225, 180, 135, 90 };
 
-	double centerZ = (unit->getPosition().z * 2) + 1.5;
-	double centerX = unit->getPosition().x + 0.5;
-	double centerY = unit->getPosition().y + 0.5;
 	int power_, objectFalloff;
 
 	// units see 90 degrees down and 60 degrees up.
-	double startFi = -90;
-	double endFi = 60;
+	int startFi = -90;
+	int endFi = 60;
 
 	if (unit->getPosition().z == 0)
 	{
 		startFi = 0;
 	}
 
-	// we see the tile we are standing on
-	if (unit->getFaction() == FACTION_PLAYER)
+	// the tiles that are kept are already seen
+	checked->assign(_save->getWidth() * _save->getLength() * _save->getHeight(), 0);
+	std::vector<Tile*> *tiles = unit->getVisibleTiles();
+	std::vector<unsigned int> *rays = unit->getVisibleRays();
+	for (size_t i = 0; i < tiles->size(); i++)
 	{
-		_save->getTile(unit->getPosition())->setDiscovered(true);
-	}
-
-	unit->clearVisibleUnits();
-	for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
-	{
-		_save->getTiles()[i]->setChecked(false);
+		(*checked)[_save->getTileIndex((*tiles)[i]->getPosition())] = i + 1;
 	}
 
+	// turning clockwise brings the first headings into view, counter-clockwise the last ones
+	int firstHeading = turn < 0 ? FOV_HEADINGS - FOV_TURN_HEADINGS : 0;
+	int lastHeading = turn > 0 ? FOV_TURN_HEADINGS - 1 : FOV_HEADINGS - 1;
 
 	// raytrace up and down
-	for (double fi = startFi; fi <= endFi; fi += 6)
+	for (int fi = startFi; fi <= endFi; fi += 6)
 	{
-		double cos_fi = cos(fi * M_PI / 180.0);
-		double sin_fi = sin(fi * M_PI / 180.0);
-
 		// raytrace every 3 degrees makes sure we cover all tiles in a circle.
-		for (double te = startAngle[unit->getDirection()]; te <= endAngle[unit->getDirection()]; te += 3)
+		for (int heading = firstHeading; heading <= lastHeading; heading++)
 		{
-			double cos_te = cos(te * M_PI / 180.0);
-			double sin_te = sin(te * M_PI / 180.0);
-
+			int te = startAngle[unit->getDirection()] + heading * 3;
+			// -45 degrees is the same ray as 315 degrees
+			const RayStep *ray = _fovRays[(fi + 90) / 6][(te < 0 ? te + 360 : te) / 3];
 			Tile *origin = _save->getTile(unit->getPosition());
-			double l = 0;
-			double vx, vy, vz;
+			int l = 0;
 			int tileX, tileY, tileZ;
-			power_ = 20;
+			power_ = MAX_VIEW_DISTANCE;
 
+			// every step costs at least 1 power, so we never go past the end of the ray
 			while (power_ > 0)
 			{
+				tileX = unit->getPosition().x + ray[l].x;
+				tileY = unit->getPosition().y + ray[l].y;
+				tileZ = unit->getPosition().z + ray[l].z;
 				l++;
-				vx = centerX + l * cos_te * cos_fi;
-				vy = centerY + l * sin_te * cos_fi;
-				vz = centerZ + l * sin_fi;
-
-				tileZ = int(floor(vz / 2.0));
-				tileX = int(floor(vx));
-				tileY = int(floor(vy));
 
 				power_--;
 
@@ -242,21 +547,15 @@ void TerrainModifier::calculateFOV(BattleUnit *unit)
 				if (!dest) break; // out of map!
 
 				// horizontal blockage by walls
-				power_ -= horizontalBlockage(origin, dest, DT_NONE);
+				power_ -= horizontalBlockage<DT_NONE>(origin, dest);
 
 				// vertical blockage by ceilings/floors
-				power_ -= verticalBlockage(origin, dest, DT_NONE);
+				power_ -= verticalBlockage<DT_NONE>(origin, dest);
 
 				// objects on destination tile affect the ray after it has crossed this tile
 				// but it has to be calculated before we affect the tile (it could have been blown up)
-				if (dest->getMapData(O_OBJECT))
-				{
-					objectFalloff = dest->getMapData(O_OBJECT)->getBlock(DT_NONE);
-				}
-				else
-				{
-					objectFalloff = 0;
-				}
+				int index = _save->getTileIndex(Position(tileX, tileY, tileZ));
+				objectFalloff = _save->getTerrainBlock<DT_NONE>(_save->getTileObject(index, O_OBJECT));
 
 				// smoke decreases visibility - but not for terrain
 				/*if (dest->getSmoke())
@@ -264,26 +563,30 @@ void TerrainModifier::calculateFOV(BattleUnit *unit)
 					objectFalloff += int(dest->getSmoke() / 3);
 				}*/
 
-				if (power_ > 0 && dest->getShade() < 10 && !dest->getChecked())
+				if (power_ > 0 && dest->getShade() < 10 && (*checked)[index])
 				{
-					dest->setChecked(true);
-					checkForVisibleUnits(unit, dest);
+					(*rays)[(*checked)[index] - 1] |= 1u << heading;
+				}
+				else if (power_ > 0 && dest->getShade() < 10)
+				{
+					unit->addToVisibleTiles(dest, 1u << heading);
+					(*checked)[index] = tiles->size();
 					if (unit->getFaction() == FACTION_PLAYER)
 					{
-						dest->setDiscovered(true);
+						discovered->push_back(dest);
 					}
 					// if there is a door to the east or south of a visible tile, we see that too
 					if (unit->getFaction() == FACTION_PLAYER)
 					{
 						Tile* t = _save->getTile(Position(tileX + 1, tileY, tileZ));
-						if (t && t->getMapData(O_WESTWALL) && (t->getMapData(O_WESTWALL)->isDoor() || t->getMapData(O_WESTWALL)->isUFODoor()))
+						if (t && (_save->getTerrainFlags(_save->getTileObject(index + 1, O_WESTWALL)) & (TERRAIN_DOOR | TERRAIN_UFO_DOOR)))
 						{
-							t->setDiscovered(true);
+							discovered->push_back(t);
 						}
 						t = _save->getTile(Position(tileX, tileY - 1, tileZ));
-						if (t && t->getMapData(O_NORTHWALL) && (t->getMapData(O_NORTHWALL)->isDoor() || t->getMapData(O_NORTHWALL)->isUFODoor()))
+						if (t && (_save->getTerrainFlags(_save->getTileObject(index - _save->getWidth(), O_NORTHWALL)) & (TERRAIN_DOOR | TERRAIN_UFO_DOOR)))
 						{
-							t->setDiscovered(true);
+							discovered->push_back(t);
 						}
 					}
 				}
@@ -295,96 +598,193 @@ void TerrainModifier::calculateFOV(BattleUnit *unit)
 }
 
 /**
- * Check for an opposing unit on this tile
+ * Check for opposing units on the tiles a unit sees. The lines of sight
+ * to all of them are cast together.
  * @param unit
- * @param tile
  */
-bool TerrainModifier::checkForVisibleUnits(BattleUnit *unit, Tile *tile)
+void TerrainModifier::checkForVisibleUnits(BattleUnit *unit)
 {
-	BattleUnit *bu = tile->getUnit();
+	std::vector<BattleUnit*> candidates;
+	std::vector<std::pair<Position, Position> > lines;
+	for (std::vector<Tile*>::iterator i = unit->getVisibleTiles()->begin(); i != unit->getVisibleTiles()->end(); i++)
+	{
+		Tile *tile = *i;
+		BattleUnit *bu = tile->getUnit();
+
+		if (bu == 0 || bu->isOut())
+		{
+			continue;
+		}
 
-	if (bu == 0 || bu->isOut())
+		if (unit->getFaction() == FACTION_PLAYER && (bu->getFaction() == FACTION_PLAYER || bu->getFaction() == FACTION_NEUTRAL))
+		{
+			continue;
+		}
+
+		if (unit->getFaction() == FACTION_HOSTILE && bu->getFaction() == FACTION_HOSTILE)
+		{
+			continue;
+		}
+
+		Position originVoxel, targetVoxel;
+		originVoxel = Position((unit->getPosition().x * 16) + 8, (unit->getPosition().y * 16) + 8, unit->getPosition().z*24);
+		originVoxel.z += -tile->getTerrainLevel();
+		originVoxel.z += unit->isKneeled()?unit->getUnit()->getKneelHeight():unit->getUnit()->getStandHeight();
+
+		targetVoxel = Position((bu->getPosition().x * 16) + 8, (bu->getPosition().y * 16) + 8, bu->getPosition().z*24);
+		targetVoxel.z += -_save->getTile(bu->getPosition())->getTerrainLevel();
+		targetVoxel.z += bu->isKneeled()?bu->getUnit()->getKneelHeight():bu->getUnit()->getStandHeight();
+
+		// cast a ray from the middle of the unit to the middle of this one
+		candidates.push_back(bu);
+		lines.push_back(std::make_pair(originVoxel, targetVoxel));
+	}
+
+	std::vector<int> results;
+	calculateSightLines(lines, &results);
+	for (size_t i = 0; i < candidates.size(); i++)
 	{
-		return false;
+		const Position &targetVoxel = lines[i].second;
+		Position hitPosition = Position(targetVoxel.x/16, targetVoxel.y/16, targetVoxel.z/24);
+		if (results[i] == -1 || (results[i] == 4 && candidates[i]->getPosition() == hitPosition))
+		{
+			unit->addToVisibleUnits(candidates[i]);
+		}
 	}
+}
+
 
-	if (unit->getFaction() == FACTION_PLAYER && (bu->getFaction() == FACTION_PLAYER || bu->getFaction() == FACTION_NEUTRAL))
+/**
+ * Calculates line of sight of the soldiers of the current side within range of the Position.
+ * Units that are too far away to see anything within the radius keep their field of view.
+ * @param position Tile position.
+ * @param radius Radius of the affected area in tiles.
+ */
+void TerrainModifier::calculateFOV(const Position &position, int radius)
+{
+	ProfileMarker marker(PROF_FOV);
+	std::vector<BattleUnit*> units;
+	_save->getUnitsInRange(position, radius + MAX_VIEW_DISTANCE + 1, &units);
+
+	_skippedFOV = 0;
+	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
 	{
-		return false;
+		if ((*i)->getFaction() == _save->getSide())
+		{
+			_skippedFOV++;
+		}
 	}
 
-	if (unit->getFaction() == FACTION_HOSTILE && bu->getFaction() == FACTION_HOSTILE)
+	std::vector<BattleUnit*> side;
+	for (std::vector<BattleUnit*>::iterator i = units.begin(); i != units.end(); i++)
 	{
-		return false;
+		if ((*i)->getFaction() == _save->getSide())
+		{
+			side.push_back(*i);
+			_skippedFOV--;
+		}
 	}
+	calculateFOV(&side);
+}
 
-	Position originVoxel, targetVoxel;
-	originVoxel = Position((unit->getPosition().x * 16) + 8, (unit->getPosition().y * 16) + 8, unit->getPosition().z*24);
-	originVoxel.z += -tile->getTerrainLevel();
-	originVoxel.z += unit->isKneeled()?unit->getUnit()->getKneelHeight():unit->getUnit()->getStandHeight();
-	bool unitSeen = false;
+/**
+ * Get the number of units of the current side that were out of range in the last call to calculateFOV(position).
+ * @return number of units skipped
+ */
+int TerrainModifier::getSkippedFOV() const
+{
+	return _skippedFOV;
+}
 
-	targetVoxel = Position((bu->getPosition().x * 16) + 8, (bu->getPosition().y * 16) + 8, bu->getPosition().z*24);
-	targetVoxel.z += -_save->getTile(bu->getPosition())->getTerrainLevel();
-	targetVoxel.z += bu->isKneeled()?bu->getUnit()->getKneelHeight():bu->getUnit()->getStandHeight();
+/**
+ * Invalidate the cached field of view of all units that could have seen something change in a certain area.
+ * Rays reach up to MAX_VIEW_DISTANCE tiles, blockage checks look one tile further.
+ * @param position Center of the changed area.
+ * @param radius Radius of the changed area in tiles.
+ */
+void TerrainModifier::invalidateFOV(const Position &position, int radius)
+{
+	std::vector<BattleUnit*> units;
+	_save->getUnitsInRange(position, radius + MAX_VIEW_DISTANCE + 1, &units);
 
-	// cast a ray from the middle of the unit to the middle of this one
-	int test = calculateLine(originVoxel, targetVoxel, false, 0, 0);
-	Position hitPosition = Position(targetVoxel.x/16, targetVoxel.y/16, targetVoxel.z/24);
-	if (test == -1 || (test == 4 && bu->getPosition() == hitPosition))
+	for (std::vector<BattleUnit*>::iterator i = units.begin(); i != units.end(); i++)
 	{
-		unitSeen = true;
-		unit->addToVisibleUnits(bu);
+		(*i)->setFOVCached(false);
 	}
-
-	return unitSeen;
 }
 
-
 /**
- * Calculates line of sight of a soldiers within range of the Position.
- * TODO: review this, because it is recalculating all soldiers.
- * @param position
+ * Gets the light pattern of a source with a certain power, calculating it the first time.
+ * Row dy (from -power to power) lights the tiles up to halfWidths[dy + power] away from the center,
+ * light[(dy + power) * (2 * power + 1) + dx + power] is the light a tile gets.
+ * @param power
+ * @return stencil
  */
-void TerrainModifier::calculateFOV(const Position &position)
+const TerrainModifier::LightStencil &TerrainModifier::getLightStencil(int power)
 {
-	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); i++)
+	if ((int)_lightStencils.size() <= power)
 	{
-		if ((*i)->getFaction() == _save->getSide())
+		_lightStencils.resize(power + 1);
+	}
+
+	LightStencil *stencil = &_lightStencils[power];
+	if (stencil->halfWidths.empty())
+	{
+		int size = 2 * power + 1;
+		stencil->power = power;
+		stencil->halfWidths.resize(size, -1);
+		stencil->light.resize(size * size, 0);
+		for (int y = -power; y <= power; y++)
 		{
-			calculateFOV(*i);
+			for (int x = -power; x <= power; x++)
+			{
+				int light = power - int(floor(sqrt(float(x*x + y*y)) + 0.5));
+				if (light > 0)
+				{
+					stencil->light[(y + power) * size + x + power] = light;
+					stencil->halfWidths[y + power] = std::max(stencil->halfWidths[y + power], abs(x));
+				}
+			}
 		}
 	}
+	return *stencil;
 }
 
 /**
  * Adds circular light pattern starting from center and loosing power with distance travelled.
+ * The pattern comes from a precalculated stencil, clipped to the map row by row.
  * @param center
  * @param power
  * @param layer Light is seperated in 3 layers: Ambient, Static and Dynamic.
+ * @param columns Only light the columns of tiles set in here (width * length, null for all).
  */
-void TerrainModifier::addLight(const Position &center, int power, int layer)
+void TerrainModifier::addLight(const Position &center, int power, int layer, const std::vector<bool> *columns)
 {
-	// only loop through the positive quadrant.
-	for (int x = 0; x <= power; x++)
-	{
-		for (int y = 0; y <= power; y++)
-		{
-			for (int z = 0; z < _save->getHeight(); z++)
-			{
-				int distance = int(floor(sqrt(float(x*x + y*y)) + 0.5));
+	if (power <= 0)
+		return;
 
-				if (_save->getTile(Position(center.x + x,center.y + y, z)))
-					_save->getTile(Position(center.x + x,center.y + y, z))->addLight(power - distance, layer);
+	const LightStencil &stencil = getLightStencil(power);
+	const int size = 2 * power + 1;
+	const int width = _save->getWidth(), length = _save->getLength();
+	Tile **tiles = _save->getTiles();
 
-				if (_save->getTile(Position(center.x - x,center.y - y, z)))
-					_save->getTile(Position(center.x - x,center.y - y, z))->addLight(power - distance, layer);
+	for (int y = std::max(0, center.y - power); y <= std::min(length - 1, center.y + power); y++)
+	{
+		int halfWidth = stencil.halfWidths[y - center.y + power];
+		if (halfWidth < 0)
+			continue;
 
-				if (_save->getTile(Position(center.x - x,center.y + y, z)))
-					_save->getTile(Position(center.x - x,center.y + y, z))->addLight(power - distance, layer);
+		int x1 = std::max(0, center.x - halfWidth), x2 = std::min(width - 1, center.x + halfWidth);
+		const Sint8 *light = &stencil.light[(y - center.y + power) * size];
 
-				if (_save->getTile(Position(center.x + x,center.y - y, z)))
-					_save->getTile(Position(center.x + x,center.y - y, z))->addLight(power - distance, layer);
+		for (int z = 0; z < _save->getHeight(); z++)
+		{
+			int row = z * length * width + y * width;
+			for (int x = x1; x <= x2; x++)
+			{
+				if (columns && !(*columns)[y * width + x])
+					continue;
+				tiles[row + x]->addLight(light[x - center.x + power], layer);
 			}
 		}
 	}
@@ -394,42 +794,22 @@ void TerrainModifier::addLight(const Position &center, int power, int layer)
  * The amount this certain wall or floor-part of the tile blocks.
  * @param tile
  * @param part
- * @param affector
+ * @tparam type Damage type.
  * @return amount of blockage
  */
-int TerrainModifier::blockage(Tile *tile, const int part, ItemDamageType type)
+template <ItemDamageType type> int TerrainModifier::blockage(Tile *tile, const int part)
 {
-	int blockage = 0;
-	
 	if (tile == 0) return 0; // probably outside the map here
 
-	if (part == O_FLOOR && tile->getMapData(O_FLOOR))
-	{
-		// blockage modifiers of floors in ufo only counted for horizontal stuff, so this is kind of an experiment
-		if (type == DT_HE)
-			blockage += 15;	
-		else
-			blockage += 255;
-	}
-	else
-	{
-		if (tile->getMapData(part))
-			blockage += tile->getMapData(part)->getBlock(type);
-
-		// open ufo doors are actually still closed behind the scenes
-		// so a special trick is needed to see if they are open, if they are, they obviously don't block anything
-		if (tile->isUfoDoorOpen(part)) 
-			blockage = 0;
-	}
-
-	return blockage;
+	return _save->getBlockage<type>(_save->getTileIndex(tile->getPosition()), part);
 }
 
 /**
- * HE, smoke and fire explodes in a circular pattern on 1 level only. HE however damages floor tiles of the above level. Not the units on it.
- * HE destroys an object if its armor is lower than the explosive power, then it's HE blockage is applied for further propagation.
+ * HE, smoke and fire explodes in a circular pattern. HE also goes through floors to the levels above and below.
+ * Objects with explosives in them, like fuel tanks and ufo power sources, explode in turn when they are destroyed.
+ * The explosions of such a chain go off one after the other, and the field of view and lighting are
+ * only refreshed once all of them did, for all the tiles they reached.
  * See http://www.ufopaedia.org/index.php?title=Explosions for more info.
- * TODO : use bresenham?
  * @param center
  * @param power
  * @param affector
@@ -437,118 +817,242 @@ int TerrainModifier::blockage(Tile *tile, const int part, ItemDamageType type)
  */
 void TerrainModifier::explode(const Position &center, int power, ItemDamageType type, int maxRadius, BattleUnit *unit)
 {
+	// the tiles in the blasts, only they need to be detonated and refreshed
+	std::vector<Tile*> blasted;
+	std::queue<Blast> chain;
+
 	if (type == DT_AP)
 	{
+		Tile *tile = _save->getTile(Position(center.x/16, center.y/16, center.z/24));
+		if (tile)
+		{
+			blasted.push_back(tile);
+		}
+
 		int part = voxelCheck(center, unit);
 		if (part >= 0 && part <= 3)
 		{
+			MapData *objects[4] = { tile->getMapData(0), tile->getMapData(1), tile->getMapData(2), tile->getMapData(3) };
 			// power 25% to 75%
-			_save->getTile(Position(center.x/16, center.y/16, center.z/24))->damage(
-				part, (int)(RNG::generate(power/4, (power*3)/4)));
+			tile->damage(part, (int)(RNG::generate(power/4, (power*3)/4, RNG_COMBAT)));
+			addChainedBlasts(tile, objects, &chain);
 		}
 		else if (part == 4)
 		{
 			// power 0 - 200%
-			_save->getTile(Position(center.x/16, center.y/16, center.z/24))->getUnit()->damage(
-				Position(center.x%16, center.y%16, center.z%24), RNG::generate(0, power*2));
+			tile->getUnit()->damage(Position(center.x%16, center.y%16, center.z%24), RNG::generate(0, power*2, RNG_COMBAT));
 		}
 	}
 	else
 	{
-		double centerZ = (int)(center.z / 24) + 0.5;
-		double centerX = (int)(center.x / 16) + 0.5;
-		double centerY = (int)(center.y / 16) + 0.5;
-		int power_;
+		Blast blast = { Position(center.x / 16, center.y / 16, center.z / 24), power, type };
+		chain.push(blast);
+	}
 
-		if (type == DT_IN)
+	// every type of explosion has its own kernel, so the type is only looked at once per blast
+	while (!chain.empty())
+	{
+		switch (chain.front().type)
 		{
-			power /= 2;
+		case DT_HE:
+			spreadBlast<DT_HE>(chain.front(), maxRadius, &blasted, &chain);
+			break;
+		case DT_SMOKE:
+			spreadBlast<DT_SMOKE>(chain.front(), maxRadius, &blasted, &chain);
+			break;
+		case DT_IN:
+			spreadBlast<DT_IN>(chain.front(), maxRadius, &blasted, &chain);
+			break;
+		case DT_NONE:
+			spreadBlast<DT_NONE>(chain.front(), maxRadius, &blasted, &chain);
+			break;
+		case DT_STUN:
+			spreadBlast<DT_STUN>(chain.front(), maxRadius, &blasted, &chain);
+			break;
+		default:
+			// the other types are all blocked alike and have no effect on the tiles
+			spreadBlast<DT_AP>(chain.front(), maxRadius, &blasted, &chain);
+			break;
 		}
+		chain.pop();
+	}
 
-		// raytrace every 3 degrees makes sure we cover all tiles in a circle.
-		for (double te = 0; te <= 360; te += 3)
-		{
-			double cos_te = cos(te * M_PI / 180.0);
-			double sin_te = sin(te * M_PI / 180.0);
+	// a tile can be in more than one blast of a chain
+	std::sort(blasted.begin(), blasted.end());
+	blasted.erase(std::unique(blasted.begin(), blasted.end()), blasted.end());
 
-			Tile *origin = _save->getTile(center);
-			double l = 0;
-			double vx, vy, vz;
-			int tileX, tileY, tileZ;
-			power_ = power;
+	if (blasted.empty())
+		return;
 
-			while (power_ > 0 && l <= maxRadius)
-			{
-				vx = centerX + l * cos_te;
-				vy = centerY + l * sin_te;
-				vz = centerZ;
+	// the terrain could have changed, so units that see the blast area need a fresh field of view
+	int minX = _save->getWidth(), minY = _save->getLength(), maxX = -1, maxY = -1;
+	for (std::vector<Tile*>::iterator i = blasted.begin(); i != blasted.end(); i++)
+	{
+		minX = std::min(minX, (*i)->getPosition().x);
+		minY = std::min(minY, (*i)->getPosition().y);
+		maxX = std::max(maxX, (*i)->getPosition().x);
+		maxY = std::max(maxY, (*i)->getPosition().y);
+	}
+	Position blastCenter((minX + maxX) / 2, (minY + maxY) / 2, 0);
+	int radius = (std::max(maxX - minX, maxY - minY) + 1) / 2;
+	invalidateFOV(blastCenter, radius);
 
-				tileZ = int(floor(vz));
-				tileX = int(floor(vx));
-				tileY = int(floor(vy));
+	// recalculate line of sight of units in range
+	calculateFOV(blastCenter, radius);
+	calculateTerrainLighting(blasted); // fires could have been started
+}
 
-				Tile *dest = _save->getTile(Position(tileX, tileY, tileZ));
-				if (!dest) break; // out of map!
+/**
+ * Spreads one explosion of a chain over the map. The explosion spreads from tile to tile, strongest first,
+ * so every tile is reached once, with the most power that gets there: power goes down by 10 for every tile
+ * crossed (15 diagonally) and by the blockage of the walls, floors and objects on the way.
+ * HE destroys an object if its armor is lower than the explosive power, then it's HE blockage is applied for further propagation.
+ * The damage type is a template parameter, so every type gets a kernel of its own with the checks of
+ * the type folded away, and the blockage lookups inlined for its channel.
+ * @param blast Center tile and power of the explosion.
+ * @param maxRadius
+ * @param blasted The tiles the explosion reaches are added here.
+ * @param chain The explosions of the objects that get destroyed are added here.
+ */
+template <ItemDamageType type> void TerrainModifier::spreadBlast(const Blast &blast, int maxRadius, std::vector<Tile*> *blasted, std::queue<Blast> *chain)
+{
+	const Position &centerTile = blast.center;
+	int power = blast.power;
+	size_t first = blasted->size();
 
-				// horizontal blockage by walls
-				power_ -= horizontalBlockage(origin, dest, type);
+	if (type == DT_IN)
+	{
+		power /= 2;
+	}
 
-				if (power_ > 0)
-				{
-					if (type == DT_HE)
-					{
-						// explosives do 1/2 damage to terrain and 1/2 up to 3/2 random damage to units
-						dest->setExplosive(power_ / 2);
-						// power 50 - 150%
-						if (dest->getUnit())
-							dest->getUnit()->damage(Position(0, 0, 0), (int)(RNG::generate(power_/2.0, power_*1.5)));
-
-						// TODO: destroy floors above
-				
-					}
-					if (type == DT_SMOKE)
-					{
-						// smoke from explosions always stay 15 to 20 turns
-						if (dest->getSmoke() < 10)
-						{
-							dest->addSmoke(RNG::generate(15, 20));
-						}
-					}
-					if (type == DT_IN)
-					{
-						if (dest->getFire() == 0)
-						{
-							dest->ignite();
-						}
-					}
-				}
+	// tiles waiting to be reached, strongest first, and the most power that can reach them so far
+	std::priority_queue<std::pair<int, int> > open;
+	std::map<int, int> reached;
+	std::set<int> done;
 
-				power_ -= 10; // explosive damage decreases by 10
+	if (_save->getTile(centerTile) && power > 0)
+	{
+		open.push(std::make_pair(power, _save->getTileIndex(centerTile)));
+		reached[open.top().second] = power;
+	}
 
-				// objects on destination tile affect the ray after it has crossed this tile
-				// but it has to be calculated before we affect the tile (it could have been blown up)
-				if (dest->getMapData(O_OBJECT))
-				{
-					power_ -= dest->getMapData(O_OBJECT)->getBlock(type);
-				}
-				origin = dest;
-				l++;
+	while (!open.empty())
+	{
+		int power_ = open.top().first;
+		int index = open.top().second;
+		open.pop();
+
+		if (power_ < reached[index] || !done.insert(index).second)
+			continue;
+
+		Tile *dest = _save->getTiles()[index];
+		blasted->push_back(dest);
+
+		// objects on destination tile affect the explosion after it has crossed this tile
+		// but it has to be calculated before we affect the tile (it could have been blown up)
+		int leaving = power_ - 10 - _save->getTerrainBlock<type>(_save->getTileObject(index, O_OBJECT));
+
+		if (type == DT_HE)
+		{
+			// explosives do 1/2 damage to terrain and 1/2 up to 3/2 random damage to units
+			dest->setExplosive(power_ / 2);
+			// power 50 - 150%
+			if (dest->getUnit())
+				dest->getUnit()->damage(Position(0, 0, 0), (int)(RNG::generate(power_/2.0, power_*1.5, RNG_COMBAT)));
+		}
+		if (type == DT_SMOKE)
+		{
+			// smoke from explosions always stay 15 to 20 turns
+			if (dest->getSmoke() < 10)
+			{
+				dest->addSmoke(RNG::generate(15, 20, RNG_COMBAT));
+			}
+		}
+		if (type == DT_IN)
+		{
+			if (dest->getFire() == 0)
+			{
+				dest->ignite();
 			}
 		}
 
-		// indicate we have finished recalculating
-		if (type == DT_HE)
+		if (leaving <= 0)
+			continue;
+
+		// spread to the 8 tiles around, and for HE through the floors to the levels above and below
+		for (int direction = 0; direction < (type == DT_HE ? 10 : 8); direction++)
 		{
-			for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
+			Position next = dest->getPosition();
+			int power2 = leaving;
+			if (direction < 8)
+			{
+				Position vector;
+				Pathfinding::directionToVector(direction, &vector);
+				next += vector;
+				if (direction & 1)
+				{
+					power2 -= 5;
+				}
+			}
+			else
 			{
-				_save->getTiles()[i]->detonate();
+				next.z += (direction == 8) ? 1 : -1;
+			}
+
+			int dx = next.x - centerTile.x, dy = next.y - centerTile.y, dz = next.z - centerTile.z;
+			if (dx * dx + dy * dy > maxRadius * maxRadius || abs(dz) > maxRadius)
+				continue;
+
+			Tile *nextTile = _save->getTile(next);
+			if (!nextTile)
+				continue; // out of map!
+
+			if (direction < 8)
+			{
+				power2 -= horizontalBlockage<type>(dest, nextTile);
+			}
+			else
+			{
+				power2 -= verticalBlockage<type>(dest, nextTile);
+			}
+
+			int nextIndex = _save->getTileIndex(next);
+			if (power2 > 0 && !done.count(nextIndex) && (reached.find(nextIndex) == reached.end() || reached[nextIndex] < power2))
+			{
+				reached[nextIndex] = power2;
+				open.push(std::make_pair(power2, nextIndex));
 			}
 		}
 	}
 
-	// recalculate line of sight (to optimise: only units in range)
-	calculateFOV(center);
-	calculateTerrainLighting(); // fires could have been started
+	// indicate we have finished recalculating
+	if (type == DT_HE)
+	{
+		for (std::vector<Tile*>::iterator i = blasted->begin() + first; i != blasted->end(); i++)
+		{
+			MapData *objects[4] = { (*i)->getMapData(0), (*i)->getMapData(1), (*i)->getMapData(2), (*i)->getMapData(3) };
+			(*i)->detonate();
+			addChainedBlasts(*i, objects, chain);
+		}
+	}
+}
+
+/**
+ * Adds the explosions of the objects of a tile that just got destroyed to a chain of explosions.
+ * @param tile
+ * @param objects The objects of the tile before it got damaged.
+ * @param chain
+ */
+void TerrainModifier::addChainedBlasts(Tile *tile, MapData *const objects[4], std::queue<Blast> *chain)
+{
+	for (int part = 0; part < 4; part++)
+	{
+		if (objects[part] && objects[part]->getExplosive() > 0 && tile->getMapData(part) != objects[part])
+		{
+			Blast blast = { tile->getPosition(), objects[part]->getExplosive(), objects[part]->getExplosiveType() };
+			chain->push(blast);
+		}
+	}
 }
 
 /**
@@ -556,10 +1060,10 @@ void TerrainModifier::explode(const Position &center, int power, ItemDamageType
  * Can cross more than one level. Only floor tiles are taken into account.
  * @param startTile
  * @param endTile
- * @param affector
+ * @tparam type Damage type.
  * @return amount of blockage
  */
-int TerrainModifier::verticalBlockage(Tile *startTile, Tile *endTile, ItemDamageType type)
+template <ItemDamageType type> int TerrainModifier::verticalBlockage(Tile *startTile, Tile *endTile)
 {
 	int block = 0;
 
@@ -574,14 +1078,14 @@ int TerrainModifier::verticalBlockage(Tile *startTile, Tile *endTile, ItemDamage
 	{
 		for (int z = startTile->getPosition().z; z > endTile->getPosition().z; z--)
 		{
-			block += blockage(_save->getTile(Position(x, y, z)), O_FLOOR, type);
+			block += blockage<type>(_save->getTile(Position(x, y, z)), O_FLOOR);
 		}
 	}
 	else if (direction > 0) // up
 	{
 		for (int z = startTile->getPosition().z + 1; z <= endTile->getPosition().z; z++)
 		{
-			block += blockage(_save->getTile(Position(x, y, z)), O_FLOOR, type);
+			block += blockage<type>(_save->getTile(Position(x, y, z)), O_FLOOR);
 		}
 	}
 
@@ -592,10 +1096,10 @@ int TerrainModifier::verticalBlockage(Tile *startTile, Tile *endTile, ItemDamage
  * The amount of power that is blocked going from one tile to another on the same level.
  * @param startTile
  * @param endTile
- * @param affector
+ * @tparam type Damage type.
  * @return amount of blockage
  */
-int TerrainModifier::horizontalBlockage(Tile *startTile, Tile *endTile, ItemDamageType type)
+template <ItemDamageType type> int TerrainModifier::horizontalBlockage(Tile *startTile, Tile *endTile)
 {
 	// safety check
 	if (startTile == 0 || endTile == 0) return 0;
@@ -606,36 +1110,36 @@ int TerrainModifier::horizontalBlockage(Tile *startTile, Tile *endTile, ItemDama
 	switch(direction)
 	{
 	case 0:	// north
-		return blockage(startTile, O_NORTHWALL, type);
+		return blockage<type>(startTile, O_NORTHWALL);
 		break;
 	case 1: // north east
-		return (blockage(startTile,O_NORTHWALL, type) + blockage(endTile,O_WESTWALL, type))/2
-			+ (blockage(_save->getTile(startTile->getPosition() + Position(1, 0, 0)),O_WESTWALL, type)
-			+ blockage(_save->getTile(startTile->getPosition() + Position(1, 0, 0)),O_NORTHWALL, type))/2;
+		return (blockage<type>(startTile, O_NORTHWALL) + blockage<type>(endTile, O_WESTWALL))/2
+			+ (blockage<type>(_save->getTile(startTile->getPosition() + Position(1, 0, 0)), O_WESTWALL)
+			+ blockage<type>(_save->getTile(startTile->getPosition() + Position(1, 0, 0)), O_NORTHWALL))/2;
 		break;
 	case 2: // east
-		return blockage(endTile,O_WESTWALL, type);
+		return blockage<type>(endTile, O_WESTWALL);
 		break;
 	case 3: // south east
-		return (blockage(endTile,O_WESTWALL, type) + blockage(endTile,O_NORTHWALL, type))/2
-			+ (blockage(_save->getTile(startTile->getPosition() + Position(1, 0, 0)),O_WESTWALL, type)
-			+ blockage(_save->getTile(startTile->getPosition() + Position(0, -1, 0)),O_NORTHWALL, type))/2;
+		return (blockage<type>(endTile, O_WESTWALL) + blockage<type>(endTile, O_NORTHWALL))/2
+			+ (blockage<type>(_save->getTile(startTile->getPosition() + Position(1, 0, 0)), O_WESTWALL)
+			+ blockage<type>(_save->getTile(startTile->getPosition() + Position(0, -1, 0)), O_NORTHWALL))/2;
 		break;
 	case 4: // south
-		return blockage(endTile,O_NORTHWALL, type);
+		return blockage<type>(endTile, O_NORTHWALL);
 		break;
 	case 5: // south west
-		return (blockage(endTile,O_NORTHWALL, type) + blockage(startTile,O_WESTWALL, type))/2
-			+ (blockage(_save->getTile(startTile->getPosition() + Position(0, -1, 0)),O_WESTWALL, type)
-			+ blockage(_save->getTile(startTile->getPosition() + Position(0, -1, 0)),O_NORTHWALL, type))/2;
+		return (blockage<type>(endTile, O_NORTHWALL) + blockage<type>(startTile, O_WESTWALL))/2
+			+ (blockage<type>(_save->getTile(startTile->getPosition() + Position(0, -1, 0)), O_WESTWALL)
+			+ blockage<type>(_save->getTile(startTile->getPosition() + Position(0, -1, 0)), O_NORTHWALL))/2;
 		break;
 	case 6: // west
-		return blockage(startTile,O_WESTWALL, type);
+		return blockage<type>(startTile, O_WESTWALL);
 		break;
 	case 7: // north west
-		return (blockage(startTile,O_WESTWALL, type) + blockage(startTile,O_NORTHWALL, type))/2
-			+ (blockage(_save->getTile(startTile->getPosition() + Position(0, 1, 0)),O_WESTWALL, type)
-			+ blockage(_save->getTile(startTile->getPosition() + Position(-1, 0, 0)),O_NORTHWALL, type))/2;
+		return (blockage<type>(startTile, O_WESTWALL) + blockage<type>(startTile, O_NORTHWALL))/2
+			+ (blockage<type>(_save->getTile(startTile->getPosition() + Position(0, 1, 0)), O_WESTWALL)
+			+ blockage<type>(_save->getTile(startTile->getPosition() + Position(-1, 0, 0)), O_NORTHWALL))/2;
 		break;
 	}
 
@@ -649,14 +1153,10 @@ int TerrainModifier::horizontalBlockage(Tile *startTile, Tile *endTile, ItemDama
  */
 int TerrainModifier::vectorToDirection(const Position &vector)
 {
-	int x[8] = {0, 1, 1, 1, 0, -1, -1, -1};
-	int y[8] = {1, 1, 0, -1, -1, -1, 0, 1};
-	for (int i=0;i<9;i++)
-	{
-		if (x[i] == vector.x && y[i] == vector.y)
-			return i;
-	}
-	return -1;
+	static const int directions[3][3] = {{5, 6, 7}, {4, -1, 0}, {3, 2, 1}};
+	if (vector.x < -1 || vector.x > 1 || vector.y < -1 || vector.y > 1)
+		return -1;
+	return directions[vector.x + 1][vector.y + 1];
 }
 
 /**
@@ -724,14 +1224,16 @@ int TerrainModifier::unitOpensDoor(BattleUnit *unit)
 
 	if (door == 0 || door == 1)
 	{
-		_save->getTerrainModifier()->calculateFOV(tile->getPosition());
+		// doors (and their adjacent doors) are within 2 tiles of the unit
+		invalidateFOV(unit->getPosition(), 2);
+		calculateFOV(unit->getPosition(), 2);
 	}
 
 	return door;
 }
 
 /**
- * calculateLine. Using bresenham algorithm in 3D.
+ * calculateLine. Walks a VoxelLine (bresenham algorithm in 3D) up to what it hits.
  * @param origin
  * @param target
  * @param storeTrajectory true will store the whole trajectory - otherwise it just stores the last position.
@@ -739,98 +1241,218 @@ int TerrainModifier::unitOpensDoor(BattleUnit *unit)
  */
 int TerrainModifier::calculateLine(const Position& origin, const Position& target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit)
 {
-	int x, x0, x1, delta_x, step_x;
-    int y, y0, y1, delta_y, step_y;
-    int z, z0, z1, delta_z, step_z;
-    int swap_xy, swap_xz;
-    int drift_xy, drift_xz;
-    int cx, cy, cz;
-
-    //start and end points
-    x0 = origin.x;     x1 = target.x;
-    y0 = origin.y;     y1 = target.y;
-    z0 = origin.z;     z1 = target.z;
-    
-    //'steep' xy Line, make longest delta x plane  
-    swap_xy = abs(y1 - y0) > abs(x1 - x0);
-    if (swap_xy)
-	{
-        std::swap(x0, y0);
-        std::swap(x1, y1);
-	}
-                
-    //do same for xz
-    swap_xz = abs(z1 - z0) > abs(x1 - x0);
-    if (swap_xz)
-	{
-        std::swap(x0, z0);
-		std::swap(x1, z1);
-	}
-    
-    //delta is Length in each plane
-    delta_x = abs(x1 - x0);
-    delta_y = abs(y1 - y0);
-    delta_z = abs(z1 - z0);
-    
-    //drift controls when to step in 'shallow' planes
-    //starting value keeps Line centred
-    drift_xy  = (delta_x / 2);
-    drift_xz  = (delta_x / 2);
-    
-    //direction of line
-	step_x = 1;  if (x0 > x1) {  step_x = -1; }
-	step_y = 1;  if (y0 > y1) {  step_y = -1; }
-	step_z = 1;  if (z0 > z1) {  step_z = -1; }
-    
-    //starting point
-    y = y0;
-    z = z0;
-    
-    //step through longest delta (which we have swapped to x)
-    for (x = x0; x != x1; x += step_x)
-	{
-        //copy position
-        cx = x;    cy = y;    cz = z;
-
-        //unswap (in reverse)
-        if (swap_xz) std::swap(cx, cz);
-        if (swap_xy) std::swap(cx, cy);
-        
+	VoxelLine line(this, origin, target, excludeUnit);
+	Position voxel;
+	while (line.next(&voxel))
+	{
 		if (storeTrajectory)
 		{
-			trajectory->push_back(Position(cx, cy, cz));
+			trajectory->push_back(voxel);
 		}
-        //passes through this point?
-		int result = voxelCheck(Position(cx, cy, cz), excludeUnit);
-		if (result != -1)
+	}
+	if (line.getResult() != -1 && !storeTrajectory && trajectory != 0)
+	{ // store the position of impact
+		trajectory->push_back(voxel);
+	}
+	return line.getResult();
+}
+
+/**
+ * Calculate a line of sight between two voxels, without storing the trajectory. The results are kept for the
+ * current turn, until the terrain version goes up (terrain destroyed, doors changed or units moved), so units
+ * looking at each other again, for example after turning, don't trace the same lines again.
+ * @param origin
+ * @param target
+ * @return the objectnumber(0-3) or unit(4) or out of map (5) or -1(hit nothing)
+ */
+int TerrainModifier::calculateSightLine(const Position& origin, const Position& target)
+{
+	std::vector<std::pair<Position, Position> > lines(1, std::make_pair(origin, target));
+	std::vector<int> results;
+	calculateSightLines(lines, &results);
+	return results[0];
+}
+
+/**
+ * Calculate several lines of sight, using the results of earlier calls like calculateSightLine does.
+ * The lines that aren't known yet are cast together.
+ * @param lines origin and target voxel of every line.
+ * @param results what every line hit is stored here, see calculateLine.
+ */
+void TerrainModifier::calculateSightLines(const std::vector<std::pair<Position, Position> > &lines, std::vector<int> *results)
+{
+	if (_sightLinesTurn != _save->getTurn() || _sightLinesVersion != _save->getTerrainVersion())
+	{
+		_sightLines.clear();
+		_sightLinesTurn = _save->getTurn();
+		_sightLinesVersion = _save->getTerrainVersion();
+	}
+
+	results->assign(lines.size(), -1);
+	std::vector<std::pair<int, int> > keys;
+	std::vector<std::pair<Position, Position> > unknown;
+	std::vector<size_t> unknownIndex;
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		const Position &origin = lines[i].first, &target = lines[i].second;
+		// voxel coordinates fit in 11 bits for x, 12 for y and 8 for z
+		std::pair<int, int> key((origin.x << 20) | (origin.y << 8) | origin.z, (target.x << 20) | (target.y << 8) | target.z);
+		std::map<std::pair<int, int>, int>::iterator j = _sightLines.find(key);
+		if (j != _sightLines.end())
 		{
-			if (!storeTrajectory && trajectory != 0)
-			{ // store the position of impact
-				trajectory->push_back(Position(cx, cy, cz));
-			}
-			return result;
+			(*results)[i] = j->second;
 		}
-        
-        //update progress in other planes
-        drift_xy = drift_xy - delta_y;
-        drift_xz = drift_xz - delta_z;
-
-        //step in y plane
-        if (drift_xy < 0)
+		else
 		{
-            y = y + step_y;
-            drift_xy = drift_xy + delta_x;
+			keys.push_back(key);
+			unknown.push_back(lines[i]);
+			unknownIndex.push_back(i);
 		}
-        
-        //same in z
-        if (drift_xz < 0)
+	}
+
+	std::vector<int> cast;
+	calculateLines(unknown, 0, &cast);
+	for (size_t i = 0; i < unknown.size(); i++)
+	{
+		(*results)[unknownIndex[i]] = cast[i];
+		_sightLines[keys[i]] = cast[i];
+	}
+}
+
+/**
+ * Gets the units that would have a line of sight to a unit if it stood at a certain position, so a move
+ * can be weighed before it's made. The unit isn't moved and the sight line cache isn't touched,
+ * so nothing of the battle changes and several of these can run at once on worker threads.
+ * @param unit Unit that would stand there.
+ * @param position Tile position to check.
+ * @param candidates Units that could be looking.
+ * @param spotters The candidates within view distance with a clear line are stored here.
+ */
+void TerrainModifier::getSpotters(BattleUnit *unit, const Position &position, const std::vector<BattleUnit*> &candidates, std::vector<BattleUnit*> *spotters)
+{
+	Tile *tile = _save->getTile(position);
+	if (tile == 0)
+		return;
+
+	Position targetVoxel((position.x * 16) + 8, (position.y * 16) + 8, position.z*24);
+	targetVoxel.z += -tile->getTerrainLevel();
+	targetVoxel.z += unit->isKneeled()?unit->getUnit()->getKneelHeight():unit->getUnit()->getStandHeight();
+
+	for (std::vector<BattleUnit*>::const_iterator i = candidates.begin(); i != candidates.end(); i++)
+	{
+		BattleUnit *bu = *i;
+		int dx = bu->getPosition().x - position.x, dy = bu->getPosition().y - position.y;
+		if (bu == unit || bu->isOut() || dx * dx + dy * dy > MAX_VIEW_DISTANCE * MAX_VIEW_DISTANCE)
+			continue;
+
+		Position originVoxel((bu->getPosition().x * 16) + 8, (bu->getPosition().y * 16) + 8, bu->getPosition().z*24);
+		originVoxel.z += -_save->getTile(bu->getPosition())->getTerrainLevel();
+		originVoxel.z += bu->isKneeled()?bu->getUnit()->getKneelHeight():bu->getUnit()->getStandHeight();
+
+		// the line starts inside the unit that looks, so it's cast by itself, going through that unit
+		std::vector<std::pair<Position, Position> > line(1, std::make_pair(originVoxel, targetVoxel));
+		std::vector<int> result;
+		calculateLines(line, bu, &result);
+		if (result[0] == -1)
 		{
-            z = z + step_z;
-            drift_xz = drift_xz + delta_x;
+			spotters->push_back(bu);
 		}
 	}
+}
 
-	return -1;
+/**
+ * Casts several lines (bresenham algorithm in 3D) at once, the same way a VoxelLine walks one.
+ * RAY_LANES lines march in lockstep: every step the voxel each of them is at gets checked,
+ * then they all advance with the same branchless arithmetic, kept in arrays per axis so the
+ * compiler can vectorize it. Like a VoxelLine, the voxels are only checked in tiles that aren't empty.
+ * @param lines origin and target voxel of every line, the target isn't part of the line.
+ * @param excludeUnit unit the lines go through, like the one looking or firing.
+ * @param results what every line hit is stored here, see calculateLine.
+ */
+void TerrainModifier::calculateLines(const std::vector<std::pair<Position, Position> > &lines, BattleUnit *excludeUnit, std::vector<int> *results)
+{
+	results->assign(lines.size(), -1);
+	for (size_t first = 0; first < lines.size(); first += RAY_LANES)
+	{
+		int lanes = std::min((int)(lines.size() - first), RAY_LANES);
+		int voxel[3][RAY_LANES], step[3][RAY_LANES], delta[3][RAY_LANES], drift[3][RAY_LANES];
+		int length[RAY_LANES], left[RAY_LANES];
+		Position tilePosition[RAY_LANES];
+		bool emptyTile[RAY_LANES];
+		int active = 0;
+
+		for (int i = 0; i < lanes; i++)
+		{
+			const Position &origin = lines[first + i].first, &target = lines[first + i].second;
+			int from[3] = { origin.x, origin.y, origin.z };
+			int to[3] = { target.x, target.y, target.z };
+			// the longest axis steps every time, the others when their drift runs out
+			length[i] = 0;
+			for (int a = 0; a < 3; a++)
+			{
+				voxel[a][i] = from[a];
+				delta[a][i] = abs(to[a] - from[a]);
+				step[a][i] = (from[a] > to[a]) ? -1 : 1;
+				length[i] = std::max(length[i], delta[a][i]);
+			}
+			//starting value keeps Line centred
+			for (int a = 0; a < 3; a++)
+			{
+				drift[a][i] = length[i] / 2;
+			}
+			left[i] = length[i];
+			tilePosition[i] = Position(-1, -1, -1);
+			emptyTile[i] = false;
+			if (left[i] > 0)
+			{
+				active++;
+			}
+		}
+
+		while (active > 0)
+		{
+			// passes through these points?
+			for (int i = 0; i < lanes; i++)
+			{
+				if (left[i] == 0)
+					continue;
+				Position position(voxel[0][i], voxel[1][i], voxel[2][i]);
+				Position tile(position.x / 16, position.y / 16, position.z / 24);
+				if (tile != tilePosition[i])
+				{
+					tilePosition[i] = tile;
+					Tile *t = _save->getTile(tile);
+					emptyTile[i] = t != 0 && getVoxelSummary(t) == VOXELS_EMPTY && (t->getUnit() == 0 || t->getUnit() == excludeUnit);
+				}
+				int result = emptyTile[i] ? -1 : voxelCheck(position, excludeUnit);
+				if (result != -1)
+				{
+					(*results)[first + i] = result;
+					left[i] = 0;
+				}
+				else
+				{
+					left[i]--;
+				}
+				if (left[i] == 0)
+				{
+					active--;
+				}
+			}
+
+			// update progress in all planes, lines that are done just keep going
+			for (int a = 0; a < 3; a++)
+			{
+				for (int i = 0; i < lanes; i++)
+				{
+					drift[a][i] -= delta[a][i];
+					int carry = drift[a][i] < 0;
+					voxel[a][i] += carry * step[a][i];
+					drift[a][i] += carry * length[i];
+				}
+			}
+		}
+	}
 }
 
 /**
@@ -854,29 +1476,55 @@ int TerrainModifier::voxelCheck(const Position& voxel, BattleUnit *excludeUnit)
 		{
 			int x = 15 - voxel.x%16;
 			int y = 15 - voxel.y%16;
-			int idx = (unit->getUnit()->gotLoftemps() * 16) + y;
-			if ((_voxelData->at(idx) & (1 << x))==(1 << x))
+			if (_lofts[unit->getUnit()->gotLoftemps() * 16 + y] & (1 << x))
 			{
 				return 4;
 			}
 		}
 	}
 
+	int index = _save->getTileIndex(tile->getPosition());
+	int x = 15 - voxel.x%16;
+	int y = 15 - voxel.y%16;
 	for (int i=0; i< 4; i++)
 	{
-		MapData *mp = tile->getMapData(i);
-		if (mp != 0)
+		if (_save->getTerrainLoft(_save->getTileObject(index, i), (voxel.z%24)/2)[y] & (1 << x))
 		{
-			int x = 15 - voxel.x%16;
-			int y = 15 - voxel.y%16;
-			int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
-			if ((_voxelData->at(idx) & (1 << x))==(1 << x))
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Gets how much of a tile is filled by the voxels of its terrain objects, calculating it when it's not known.
+ * Only empty tiles are skipped by rays; in solid tiles the voxels are still checked, to know which part was hit and where.
+ * @param tile
+ * @return summary
+ */
+VoxelSummary TerrainModifier::getVoxelSummary(Tile *tile)
+{
+	if (tile->getVoxelSummary() != VOXELS_UNKNOWN)
+		return tile->getVoxelSummary();
+
+	int index = _save->getTileIndex(tile->getPosition());
+	bool empty = true, solid = true;
+	for (int layer = 0; layer < 12; layer++)
+	{
+		for (int y = 0; y < 16; y++)
+		{
+			Uint16 row = 0;
+			for (int i = 0; i < 4; i++)
 			{
-				return i;
+				row |= _save->getTerrainLoft(_save->getTileObject(index, i), layer)[y];
 			}
+			empty = empty && row == 0;
+			solid = solid && row == 0xFFFF;
 		}
 	}
-	return -1;
+
+	tile->setVoxelSummary(empty ? VOXELS_EMPTY : (solid ? VOXELS_SOLID : VOXELS_MIXED));
+	return tile->getVoxelSummary();
 }
 
 /**
@@ -907,7 +1555,11 @@ int TerrainModifier::closeUfoDoors()
 	// prepare a list of tiles on fire/smoke & close any ufo doors
 	for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
 	{
-		doorsclosed += _save->getTiles()[i]->closeUfoDoor();
+		if (_save->getTiles()[i]->closeUfoDoor())
+		{
+			doorsclosed++;
+			invalidateFOV(_save->getTiles()[i]->getPosition(), 0);
+		}
 	}
 
 	return doorsclosed;
@@ -922,17 +1574,29 @@ void TerrainModifier::prepareNewTurn()
 {
 	std::vector<Tile*> tilesOnFire;
 	std::vector<Tile*> tilesOnSmoke;
+	std::vector<Tile*> changed;
+	std::set<int> *activeTiles = _save->getActiveTiles();
 	
-	// prepare a list of tiles on fire/smoke & close any ufo doors
-	for (int i = 0; i < _save->getWidth() * _save->getLength() * _save->getHeight(); i++)
+	// prepare a list of tiles on fire/smoke, before anything spreads, so new fires only spread next turn
+	// only the tiles that burned or smoked can still do so, the others are dropped from the active ones
+	for (std::set<int>::iterator i = activeTiles->begin(); i != activeTiles->end();)
 	{
-		if (_save->getTiles()[i]->getFire() > 0)
+		Tile *tile = _save->getTiles()[*i];
+		if (tile->getFire() > 0)
+		{
+			tilesOnFire.push_back(tile);
+		}
+		if (tile->getSmoke() > 0)
 		{
-			tilesOnFire.push_back(_save->getTiles()[i]);
+			tilesOnSmoke.push_back(tile);
 		}
-		if (_save->getTiles()[i]->getSmoke() > 0)
+		if (tile->getFire() == 0 && tile->getSmoke() == 0)
+		{
+			activeTiles->erase(i++);
+		}
+		else
 		{
-			tilesOnSmoke.push_back(_save->getTiles()[i]);
+			++i;
 		}
 	}
 
@@ -953,19 +1617,20 @@ void TerrainModifier::prepareNewTurn()
 				if (t && t->getFire() == 0)
 				{
 					// check adjacent tiles - if they have a flammability of < 255, there is a chance...
-					if (horizontalBlockage((*i), t, DT_IN) == 0)
+					if (horizontalBlockage<DT_IN>((*i), t) == 0)
 					{
 						int flam = t->getFlammability();
 						if (flam < 255)
 						{
-							double base = RNG::boxMuller(0,126);
+							double base = RNG::boxMuller(0, 126, RNG_COMBAT);
 							if (base < 0) base *= -1;
 						
 							if (flam < base)
 							{
-								if (RNG::generate(0, flam) < 2)
+								if (RNG::generate(0, flam, RNG_COMBAT) < 2)
 								{
 									t->ignite();
+									changed.push_back(t);
 								}
 							}
 						}
@@ -974,12 +1639,15 @@ void TerrainModifier::prepareNewTurn()
 			}
 		}
 
+		// burning objects can be destroyed
 		(*i)->prepareNewTurn();
+		invalidateFOV((*i)->getPosition(), 0);
+		changed.push_back(*i);
 	}
 
 	if (tilesOnFire.size() > 0)
 	{
-		calculateTerrainLighting(); // fires could have been stopped
+		calculateTerrainLighting(changed); // fires could have been started or stopped
 	}
 
 }
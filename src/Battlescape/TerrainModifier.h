@@ -20,10 +20,21 @@
 #define OPENXCOM_TERRAINMODIFIER_H
 
 #include <vector>
+#include <map>
+#include <queue>
 #include "Position.h"
 #include "../Ruleset/MapData.h"
+#include "../Savegame/Tile.h"
 #include "SDL.h"
 
+#define MAX_VIEW_DISTANCE 20
+#define FOV_PITCHES 26
+#define RAY_HEADINGS 121
+#define FOV_HEADINGS 31
+#define FOV_TURN_HEADINGS 15
+#define FOV_THREADS 4
+#define RAY_LANES 8
+
 namespace OpenXcom
 {
 
@@ -38,19 +49,73 @@ class Tile;
  */
 class TerrainModifier
 {
+	friend class VoxelLine;
 private:
+	/// Tile offset of one step along a ray, relative to the tile the ray started in.
+	struct RayStep
+	{
+		Sint8 x, y, z;
+	};
+	/// A light on the map: a lit terrain object, a fire or a unit.
+	struct LightSource
+	{
+		Position position;
+		int power;
+	};
+	static bool lightSourceLess(const LightSource &a, const LightSource &b);
+	/// Light a source of a certain power gives to the tiles around it.
+	struct LightStencil
+	{
+		int power;
+		std::vector<int> halfWidths;
+		std::vector<Sint8> light;
+	};
+	static std::vector<LightStencil> _lightStencils;
+	static const LightStencil &getLightStencil(int power);
+	static RayStep _fovRays[FOV_PITCHES][RAY_HEADINGS][MAX_VIEW_DISTANCE];
+	static bool _raysBuilt;
+	static void buildRays();
+	/// Part of a batch of field of view calculations, traced by one worker thread.
+	struct FOVPart
+	{
+		TerrainModifier *terrain;
+		std::vector<BattleUnit*> *units;
+		std::vector<int> *turns;
+		int first, step;
+		std::vector<int> checked;
+		std::vector<Tile*> discovered;
+	};
+	static int traceFOVPart(void *data);
+	/// An explosion waiting to go off, in a chain of explosions.
+	struct Blast
+	{
+		Position center;
+		int power;
+		ItemDamageType type;
+	};
+	template <ItemDamageType type> void spreadBlast(const Blast &blast, int maxRadius, std::vector<Tile*> *blasted, std::queue<Blast> *chain);
+	void addChainedBlasts(Tile *tile, MapData *const objects[4], std::queue<Blast> *chain);
 	SavedBattleGame *_save;
-	std::vector<Uint16> *_voxelData;
-	void addLight(const Position &center, int power, int layer);
-	int blockage(Tile *tile, const int part, ItemDamageType type);
-	int horizontalBlockage(Tile *startTile, Tile *endTile, ItemDamageType type);
-	int verticalBlockage(Tile *startTile, Tile *endTile, ItemDamageType type);
+	const Uint16 *_lofts;
+	int _skippedFOV;
+	std::map<std::pair<int, int>, int> _sightLines;
+	int _sightLinesTurn, _sightLinesVersion;
+	std::vector<LightSource> _lightSources[LIGHTLAYERS];
+	void addLight(const Position &center, int power, int layer, const std::vector<bool> *columns = 0);
+	void updateLight(int layer, std::vector<LightSource> *sources);
+	void addTerrainLightSources(Tile *tile, std::vector<LightSource> *sources);
+	template <ItemDamageType type> int blockage(Tile *tile, const int part);
+	template <ItemDamageType type> int horizontalBlockage(Tile *startTile, Tile *endTile);
+	template <ItemDamageType type> int verticalBlockage(Tile *startTile, Tile *endTile);
 	int vectorToDirection(const Position &vector);
 	int voxelCheck(const Position& voxel, BattleUnit *excludeUnit);
-	bool checkForVisibleUnits(BattleUnit *unit, Tile *tile);
+	VoxelSummary getVoxelSummary(Tile *tile);
+	void checkForVisibleUnits(BattleUnit *unit);
+	void turnFOV(BattleUnit *unit, int turn);
+	void traceFOV(BattleUnit *unit, int turn, std::vector<int> *checked, std::vector<Tile*> *discovered);
 public:
 	/// Creates a new TerrainModifier class.
-	TerrainModifier(SavedBattleGame *save, std::vector<Uint16> *voxelData);
+	TerrainModifier(SavedBattleGame *save, const Uint16 *lofts);
 	/// Cleans up the TerrainModifier.
 	~TerrainModifier();
 	/// Calculate sun shading of the whole map.
@@ -59,10 +124,18 @@ public:
 	void calculateSunShading(Tile *tile);
 	/// Calculate the visible tiles of a unit.
 	void calculateFOV(BattleUnit *unit);
+	/// Calculate the visible tiles of several units, in parallel.
+	void calculateFOV(std::vector<BattleUnit*> *units, int threads = FOV_THREADS);
 	/// Calculate the field of view within range of a certain position.
-	void calculateFOV(const Position &position);
+	void calculateFOV(const Position &position, int radius = 0);
+	/// Get the number of units skipped by the last field of view calculation around a position.
+	int getSkippedFOV() const;
+	/// Invalidate the cached field of view of units that can see a certain area.
+	void invalidateFOV(const Position &position, int radius);
 	/// Recalculate lighting of the battlescape.
 	void calculateTerrainLighting();
+	/// Recalculate lighting of the battlescape, when only some tiles changed.
+	void calculateTerrainLighting(const std::vector<Tile*> &tiles);
 	/// Recalculate lighting of the battlescape.
 	void calculateUnitLighting();
 	/// Explosions.
@@ -71,8 +144,16 @@ public:
 	int unitOpensDoor(BattleUnit *unit);
 	/// Close ufo doors.
 	int closeUfoDoors();
-	/// Calculate line.
+	/// Calculate line, storing the voxels of the trajectory or where it hit.
 	int calculateLine(const Position& origin, const Position& target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit);
+	/// Calculate a line of sight, using the results of earlier calls.
+	int calculateSightLine(const Position& origin, const Position& target);
+	/// Calculate several lines of sight at once, using the results of earlier calls.
+	void calculateSightLines(const std::vector<std::pair<Position, Position> > &lines, std::vector<int> *results);
+	/// Calculate several lines at once, storing what each of them hit.
+	void calculateLines(const std::vector<std::pair<Position, Position> > &lines, BattleUnit *excludeUnit, std::vector<int> *results);
+	/// Get the units that would see a unit if it stood somewhere else.
+	void getSpotters(BattleUnit *unit, const Position &position, const std::vector<BattleUnit*> &candidates, std::vector<BattleUnit*> *spotters);
 	/// Add item & affect with gravity.
 	void spawnItem(const Position &position, BattleItem *item);
 	/// New turn preparations.
@@ -74,11 +74,11 @@ void UnitFallBState::init()
 		{
 			if (s->getGender() == GENDER_MALE)
 			{
-				_parent->getGame()->getResourcePack()->getSoundSet("BATTLE.CAT")->getSound(RNG::generate(41,43))->play();
+				_parent->getGame()->getResourcePack()->getSoundSet("BATTLE.CAT")->getSound(RNG::generate(41, 43, RNG_COSMETIC))->play();
 			}
 			else
 			{
-				_parent->getGame()->getResourcePack()->getSoundSet("BATTLE.CAT")->getSound(RNG::generate(44,46))->play();
+				_parent->getGame()->getResourcePack()->getSoundSet("BATTLE.CAT")->getSound(RNG::generate(44, 46, RNG_COSMETIC))->play();
 			}
 		}
 		else
@@ -110,6 +110,8 @@ void UnitFallBState::think()
 	{
 		_unit->keepFalling();
 		TerrainModifier *terrain = _parent->getGame()->getSavedGame()->getBattleGame()->getTerrainModifier();
+		// the unit doesn't see anything anymore
+		_parent->getGame()->getSavedGame()->getBattleGame()->setVisibleTilesDirty(_unit->getFaction());
 		convertUnitToCorpse(_unit, terrain);
 		terrain->calculateUnitLighting();
 		_parent->getMap()->cacheTileSprites();
@@ -137,7 +139,8 @@ std::string UnitFallBState::getResult() const
 
 void UnitFallBState::convertUnitToCorpse(BattleUnit *unit, TerrainModifier *terrain)
 {
-	terrain->spawnItem(_unit->getPosition(), new BattleItem(_parent->getGame()->getRuleset()->getItem(_unit->getUnit()->getArmor()->getCorpseItem())));
+	SavedBattleGame *save = _parent->getGame()->getSavedGame()->getBattleGame();
+	terrain->spawnItem(_unit->getPosition(), save->createItem(_parent->getGame()->getRuleset()->getItem(_unit->getUnit()->getArmor()->getCorpseItem())));
 }
 
 }
@@ -40,7 +40,7 @@ namespace OpenXcom
  * @param x X position in pixels.
  * @param y Y position in pixels.
  */
-UnitSprite::UnitSprite(int width, int height, int x, int y) : Surface(width, height, x, y), _unit(0), _item(0)
+UnitSprite::UnitSprite(int width, int height, int x, int y) : Surface(width, height, x, y), _unit(0), _soldier(0), _item(0)
 {
 
 
@@ -71,6 +71,7 @@ void UnitSprite::setSurfaces(SurfaceSet *unitSurface, SurfaceSet *itemSurface)
 void UnitSprite::setBattleUnit(BattleUnit *unit)
 {
 	_unit = unit;
+	_soldier = dynamic_cast<Soldier*>(_unit->getUnit());
 }
 
 /**
@@ -82,6 +83,53 @@ void UnitSprite::setBattleItem(BattleItem *item)
 	_item = item;
 }
 
+/**
+ * Packs everything draw() looks at into a single number, so
+ * two unit/item combinations with the same key render the same frame
+ * from the same surfacesets. State that doesn't change the frame is left
+ * out so the number of distinct keys stays small.
+ * @return Frame key, always positive.
+ */
+int UnitSprite::getFrameKey() const
+{
+	if (_unit->isOut())
+	{
+		return 0;
+	}
+	int status = _unit->getStatus();
+	if (status == STATUS_FALLING)
+	{
+		return 1 | (_unit->getFallingPhase() << 1);
+	}
+	// turning is drawn like standing, aiming only shows with an item
+	if (status == STATUS_TURNING || (status == STATUS_AIMING && !_item))
+	{
+		status = STATUS_STANDING;
+	}
+	Soldier *soldier = _soldier;
+	int key = 2;
+	key |= _unit->getDirection() << 2;
+	key |= status << 5;
+	if (status == STATUS_WALKING)
+	{
+		key |= _unit->getWalkingPhase() << 8;
+	}
+	if (_unit->isKneeled())
+	{
+		key |= 1 << 11;
+	}
+	if (soldier != 0 && soldier->getGender() == GENDER_FEMALE)
+	{
+		key |= 1 << 12;
+	}
+	if (_item)
+	{
+		key |= (_item->getRules()->getTwoHanded() ? 1 : 0) << 13;
+		key |= (_item->getRules()->getHandSprite() + 1) << 14;
+	}
+	return key;
+}
+
 /**
  * Draws a unit, using the drawing rules of the unit.
  * This function is called by Map, for each unit on the screen.
@@ -102,7 +150,7 @@ void UnitSprite::draw()
 	const int offYKneel = 4;
 
 	clear();
-	Soldier *soldier = dynamic_cast<Soldier*>(_unit->getUnit());
+	Soldier *soldier = _soldier;
 
 	if (_unit->isOut())
 	{
@@ -27,6 +27,7 @@ namespace OpenXcom
 class BattleUnit;
 class BattleItem;
 class SurfaceSet;
+class Soldier;
 
 /**
  * A class that renders a specific unit, given its render rules
@@ -36,6 +37,7 @@ class UnitSprite : public Surface
 {
 private:
 	BattleUnit *_unit;
+	Soldier *_soldier;
 	BattleItem *_item;
 	SurfaceSet *_unitSurface;
 	SurfaceSet *_itemSurface;
@@ -50,6 +52,8 @@ public:
 	void setBattleUnit(BattleUnit *unit);
 	/// Sets the battleitem to be rendered.
 	void setBattleItem(BattleItem *item);
+	/// Get a number identifying the frame draw() would render.
+	int getFrameKey() const;
 	/// Draw the surface.
 	void draw();
 	/// Blit the surface.
@@ -65,7 +65,7 @@ void UnitTurnBState::init()
 		}
 		if (door == 1)
 		{
-			_parent->getGame()->getResourcePack()->getSoundSet("BATTLE.CAT")->getSound(RNG::generate(20,21))->play(); // ufo door
+			_parent->getGame()->getResourcePack()->getSoundSet("BATTLE.CAT")->getSound(RNG::generate(20, 21, RNG_COSMETIC))->play(); // ufo door
 		}
 		_parent->popState();
 	}
@@ -38,11 +38,23 @@ namespace OpenXcom
 /**
  * Sets up an UnitWalkBState.
  */
-UnitWalkBState::UnitWalkBState(BattlescapeState *parent) : BattleState(parent)
+UnitWalkBState::UnitWalkBState(BattlescapeState *parent) : BattleState(parent), _unit(0)
 {
 	
 }
 
+/**
+ * Sets up an UnitWalkBState for a unit the player doesn't control,
+ * like an alien walking in sight of the player.
+ * @param parent Pointer to the battlescape.
+ * @param unit Pointer to the walking unit.
+ * @param target Tile it walks to.
+ */
+UnitWalkBState::UnitWalkBState(BattlescapeState *parent, BattleUnit *unit, const Position &target) : BattleState(parent), _target(target), _unit(unit)
+{
+
+}
+
 /**
  * Deletes the UnitWalkBState.
  */
@@ -54,11 +66,28 @@ UnitWalkBState::~UnitWalkBState()
 void UnitWalkBState::init()
 {
 	_parent->setStateInterval(DEFAULT_WALK_SPEED);
-	_unit = _parent->getGame()->getSavedGame()->getBattleGame()->getSelectedUnit();
 	_pf = _parent->getGame()->getSavedGame()->getBattleGame()->getPathfinding();
 	_terrain = _parent->getGame()->getSavedGame()->getBattleGame()->getTerrainModifier();
-	_target = _parent->getTarget();
-	_pf->calculate(_unit, _target);
+	if (_unit == 0)
+	{
+		_unit = _parent->getGame()->getSavedGame()->getBattleGame()->getSelectedUnit();
+		_target = _parent->getTarget();
+	}
+	else
+	{
+		// show the player who's coming
+		_parent->getMap()->centerOnPosition(_unit->getPosition());
+	}
+	// the way to anywhere the unit can reach this turn is usually known already
+	std::vector<int> path;
+	if (_pf->getReachablePath(_unit, _target, &path) != 255)
+	{
+		_pf->setPath(path);
+	}
+	else
+	{
+		_pf->calculate(_unit, _target);
+	}
 }
 
 void UnitWalkBState::think()
@@ -93,6 +122,7 @@ void UnitWalkBState::think()
 		{
 			_parent->getGame()->getSavedGame()->getBattleGame()->getTile(_unit->getLastPosition())->setUnit(0);
 			_parent->getGame()->getSavedGame()->getBattleGame()->getTile(_unit->getPosition())->setUnit(_unit);
+			_parent->getGame()->getSavedGame()->getBattleGame()->updateUnitBucket(_unit);
 			// if the unit changed level, camera changes level with
 			_parent->getMap()->setViewHeight(_unit->getPosition().z);
 		}
@@ -130,14 +160,15 @@ void UnitWalkBState::think()
 
 			// we are looking in the wrong way, turn first
 			// we are not using the turn state, because turning during walking costs no tu
-			if (dir != _unit->getDirection()) 
+			// flying up or down (directions 8 and 9) doesn't need turning
+			if (dir < 8 && dir != _unit->getDirection()) 
 			{
 				_unit->lookAt(dir);
 				return;
 			}
 
 			// now open doors (if any)
-			int door = _terrain->unitOpensDoor(_unit);
+			int door = dir < 8 ? _terrain->unitOpensDoor(_unit) : -1;
 			if (door == 3)
 			{
 				return; // don't start walking yet, wait for the ufo door to open
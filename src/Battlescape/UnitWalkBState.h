@@ -40,6 +40,8 @@ private:
 public:
 	/// Creates a new UnitWalkBState class
 	UnitWalkBState(BattlescapeState *parent);
+	/// Creates a new UnitWalkBState class for a unit that isn't selected.
+	UnitWalkBState(BattlescapeState *parent, BattleUnit *unit, const Position &target);
 	/// Cleans up the UnitWalkBState.
 	~UnitWalkBState();
 	/// Set the target to walk to.
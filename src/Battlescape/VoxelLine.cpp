@@ -0,0 +1,162 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <algorithm>
+#include "VoxelLine.h"
+#include "TerrainModifier.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/Tile.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a line that has no voxels.
+ */
+VoxelLine::VoxelLine() : _terrain(0), _excludeUnit(0), _x(0), _y(0), _z(0), _x1(0), _deltaX(0), _deltaY(0), _deltaZ(0), _stepX(1), _stepY(1), _stepZ(1), _driftXY(0), _driftXZ(0), _swapXY(false), _swapXZ(false), _tilePosition(-1, -1, -1), _emptyTile(false), _result(-1), _finished(true)
+{
+}
+
+/**
+ * Creates a line between two voxels. The longest axis is
+ * swapped to X, so the line takes one voxel step along it every time.
+ * @param terrain Pointer to the terrain modifier, to check the voxels with, 0 to never stop before the target.
+ * @param origin Voxel the line starts at.
+ * @param target Voxel the line goes to, which isn't part of it.
+ * @param excludeUnit Unit the line goes through, like the one firing.
+ */
+VoxelLine::VoxelLine(TerrainModifier *terrain, const Position &origin, const Position &target, BattleUnit *excludeUnit) : _terrain(terrain), _excludeUnit(excludeUnit), _tilePosition(-1, -1, -1), _emptyTile(false), _result(-1), _finished(false)
+{
+	int x0 = origin.x, x1 = target.x;
+	int y0 = origin.y, y1 = target.y;
+	int z0 = origin.z, z1 = target.z;
+
+	//'steep' xy Line, make longest delta x plane
+	_swapXY = abs(y1 - y0) > abs(x1 - x0);
+	if (_swapXY)
+	{
+		std::swap(x0, y0);
+		std::swap(x1, y1);
+	}
+
+	//do same for xz
+	_swapXZ = abs(z1 - z0) > abs(x1 - x0);
+	if (_swapXZ)
+	{
+		std::swap(x0, z0);
+		std::swap(x1, z1);
+	}
+
+	//delta is Length in each plane
+	_deltaX = abs(x1 - x0);
+	_deltaY = abs(y1 - y0);
+	_deltaZ = abs(z1 - z0);
+
+	//drift controls when to step in 'shallow' planes
+	//starting value keeps Line centred
+	_driftXY = _deltaX / 2;
+	_driftXZ = _deltaX / 2;
+
+	//direction of line
+	_stepX = (x0 > x1) ? -1 : 1;
+	_stepY = (y0 > y1) ? -1 : 1;
+	_stepZ = (z0 > z1) ? -1 : 1;
+
+	//starting point
+	_x = x0;
+	_y = y0;
+	_z = z0;
+	_x1 = x1;
+}
+
+/**
+ * Gets the next voxel on the line. The voxel that hits something
+ * is the last one, and so is the one before the target.
+ * @param voxel Pointer to the position to store the voxel in.
+ * @return false if the line has no more voxels.
+ */
+bool VoxelLine::next(Position *voxel)
+{
+	if (_finished || _x == _x1)
+	{
+		_finished = true;
+		return false;
+	}
+
+	//copy position
+	int cx = _x, cy = _y, cz = _z;
+
+	//unswap (in reverse)
+	if (_swapXZ) std::swap(cx, cz);
+	if (_swapXY) std::swap(cx, cy);
+	*voxel = Position(cx, cy, cz);
+
+	//nothing to check against?
+	if (_terrain == 0)
+	{
+		_emptyTile = true;
+	}
+	//entered another tile? voxels are only checked in tiles that aren't empty
+	else if (cx / 16 != _tilePosition.x || cy / 16 != _tilePosition.y || cz / 24 != _tilePosition.z)
+	{
+		_tilePosition = Position(cx / 16, cy / 16, cz / 24);
+		Tile *tile = _terrain->_save->getTile(_tilePosition);
+		_emptyTile = tile != 0 && _terrain->getVoxelSummary(tile) == VOXELS_EMPTY && (tile->getUnit() == 0 || tile->getUnit() == _excludeUnit);
+	}
+
+	//passes through this point?
+	_result = _emptyTile ? -1 : _terrain->voxelCheck(*voxel, _excludeUnit);
+	if (_result != -1)
+	{
+		_finished = true;
+		return true;
+	}
+
+	//update progress in other planes
+	_driftXY -= _deltaY;
+	_driftXZ -= _deltaZ;
+
+	//step in y plane
+	if (_driftXY < 0)
+	{
+		_y += _stepY;
+		_driftXY += _deltaX;
+	}
+
+	//same in z
+	if (_driftXZ < 0)
+	{
+		_z += _stepZ;
+		_driftXZ += _deltaX;
+	}
+
+	_x += _stepX;
+	return true;
+}
+
+/**
+ * Gets what the line hit, once it has no more voxels.
+ * @return the objectnumber(0-3) or unit(4) or out of map (5) or -1(hit nothing)
+ */
+int VoxelLine::getResult() const
+{
+	return _result;
+}
+
+}
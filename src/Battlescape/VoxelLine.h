@@ -0,0 +1,62 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_VOXELLINE_H
+#define OPENXCOM_VOXELLINE_H
+
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class TerrainModifier;
+class BattleUnit;
+
+/**
+ * A line through voxel space (bresenham in 3D) that is walked one
+ * voxel at a time and stops at the first voxel that hits something,
+ * so the voxels don't have to be stored up front.
+ */
+class VoxelLine
+{
+private:
+	TerrainModifier *_terrain;
+	BattleUnit *_excludeUnit;
+	int _x, _y, _z, _x1;
+	int _deltaX, _deltaY, _deltaZ;
+	int _stepX, _stepY, _stepZ;
+	int _driftXY, _driftXZ;
+	bool _swapXY, _swapXZ;
+	Position _tilePosition;
+	bool _emptyTile;
+	int _result;
+	bool _finished;
+public:
+	/// Creates an empty line.
+	VoxelLine();
+	/// Creates a line between two voxels.
+	VoxelLine(TerrainModifier *terrain, const Position &origin, const Position &target, BattleUnit *excludeUnit);
+	/// Gets the next voxel on the line.
+	bool next(Position *voxel);
+	/// Gets what the line hit.
+	int getResult() const;
+};
+
+}
+
+#endif
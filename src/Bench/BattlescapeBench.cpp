@@ -0,0 +1,228 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include "Bench.h"
+#include "../Engine/Game.h"
+#include "../Engine/RNG.h"
+#include "../Ruleset/Ruleset.h"
+#include "../Ruleset/MapData.h"
+#include "../Savegame/SavedGame.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/Base.h"
+#include "../Savegame/Craft.h"
+#include "../Savegame/Ufo.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Savegame/Tile.h"
+#include "../Battlescape/BattlescapeGenerator.h"
+#include "../Battlescape/TerrainModifier.h"
+#include "../Battlescape/Pathfinding.h"
+#include "../Battlescape/AlienTurn.h"
+#include "../Battlescape/Position.h"
+
+/** @file
+ * Benchmark of the battlescape simulation.
+ * Generates a battle like the game does and times
+ * the map sweeps, field of view (one unit and all of them), explosions,
+ * pathfinding and alien turns on it.
+ *
+ * Options: [-mission terror|ufo] [-ufo TYPE] [-texture N]
+ *          [-seed N] [-sweep N] [-fov N] [-explode N] [-path N]
+ *          [-turns N]
+ */
+
+namespace OpenXcom
+{
+
+/**
+ * Picks a random tile with a floor, where units can stand.
+ * @param save Pointer to the battle game.
+ * @return Position of the tile.
+ */
+static Position randomFloor(SavedBattleGame *save)
+{
+	for (int tries = 0; tries < 1000; tries++)
+	{
+		Position pos(RNG::generate(0, save->getWidth() - 1), RNG::generate(0, save->getLength() - 1), RNG::generate(0, save->getHeight() - 1));
+		Tile *tile = save->getTile(pos);
+		if (tile && tile->getMapData(O_FLOOR) && !tile->getMapData(O_OBJECT))
+		{
+			return pos;
+		}
+	}
+	return Position(0, 0, 0);
+}
+
+/**
+ * Times the battlescape simulation on a new battle.
+ * @param game Pointer to the game, with resources and rules loaded.
+ * @param argc Number of options.
+ * @param args Options.
+ */
+void battlescapeBench(Game *game, int argc, char** args)
+{
+	std::string mission = "terror", ufoType = "STR_SMALL_SCOUT";
+	int texture = 1, seed = 1, sweeps = 20, fovs = 1000, explosions = 100, paths = 200, turns = 10;
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(args[i], "-mission") == 0)
+			mission = args[++i];
+		else if (strcmp(args[i], "-ufo") == 0)
+			ufoType = args[++i];
+		else if (strcmp(args[i], "-texture") == 0)
+			texture = atoi(args[++i]);
+		else if (strcmp(args[i], "-seed") == 0)
+			seed = atoi(args[++i]);
+		else if (strcmp(args[i], "-sweep") == 0)
+			sweeps = atoi(args[++i]);
+		else if (strcmp(args[i], "-fov") == 0)
+			fovs = atoi(args[++i]);
+		else if (strcmp(args[i], "-explode") == 0)
+			explosions = atoi(args[++i]);
+		else if (strcmp(args[i], "-path") == 0)
+			paths = atoi(args[++i]);
+		else if (strcmp(args[i], "-turns") == 0)
+			turns = atoi(args[++i]);
+	}
+
+	game->setSavedGame(game->getRuleset()->newSave(DIFF_BEGINNER));
+	RNG::init(seed);
+
+	// Generate the battle the same way the geoscape does
+	Craft *craft = game->getSavedGame()->getBases()->at(0)->getCrafts()->at(0);
+	Ufo *ufo = 0;
+	BattlescapeGenerator *bgen = new BattlescapeGenerator(game);
+	bgen->setWorldTexture(texture);
+	bgen->setWorldShade(0);
+	bgen->setCraft(craft);
+	if (mission == "ufo")
+	{
+		ufo = new Ufo(game->getRuleset()->getUfo(ufoType));
+		bgen->setMissionType(MISS_UFORECOVERY);
+		bgen->setUfo(ufo);
+	}
+	else
+	{
+		bgen->setMissionType(MISS_TERROR);
+	}
+	double start = benchTime();
+	bgen->run();
+	double generation = benchTime() - start;
+	bgen->install();
+	delete bgen;
+
+	SavedBattleGame *save = game->getSavedGame()->getBattleGame();
+	TerrainModifier *terrain = save->getTerrainModifier();
+	std::vector<BattleUnit*> *units = save->getUnits();
+	std::cout << "map " << save->getWidth() << "x" << save->getLength() << "x" << save->getHeight()
+			  << ", " << units->size() << " units, generated in " << std::fixed << std::setprecision(1) << generation / 1000 << " ms" << std::endl;
+
+	// Full map sweeps
+	std::vector<double> sun, lighting, unitLighting;
+	for (int i = 0; i < sweeps; i++)
+	{
+		start = benchTime();
+		terrain->calculateSunShading();
+		sun.push_back(benchTime() - start);
+		start = benchTime();
+		terrain->calculateTerrainLighting();
+		lighting.push_back(benchTime() - start);
+		start = benchTime();
+		terrain->calculateUnitLighting();
+		unitLighting.push_back(benchTime() - start);
+	}
+	benchReport("sun", sun);
+	benchReport("lighting", lighting);
+	benchReport("unitlight", unitLighting);
+
+	// Field of view, with the cached results thrown away so every call traces
+	std::vector<double> fov;
+	for (int i = 0; i < fovs && !units->empty(); i++)
+	{
+		BattleUnit *unit = units->at(i % units->size());
+		unit->setDirection(RNG::generate(0, 7));
+		unit->setFOVCached(false);
+		start = benchTime();
+		terrain->calculateFOV(unit);
+		fov.push_back(benchTime() - start);
+	}
+	benchReport("fov", fov);
+
+	// Field of view of all units at once, like at the start of a turn
+	std::vector<double> fovAll;
+	for (int i = 0; i < sweeps && !units->empty(); i++)
+	{
+		for (std::vector<BattleUnit*>::iterator j = units->begin(); j != units->end(); j++)
+		{
+			(*j)->setFOVCached(false);
+		}
+		start = benchTime();
+		terrain->calculateFOV(units);
+		fovAll.push_back(benchTime() - start);
+	}
+	benchReport("fovall", fovAll);
+
+	// Pathfinding between random floor tiles
+	std::vector<double> path;
+	for (int i = 0; i < paths && !units->empty(); i++)
+	{
+		BattleUnit *unit = units->at(i % units->size());
+		Position target = randomFloor(save);
+		start = benchTime();
+		save->getPathfinding()->calculate(unit, target);
+		path.push_back(benchTime() - start);
+	}
+	benchReport("path", path);
+
+	// Alien turns, without the walks the player would watch
+	std::vector<double> alienTurn;
+	AlienTurn ai(save);
+	for (int i = 0; i < turns; i++)
+	{
+		for (std::vector<BattleUnit*>::iterator j = units->begin(); j != units->end(); j++)
+		{
+			(*j)->setTimeUnits((*j)->getUnit()->getTimeUnits());
+		}
+		std::vector<PathRequest> shown;
+		start = benchTime();
+		ai.run(&shown);
+		alienTurn.push_back(benchTime() - start);
+	}
+	benchReport("alienturn", alienTurn);
+
+	// Explosions last, they change the map
+	std::vector<double> explode;
+	for (int i = 0; i < explosions; i++)
+	{
+		Position pos = randomFloor(save);
+		Position center(pos.x * 16 + 8, pos.y * 16 + 8, pos.z * 24 + 2);
+		start = benchTime();
+		terrain->explode(center, RNG::generate(30, 90), DT_HE, 100, 0);
+		explode.push_back(benchTime() - start);
+	}
+	benchReport("explode", explode);
+
+	delete ufo;
+}
+
+}
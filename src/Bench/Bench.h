@@ -0,0 +1,47 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_BENCH_H
+#define OPENXCOM_BENCH_H
+
+#include <string>
+#include <vector>
+
+namespace OpenXcom
+{
+
+class Game;
+
+/// Gets the current time in microseconds.
+double benchTime();
+/// Prints the latency percentiles of an operation.
+void benchReport(const std::string &name, std::vector<double> times);
+/// Times the battlescape simulation.
+void battlescapeBench(Game *game, int argc, char** args);
+/// Times the geoscape simulation.
+void geoscapeBench(Game *game, int argc, char** args);
+/// Times the pixel paths.
+void renderBench(Game *game, int argc, char** args);
+/// Times the replay of a recorded battle.
+void replayBench(Game *game, int argc, char** args);
+/// Reports the memory used going in and out of battles.
+void soakBench(Game *game, int argc, char** args);
+
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <exception>
+#include "SDL.h"
+#include "Bench.h"
+#include "../Engine/Game.h"
+#include "../Engine/Language.h"
+#include "../Engine/Profiler.h"
+#include "../Resource/XcomResourcePack.h"
+#include "../Ruleset/XcomRuleset.h"
+
+#define DATA_FOLDER "./DATA/"
+
+/** @file
+ * Headless benchmarks of the game simulation.
+ * Sets up the game like it normally starts, with SDL running
+ * on its dummy drivers so nothing is shown or heard, and
+ * runs one of the benchmarks on it.
+ *
+ * Usage: openxcom-bench battlescape [options]
+ *        openxcom-bench geoscape [options]
+ *        openxcom-bench render [options]
+ *        openxcom-bench replay -replay NAME [options]
+ *        openxcom-bench soak [options]
+ */
+
+namespace OpenXcom
+{
+
+/**
+ * Returns the current time with sub-millisecond precision.
+ * @return Time in microseconds.
+ */
+double benchTime()
+{
+	return Profiler::getTime();
+}
+
+/**
+ * Prints the latency percentiles of an operation.
+ * @param name Operation name.
+ * @param times Time each run took, in microseconds.
+ */
+void benchReport(const std::string &name, std::vector<double> times)
+{
+	if (times.empty())
+		return;
+	std::sort(times.begin(), times.end());
+	double total = 0;
+	for (std::vector<double>::iterator i = times.begin(); i != times.end(); i++)
+	{
+		total += *i;
+	}
+	std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+			  << " n=" << std::setw(6) << times.size()
+			  << " mean=" << std::setw(10) << total / times.size()
+			  << " p50=" << std::setw(10) << times[times.size() * 50 / 100]
+			  << " p90=" << std::setw(10) << times[times.size() * 90 / 100]
+			  << " p99=" << std::setw(10) << times[times.size() * 99 / 100]
+			  << " max=" << std::setw(10) << times.back() << " us" << std::endl;
+}
+
+}
+
+using namespace OpenXcom;
+
+int main(int argc, char** args)
+{
+	if (argc < 2 || (strcmp(args[1], "battlescape") != 0 && strcmp(args[1], "geoscape") != 0 && strcmp(args[1], "render") != 0 && strcmp(args[1], "replay") != 0 && strcmp(args[1], "soak") != 0))
+	{
+		std::cerr << "Usage: " << args[0] << " battlescape|geoscape|render|replay|soak [options]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Nothing is shown or heard
+	SDL_putenv((char*)"SDL_VIDEODRIVER=dummy");
+	SDL_putenv((char*)"SDL_AUDIODRIVER=dummy");
+
+	Game *game = 0;
+	try
+	{
+		game = new Game("OpenXcom", 320, 200, 16);
+		game->setResourcePack(new XcomResourcePack(DATA_FOLDER));
+		Language *lang = new Language();
+		lang->loadLng(game->getResourcePack()->getFolder() + "Language/English.lng");
+		game->setLanguage(lang);
+		game->setRuleset(new XcomRuleset());
+
+		if (strcmp(args[1], "battlescape") == 0)
+		{
+			battlescapeBench(game, argc - 1, args + 1);
+		}
+		else if (strcmp(args[1], "geoscape") == 0)
+		{
+			geoscapeBench(game, argc - 1, args + 1);
+		}
+		else if (strcmp(args[1], "replay") == 0)
+		{
+			replayBench(game, argc - 1, args + 1);
+		}
+		else if (strcmp(args[1], "soak") == 0)
+		{
+			soakBench(game, argc - 1, args + 1);
+		}
+		else
+		{
+			renderBench(game, argc - 1, args + 1);
+		}
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		delete game;
+		return EXIT_FAILURE;
+	}
+
+	delete game;
+
+	return EXIT_SUCCESS;
+}
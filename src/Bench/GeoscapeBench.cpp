@@ -0,0 +1,152 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "Bench.h"
+#include "../Engine/Game.h"
+#include "../Engine/RNG.h"
+#include "../Ruleset/Ruleset.h"
+#include "../Savegame/SavedGame.h"
+#include "../Savegame/GameTime.h"
+#include "../Geoscape/GeoscapeState.h"
+
+/** @file
+ * Benchmark of the geoscape simulation.
+ * Loads a saved game (or starts a new one) and runs the
+ * geoscape time logic as fast as it goes for a number of
+ * in-game days, throwing away any popups, then reports
+ * how many days it simulates per second and how long
+ * each time trigger took.
+ *
+ * Options: [-save NAME] [-days N] [-seed N] [-dogfight auto]
+ */
+
+namespace OpenXcom
+{
+
+/**
+ * Times the geoscape simulation.
+ * @param game Pointer to the game, with resources and rules loaded.
+ * @param argc Number of options.
+ * @param args Options.
+ */
+void geoscapeBench(Game *game, int argc, char** args)
+{
+	std::string saveName;
+	int days = 30, seed = -1;
+	bool autoDogfight = false;
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(args[i], "-save") == 0)
+			saveName = args[++i];
+		else if (strcmp(args[i], "-days") == 0)
+			days = atoi(args[++i]);
+		else if (strcmp(args[i], "-seed") == 0)
+			seed = atoi(args[++i]);
+		else if (strcmp(args[i], "-dogfight") == 0)
+			autoDogfight = strcmp(args[++i], "auto") == 0;
+	}
+
+	if (saveName.empty())
+	{
+		game->setSavedGame(game->getRuleset()->newSave(DIFF_BEGINNER));
+		RNG::init(seed == -1 ? 1 : seed);
+	}
+	else
+	{
+		SavedGame *save = new SavedGame(DIFF_BEGINNER);
+		save->load(saveName, game->getRuleset());
+		game->setSavedGame(save);
+		if (seed != -1)
+		{
+			RNG::init(seed);
+		}
+	}
+	GeoscapeState *geoscape = new GeoscapeState(game);
+	geoscape->setAutoDogfight(autoDogfight);
+	GameTime *time = game->getSavedGame()->getTime();
+
+	// Runs the same steps as GeoscapeState::timeAdvance, timing each trigger
+	const char *names[] = {"5sec", "10min", "30min", "1hour", "1day", "1month"};
+	std::vector<double> times[6];
+	int steps = days * 24 * 60 * 12, skipped = 0, popups = 0;
+	double start = benchTime();
+	for (int i = 0; i < steps; i++)
+	{
+		if (geoscape->isIdle())
+		{
+			int skip = std::min(steps - i, time->getStepsToTrigger()) - 1;
+			if (skip > 0)
+			{
+				time->skip(skip);
+				i += skip;
+				skipped += skip;
+			}
+		}
+
+		TimeTrigger trigger = time->advance();
+		double t;
+		switch (trigger)
+		{
+		case TIME_1MONTH:
+			t = benchTime();
+			geoscape->time1Month();
+			times[5].push_back(benchTime() - t);
+		case TIME_1DAY:
+			t = benchTime();
+			geoscape->time1Day();
+			times[4].push_back(benchTime() - t);
+		case TIME_1HOUR:
+			t = benchTime();
+			geoscape->time1Hour();
+			times[3].push_back(benchTime() - t);
+		case TIME_30MIN:
+			t = benchTime();
+			geoscape->time30Minutes();
+			times[2].push_back(benchTime() - t);
+		case TIME_10MIN:
+			t = benchTime();
+			geoscape->time10Minutes();
+			times[1].push_back(benchTime() - t);
+		case TIME_5SEC:
+			t = benchTime();
+			geoscape->time5Seconds();
+			times[0].push_back(benchTime() - t);
+		}
+		popups += geoscape->dismissPopups();
+	}
+	double total = benchTime() - start;
+
+	std::cout << std::fixed << std::setprecision(2) << days << " days in " << total / 1000000 << " s, "
+			  << days / (total / 1000000) << " days/s, " << skipped << " of " << steps << " steps skipped, "
+			  << popups << " popups" << std::endl;
+	for (int i = 0; i < 6; i++)
+	{
+		benchReport(names[i], times[i]);
+	}
+
+	delete geoscape;
+}
+
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include "Bench.h"
+#include "../Engine/Game.h"
+#include "../Engine/Screen.h"
+#include "../Engine/Surface.h"
+#include "../Engine/SurfaceSet.h"
+#include "../Engine/Palette.h"
+#include "../Engine/RNG.h"
+#include "../Interface/Text.h"
+#include "../Resource/ResourcePack.h"
+
+/** @file
+ * Micro-benchmark of the pixel paths every frame goes through.
+ * Runs each surface primitive over a tile sprite (32x40),
+ * the game screen (320x200) and a scaled screen (640x400),
+ * and reports how many pixels per second they get through.
+ *
+ * Options: [-pixels N] (millions of pixels per test, default 50)
+ */
+
+namespace OpenXcom
+{
+
+enum RenderPrimitive { RENDER_SHADE, RENDER_OFFSET, RENDER_INVERT, RENDER_MASKEDCOPY, RENDER_BLIT, RENDER_BLITRLE };
+
+/**
+ * Fills a surface with sprite-like pixels: random colors
+ * with about a third of them transparent.
+ * @param surface Pointer to surface.
+ */
+static void fillSprite(Surface *surface)
+{
+	surface->lock();
+	for (int y = 0; y < surface->getHeight(); y++)
+	{
+		for (int x = 0; x < surface->getWidth(); x++)
+		{
+			surface->setPixel(x, y, RNG::generate(0, 2) == 0 ? 0 : RNG::generate(1, 255));
+		}
+	}
+	surface->unlock();
+}
+
+/**
+ * Prints how fast an operation got through its pixels.
+ * @param name Operation name.
+ * @param width Width of the area in pixels.
+ * @param height Height of the area in pixels.
+ * @param runs Number of runs.
+ * @param time Total time in microseconds.
+ */
+static void printThroughput(const std::string &name, int width, int height, int runs, double time)
+{
+	std::stringstream size;
+	size << width << "x" << height;
+	std::cout << std::left << std::setw(12) << name << std::setw(9) << size.str() << std::right << std::fixed << std::setprecision(2)
+			  << " runs=" << std::setw(8) << runs
+			  << " " << std::setw(10) << time / runs << " us/run"
+			  << " " << std::setw(10) << (double)width * height * runs / time << " Mpixels/s" << std::endl;
+}
+
+/**
+ * Times a surface primitive over a surface of a certain size.
+ * @param name Operation name.
+ * @param primitive Primitive to run.
+ * @param width Width of the surface in pixels.
+ * @param height Height of the surface in pixels.
+ * @param pixels Number of pixels to go through.
+ */
+static void timePrimitive(const std::string &name, RenderPrimitive primitive, int width, int height, double pixels)
+{
+	Surface *src = new Surface(width, height);
+	Surface *dst = new Surface(width, height);
+	fillSprite(src);
+	fillSprite(dst);
+	if (primitive == RENDER_BLITRLE)
+	{
+		src->encodeRle();
+	}
+	int runs = std::max(10, (int)(pixels / (width * height)));
+	double start = benchTime();
+	for (int i = 0; i < runs; i++)
+	{
+		switch (primitive)
+		{
+		case RENDER_SHADE:
+			src->setShade(i % 16);
+			break;
+		case RENDER_OFFSET:
+			src->offset(1);
+			break;
+		case RENDER_INVERT:
+			src->invert(128);
+			break;
+		case RENDER_MASKEDCOPY:
+			dst->maskedCopy(src, 0);
+			break;
+		case RENDER_BLIT:
+		case RENDER_BLITRLE:
+			src->blit(dst);
+			break;
+		}
+	}
+	printThroughput(name, width, height, runs, benchTime() - start);
+	delete src;
+	delete dst;
+}
+
+/**
+ * Times the surface primitives, text drawing, sprite loading
+ * and screen flipping.
+ * @param game Pointer to the game, with resources and rules loaded.
+ * @param argc Number of options.
+ * @param args Options.
+ */
+void renderBench(Game *game, int argc, char** args)
+{
+	double pixels = 50 * 1000000.0;
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(args[i], "-pixels") == 0)
+			pixels = atof(args[++i]) * 1000000.0;
+	}
+	RNG::init(1);
+
+	const int sizes[][2] = {{32, 40}, {320, 200}, {640, 400}};
+	for (int s = 0; s < 3; s++)
+	{
+		int w = sizes[s][0], h = sizes[s][1];
+		timePrimitive("setShade", RENDER_SHADE, w, h, pixels);
+		timePrimitive("offset", RENDER_OFFSET, w, h, pixels);
+		timePrimitive("invert", RENDER_INVERT, w, h, pixels);
+		timePrimitive("maskedCopy", RENDER_MASKEDCOPY, w, h, pixels);
+		timePrimitive("blit", RENDER_BLIT, w, h, pixels);
+		timePrimitive("blitRle", RENDER_BLITRLE, w, h, pixels);
+	}
+
+	// Text over the whole screen
+	Text *text = new Text(320, 200);
+	text->setPalette(game->getResourcePack()->getPalette("PALETTES.DAT_0")->getColors());
+	text->setFonts(game->getResourcePack()->getFont("BIGLETS.DAT"), game->getResourcePack()->getFont("SMALLSET.DAT"));
+	text->setColor(Palette::blockOffset(8) + 5);
+	text->setWordWrap(true);
+	std::wstring paragraph;
+	while (paragraph.size() < 2000)
+	{
+		paragraph += L"The quick brown fox jumps over the lazy dog. 0123456789 ";
+	}
+	text->setText(paragraph);
+	int runs = std::max(10, (int)(pixels / (320 * 200)));
+	double start = benchTime();
+	for (int i = 0; i < runs; i++)
+	{
+		text->draw();
+	}
+	printThroughput("Text::draw", 320, 200, runs, benchTime() - start);
+	delete text;
+
+	// Sprite sheet loading, every frame is 32x40
+	std::string pck = ResourcePack::insensitive(game->getResourcePack()->getFolder() + "GEOGRAPH/BASEBITS.PCK");
+	std::string tab = ResourcePack::insensitive(game->getResourcePack()->getFolder() + "GEOGRAPH/BASEBITS.TAB");
+	SurfaceSet *set = new SurfaceSet(32, 40);
+	set->loadPck(pck, tab);
+	int frames = set->getTotalFrames();
+	delete set;
+	runs = std::max(10, (int)(pixels / (frames * 32 * 40)));
+	start = benchTime();
+	for (int i = 0; i < runs; i++)
+	{
+		set = new SurfaceSet(32, 40);
+		set->loadPck(pck, tab);
+		delete set;
+	}
+	printThroughput("loadPck", 32, 40 * frames, runs, benchTime() - start);
+
+	// Screen flips, with every pixel changed or none
+	Screen *screen = game->getScreen();
+	int resolutions[][2] = {{320, 200}, {640, 400}};
+	for (int r = 0; r < 2; r++)
+	{
+		screen->setResolution(resolutions[r][0], resolutions[r][1]);
+		fillSprite(screen->getSurface());
+		screen->flip();
+		runs = std::max(10, (int)(pixels / (resolutions[r][0] * resolutions[r][1])));
+		double changed = 0;
+		for (int i = 0; i < runs; i++)
+		{
+			screen->getSurface()->invert(128);
+			start = benchTime();
+			screen->flip();
+			changed += benchTime() - start;
+		}
+		printThroughput("flip", resolutions[r][0], resolutions[r][1], runs, changed);
+		start = benchTime();
+		for (int i = 0; i < runs; i++)
+		{
+			screen->flip();
+		}
+		printThroughput("flip (same)", resolutions[r][0], resolutions[r][1], runs, benchTime() - start);
+	}
+}
+
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include "Bench.h"
+#include "../Engine/Game.h"
+#include "../Engine/Exception.h"
+#include "../Engine/JobPool.h"
+#include "../Engine/StateHash.h"
+#include "../Savegame/SavedGame.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Battlescape/BattlescapeState.h"
+#include "../Battlescape/BattleRecorder.h"
+
+/** @file
+ * Benchmark of a recorded battle.
+ * Loads the game a battle was recorded from (see -record)
+ * and replays the player's actions as fast as they go, with
+ * every action played out in full, then reports how long
+ * each kind of action took. Turns a reported stutter
+ * into something that can be timed again and again.
+ *
+ * It can also check that a faster way of working things out
+ * comes to the same game: -hashes writes a digest of every part
+ * of the game state after each action, and -compare replays
+ * against such a file (say from a run with -threads 1) and
+ * reports the first action and parts of the state that differ.
+ *
+ * Options: -replay NAME [-fastcombat off|all] [-threads N]
+ *          [-hashes FILE] [-compare FILE]
+ */
+
+namespace OpenXcom
+{
+
+/**
+ * Works out the digest of every part of the game state.
+ * @param game Pointer to the game.
+ * @param digest Array of HASH_PARTS digests to store them in.
+ */
+static void digestState(Game *game, Uint64 *digest)
+{
+	StateHash parts[HASH_PARTS];
+	game->getSavedGame()->hash(parts);
+	for (int i = 0; i < HASH_PARTS; i++)
+	{
+		digest[i] = parts[i].get();
+	}
+}
+
+/**
+ * Times the replay of a recorded battle.
+ * @param game Pointer to the game, with resources and rules loaded.
+ * @param argc Number of options.
+ * @param args Options.
+ */
+void replayBench(Game *game, int argc, char** args)
+{
+	std::string replayName, hashesName, compareName;
+	FastCombat fastCombat = FAST_COMBAT_ALL;
+	int threads = 0;
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(args[i], "-replay") == 0)
+			replayName = args[++i];
+		else if (strcmp(args[i], "-fastcombat") == 0)
+			fastCombat = strcmp(args[++i], "off") == 0 ? FAST_COMBAT_OFF : FAST_COMBAT_ALL;
+		else if (strcmp(args[i], "-threads") == 0)
+			threads = atoi(args[++i]);
+		else if (strcmp(args[i], "-hashes") == 0)
+			hashesName = args[++i];
+		else if (strcmp(args[i], "-compare") == 0)
+			compareName = args[++i];
+	}
+	if (replayName.empty())
+	{
+		throw Exception("No recording to replay");
+	}
+	JobPool::init(threads);
+
+	// Digests from the run to compare with, one line per action
+	std::vector<Uint64> reference;
+	if (!compareName.empty())
+	{
+		std::ifstream in(compareName.c_str());
+		if (!in)
+		{
+			throw Exception("Failed to load digests");
+		}
+		Uint64 value;
+		while (in >> std::hex >> value)
+		{
+			reference.push_back(value);
+		}
+	}
+	std::ofstream hashes;
+	if (!hashesName.empty())
+	{
+		hashes.open(hashesName.c_str());
+	}
+
+	SavedGame *save = new SavedGame(DIFF_BEGINNER);
+	save->load(replayName, game->getRuleset());
+	game->setSavedGame(save);
+	if (save->getBattleGame() == 0)
+	{
+		throw Exception("Recording has no battle");
+	}
+	save->getBattleGame()->loadMap(game->getResourcePack());
+
+	BattlescapeState::setFastCombat(fastCombat);
+	BattlescapeState::setReplay(replayName);
+	BattlescapeState *battle = new BattlescapeState(game);
+	BattlescapeState::setReplay("");
+	battle->init();
+
+	// Every step of an action is played out without waiting for the timers
+	const char *names[] = {"walk", "turn", "fire", "kneel", "endturn"};
+	std::vector<double> times[5];
+	int actions = 0, steps = 0;
+	bool verify = hashes.is_open() || !compareName.empty();
+	double start = benchTime(), hashing = 0;
+	while (true)
+	{
+		// the state before the first action counts too, in case it loaded differently
+		if (verify)
+		{
+			double t = benchTime();
+			Uint64 digest[HASH_PARTS];
+			digestState(game, digest);
+			for (int i = 0; i < HASH_PARTS && hashes.is_open(); i++)
+			{
+				hashes << std::hex << digest[i] << (i == HASH_PARTS - 1 ? "\n" : " ");
+			}
+			if (!compareName.empty())
+			{
+				size_t line = actions * HASH_PARTS;
+				if (line + HASH_PARTS > reference.size())
+				{
+					std::cout << "no digests to compare with after action " << actions << std::endl;
+					compareName.clear();
+				}
+				else
+				{
+					bool diverged = false;
+					for (int i = 0; i < HASH_PARTS; i++)
+					{
+						if (digest[i] != reference[line + i])
+						{
+							if (!diverged)
+								std::cout << "diverged after action " << actions << ":";
+							std::cout << " " << StateHash::getPartName((HashPart)i);
+							diverged = true;
+						}
+					}
+					if (diverged)
+					{
+						std::cout << std::endl;
+						break;
+					}
+				}
+			}
+			hashing += benchTime() - t;
+		}
+
+		RecordedActionType type;
+		double t = benchTime();
+		if (!battle->replayNext(&type))
+			break;
+		while (battle->isBusy())
+		{
+			battle->handleState();
+			steps++;
+		}
+		times[type].push_back(benchTime() - t);
+		actions++;
+	}
+	double total = benchTime() - start - hashing;
+
+	std::cout << std::fixed << std::setprecision(1) << actions << " actions, " << steps << " steps in "
+			  << total / 1000 << " ms" << std::endl;
+	for (int i = 0; i < 5; i++)
+	{
+		benchReport(names[i], times[i]);
+	}
+
+	delete battle;
+}
+
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include "Bench.h"
+#include "../Engine/Game.h"
+#include "../Engine/RNG.h"
+#include "../Engine/Profiler.h"
+#include "../Engine/CrossPlatform.h"
+#include "../Ruleset/Ruleset.h"
+#include "../Savegame/SavedGame.h"
+#include "../Savegame/Base.h"
+#include "../Savegame/Craft.h"
+#include "../Savegame/Ufo.h"
+#include "../Battlescape/BattlescapeGenerator.h"
+#include "../Battlescape/BattlescapeState.h"
+
+/** @file
+ * Memory soak test of the battlescape.
+ * Goes in and out of battles like a long campaign does:
+ * generates a battle, opens the battlescape on it, plays
+ * a few turns and ends the battle, over and over. After each
+ * battle it prints the memory in RAM and the memory the game
+ * counts for each part, which should all go back to where
+ * they were, so leaks and caches that keep growing show up.
+ *
+ * Options: [-cycles N] [-turns N] [-mission terror|ufo] [-ufo TYPE]
+ *          [-texture N] [-seed N]
+ */
+
+namespace OpenXcom
+{
+
+/**
+ * Prints the memory in use after a battle.
+ * @param cycle Number of the battle, or -1 for before the first.
+ * @param first Memory in RAM before the first battle, in bytes.
+ * @param base Memory counted for each part before the first battle, in bytes.
+ */
+static void soakReport(int cycle, long first, const long *base)
+{
+	long rss = CrossPlatform::getResidentMemory();
+	if (cycle == -1)
+		std::cout << "start ";
+	else
+		std::cout << std::setw(5) << cycle << " ";
+	std::cout << std::fixed << std::setprecision(1)
+			  << "rss=" << std::setw(8) << rss / 1048576.0 << " MB"
+			  << " (" << std::showpos << (rss - first) / 1024 << std::noshowpos << " KB)";
+	for (int i = 0; i < MEM_TAGS; i++)
+	{
+		long memory = Profiler::getMemory((MemoryTag)i);
+		std::cout << " " << Profiler::getMemoryName((MemoryTag)i) << "=" << memory / 1024;
+		if (base != 0 && memory != base[i])
+		{
+			std::cout << "(" << std::showpos << (memory - base[i]) / 1024 << std::noshowpos << ")";
+		}
+	}
+	std::cout << std::endl;
+}
+
+/**
+ * Generates, plays and ends battles, reporting the memory after each.
+ * @param game Pointer to the game, with resources and rules loaded.
+ * @param argc Number of options.
+ * @param args Options.
+ */
+void soakBench(Game *game, int argc, char** args)
+{
+	std::string mission = "terror", ufoType = "STR_SMALL_SCOUT";
+	int cycles = 20, turns = 3, texture = 1, seed = 1;
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(args[i], "-cycles") == 0)
+			cycles = atoi(args[++i]);
+		else if (strcmp(args[i], "-turns") == 0)
+			turns = atoi(args[++i]);
+		else if (strcmp(args[i], "-mission") == 0)
+			mission = args[++i];
+		else if (strcmp(args[i], "-ufo") == 0)
+			ufoType = args[++i];
+		else if (strcmp(args[i], "-texture") == 0)
+			texture = atoi(args[++i]);
+		else if (strcmp(args[i], "-seed") == 0)
+			seed = atoi(args[++i]);
+	}
+
+	game->setSavedGame(game->getRuleset()->newSave(DIFF_BEGINNER));
+	RNG::init(seed);
+	Craft *craft = game->getSavedGame()->getBases()->at(0)->getCrafts()->at(0);
+	BattlescapeState::setFastCombat(FAST_COMBAT_ALL);
+
+	long first = CrossPlatform::getResidentMemory();
+	long base[MEM_TAGS];
+	for (int i = 0; i < MEM_TAGS; i++)
+	{
+		base[i] = Profiler::getMemory((MemoryTag)i);
+	}
+	soakReport(-1, first, 0);
+
+	for (int cycle = 0; cycle < cycles; cycle++)
+	{
+		// Into the battle the same way the geoscape goes
+		BattlescapeGenerator *bgen = new BattlescapeGenerator(game);
+		bgen->setWorldTexture(texture);
+		bgen->setWorldShade(0);
+		bgen->setCraft(craft);
+		if (mission == "ufo")
+		{
+			// the battle's over when the UFO is gone, like in the game
+			Ufo *ufo = new Ufo(game->getRuleset()->getUfo(ufoType));
+			game->getSavedGame()->getUfos()->push_back(ufo);
+			bgen->setMissionType(MISS_UFORECOVERY);
+			bgen->setUfo(ufo);
+		}
+		else
+		{
+			bgen->setMissionType(MISS_TERROR);
+		}
+		bgen->run();
+		bgen->install();
+		delete bgen;
+
+		// A few turns, with every action played out in full
+		BattlescapeState *battle = new BattlescapeState(game);
+		battle->init();
+		for (int i = 0; i < turns; i++)
+		{
+			battle->btnEndTurnClick(0);
+			while (battle->isBusy())
+			{
+				battle->handleState();
+			}
+		}
+		delete battle;
+
+		// And out again
+		game->getSavedGame()->endBattle();
+		soakReport(cycle, first, base);
+	}
+}
+
+}
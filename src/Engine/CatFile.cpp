@@ -62,11 +62,14 @@ CatFile::~CatFile()
 }
 
 /**
- * Loads an object into memory.
+ * Loads an object into memory. Room can be left for
+ * a header in front of it, so callers that need one
+ * don't have to copy the object again.
  * @param i Object number to load.
- * @return Pointer to the loaded object.
+ * @param headerSize Bytes to leave free before the object.
+ * @return Pointer to the loaded object (including the header room).
  */
-char *CatFile::load(unsigned int i)
+char *CatFile::load(unsigned int i, unsigned int headerSize)
 {
 	if (i >= _amount)
 		return 0;
@@ -79,8 +82,8 @@ char *CatFile::load(unsigned int i)
 	seekg(namesize, std::ios::cur);
 
 	// Read object
-	char *object = new char[_size[i]];
-	read(object, _size[i]);
+	char *object = new char[headerSize + _size[i]];
+	read(object + headerSize, _size[i]);
 
 	return object;
 }
@@ -53,7 +53,7 @@ public:
 		return (i < _amount) ? _size[i] : 0;
 	}
 	/// Load an object into memory.
-	char *load(unsigned int i);
+	char *load(unsigned int i, unsigned int headerSize = 0);
 };
 
 }
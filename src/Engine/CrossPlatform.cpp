@@ -19,8 +19,14 @@
 #include "CrossPlatform.h"
 #ifdef _WIN32
 #include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
 #else
 #include <iostream>
+#include <fstream>
+#include <unistd.h>
 #endif
 
 namespace OpenXcom
@@ -52,4 +58,48 @@ void CrossPlatform::showError(const std::wstring &error)
 #endif
 }
 
+/**
+ * Returns how many processor cores the system has,
+ * for splitting work between threads.
+ * @return Number of cores, at least 1.
+ */
+int CrossPlatform::getCoreCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	int cores = info.dwNumberOfProcessors;
+#else
+	int cores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return cores < 1 ? 1 : cores;
+}
+
+/**
+ * Returns how much of the game's memory is resident in RAM,
+ * which is what runs out on small devices, to spot memory
+ * that keeps growing.
+ * @return Bytes in RAM, or 0 if the system doesn't tell.
+ */
+long CrossPlatform::getResidentMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS info;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &info, sizeof(info)))
+	{
+		return info.WorkingSetSize;
+	}
+	return 0;
+#else
+	// second field is the resident pages
+	std::ifstream statm("/proc/self/statm");
+	long size = 0, resident = 0;
+	if (statm >> size >> resident)
+	{
+		return resident * sysconf(_SC_PAGESIZE);
+	}
+	return 0;
+#endif
+}
+
 }
@@ -38,6 +38,10 @@ public:
 	static void showError(const std::string &error);
 	/// Displays an error message.
 	static void showError(const std::wstring &error);
+	/// Gets the number of processor cores.
+	static int getCoreCount();
+	/// Gets the memory of the game that's in RAM.
+	static long getResidentMemory();
 };
 
 }
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FileData.h"
+#include <fstream>
+#include "Exception.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Reads the whole contents of a file into memory with a single read.
+ * @param filename Filename of the file.
+ * @param error Message to throw if the file can't be read.
+ */
+FileData::FileData(const std::string &filename, const char *error) : _data()
+{
+	std::ifstream file (filename.c_str(), std::ios::in | std::ios::binary);
+	if (!file)
+	{
+		throw Exception(error);
+	}
+	file.seekg(0, std::ios::end);
+	std::streamoff size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	_data.resize((size_t)size);
+	if (size > 0 && !file.read((char*)&_data[0], size))
+	{
+		throw Exception("Invalid data from file");
+	}
+	file.close();
+}
+
+/**
+ *
+ */
+FileData::~FileData()
+{
+}
+
+/**
+ * Returns the contents of the file.
+ * @return Pointer to the first byte.
+ */
+const Uint8 *FileData::getData() const
+{
+	static const Uint8 empty = 0;
+	return _data.empty() ? &empty : &_data[0];
+}
+
+/**
+ * Returns the size of the file.
+ * @return Size in bytes.
+ */
+size_t FileData::getSize() const
+{
+	return _data.size();
+}
+
+/**
+ * Returns a little-endian 16-bit number from the file,
+ * the way the original game's files store them.
+ * @param pos Offset of the number in bytes.
+ * @return The number, or 0 if it's past the end.
+ */
+Uint16 FileData::getUint16(size_t pos) const
+{
+	if (pos + 2 > _data.size())
+		return 0;
+	return _data[pos] | (_data[pos + 1] << 8);
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_FILEDATA_H
+#define OPENXCOM_FILEDATA_H
+
+#include <string>
+#include <vector>
+#include "SDL.h"
+
+namespace OpenXcom
+{
+
+/**
+ * The whole contents of a binary file, read in one go,
+ * so decoders can work straight on the bytes instead of
+ * reading the file a byte at a time.
+ */
+class FileData
+{
+private:
+	std::vector<Uint8> _data;
+public:
+	/// Reads a whole file.
+	FileData(const std::string &filename, const char *error);
+	/// Cleans up the file contents.
+	~FileData();
+	/// Gets the contents of the file.
+	const Uint8 *getData() const;
+	/// Gets the size of the file.
+	size_t getSize() const;
+	/// Gets a little-endian 16-bit number from the file.
+	Uint16 getUint16(size_t pos) const;
+};
+
+}
+
+#endif
@@ -49,10 +49,12 @@ Font::~Font()
 /**
  * Calculates the real size and position of each character in
  * the surface and stores them in SDL_Rect's for future use
- * by other classes.
+ * by other classes. They're kept in a flat table from the
+ * first character on, so looking one up is just an index.
  */
 void Font::load()
 {
+	_chars.resize(_nchar);
 	_surface->lock();
 	for (unsigned char i = FIRST_CHAR; i < FIRST_CHAR + _nchar; i++)
 	{
@@ -85,29 +87,42 @@ void Font::load()
 		rect.w = right - left + 1;
 		rect.h = _height;
 
-		_chars[i] = rect;
+		_chars[i - FIRST_CHAR] = rect;
 	}
 	_surface->unlock();
 }
 
 /**
  * Returns a particular character from the set stored in the font.
+ * Characters the font doesn't have are replaced with '?'.
+ * The font itself isn't changed, so it can be used by several
+ * texts at once.
  * @param c Character to use for size/position.
- * @return Pointer to the font's surface with the respective
- * cropping rectangle set up.
+ * @return Rectangle of the character in the font's surface.
  */
-Surface *const Font::getChar(wchar_t c)
+const SDL_Rect &Font::getChar(wchar_t c) const
 {
-	if (_chars.find(c) == _chars.end())
+	if (c < FIRST_CHAR || c >= FIRST_CHAR + (int)_chars.size())
 	{
 		c = '?';
 	}
-	_surface->getCrop()->x = _chars[c].x;
-	_surface->getCrop()->y = _chars[c].y;
-	_surface->getCrop()->w = _chars[c].w;
-	_surface->getCrop()->h = _chars[c].h;
-	return _surface;
+	return _chars[c - FIRST_CHAR];
 }
+
+/**
+ * Draws a particular character from the font onto another surface,
+ * replacing its colors through a remap table.
+ * @param c Character to draw.
+ * @param surface Pointer to surface to draw onto.
+ * @param x X position to draw the character at.
+ * @param y Y position to draw the character at.
+ * @param table Table of 256 colors to replace each color with.
+ */
+void Font::drawChar(wchar_t c, Surface *surface, int x, int y, const Uint8 *table) const
+{
+	_surface->blitRemapped(surface, table, x, y, &getChar(c));
+}
+
 /**
  * Returns the maximum width for any character in the font.
  * @return Width in pixels.
@@ -19,7 +19,7 @@
 #ifndef OPENXCOM_FONT_H
 #define OPENXCOM_FONT_H
 
-#include <map>
+#include <vector>
 #include "SDL.h"
 
 namespace OpenXcom
@@ -39,7 +39,7 @@ class Font
 private:
 	Surface *_surface;
 	int _width, _height, _nchar;
-	std::map<wchar_t, SDL_Rect> _chars;
+	std::vector<SDL_Rect> _chars;
 	// For some reason the X-Com small font is smooshed together by one pixel...
 	int _spacing;
 public:
@@ -49,8 +49,10 @@ public:
 	~Font();
 	/// Determines the size and position of each character in the font.
 	void load();
-	/// Gets a particular character from the font, with its real size.
-	Surface *const getChar(wchar_t c);
+	/// Gets the size and position of a particular character in the font.
+	const SDL_Rect &getChar(wchar_t c) const;
+	/// Draws a particular character from the font onto a surface.
+	void drawChar(wchar_t c, Surface *surface, int x, int y, const Uint8 *table) const;
 	/// Gets the font's character width.
 	int getWidth() const;
 	/// Gets the font's character height.
@@ -17,12 +17,15 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Game.h"
+#include <algorithm>
+#include <typeinfo>
 #include "SDL_mixer.h"
 #include "State.h"
 #include "Screen.h"
 #include "Language.h"
 #include "../Interface/Cursor.h"
 #include "../Interface/FpsCounter.h"
+#include "../Interface/ProfilerOverlay.h"
 #include "../Resource/ResourcePack.h"
 #include "../Ruleset/Ruleset.h"
 #include "../Savegame/SavedGame.h"
@@ -30,10 +33,17 @@
 #include "Action.h"
 #include "Exception.h"
 #include "InteractiveSurface.h"
+#include "Timer.h"
+#include "Profiler.h"
+#include "JobPool.h"
+#include "SurfacePool.h"
 
 namespace OpenXcom
 {
 
+#define FRAME_INTERVAL 16
+#define IDLE_INTERVAL 10
+
 /**
  * Starts up SDL with all the subsystems and SDL_mixer for audio processing,
  * creates the display screen and sets up the cursor.
@@ -44,7 +54,7 @@ namespace OpenXcom
  * @warning Currently the game is designed for 8bpp, so there's no telling what'll
  * happen if you use a different value.
  */
-Game::Game(const std::string &title, int width, int height, int bpp) : _screen(0), _cursor(0), _lang(0), _states(), _deleted(), _res(0), _save(0), _rules(0), _quit(false), _init(false)
+Game::Game(const std::string &title, int width, int height, int bpp) : _screen(0), _cursor(0), _lang(0), _states(), _deleted(), _cache(), _res(0), _save(0), _rules(0), _quit(false), _init(false), _redraw(true), _lastFrame(0), _underlay(0), _underlayValid(false)
 {
 	// Initialize SDL
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
@@ -68,6 +78,7 @@ Game::Game(const std::string &title, int width, int height, int bpp) : _screen(0
 
 	// Create display
 	_screen = new Screen(width, height, bpp);
+	_underlay = new Surface(_screen->getSurface()->getWidth(), _screen->getSurface()->getHeight());
 
 	// Create cursor
 	_cursor = new Cursor(9, 13);
@@ -75,6 +86,9 @@ Game::Game(const std::string &title, int width, int height, int bpp) : _screen(0
 	
 	// Create fps counter
 	_fpsCounter = new FpsCounter(15, 5, 0, 0);
+
+	// Create profiler overlay
+	_profilerOverlay = new ProfilerOverlay(232, 72, 0, _screen->getSurface()->getHeight() - 72);
 }
 
 /**
@@ -84,18 +98,29 @@ Game::~Game()
 {
 	Mix_HaltChannel(-1);
 
+	// Finish any save still being written, while its
+	// completion can still be reported and cleaned up
+	SavedGame::waitSaves();
+	JobPool::runPosted();
+
 	for (std::list<State*>::iterator i = _states.begin(); i != _states.end(); i++)
 	{
 		delete *i;
 	}
+	clearStateCache();
 
 	delete _cursor;
 	delete _lang;
 	delete _res;
-	delete _rules;
 	delete _save;
+	delete _rules;
+	delete _underlay;
 	delete _screen;
 	delete _fpsCounter;
+	delete _profilerOverlay;
+	SurfacePool::clear();
+
+	JobPool::quit();
 
 	Mix_CloseAudio();
 
@@ -106,6 +131,9 @@ Game::~Game()
  * The state machine takes care of passing all the events from SDL to the
  * active state, running any code within and blitting all the states and
  * cursor to the screen. This is run indefinitely until the game quits.
+ * The screen is only rendered when a state changed, an event came in
+ * or a timer fired, and at most once every FRAME_INTERVAL, otherwise
+ * the game sleeps until the next timer is due.
  */
 void Game::run()
 {
@@ -123,15 +151,13 @@ void Game::run()
 		{
 			_states.back()->init();
 			_init = true;
+			_redraw = true;
+			_underlayValid = false;
 
 			// Unpress buttons
-			for (std::vector<Surface*>::iterator i = _states.back()->getSurfaces()->begin(); i < _states.back()->getSurfaces()->end(); i++)
+			for (std::vector<InteractiveSurface*>::iterator i = _states.back()->getInteractiveSurfaces()->begin(); i < _states.back()->getInteractiveSurfaces()->end(); i++)
 			{
-				InteractiveSurface *s = dynamic_cast<InteractiveSurface*>(*i);
-				if (s != 0)
-				{
-					s->unpress(_states.back());
-				}
+				(*i)->unpress(_states.back());
 			}
 
 			// Refresh mouse position
@@ -146,29 +172,67 @@ void Game::run()
 		}
 
 		// Process events
+		ProfileMarker events(PROF_EVENTS);
+		// consecutive mouse motions are merged into one, so handlers
+		// only run for where the mouse ended up this frame
+		SDL_Event motion;
+		bool moved = false;
 		while (SDL_PollEvent(&_event))
 		{
 			if (_event.type == SDL_QUIT)
 			{
 				_quit = true;
 			}
+			else if (_event.type == SDL_MOUSEMOTION)
+			{
+				if (moved)
+				{
+					_event.motion.xrel += motion.motion.xrel;
+					_event.motion.yrel += motion.motion.yrel;
+				}
+				motion = _event;
+				moved = true;
+			}
 			else
 			{
-				Action action = Action(&_event, _screen->getXScale(), _screen->getYScale());
-				_screen->handle(&action);
-				_cursor->handle(&action);
-				_fpsCounter->handle(&action);
-				_states.back()->handle(&action);
+				if (moved)
+				{
+					handleEvent(&motion);
+					moved = false;
+				}
+				handleEvent(&_event);
+			}
+			// a system cursor moves by itself, the screen only needs
+			// drawing again if the mouse went over something
+			if (_event.type != SDL_MOUSEMOTION || !_cursor->isHardware())
+			{
+				_redraw = true;
 			}
 		}
+		if (moved && handleEvent(&motion))
+		{
+			_redraw = true;
+		}
+		events.stop();
 		
 		// Process logic
+		ProfileMarker think(PROF_THINK);
+		JobPool::runPosted();
+		Timer::resetTicks();
 		_fpsCounter->think();
+		_profilerOverlay->think();
 		_states.back()->think();
+		think.stop();
+		if (Timer::hasFired())
+		{
+			_redraw = true;
+		}
 		
 		// Process rendering
-		if (_init)
+		Uint32 now = SDL_GetTicks();
+		if (_init && _redraw && now - _lastFrame >= FRAME_INTERVAL)
 		{
+			ProfileMarker blit(PROF_BLIT);
 			_screen->clear();
 			std::list<State*>::iterator i = _states.end();
 			do
@@ -177,19 +241,74 @@ void Game::run()
 			}
 			while(i != _states.begin() && !(*i)->isScreen());
 
-			for (; i != _states.end(); i++)
+			// the states below the active one don't change while it's open,
+			// so they're only drawn once and kept in the underlay
+			std::list<State*>::iterator top = _states.end();
+			top--;
+			if (i != top)
 			{
-				(*i)->blit();
+				if (!_underlayValid)
+				{
+					for (; i != top; i++)
+					{
+						(*i)->blit();
+					}
+					_underlay->clear();
+					_screen->getSurface()->blit(_underlay);
+					_underlayValid = true;
+				}
+				else
+				{
+					_underlay->blit(_screen->getSurface());
+				}
 			}
+			(*top)->blit();
 			_fpsCounter->blit(_screen->getSurface());
+			_profilerOverlay->blit(_screen->getSurface());
 			_cursor->blit(_screen->getSurface());
+			blit.stop();
+			ProfileMarker flip(PROF_FLIP);
+			_screen->flip();
+			flip.stop();
+			Profiler::endFrame();
+			_fpsCounter->addFrame();
+			_lastFrame = now;
+			_redraw = false;
 		}
-		_screen->flip();
 
-		SDL_Delay(0);
+		// Sleep until the next frame or timer is due, still checking for input now and then
+		Uint32 wait = IDLE_INTERVAL;
+		if (_redraw && now - _lastFrame < FRAME_INTERVAL)
+		{
+			wait = std::min(wait, FRAME_INTERVAL - (now - _lastFrame));
+		}
+		Uint32 next = Timer::getNextTick();
+		if (next != 0)
+		{
+			wait = std::min(wait, next > now ? next - now : 0);
+		}
+		SDL_Delay(wait);
 	}
 }
 
+/**
+ * Passes an event from SDL to everything listening
+ * for input: the screen, cursor, overlays and the
+ * active state.
+ * @param event Pointer to the SDL event.
+ * @return True if any element of the state got the event.
+ */
+bool Game::handleEvent(SDL_Event *event)
+{
+	Action action = Action(event, _screen->getXScale(), _screen->getYScale());
+	_screen->handle(&action);
+	_cursor->handle(&action);
+	_fpsCounter->handle(&action);
+	_profilerOverlay->handle(&action);
+	_states.back()->handle(&action);
+	return action.getSender() != 0;
+}
+
 /**
  * Stops the state machine and the game is shut down.
  */
@@ -235,10 +354,14 @@ FpsCounter *const Game::getFpsCounter() const
 void Game::setPalette(SDL_Color *colors, int firstcolor, int ncolors)
 {
 	_screen->setPalette(colors, firstcolor, ncolors);
+	_underlay->setPalette(colors, firstcolor, ncolors);
+	_redraw = true;
+	_underlayValid = false;
 	_cursor->setPalette(colors, firstcolor, ncolors);
 	_cursor->draw();
 
 	_fpsCounter->setPalette(colors, firstcolor, ncolors);
+	_profilerOverlay->setPalette(colors, firstcolor, ncolors);
 	
 	if (_res != 0)
 	{
@@ -258,6 +381,7 @@ void Game::setState(State *state)
 	{
 		popState();
 	}
+	clearStateCache();
 	pushState(state);
 	_init = false;
 }
@@ -269,6 +393,7 @@ void Game::setState(State *state)
  */
 void Game::pushState(State *state)
 {
+	Profiler::trace("pushState", 'i', typeid(*state).name());
 	_states.push_back(state);
 	_init = false;
 }
@@ -277,15 +402,44 @@ void Game::pushState(State *state)
  * Pops the last state from the top of the stack. Since states
  * can't actually be deleted mid-cycle, it's moved into a separate queue
  * which is cleared at the start of every cycle, so the transition
- * is seamless.
+ * is seamless. States that can be reused are kept in a cache
+ * instead, dropping the oldest one when it's full.
  */
 void Game::popState()
 {
-	_deleted.push_back(_states.back());
+	Profiler::trace("popState", 'i', typeid(*_states.back()).name());
+	if (_states.back()->isReusable())
+	{
+		_cache.push_front(_states.back());
+		if (_cache.size() > STATE_CACHE_SIZE)
+		{
+			_deleted.push_back(_cache.back());
+			_cache.pop_back();
+		}
+	}
+	else
+	{
+		_deleted.push_back(_states.back());
+	}
 	_states.pop_back();
 	_init = false;
 }
 
+/**
+ * Deletes all the closed states kept for reuse. They're
+ * not in the stack, so this can be done straight away.
+ * Has to be called whenever anything they point to goes
+ * away, like the saved game.
+ */
+void Game::clearStateCache()
+{
+	for (std::list<State*>::iterator i = _cache.begin(); i != _cache.end(); i++)
+	{
+		delete *i;
+	}
+	_cache.clear();
+}
+
 /**
  * Returns the language currently in use by the game.
  * @return Pointer to the language.
@@ -301,6 +455,7 @@ Language *const Game::getLanguage() const
  */
 void Game::setLanguage(Language *lang)
 {
+	clearStateCache();
 	delete _lang;
 	_lang = lang;
 }
@@ -320,6 +475,7 @@ ResourcePack *const Game::getResourcePack() const
  */
 void Game::setResourcePack(ResourcePack *res)
 {
+	clearStateCache();
 	_res = res;
 }
 
@@ -338,6 +494,7 @@ SavedGame *const Game::getSavedGame() const
  */
 void Game::setSavedGame(SavedGame *save)
 {
+	clearStateCache();
 	delete _save;
 	_save = save;
 }
@@ -23,6 +23,8 @@
 #include <string>
 #include "SDL.h"
 
+#define STATE_CACHE_SIZE 4
+
 namespace OpenXcom
 {
 
@@ -34,6 +36,8 @@ class ResourcePack;
 class SavedGame;
 class Ruleset;
 class FpsCounter;
+class ProfilerOverlay;
+class Surface;
 
 /**
  * The core of the game engine, manages the game's entire contents and structure.
@@ -48,12 +52,18 @@ private:
 	Screen *_screen;
 	Cursor *_cursor;
 	Language *_lang;
-	std::list<State*> _states, _deleted;
+	std::list<State*> _states, _deleted, _cache;
 	ResourcePack *_res;
 	SavedGame *_save;
 	Ruleset *_rules;
-	bool _quit, _init;
+	bool _quit, _init, _redraw;
 	FpsCounter *_fpsCounter;
+	ProfilerOverlay *_profilerOverlay;
+	Uint32 _lastFrame;
+	Surface *_underlay;
+	bool _underlayValid;
+	/// Passes an event to the screen, cursor and active state.
+	bool handleEvent(SDL_Event *event);
 public:
 	/// Creates a new game and initializes SDL.
 	Game(const std::string &title, int width, int height, int bpp);
@@ -77,6 +87,10 @@ public:
 	void pushState(State *state);
 	/// Pops the last state from the state stack.
 	void popState();
+	/// Takes a closed state of a certain type out of the cache.
+	template <class T> T *getCachedState();
+	/// Throws away all the closed states kept for reuse.
+	void clearStateCache();
 	/// Gets the currently loaded language.
 	Language *const getLanguage() const;
 	/// Sets a new language for the game.
@@ -95,6 +109,27 @@ public:
 	void setRuleset(Ruleset *rules);
 };
 
+/**
+ * Looks for a state that was closed and kept for reuse,
+ * so a screen can be opened again without building all
+ * its elements. The state is taken out of the cache and
+ * gets init() called when it's pushed, like a new one.
+ * @return Pointer to the state, or 0 if there's none.
+ */
+template <class T> T *Game::getCachedState()
+{
+	for (std::list<State*>::iterator i = _cache.begin(); i != _cache.end(); i++)
+	{
+		T *state = dynamic_cast<T*>(*i);
+		if (state != 0)
+		{
+			_cache.erase(i);
+			return state;
+		}
+	}
+	return 0;
+}
+
 }
 
 #endif
@@ -162,6 +162,48 @@ void InteractiveSurface::unpress(State *state)
 	}
 }
 
+/**
+ * Returns the area of the screen where mouse events can affect
+ * the surface, so the state only passes them on when they do.
+ * @return Area in unscaled screen pixels.
+ */
+SDL_Rect InteractiveSurface::getEventArea() const
+{
+	SDL_Rect area;
+	area.x = getX();
+	area.y = getY();
+	area.w = getWidth();
+	area.h = getHeight();
+	return area;
+}
+
+/**
+ * Returns if the mouse was over the surface on the last mouse event.
+ * @return True if hovered.
+ */
+bool InteractiveSurface::isHovered() const
+{
+	return _isHovered;
+}
+
+/**
+ * Returns if a mouse button was pressed on the surface and not released yet.
+ * @return True if pressed.
+ */
+bool InteractiveSurface::isPressed() const
+{
+	return _isPressed;
+}
+
+/**
+ * Returns if the surface receives keyboard events.
+ * @return True if focused.
+ */
+bool InteractiveSurface::isFocused() const
+{
+	return _isFocused;
+}
+
 /**
  * Called everytime there's a mouse press over the surface.
  * Allows the surface to have custom functionality for this action,
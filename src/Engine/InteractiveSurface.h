@@ -55,6 +55,14 @@ public:
 	virtual void focus();
 	/// Unpresses the surface.
 	virtual void unpress(State *state);
+	/// Gets the area of the screen the surface takes mouse events in.
+	virtual SDL_Rect getEventArea() const;
+	/// Gets if the mouse is over the surface.
+	bool isHovered() const;
+	/// Gets if the surface is pressed.
+	bool isPressed() const;
+	/// Gets if the surface is focused.
+	bool isFocused() const;
 	/// Hooks an action handler to a mouse click on the surface.
 	void onMouseClick(ActionHandler handler);
 	/// Hooks an action handler to a mouse press over the surface.
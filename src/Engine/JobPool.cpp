@@ -0,0 +1,422 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "JobPool.h"
+#include <algorithm>
+#include "CrossPlatform.h"
+
+namespace OpenXcom
+{
+
+std::vector<JobPool::Worker*> JobPool::_workers;
+SDL_mutex *JobPool::_mutex = 0;
+SDL_cond *JobPool::_wake = 0;
+SDL_cond *JobPool::_done = 0;
+int JobPool::_pending = 0;
+int JobPool::_next = 0;
+bool JobPool::_quit = false;
+std::vector<JobPool::Job> JobPool::_posted;
+
+/**
+ * Creates a job group with no jobs.
+ */
+JobGroup::JobGroup() : _left(0)
+{
+}
+
+/**
+ * Makes sure none of the group's jobs are still
+ * running before it goes away.
+ */
+JobGroup::~JobGroup()
+{
+	JobPool::wait(this);
+}
+
+/**
+ * Starts the worker threads. Done automatically the
+ * first time a job is run.
+ * @param threads Number of workers, 0 for one less than the cores.
+ */
+void JobPool::init(int threads)
+{
+	if (_mutex != 0)
+		return;
+	if (threads == 0)
+	{
+		threads = std::max(1, CrossPlatform::getCoreCount() - 1);
+	}
+	_mutex = SDL_CreateMutex();
+	_wake = SDL_CreateCond();
+	_done = SDL_CreateCond();
+	_quit = false;
+	for (int i = 0; i < threads; i++)
+	{
+		Worker *w = new Worker();
+		w->thread = 0;
+		w->id = 0;
+		w->index = i;
+		w->mutex = SDL_CreateMutex();
+		_workers.push_back(w);
+	}
+	// the list can't change once a thread is running, so workers
+	// whose thread didn't start are kept but never given jobs
+	// the thread IDs are set before anyone can look for a worker
+	int started = 0;
+	SDL_mutexP(_mutex);
+	for (std::vector<Worker*>::iterator i = _workers.begin(); i != _workers.end(); i++)
+	{
+		(*i)->thread = SDL_CreateThread(runWorker, *i);
+		if ((*i)->thread != 0)
+		{
+			(*i)->id = SDL_GetThreadID((*i)->thread);
+			started++;
+		}
+	}
+	SDL_mutexV(_mutex);
+	if (started == 0)
+	{
+		for (std::vector<Worker*>::iterator i = _workers.begin(); i != _workers.end(); i++)
+		{
+			SDL_DestroyMutex((*i)->mutex);
+			delete *i;
+		}
+		_workers.clear();
+	}
+}
+
+/**
+ * Stops the worker threads once they're done with
+ * their current jobs. Nothing can be waiting on them.
+ */
+void JobPool::quit()
+{
+	if (_mutex == 0)
+		return;
+	SDL_mutexP(_mutex);
+	_quit = true;
+	SDL_CondBroadcast(_wake);
+	SDL_mutexV(_mutex);
+	for (std::vector<Worker*>::iterator i = _workers.begin(); i != _workers.end(); i++)
+	{
+		if ((*i)->thread != 0)
+		{
+			SDL_WaitThread((*i)->thread, 0);
+		}
+		SDL_DestroyMutex((*i)->mutex);
+		delete *i;
+	}
+	_workers.clear();
+	SDL_DestroyCond(_done);
+	SDL_DestroyCond(_wake);
+	SDL_DestroyMutex(_mutex);
+	_done = _wake = 0;
+	_mutex = 0;
+}
+
+/**
+ * Returns the number of worker threads in the pool,
+ * not counting the threads that help while waiting.
+ * @return Number of threads.
+ */
+int JobPool::getThreads()
+{
+	init();
+	int threads = 0;
+	for (std::vector<Worker*>::iterator i = _workers.begin(); i != _workers.end(); i++)
+	{
+		if ((*i)->thread != 0)
+		{
+			threads++;
+		}
+	}
+	return threads;
+}
+
+/**
+ * Entry point of a worker thread. Runs jobs from its
+ * own queue, newest first, or steals the oldest from the
+ * others, and sleeps when there's nothing to do.
+ * @param worker Pointer to the worker.
+ * @return Always 0.
+ */
+int JobPool::runWorker(void *worker)
+{
+	Worker *self = (Worker*)worker;
+	while (true)
+	{
+		Job job;
+		if (takeJob(self->index, 0, &job))
+		{
+			execute(job);
+			continue;
+		}
+		SDL_mutexP(_mutex);
+		while (_pending <= 0 && !_quit)
+		{
+			SDL_CondWait(_wake, _mutex);
+		}
+		bool quit = _quit;
+		SDL_mutexV(_mutex);
+		if (quit)
+			return 0;
+	}
+}
+
+/**
+ * Returns the worker running on the current thread.
+ * @return Worker index, or -1 if it's not a worker.
+ */
+int JobPool::findWorker()
+{
+	Uint32 id = SDL_ThreadID();
+	for (size_t i = 0; i < _workers.size(); i++)
+	{
+		if (_workers[i]->id == id)
+			return i;
+	}
+	return -1;
+}
+
+/**
+ * Takes a job out of the queues, starting with the
+ * worker's own and then stealing from the others.
+ * @param worker Worker index, or -1 to only steal.
+ * @param group Only take jobs of this group, or 0 for any.
+ * @param job Pointer to store the job.
+ * @return Whether a job was found.
+ */
+bool JobPool::takeJob(int worker, JobGroup *group, Job *job)
+{
+	int size = _workers.size();
+	for (int n = 0; n < size; n++)
+	{
+		int w = (worker == -1) ? n : (worker + n) % size;
+		Worker *q = _workers[w];
+		bool found = false;
+		SDL_mutexP(q->mutex);
+		if (!q->jobs.empty())
+		{
+			if (group == 0)
+			{
+				if (w == worker)
+				{
+					*job = q->jobs.back();
+					q->jobs.pop_back();
+				}
+				else
+				{
+					*job = q->jobs.front();
+					q->jobs.pop_front();
+				}
+				found = true;
+			}
+			else
+			{
+				for (std::deque<Job>::iterator i = q->jobs.begin(); i != q->jobs.end(); i++)
+				{
+					if (i->group == group)
+					{
+						*job = *i;
+						q->jobs.erase(i);
+						found = true;
+						break;
+					}
+				}
+			}
+		}
+		SDL_mutexV(q->mutex);
+		if (found)
+		{
+			SDL_mutexP(_mutex);
+			_pending--;
+			SDL_mutexV(_mutex);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Runs a job and marks it done in its group.
+ * @param job Job to run.
+ */
+void JobPool::execute(const Job &job)
+{
+	job.function(job.data);
+	SDL_mutexP(_mutex);
+	job.group->_left--;
+	if (job.group->_left == 0)
+	{
+		SDL_CondBroadcast(_done);
+	}
+	SDL_mutexV(_mutex);
+}
+
+/**
+ * Queues a job to be run by the pool. Jobs run from a worker
+ * go in its own queue, the rest are spread over the workers.
+ * Without any workers the job is just run straight away.
+ * @param group Pointer to the group the job belongs to.
+ * @param function Function to run.
+ * @param data Data to pass to the function.
+ */
+void JobPool::run(JobGroup *group, JobFunction function, void *data)
+{
+	init();
+	if (_workers.empty())
+	{
+		function(data);
+		return;
+	}
+
+	Job job = { function, data, group };
+	int w = findWorker();
+	SDL_mutexP(_mutex);
+	group->_left++;
+	if (w == -1)
+	{
+		do
+		{
+			w = _next;
+			_next = (_next + 1) % _workers.size();
+		}
+		while (_workers[w]->thread == 0);
+	}
+	SDL_mutexV(_mutex);
+
+	SDL_mutexP(_workers[w]->mutex);
+	_workers[w]->jobs.push_back(job);
+	SDL_mutexV(_workers[w]->mutex);
+
+	SDL_mutexP(_mutex);
+	_pending++;
+	SDL_CondSignal(_wake);
+	SDL_mutexV(_mutex);
+}
+
+/**
+ * Waits until all the jobs in a group are done. Meanwhile
+ * the thread runs any of the group's jobs still queued,
+ * but nothing else, so it's not held up by longer jobs.
+ * @param group Pointer to the group.
+ */
+void JobPool::wait(JobGroup *group)
+{
+	if (_mutex == 0)
+		return;
+	while (true)
+	{
+		SDL_mutexP(_mutex);
+		bool done = (group->_left == 0);
+		SDL_mutexV(_mutex);
+		if (done)
+			return;
+
+		Job job;
+		if (takeJob(findWorker(), group, &job))
+		{
+			execute(job);
+			continue;
+		}
+
+		SDL_mutexP(_mutex);
+		if (group->_left > 0)
+		{
+			SDL_CondWait(_done, _mutex);
+		}
+		SDL_mutexV(_mutex);
+	}
+}
+
+/**
+ * Runs the indexes of a chunk of a range.
+ * @param range Pointer to the range.
+ * @return Always 0.
+ */
+int JobPool::runRange(void *range)
+{
+	Range *r = (Range*)range;
+	for (int i = r->begin; i < r->end; i++)
+	{
+		r->function(r->data, i);
+	}
+	return 0;
+}
+
+/**
+ * Runs a function for every index from 0 to count, split
+ * into a few chunks per thread so they even out, and
+ * waits for them all.
+ * @param count Number of indexes.
+ * @param function Function to run for each index.
+ * @param data Data to pass to the function.
+ */
+void JobPool::parallelFor(int count, IndexFunction function, void *data)
+{
+	if (count <= 0)
+		return;
+	int chunks = std::min(count, (getThreads() + 1) * 4);
+	std::vector<Range> ranges(chunks);
+	JobGroup group;
+	for (int i = 0; i < chunks; i++)
+	{
+		ranges[i].function = function;
+		ranges[i].data = data;
+		ranges[i].begin = count * i / chunks;
+		ranges[i].end = count * (i + 1) / chunks;
+		run(&group, runRange, &ranges[i]);
+	}
+	wait(&group);
+}
+
+/**
+ * Queues a function to be run on the main thread the next
+ * time it calls runPosted(), for jobs to hand over results
+ * that only the main thread can use.
+ * @param function Function to run.
+ * @param data Data to pass to the function.
+ */
+void JobPool::post(JobFunction function, void *data)
+{
+	init();
+	Job job = { function, data, 0 };
+	SDL_mutexP(_mutex);
+	_posted.push_back(job);
+	SDL_mutexV(_mutex);
+}
+
+/**
+ * Runs all the functions posted for the main thread,
+ * in the order they were posted.
+ */
+void JobPool::runPosted()
+{
+	if (_mutex == 0)
+		return;
+	std::vector<Job> posted;
+	SDL_mutexP(_mutex);
+	posted.swap(_posted);
+	SDL_mutexV(_mutex);
+	for (std::vector<Job>::iterator i = posted.begin(); i != posted.end(); i++)
+	{
+		i->function(i->data);
+	}
+}
+
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_JOBPOOL_H
+#define OPENXCOM_JOBPOOL_H
+
+#include <vector>
+#include <deque>
+#include "SDL.h"
+
+namespace OpenXcom
+{
+
+/// A job to run, with the same signature as an SDL thread function.
+typedef int (*JobFunction)(void *data);
+/// A job to run for one index of a range.
+typedef void (*IndexFunction)(void *data, int index);
+
+/**
+ * A set of jobs that can be waited on together.
+ * It waits for its jobs before going away.
+ */
+class JobGroup
+{
+private:
+	int _left;
+	friend class JobPool;
+public:
+	/// Creates an empty job group.
+	JobGroup();
+	/// Waits for the jobs in the group and cleans it up.
+	~JobGroup();
+};
+
+/**
+ * A pool of worker threads shared by the whole engine, one less
+ * than the number of cores since the main thread works too.
+ * Each worker has its own queue of jobs and steals from the others
+ * when it runs out, and threads waiting on a group help with its
+ * jobs. A job owns whatever nothing else touches until it's over:
+ * it may draw from an RNG stream only it uses while it runs (like
+ * RNG_BATTLE while a battlescape is generated), and create and fill
+ * Surfaces and SurfaceSets that aren't shown or shared until then.
+ * Anything else that assumes a single thread, like the screen,
+ * the palette or the other RNG streams, stays on the main thread;
+ * jobs can post work to be done there once they're over.
+ * Profiler memory counts and file lookups are safe from any thread.
+ */
+class JobPool
+{
+private:
+	/// A job waiting in a queue.
+	struct Job
+	{
+		JobFunction function;
+		void *data;
+		JobGroup *group;
+	};
+	/// A worker thread and its queue of jobs.
+	struct Worker
+	{
+		SDL_Thread *thread;
+		Uint32 id;
+		int index;
+		SDL_mutex *mutex;
+		std::deque<Job> jobs;
+	};
+	/// A chunk of a range of indexes.
+	struct Range
+	{
+		IndexFunction function;
+		void *data;
+		int begin, end;
+	};
+	static std::vector<Worker*> _workers;
+	static SDL_mutex *_mutex;
+	static SDL_cond *_wake, *_done;
+	static int _pending, _next;
+	static bool _quit;
+	static std::vector<Job> _posted;
+	static int runWorker(void *worker);
+	static int runRange(void *range);
+	static int findWorker();
+	static bool takeJob(int worker, JobGroup *group, Job *job);
+	static void execute(const Job &job);
+public:
+	/// Starts the worker threads.
+	static void init(int threads = 0);
+	/// Stops the worker threads.
+	static void quit();
+	/// Gets the number of worker threads.
+	static int getThreads();
+	/// Runs a job on the pool as part of a group.
+	static void run(JobGroup *group, JobFunction function, void *data);
+	/// Waits for all the jobs in a group, helping with them meanwhile.
+	static void wait(JobGroup *group);
+	/// Runs a function for every index in a range, split between the threads.
+	static void parallelFor(int count, IndexFunction function, void *data);
+	/// Queues a function to be run on the main thread.
+	static void post(JobFunction function, void *data);
+	/// Runs the functions posted for the main thread.
+	static void runPosted();
+};
+
+}
+
+#endif
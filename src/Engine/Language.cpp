@@ -27,9 +27,9 @@ namespace OpenXcom
 /**
  * Initializes an empty language file.
  */
-Language::Language() : _name(L""), _strings()
+Language::Language() : _name(L""), _utf8(), _strings(), _missing()
 {
-
+	_mutex = SDL_CreateMutex();
 }
 
 /**
@@ -37,7 +37,7 @@ Language::Language() : _name(L""), _strings()
  */
 Language::~Language()
 {
-	
+	SDL_DestroyMutex(_mutex);
 }
 
 /**
@@ -151,59 +151,57 @@ std::string Language::wstrToUtf8(const std::wstring& src)
  */
 void Language::loadLng(const std::string &filename)
 {
+	_utf8.clear();
 	_strings.clear();
+	_missing.clear();
 	
-	// Load file and put text in map
+	// Load the whole file at once
 	std::ifstream txtFile (filename.c_str(), std::ios::in | std::ios::binary);
 	if (!txtFile)
 	{
 		throw Exception("Failed to load LNG");
 	}
-	
-	char value;
-	std::string buffer, bufid;
-	std::wstring bufstr;
+
+	txtFile.seekg(0, std::ios::end);
+	std::streamoff size = txtFile.tellg();
+	txtFile.seekg(0, std::ios::beg);
+	std::string data((size_t)size, '\0');
+	if (size > 0 && !txtFile.read(&data[0], size))
+	{
+		throw Exception("Invalid data from file");
+	}
+	txtFile.close();
+
+	// Put text in map, strings are only
+	// converted when they're first used
+	std::string bufid;
 	bool first = true, id = true;
+	size_t start = 0, end;
 
-	while (txtFile.read(&value, 1))
+	while ((end = data.find('\0', start)) != std::string::npos)
 	{
-		if (value != '\0')
+		// Get language name
+		if (first)
 		{
-			buffer += value;
+			_name = utf8ToWstr(data.substr(start, end - start));
+			first = false;
 		}
 		else
 		{
-			// Get language name
-			if (first)
+			// Get ID
+			if (id)
 			{
-				_name = utf8ToWstr(buffer);
-				first = false;
+				bufid.assign(data, start, end - start);
 			}
+			// Get string
 			else
 			{
-				// Get ID
-				if (id)
-				{
-					bufid = buffer;
-				}
-				// Get string
-				else
-				{
-					bufstr = utf8ToWstr(buffer);
-					_strings[bufid] = bufstr;
-				}
-				id = !id;
+				_utf8[bufid].assign(data, start, end - start);
 			}
-			buffer.clear();
+			id = !id;
 		}
+		start = end + 1;
 	}
-
-	if (!txtFile.eof())
-	{
-		throw Exception("Invalid data from file");
-	}
-
-	txtFile.close();
 }
 
 /**
@@ -217,22 +215,39 @@ std::wstring Language::getName() const
 
 /**
  * Returns the localizable string with the specified ID.
- * If it's not found, just returns the ID.
+ * If it's not found, just returns the ID. The string is
+ * returned by reference so UI text can be built from it
+ * without copying, and stays valid until the language
+ * is loaded again. Strings are decoded and stored under
+ * a lock, since jobs look them up too.
  * @param id ID of the string.
  * @return String with the requested ID.
  */
-std::wstring Language::getString(const std::string &id) const
+const std::wstring &Language::getString(const std::string &id) const
 {
+	SDL_mutexP(_mutex);
 	std::map<std::string, std::wstring>::const_iterator s = _strings.find(id);
 	if (s == _strings.end())
 	{
-		std::wcout << "WARNING: " << utf8ToWstr(id) << " not found in " << _name << std::endl;
-		return utf8ToWstr(id);
-	}
-	else
-	{
-		return s->second;
+		std::map<std::string, std::string>::const_iterator u = _utf8.find(id);
+		if (u != _utf8.end())
+		{
+			s = _strings.insert(std::make_pair(id, utf8ToWstr(u->second))).first;
+		}
+		else
+		{
+			s = _missing.find(id);
+			if (s == _missing.end())
+			{
+				std::wstring str = utf8ToWstr(id);
+				std::wcout << "WARNING: " << str << " not found in " << _name << std::endl;
+				s = _missing.insert(std::make_pair(id, str)).first;
+			}
+		}
 	}
+	const std::wstring &str = s->second;
+	SDL_mutexV(_mutex);
+	return str;
 }
 
 /**
@@ -244,10 +259,11 @@ void Language::toHtml() const
 	std::ofstream htmlFile ("lang.html", std::ios::out);
 	htmlFile << "<table border=\"1\" width=\"100%\">" << std::endl;
 	htmlFile << "<tr><th>ID String</th><th>English String</th></tr>" << std::endl;
-	for (std::map<std::string, std::wstring>::const_iterator i = _strings.begin(); i != _strings.end(); i++)
+	for (std::map<std::string, std::string>::const_iterator i = _utf8.begin(); i != _utf8.end(); i++)
 	{
+		const std::wstring &str = getString(i->first);
 		htmlFile << "<tr><td>" << i->first << "</td><td>";
-		for (std::wstring::const_iterator j = i->second.begin(); j != i->second.end(); j++)
+		for (std::wstring::const_iterator j = str.begin(); j != str.end(); j++)
 		{
 			if (*j == 2 || *j == '\n')
 			{
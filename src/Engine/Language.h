@@ -21,6 +21,7 @@
 
 #include <map>
 #include <string>
+#include "SDL.h"
 
 namespace OpenXcom
 {
@@ -28,12 +29,15 @@ namespace OpenXcom
 /**
  * Contains strings used throughout the game for localization.
  * Languages are just a set of strings identified by an ID string.
+ * Strings can be looked up from any thread.
  */
 class Language
 {
 private:
 	std::wstring _name;
-	std::map<std::string, std::wstring> _strings;
+	std::map<std::string, std::string> _utf8;
+	mutable std::map<std::string, std::wstring> _strings, _missing;
+	SDL_mutex *_mutex;
 public:
 	/// Creates a blank language.
 	Language();
@@ -48,7 +52,7 @@ public:
 	/// Gets the language's name.
 	std::wstring getName() const;
 	/// Gets a string from the language.
-	std::wstring getString(const std::string &id) const;
+	const std::wstring &getString(const std::string &id) const;
 	/// Outputs the language to a HTML file.
 	void toHtml() const;
 };
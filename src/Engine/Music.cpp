@@ -22,10 +22,12 @@
 namespace OpenXcom
 {
 
+const Music *Music::_playing = 0;
+
 /**
  * Initializes a new music track.
  */
-Music::Music() : _music(0)
+Music::Music() : _music(0), _rw(0), _filename(), _data()
 {
 }
 
@@ -34,47 +36,110 @@ Music::Music() : _music(0)
  */
 Music::~Music()
 {
-	Mix_FreeMusic(_music);
+	if (_playing == this)
+	{
+		_playing = 0;
+	}
+	close();
 }
 
 /**
- * Loads a music file from a specified filename.
+ * Sets the music to play from a file. The file is only
+ * opened when the music plays, and streamed from there.
  * @param filename Filename of the music file.
  */
 void Music::load(const std::string &filename)
 {
-	_music = Mix_LoadMUS(filename.c_str());
-	if (_music == 0) 
-	{
-		throw Exception(Mix_GetError());
-	}
+	_filename = filename;
+	_data.clear();
 }
 
 /**
- * Loads a music file from a specified memory chunk.
+ * Sets the music to play from a copy of a memory chunk,
+ * for music that has to be converted before it can play.
  * @param data Pointer to the music file in memory
  * @param size Size of the music file in bytes.
  */
 void Music::load(const void *data, unsigned int size)
 {
-	SDL_RWops *rwops = SDL_RWFromConstMem(data, size);
-	_music = Mix_LoadMUS_RW(rwops);
-	SDL_FreeRW(rwops);
+	_filename.clear();
+	_data.assign((const Uint8*)data, (const Uint8*)data + size);
+}
+
+/**
+ * Opens the music through SDL_mixer, which only reads as
+ * much of it as it needs to start decoding.
+ */
+void Music::open() const
+{
+	if (_music != 0)
+		return;
+
+	if (!_filename.empty())
+	{
+		_music = Mix_LoadMUS(_filename.c_str());
+	}
+	else if (!_data.empty())
+	{
+		// SDL_mixer keeps reading from this while the music plays
+		_rw = SDL_RWFromConstMem(&_data[0], _data.size());
+		_music = Mix_LoadMUS_RW(_rw);
+	}
+	else
+	{
+		return;
+	}
 	if (_music == 0)
 	{
+		close();
 		throw Exception(Mix_GetError());
 	}
 }
 
 /**
- * Plays the contained music track.
+ * Closes the music and whatever SDL_mixer was decoding it with.
+ */
+void Music::close() const
+{
+	if (_music != 0)
+	{
+		Mix_FreeMusic(_music);
+		_music = 0;
+	}
+	if (_rw != 0)
+	{
+		SDL_FreeRW(_rw);
+		_rw = 0;
+	}
+}
+
+/**
+ * Plays the contained music track. If it's already
+ * playing it just carries on, instead of restarting
+ * the track through SDL_mixer. The new track is opened
+ * before the old one stops, so there's no wait between
+ * them, and the old one is closed right after.
  */
 void Music::play() const
 {
-	if (_music != 0 && Mix_PlayMusic(_music, -1) == -1)
+	if (_playing == this && Mix_PlayingMusic())
+	{
+		return;
+	}
+	open();
+	if (_music == 0)
+	{
+		return;
+	}
+	if (Mix_PlayMusic(_music, -1) == -1)
 	{
 		throw Exception(Mix_GetError());
 	}
+	if (_playing != 0 && _playing != this)
+	{
+		_playing->close();
+	}
+	_playing = this;
 }
 
 }
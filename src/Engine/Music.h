@@ -20,6 +20,7 @@
 #define OPENXCOM_MUSIC_H
 
 #include <string>
+#include <vector>
 #include "SDL_mixer.h"
 
 namespace OpenXcom
@@ -28,11 +29,22 @@ namespace OpenXcom
 /**
  * Container for music tracks.
  * Handles loading and playing various formats through SDL_mixer.
+ * A track is only opened while it's playing, and SDL_mixer
+ * decodes it bit by bit on the audio thread, so a long
+ * soundtrack takes no more memory than a short one.
  */
 class Music
 {
 private:
-	Mix_Music *_music;
+	mutable Mix_Music *_music;
+	mutable SDL_RWops *_rw;
+	std::string _filename;
+	std::vector<Uint8> _data;
+	static const Music *_playing;
+	/// Opens the music for playing.
+	void open() const;
+	/// Closes the music after playing.
+	void close() const;
 public:
 	/// Creates a blank music track.
 	Music();
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _USE_MATH_DEFINES
+#include "PolarGrid.h"
+#include <cmath>
+#include <algorithm>
+
+namespace OpenXcom
+{
+
+/**
+ * Returns the width of every column in the grid.
+ * @return Longitude in radians.
+ */
+double PolarGrid::getCellLongitude()
+{
+	return 2 * M_PI / COLUMNS;
+}
+
+/**
+ * Returns the height of every row in the grid.
+ * @return Latitude in radians.
+ */
+double PolarGrid::getCellLatitude()
+{
+	return M_PI / ROWS;
+}
+
+/**
+ * Returns the index of the grid cell a point falls in,
+ * wrapping the longitude around the world.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return Cell index (row * COLUMNS + column).
+ */
+int PolarGrid::getCell(double lon, double lat)
+{
+	lon = fmod(lon, 2 * M_PI);
+	if (lon < 0)
+		lon += 2 * M_PI;
+	int col = std::min((int)(lon / (2 * M_PI) * COLUMNS), COLUMNS - 1);
+	int row = std::max(0, std::min((int)((lat + M_PI / 2) / M_PI * ROWS), ROWS - 1));
+	return row * COLUMNS + col;
+}
+
+/**
+ * Returns the longitude/latitude bounds of a grid cell.
+ * @param cell Cell index.
+ * @param lonMin Pointer to store the minimum longitude.
+ * @param lonMax Pointer to store the maximum longitude.
+ * @param latMin Pointer to store the minimum latitude.
+ * @param latMax Pointer to store the maximum latitude.
+ */
+void PolarGrid::getCellArea(int cell, double *lonMin, double *lonMax, double *latMin, double *latMax)
+{
+	int col = cell % COLUMNS, row = cell / COLUMNS;
+	*lonMin = col * getCellLongitude();
+	*lonMax = (col + 1) * getCellLongitude();
+	*latMin = row * getCellLatitude() - M_PI / 2;
+	*latMax = (row + 1) * getCellLatitude() - M_PI / 2;
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_POLARGRID_H
+#define OPENXCOM_POLARGRID_H
+
+namespace OpenXcom
+{
+
+/**
+ * Splits the world into a grid of longitude/latitude cells,
+ * so lookups by position only have to go through the
+ * things in one cell instead of the whole world.
+ * Shared by every spatial index so they all agree on the cells.
+ */
+class PolarGrid
+{
+private:
+	PolarGrid();
+	~PolarGrid();
+public:
+	/// Number of longitude columns in the grid.
+	static const int COLUMNS = 72;
+	/// Number of latitude rows in the grid.
+	static const int ROWS = 36;
+	/// Gets the width of a cell in radians.
+	static double getCellLongitude();
+	/// Gets the height of a cell in radians.
+	static double getCellLatitude();
+	/// Gets the cell containing a point.
+	static int getCell(double lon, double lat);
+	/// Gets the area covered by a cell.
+	static void getCellArea(int cell, double *lonMin, double *lonMax, double *latMin, double *latMax);
+};
+
+}
+
+#endif
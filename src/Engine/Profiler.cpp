@@ -0,0 +1,407 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Profiler.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+#include "Exception.h"
+
+namespace OpenXcom
+{
+
+bool Profiler::_enabled = false;
+Uint32 Profiler::_thread = 0;
+int Profiler::_current = 0;
+int Profiler::_depth[PROF_SECTIONS];
+double Profiler::_frames[PROFILE_FRAMES][PROF_SECTIONS];
+std::ofstream *Profiler::_trace = 0;
+double Profiler::_traceStart = 0;
+bool Profiler::_traceFirst = true;
+long Profiler::_memory[MEM_TAGS];
+long Profiler::_tracedMemory[MEM_TAGS];
+SDL_mutex *Profiler::_memoryMutex = SDL_CreateMutex();
+
+/**
+ * Returns the name of a section, for display.
+ * @param section Profiled section.
+ * @return Section name.
+ */
+const char *Profiler::getName(ProfileSection section)
+{
+	static const char *names[PROF_SECTIONS] = {"events", "think", "blit", "flip", "terrain", "globe", "fov", "lighting", "paths"};
+	return names[section];
+}
+
+/**
+ * Returns the current time with sub-millisecond precision,
+ * which SDL_GetTicks doesn't have.
+ * @return Time in microseconds.
+ */
+double Profiler::getTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER count, frequency;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return count.QuadPart * 1000000.0 / frequency.QuadPart;
+#else
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec * 1000000.0 + tv.tv_usec;
+#endif
+}
+
+/**
+ * Turns the profiler on or off. The past frames are
+ * cleared when it's turned on, and from then on
+ * only the calling thread is timed.
+ * @param enabled Profiler on?
+ */
+void Profiler::setEnabled(bool enabled)
+{
+	if (enabled && !_enabled)
+	{
+		_thread = SDL_ThreadID();
+		_current = 0;
+		for (int i = 0; i < PROFILE_FRAMES; i++)
+		{
+			for (int j = 0; j < PROF_SECTIONS; j++)
+			{
+				_frames[i][j] = 0;
+			}
+		}
+		for (int j = 0; j < PROF_SECTIONS; j++)
+		{
+			_depth[j] = 0;
+		}
+	}
+	_enabled = enabled;
+}
+
+/**
+ * Returns whether the profiler is timing anything.
+ * @return Profiler on?
+ */
+bool Profiler::isEnabled()
+{
+	return _enabled;
+}
+
+/**
+ * Starts timing a section. Sections that call
+ * themselves (like batched pathfinding) are only
+ * timed from the outermost call.
+ * @param section Profiled section.
+ * @return Whether this call should be timed.
+ */
+bool Profiler::begin(ProfileSection section)
+{
+	if ((!_enabled && _trace == 0) || SDL_ThreadID() != _thread)
+		return false;
+	if (_depth[section]++ != 0)
+		return false;
+	trace(getName(section), 'B');
+	return true;
+}
+
+/**
+ * Stops timing a section and adds its time to the current frame.
+ * @param section Profiled section.
+ * @param time Time spent in microseconds.
+ */
+void Profiler::end(ProfileSection section, double time)
+{
+	_depth[section] = 0;
+	_frames[_current][section] += time;
+	trace(getName(section), 'E');
+}
+
+/**
+ * Closes the current frame and starts timing a new one,
+ * replacing the oldest frame. When tracing, the memory in use
+ * is recorded too, whenever it changed.
+ */
+void Profiler::endFrame()
+{
+	if (_trace != 0)
+	{
+		bool changed = false;
+		for (int j = 0; j < MEM_TAGS; j++)
+		{
+			long memory = getMemory((MemoryTag)j);
+			changed = changed || (memory != _tracedMemory[j]);
+			_tracedMemory[j] = memory;
+		}
+		if (changed)
+		{
+			std::stringstream ss;
+			ss << "{";
+			for (int j = 0; j < MEM_TAGS; j++)
+			{
+				ss << (j == 0 ? "" : ",") << "\"" << getMemoryName((MemoryTag)j) << "\":" << _tracedMemory[j];
+			}
+			ss << "}";
+			trace("memory", 'C', ss.str().c_str());
+		}
+	}
+	if (!_enabled)
+		return;
+	_current = (_current + 1) % PROFILE_FRAMES;
+	for (int j = 0; j < PROF_SECTIONS; j++)
+	{
+		_frames[_current][j] = 0;
+	}
+}
+
+/**
+ * Returns the time a section took in a past frame.
+ * @param frame Frames ago, 0 being the last finished frame.
+ * @param section Profiled section.
+ * @return Time spent in microseconds.
+ */
+double Profiler::getFrameTime(int frame, ProfileSection section)
+{
+	return _frames[(_current - 1 - frame + PROFILE_FRAMES * 2) % PROFILE_FRAMES][section];
+}
+
+/**
+ * Returns the average time a section took over the past frames.
+ * @param section Profiled section.
+ * @return Time spent in microseconds.
+ */
+double Profiler::getAverageTime(ProfileSection section)
+{
+	double total = 0;
+	for (int i = 0; i < PROFILE_FRAMES - 1; i++)
+	{
+		total += getFrameTime(i, section);
+	}
+	return total / (PROFILE_FRAMES - 1);
+}
+
+/**
+ * Saves the past frames to a CSV file, oldest first,
+ * with a column of milliseconds for each section.
+ * @param filename Filename of the CSV file.
+ */
+void Profiler::save(const std::string &filename)
+{
+	std::ofstream out(filename.c_str());
+	if (!out)
+	{
+		throw Exception("Failed to save profile");
+	}
+	out << "frame";
+	for (int j = 0; j < PROF_SECTIONS; j++)
+	{
+		out << "," << getName((ProfileSection)j);
+	}
+	out << std::endl;
+	for (int i = PROFILE_FRAMES - 2; i >= 0; i--)
+	{
+		out << PROFILE_FRAMES - 2 - i;
+		for (int j = 0; j < PROF_SECTIONS; j++)
+		{
+			out << "," << getFrameTime(i, (ProfileSection)j) / 1000;
+		}
+		out << std::endl;
+	}
+	out.close();
+}
+
+/**
+ * Starts recording trace events to a file in the
+ * Chrome trace format, timed from now on.
+ * @param filename Filename of the trace file.
+ */
+void Profiler::startTrace(const std::string &filename)
+{
+	stopTrace();
+	_trace = new std::ofstream(filename.c_str());
+	if (!*_trace)
+	{
+		delete _trace;
+		_trace = 0;
+		throw Exception("Failed to save trace");
+	}
+	if (!_enabled)
+	{
+		_thread = SDL_ThreadID();
+		for (int j = 0; j < PROF_SECTIONS; j++)
+		{
+			_depth[j] = 0;
+		}
+	}
+	_traceStart = getTime();
+	_traceFirst = true;
+	*_trace << "[";
+}
+
+/**
+ * Closes the trace file, if one is being recorded.
+ */
+void Profiler::stopTrace()
+{
+	if (_trace == 0)
+		return;
+	*_trace << "\n]\n";
+	_trace->close();
+	delete _trace;
+	_trace = 0;
+}
+
+/**
+ * Records an event in the trace file, if one is being
+ * recorded and this is the profiled thread.
+ * @param name Event name.
+ * @param phase Event phase: 'B' for begin, 'E' for end, 'i' for instant, 'C' for counters.
+ * @param detail Extra info shown with the event, if any, or a JSON object of values for counters.
+ * @return Whether the event was recorded.
+ */
+bool Profiler::trace(const char *name, char phase, const char *detail)
+{
+	if (_trace == 0 || SDL_ThreadID() != _thread)
+		return false;
+	if (!_traceFirst)
+	{
+		*_trace << ",";
+	}
+	_traceFirst = false;
+	*_trace << "\n{\"name\":\"" << name << "\",\"ph\":\"" << phase << "\",\"ts\":" << std::fixed << std::setprecision(0) << getTime() - _traceStart << ",\"pid\":1,\"tid\":1";
+	if (phase == 'i')
+	{
+		*_trace << ",\"s\":\"g\"";
+	}
+	if (detail != 0 && phase == 'C')
+	{
+		*_trace << ",\"args\":" << detail;
+	}
+	else if (detail != 0)
+	{
+		*_trace << ",\"args\":{\"detail\":\"" << detail << "\"}";
+	}
+	*_trace << "}";
+	return true;
+}
+
+/**
+ * Returns the name of a memory tag, for display.
+ * @param tag Memory tag.
+ * @return Tag name.
+ */
+const char *Profiler::getMemoryName(MemoryTag tag)
+{
+	static const char *names[MEM_TAGS] = {"surfaces", "sprites", "sounds", "mapcache", "paths", "tiles"};
+	return names[tag];
+}
+
+/**
+ * Counts memory something took, or gave back.
+ * Can be called from any thread.
+ * @param tag What the memory is used for.
+ * @param bytes Bytes taken, negative when given back.
+ */
+void Profiler::addMemory(MemoryTag tag, long bytes)
+{
+	SDL_mutexP(_memoryMutex);
+	_memory[tag] += bytes;
+	SDL_mutexV(_memoryMutex);
+}
+
+/**
+ * Returns how much memory is in use for something.
+ * @param tag Memory tag.
+ * @return Bytes in use.
+ */
+long Profiler::getMemory(MemoryTag tag)
+{
+	SDL_mutexP(_memoryMutex);
+	long bytes = _memory[tag];
+	SDL_mutexV(_memoryMutex);
+	return bytes;
+}
+
+/**
+ * Starts timing a section, if the profiler is on.
+ * @param section Profiled section.
+ */
+ProfileMarker::ProfileMarker(ProfileSection section) : _section(section), _timed(Profiler::begin(section)), _start(0)
+{
+	if (_timed)
+	{
+		_start = Profiler::getTime();
+	}
+}
+
+/**
+ * Stops timing the section and adds its time to the current frame.
+ */
+ProfileMarker::~ProfileMarker()
+{
+	stop();
+}
+
+/**
+ * Stops timing the section and adds its time to the current frame,
+ * if it wasn't stopped already.
+ */
+void ProfileMarker::stop()
+{
+	if (_timed)
+	{
+		Profiler::end(_section, Profiler::getTime() - _start);
+		_timed = false;
+	}
+}
+
+/**
+ * Starts a trace event, if a trace is being recorded.
+ * @param name Event name.
+ * @param detail Extra info shown with the event, if any.
+ */
+TraceMarker::TraceMarker(const char *name, const char *detail) : _name(name), _traced(Profiler::trace(name, 'B', detail))
+{
+}
+
+/**
+ * Ends the trace event.
+ */
+TraceMarker::~TraceMarker()
+{
+	stop();
+}
+
+/**
+ * Ends the trace event, if it wasn't ended already.
+ */
+void TraceMarker::stop()
+{
+	if (_traced)
+	{
+		Profiler::trace(_name, 'E');
+		_traced = false;
+	}
+}
+
+}
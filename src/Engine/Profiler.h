@@ -0,0 +1,143 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_PROFILER_H
+#define OPENXCOM_PROFILER_H
+
+#include <string>
+#include <iosfwd>
+#include "SDL.h"
+
+#define PROFILE_FRAMES 128
+
+namespace OpenXcom
+{
+
+/**
+ * Parts of the game loop and hot paths that get timed.
+ * The first ones make up a frame, the rest run inside them.
+ */
+enum ProfileSection { PROF_EVENTS, PROF_THINK, PROF_BLIT, PROF_FLIP, PROF_TERRAIN, PROF_GLOBE, PROF_FOV, PROF_LIGHTING, PROF_PATHFINDING, PROF_SECTIONS };
+
+#define PROF_FRAME_SECTIONS 4
+
+/**
+ * What the memory the game keeps track of is used for.
+ */
+enum MemoryTag { MEM_SURFACES, MEM_SPRITES, MEM_SOUNDS, MEM_MAPCACHE, MEM_PATHFINDING, MEM_TILES, MEM_TAGS };
+
+/**
+ * Keeps the time spent in each section over the last
+ * PROFILE_FRAMES frames, so stutter can be tracked down.
+ * It can also record every section, along with other
+ * events, to a Chrome trace file (see chrome://tracing).
+ * Only the main thread is timed, and nothing is timed
+ * while the profiler and trace are both off.
+ * Memory is always counted, by whatever owns it,
+ * on any thread.
+ */
+class Profiler
+{
+private:
+	static bool _enabled;
+	static Uint32 _thread;
+	static int _current;
+	static int _depth[PROF_SECTIONS];
+	static double _frames[PROFILE_FRAMES][PROF_SECTIONS];
+	static std::ofstream *_trace;
+	static double _traceStart;
+	static bool _traceFirst;
+	static long _memory[MEM_TAGS], _tracedMemory[MEM_TAGS];
+	static SDL_mutex *_memoryMutex;
+	Profiler();
+	~Profiler();
+public:
+	/// Gets the name of a section.
+	static const char *getName(ProfileSection section);
+	/// Gets the current time in microseconds.
+	static double getTime();
+	/// Turns the profiler on or off.
+	static void setEnabled(bool enabled);
+	/// Gets whether the profiler is on.
+	static bool isEnabled();
+	/// Starts timing a section.
+	static bool begin(ProfileSection section);
+	/// Stops timing a section.
+	static void end(ProfileSection section, double time);
+	/// Moves on to the next frame.
+	static void endFrame();
+	/// Gets the time a section took in a past frame.
+	static double getFrameTime(int frame, ProfileSection section);
+	/// Gets the average time a section took over the past frames.
+	static double getAverageTime(ProfileSection section);
+	/// Saves the past frames to a CSV file.
+	static void save(const std::string &filename);
+	/// Starts recording a trace file.
+	static void startTrace(const std::string &filename);
+	/// Stops recording the trace file.
+	static void stopTrace();
+	/// Records an event in the trace file.
+	static bool trace(const char *name, char phase, const char *detail = 0);
+	/// Gets the name of a memory tag.
+	static const char *getMemoryName(MemoryTag tag);
+	/// Counts memory taken or given back.
+	static void addMemory(MemoryTag tag, long bytes);
+	/// Gets the memory in use for something.
+	static long getMemory(MemoryTag tag);
+};
+
+/**
+ * Times a section for as long as it's in scope,
+ * or until it's stopped.
+ */
+class ProfileMarker
+{
+private:
+	ProfileSection _section;
+	bool _timed;
+	double _start;
+public:
+	/// Starts timing a section.
+	ProfileMarker(ProfileSection section);
+	/// Stops timing the section.
+	~ProfileMarker();
+	/// Stops timing the section before it goes out of scope.
+	void stop();
+};
+
+/**
+ * Records an event in the trace file that lasts for as
+ * long as it's in scope, or until it's stopped.
+ */
+class TraceMarker
+{
+private:
+	const char *_name;
+	bool _traced;
+public:
+	/// Starts a trace event.
+	TraceMarker(const char *name, const char *detail = 0);
+	/// Ends the trace event.
+	~TraceMarker();
+	/// Ends the trace event before it goes out of scope.
+	void stop();
+};
+
+}
+
+#endif
@@ -17,19 +17,21 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "RNG.h"
+#include "StateHash.h"
 #define _USE_MATH_DEFINES
 #include <cmath>
-#include <cstdlib>
 #include <ctime>
 
 namespace OpenXcom
 {
 
 int RNG::_seed = 0;
+Uint32 RNG::_state[RNG_STREAMS][RNG_STATE_SIZE];
 
 /**
  * Seeds the random generator with a new number.
  * Defaults to the current time if none is set.
+ * Every stream gets its own state from the seed.
  * @param seed New seed.
  */
 void RNG::init(int seed)
@@ -42,7 +44,19 @@ void RNG::init(int seed)
 	{
 		_seed = seed;
 	}
-	srand(_seed);
+	// splitmix32 spreads the seed over all the state words
+	Uint32 x = (Uint32)_seed;
+	for (int i = 0; i < RNG_STREAMS; i++)
+	{
+		for (int j = 0; j < RNG_STATE_SIZE; j++)
+		{
+			x += 0x9E3779B9;
+			Uint32 z = x;
+			z = (z ^ (z >> 16)) * 0x85EBCA6B;
+			z = (z ^ (z >> 13)) * 0xC2B2AE35;
+			_state[i][j] = z ^ (z >> 16);
+		}
+	}
 }
 
 /**
@@ -54,62 +68,111 @@ int RNG::getSeed()
 	return _seed;
 }
 
+/**
+ * Returns the current state of a stream, to store it.
+ * @param stream Random stream.
+ * @return Pointer to RNG_STATE_SIZE state words.
+ */
+const Uint32 *RNG::getState(RNGStream stream)
+{
+	return _state[stream];
+}
+
+/**
+ * Changes the current state of a stream, to carry on
+ * from a stored state.
+ * @param stream Random stream.
+ * @param state Pointer to RNG_STATE_SIZE state words.
+ */
+void RNG::setState(RNGStream stream, const Uint32 *state)
+{
+	for (int i = 0; i < RNG_STATE_SIZE; i++)
+	{
+		_state[stream][i] = state[i];
+	}
+}
+
+/**
+ * Advances a stream and returns its next number.
+ * @param stream Random stream.
+ * @return Random 32-bit number.
+ */
+Uint32 RNG::next(RNGStream stream)
+{
+	Uint32 *s = _state[stream];
+	Uint32 x = s[1] * 5;
+	Uint32 result = ((x << 7) | (x >> 25)) * 9;
+	Uint32 t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = (s[3] << 11) | (s[3] >> 21);
+	return result;
+}
+
 /**
  * Generates a random integer number within a certain range.
  * @param min Minimum number.
  * @param max Maximum number.
+ * @param stream Random stream to draw from.
  * @return Generated number.
  */
-int RNG::generate(int min, int max)
+int RNG::generate(int min, int max, RNGStream stream)
 {
-	_seed = rand();
-	return (_seed % (max - min + 1) + min);
+	return (int)(next(stream) % (Uint32)(max - min + 1)) + min;
 }
 
 /**
  * Generates a random decimal number within a certain range.
  * @param min Minimum number.
  * @param max Maximum number.
+ * @param stream Random stream to draw from.
  * @return Generated number.
  */
-double RNG::generate(double min, double max)
+double RNG::generate(double min, double max, RNGStream stream)
 {
-	_seed = rand();
-	return (_seed * (max - min) / RAND_MAX + min);
+	return (next(stream) * (max - min) / 4294967295.0 + min);
 }
 
 /**
- * Normal random variate generator
+ * Normal random variate generator.
+ * Only one of each pair of values is used, so
+ * the stream state is all there is to store.
  * @param m mean
  * @param s standard deviation
+ * @param stream Random stream to draw from.
  * @return normally distributed value.
  */
-double RNG::boxMuller(double m, double s)	
+double RNG::boxMuller(double m, double s, RNGStream stream)
 {
-	double x1, x2, w, y1;
-	static double y2;
-	static int use_last = 0;
+	double x1, x2, w;
+	do {
+		x1 = 2.0 * generate(0.0, 1.0, stream) - 1.0;
+		x2 = 2.0 * generate(0.0, 1.0, stream) - 1.0;
+		w = x1 * x1 + x2 * x2;
+	} while ( w >= 1.0 || w == 0.0 );
 
-	if (use_last)		        /* use value from previous call */
-	{
-		y1 = y2;
-		use_last = 0;
-	}
-	else
-	{
-		do {
-			x1 = 2.0 * generate(0.0, 1.0) - 1.0;
-			x2 = 2.0 * generate(0.0, 1.0) - 1.0;
-			w = x1 * x1 + x2 * x2;
-		} while ( w >= 1.0 );
+	w = sqrt( (-2.0 * log( w ) ) / w );
 
-		w = sqrt( (-2.0 * log( w ) ) / w );
-		y1 = x1 * w;
-		y2 = x2 * w;
-		use_last = 1;
-	}
+	return( m + x1 * w * s );
+}
 
-	return( m + y1 * s );
+/**
+ * Adds the state of all the streams to a digest,
+ * so two runs drawing different numbers can be told apart.
+ * @param hash Pointer to the digest.
+ */
+void RNG::hash(StateHash *hash)
+{
+	for (int i = 0; i < RNG_STREAMS; i++)
+	{
+		for (int j = 0; j < RNG_STATE_SIZE; j++)
+		{
+			hash->add((int)_state[i][j]);
+		}
+	}
 }
 
 }
@@ -19,19 +19,34 @@
 #ifndef OPENXCOM_RNG_H
 #define OPENXCOM_RNG_H
 
+#include "SDL.h"
+
+#define RNG_STATE_SIZE 4
+
 namespace OpenXcom
 {
 
+class StateHash;
+
+/**
+ * Independent random streams, so the numbers one part
+ * of the game draws don't shift the numbers of another.
+ */
+enum RNGStream { RNG_GEOSCAPE, RNG_BATTLE, RNG_COMBAT, RNG_AI, RNG_COSMETIC, RNG_STREAMS };
+
 /**
  * Random Number Generator used throughout the game
- * for all your randomness needs. It's really just the
- * standard C generator, but wrapped in a way that we
- * can store its seed for later use if necessary.
+ * for all your randomness needs. Each stream is a
+ * xoshiro128** generator, which gives the same numbers
+ * on every platform, and its state can be stored
+ * to carry on exactly where it left off.
  */
 class RNG
 {
 private:
 	static int _seed;
+	static Uint32 _state[RNG_STREAMS][RNG_STATE_SIZE];
+	static Uint32 next(RNGStream stream);
 	RNG();
 	~RNG();
 public:
@@ -39,12 +54,18 @@ public:
 	static void init(int seed = -1);
 	/// Gets the generator's seed.
 	static int getSeed();
+	/// Gets the state of a stream.
+	static const Uint32 *getState(RNGStream stream);
+	/// Sets the state of a stream.
+	static void setState(RNGStream stream, const Uint32 *state);
 	/// Generates a random integer number.
-	static int generate(int min, int max);
+	static int generate(int min, int max, RNGStream stream = RNG_GEOSCAPE);
 	/// Generates a random decimal number.
-	static double generate(double min, double max);
+	static double generate(double min, double max, RNGStream stream = RNG_GEOSCAPE);
 	/// Get normally distributed value.
-	static double boxMuller(double m = 0, double s = 1);
+	static double boxMuller(double m = 0, double s = 1, RNGStream stream = RNG_GEOSCAPE);
+	/// Adds the state of all the streams to a digest.
+	static void hash(StateHash *hash);
 };
 
 }
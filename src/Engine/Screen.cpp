@@ -19,10 +19,15 @@
 #include "Screen.h"
 #include <sstream>
 #include <iomanip>
+#include <cstring>
+#include <algorithm>
 #include <sys/stat.h>
-#include "SDL_rotozoom.h"
+#ifndef DINGOO
+#include "SDL_opengl.h"
+#endif
 #include "Exception.h"
 #include "Surface.h"
+#include "SurfacePool.h"
 #include "Action.h"
 
 namespace OpenXcom
@@ -31,13 +36,98 @@ namespace OpenXcom
 #define BASE_WIDTH 320.0
 #define BASE_HEIGHT 200.0
 
+#define FLIP_BAND 8
+
+/**
+ * Scales an area of an 8bpp surface onto a display surface of any size,
+ * converting every pixel through a color table in the same pass. Whole-number
+ * scales of 1, 2, 3 and 4 have their own loops, any other scale picks each column
+ * from a lookup table. Rows scaled from the same source row are just copied.
+ * @param src Surface to scale from.
+ * @param dst Surface to scale to, must be locked.
+ * @param area Area of the source surface to scale.
+ * @param colors Display pixel value of each palette index.
+ * @param columns Source column of each destination column.
+ * @param factor Whole-number horizontal scale, or 0 if there isn't one.
+ * @return Area of the display surface that was drawn.
+ */
+template <typename Pixel>
+static SDL_Rect scaleSurface(SDL_Surface *src, SDL_Surface *dst, const SDL_Rect &area, const Uint32 *colors, const std::vector<int> &columns, int factor)
+{
+	// the display pixels whose source pixel lies inside the area
+	int x1 = (area.x * dst->w + src->w - 1) / src->w;
+	int x2 = ((area.x + area.w) * dst->w + src->w - 1) / src->w;
+	int y1 = (area.y * dst->h + src->h - 1) / src->h;
+	int y2 = ((area.y + area.h) * dst->h + src->h - 1) / src->h;
+
+	int lastRow = -1;
+	Uint8 *lastLine = 0;
+	for (int y = y1; y < y2; y++)
+	{
+		int row = y * src->h / dst->h;
+		Uint8 *line = (Uint8*)dst->pixels + y * dst->pitch + x1 * sizeof(Pixel);
+		if (row == lastRow)
+		{
+			memcpy(line, lastLine, (x2 - x1) * sizeof(Pixel));
+			continue;
+		}
+		const Uint8 *in = (Uint8*)src->pixels + row * src->pitch;
+		Pixel *out = (Pixel*)line;
+		switch (factor)
+		{
+		case 1:
+			for (int x = area.x; x < area.x + area.w; x++, out++)
+			{
+				*out = (Pixel)colors[in[x]];
+			}
+			break;
+		case 2:
+			for (int x = area.x; x < area.x + area.w; x++, out += 2)
+			{
+				Pixel p = (Pixel)colors[in[x]];
+				out[0] = p; out[1] = p;
+			}
+			break;
+		case 3:
+			for (int x = area.x; x < area.x + area.w; x++, out += 3)
+			{
+				Pixel p = (Pixel)colors[in[x]];
+				out[0] = p; out[1] = p; out[2] = p;
+			}
+			break;
+		case 4:
+			for (int x = area.x; x < area.x + area.w; x++, out += 4)
+			{
+				Pixel p = (Pixel)colors[in[x]];
+				out[0] = p; out[1] = p; out[2] = p; out[3] = p;
+			}
+			break;
+		default:
+			for (int x = x1; x < x2; x++, out++)
+			{
+				*out = (Pixel)colors[in[columns[x]]];
+			}
+			break;
+		}
+		lastRow = row;
+		lastLine = line;
+	}
+
+	SDL_Rect rect;
+	rect.x = x1;
+	rect.y = y1;
+	rect.w = x2 - x1;
+	rect.h = y2 - y1;
+	return rect;
+}
+
 /**
  * Initializes a new display screen for the game to render contents to.
  * @param width Width in pixels.
  * @param height Height in pixels.
  * @param bpp Bits-per-pixel.
  */
-Screen::Screen(int width, int height, int bpp) : _scaleX(1.0), _scaleY(1.0), _fullscreen(false)
+Screen::Screen(int width, int height, int bpp) : _scaleX(1.0), _scaleY(1.0), _fullscreen(false), _pushAll(true), _openGL(false), _filter(false), _paletteChanged(true), _texture(0), _textureWidth(0), _textureHeight(0)
 {
 	_flags = SDL_SWSURFACE|SDL_HWPALETTE;
 	_screen = SDL_SetVideoMode(width, height, bpp, _flags);
@@ -46,6 +136,8 @@ Screen::Screen(int width, int height, int bpp) : _scaleX(1.0), _scaleY(1.0), _fu
 		throw Exception(SDL_GetError());
 	}
 	_surface = new Surface(width, height);
+	updateScale();
+	updateColors(0, 256);
 }
 
 /**
@@ -54,6 +146,7 @@ Screen::Screen(int width, int height, int bpp) : _scaleX(1.0), _scaleY(1.0), _fu
  */
 Screen::~Screen()
 {
+	freeOpenGL();
 	delete _surface;
 }
 
@@ -89,7 +182,66 @@ void Screen::handle(Action *action)
 			i++;
 		}
 		while (stat(ss.str().c_str(), &info) == 0);
-		SDL_SaveBMP(_screen, ss.str().c_str());
+		// an OpenGL display can't be read back, so save the buffer as it is
+		SDL_SaveBMP(_openGL ? _surface->getSurface() : _screen, ss.str().c_str());
+	}
+}
+
+/**
+ * Finds the areas of the buffer that changed since the last flip,
+ * comparing it to a copy of what was shown. Changes are gathered in
+ * bands of FLIP_BAND rows, each covering the changed columns in it.
+ * @param areas Vector to add the changed areas to.
+ */
+void Screen::findChanges(std::vector<SDL_Rect> *areas)
+{
+	SDL_Surface *buffer = _surface->getSurface();
+	int width = buffer->w, height = buffer->h;
+	if (_pushAll || (int)_shown.size() != width * height)
+	{
+		_shown.resize(width * height);
+		for (int y = 0; y < height; y++)
+		{
+			memcpy(&_shown[y * width], (Uint8*)buffer->pixels + y * buffer->pitch, width);
+		}
+		SDL_Rect rect;
+		rect.x = 0;
+		rect.y = 0;
+		rect.w = width;
+		rect.h = height;
+		areas->push_back(rect);
+		_pushAll = false;
+		return;
+	}
+
+	for (int band = 0; band < height; band += FLIP_BAND)
+	{
+		int left = width, right = -1;
+		int bottom = std::min(band + FLIP_BAND, height);
+		for (int y = band; y < bottom; y++)
+		{
+			Uint8 *line = (Uint8*)buffer->pixels + y * buffer->pitch;
+			Uint8 *shown = &_shown[y * width];
+			if (memcmp(line, shown, width) == 0)
+				continue;
+			int x1 = 0, x2 = width - 1;
+			while (line[x1] == shown[x1])
+				x1++;
+			while (line[x2] == shown[x2])
+				x2--;
+			left = std::min(left, x1);
+			right = std::max(right, x2);
+			memcpy(shown + x1, line + x1, x2 - x1 + 1);
+		}
+		if (right >= left)
+		{
+			SDL_Rect rect;
+			rect.x = left;
+			rect.y = band;
+			rect.w = right - left + 1;
+			rect.h = bottom - band;
+			areas->push_back(rect);
+		}
 	}
 }
 
@@ -98,25 +250,69 @@ void Screen::handle(Action *action)
  * any necessary filters or conversions in the process.
  * If the scaling factor is bigger than 1, the entire contents
  * of the buffer are resized by that factor (eg. 2 = doubled)
- * before being put on screen.
+ * before being put on screen. Only the areas that changed since
+ * the last flip are drawn and updated on the display. Palette
+ * conversion goes through the color table kept by setPalette,
+ * even when the buffer isn't scaled.
  */
 void Screen::flip()
 {
-	if (getWidth() != BASE_WIDTH || getHeight() != BASE_HEIGHT)
+	std::vector<SDL_Rect> areas, rects;
+	findChanges(&areas);
+	if (areas.empty())
+		return;
+
+	if (_openGL)
 	{
-		SDL_Surface* zoom = zoomSurface(_surface->getSurface(), _scaleX, _scaleY, 0);
-		SDL_BlitSurface(zoom, 0, _screen, 0);
-		SDL_FreeSurface(zoom);
+		flipOpenGL(areas);
+		return;
+	}
+
+	int bytes = _screen->format->BytesPerPixel;
+	if (bytes == 1 || bytes == 2 || bytes == 4)
+	{
+		// convert (and scale) straight into the display, no surface in between
+		SDL_LockSurface(_screen);
+		for (std::vector<SDL_Rect>::iterator i = areas.begin(); i != areas.end(); i++)
+		{
+			if (bytes == 1)
+				rects.push_back(scaleSurface<Uint8>(_surface->getSurface(), _screen, *i, _colors, _columns, _factor));
+			else if (bytes == 2)
+				rects.push_back(scaleSurface<Uint16>(_surface->getSurface(), _screen, *i, _colors, _columns, _factor));
+			else
+				rects.push_back(scaleSurface<Uint32>(_surface->getSurface(), _screen, *i, _colors, _columns, _factor));
+		}
+		SDL_UnlockSurface(_screen);
+	}
+	else if (getWidth() != _surface->getWidth() || getHeight() != _surface->getHeight())
+	{
+		// 24 bit displays are scaled through SDL
+		SDL_Rect rect;
+		rect.x = 0;
+		rect.y = 0;
+		rect.w = getWidth();
+		rect.h = getHeight();
+		SDL_FillRect(_screen, &rect, 0);
+		// stretch into a surface kept from the last frame, then convert to the display
+		SurfaceLease zoom(getWidth(), getHeight());
+		zoom->setPalette(_surface->getPalette());
+		SDL_SoftStretch(_surface->getSurface(), 0, zoom->getSurface(), 0);
+		SDL_BlitSurface(zoom->getSurface(), 0, _screen, 0);
+		rects.push_back(rect);
 	}
 	else
 	{
-		SDL_BlitSurface(_surface->getSurface(), 0, _screen, 0);
+		for (std::vector<SDL_Rect>::iterator i = areas.begin(); i != areas.end(); i++)
+		{
+			// the buffer is color keyed, so clear what's under it first
+			SDL_Rect rect = *i;
+			SDL_FillRect(_screen, &rect, 0);
+			SDL_BlitSurface(_surface->getSurface(), &(*i), _screen, &rect);
+			rects.push_back(*i);
+		}
 	}
 
-	if (SDL_Flip(_screen) == -1)
-    {
-        throw Exception(SDL_GetError());
-    }
+	SDL_UpdateRects(_screen, rects.size(), &rects[0]);
 }
 
 /**
@@ -125,12 +321,6 @@ void Screen::flip()
 void Screen::clear()
 {
 	_surface->clear();
-	SDL_Rect square;
-	square.x = 0;
-	square.y = 0;
-	square.w = getWidth();
-	square.h = getHeight();
-	SDL_FillRect(_screen, &square, 0);
 }
 
 /**
@@ -143,6 +333,55 @@ void Screen::setPalette(SDL_Color* colors, int firstcolor, int ncolors)
 {
 	_surface->setPalette(colors, firstcolor, ncolors);
 	SDL_SetColors(_screen, colors, firstcolor, ncolors);
+	updateColors(firstcolor, ncolors);
+	_paletteChanged = true;
+	if (_openGL)
+	{
+		// the texture holds converted colors, so all of it has to be uploaded again
+		_pushAll = true;
+	}
+}
+
+/**
+ * Works out which buffer column every column of the display
+ * is scaled from, and whether the scale is a whole number.
+ */
+void Screen::updateScale()
+{
+	_columns.resize(getWidth());
+	for (int x = 0; x < getWidth(); x++)
+	{
+		_columns[x] = x * _surface->getWidth() / getWidth();
+	}
+	_factor = 0;
+	if (getWidth() % _surface->getWidth() == 0)
+	{
+		_factor = getWidth() / _surface->getWidth();
+	}
+}
+
+/**
+ * Works out the display pixel value of palette colors,
+ * so scaling can convert them without going through SDL.
+ * @param firstcolor Offset of the first color to update.
+ * @param ncolors Amount of colors to update.
+ */
+void Screen::updateColors(int firstcolor, int ncolors)
+{
+	SDL_Color *palette = _surface->getPalette();
+	for (int i = firstcolor; i < firstcolor + ncolors; i++)
+	{
+		if (_screen->format->BytesPerPixel == 1)
+		{
+			_colors[i] = i;
+		}
+		else
+		{
+			_colors[i] = SDL_MapRGB(_screen->format, palette[i].r, palette[i].g, palette[i].b);
+			// the display doesn't have a palette, so every pixel using the color changes
+			_pushAll = true;
+		}
+	}
 }
 
 /**
@@ -182,11 +421,18 @@ void Screen::setResolution(int width, int height)
 {
 	_scaleX = width / BASE_WIDTH;
 	_scaleY = height / BASE_HEIGHT;
-	_screen = SDL_SetVideoMode(width, height, _screen->format->BitsPerPixel, _flags);
+	freeOpenGL();
+	_screen = SDL_SetVideoMode(width, height, _openGL ? 0 : _screen->format->BitsPerPixel, _flags);
 	if (_screen == 0)
 	{
 		throw Exception(SDL_GetError());
 	}
+	if (_openGL)
+	{
+		setupOpenGL();
+	}
+	updateScale();
+	_pushAll = true;
 	setPalette(getPalette());
 }
 
@@ -209,6 +455,137 @@ void Screen::setFullscreen(bool full)
 	setResolution(getWidth(), getHeight());
 }
 
+/**
+ * Switches the screen between being drawn by SDL and through OpenGL.
+ * With OpenGL only the changed parts of the 8bpp buffer are uploaded,
+ * the graphics card converts them through the palette and scales
+ * them to the display, so the work doesn't grow with the resolution.
+ * @param openGL True to draw through OpenGL.
+ * @param filter True to smooth the scaled image, False to keep its pixels sharp.
+ */
+void Screen::setOpenGL(bool openGL, bool filter)
+{
+#ifndef DINGOO
+	_openGL = openGL;
+	_filter = filter;
+	_flags &= SDL_FULLSCREEN;
+	if (_openGL)
+	{
+		_flags |= SDL_OPENGL;
+	}
+	else
+	{
+		_flags |= SDL_SWSURFACE|SDL_HWPALETTE;
+	}
+	setResolution(getWidth(), getHeight());
+#endif
+}
+
+/**
+ * Sets up the OpenGL state for drawing the buffer, after the
+ * display was set up. The buffer is kept in a texture with
+ * power-of-two sizes, which every version of OpenGL supports.
+ */
+void Screen::setupOpenGL()
+{
+#ifndef DINGOO
+	_textureWidth = 1;
+	while (_textureWidth < _surface->getWidth())
+		_textureWidth *= 2;
+	_textureHeight = 1;
+	while (_textureHeight < _surface->getHeight())
+		_textureHeight *= 2;
+
+	glViewport(0, 0, getWidth(), getHeight());
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0, 1, 1, 0, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glEnable(GL_TEXTURE_2D);
+
+	// changing the display mode can lose the texture, so a new one is made every time
+	GLuint texture;
+	glGenTextures(1, &texture);
+	_texture = texture;
+	glBindTexture(GL_TEXTURE_2D, _texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _filter ? GL_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _filter ? GL_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, _textureWidth, _textureHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	_paletteChanged = true;
+	_pushAll = true;
+#endif
+}
+
+/**
+ * Frees the texture made by setupOpenGL(), while the
+ * display it was made for is still around.
+ */
+void Screen::freeOpenGL()
+{
+#ifndef DINGOO
+	if (_texture != 0)
+	{
+		GLuint texture = _texture;
+		glDeleteTextures(1, &texture);
+		_texture = 0;
+	}
+#endif
+}
+
+/**
+ * Uploads the changed areas of the buffer as palette indexes, which
+ * OpenGL converts to colors through its pixel maps on the way into
+ * the texture, then draws the texture over the whole display.
+ * @param areas Areas of the buffer that changed.
+ */
+void Screen::flipOpenGL(const std::vector<SDL_Rect> &areas)
+{
+#ifndef DINGOO
+	if (_paletteChanged)
+	{
+		GLfloat r[256], g[256], b[256];
+		SDL_Color *palette = _surface->getPalette();
+		for (int i = 0; i < 256; i++)
+		{
+			r[i] = palette[i].r / 255.0f;
+			g[i] = palette[i].g / 255.0f;
+			b[i] = palette[i].b / 255.0f;
+		}
+		glPixelMapfv(GL_PIXEL_MAP_I_TO_R, 256, r);
+		glPixelMapfv(GL_PIXEL_MAP_I_TO_G, 256, g);
+		glPixelMapfv(GL_PIXEL_MAP_I_TO_B, 256, b);
+		glPixelTransferi(GL_MAP_COLOR, GL_TRUE);
+		_paletteChanged = false;
+	}
+
+	SDL_Surface *buffer = _surface->getSurface();
+	glBindTexture(GL_TEXTURE_2D, _texture);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, buffer->pitch);
+	for (std::vector<SDL_Rect>::const_iterator i = areas.begin(); i != areas.end(); i++)
+	{
+		const Uint8 *pixels = (Uint8*)buffer->pixels + i->y * buffer->pitch + i->x;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, i->x, i->y, i->w, i->h, GL_COLOR_INDEX, GL_UNSIGNED_BYTE, pixels);
+	}
+
+	GLfloat u = (GLfloat)_surface->getWidth() / _textureWidth;
+	GLfloat v = (GLfloat)_surface->getHeight() / _textureHeight;
+	glBegin(GL_QUADS);
+	glTexCoord2f(0, 0); glVertex2f(0, 0);
+	glTexCoord2f(u, 0); glVertex2f(1, 0);
+	glTexCoord2f(u, v); glVertex2f(1, 1);
+	glTexCoord2f(0, v); glVertex2f(0, 1);
+	glEnd();
+	SDL_GL_SwapBuffers();
+#endif
+}
+
 /**
  * Returns the screen's X scale.
  * @return Scale factor.
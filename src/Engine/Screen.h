@@ -19,6 +19,7 @@
 #ifndef OPENXCOM_SCREEN_H
 #define OPENXCOM_SCREEN_H
 
+#include <vector>
 #include "SDL.h"
 
 namespace OpenXcom
@@ -33,7 +34,8 @@ class Action;
  * a specialized version of a Surface with functionality more
  * relevant for display screens. Contains a Surface buffer
  * where all the contents are kept, so any filters or conversions
- * can be applied before rendering the screen.
+ * can be applied before rendering the screen. It can also be drawn
+ * through OpenGL, which does the conversion and scaling instead.
  */
 class Screen
 {
@@ -43,6 +45,20 @@ private:
 	double _scaleX, _scaleY;
 	Uint32 _flags;
 	bool _fullscreen;
+	Uint32 _colors[256];
+	std::vector<int> _columns;
+	int _factor;
+	std::vector<Uint8> _shown;
+	bool _pushAll;
+	bool _openGL, _filter, _paletteChanged;
+	unsigned int _texture;
+	int _textureWidth, _textureHeight;
+	void updateScale();
+	void findChanges(std::vector<SDL_Rect> *areas);
+	void updateColors(int firstcolor, int ncolors);
+	void setupOpenGL();
+	void freeOpenGL();
+	void flipOpenGL(const std::vector<SDL_Rect> &areas);
 public:
 	/// Creates a new display screen with the specified resolution.
 	Screen(int width, int height, int bpp);
@@ -68,6 +84,8 @@ public:
 	void setResolution(int width, int height);
 	/// Sets whether the screen is full-screen or windowed.
 	void setFullscreen(bool full);
+	/// Sets whether the screen is drawn through OpenGL.
+	void setOpenGL(bool openGL, bool filter);
 	/// Gets the screen's X scale;
 	double getXScale() const;
 	/// Gets the screen's Y scale;
@@ -20,6 +20,7 @@
 #include <iostream>
 #include "SDL.h"
 #include "Exception.h"
+#include "Profiler.h"
 
 namespace OpenXcom
 {
@@ -36,6 +37,10 @@ Sound::Sound() : _sound(0)
  */
 Sound::~Sound()
 {
+	if (_sound != 0)
+	{
+		Profiler::addMemory(MEM_SOUNDS, -(long)_sound->alen);
+	}
 	Mix_FreeChunk(_sound);
 }
 
@@ -50,6 +55,7 @@ void Sound::load(const std::string &filename)
 	{
 		throw Exception(Mix_GetError());
 	}
+	Profiler::addMemory(MEM_SOUNDS, _sound->alen);
 }
 
 /**
@@ -65,6 +71,7 @@ void Sound::load(const void *data, unsigned int size)
 	{
 		throw Exception(Mix_GetError());
 	}
+	Profiler::addMemory(MEM_SOUNDS, _sound->alen);
 }
 
 /**
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "SoundSet.h"
+#include <cstring>
 #include "CatFile.h"
 #include "Sound.h"
 #include "Exception.h"
@@ -27,7 +28,7 @@ namespace OpenXcom
 /**
  * Sets up a new empty sound set.
  */
-SoundSet::SoundSet() : _sounds()
+SoundSet::SoundSet() : _sounds(), _cat(0), _wav(true), _recent(), _kept()
 {
 
 }
@@ -41,13 +42,16 @@ SoundSet::~SoundSet()
 	{
 		delete *i;
 	}
+	delete _cat;
 }
 
 /**
- * Loads the contents of an X-Com CAT file which usually contains
+ * Opens an X-Com CAT file which usually contains
  * a set of sound files. The CAT starts with an index of the offset
  * and size of every file contained within. Each file consists of a
- * filename followed by its contents.
+ * filename followed by its contents. The sounds are only decoded
+ * when they're first used, and only the most recently used ones
+ * are kept in memory.
  * @param filename Filename of the CAT set.
  * @param wav Are the sounds in WAV format?
  * @sa http://www.ufopaedia.org/index.php?title=SOUND
@@ -55,74 +59,121 @@ SoundSet::~SoundSet()
 void SoundSet::loadCat(const std::string &filename, bool wav)
 {
 	// Load CAT file
-	CatFile sndFile (filename.c_str());
-	if (!sndFile)
+	CatFile *sndFile = new CatFile(filename.c_str());
+	if (!*sndFile)
 	{
+		delete sndFile;
 		throw Exception("Failed to load CAT");
 	}
+	delete _cat;
+	_cat = sndFile;
+	_wav = wav;
 
-	// Load each sound file
-	for (int i = 0; i < sndFile.getAmount(); i++)
+	for (std::vector<Sound*>::iterator i = _sounds.begin(); i != _sounds.end(); i++)
 	{
-		// Read WAV chunk
-		char *sound = sndFile.load(i);
-		unsigned int size = sndFile.getObjectSize(i);
+		delete *i;
+	}
+	_sounds.clear();
+	_sounds.resize(_cat->getAmount(), 0);
+	_recent.clear();
+	_kept.clear();
+	_kept.resize(_cat->getAmount(), false);
+}
 
-		// If there's no WAV header (44 bytes), add it
-		// Assuming sounds are 8-bit 8000Hz (DOS version)
-		char *newsound = 0;
-		if (!wav)
-		{
-			char header[] = {'R', 'I', 'F', 'F', 0x00, 0x00, 0x00, 0x00, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ',
-							 0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x40, 0x1f, 0x00, 0x00, 0x40, 0x1f, 0x00, 0x00, 0x01, 0x00, 0x08, 0x00,
-							 'd', 'a', 't', 'a', 0x00, 0x00, 0x00, 0x00};
-			int headersize = size + 36;
-			int soundsize = size;
-			memcpy(header + 4, &headersize, sizeof(headersize));
-			memcpy(header + 40, &soundsize, sizeof(soundsize));
+/**
+ * Decodes a sound from the CAT file, making room
+ * for it by freeing the least recently used one.
+ * @param i Sound number in the set.
+ */
+void SoundSet::loadSound(unsigned int i)
+{
+	if (_recent.size() >= SOUND_CACHE_SIZE)
+	{
+		delete _sounds[_recent.back()];
+		_sounds[_recent.back()] = 0;
+		_recent.pop_back();
+	}
 
-			newsound = new char[44 + size];
-			memcpy(newsound, header, 44);
-			memcpy(newsound + 44, sound, size);
-		}
+	// Read WAV chunk, leaving room for a
+	// WAV header (44 bytes) if there's none
+	unsigned int size = _cat->getObjectSize(i);
+	char *sound = _cat->load(i, _wav ? 0 : 44);
 
-		Sound *s = new Sound();
-		try
-		{
-			if (wav)
-				s->load(sound, size);
-			else
-				s->load(newsound, 44 + size);
-		}
-		catch (Exception &e)
-		{
-			// Ignore junk in the file
-			e = e;
-		}
-		_sounds.push_back(s);
+	// Assuming sounds are 8-bit 8000Hz (DOS version)
+	if (!_wav)
+	{
+		char header[] = {'R', 'I', 'F', 'F', 0x00, 0x00, 0x00, 0x00, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ',
+						 0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x40, 0x1f, 0x00, 0x00, 0x40, 0x1f, 0x00, 0x00, 0x01, 0x00, 0x08, 0x00,
+						 'd', 'a', 't', 'a', 0x00, 0x00, 0x00, 0x00};
+		int headersize = size + 36;
+		int soundsize = size;
+		memcpy(header + 4, &headersize, sizeof(headersize));
+		memcpy(header + 40, &soundsize, sizeof(soundsize));
+		memcpy(sound, header, 44);
+	}
 
-		delete[] sound;
-		if (!wav)
-		{
-			delete[] newsound;
-		}
+	Sound *s = new Sound();
+	try
+	{
+		if (_wav)
+			s->load(sound, size);
+		else
+			s->load(sound, 44 + size);
+	}
+	catch (Exception &e)
+	{
+		// Ignore junk in the file
+		e = e;
 	}
+	_sounds[i] = s;
+	_recent.push_front(i);
+
+	delete[] sound;
 }
 
 /**
- * Returns a particular wave from the sound set.
+ * Returns a particular wave from the sound set,
+ * decoding it if it's not in memory.
  * @param i Sound number in the set.
  * @return Pointer to the respective sound.
  */
-Sound *const SoundSet::getSound(unsigned int i) const
+Sound *const SoundSet::getSound(unsigned int i)
 {
 	if (i >= _sounds.size())
 	{
 		return 0;
 	}
+	if (_sounds[i] == 0)
+	{
+		loadSound(i);
+	}
+	else if (!_kept[i] && _recent.front() != i)
+	{
+		_recent.remove(i);
+		_recent.push_front(i);
+	}
 	return _sounds[i];
 }
 
+/**
+ * Returns a particular wave from the sound set and takes
+ * it out of the cache, so it's never freed to make room
+ * for others. Used for sounds that are held on to
+ * outside the set, like the interface sounds.
+ * @param i Sound number in the set.
+ * @return Pointer to the respective sound.
+ */
+Sound *const SoundSet::keepSound(unsigned int i)
+{
+	Sound *s = getSound(i);
+	if (s != 0 && !_kept[i])
+	{
+		_recent.remove(i);
+		_kept[i] = true;
+	}
+	return s;
+}
+
 /**
  * Returns the total amount of sounds currently
  * stored in the set.
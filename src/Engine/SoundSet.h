@@ -20,12 +20,16 @@
 #define OPENXCOM_SOUNDSET_H
 
 #include <vector>
+#include <list>
 #include <string>
 
+#define SOUND_CACHE_SIZE 64
+
 namespace OpenXcom
 {
 
 class Sound;
+class CatFile;
 
 /**
  * Container of a set of sounds.
@@ -37,6 +41,12 @@ class SoundSet
 private:
 	int _width, _height;
 	std::vector<Sound*> _sounds;
+	CatFile *_cat;
+	bool _wav;
+	std::list<unsigned int> _recent;
+	std::vector<bool> _kept;
+	/// Decodes a sound from the CAT file.
+	void loadSound(unsigned int i);
 public:
 	/// Crates a sound set.
 	SoundSet();
@@ -45,7 +55,9 @@ public:
 	/// Loads an X-Com CAT set of sound files.
 	void loadCat(const std::string &filename, bool wav = true);
 	/// Gets a particular sound from the set.
-	Sound *const getSound(unsigned int i) const;
+	Sound *const getSound(unsigned int i);
+	/// Gets a sound that stays in memory as long as the set.
+	Sound *const keepSound(unsigned int i);
 	/// Gets the total sounds in the set.
 	int getTotalSounds() const;
 };
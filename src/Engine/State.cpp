@@ -17,11 +17,13 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "State.h"
+#include <algorithm>
 #include "InteractiveSurface.h"
 #include "Game.h"
 #include "Screen.h"
 #include "Surface.h"
 #include "Font.h"
+#include "Action.h"
 #include "../Resource/ResourcePack.h"
 #include "../Interface/Text.h"
 #include "../Interface/TextButton.h"
@@ -36,7 +38,7 @@ namespace OpenXcom
  * By default states are full-screen.
  * @param game Pointer to the core game.
  */
-State::State(Game *game) : _game(game), _screen(true)
+State::State(Game *game) : _game(game), _screen(true), _eventColumns(0)
 {
 	
 }
@@ -61,6 +63,16 @@ std::vector<Surface*> *const State::getSurfaces()
 	return &_surfaces;
 }
 
+/**
+ * Returns the interactive surfaces attached to this state,
+ * in the order they were added.
+ * @return List of interactive surfaces.
+ */
+std::vector<InteractiveSurface*> *const State::getInteractiveSurfaces()
+{
+	return &_interactive;
+}
+
 /**
  * Adds a new child surface for the state to take care of,
  * giving it the game's display palette. Once associated,
@@ -99,6 +111,13 @@ void State::add(Surface *surface)
 	}
 
 	_surfaces.push_back(surface);
+
+	InteractiveSurface *is = dynamic_cast<InteractiveSurface*>(surface);
+	if (is)
+	{
+		_interactive.push_back(is);
+		_eventCells.clear();
+	}
 }
 
 /**
@@ -127,6 +146,18 @@ void State::init()
 
 }
 
+/**
+ * Returns whether the state can be kept around after
+ * it's closed and opened again later, instead of being
+ * built from scratch. Such states have to bring all their
+ * contents up to date in init().
+ * @return False by default.
+ */
+bool State::isReusable() const
+{
+	return false;
+}
+
 /**
  * Runs any code the state needs to keep updating every
  * game cycle, like timers and other real-time elements.
@@ -137,18 +168,103 @@ void State::think()
 		(*i)->think();
 }
 
+/**
+ * Sorts the interactive surfaces into a grid of screen cells by the areas
+ * they take mouse events in. Only rebuilt when a surface was added or one
+ * of the areas changed since the last time.
+ */
+void State::updateEventCells()
+{
+	bool changed = _eventCells.empty() || _eventAreas.size() != _interactive.size();
+	for (size_t i = 0; i < _interactive.size() && !changed; i++)
+	{
+		SDL_Rect area = _interactive[i]->getEventArea();
+		changed = (area.x != _eventAreas[i].x || area.y != _eventAreas[i].y || area.w != _eventAreas[i].w || area.h != _eventAreas[i].h);
+	}
+	if (!changed)
+		return;
+
+	Surface *screen = _game->getScreen()->getSurface();
+	_eventColumns = (screen->getWidth() + EVENT_CELL_WIDTH - 1) / EVENT_CELL_WIDTH;
+	int rows = (screen->getHeight() + EVENT_CELL_HEIGHT - 1) / EVENT_CELL_HEIGHT;
+	_eventCells.assign(_eventColumns * rows, std::vector<int>());
+	_eventAreas.clear();
+	for (size_t i = 0; i < _interactive.size(); i++)
+	{
+		SDL_Rect area = _interactive[i]->getEventArea();
+		_eventAreas.push_back(area);
+		int x1 = std::max(0, (int)area.x / EVENT_CELL_WIDTH);
+		int y1 = std::max(0, (int)area.y / EVENT_CELL_HEIGHT);
+		int x2 = std::min(_eventColumns - 1, (area.x + area.w - 1) / EVENT_CELL_WIDTH);
+		int y2 = std::min(rows - 1, (area.y + area.h - 1) / EVENT_CELL_HEIGHT);
+		for (int y = y1; y <= y2; y++)
+		{
+			for (int x = x1; x <= x2; x++)
+			{
+				_eventCells[y * _eventColumns + x].push_back(i);
+			}
+		}
+	}
+}
+
 /**
  * Takes care of any events from the core game engine,
  * and passes them on to its InteractiveSurface child elements.
+ * Mouse moves and presses only go to the surfaces under the mouse and
+ * the ones still hovered or pressed, keyboard events only to those
+ * and the focused ones. Mouse releases go to every surface.
  * @param action Pointer to an action.
  */
 void State::handle(Action *action)
 {
-	for (std::vector<Surface*>::iterator i = _surfaces.begin(); i < _surfaces.end(); i++)
+	if (_interactive.empty())
+		return;
+
+	// work out the receivers first, the handlers can add surfaces
+	std::vector<bool> receivers(_interactive.size(), false);
+	int x = -1, y = -1;
+	Uint8 type = action->getDetails()->type;
+	if (type == SDL_MOUSEMOTION)
+	{
+		x = action->getDetails()->motion.x;
+		y = action->getDetails()->motion.y;
+	}
+	else if (type == SDL_MOUSEBUTTONDOWN)
+	{
+		x = action->getDetails()->button.x;
+		y = action->getDetails()->button.y;
+	}
+	else if (type == SDL_MOUSEBUTTONUP)
+	{
+		// releases go everywhere, something might be pressed that doesn't know it is
+		receivers.assign(_interactive.size(), true);
+	}
+	if (x != -1 && y != -1)
+	{
+		updateEventCells();
+		int cellX = (int)(x / action->getXScale()) / EVENT_CELL_WIDTH;
+		int cellY = (int)(y / action->getYScale()) / EVENT_CELL_HEIGHT;
+		if (cellX >= 0 && cellX < _eventColumns && cellY >= 0 && cellY * _eventColumns < (int)_eventCells.size())
+		{
+			std::vector<int> &cell = _eventCells[cellY * _eventColumns + cellX];
+			for (std::vector<int>::iterator i = cell.begin(); i != cell.end(); i++)
+			{
+				receivers[*i] = true;
+			}
+		}
+	}
+	for (size_t i = 0; i < _interactive.size(); i++)
+	{
+		if (_interactive[i]->isFocused() || _interactive[i]->isHovered() || _interactive[i]->isPressed())
+		{
+			receivers[i] = true;
+		}
+	}
+
+	for (size_t i = 0; i < receivers.size(); i++)
 	{
-		InteractiveSurface* j = dynamic_cast<InteractiveSurface*>(*i);
-		if (j != 0)
-			j->handle(action, this);
+		if (receivers[i])
+			_interactive[i]->handle(action, this);
 	}
 }
 
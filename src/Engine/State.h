@@ -28,8 +28,12 @@ namespace OpenXcom
 
 class Game;
 class Surface;
+class InteractiveSurface;
 class Action;
 
+#define EVENT_CELL_WIDTH 32
+#define EVENT_CELL_HEIGHT 25
+
 /**
  * A game state that receives user input and reacts accordingly.
  * Game states typically represent a whole window or screen that
@@ -44,6 +48,11 @@ protected:
 	Game *_game;
 	std::vector<Surface*> _surfaces;
 	bool _screen;
+	std::vector<InteractiveSurface*> _interactive;
+	std::vector<SDL_Rect> _eventAreas;
+	std::vector< std::vector<int> > _eventCells;
+	int _eventColumns;
+	void updateEventCells();
 
 public:
 	/// Creates a new state linked to a game.
@@ -52,12 +61,16 @@ public:
 	virtual ~State();
 	/// Gets the state's surfaces.
 	std::vector<Surface*> *const getSurfaces();
+	/// Gets the state's interactive surfaces.
+	std::vector<InteractiveSurface*> *const getInteractiveSurfaces();
 	/// Adds a child element to the state.
 	void add(Surface *surface);
 	/// Gets whether the state is a full-screen.
 	bool isScreen() const;
 	/// Initializes the state.
 	virtual void init();
+	/// Checks if the state can be kept for reuse once it's closed.
+	virtual bool isReusable() const;
 	/// Handles any events.
 	virtual void handle(Action *action);
 	/// Runs state functionality every cycle.
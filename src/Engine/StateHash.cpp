@@ -0,0 +1,96 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "StateHash.h"
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a digest of nothing.
+ */
+StateHash::StateHash() : _hash(FNV_OFFSET)
+{
+}
+
+/**
+ * Adds some bytes to the digest, in the order they're in.
+ * @param data Pointer to the bytes.
+ * @param size Number of bytes.
+ */
+void StateHash::add(const void *data, size_t size)
+{
+	const Uint8 *bytes = (const Uint8*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		_hash ^= bytes[i];
+		_hash *= FNV_PRIME;
+	}
+}
+
+/**
+ * Adds a number to the digest, lowest byte first
+ * whatever the platform's byte order.
+ * @param value Number.
+ */
+void StateHash::add(int value)
+{
+	Uint8 bytes[4];
+	for (int i = 0; i < 4; i++)
+	{
+		bytes[i] = (Uint8)((Uint32)value >> (i * 8));
+	}
+	add(bytes, 4);
+}
+
+/**
+ * Adds a string to the digest, with its length
+ * so strings next to each other can't run together.
+ * @param s String.
+ */
+void StateHash::add(const std::string &s)
+{
+	add((int)s.size());
+	add(s.data(), s.size());
+}
+
+/**
+ * Returns the digest of everything added so far.
+ * @return 64-bit digest.
+ */
+Uint64 StateHash::get() const
+{
+	return _hash;
+}
+
+/**
+ * Returns the name of a part of the game state,
+ * for reporting where a difference is.
+ * @param part Part of the game state.
+ * @return Name of the part.
+ */
+const char *StateHash::getPartName(HashPart part)
+{
+	static const char *names[] = {"rng", "terrain", "lighting", "units", "visibility", "game"};
+	return names[part];
+}
+
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_STATEHASH_H
+#define OPENXCOM_STATEHASH_H
+
+#include <string>
+#include "SDL.h"
+
+namespace OpenXcom
+{
+
+/**
+ * The parts of the game state that are hashed apart, so
+ * a difference can be pinned down to where it started.
+ */
+enum HashPart { HASH_RNG, HASH_TERRAIN, HASH_LIGHTING, HASH_UNITS, HASH_VISIBILITY, HASH_GAME, HASH_PARTS };
+
+/**
+ * A 64-bit FNV-1a digest of game state. Values are fed in
+ * a fixed byte order, so the same state gives the same
+ * digest on every platform and build. Used to check that
+ * faster ways of working things out, like threads or
+ * incremental updates, still come to exactly the same game.
+ */
+class StateHash
+{
+private:
+	Uint64 _hash;
+public:
+	/// Creates an empty digest.
+	StateHash();
+	/// Adds some bytes to the digest.
+	void add(const void *data, size_t size);
+	/// Adds a number to the digest.
+	void add(int value);
+	/// Adds a string to the digest.
+	void add(const std::string &s);
+	/// Gets the digest.
+	Uint64 get() const;
+	/// Gets the name of a part of the game state.
+	static const char *getPartName(HashPart part);
+};
+
+}
+
+#endif
@@ -18,13 +18,98 @@
  */
 #include "Surface.h"
 #include <fstream>
+#include <algorithm>
+#include <cstring>
 #include "SDL_gfxPrimitives.h"
 #include "Palette.h"
 #include "Exception.h"
+#include "FileData.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SURFACE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SURFACE_NEON
+#endif
 
 namespace OpenXcom
 {
 
+Uint8 Surface::_shadeTables[MAX_SHADE + 1][256];
+bool Surface::_shadeTablesBuilt = false;
+
+/**
+ * Multiplies a row of pixels by a factor, wrapping around
+ * like an 8-bit color does. 16 pixels at a time where the
+ * CPU has vector instructions, the rest one by one.
+ * @param row Pointer to the pixels.
+ * @param width Number of pixels.
+ * @param factor Factor to multiply by.
+ */
+static void multiplyRow(Uint8 *row, int width, int factor)
+{
+	int x = 0;
+#if defined(SURFACE_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i low = _mm_set1_epi16(0xff);
+	const __m128i f = _mm_set1_epi16(factor & 0xff);
+	for (; x + 16 <= width; x += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(row + x));
+		__m128i lo = _mm_and_si128(_mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), f), low);
+		__m128i hi = _mm_and_si128(_mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), f), low);
+		_mm_storeu_si128((__m128i*)(row + x), _mm_packus_epi16(lo, hi));
+	}
+#elif defined(SURFACE_NEON)
+	const uint8x16_t f = vdupq_n_u8((Uint8)factor);
+	for (; x + 16 <= width; x += 16)
+	{
+		vst1q_u8(row + x, vmulq_u8(vld1q_u8(row + x), f));
+	}
+#endif
+	for (; x < width; x++)
+	{
+		row[x] = (Uint8)(row[x] * factor);
+	}
+}
+
+/**
+ * Replaces the pixels of a row that match a mask color with
+ * the pixels of another row, by blending on the comparison
+ * instead of branching on every pixel.
+ * @param dest Pointer to the pixels to replace.
+ * @param src Pointer to the pixels to copy from.
+ * @param width Number of pixels.
+ * @param mask Color to replace.
+ */
+static void maskedCopyRow(Uint8 *dest, const Uint8 *src, int width, Uint8 mask)
+{
+	int x = 0;
+#if defined(SURFACE_SSE2)
+	const __m128i m = _mm_set1_epi8((char)mask);
+	for (; x + 16 <= width; x += 16)
+	{
+		__m128i d = _mm_loadu_si128((const __m128i*)(dest + x));
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+		__m128i eq = _mm_cmpeq_epi8(d, m);
+		_mm_storeu_si128((__m128i*)(dest + x), _mm_or_si128(_mm_and_si128(eq, s), _mm_andnot_si128(eq, d)));
+	}
+#elif defined(SURFACE_NEON)
+	const uint8x16_t m = vdupq_n_u8(mask);
+	for (; x + 16 <= width; x += 16)
+	{
+		uint8x16_t d = vld1q_u8(dest + x);
+		vst1q_u8(dest + x, vbslq_u8(vceqq_u8(d, m), vld1q_u8(src + x), d));
+	}
+#endif
+	for (; x < width; x++)
+	{
+		// 0xFF where the color matches, 0 elsewhere
+		Uint8 eq = (Uint8)-(dest[x] == mask);
+		dest[x] = (src[x] & eq) | (dest[x] & ~eq);
+	}
+}
+
 /**
  * Sets up a blank 8bpp surface with the specified size and position,
  * with pure black as the transparent color.
@@ -36,7 +121,7 @@ namespace OpenXcom
  * @param x X position in pixels.
  * @param y Y position in pixels.
  */
-Surface::Surface(int width, int height, int x, int y) : _x(x), _y(y), _visible(true), _hidden(false)
+Surface::Surface(int width, int height, int x, int y) : _x(x), _y(y), _visible(true), _hidden(false), _memoryTag(MEM_SURFACES), _memory(0), _sharedPalette(0), _paletteVersion(0)
 {
 	_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height, 8, 0, 0, 0, 0);
 
@@ -45,6 +130,37 @@ Surface::Surface(int width, int height, int x, int y) : _x(x), _y(y), _visible(t
 		throw Exception(SDL_GetError());
 	}
 
+	_memory = _surface->pitch * _surface->h;
+	Profiler::addMemory(_memoryTag, _memory);
+
+	SDL_SetColorKey(_surface, SDL_SRCCOLORKEY, 0);
+
+	_crop.w = 0;
+	_crop.h = 0;
+	_crop.x = 0;
+	_crop.y = 0;
+}
+
+/**
+ * Sets up an 8bpp surface over an existing block of pixels, with
+ * pure black as the transparent color. The pixels aren't copied,
+ * so they have to outlive the surface, and their memory is
+ * counted by whatever owns them.
+ * @param pixels Pointer to the pixels, one byte each, row after row.
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @param x X position in pixels.
+ * @param y Y position in pixels.
+ */
+Surface::Surface(Uint8 *pixels, int width, int height, int x, int y) : _x(x), _y(y), _visible(true), _hidden(false), _memoryTag(MEM_SURFACES), _memory(0), _sharedPalette(0), _paletteVersion(0)
+{
+	_surface = SDL_CreateRGBSurfaceFrom(pixels, width, height, 8, width, 0, 0, 0, 0);
+
+	if (_surface == 0)
+	{
+		throw Exception(SDL_GetError());
+	}
+
 	SDL_SetColorKey(_surface, SDL_SRCCOLORKEY, 0);
 
 	_crop.w = 0;
@@ -68,6 +184,11 @@ Surface::Surface(const Surface& other)
 	_visible = other._visible;
 	_hidden = other._hidden;
 	_surface = SDL_ConvertSurface(other._surface, other._surface->format, other._surface->flags);
+	_memoryTag = other._memoryTag;
+	_memory = _surface->pitch * _surface->h;
+	Profiler::addMemory(_memoryTag, _memory);
+	_sharedPalette = other._sharedPalette;
+	_paletteVersion = other._paletteVersion;
 }
 
 /**
@@ -75,9 +196,22 @@ Surface::Surface(const Surface& other)
  */
 Surface::~Surface()
 {
+	Profiler::addMemory(_memoryTag, -_memory);
 	SDL_FreeSurface(_surface);
 }
 
+/**
+ * Changes what the memory of the surface's pixels is
+ * counted as, for surfaces owned by a particular subsystem.
+ * @param tag Memory tag.
+ */
+void Surface::setMemoryTag(MemoryTag tag)
+{
+	Profiler::addMemory(_memoryTag, -_memory);
+	_memoryTag = tag;
+	Profiler::addMemory(_memoryTag, _memory);
+}
+
 /**
  * Loads the contents of an X-Com SCR image file into
  * the surface. SCR files are simply uncompressed images
@@ -87,33 +221,13 @@ Surface::~Surface()
  */
 void Surface::loadScr(const std::string &filename)
 {
-	// Load file and put pixels in surface
-	std::ifstream imgFile (filename.c_str(), std::ios::in | std::ios::binary);
-	if (!imgFile)
-	{
-		throw Exception("Failed to load SCR");
-	}
+	FileData file(filename, "Failed to load SCR");
 
-	// Lock the surface
+	// The file is the pixels in reading order, any extra is ignored
 	lock();
-	
-	Uint8 value;
-	int x = 0, y = 0;
-
-	while (imgFile.read((char*)&value, 1))
-	{
-		setPixelIterative(&x, &y, value);
-	}
-
-	if (!imgFile.eof())
-	{
-		throw Exception("Invalid data from file");
-	}
-
-	// Unlock the surface
+	int size = (int)std::min(file.getSize(), (size_t)(getWidth() * getHeight()));
+	setPixels(0, file.getData(), size);
 	unlock();
-
-	imgFile.close();
 }
 
 /**
@@ -125,45 +239,43 @@ void Surface::loadScr(const std::string &filename)
  */
 void Surface::loadSpk(const std::string &filename)
 {
-	// Load file and put pixels in surface
-	std::ifstream imgFile (filename.c_str(), std::ios::in | std::ios::binary);
-	if (!imgFile)
-	{
-		throw Exception("Failed to load SPK");
-	}
+	FileData file(filename, "Failed to load SPK");
+	const Uint8 *data = file.getData();
+	size_t size = file.getSize(), in = 0;
 
 	// Lock the surface
 	lock();
-	
-	Uint16 flag;
-	Uint8 value;
-	int x = 0, y = 0;
 
-	while (imgFile.read((char*)&flag, sizeof(flag)) && flag != 65533)
+	// Runs of transparent or copied pixels, each a flag and a count of pixel pairs
+	int pos = 0;
+	while (in + 4 <= size)
 	{
+		Uint16 flag = file.getUint16(in);
+		if (flag == 65533)
+			break;
+		int count = file.getUint16(in + 2) * 2;
+		in += 4;
 		if (flag == 65535)
 		{
-			imgFile.read((char*)&flag, sizeof(flag));
-			for (int i = 0; i < flag * 2; i++)
-			{
-				setPixelIterative(&x, &y, 0);
-			}
+			setPixels(pos, 0, count);
+			pos += count;
 		}
 		else if (flag == 65534)
 		{
-			imgFile.read((char*)&flag, sizeof(flag));
-			for (int i = 0; i < flag * 2; i++)
-			{
-				imgFile.read((char*)&value, 1);
-				setPixelIterative(&x, &y, value);
-			}
+			int copy = (int)std::min((size_t)count, size - in);
+			setPixels(pos, data + in, copy);
+			pos += copy;
+			in += copy;
+		}
+		else
+		{
+			// unknown flags are skipped on their own
+			in -= 2;
 		}
 	}
 
 	// Unlock the surface
 	unlock();
-
-	imgFile.close();
 }
 
 /**
@@ -178,6 +290,7 @@ void Surface::clear()
 	square.w = getWidth();
 	square.h = getHeight();
 	SDL_FillRect(_surface, &square, 0);
+	_rle.clear();
 }
 
 /**
@@ -190,12 +303,10 @@ void Surface::clear()
  */
 void Surface::offset(int off, int min, int max)
 {
-	// Lock the surface
-	lock();
-	
-	for (int x = 0, y = 0; x < getWidth() && y < getHeight();)
+	Uint8 table[256];
+	table[0] = 0;
+	for (int pixel = 1; pixel < 256; pixel++)
 	{
-		Uint8 pixel = getPixel(x, y);
 		int p = pixel + off;
 		if (min != -1 && p < min)
 		{
@@ -205,19 +316,9 @@ void Surface::offset(int off, int min, int max)
 		{
 			p = max;
 		}
-
-		if (pixel > 0)
-		{
-			setPixelIterative(&x, &y, p);
-		}
-		else
-		{
-			setPixelIterative(&x, &y, 0);
-		}
+		table[pixel] = p;
 	}
-
-	// Unlock the surface
-	unlock();
+	remap(table);
 }
 
 /**
@@ -228,11 +329,10 @@ void Surface::multiply(int factor)
 {
 	// Lock the surface
 	lock();
-	
-	for (int x = 0, y = 0; x < getWidth() && y < getHeight();)
+
+	for (int y = 0; y < getHeight(); y++)
 	{
-		Uint8 pixel = getPixel(x, y);
-		setPixelIterative(&x, &y, pixel * factor);
+		multiplyRow(getRow(y), getWidth(), factor);
 	}
 
 	// Unlock the surface
@@ -246,24 +346,13 @@ void Surface::multiply(int factor)
  */
 void Surface::invert(Uint8 mid)
 {
-	// Lock the surface
-	lock();
-
-	for (int x = 0, y = 0; x < getWidth() && y < getHeight();)
+	Uint8 table[256];
+	table[0] = 0;
+	for (int pixel = 1; pixel < 256; pixel++)
 	{
-		Uint8 pixel = getPixel(x, y);
-		if (pixel > 0)
-		{
-			setPixelIterative(&x, &y, pixel + 2 * (mid - pixel));
-		}
-		else
-		{
-			setPixelIterative(&x, &y, 0);
-		}
+		table[pixel] = pixel + 2 * (mid - pixel);
 	}
-
-	// Unlock the surface
-	unlock();
+	remap(table);
 }
 
 /**
@@ -273,36 +362,63 @@ void Surface::invert(Uint8 mid)
  */
 void Surface::setShade(int shade)
 {
-	// Lock the surface
-	lock();
-	for (int x = 0, y = 0; x < _surface->w && y < _surface->h;)
+	remap(getShadeTable(shade));
+}
+
+/**
+ * Returns the color remap table for a shade level: every color
+ * is moved that many shades darker within its 16 color block,
+ * and anything that goes past the darkest shade becomes black.
+ * @param shade Shade level, 0 is original color, 16 is black.
+ * @return Table of 256 colors, transparent stays transparent.
+ */
+const Uint8 *Surface::getShadeTable(int shade)
+{
+	if (!_shadeTablesBuilt)
 	{
-		Uint8 pixel = getPixel(x, y);
-		if (pixel)
+		for (int level = 0; level <= MAX_SHADE; level++)
 		{
-			int baseColor = pixel/16;
-			int originalShade = pixel%16;
-			int newShade = originalShade + shade;
-			if (newShade > 15)
-			{
-				baseColor = 0;
-				newShade = 15;
-			}
-			if (originalShade != newShade || baseColor == 0)
+			_shadeTables[level][0] = 0;
+			for (int pixel = 1; pixel < 256; pixel++)
 			{
-				pixel = (baseColor*16) + newShade;
-				setPixel(x, y, pixel);
+				int baseColor = pixel / 16;
+				int newShade = pixel % 16 + level;
+				if (newShade > 15)
+				{
+					baseColor = 0;
+					newShade = 15;
+				}
+				_shadeTables[level][pixel] = baseColor * 16 + newShade;
 			}
 		}
-		x++;
-		if (x == getWidth())
+		_shadeTablesBuilt = true;
+	}
+	if (shade < 0)
+	{
+		shade = 0;
+	}
+	else if (shade > MAX_SHADE)
+	{
+		shade = MAX_SHADE;
+	}
+	return _shadeTables[shade];
+}
+
+/**
+ * Replaces every color in the surface through a remap table.
+ * @param table Table of 256 colors to replace each color with.
+ */
+void Surface::remap(const Uint8 *table)
+{
+	lock();
+	for (int y = 0; y < _surface->h; y++)
+	{
+		Uint8 *row = getRow(y);
+		for (int x = 0; x < _surface->w; x++)
 		{
-			y++;
-			x = 0;
+			row[x] = table[row[x]];
 		}
 	}
-
-	// Unlock the surface
 	unlock();
 }
 
@@ -335,6 +451,8 @@ void Surface::blit(Surface *surface)
 {
 	if (_visible && !_hidden)
 	{
+		syncPalette();
+		surface->syncPalette();
 		SDL_Rect* cropper;
 		SDL_Rect target;
 		if (_crop.w == 0 && _crop.h == 0)
@@ -347,10 +465,195 @@ void Surface::blit(Surface *surface)
 		}
 		target.x = getX();
 		target.y = getY();
-		SDL_BlitSurface(_surface, cropper, surface->getSurface(), &target);
+		if (!_rle.empty() && surface->getSurface()->format->BytesPerPixel == 1)
+		{
+			blitRle(surface, cropper);
+		}
+		else
+		{
+			SDL_BlitSurface(_surface, cropper, surface->getSurface(), &target);
+			surface->_rle.clear();
+		}
 	}
 }
 
+/**
+ * Encodes the surface as runs of transparent and opaque pixels,
+ * so blitting it can skip over transparent areas altogether.
+ * Meant for sprites that are blitted a lot but never change, the
+ * encoding is dropped as soon as the surface is drawn on.
+ */
+void Surface::encodeRle()
+{
+	_rle.clear();
+	_rleRows.clear();
+	SDL_LockSurface(_surface);
+	for (int y = 0; y < _surface->h; y++)
+	{
+		const Uint8 *row = (Uint8*)_surface->pixels + y * _surface->pitch;
+		_rleRows.push_back(_rle.size());
+		int x = 0;
+		while (x < _surface->w)
+		{
+			// each run is a number of transparent pixels to skip and the opaque pixels after them
+			int skip = 0, count = 0;
+			while (x + skip < _surface->w && !row[x + skip] && skip < 255)
+				skip++;
+			while (x + skip + count < _surface->w && row[x + skip + count] && count < 255)
+				count++;
+			if (skip == 0 && count == 0)
+				break;
+			_rle.push_back(skip);
+			_rle.push_back(count);
+			_rle.insert(_rle.end(), row + x + skip, row + x + skip + count);
+			x += skip + count;
+		}
+		// a run of nothing ends the row
+		_rle.push_back(0);
+		_rle.push_back(0);
+	}
+	SDL_UnlockSurface(_surface);
+}
+
+/**
+ * Blits the run-length encoded surface onto another one,
+ * clipping it against the cropping rectangle and the other
+ * surface's clipping rectangle.
+ * @param surface Pointer to an 8-bit surface to blit onto.
+ * @param cropper Pointer to the cropping rectangle, 0 for the whole surface.
+ */
+void Surface::blitRle(Surface *surface, const SDL_Rect *cropper)
+{
+	int srcX = 0, srcY = 0, width = getWidth(), height = getHeight();
+	if (cropper)
+	{
+		srcX = std::max((int)cropper->x, 0);
+		srcY = std::max((int)cropper->y, 0);
+		width = std::min(cropper->x + cropper->w, getWidth()) - srcX;
+		height = std::min(cropper->y + cropper->h, getHeight()) - srcY;
+	}
+	SDL_Rect clip;
+	SDL_GetClipRect(surface->getSurface(), &clip);
+	int dstX = getX(), dstY = getY();
+	if (dstX < clip.x)
+	{
+		srcX += clip.x - dstX;
+		width -= clip.x - dstX;
+		dstX = clip.x;
+	}
+	if (dstY < clip.y)
+	{
+		srcY += clip.y - dstY;
+		height -= clip.y - dstY;
+		dstY = clip.y;
+	}
+	width = std::min(width, clip.x + clip.w - dstX);
+	height = std::min(height, clip.y + clip.h - dstY);
+	if (width <= 0 || height <= 0)
+		return;
+
+	SDL_Surface *dst = surface->getSurface();
+	SDL_LockSurface(dst);
+	int endX = srcX + width;
+	for (int y = 0; y < height; y++)
+	{
+		const Uint8 *run = &_rle[_rleRows[srcY + y]];
+		Uint8 *dest = (Uint8*)dst->pixels + (dstY + y) * dst->pitch + dstX - srcX;
+		int x = 0;
+		while ((run[0] || run[1]) && x < endX)
+		{
+			x += run[0];
+			int count = run[1];
+			const Uint8 *pixels = run + 2;
+			run += 2 + count;
+			// only copy the part of the run inside the clipped area
+			int from = std::max(x, srcX), to = std::min(x + count, endX);
+			if (from < to)
+			{
+				memcpy(dest + from, pixels + (from - x), to - from);
+			}
+			x += count;
+		}
+	}
+	SDL_UnlockSurface(dst);
+	surface->_rle.clear();
+}
+
+/**
+ * Blits this surface onto another one, replacing every color
+ * through a remap table on the way, so a shaded copy doesn't
+ * need a separate pass. Transparent pixels are skipped, and the
+ * cropping rectangle and the other surface's clipping are kept.
+ * @param surface Pointer to surface to blit onto.
+ * @param table Table of 256 colors to replace each color with.
+ */
+void Surface::blitRemapped(Surface *surface, const Uint8 *table)
+{
+	if (_visible && !_hidden)
+	{
+		blitRemapped(surface, table, getX(), getY(), &_crop);
+	}
+}
+
+/**
+ * Blits part of this surface onto another one at a certain position,
+ * replacing every color through a remap table on the way. Neither
+ * this surface's position nor its cropping rectangle are touched,
+ * so several callers can share it (like the characters of a font).
+ * @param surface Pointer to surface to blit onto.
+ * @param table Table of 256 colors to replace each color with.
+ * @param dstX X position to blit to.
+ * @param dstY Y position to blit to.
+ * @param crop Part of this surface to blit, or blank for all of it.
+ */
+void Surface::blitRemapped(Surface *surface, const Uint8 *table, int dstX, int dstY, const SDL_Rect *crop) const
+{
+	int srcX = 0, srcY = 0, width = getWidth(), height = getHeight();
+	if (crop->w != 0 || crop->h != 0)
+	{
+		srcX = crop->x;
+		srcY = crop->y;
+		width = std::min((int)crop->w, getWidth() - srcX);
+		height = std::min((int)crop->h, getHeight() - srcY);
+	}
+	SDL_Rect clip;
+	SDL_GetClipRect(surface->getSurface(), &clip);
+	if (dstX < clip.x)
+	{
+		srcX += clip.x - dstX;
+		width -= clip.x - dstX;
+		dstX = clip.x;
+	}
+	if (dstY < clip.y)
+	{
+		srcY += clip.y - dstY;
+		height -= clip.y - dstY;
+		dstY = clip.y;
+	}
+	width = std::min(width, clip.x + clip.w - dstX);
+	height = std::min(height, clip.y + clip.h - dstY);
+	if (width <= 0 || height <= 0)
+		return;
+
+	SDL_LockSurface(_surface);
+	surface->lock();
+	SDL_Surface *dst = surface->getSurface();
+	for (int y = 0; y < height; y++)
+	{
+		const Uint8 *src = (Uint8*)_surface->pixels + (srcY + y) * _surface->pitch + srcX;
+		Uint8 *dest = (Uint8*)dst->pixels + (dstY + y) * dst->pitch + dstX;
+		for (int x = 0; x < width; x++)
+		{
+			if (src[x])
+			{
+				dest[x] = table[src[x]];
+			}
+		}
+	}
+	surface->unlock();
+	SDL_UnlockSurface(_surface);
+}
+
 /**
  * Copies the exact contents of another surface onto this one.
  * Only the content that would overlap both surfaces is copied, in
@@ -365,38 +668,35 @@ void Surface::copy(Surface *surface)
 	from.y = getY() - surface->getY();
 	from.w = getWidth();
 	from.h = getHeight();
+	syncPalette();
+	surface->syncPalette();
 	SDL_BlitSurface(surface->getSurface(), &from, _surface, 0);
+	_rle.clear();
 }
 
 /**
  * Copies the exact contents of another surface onto the areas that
- * match a certain color, like a mask. Surface sizes must match.
+ * match a certain color, like a mask. Only the area covered
+ * by both surfaces is copied.
  * @param surface Pointer to surface to copy from.
  * @param mask Color mask to replace with the other surface.
  */
 void Surface::maskedCopy(Surface *surface, Uint8 mask)
 {
-	if (surface->getWidth() != getWidth() || surface->getHeight() != getHeight())
-	{
-		return;
-	}
+	int width = std::min(getWidth(), surface->getWidth());
+	int height = std::min(getHeight(), surface->getHeight());
 
-	// Lock the surface
+	// Lock the surfaces
 	lock();
+	surface->lock();
 
-	for (int x = 0, y = 0; x < getWidth() && y < getHeight();)
+	for (int y = 0; y < height; y++)
 	{
-		if (getPixel(x, y) == mask)
-		{
-			setPixelIterative(&x, &y, surface->getPixel(x, y));
-		}
-		else
-		{
-			setPixelIterative(&x, &y, this->getPixel(x, y));
-		}
+		maskedCopyRow(getRow(y), surface->getRow(y), width, mask);
 	}
 
-	// Unlock the surface
+	// Unlock the surfaces
+	surface->unlock();
 	unlock();
 }
 
@@ -408,6 +708,7 @@ void Surface::maskedCopy(Surface *surface, Uint8 mask)
 void Surface::drawRect(SDL_Rect *rect, Uint8 color)
 {
     SDL_FillRect(_surface, rect, color);
+	_rle.clear();
 }
 
 /**
@@ -421,6 +722,7 @@ void Surface::drawRect(SDL_Rect *rect, Uint8 color)
 void Surface::drawLine(Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 color)
 {
     lineColor(_surface, x1, y1, x2, y2, Palette::getRGBA(getPalette(), color));
+	_rle.clear();
 }
 
 /**
@@ -433,6 +735,7 @@ void Surface::drawLine(Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 color)
 void Surface::drawCircle(Sint16 x, Sint16 y, Sint16 r, Uint8 color)
 {
     filledCircleColor(_surface, x, y, r, Palette::getRGBA(getPalette(), color));
+	_rle.clear();
 }
 
 /**
@@ -445,20 +748,107 @@ void Surface::drawCircle(Sint16 x, Sint16 y, Sint16 r, Uint8 color)
 void Surface::drawPolygon(Sint16 *x, Sint16 *y, int n, Uint8 color)
 {
     filledPolygonColor(_surface, x, y, n, Palette::getRGBA(getPalette(), color));
+	_rle.clear();
 }
 
 /**
- * Draws a textured polygon on the surface.
+ * Draws a textured polygon on the surface. The texture is tiled
+ * across the screen and copied straight from its 8bpp pixels,
+ * one scanline at a time, filling the same pixels SDL_gfx does.
  * @param x Array of x coordinates.
  * @param y Array of y coordinates.
  * @param n Number of points.
  * @param texture Texture for polygon.
  * @param dx X offset of texture relative to the screen.
  * @param dy Y offset of texture relative to the screen.
+ * @param table Table of 256 colors to replace the texture colors with, if any.
  */
-void Surface::drawTexturedPolygon(Sint16 *x, Sint16 *y, int n, Surface *texture, int dx, int dy)
+void Surface::drawTexturedPolygon(Sint16 *x, Sint16 *y, int n, Surface *texture, int dx, int dy, const Uint8 *table)
 {
-    texturedPolygon(_surface, x, y, n, texture->getSurface(), dx, dy);
+	if (n < 3)
+		return;
+
+	int minY = y[0], maxY = y[0];
+	for (int i = 1; i < n; i++)
+	{
+		minY = std::min(minY, (int)y[i]);
+		maxY = std::max(maxY, (int)y[i]);
+	}
+
+	SDL_Rect clip;
+	SDL_GetClipRect(_surface, &clip);
+	int clipTop = std::max(minY, (int)clip.y), clipBottom = std::min(maxY, clip.y + clip.h - 1);
+	if (clipTop > clipBottom)
+		return;
+
+	int stackInts[8];
+	std::vector<int> heapInts;
+	int *ints = stackInts;
+	if (n > 8)
+	{
+		heapInts.resize(n);
+		ints = &heapInts[0];
+	}
+
+	SDL_Surface *src = texture->getSurface();
+	lock();
+	SDL_LockSurface(src);
+	for (int row = clipTop; row <= clipBottom; row++)
+	{
+		// Find where the edges cross this scanline, in 16.16 fixed point
+		int count = 0;
+		for (int i = 0; i < n; i++)
+		{
+			int j = (i == 0) ? n - 1 : i - 1;
+			int x1, y1, x2, y2;
+			if (y[j] < y[i])
+			{
+				x1 = x[j]; y1 = y[j]; x2 = x[i]; y2 = y[i];
+			}
+			else if (y[j] > y[i])
+			{
+				x1 = x[i]; y1 = y[i]; x2 = x[j]; y2 = y[j];
+			}
+			else
+			{
+				continue;
+			}
+			if ((row >= y1 && row < y2) || (row == maxY && row > y1 && row <= y2))
+			{
+				ints[count++] = ((65536 * (row - y1)) / (y2 - y1)) * (x2 - x1) + 65536 * x1;
+			}
+		}
+		std::sort(ints, ints + count);
+
+		int texY = (row + dy) % src->h;
+		if (texY < 0)
+			texY += src->h;
+		const Uint8 *texRow = (Uint8*)src->pixels + texY * src->pitch;
+		Uint8 *dest = (Uint8*)_surface->pixels + row * _surface->pitch;
+		for (int i = 0; i + 1 < count; i += 2)
+		{
+			int xa = ints[i] + 1;
+			xa = (xa >> 16) + ((xa & 32768) >> 15);
+			int xb = ints[i + 1] - 1;
+			xb = (xb >> 16) + ((xb & 32768) >> 15);
+			xa = std::max(xa, (int)clip.x);
+			xb = std::min(xb, clip.x + clip.w - 1);
+			if (xa > xb)
+				continue;
+
+			int texX = (xa - dx) % src->w;
+			if (texX < 0)
+				texX += src->w;
+			for (int px = xa; px <= xb; px++)
+			{
+				dest[px] = table ? table[texRow[texX]] : texRow[texX];
+				if (++texX == src->w)
+					texX = 0;
+			}
+		}
+	}
+	SDL_UnlockSurface(src);
+	unlock();
 }
 
 /**
@@ -471,6 +861,7 @@ void Surface::drawTexturedPolygon(Sint16 *x, Sint16 *y, int n, Surface *texture,
 void Surface::drawString(Sint16 x, Sint16 y, const char *s, Uint8 color)
 {
     stringColor(_surface, x, y, s, Palette::getRGBA(getPalette(), color));
+	_rle.clear();
 }
 
 /**
@@ -541,12 +932,41 @@ void Surface::setPalette(SDL_Color *colors, int firstcolor, int ncolors)
 	SDL_SetColors(_surface, colors, firstcolor, ncolors);
 }
 
+/**
+ * Makes the surface take its colors from a shared palette,
+ * like the resource graphics do, so changing the palette
+ * doesn't have to go through every one of them.
+ * @param palette Pointer to the shared palette, 0 for none.
+ */
+void Surface::setSharedPalette(const SharedPalette *palette)
+{
+	_sharedPalette = palette;
+	_paletteVersion = 0;
+	syncPalette();
+}
+
+/**
+ * Copies the colors of the shared palette into the surface,
+ * if they changed since the last time. Blitting only needs
+ * the right colors when SDL converts between the palettes
+ * of two surfaces, so this is done right before that.
+ */
+void Surface::syncPalette() const
+{
+	if (_sharedPalette != 0 && _paletteVersion != _sharedPalette->version)
+	{
+		SDL_SetColors(_surface, const_cast<SDL_Color*>(_sharedPalette->colors), 0, 256);
+		_paletteVersion = _sharedPalette->version;
+	}
+}
+
 /**
  * Returns the surface's 8bpp palette.
  * @return Pointer to the palette's colors.
  */
 SDL_Color *const Surface::getPalette() const
 {
+	syncPalette();
 	return _surface->format->palette->colors;
 }
 
@@ -563,6 +983,7 @@ void Surface::setPixel(int x, int y, Uint8 pixel)
 	{
 		return;
 	}
+	_rle.clear();
     ((Uint8 *)_surface->pixels)[y * _surface->pitch + x * _surface->format->BytesPerPixel] = pixel;
 }
 
@@ -585,6 +1006,63 @@ void Surface::setPixelIterative(int *x, int *y, Uint8 pixel)
 	}
 }
 
+/**
+ * Returns the pixels of a row of the surface, for effects
+ * that go over whole rows instead of pixel by pixel.
+ * The surface must be locked, and anything written to
+ * the row is up to the caller to keep in sync.
+ * @param y Y position of the row.
+ * @return Pointer to the first pixel of the row.
+ */
+Uint8 *Surface::getRow(int y) const
+{
+	return (Uint8*)_surface->pixels + y * _surface->pitch;
+}
+
+/**
+ * Returns the number of bytes from the start of one row
+ * of pixels to the start of the next.
+ * @return Pitch in bytes.
+ */
+int Surface::getPitch() const
+{
+	return _surface->pitch;
+}
+
+/**
+ * Changes the colors of a run of pixels, going in reading
+ * order from a position and on to the next rows, like a
+ * row of setPixelIterative calls but a row at a time.
+ * Anything past the end of the surface is left out.
+ * @param pos Position of the first pixel, as y * width + x.
+ * @param pixels Colors of the pixels, or 0 to clear them.
+ * @param count Number of pixels.
+ */
+void Surface::setPixels(int pos, const Uint8 *pixels, int count)
+{
+	int width = getWidth();
+	int end = std::min(pos + count, width * getHeight());
+	if (pos < 0 || pos >= end)
+		return;
+	_rle.clear();
+	while (pos < end)
+	{
+		int x = pos % width, y = pos / width;
+		int run = std::min(width - x, end - pos);
+		Uint8 *dest = (Uint8*)_surface->pixels + y * _surface->pitch + x;
+		if (pixels != 0)
+		{
+			memcpy(dest, pixels, run);
+			pixels += run;
+		}
+		else
+		{
+			memset(dest, 0, run);
+		}
+		pos += run;
+	}
+}
+
 /**
  * Returns the color of a specified pixel in the surface.
  * @param x X position of the pixel.
@@ -670,6 +1148,8 @@ void Surface::show()
  */
 void Surface::lock()
 {
+	// whatever gets locked for is going to change the pixels
+	_rle.clear();
 	SDL_LockSurface(_surface);
 }
 
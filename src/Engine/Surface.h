@@ -21,10 +21,26 @@
 
 #include "SDL.h"
 #include <string>
+#include <vector>
+#include "Profiler.h"
+
+#define MAX_SHADE 16
 
 namespace OpenXcom
 {
 
+/**
+ * A set of colors shared by many surfaces. Changing it is just a
+ * copy and a new version, the surfaces using it pick up the new
+ * colors the next time they're blitted. Versions start
+ * at 1, surfaces that never synced are at 0.
+ */
+struct SharedPalette
+{
+	SDL_Color colors[256];
+	unsigned int version;
+};
+
 /**
  * Element that is blit (rendered) onto the screen.
  * Mainly an encapsulation for SDL's SDL_Surface struct, so it
@@ -39,13 +55,27 @@ protected:
 	int _x, _y;
 	SDL_Rect _crop;
 	bool _visible, _hidden;
+	MemoryTag _memoryTag;
+	int _memory;
+	static Uint8 _shadeTables[MAX_SHADE + 1][256];
+	static bool _shadeTablesBuilt;
+	std::vector<Uint8> _rle;
+	std::vector<int> _rleRows;
+	const SharedPalette *_sharedPalette;
+	mutable unsigned int _paletteVersion;
+	void blitRle(Surface *surface, const SDL_Rect *cropper);
+	void syncPalette() const;
 public:
 	/// Creates a new surface with the specified size and position.
 	Surface(int width, int height, int x = 0, int y = 0);
+	/// Creates a new surface over existing pixels.
+	Surface(Uint8 *pixels, int width, int height, int x = 0, int y = 0);
 	/// Creates a new surface from an existing one.
 	Surface(const Surface& other);
 	/// Cleans up the surface.
 	virtual ~Surface();
+	/// Sets what the surface's memory is counted as.
+	void setMemoryTag(MemoryTag tag);
 	/// Loads an X-Com SCR graphic.
 	void loadScr(const std::string &filename);
 	/// Loads an X-Com SPK graphic.
@@ -60,12 +90,22 @@ public:
 	void invert(Uint8 mid);
 	/// Sets the surface's shade level.
 	void setShade(int shade);
+	/// Gets the color remap table for a shade level.
+	static const Uint8 *getShadeTable(int shade);
+	/// Replaces the surface's colors through a remap table.
+	void remap(const Uint8 *table);
 	/// Runs surface functionality every cycle
 	virtual void think();
 	/// Draws the surface's graphic.
 	virtual void draw();
 	/// Blits this surface onto another one.
 	virtual void blit(Surface *surface);
+	/// Encodes the surface's transparent areas for faster blitting.
+	void encodeRle();
+	/// Blits this surface onto another one, remapping its colors.
+	void blitRemapped(Surface *surface, const Uint8 *table);
+	/// Blits part of this surface onto another one at a certain position, remapping its colors.
+	void blitRemapped(Surface *surface, const Uint8 *table, int dstX, int dstY, const SDL_Rect *crop) const;
 	/// Copies a portion of another surface into this one.
 	void copy(Surface *surface);
 	/// Copies a portion of another surface according to a mask.
@@ -79,11 +119,13 @@ public:
     /// Draws a filled polygon on the surface.
     void drawPolygon(Sint16 *x, Sint16 *y, int n, Uint8 color);
     /// Draws a textured polygon on the surface.
-    void drawTexturedPolygon(Sint16 *x, Sint16 *y, int n, Surface *texture, int dx, int dy);
+    void drawTexturedPolygon(Sint16 *x, Sint16 *y, int n, Surface *texture, int dx, int dy, const Uint8 *table = 0);
     /// Draws a string on the surface.
     void drawString(Sint16 x, Sint16 y, const char *s, Uint8 color);
 	/// Sets the surface's palette.
 	virtual void setPalette(SDL_Color *colors, int firstcolor = 0, int ncolors = 256);
+	/// Makes the surface use a shared palette.
+	void setSharedPalette(const SharedPalette *palette);
 	/// Gets the surface's palette.
 	SDL_Color *const getPalette() const;
 	/// Sets the X position of the surface.
@@ -102,8 +144,14 @@ public:
 	void setPixel(int x, int y, Uint8 pixel);
 	/// Changes a pixel in the surface and returns the next one.
 	void setPixelIterative(int *x, int *y, Uint8 pixel);
+	/// Changes the colors of a run of pixels in reading order.
+	void setPixels(int pos, const Uint8 *pixels, int count);
 	/// Gets a pixel of the surface.
 	Uint8 getPixel(int x, int y) const;
+	/// Gets the pixels of a row of the surface.
+	Uint8 *getRow(int y) const;
+	/// Gets the number of bytes from one row to the next.
+	int getPitch() const;
 	/// Gets the internal SDL surface.
 	SDL_Surface *const getSurface() const;
 	/// Gets the surface's width.
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SurfacePool.h"
+#include "Surface.h"
+
+namespace OpenXcom
+{
+
+std::map<std::pair<int, int>, std::vector<Surface*> > SurfacePool::_spare;
+
+/**
+ * Hands out a spare surface of the right size if there is one,
+ * or a new one otherwise. Either way it comes back cleared,
+ * at the origin and with nothing cropped or hidden.
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @return Pointer to the surface, to be given back with release().
+ */
+Surface *SurfacePool::acquire(int width, int height)
+{
+	std::vector<Surface*> &spare = _spare[std::make_pair(width, height)];
+	if (spare.empty())
+	{
+		return new Surface(width, height);
+	}
+	Surface *surface = spare.back();
+	spare.pop_back();
+	surface->setX(0);
+	surface->setY(0);
+	surface->resetCrop();
+	surface->setVisible(true);
+	surface->show();
+	surface->clear();
+	return surface;
+}
+
+/**
+ * Keeps a surface for the next time one of its size is needed,
+ * unless there's already enough of those around.
+ * @param surface Pointer to a surface from acquire().
+ */
+void SurfacePool::release(Surface *surface)
+{
+	if (surface == 0)
+		return;
+
+	std::vector<Surface*> &spare = _spare[std::make_pair(surface->getWidth(), surface->getHeight())];
+	if (spare.size() < MAX_PER_SIZE)
+	{
+		spare.push_back(surface);
+	}
+	else
+	{
+		delete surface;
+	}
+}
+
+/**
+ * Frees all the surfaces kept in the pool.
+ * Surfaces that are still borrowed aren't affected.
+ */
+void SurfacePool::clear()
+{
+	for (std::map<std::pair<int, int>, std::vector<Surface*> >::iterator i = _spare.begin(); i != _spare.end(); ++i)
+	{
+		for (std::vector<Surface*>::iterator j = i->second.begin(); j != i->second.end(); ++j)
+		{
+			delete *j;
+		}
+	}
+	_spare.clear();
+}
+
+/**
+ * Borrows a surface from the pool.
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ */
+SurfaceLease::SurfaceLease(int width, int height) : _surface(SurfacePool::acquire(width, height))
+{
+}
+
+/**
+ * Gives the surface back to the pool.
+ */
+SurfaceLease::~SurfaceLease()
+{
+	SurfacePool::release(_surface);
+}
+
+/**
+ * Returns the borrowed surface.
+ * @return Pointer to the surface.
+ */
+Surface *SurfaceLease::get() const
+{
+	return _surface;
+}
+
+/**
+ * Accesses the borrowed surface.
+ * @return Pointer to the surface.
+ */
+Surface *SurfaceLease::operator->() const
+{
+	return _surface;
+}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_SURFACEPOOL_H
+#define OPENXCOM_SURFACEPOOL_H
+
+#include <map>
+#include <vector>
+#include <utility>
+
+namespace OpenXcom
+{
+
+class Surface;
+
+/**
+ * Keeps spare surfaces around for rendering that only needs
+ * a surface for a moment, so they don't have to be created
+ * and freed through SDL every time. Surfaces are kept in
+ * buckets by their size, and only a few of each size.
+ */
+class SurfacePool
+{
+private:
+	static const unsigned int MAX_PER_SIZE = 4;
+	static std::map<std::pair<int, int>, std::vector<Surface*> > _spare;
+public:
+	/// Gets a cleared surface of a certain size.
+	static Surface *acquire(int width, int height);
+	/// Gives a surface back to the pool.
+	static void release(Surface *surface);
+	/// Frees all the spare surfaces.
+	static void clear();
+};
+
+/**
+ * A surface borrowed from the surface pool for as long
+ * as the lease is in scope.
+ */
+class SurfaceLease
+{
+private:
+	Surface *_surface;
+	SurfaceLease(const SurfaceLease&);
+	SurfaceLease &operator=(const SurfaceLease&);
+public:
+	/// Borrows a surface of a certain size.
+	SurfaceLease(int width, int height);
+	/// Gives the surface back.
+	~SurfaceLease();
+	/// Gets the borrowed surface.
+	Surface *get() const;
+	/// Accesses the borrowed surface.
+	Surface *operator->() const;
+};
+
+}
+
+#endif
@@ -18,8 +18,11 @@
  */
 #include "SurfaceSet.h"
 #include <fstream>
+#include <cstring>
 #include "Surface.h"
 #include "Exception.h"
+#include "FileData.h"
+#include "Profiler.h"
 
 namespace OpenXcom
 {
@@ -29,7 +32,7 @@ namespace OpenXcom
  * @param width Frame width in pixels.
  * @param height Frame height in pixels.
  */
-SurfaceSet::SurfaceSet(int width, int height) : _width(width), _height(height), _frames()
+SurfaceSet::SurfaceSet(int width, int height) : _width(width), _height(height), _frames(), _memory(0)
 {
 
 }
@@ -42,10 +45,12 @@ SurfaceSet::SurfaceSet(const SurfaceSet& other)
 {
 	_width = other._width;
 	_height = other._height;
+	_memory = 0;
 
 	for (unsigned int f = 0; f < other._frames.size(); f++)
 	{
 		_frames.push_back(new Surface(*other._frames[f]));
+		_frames.back()->setMemoryTag(MEM_SPRITES);
 	}
 }
 
@@ -58,6 +63,11 @@ SurfaceSet::~SurfaceSet()
 	{
 		delete *i;
 	}
+	for (std::vector<Uint8*>::iterator i = _pixels.begin(); i != _pixels.end(); i++)
+	{
+		delete[] *i;
+	}
+	Profiler::addMemory(MEM_SPRITES, -_memory);
 }
 
 /**
@@ -73,72 +83,69 @@ void SurfaceSet::loadPck(const std::string &pck, const std::string &tab)
 {
 	int nframes = 0;
 
-	// Load TAB and get image offsets
+	// Load TAB and count image offsets
 	std::ifstream offsetFile (tab.c_str(), std::ios::in | std::ios::binary);
 	if (!offsetFile)
 	{
 		nframes = 1;
-		Surface *surface = new Surface(_width, _height);
-		_frames.push_back(surface);
 	}
 	else
 	{
-		Uint16 off;
-
-		while (offsetFile.read((char*)&off, sizeof(off)))
-		{
-			Surface *surface = new Surface(_width, _height);
-			_frames.push_back(surface);
-			nframes++;
-		}
+		offsetFile.seekg(0, std::ios::end);
+		nframes = (int)offsetFile.tellg() / sizeof(Uint16);
 	}
 
-	// Load PCX and put pixels in surfaces
-    std::ifstream imgFile (pck.c_str(), std::ios::in | std::ios::binary);
-	if (!imgFile)
-	{
-		throw Exception("Failed to load PCK");
-	}
-	
-	Uint8 value;
-	
+	// Load the whole PCK at once
+	FileData file(pck, "Failed to load PCK");
+
+	// Decode all frames into one block of pixels, each frame is a surface over its part
+	int frameSize = _width * _height;
+	Uint8 *pixels = new Uint8[nframes * frameSize];
+	memset(pixels, 0, nframes * frameSize);
+	_pixels.push_back(pixels);
+	_memory += nframes * frameSize;
+	Profiler::addMemory(MEM_SPRITES, nframes * frameSize);
+
+	const Uint8 *in = file.getData(), *end = file.getData() + file.getSize();
 	for (int frame = 0; frame < nframes; frame++)
 	{
-		int x = 0, y = 0;
+		Uint8 *out = pixels + frame * frameSize;
+		int pos = 0;
 
-		// Lock the surface
-		_frames[frame]->lock();
-
-		imgFile.read((char*)&value, 1);
-		for (int i = 0; i < value; i++)
+		if (in < end)
 		{
-			for (int j = 0; j < _width; j++)
-			{
-				_frames[frame]->setPixelIterative(&x, &y, 0);
-			}
+			// number of empty rows at the top
+			pos = *in++ * _width;
 		}
-		
-		while (imgFile.read((char*)&value, 1) && value != 255)
+		while (in < end && *in != 255)
 		{
-			if (value == 254)
+			if (*in == 254)
 			{
-				imgFile.read((char*)&value, 1);
-				for (int i = 0; i < value; i++)
+				// run of transparent pixels
+				if (in + 1 < end)
 				{
-					_frames[frame]->setPixelIterative(&x, &y, 0);
+					pos += in[1];
 				}
+				in += 2;
 			}
 			else
 			{
-				_frames[frame]->setPixelIterative(&x, &y, value);
+				if (pos < frameSize)
+				{
+					out[pos] = *in;
+				}
+				pos++;
+				in++;
 			}
 		}
+		// skip the end of frame marker
+		in++;
 
-		// Unlock the surface
-		_frames[frame]->unlock();
+		Surface *surface = new Surface(out, _width, _height);
+		surface->encodeRle();
+		_frames.push_back(surface);
 	}
 
-	imgFile.close();
 	offsetFile.close();
 }
 
@@ -152,54 +159,19 @@ void SurfaceSet::loadPck(const std::string &pck, const std::string &tab)
  */
 void SurfaceSet::loadDat(const std::string &filename)
 {
-	int nframes = 0;
-
-	// Load file and put pixels in surface
-	std::ifstream imgFile (filename.c_str(), std::ios::in | std::ios::binary);
-	if (!imgFile)
-	{
-		throw Exception("Failed to load DAT");
-	}
-	
-	imgFile.seekg(0, std::ios::end);
-	std::streamoff size = imgFile.tellg();
-	imgFile.seekg(0, std::ios::beg);
-
-	nframes = (int)size / (_width * _height);
+	FileData file(filename, "Failed to load DAT");
+	int frameSize = _width * _height;
+	int nframes = (int)file.getSize() / frameSize;
 
 	for (int i = 0; i < nframes; i++)
 	{
 		Surface *surface = new Surface(_width, _height);
+		surface->setMemoryTag(MEM_SPRITES);
+		surface->lock();
+		surface->setPixels(0, file.getData() + i * frameSize, frameSize);
+		surface->unlock();
 		_frames.push_back(surface);
 	}
-
-	Uint8 value;
-	int x = 0, y = 0, frame = 0;
-
-	// Lock the surface
-	_frames[frame]->lock();
-
-	while (imgFile.read((char*)&value, 1))
-	{
-		_frames[frame]->setPixelIterative(&x, &y, value);
-		
-		if (y >= _height)
-		{
-			// Unlock the surface
-			_frames[frame]->unlock();
-
-			frame++;
-			x = 0;
-			y = 0;
-
-			if (frame >= nframes)
-				break;
-			else
-				_frames[frame]->lock();
-		}
-	}
-
-	imgFile.close();
 }
 
 /**
@@ -254,4 +226,16 @@ void SurfaceSet::setPalette(SDL_Color *colors, int firstcolor, int ncolors)
 	}
 }
 
+/**
+ * Makes all of the frames take their colors from a shared palette.
+ * @param palette Pointer to the shared palette.
+ */
+void SurfaceSet::setSharedPalette(const SharedPalette *palette)
+{
+	for (std::vector<Surface*>::iterator i = _frames.begin(); i != _frames.end(); i++)
+	{
+		(*i)->setSharedPalette(palette);
+	}
+}
+
 }
@@ -27,6 +27,7 @@ namespace OpenXcom
 {
 
 class Surface;
+struct SharedPalette;
 
 /**
  * Container of a set of surfaces.
@@ -39,6 +40,8 @@ class SurfaceSet
 private:
 	int _width, _height;
 	std::vector<Surface*> _frames;
+	std::vector<Uint8*> _pixels;
+	int _memory;
 public:
 	/// Crates a surface set with frames of the specified size.
 	SurfaceSet(int width, int height);
@@ -60,6 +63,8 @@ public:
 	int getTotalFrames() const;
 	/// Sets the surface set's palette.
 	void setPalette(SDL_Color *colors, int firstcolor = 0, int ncolors = 256);
+	/// Makes all frames use a shared palette.
+	void setSharedPalette(const SharedPalette *palette);
 };
 
 }
@@ -21,6 +21,10 @@
 namespace OpenXcom
 {
 
+Uint32 Timer::_ticks = 0;
+Uint32 Timer::_nextTick = 0;
+bool Timer::_fired = false;
+
 /**
  * Initializes a new timer with a set interval.
  * @param interval Time interval in miliseconds.
@@ -79,6 +83,8 @@ bool Timer::isRunning() const
 /**
  * The timer keeps calculating the passed time while it's running,
  * calling the respective action handler whenever the set interval passes.
+ * The time is read once per game cycle by resetTicks, so checking
+ * a timer that isn't due yet costs no system call.
  * @param state State that the action handler belongs to.
  * @param surface Surface that the action handler belongs to.
  */
@@ -86,7 +92,8 @@ void Timer::think(State* state, Surface* surface)
 {
 	if (_running)
 	{
-		if (getTime() >= _interval)
+		// signed, since timers started during this cycle began after it was read
+		if ((Sint32)(_ticks - _start) >= (Sint32)_interval)
 		{
 			if (state != 0 && _state != 0)
 			{
@@ -97,6 +104,13 @@ void Timer::think(State* state, Surface* surface)
 				(surface->*_surface)();
 			}			
 			_start = SDL_GetTicks();
+			_fired = true;
+		}
+		// keep track of the earliest timer due, so the game knows how long it can sleep
+		Uint32 tick = _start + _interval;
+		if (_nextTick == 0 || tick < _nextTick)
+		{
+			_nextTick = tick;
 		}
 	}
 }
@@ -128,4 +142,35 @@ void Timer::onTimer(SurfaceHandler handler)
 	_surface = handler;
 }
 
+/**
+ * Returns the time the earliest timer advanced since
+ * the last reset is due to fire, or 0 if no timer advanced.
+ * @return Time in miliseconds, as given by SDL_GetTicks.
+ */
+Uint32 Timer::getNextTick()
+{
+	return _nextTick;
+}
+
+/**
+ * Returns if any timer called its action handler since the last reset.
+ * @return True if a timer fired.
+ */
+bool Timer::hasFired()
+{
+	return _fired;
+}
+
+/**
+ * Reads the time for all the timers to check against this game cycle,
+ * and forgets which timers advanced and fired, so the cycle
+ * can be tracked on its own.
+ */
+void Timer::resetTicks()
+{
+	_ticks = SDL_GetTicks();
+	_nextTick = 0;
+	_fired = false;
+}
+
 }
@@ -41,6 +41,8 @@ private:
 	bool _running;
 	StateHandler _state;
 	SurfaceHandler _surface;
+	static Uint32 _ticks, _nextTick;
+	static bool _fired;
 public:
 	/// Creates a stopped timer.
 	Timer(Uint32 interval);
@@ -62,6 +64,12 @@ public:
 	void onTimer(StateHandler handler);
 	/// Hooks a surface action handler to the timer interval.
 	void onTimer(SurfaceHandler handler);
+	/// Gets when the earliest of the timers that advanced next fires.
+	static Uint32 getNextTick();
+	/// Gets if any timer fired.
+	static bool hasFired();
+	/// Starts a new game cycle for the timers.
+	static void resetTicks();
 };
 
 }
@@ -120,18 +120,14 @@ void ConfirmLandingState::btnYesClick(Action *action)
 	Ufo* u = dynamic_cast<Ufo*>(_craft->getDestination());
 	if (u != 0)
 	{
-		_game->getSavedGame()->setBattleGame(new SavedBattleGame());
-
 		BattlescapeGenerator *bgen = new BattlescapeGenerator(_game);
 		bgen->setMissionType(MISS_UFORECOVERY);
 		bgen->setWorldTexture(_texture);
 		bgen->setWorldShade(_shade);
 		bgen->setCraft(_craft);
 		bgen->setUfo(u);
-		bgen->run();
-		delete bgen;
 
-		_game->pushState(new BriefingCrashState(_game, _craft));
+		_game->pushState(new BriefingCrashState(_game, _craft, bgen));
 	}
 }
 
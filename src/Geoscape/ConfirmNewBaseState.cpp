@@ -76,14 +76,11 @@ ConfirmNewBaseState::ConfirmNewBaseState(Game *game, Base *base, Globe *globe) :
 	_btnCancel->onMouseClick((ActionHandler)&ConfirmNewBaseState::btnCancelClick);
 
 	std::wstringstream ss;
-	for (std::vector<Region*>::iterator i = _game->getSavedGame()->getRegions()->begin(); i != _game->getSavedGame()->getRegions()->end(); i++)
+	Region *region = _game->getSavedGame()->locateRegion(_base->getLongitude(), _base->getLatitude());
+	if (region != 0)
 	{
-		if ((*i)->getRules()->insideRegion(_base->getLongitude(), _base->getLatitude()))
-		{
-			_cost = (*i)->getRules()->getBaseCost();
-			ss << _game->getLanguage()->getString("STR_AREA_") << L'\x01' << _game->getLanguage()->getString((*i)->getRules()->getType());
-			break;
-		}
+		_cost = region->getRules()->getBaseCost();
+		ss << _game->getLanguage()->getString("STR_AREA_") << L'\x01' << _game->getLanguage()->getString(region->getRules()->getType());
 	}
 	
 	std::wstring s = _game->getLanguage()->getString("STR_COST_");
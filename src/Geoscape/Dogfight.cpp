@@ -0,0 +1,447 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Dogfight.h"
+#include "Globe.h"
+#include "../Savegame/SavedGame.h"
+#include "../Savegame/Craft.h"
+#include "../Ruleset/RuleCraft.h"
+#include "../Savegame/CraftWeapon.h"
+#include "../Ruleset/RuleCraftWeapon.h"
+#include "../Savegame/Ufo.h"
+#include "../Engine/RNG.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Sets up a dogfight between a craft and a UFO,
+ * with the craft closing in from the same distance
+ * as in the Dogfight window.
+ * @param craft Pointer to the craft intercepting.
+ * @param ufo Pointer to the UFO being intercepted.
+ * @param globe Pointer to the Geoscape globe.
+ * @param mode Attack mode used by the craft.
+ */
+Dogfight::Dogfight(Craft *craft, Ufo *ufo, Globe *globe, DogfightMode mode) : _craft(craft), _ufo(ufo), _globe(globe), _mode(mode), _result(DOGFIGHT_DISENGAGED), _currentDist(640), _targetDist(560), _shots(0), _hits(0), _attached(false), _over(false)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		_weapons[i].reload = 0;
+		_weapons[i].elapsed = 0;
+		_weapons[i].firing = false;
+	}
+	setMode(mode);
+}
+
+/**
+ *
+ */
+Dogfight::~Dogfight()
+{
+}
+
+/**
+ * Returns the craft intercepting the UFO.
+ * @return Pointer to craft.
+ */
+Craft *Dogfight::getCraft() const
+{
+	return _craft;
+}
+
+/**
+ * Returns the UFO being intercepted.
+ * @return Pointer to UFO.
+ */
+Ufo *Dogfight::getUfo() const
+{
+	return _ufo;
+}
+
+/**
+ * Returns the attack mode the craft is using.
+ * @return Attack mode.
+ */
+DogfightMode Dogfight::getMode() const
+{
+	return _mode;
+}
+
+/**
+ * Changes the attack mode the craft is using,
+ * which sets the weapon reload times and the
+ * distance it keeps from the UFO.
+ * @param mode Attack mode.
+ */
+void Dogfight::setMode(DogfightMode mode)
+{
+	_mode = mode;
+	for (int i = 0; i < 2; i++)
+	{
+		if (i >= _craft->getRules()->getWeapons() || _craft->getWeapons()->at(i) == 0)
+			continue;
+		RuleCraftWeapon *rule = _craft->getWeapons()->at(i)->getRules();
+		switch (_mode)
+		{
+		case DOGFIGHT_CAUTIOUS:
+			_weapons[i].reload = rule->getCautiousReload() * 75;
+			break;
+		case DOGFIGHT_STANDARD:
+			_weapons[i].reload = rule->getStandardReload() * 75;
+			break;
+		case DOGFIGHT_AGGRESSIVE:
+			_weapons[i].reload = rule->getAggressiveReload() * 75;
+			break;
+		default:
+			break;
+		}
+	}
+	chooseDistance();
+}
+
+/**
+ * Returns the current distance between the craft
+ * and the UFO, in the Dogfight window's units.
+ * @return Distance.
+ */
+int Dogfight::getDistance() const
+{
+	return _currentDist;
+}
+
+/**
+ * Returns the distance travelled by each of the
+ * projectiles fired by a weapon that haven't
+ * reached the UFO yet.
+ * @param weapon Weapon slot.
+ * @return Pointer to list of distances.
+ */
+const std::vector<int> *Dogfight::getProjectiles(int weapon) const
+{
+	return &_weapons[weapon].shots;
+}
+
+/**
+ * Returns the number of shots the craft fired
+ * during the dogfight.
+ * @return Number of shots.
+ */
+int Dogfight::getShots() const
+{
+	return _shots;
+}
+
+/**
+ * Returns the number of shots that hit and
+ * damaged the UFO during the dogfight.
+ * @return Number of hits.
+ */
+int Dogfight::getHits() const
+{
+	return _hits;
+}
+
+/**
+ * Returns whether the dogfight is being shown
+ * in a window, which advances it in real time.
+ * Other dogfights are advanced by the geoscape.
+ * @return Attached to a window?
+ */
+bool Dogfight::isAttached() const
+{
+	return _attached;
+}
+
+/**
+ * Changes whether the dogfight is being shown
+ * in a window.
+ * @param attached Attached to a window?
+ */
+void Dogfight::setAttached(bool attached)
+{
+	_attached = attached;
+}
+
+/**
+ * Fires a shot from a weapon equipped on the craft.
+ * @param weapon Weapon slot.
+ */
+void Dogfight::fire(int weapon)
+{
+	CraftWeapon *w = _craft->getWeapons()->at(weapon);
+	if (w->getAmmo() == 0)
+		return;
+	_weapons[weapon].shots.push_back(8);
+	w->setAmmo(w->getAmmo() - 1);
+	_shots++;
+}
+
+/**
+ * Picks the distance the craft keeps from the UFO
+ * with the weapons that still have ammo, depending
+ * on the attack mode.
+ */
+void Dogfight::chooseDistance()
+{
+	if (_mode == DOGFIGHT_STANDOFF)
+	{
+		_targetDist = 560;
+		return;
+	}
+	else if (_mode == DOGFIGHT_AGGRESSIVE)
+	{
+		_targetDist = 64;
+		return;
+	}
+	else if (_mode == DOGFIGHT_DISENGAGE)
+	{
+		_targetDist = 800;
+		return;
+	}
+	int range = (_mode == DOGFIGHT_CAUTIOUS) ? 0 : 1000;
+	for (std::vector<CraftWeapon*>::iterator i = _craft->getWeapons()->begin(); i < _craft->getWeapons()->end(); i++)
+	{
+		if (*i == 0 || (*i)->getAmmo() == 0)
+			continue;
+		int r = (*i)->getRules()->getRange();
+		if ((_mode == DOGFIGHT_CAUTIOUS && r > range) || (_mode == DOGFIGHT_STANDARD && r < range))
+		{
+			range = r;
+		}
+	}
+	if (range == 0 || range == 1000)
+	{
+		_targetDist = 560;
+	}
+	else
+	{
+		_targetDist = range * 8;
+	}
+}
+
+/**
+ * Ends the dogfight with the UFO shot down, and
+ * works out if it left a crash site behind.
+ */
+void Dogfight::crash()
+{
+	if (_ufo->isDestroyed() || !_globe->insideLand(_ufo->getLongitude(), _ufo->getLatitude()))
+	{
+		_result = DOGFIGHT_DESTROYED;
+	}
+	else
+	{
+		_ufo->setHoursCrashed(24 + RNG::generate(0, 72));
+		_result = DOGFIGHT_CRASHED;
+	}
+	_ufo->setSpeed(0);
+	for (int i = 0; i < 2; i++)
+	{
+		_weapons[i].shots.clear();
+		_weapons[i].firing = false;
+	}
+	_over = true;
+}
+
+/**
+ * Runs a single step of the dogfight, as long as
+ * the Dogfight window's movement timer: moves the
+ * craft, fires the weapons and checks for hits.
+ * A dogfight nobody is watching disengages once
+ * the craft has nothing left to shoot with.
+ */
+void Dogfight::step()
+{
+	if (_over)
+		return;
+	// The craft was called off or someone else got there first
+	if (_craft->getDestination() != _ufo || _ufo->isCrashed())
+	{
+		_over = true;
+		return;
+	}
+
+	if (_currentDist < _targetDist)
+	{
+		_currentDist += 4;
+	}
+	else if (_currentDist > _targetDist)
+	{
+		_currentDist -= 2;
+	}
+
+	bool armed = false;
+	for (int i = 0; i < _craft->getRules()->getWeapons() && i < 2; i++)
+	{
+		CraftWeapon *w = _craft->getWeapons()->at(i);
+		if (w == 0)
+			continue;
+		WeaponState *state = &_weapons[i];
+
+		for (std::vector<int>::iterator d = state->shots.begin(); d != state->shots.end();)
+		{
+			(*d) += 8;
+			if ((*d) >= _currentDist)
+			{
+				int acc = RNG::generate(1, 100);
+				if (acc <= w->getRules()->getAccuracy() && !_ufo->isCrashed())
+				{
+					int damage = RNG::generate(w->getRules()->getDamage() / 2, w->getRules()->getDamage());
+					_ufo->setDamage(_ufo->getDamage() + damage);
+					_hits++;
+				}
+				d = state->shots.erase(d);
+			}
+			else
+			{
+				d++;
+			}
+		}
+		if (_ufo->isCrashed())
+		{
+			crash();
+			return;
+		}
+
+		bool canFire = _currentDist <= w->getRules()->getRange() * 8 && w->getAmmo() > 0 && _mode != DOGFIGHT_STANDOFF && _mode != DOGFIGHT_DISENGAGE;
+		if (!state->firing && canFire)
+		{
+			state->firing = true;
+			state->elapsed = 0;
+			fire(i);
+		}
+		else if (state->firing && !canFire)
+		{
+			state->firing = false;
+			if (w->getAmmo() == 0 && (_mode == DOGFIGHT_CAUTIOUS || _mode == DOGFIGHT_STANDARD))
+			{
+				chooseDistance();
+			}
+		}
+		else if (state->firing)
+		{
+			state->elapsed += DOGFIGHT_TICK;
+			if (state->elapsed >= state->reload)
+			{
+				state->elapsed = 0;
+				fire(i);
+			}
+		}
+
+		if (w->getAmmo() > 0 || !state->shots.empty())
+		{
+			armed = true;
+		}
+	}
+
+	if (_mode == DOGFIGHT_DISENGAGE && _currentDist > 640)
+	{
+		_over = true;
+	}
+	else if (!armed && !_attached && _mode != DOGFIGHT_DISENGAGE)
+	{
+		setMode(DOGFIGHT_DISENGAGE);
+	}
+}
+
+/**
+ * Runs several steps of the dogfight, stopping
+ * early if it's over.
+ * @param steps Number of steps.
+ */
+void Dogfight::advance(int steps)
+{
+	for (int i = 0; i < steps && !_over; i++)
+	{
+		step();
+	}
+}
+
+/**
+ * Returns whether the dogfight is over, because
+ * the UFO was shot down or the craft got away.
+ * @return Is it over?
+ */
+bool Dogfight::isOver() const
+{
+	return _over;
+}
+
+/**
+ * Returns how the dogfight ended.
+ * @return Dogfight result.
+ */
+DogfightResult Dogfight::getResult() const
+{
+	return _result;
+}
+
+/**
+ * Sends the craft back to base once the dogfight
+ * is over, unless the UFO was brought down by
+ * someone else and the craft can still go for it.
+ * A destroyed UFO has to be removed by the caller,
+ * after dropping any other dogfights against it.
+ * @return How the dogfight ended.
+ */
+DogfightResult Dogfight::finish()
+{
+	if (!(_ufo->isCrashed() && _result == DOGFIGHT_DISENGAGED && _craft->getDestination() == _ufo))
+	{
+		_craft->returnToBase();
+	}
+	return _result;
+}
+
+/**
+ * Sends any other craft following a UFO back
+ * to base and removes the UFO from the game,
+ * once it's destroyed or sunk.
+ * @param save Pointer to the saved game.
+ * @param ufo Pointer to the UFO.
+ */
+void Dogfight::removeUfo(SavedGame *save, Ufo *ufo)
+{
+	// Disengage any other craft
+	while (ufo->getFollowers()->size() > 0)
+	{
+		for (std::vector<Target*>::iterator i = ufo->getFollowers()->begin(); i != ufo->getFollowers()->end(); i++)
+		{
+			Craft *c = dynamic_cast<Craft*>(*i);
+			if (c)
+			{
+				c->returnToBase();
+				break;
+			}
+		}
+	}
+
+	// Clear UFO
+	for (std::vector<Ufo*>::iterator i = save->getUfos()->begin(); i != save->getUfos()->end(); i++)
+	{
+		if (*i == ufo)
+		{
+			delete *i;
+			save->getUfos()->erase(i);
+			break;
+		}
+	}
+}
+
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_DOGFIGHT_H
+#define OPENXCOM_DOGFIGHT_H
+
+#include <vector>
+
+#define DOGFIGHT_TICK 20
+#define DOGFIGHT_STEPS 250
+
+namespace OpenXcom
+{
+
+class Globe;
+class Craft;
+class Ufo;
+class SavedGame;
+
+/// Attack modes a craft can use against a UFO.
+enum DogfightMode { DOGFIGHT_STANDOFF, DOGFIGHT_CAUTIOUS, DOGFIGHT_STANDARD, DOGFIGHT_AGGRESSIVE, DOGFIGHT_DISENGAGE };
+
+/// Ways a dogfight can end.
+enum DogfightResult { DOGFIGHT_DISENGAGED, DOGFIGHT_CRASHED, DOGFIGHT_DESTROYED };
+
+/**
+ * The simulation of a dogfight between a player craft and
+ * a UFO, following the distance, range, reload and damage
+ * rules of the original interceptions. It's advanced in steps
+ * of the Dogfight window's movement timer, either by a window
+ * showing it or by the geoscape clock, so several of them can
+ * run at once without anything on screen.
+ */
+class Dogfight
+{
+private:
+	Craft *_craft;
+	Ufo *_ufo;
+	Globe *_globe;
+	DogfightMode _mode;
+	DogfightResult _result;
+	int _currentDist, _targetDist, _shots, _hits;
+	bool _attached, _over;
+	/// Projectiles in flight and time since the last shot of a weapon.
+	struct WeaponState
+	{
+		std::vector<int> shots;
+		int reload, elapsed;
+		bool firing;
+	};
+	WeaponState _weapons[2];
+	void fire(int weapon);
+	void chooseDistance();
+	void crash();
+public:
+	/// Creates a new dogfight.
+	Dogfight(Craft *craft, Ufo *ufo, Globe *globe, DogfightMode mode);
+	/// Cleans up the dogfight.
+	~Dogfight();
+	/// Gets the craft intercepting.
+	Craft *getCraft() const;
+	/// Gets the UFO being intercepted.
+	Ufo *getUfo() const;
+	/// Gets the attack mode.
+	DogfightMode getMode() const;
+	/// Sets the attack mode.
+	void setMode(DogfightMode mode);
+	/// Gets the distance between the craft and the UFO.
+	int getDistance() const;
+	/// Gets the projectiles in flight from a weapon.
+	const std::vector<int> *getProjectiles(int weapon) const;
+	/// Gets the number of shots fired.
+	int getShots() const;
+	/// Gets the number of shots that hit the UFO.
+	int getHits() const;
+	/// Checks if the dogfight is shown in a window.
+	bool isAttached() const;
+	/// Sets if the dogfight is shown in a window.
+	void setAttached(bool attached);
+	/// Runs a step of the dogfight.
+	void step();
+	/// Runs several steps of the dogfight.
+	void advance(int steps);
+	/// Checks if the dogfight is over.
+	bool isOver() const;
+	/// Gets how the dogfight ended.
+	DogfightResult getResult() const;
+	/// Sends the craft home after the dogfight.
+	DogfightResult finish();
+	/// Removes a UFO shot down for good from the game.
+	static void removeUfo(SavedGame *save, Ufo *ufo);
+};
+
+}
+
+#endif
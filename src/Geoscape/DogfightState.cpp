@@ -29,7 +29,7 @@
 #include "../Interface/ImageButton.h"
 #include "../Interface/Text.h"
 #include "../Engine/Timer.h"
-#include "Globe.h"
+#include "Dogfight.h"
 #include "../Savegame/SavedGame.h"
 #include "../Savegame/Craft.h"
 #include "../Ruleset/RuleCraft.h"
@@ -48,11 +48,9 @@ namespace OpenXcom
 /**
  * Initializes all the elements in the Dogfight window.
  * @param game Pointer to the core game.
- * @param globe Pointer to the Geoscape globe.
- * @param craft Pointer to the craft intercepting.
- * @param ufo Pointer to the UFO being intercepted.
+ * @param dogfight Pointer to the dogfight to show.
  */
-DogfightState::DogfightState(Game *game, Globe *globe, Craft *craft, Ufo *ufo) : State(game), _globe(globe), _craft(craft), _ufo(ufo), _timeout(50), _currentDist(640), _targetDist(560), _w1Dist(), _w2Dist(), _end(false), _destroy(false)
+DogfightState::DogfightState(Game *game, Dogfight *dogfight) : State(game), _dogfight(dogfight), _craft(dogfight->getCraft()), _ufo(dogfight->getUfo()), _timeout(50), _end(false)
 {
 	_targetRadius = _currentRadius = _ufo->getRules()->getRadius();
 	
@@ -80,9 +78,7 @@ DogfightState::DogfightState(Game *game, Globe *globe, Craft *craft, Ufo *ufo) :
 	_txtStatus = new Text(150, 9, 84, 137);
 
 	_animTimer = new Timer(30);
-	_moveTimer = new Timer(20);
-	_w1Timer = new Timer(0);
-	_w2Timer = new Timer(0);
+	_moveTimer = new Timer(DOGFIGHT_TICK);
 	_mode = _btnStandoff;
 
 	add(_window);
@@ -270,10 +266,6 @@ DogfightState::DogfightState(Game *game, Globe *globe, Craft *craft, Ufo *ufo) :
 	_moveTimer->onTimer((StateHandler)&DogfightState::move);
 	_moveTimer->start();
 
-	_w1Timer->onTimer((StateHandler)&DogfightState::fireWeapon1);
-
-	_w2Timer->onTimer((StateHandler)&DogfightState::fireWeapon2);
-
 	// Set music
 	_game->getResourcePack()->getMusic("GMINTER")->play();
 }
@@ -285,8 +277,15 @@ DogfightState::~DogfightState()
 {
 	delete _animTimer;
 	delete _moveTimer;
-	delete _w1Timer;
-	delete _w2Timer;
+}
+
+/**
+ * Returns the dogfight this window shows.
+ * @return Pointer to the dogfight.
+ */
+Dogfight *DogfightState::getDogfight() const
+{
+	return _dogfight;
 }
 
 /**
@@ -296,8 +295,20 @@ void DogfightState::think()
 {
 	_animTimer->think(this, 0);
 	_moveTimer->think(this, 0);
-	_w1Timer->think(this, 0);
-	_w2Timer->think(this, 0);
+}
+
+/**
+ * Shows the dogfight in this window from now on,
+ * starting with the craft standing off.
+ */
+void DogfightState::init()
+{
+	State::init();
+	if (!_dogfight->isAttached())
+	{
+		_dogfight->setAttached(true);
+		_dogfight->setMode(DOGFIGHT_STANDOFF);
+	}
 }
 
 /**
@@ -326,95 +337,48 @@ void DogfightState::animate()
 }
 
 /**
- * Moves the craft towards the UFO according to
- * the current interception mode.
+ * Advances the dogfight by a step and shows
+ * what happened in it.
  */
 void DogfightState::move()
 {
-	// Update distance
-	if (_currentDist < _targetDist)
-	{
-		_currentDist += 4;
-	}
-	else if (_currentDist > _targetDist)
+	int ammo[2] = {0, 0};
+	for (int i = 0; i < _craft->getRules()->getWeapons() && i < 2; i++)
 	{
-		_currentDist -= 2;
+		CraftWeapon *w = _craft->getWeapons()->at(i);
+		if (w != 0)
+			ammo[i] = w->getAmmo();
 	}
+	int hits = _dogfight->getHits();
+
+	_dogfight->step();
+
 	std::wstringstream ss;
-	ss << _currentDist;
+	ss << _dogfight->getDistance();
 	_txtDistance->setText(ss.str());
 
-	for (int i = 0; i < _craft->getRules()->getWeapons(); i++)
+	for (int i = 0; i < _craft->getRules()->getWeapons() && i < 2; i++)
 	{
 		CraftWeapon *w = _craft->getWeapons()->at(i);
-		if (w == 0)
+		if (w == 0 || w->getAmmo() == ammo[i])
 			continue;
-		std::vector<int> *wDist = 0;
-		Timer *wTimer = 0;
+		std::wstringstream ss2;
+		ss2 << w->getAmmo();
 		if (i == 0)
 		{
-			wDist = &_w1Dist;
-			wTimer = _w1Timer;
+			_txtAmmo1->setText(ss2.str());
 		}
 		else
 		{
-			wDist = &_w2Dist;
-			wTimer = _w2Timer;
-		}
-
-		for (std::vector<int>::iterator d = wDist->begin(); d != wDist->end();)
-		{
-			// Update weapons
-			(*d) += 8;
-
-			// Handle weapon damage
-			if ((*d) >= _currentDist)
-			{
-				int acc = RNG::generate(1, 100);
-				if (acc <= w->getRules()->getAccuracy() && !_ufo->isCrashed())
-				{
-					int damage = RNG::generate(w->getRules()->getDamage() / 2, w->getRules()->getDamage());
-					_ufo->setDamage(_ufo->getDamage() + damage);
-					setStatus("STR_UFO_HIT");
-					_currentRadius += 4;
-					_game->getResourcePack()->getSoundSet("GEO.CAT")->getSound(12)->play();
-				}
-				d = wDist->erase(d);
-			}
-			else
-			{
-				d++;
-			}
-		}
-
-		// Handle weapon firing
-		if (!wTimer->isRunning() && _currentDist <= w->getRules()->getRange() * 8 && w->getAmmo() > 0 && _mode != _btnStandoff && _mode != _btnDisengage && !_ufo->isCrashed())
-		{
-			wTimer->start();
-			if (i == 0)
-			{
-				fireWeapon1();
-			}
-			else
-			{
-				fireWeapon2();
-			}
-		}
-		else if (wTimer->isRunning() && (_currentDist > w->getRules()->getRange() * 8 || w->getAmmo() == 0 || _mode == _btnStandoff || _mode == _btnDisengage || _ufo->isCrashed()))
-		{
-			wTimer->stop();
-			if (w->getAmmo() == 0)
-			{
-				if (_mode == _btnCautious)
-				{
-					minimumDistance();
-				}
-				else if (_mode == _btnStandard)
-				{
-					maximumDistance();
-				}
-			}
+			_txtAmmo2->setText(ss2.str());
 		}
+		_game->getResourcePack()->getSoundSet("GEO.CAT")->getSound(w->getRules()->getSound())->play();
+	}
+	if (_dogfight->getHits() != hits)
+	{
+		setStatus("STR_UFO_HIT");
+		_currentRadius += 4;
+		_game->getResourcePack()->getSoundSet("GEO.CAT")->getSound(12)->play();
 	}
 
 	_battle->clear();
@@ -428,26 +392,16 @@ void DogfightState::move()
 	{
 		for (int r = _currentRadius; r >= 0; r--)
 		{
-			_battle->drawCircle(_battle->getWidth() / 2, _battle->getHeight() - _currentDist / 8, r, Palette::blockOffset(7) + 4 + r);
+			_battle->drawCircle(_battle->getWidth() / 2, _battle->getHeight() - _dogfight->getDistance() / 8, r, Palette::blockOffset(7) + 4 + r);
 		}
 	}
 
 	// Draw weapon shots
-	for (int i = 0; i < _craft->getRules()->getWeapons(); i++)
+	for (int i = 0; i < _craft->getRules()->getWeapons() && i < 2; i++)
 	{
-		std::vector<int> *wDist = 0;
-		int off = 0;
-		if (i == 0)
-		{
-			wDist = &_w1Dist;
-			off = -1;
-		}
-		else
-		{
-			wDist = &_w2Dist;
-			off = 1;
-		}
-		for (std::vector<int>::iterator d = wDist->begin(); d != wDist->end(); d++)
+		const std::vector<int> *wDist = _dogfight->getProjectiles(i);
+		int off = (i == 0) ? -1 : 1;
+		for (std::vector<int>::const_iterator d = wDist->begin(); d != wDist->end(); d++)
 		{
 			for (int j = -2; j <= 0; j++)
 			{
@@ -456,150 +410,27 @@ void DogfightState::move()
 		}
 	}
 
-	// Check when battle is over
-	if ((_currentDist > 640 && _mode == _btnDisengage) || (_timeout == 0 && _ufo->isCrashed()))
-	{
-		_craft->returnToBase();
-		if (_destroy)
-		{
-			// Disengage any other craft
-			while (_ufo->getFollowers()->size() > 0)
-			{
-				for (std::vector<Target*>::iterator i = _ufo->getFollowers()->begin(); i != _ufo->getFollowers()->end(); i++)
-				{
-					Craft *c = dynamic_cast<Craft*>(*i);
-					if (c)
-					{
-						c->returnToBase();
-						break;
-					}
-				}
-			}
-			
-			// Clear UFO
-			for (std::vector<Ufo*>::iterator i = _game->getSavedGame()->getUfos()->begin(); i != _game->getSavedGame()->getUfos()->end(); i++)
-			{
-				if (*i == _ufo)
-				{
-					delete *i;
-					_game->getSavedGame()->getUfos()->erase(i);
-					break;
-				}
-			}
-		}
-		_game->popState();
-	}
-
-	if (!_end && _ufo->isCrashed())
+	if (!_end && _dogfight->isOver() && _dogfight->getResult() != DOGFIGHT_DISENGAGED)
 	{
 		if (_ufo->isDestroyed())
 		{
 			setStatus("STR_UFO_DESTROYED");
 			_game->getResourcePack()->getSoundSet("GEO.CAT")->getSound(11)->play();
-			_destroy = true;
 		}
 		else
 		{
 			setStatus("STR_UFO_CRASH_LANDS");
 			_game->getResourcePack()->getSoundSet("GEO.CAT")->getSound(10)->play();
-			if (!_globe->insideLand(_ufo->getLongitude(), _ufo->getLatitude()))
-			{
-				_destroy = true;
-			}
-			else
-			{
-				_ufo->setHoursCrashed(24 + RNG::generate(0, 72));
-			}
 		}
 		_targetRadius = 0;
 		_end = true;
-		_ufo->setSpeed(0);
 	}
-}
-
-/**
- * Fires a shot from the first weapon
- * equipped on the craft.
- */
-void DogfightState::fireWeapon1()
-{
-	_w1Dist.push_back(8);
-	CraftWeapon *w1 = _craft->getWeapons()->at(0);
-	w1->setAmmo(w1->getAmmo() - 1);
-
-	std::wstringstream ss;
-	ss << w1->getAmmo();
-	_txtAmmo1->setText(ss.str());
-
-	_game->getResourcePack()->getSoundSet("GEO.CAT")->getSound(w1->getRules()->getSound())->play();
-}
-
-/**
- * Fires a shot from the second weapon
- * equipped on the craft.
- */
-void DogfightState::fireWeapon2()
-{
-	_w2Dist.push_back(8);
-	CraftWeapon *w2= _craft->getWeapons()->at(1);
-	w2->setAmmo(w2->getAmmo() - 1);
-
-	std::wstringstream ss;
-	ss << w2->getAmmo();
-	_txtAmmo2->setText(ss.str());
-
-	_game->getResourcePack()->getSoundSet("GEO.CAT")->getSound(w2->getRules()->getSound())->play();
-}
 
-/**
- * Sets the craft to the minimum distance
- * required to fire a weapon.
- */
-void DogfightState::minimumDistance()
-{
-	int max = 0;
-	for (std::vector<CraftWeapon*>::iterator i = _craft->getWeapons()->begin(); i < _craft->getWeapons()->end(); i++)
+	// Check when battle is over, the geoscape takes it from there
+	if (_dogfight->isOver() && (!_end || _timeout == 0))
 	{
-		if (*i == 0)
-			continue;
-		if ((*i)->getRules()->getRange() > max && (*i)->getAmmo() > 0)
-		{
-			max = (*i)->getRules()->getRange();
-		}
-	}
-	if (max == 0)
-	{
-		_targetDist = 560;
-	}
-	else
-	{
-		_targetDist = max * 8;
-	}
-}
-
-/**
- * Sets the craft to the maximum distance
- * required to fire a weapon.
- */
-void DogfightState::maximumDistance()
-{
-	int min = 1000;
-	for (std::vector<CraftWeapon*>::iterator i = _craft->getWeapons()->begin(); i < _craft->getWeapons()->end(); i++)
-	{
-		if (*i == 0)
-			continue;
-		if ((*i)->getRules()->getRange() < min && (*i)->getAmmo() > 0)
-		{
-			min = (*i)->getRules()->getRange();
-		}
-	}
-	if (min == 1000)
-	{
-		_targetDist = 560;
-	}
-	else
-	{
-		_targetDist = min * 8;
+		_dogfight->setAttached(false);
+		_game->popState();
 	}
 }
 
@@ -631,7 +462,7 @@ void DogfightState::btnStandoffClick(Action *action)
 	if (!_ufo->isCrashed())
 	{
 		setStatus("STR_STANDOFF");
-		_targetDist = 560;
+		_dogfight->setMode(DOGFIGHT_STANDOFF);
 	}
 }
 
@@ -644,15 +475,7 @@ void DogfightState::btnCautiousClick(Action *action)
 	if (!_ufo->isCrashed())
 	{
 		setStatus("STR_CAUTIOUS_ATTACK");
-		if (_craft->getNumWeapons() > 0 && _craft->getWeapons()->at(0) != 0)
-		{
-			_w1Timer->setInterval(_craft->getWeapons()->at(0)->getRules()->getCautiousReload() * 75);
-		}
-		if (_craft->getNumWeapons() > 1 && _craft->getWeapons()->at(1) != 0)
-		{
-			_w2Timer->setInterval(_craft->getWeapons()->at(1)->getRules()->getCautiousReload() * 75);
-		}
-		minimumDistance();
+		_dogfight->setMode(DOGFIGHT_CAUTIOUS);
 	}
 }
 
@@ -665,15 +488,7 @@ void DogfightState::btnStandardClick(Action *action)
 	if (!_ufo->isCrashed())
 	{
 		setStatus("STR_STANDARD_ATTACK");
-		if (_craft->getNumWeapons() > 0 && _craft->getWeapons()->at(0) != 0)
-		{
-			_w1Timer->setInterval(_craft->getWeapons()->at(0)->getRules()->getStandardReload() * 75);
-		}
-		if (_craft->getNumWeapons() > 1 && _craft->getWeapons()->at(1) != 0)
-		{
-			_w2Timer->setInterval(_craft->getWeapons()->at(1)->getRules()->getStandardReload() * 75);
-		}
-		maximumDistance();
+		_dogfight->setMode(DOGFIGHT_STANDARD);
 	}
 }
 
@@ -686,15 +501,7 @@ void DogfightState::btnAggressiveClick(Action *action)
 	if (!_ufo->isCrashed())
 	{
 		setStatus("STR_AGGRESSIVE_ATTACK");
-		if (_craft->getNumWeapons() > 0 && _craft->getWeapons()->at(0) != 0)
-		{
-			_w1Timer->setInterval(_craft->getWeapons()->at(0)->getRules()->getAggressiveReload() * 75);
-		}
-		if (_craft->getNumWeapons() > 1 && _craft->getWeapons()->at(1) != 0)
-		{
-			_w2Timer->setInterval(_craft->getWeapons()->at(1)->getRules()->getAggressiveReload() * 75);
-		}
-		_targetDist = 64;
+		_dogfight->setMode(DOGFIGHT_AGGRESSIVE);
 	}
 }
 
@@ -707,7 +514,7 @@ void DogfightState::btnDisengageClick(Action *action)
 	if (!_ufo->isCrashed())
 	{
 		setStatus("STR_DISENGAGING");
-		_targetDist = 800;
+		_dogfight->setMode(DOGFIGHT_DISENGAGE);
 	}
 }
 
@@ -31,9 +31,9 @@ class Text;
 class Surface;
 class InteractiveSurface;
 class Timer;
-class Globe;
 class Craft;
 class Ufo;
+class Dogfight;
 
 /**
  * Shows a dogfight (interception) between a
@@ -42,37 +42,32 @@ class Ufo;
 class DogfightState : public State
 {
 private:
-	Timer *_animTimer, *_moveTimer, *_w1Timer, *_w2Timer;
+	Timer *_animTimer, *_moveTimer;
 	Surface *_window, *_battle, *_weapon1, *_range1, *_weapon2, *_range2, *_damage;
 	InteractiveSurface *_btnMinimize, *_preview;
 	ImageButton *_btnStandoff, *_btnCautious, *_btnStandard, *_btnAggressive, *_btnDisengage, *_btnUfo;
 	ImageButton *_mode;
 	Text *_txtAmmo1, *_txtAmmo2, *_txtDistance, *_txtStatus;
-	Globe *_globe;
+	Dogfight *_dogfight;
 	Craft *_craft;
 	Ufo *_ufo;
-	int _timeout, _currentDist, _targetDist, _currentRadius, _targetRadius;
-	std::vector<int> _w1Dist, _w2Dist;
-	bool _end, _destroy;
+	int _timeout, _currentRadius, _targetRadius;
+	bool _end;
 public:
 	/// Creates the Dogfight state.
-	DogfightState(Game *game, Globe *globe, Craft *craft, Ufo *ufo);
+	DogfightState(Game *game, Dogfight *dogfight);
 	/// Cleans up the Dogfight state.
 	~DogfightState();
+	/// Gets the dogfight shown.
+	Dogfight *getDogfight() const;
 	/// Runs the timers.
 	void think();
+	/// Attaches the dogfight to the window.
+	void init();
 	/// Animates the window.
 	void animate();
-	/// Moves the craft.
+	/// Advances the dogfight.
 	void move();
-	// Fires the first weapon.
-	void fireWeapon1();
-	// Fires the second weapon.
-	void fireWeapon2();
-	// Sets the craft to minimum distance.
-	void minimumDistance();
-	// Sets the craft to maximum distance.
-	void maximumDistance();
 	/// Changes the status text.
 	void setStatus(std::string status);
 	/// Handler for clicking the Minimize button.
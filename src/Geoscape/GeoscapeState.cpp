@@ -21,6 +21,7 @@
 #include <cmath>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include "../Engine/RNG.h"
 #include "../Engine/Game.h"
 #include "../Engine/Action.h"
@@ -46,7 +47,7 @@
 #include "../Savegame/Ufo.h"
 #include "../Ruleset/RuleUfo.h"
 #include "../Savegame/Waypoint.h"
-#include "../Savegame/Transfer.h"
+#include "../Savegame/AlienSchedule.h"
 #include "OptionsState.h"
 #include "InterceptState.h"
 #include "../Basescape/BasescapeState.h"
@@ -57,6 +58,7 @@
 #include "UfoDetectedState.h"
 #include "GeoscapeCraftState.h"
 #include "DogfightState.h"
+#include "Dogfight.h"
 #include "UfoLostState.h"
 #include "CraftPatrolState.h"
 #include "LowFuelState.h"
@@ -75,7 +77,7 @@ namespace OpenXcom
  * Initializes all the elements in the Geoscape screen.
  * @param game Pointer to the core game.
  */
-GeoscapeState::GeoscapeState(Game *game) : State(game), _pause(false), _music(false), _popups()
+GeoscapeState::GeoscapeState(Game *game) : State(game), _pause(false), _music(false), _autoDogfight(false), _stepsLeft(0), _shownSecond(-1), _shownMinute(-1), _shownHour(-1), _shownWeekday(-1), _shownDay(-1), _shownMonth(-1), _shownYear(-1), _popups(), _dogfights()
 {
 	// Create objects
 	_bg = new Surface(320, 200, 0, 0);
@@ -114,6 +116,7 @@ GeoscapeState::GeoscapeState(Game *game) : State(game), _pause(false), _music(fa
 
 	_timeSpeed = _btn5Secs;
 	_timer = new Timer(100);
+	_simTimer = new Timer(0);
 
 	// Set palette
 	_game->setPalette(_game->getResourcePack()->getPalette("PALETTES.DAT_0")->getColors());
@@ -206,26 +209,32 @@ GeoscapeState::GeoscapeState(Game *game) : State(game), _pause(false), _music(fa
 	_btn5Secs->copy(_bg);
 	_btn5Secs->setColor(Palette::blockOffset(15)+8);
 	_btn5Secs->setGroup(&_timeSpeed);
+	_btn5Secs->onMouseClick((ActionHandler)&GeoscapeState::btnTimeSpeedClick);
 
 	_btn1Min->copy(_bg);
 	_btn1Min->setColor(Palette::blockOffset(15)+8);
 	_btn1Min->setGroup(&_timeSpeed);
+	_btn1Min->onMouseClick((ActionHandler)&GeoscapeState::btnTimeSpeedClick);
 
 	_btn5Mins->copy(_bg);
 	_btn5Mins->setColor(Palette::blockOffset(15)+8);
 	_btn5Mins->setGroup(&_timeSpeed);
+	_btn5Mins->onMouseClick((ActionHandler)&GeoscapeState::btnTimeSpeedClick);
 
 	_btn30Mins->copy(_bg);
 	_btn30Mins->setColor(Palette::blockOffset(15)+8);
 	_btn30Mins->setGroup(&_timeSpeed);
+	_btn30Mins->onMouseClick((ActionHandler)&GeoscapeState::btnTimeSpeedClick);
 
 	_btn1Hour->copy(_bg);
 	_btn1Hour->setColor(Palette::blockOffset(15)+8);
 	_btn1Hour->setGroup(&_timeSpeed);
+	_btn1Hour->onMouseClick((ActionHandler)&GeoscapeState::btnTimeSpeedClick);
 
 	_btn1Day->copy(_bg);
 	_btn1Day->setColor(Palette::blockOffset(15)+8);
 	_btn1Day->setGroup(&_timeSpeed);
+	_btn1Day->onMouseClick((ActionHandler)&GeoscapeState::btnTimeSpeedClick);
 	
 	_btnRotateLeft->onMousePress((ActionHandler)&GeoscapeState::btnRotateLeftPress);
 	_btnRotateLeft->onMouseRelease((ActionHandler)&GeoscapeState::btnRotateLeftRelease);
@@ -287,6 +296,8 @@ GeoscapeState::GeoscapeState(Game *game) : State(game), _pause(false), _music(fa
 	_timer->onTimer((StateHandler)&GeoscapeState::timeAdvance);
 	_timer->start();
 
+	_simTimer->onTimer((StateHandler)&GeoscapeState::simulate);
+
 	timeDisplay();
 }
 
@@ -296,6 +307,11 @@ GeoscapeState::GeoscapeState(Game *game) : State(game), _pause(false), _music(fa
 GeoscapeState::~GeoscapeState()
 {
 	delete _timer;
+	delete _simTimer;
+	for (std::vector<Dogfight*>::iterator i = _dogfights.begin(); i != _dogfights.end(); i++)
+	{
+		delete *i;
+	}
 }
 
 /**
@@ -307,6 +323,10 @@ void GeoscapeState::init()
 	// Set palette
 	_game->setPalette(_game->getResourcePack()->getPalette("PALETTES.DAT_0")->getColors());
 
+	// the language might have changed on another screen
+	_shownWeekday = -1;
+	_shownDay = -1;
+	_shownMonth = -1;
 	timeDisplay();
 
 	_globe->onMouseClick((ActionHandler)&GeoscapeState::globeClick);
@@ -317,7 +337,7 @@ void GeoscapeState::init()
 	if (!_music)
 	{
 		std::stringstream ss;
-		ss << "GMGEO" << RNG::generate(1, 2);
+		ss << "GMGEO" << RNG::generate(1, 2, RNG_COSMETIC);
 		_game->getResourcePack()->getMusic(ss.str())->play();
 		_music = true;
 	}
@@ -334,6 +354,7 @@ void GeoscapeState::think()
 	{
 		// Handle timers
 		_timer->think(this, 0);
+		_simTimer->think(this, 0);
 	}
 	else
 	{
@@ -348,30 +369,65 @@ void GeoscapeState::think()
 /**
  * Updates the Geoscape clock with the latest
  * game time and date in human-readable format.
+ * Only the parts of the clock that changed since
+ * they were last shown are written out again,
+ * which is mostly just the seconds.
  */
 void GeoscapeState::timeDisplay()
 {
-	std::stringstream ss, ss2;
-	std::wstringstream ss3, ss4, ss5;
-	
-	ss << std::setfill('0') << std::setw(2) << _game->getSavedGame()->getTime()->getSecond();
-	_txtSec->setText(Language::utf8ToWstr(ss.str()));
+	GameTime *time = _game->getSavedGame()->getTime();
 
-	ss2 << std::setfill('0') << std::setw(2) << _game->getSavedGame()->getTime()->getMinute();
-	_txtMin->setText(Language::utf8ToWstr(ss2.str()));
+	if (time->getSecond() != _shownSecond)
+	{
+		std::wstringstream ss;
+		ss << std::setfill(L'0') << std::setw(2) << time->getSecond();
+		_txtSec->setText(ss.str());
+		_shownSecond = time->getSecond();
+	}
 
-	ss3 << _game->getSavedGame()->getTime()->getHour();
-	_txtHour->setText(ss3.str());
+	if (time->getMinute() != _shownMinute)
+	{
+		std::wstringstream ss;
+		ss << std::setfill(L'0') << std::setw(2) << time->getMinute();
+		_txtMin->setText(ss.str());
+		_shownMinute = time->getMinute();
+	}
 
-	ss4 << _game->getSavedGame()->getTime()->getDay() << _game->getLanguage()->getString(_game->getSavedGame()->getTime()->getDayString());
-	_txtDay->setText(ss4.str());
+	if (time->getHour() != _shownHour)
+	{
+		std::wstringstream ss;
+		ss << time->getHour();
+		_txtHour->setText(ss.str());
+		_shownHour = time->getHour();
+	}
 
-	_txtWeekday->setText(_game->getLanguage()->getString(_game->getSavedGame()->getTime()->getWeekdayString()));
+	if (time->getDay() != _shownDay)
+	{
+		std::wstringstream ss;
+		ss << time->getDay() << _game->getLanguage()->getString(time->getDayString());
+		_txtDay->setText(ss.str());
+		_shownDay = time->getDay();
+	}
 
-	_txtMonth->setText(_game->getLanguage()->getString(_game->getSavedGame()->getTime()->getMonthString()));
+	if (time->getWeekday() != _shownWeekday)
+	{
+		_txtWeekday->setText(_game->getLanguage()->getString(time->getWeekdayString()));
+		_shownWeekday = time->getWeekday();
+	}
+
+	if (time->getMonth() != _shownMonth)
+	{
+		_txtMonth->setText(_game->getLanguage()->getString(time->getMonthString()));
+		_shownMonth = time->getMonth();
+	}
 
-	ss5 << _game->getSavedGame()->getTime()->getYear();
-	_txtYear->setText(ss5.str());
+	if (time->getYear() != _shownYear)
+	{
+		std::wstringstream ss;
+		ss << time->getYear();
+		_txtYear->setText(ss.str());
+		_shownYear = time->getYear();
+	}
 }
 
 /**
@@ -383,9 +439,14 @@ void GeoscapeState::timeDisplay()
  * the timer until the next speed step (eg. the next day
  * on 1 Day speed) or until an event occurs, since updating
  * the screen on each step would become cumbersomely slow.
+ * The steps are run in slices, see simulate().
  */
 void GeoscapeState::timeAdvance()
 {
+	// Still working through the last speed step
+	if (_stepsLeft > 0)
+		return;
+
 	int timeSpan = 0;
 	if (_timeSpeed == _btn5Secs)
 	{
@@ -411,9 +472,34 @@ void GeoscapeState::timeAdvance()
 	{
 		timeSpan = 12 * 5 * 6 * 2 * 24;
 	}
-		
-	for (int i = 0; i < timeSpan && !_pause; i++)
+	_stepsLeft = timeSpan;
+	_simTimer->start();
+	simulate();
+}
+
+/**
+ * Runs the 5 second steps left from the current speed step
+ * for at most SIMULATION_BUDGET miliseconds, so a long speed
+ * step doesn't hold up the screen and input. Whatever's left
+ * carries over to the next game cycle. Steps are dropped
+ * when a popup pauses the game.
+ */
+void GeoscapeState::simulate()
+{
+	Uint32 start = SDL_GetTicks();
+	while (_stepsLeft > 0 && !_pause && SDL_GetTicks() - start < SIMULATION_BUDGET)
 	{
+		// Skip straight to the next trigger when the steps before it wouldn't do anything
+		if (isIdle())
+		{
+			int steps = std::min(_stepsLeft, _game->getSavedGame()->getTime()->getStepsToTrigger()) - 1;
+			if (steps > 0)
+			{
+				_game->getSavedGame()->getTime()->skip(steps);
+				_stepsLeft -= steps;
+			}
+		}
+
 		TimeTrigger trigger;
 		trigger = _game->getSavedGame()->getTime()->advance();
 		switch (trigger)
@@ -431,14 +517,152 @@ void GeoscapeState::timeAdvance()
 		case TIME_5SEC:
 			time5Seconds();
 		}
+		_stepsLeft--;
 	}
 
+	if (_pause)
+	{
+		_stepsLeft = 0;
+	}
+	if (_stepsLeft == 0)
+	{
+		_simTimer->stop();
+	}
 	_pause = false;
 
 	timeDisplay();
 	_globe->draw();
 }
 
+/**
+ * Checks if the next 5 second step would leave
+ * everything as it is: no UFO is moving or about
+ * to be removed, all crafts are parked and there
+ * are no unused waypoints to clean up.
+ * @return True if the step can be skipped.
+ */
+bool GeoscapeState::isIdle() const
+{
+	for (std::vector<Ufo*>::iterator i = _game->getSavedGame()->getUfos()->begin(); i != _game->getSavedGame()->getUfos()->end(); i++)
+	{
+		if ((*i)->reachedDestination() || (*i)->getHoursCrashed() == 0)
+			return false;
+		if (!(*i)->isCrashed() && ((*i)->getSpeed() != 0 || (*i)->getDestination() != 0))
+			return false;
+	}
+	for (std::vector<Base*>::iterator i = _game->getSavedGame()->getBases()->begin(); i != _game->getSavedGame()->getBases()->end(); i++)
+	{
+		for (std::vector<Craft*>::iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end(); j++)
+		{
+			if ((*j)->getDestination() != 0)
+				return false;
+		}
+	}
+	for (std::vector<Waypoint*>::iterator i = _game->getSavedGame()->getWaypoints()->begin(); i != _game->getSavedGame()->getWaypoints()->end(); i++)
+	{
+		if ((*i)->getFollowers()->empty())
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Checks if a craft is already fighting a UFO.
+ * @param craft Pointer to craft.
+ * @return In a dogfight?
+ */
+bool GeoscapeState::isFighting(Craft *craft) const
+{
+	for (std::vector<Dogfight*>::const_iterator i = _dogfights.begin(); i != _dogfights.end(); i++)
+	{
+		if ((*i)->getCraft() == craft)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Advances every dogfight that isn't shown in a window
+ * by 5 seconds worth of steps, so they all run at the
+ * same time, then sends home the crafts of the ones
+ * that are over and removes any UFOs they destroyed.
+ */
+void GeoscapeState::updateDogfights()
+{
+	std::vector<Ufo*> destroyed;
+	for (std::vector<Dogfight*>::iterator i = _dogfights.begin(); i != _dogfights.end();)
+	{
+		if (!(*i)->isAttached())
+		{
+			(*i)->advance(DOGFIGHT_STEPS);
+		}
+		if ((*i)->isOver() && !(*i)->isAttached())
+		{
+			if ((*i)->finish() == DOGFIGHT_DESTROYED)
+			{
+				destroyed.push_back((*i)->getUfo());
+			}
+			deleteDogfight(*i);
+			i = _dogfights.erase(i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+	for (std::vector<Ufo*>::iterator i = destroyed.begin(); i != destroyed.end(); i++)
+	{
+		endDogfights(*i);
+		Dogfight::removeUfo(_game->getSavedGame(), *i);
+	}
+}
+
+/**
+ * Ends all the dogfights against a UFO that's about
+ * to be removed, sending their crafts home.
+ * @param ufo Pointer to UFO.
+ */
+void GeoscapeState::endDogfights(Ufo *ufo)
+{
+	for (std::vector<Dogfight*>::iterator i = _dogfights.begin(); i != _dogfights.end();)
+	{
+		if ((*i)->getUfo() == ufo)
+		{
+			(*i)->getCraft()->returnToBase();
+			deleteDogfight(*i);
+			i = _dogfights.erase(i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+/**
+ * Deletes a dogfight that's over, along with its window
+ * if it's still waiting in the popup queue, so the window
+ * never shows a dogfight that's gone.
+ * @param dogfight Pointer to the dogfight.
+ */
+void GeoscapeState::deleteDogfight(Dogfight *dogfight)
+{
+	for (std::vector<State*>::iterator i = _popups.begin(); i != _popups.end();)
+	{
+		DogfightState *window = dynamic_cast<DogfightState*>(*i);
+		if (window != 0 && window->getDogfight() == dogfight)
+		{
+			delete *i;
+			i = _popups.erase(i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+	delete dogfight;
+}
+
 /**
  * Takes care of any game logic that has to
  * run every game second, like craft movement.
@@ -455,6 +679,8 @@ void GeoscapeState::time5Seconds()
 		}
 	}
 
+	updateDogfights();
+
 	// Handle craft logic
 	for (std::vector<Base*>::iterator i = _game->getSavedGame()->getBases()->begin(); i != _game->getSavedGame()->getBases()->end(); i++)
 	{
@@ -482,9 +708,17 @@ void GeoscapeState::time5Seconds()
 				{
 					if (!u->isCrashed())
 					{
-						timerReset();
-						_music = false;
-						popup(new DogfightState(_game, _globe, (*j), u));
+						if (!isFighting(*j))
+						{
+							Dogfight *dogfight = new Dogfight((*j), u, _globe, DOGFIGHT_STANDARD);
+							_dogfights.push_back(dogfight);
+							if (!_autoDogfight)
+							{
+								timerReset();
+								_music = false;
+								popup(new DogfightState(_game, dogfight));
+							}
+						}
 					}
 					else
 					{
@@ -513,33 +747,39 @@ void GeoscapeState::time5Seconds()
 		}
 	}
 
-	// Clean up dead UFOs
-	for (std::vector<Ufo*>::iterator i = _game->getSavedGame()->getUfos()->begin(); i != _game->getSavedGame()->getUfos()->end();)
+	// Clean up dead UFOs, moving the rest down in a single pass
+	// so they stay in the same order
+	std::vector<Ufo*> *ufos = _game->getSavedGame()->getUfos();
+	std::vector<Ufo*>::iterator ufosEnd = ufos->begin();
+	for (std::vector<Ufo*>::iterator i = ufos->begin(); i != ufos->end(); i++)
 	{
 		if ((*i)->reachedDestination() || (*i)->getHoursCrashed() == 0)
 		{
+			endDogfights(*i);
 			delete *i;
-			i = _game->getSavedGame()->getUfos()->erase(i);
 		}
 		else
 		{
-			i++;
+			*ufosEnd++ = *i;
 		}
 	}
+	ufos->erase(ufosEnd, ufos->end());
 
 	// Clean up unused waypoints
-	for (std::vector<Waypoint*>::iterator i = _game->getSavedGame()->getWaypoints()->begin(); i != _game->getSavedGame()->getWaypoints()->end();)
+	std::vector<Waypoint*> *waypoints = _game->getSavedGame()->getWaypoints();
+	std::vector<Waypoint*>::iterator waypointsEnd = waypoints->begin();
+	for (std::vector<Waypoint*>::iterator i = waypoints->begin(); i != waypoints->end(); i++)
 	{
 		if ((*i)->getFollowers()->empty())
 		{
 			delete *i;
-			i = _game->getSavedGame()->getWaypoints()->erase(i);
 		}
 		else
 		{
-			i++;
+			*waypointsEnd++ = *i;
 		}
 	}
+	waypoints->erase(waypointsEnd, waypoints->end());
 }
 
 /**
@@ -552,7 +792,7 @@ void GeoscapeState::time10Minutes()
 	{
 		for (std::vector<Craft*>::iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end(); j++)
 		{
-			if ((*j)->getStatus() == "STR_OUT")
+			if ((*j)->getStatus() == CRAFT_OUT)
 			{
 				(*j)->consumeFuel();
 				if (!(*j)->getLowFuel() && (*j)->getFuel() <= (*j)->getFuelLimit())
@@ -566,46 +806,76 @@ void GeoscapeState::time10Minutes()
 	}
 }
 
+/**
+ * Gathers every radar that can see UFOs, in the order the
+ * bases, facilities and crafts are stored, so detection
+ * goes through them (and rolls for them) in the same order.
+ * Facilities without a radar are left out, since they never
+ * detect anything, and each range is converted only once.
+ * @param radars Pointer to the list to fill.
+ */
+void GeoscapeState::getRadars(std::vector<Radar> *radars) const
+{
+	for (std::vector<Base*>::iterator b = _game->getSavedGame()->getBases()->begin(); b != _game->getSavedGame()->getBases()->end(); b++)
+	{
+		for (std::vector<BaseFacility*>::iterator f = (*b)->getFacilities()->begin(); f != (*b)->getFacilities()->end(); f++)
+		{
+			if ((*f)->getRules()->getRadarRange() == 0)
+				continue;
+			Radar radar;
+			radar.facility = *f;
+			radar.craft = 0;
+			radar.lat = (*b)->getLatitude();
+			radar.range = (*f)->getRules()->getRadarRange() * (1 / 60.0) * (M_PI / 180);
+			radar.active = ((*f)->getBuildTime() == 0);
+			radars->push_back(radar);
+		}
+		for (std::vector<Craft*>::iterator c = (*b)->getCrafts()->begin(); c != (*b)->getCrafts()->end(); c++)
+		{
+			Radar radar;
+			radar.facility = 0;
+			radar.craft = *c;
+			radar.lat = (*c)->getLatitude();
+			radar.range = (*c)->getRules()->getRadarRange() * (1 / 60.0) * (M_PI / 180);
+			radar.active = !((*c)->getLongitude() == (*b)->getLongitude() && (*c)->getLatitude() == (*b)->getLatitude() && (*c)->getDestination() == 0);
+			radars->push_back(radar);
+		}
+	}
+}
+
+/**
+ * Quickly rules out a UFO that's further north or south
+ * of a radar than its range, without the full range check.
+ * @param radar Radar to check.
+ * @param ufo Pointer to the UFO.
+ * @return True if the UFO can't be in range.
+ */
+bool GeoscapeState::outsideRadarLatitude(const Radar &radar, Ufo *ufo)
+{
+	double dLat = ufo->getLatitude() - radar.lat;
+	return dLat * dLat > radar.range * radar.range;
+}
+
 /**
  * Takes care of any game logic that has to
  * run every game half hour, like UFO detection.
  */
 void GeoscapeState::time30Minutes()
 {
-	// Spawn UFOs
-	int chance = RNG::generate(1, 100);
-	if (chance <= 50)
+	// Spawn the UFOs planned for now, planning the rest of the month first for games that haven't yet
+	AlienSchedule *schedule = _game->getSavedGame()->getAlienSchedule();
+	if (!schedule->isPlanned())
 	{
-		int type = RNG::generate(1, 3);
-		Ufo *u;
-		switch (type)
-		{
-		case 1:
-			u = new Ufo(_game->getRuleset()->getUfo("STR_SMALL_SCOUT"));
-			break;
-		case 2:
-			u = new Ufo(_game->getRuleset()->getUfo("STR_MEDIUM_SCOUT"));
-			break;
-		case 3:
-			u = new Ufo(_game->getRuleset()->getUfo("STR_LARGE_SCOUT"));
-			break;
-		}
-		u->setLongitude(RNG::generate(0.0, 2*M_PI));
-		u->setLatitude(RNG::generate(-M_PI/2, M_PI/2));
-		Waypoint *w = new Waypoint();
-		w->setLongitude(RNG::generate(0.0, 2*M_PI));
-		w->setLatitude(RNG::generate(-M_PI/2, M_PI/2));
-		u->setDestination(w);
-		u->setSpeed(RNG::generate(u->getRules()->getMaxSpeed() / 4, u->getRules()->getMaxSpeed() / 2));
-		_game->getSavedGame()->getUfos()->push_back(u);
+		schedule->plan(_game->getRuleset(), _game->getSavedGame()->getTime());
 	}
+	schedule->advance(_game->getRuleset(), _game->getSavedGame()->getUfos());
 
 	// Handle craft maintenance
 	for (std::vector<Base*>::iterator i = _game->getSavedGame()->getBases()->begin(); i != _game->getSavedGame()->getBases()->end(); i++)
 	{
 		for (std::vector<Craft*>::iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end(); j++)
 		{
-			if ((*j)->getStatus() == "STR_REFUELLING")
+			if ((*j)->getStatus() == CRAFT_REFUELLING)
 			{
 				(*j)->refuel();
 			}
@@ -613,6 +883,8 @@ void GeoscapeState::time30Minutes()
 	}
 
 	// Handle UFO detection
+	std::vector<Radar> radars;
+	getRadars(&radars);
 	for (std::vector<Ufo*>::iterator u = _game->getSavedGame()->getUfos()->begin(); u != _game->getSavedGame()->getUfos()->end(); u++)
 	{
 		if ((*u)->isCrashed())
@@ -620,29 +892,24 @@ void GeoscapeState::time30Minutes()
 		if (!(*u)->getDetected())
 		{
 			bool detected = false;
-			for (std::vector<Base*>::iterator b = _game->getSavedGame()->getBases()->begin(); b != _game->getSavedGame()->getBases()->end() && !detected; b++)
+			for (std::vector<Radar>::iterator r = radars.begin(); r != radars.end() && !detected; r++)
 			{
-				for (std::vector<BaseFacility*>::iterator f = (*b)->getFacilities()->begin(); f != (*b)->getFacilities()->end() && !detected; f++)
+				if (!r->active || outsideRadarLatitude(*r, *u))
+					continue;
+				if (r->facility != 0)
 				{
-					if ((*f)->getBuildTime() != 0)
-						continue;
-					if ((*f)->insideRadarRange(*u))
+					if (r->facility->insideRadarRange(*u))
 					{
 						int chance = RNG::generate(1, 100);
-						if (chance <= (*f)->getRules()->getRadarChance())
+						if (chance <= r->facility->getRules()->getRadarChance())
 						{
 							detected = true;
 						}
 					}
 				}
-				for (std::vector<Craft*>::iterator c = (*b)->getCrafts()->begin(); c != (*b)->getCrafts()->end() && !detected; c++)
+				else if (r->craft->insideRadarRange(*u))
 				{
-					if ((*c)->getLongitude() == (*b)->getLongitude() && (*c)->getLatitude() == (*b)->getLatitude() && (*c)->getDestination() == 0)
-						continue;
-					if ((*c)->insideRadarRange(*u))
-					{
-						detected = true;
-					}
+					detected = true;
 				}
 			}
 			if (detected)
@@ -654,15 +921,17 @@ void GeoscapeState::time30Minutes()
 		else
 		{
 			bool detected = false;
-			for (std::vector<Base*>::iterator b = _game->getSavedGame()->getBases()->begin(); b != _game->getSavedGame()->getBases()->end() && !detected; b++)
+			for (std::vector<Radar>::iterator r = radars.begin(); r != radars.end() && !detected; r++)
 			{
-				for (std::vector<BaseFacility*>::iterator f = (*b)->getFacilities()->begin(); f != (*b)->getFacilities()->end() && !detected; f++)
+				if (outsideRadarLatitude(*r, *u))
+					continue;
+				if (r->facility != 0)
 				{
-					detected = detected || (*f)->insideRadarRange(*u);
+					detected = r->facility->insideRadarRange(*u);
 				}
-				for (std::vector<Craft*>::iterator c = (*b)->getCrafts()->begin(); c != (*b)->getCrafts()->end() && !detected; c++)
+				else
 				{
-					detected = detected || (*c)->insideRadarRange(*u);
+					detected = r->craft->insideRadarRange(*u);
 				}
 			}
 			(*u)->setDetected(detected);
@@ -681,11 +950,11 @@ void GeoscapeState::time1Hour()
 	{
 		for (std::vector<Craft*>::iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end(); j++)
 		{
-			if ((*j)->getStatus() == "STR_REPAIRS")
+			if ((*j)->getStatus() == CRAFT_REPAIRS)
 			{
 				(*j)->repair();
 			}
-			else if ((*j)->getStatus() == "STR_REARMING")
+			else if ((*j)->getStatus() == CRAFT_REARMING)
 			{
 				std::string s = (*j)->rearm();
 				if (s != "")
@@ -705,20 +974,8 @@ void GeoscapeState::time1Hour()
 		}
 	}
 
-	// Handle transfers
-	bool window = false;
-	for (std::vector<Base*>::iterator i = _game->getSavedGame()->getBases()->begin(); i != _game->getSavedGame()->getBases()->end(); i++)
-	{
-		for (std::vector<Transfer*>::iterator j = (*i)->getTransfers()->begin(); j != (*i)->getTransfers()->end(); j++)
-		{
-			(*j)->advance(*i);
-			if (!window && (*j)->getHours() == 0)
-			{
-				window = true;
-			}
-		}
-	}
-	if (window)
+	// Handle transfers, research and manufacturing
+	if (_game->getSavedGame()->advanceHour())
 	{
 		popup(new ItemsArrivingState(_game, this));
 	}
@@ -754,6 +1011,9 @@ void GeoscapeState::time1Day()
  */
 void GeoscapeState::time1Month()
 {
+	// Plan the alien activity for the new month
+	_game->getSavedGame()->getAlienSchedule()->plan(_game->getRuleset(), _game->getSavedGame()->getTime());
+
 	// Handle funding
 	timerReset();
 	_game->getSavedGame()->monthlyFunding();
@@ -784,6 +1044,35 @@ void GeoscapeState::popup(State *state)
 	_popups.push_back(state);
 }
 
+/**
+ * Throws away all the popup windows waiting to be
+ * shown and unpauses the game timer, for running
+ * the geoscape without anyone to answer them.
+ * @return Number of popups thrown away.
+ */
+int GeoscapeState::dismissPopups()
+{
+	int n = _popups.size();
+	for (std::vector<State*>::iterator i = _popups.begin(); i != _popups.end(); i++)
+	{
+		delete *i;
+	}
+	_popups.clear();
+	_pause = false;
+	return n;
+}
+
+/**
+ * Changes whether crafts reaching a UFO fight it out
+ * on the geoscape clock instead of opening the Dogfight
+ * window, for running many interceptions quickly.
+ * @param autoDogfight Auto-resolve dogfights?
+ */
+void GeoscapeState::setAutoDogfight(bool autoDogfight)
+{
+	_autoDogfight = autoDogfight;
+}
+
 /**
  * Returns a pointer to the Geoscape globe for
  * access by other substates.
@@ -821,7 +1110,12 @@ void GeoscapeState::globeClick(Action *action)
  */
 void GeoscapeState::btnInterceptClick(Action *action)
 {
-	_game->pushState(new InterceptState(_game, _globe));
+	InterceptState *state = _game->getCachedState<InterceptState>();
+	if (state == 0)
+	{
+		state = new InterceptState(_game, _globe);
+	}
+	_game->pushState(state);
 }
 
 /**
@@ -832,7 +1126,16 @@ void GeoscapeState::btnBasesClick(Action *action)
 {
 	if (_game->getSavedGame()->getBases()->size() > 0)
 	{
-		_game->pushState(new BasescapeState(_game, _game->getSavedGame()->getBases()->front(), _globe));
+		BasescapeState *state = _game->getCachedState<BasescapeState>();
+		if (state == 0)
+		{
+			state = new BasescapeState(_game, _game->getSavedGame()->getBases()->front(), _globe);
+		}
+		else
+		{
+			state->setBase(_game->getSavedGame()->getBases()->front());
+		}
+		_game->pushState(state);
 	}
 	else
 	{
@@ -849,7 +1152,6 @@ void GeoscapeState::btnGraphsClick(Action *action)
 	//_game->pushState(new GraphsState(_game));
 
 	/* Daiky: uncomment this bit to start a terror mission */
-	_game->getSavedGame()->setBattleGame(new SavedBattleGame());	
 	BattlescapeGenerator *bgen = new BattlescapeGenerator(_game);
 	bgen->setMissionType(MISS_TERROR);
 	//bgen->setMissionType(MISS_UFOASSAULT);
@@ -857,6 +1159,7 @@ void GeoscapeState::btnGraphsClick(Action *action)
 	bgen->setWorldShade(1);
 	bgen->setCraft(_game->getSavedGame()->getBases()->at(0)->getCrafts()->at(0));
 	bgen->run();
+	bgen->install();
 	delete bgen;
 	_music = false;
 	_game->pushState(new BattlescapeState(_game));
@@ -889,6 +1192,17 @@ void GeoscapeState::btnFundingClick(Action *action)
 	_game->pushState(new FundingState(_game));
 }
 
+/**
+ * Drops what's left of the speed step in progress,
+ * so the new speed takes over from the next step.
+ * @param action Pointer to an action.
+ */
+void GeoscapeState::btnTimeSpeedClick(Action *action)
+{
+	_stepsLeft = 0;
+	_simTimer->stop();
+}
+
 /**
  * Starts rotating the globe to the left.
  * @param action Pointer to an action.
@@ -22,6 +22,8 @@
 #include "../Engine/State.h"
 #include <vector>
 
+#define SIMULATION_BUDGET 12
+
 namespace OpenXcom
 {
 
@@ -31,6 +33,10 @@ class ImageButton;
 class InteractiveSurface;
 class Text;
 class Timer;
+class BaseFacility;
+class Craft;
+class Ufo;
+class Dogfight;
 
 /**
  * Geoscape screen which shows an overview of
@@ -46,9 +52,32 @@ private:
 	ImageButton *_btn5Secs, *_btn1Min, *_btn5Mins, *_btn30Mins, *_btn1Hour, *_btn1Day;
 	InteractiveSurface *_btnRotateLeft, *_btnRotateRight, *_btnRotateUp, *_btnRotateDown, *_btnZoomIn, *_btnZoomOut;
 	Text *_txtHour, *_txtHourSep, *_txtMin, *_txtMinSep, *_txtSec, *_txtWeekday, *_txtDay, *_txtMonth, *_txtYear;
-	Timer *_timer;
-	bool _pause, _music;
+	Timer *_timer, *_simTimer;
+	bool _pause, _music, _autoDogfight;
+	int _stepsLeft;
+	int _shownSecond, _shownMinute, _shownHour, _shownWeekday, _shownDay, _shownMonth, _shownYear;
 	std::vector<State*> _popups;
+	std::vector<Dogfight*> _dogfights;
+	/// A radar that can detect UFOs, either a base facility or a craft.
+	struct Radar
+	{
+		BaseFacility *facility;
+		Craft *craft;
+		double lat, range;
+		bool active;
+	};
+	/// Gets all the radars around the world.
+	void getRadars(std::vector<Radar> *radars) const;
+	/// Checks if a UFO is too far north or south for a radar.
+	static bool outsideRadarLatitude(const Radar &radar, Ufo *ufo);
+	/// Checks if a craft is in a dogfight.
+	bool isFighting(Craft *craft) const;
+	/// Advances the dogfights nobody is watching and cleans up finished ones.
+	void updateDogfights();
+	/// Ends all the dogfights against a UFO.
+	void endDogfights(Ufo *ufo);
+	/// Deletes a dogfight and any window queued for it.
+	void deleteDogfight(Dogfight *dogfight);
 public:
 	/// Creates the Geoscape state.
 	GeoscapeState(Game *game);
@@ -62,6 +91,10 @@ public:
 	void timeDisplay();
 	/// Advances the game timer.
 	void timeAdvance();
+	/// Runs a slice of the steps left to advance.
+	void simulate();
+	/// Checks if nothing on the globe would change in 5 seconds.
+	bool isIdle() const;
 	/// Trigger whenever 5 seconds pass.
 	void time5Seconds();
 	/// Trigger whenever 10 minutes pass.
@@ -78,6 +111,10 @@ public:
 	void timerReset();
 	/// Displays a popup window.
 	void popup(State *state);
+	/// Throws away the queued popup windows.
+	int dismissPopups();
+	/// Sets whether dogfights are fought without the Dogfight window.
+	void setAutoDogfight(bool autoDogfight);
 	/// Gets the Geoscape globe.
 	Globe *const getGlobe() const;
 	/// Handler for clicking the globe.
@@ -94,6 +131,8 @@ public:
 	void btnOptionsClick(Action *action);
 	/// Handler for clicking the Funding button.
 	void btnFundingClick(Action *action);
+	/// Handler for clicking a time speed button.
+	void btnTimeSpeedClick(Action *action);
 	/// Handler for pressing the Rotate Left arrow.
 	void btnRotateLeftPress(Action *action);
 	/// Handler for releasing the Rotate Left arrow.
@@ -19,10 +19,12 @@
 #define _USE_MATH_DEFINES
 #include "Globe.h"
 #include <cmath>
+#include <algorithm>
 #include <fstream>
 #include "../Engine/Action.h"
 #include "../Engine/SurfaceSet.h"
 #include "../Engine/Timer.h"
+#include "../Engine/PolarGrid.h"
 #include "../Resource/ResourcePack.h"
 #include "Polygon.h"
 #include "Polyline.h"
@@ -37,6 +39,7 @@
 #include "../Engine/Font.h"
 #include "../Engine/Language.h"
 #include "../Engine/Exception.h"
+#include "../Engine/Profiler.h"
 #include "../Ruleset/RuleRegion.h"
 #include "../Savegame/Region.h"
 #include "../Ruleset/City.h"
@@ -56,6 +59,11 @@ namespace OpenXcom
 #define ROTATE_LONGITUDE 0.25
 #define ROTATE_LATITUDE 0.15
 #define NEAR_RADIUS 25
+#define CLUSTER_COLUMNS 24
+#define CLUSTER_ROWS 12
+#define OCEAN_DAYLIGHT_STEPS 2880
+#define LOD_RADIUS 360
+#define TARGET_CELL_SIZE 8
 
 /**
  * Sets up a globe with the specified size and position.
@@ -67,14 +75,14 @@ namespace OpenXcom
  * @param x X position in pixels.
  * @param y Y position in pixels.
  */
-Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y) : InteractiveSurface(width, height, x, y), _radius(), _cenLon(-0.01), _cenLat(-0.1), _rotLon(0.0), _rotLat(0.0), _cenX(cenX), _cenY(cenY), _zoom(0), _game(game), _blink(true), _detail(true), _cacheLand()
+Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y) : InteractiveSurface(width, height, x, y), _landIndex(), _radius(), _cenLon(-0.01), _cenLat(-0.1), _rotLon(0.0), _rotLat(0.0), _labelVectors(), _cityVectors(), _cenX(cenX), _cenY(cenY), _zoom(0), _game(game), _oceanZoom(-1), _oceanDaylight(-1), _landDaylight(-1), _detailDirty(true), _labels(), _targetCells(), _targetColumns(0), _targetMarks(0), _oceanLon(0.0), _oceanLat(0.0), _blink(true), _detail(true), _cacheLand()
 {
-	_texture[0] = _game->getResourcePack()->getSurfaceSet("TEXTURE.DAT");
-	for (int shade = 1; shade < NUM_SHADES; shade++)
+	_texture = _game->getResourcePack()->getSurfaceSet("TEXTURE.DAT");
+	for (int shade = 0; shade < NUM_SHADES; shade++)
 	{
-		_texture[shade] = new SurfaceSet(*_texture[0]);
-		for (int f = 0; f < _texture[shade]->getTotalFrames(); f++)
-			_texture[shade]->getFrame(f)->offset(shade);
+		_shadeTables[shade][0] = 0;
+		for (int pixel = 1; pixel < 256; pixel++)
+			_shadeTables[shade][pixel] = pixel + shade;
 	}
 
 	_radius.push_back(90);
@@ -84,8 +92,12 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_radius.push_back(450);
 	_radius.push_back(720);
 
+	_targetColumns = width / TARGET_CELL_SIZE + 1;
+	_targetCells.resize(_targetColumns * (height / TARGET_CELL_SIZE + 1));
+
 	_countries = new Surface(width, height, x, y);
 	_markers = new Surface(width, height, x, y);
+	_ocean = new Surface(width, height);
 
 	// Animation timers
 	_blinkTimer = new Timer(100);
@@ -95,7 +107,7 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_rotTimer->onTimer((SurfaceHandler)&Globe::rotate);
 	
 	// Globe markers
-	_mkXcomBase = new Surface(3, 3);
+	_mkXcomBase = new Surface(6, 3);
 	_mkXcomBase->lock();
 	_mkXcomBase->setPixel(0, 0, 9);
 	_mkXcomBase->setPixel(1, 0, 9);
@@ -107,7 +119,7 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_mkXcomBase->setPixel(2, 2, 9);
 	_mkXcomBase->unlock();
 
-	_mkAlienBase = new Surface(3, 3);
+	_mkAlienBase = new Surface(6, 3);
 	_mkAlienBase->lock();
 	_mkAlienBase->setPixel(0, 0, 1);
 	_mkAlienBase->setPixel(1, 0, 1);
@@ -119,7 +131,7 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_mkAlienBase->setPixel(2, 2, 1);
 	_mkAlienBase->unlock();
 
-	_mkCraft = new Surface(3, 3);
+	_mkCraft = new Surface(6, 3);
 	_mkCraft->lock();
 	_mkCraft->setPixel(1, 0, 11);
 	_mkCraft->setPixel(0, 1, 11);
@@ -127,7 +139,7 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_mkCraft->setPixel(1, 2, 11);
 	_mkCraft->unlock();
 
-	_mkWaypoint = new Surface(3, 3);
+	_mkWaypoint = new Surface(6, 3);
 	_mkWaypoint->lock();
 	_mkWaypoint->setPixel(0, 0, 3);
 	_mkWaypoint->setPixel(0, 2, 3);
@@ -149,7 +161,7 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_mkCity->setPixel(2, 2, 14);
 	_mkCity->unlock();
 
-	_mkFlyingUfo = new Surface(3, 3);
+	_mkFlyingUfo = new Surface(6, 3);
 	_mkFlyingUfo->lock();
 	_mkFlyingUfo->setPixel(1, 0, 13);
 	_mkFlyingUfo->setPixel(0, 1, 13);
@@ -158,7 +170,7 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_mkFlyingUfo->setPixel(1, 2, 13);
 	_mkFlyingUfo->unlock();
 
-	_mkLandedUfo = new Surface(3, 3);
+	_mkLandedUfo = new Surface(6, 3);
 	_mkLandedUfo->lock();
 	_mkLandedUfo->setPixel(0, 0, 7);
 	_mkLandedUfo->setPixel(0, 2, 7);
@@ -167,7 +179,7 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_mkLandedUfo->setPixel(2, 2, 7);
 	_mkLandedUfo->unlock();
 
-	_mkCrashedUfo = new Surface(3, 3);
+	_mkCrashedUfo = new Surface(6, 3);
 	_mkCrashedUfo->lock();
 	_mkCrashedUfo->setPixel(0, 0, 5);
 	_mkCrashedUfo->setPixel(0, 2, 5);
@@ -176,7 +188,7 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_mkCrashedUfo->setPixel(2, 2, 5);
 	_mkCrashedUfo->unlock();
 
-	_mkAlienSite = new Surface(3, 3);
+	_mkAlienSite = new Surface(6, 3);
 	_mkAlienSite->lock();
 	_mkAlienSite->setPixel(1, 0, 1);
 	_mkAlienSite->setPixel(0, 1, 1);
@@ -185,6 +197,37 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
 	_mkAlienSite->setPixel(1, 2, 1);
 	_mkAlienSite->unlock();
 
+	// Blinking markers keep their blinked look next to them, so blinking is just cropping
+	Surface *blinking[] = {_mkXcomBase, _mkAlienBase, _mkCraft, _mkWaypoint, _mkFlyingUfo, _mkLandedUfo, _mkCrashedUfo, _mkAlienSite};
+	for (int i = 0; i < 8; i++)
+	{
+		blinking[i]->lock();
+		for (int y = 0; y < 3; y++)
+		{
+			for (int x = 0; x < 3; x++)
+			{
+				Uint8 pixel = blinking[i]->getPixel(x, y);
+				if (pixel != 0)
+				{
+					blinking[i]->setPixel(x + 3, y, pixel + 1);
+				}
+			}
+		}
+		blinking[i]->unlock();
+		SDL_Rect *crop = blinking[i]->getCrop();
+		crop->x = 0;
+		crop->y = 0;
+		crop->w = 3;
+		crop->h = 3;
+	}
+
+	buildClusters(_game->getResourcePack()->getPolygons(), &_clusters[0]);
+	for (int lod = 1; lod < POLYGON_LODS; lod++)
+	{
+		mergePolygons(lod == 1 ? _game->getResourcePack()->getPolygons() : &_lodPolygons[lod - 2], &_lodPolygons[lod - 1]);
+		buildClusters(&_lodPolygons[lod - 1], &_clusters[lod]);
+	}
+	buildLandIndex(_game->getResourcePack()->getPolygons());
 	cachePolygons();
 }
 
@@ -193,13 +236,11 @@ Globe::Globe(Game *game, int cenX, int cenY, int width, int height, int x, int y
  */
 Globe::~Globe()
 {
-	for (int i = 1; i < NUM_SHADES; i++)
-		delete _texture[i];
-
     delete _blinkTimer;
     delete _rotTimer;
 	delete _countries;
 	delete _markers;
+	delete _ocean;
 	delete _mkXcomBase;
 	delete _mkAlienBase;
 	delete _mkCraft;
@@ -214,6 +255,17 @@ Globe::~Globe()
 	{
 		delete *i;
 	}
+	for (int lod = 0; lod < POLYGON_LODS - 1; lod++)
+	{
+		for (std::list<Polygon*>::iterator i = _lodPolygons[lod].begin(); i != _lodPolygons[lod].end(); i++)
+		{
+			delete *i;
+		}
+	}
+	for (std::map<std::pair<std::wstring, Uint8>, Text*>::iterator i = _labels.begin(); i != _labels.end(); i++)
+	{
+		delete i->second;
+	}
 }
 
 /**
@@ -225,10 +277,40 @@ Globe::~Globe()
  * @param y Pointer to the output Y position.
  */
 void Globe::polarToCart(double lon, double lat, Sint16 *x, Sint16 *y) const
+{
+	double v[3];
+	polarToVector(lon, lat, v);
+	vectorToCart(v, x, y);
+}
+
+/**
+ * Converts a polar point into the unit vector pointing to it
+ * from the center of the world (X towards longitude 90,
+ * Y towards latitude 90, Z towards longitude 0), same as
+ * the ones stored in the world polygons.
+ * @param lon Longitude of the polar point.
+ * @param lat Latitude of the polar point.
+ * @param v Pointer to the output X, Y and Z.
+ */
+void Globe::polarToVector(double lon, double lat, double *v)
+{
+	v[0] = cos(lat) * sin(lon);
+	v[1] = sin(lat);
+	v[2] = cos(lat) * cos(lon);
+}
+
+/**
+ * Converts a unit vector into a cartesian point on the globe
+ * by rotating it to the current view.
+ * @param v Pointer to the vector's X, Y and Z.
+ * @param x Pointer to the output X position.
+ * @param y Pointer to the output Y position.
+ */
+void Globe::vectorToCart(const double *v, Sint16 *x, Sint16 *y) const
 {
 	// Orthographic projection
-	*x = _cenX + (Sint16)floor(_radius[_zoom] * cos(lat) * sin(lon - _cenLon));
-	*y = _cenY + (Sint16)floor(_radius[_zoom] * (cos(_cenLat) * sin(lat) - sin(_cenLat) * cos(lat) * cos(lon - _cenLon)));
+	*x = _cenX + (Sint16)floor(_radius[_zoom] * (_rotation[0][0] * v[0] + _rotation[0][1] * v[1] + _rotation[0][2] * v[2]));
+	*y = _cenY + (Sint16)floor(_radius[_zoom] * (_rotation[1][0] * v[0] + _rotation[1][1] * v[1] + _rotation[1][2] * v[2]));
 }
 
 /**
@@ -267,9 +349,41 @@ void Globe::cartToPolar(Sint16 x, Sint16 y, double *lon, double *lat) const
  */
 bool Globe::pointBack(double lon, double lat) const
 {
-	double c = cos(_cenLat) * cos(lat) * cos(lon - _cenLon) + sin(_cenLat) * sin(lat);
-	
-	return c < 0;
+	double v[3];
+	polarToVector(lon, lat, v);
+	return pointBack(v);
+}
+
+/**
+ * Checks if a unit vector is on the back-half of the globe,
+ * invisible to the player.
+ * @param v Pointer to the vector's X, Y and Z.
+ * @return True if it's on the back, False if it's on the front.
+ */
+bool Globe::pointBack(const double *v) const
+{
+	return _rotation[2][0] * v[0] + _rotation[2][1] * v[1] + _rotation[2][2] * v[2] < 0;
+}
+
+/**
+ * Works out the rotation that takes the unit vectors
+ * of the world to the current view, where X and Y
+ * are the screen axes and Z faces the player.
+ */
+void Globe::updateRotation()
+{
+	double cosLon = cos(_cenLon), sinLon = sin(_cenLon);
+	double cosLat = cos(_cenLat), sinLat = sin(_cenLat);
+
+	_rotation[0][0] = cosLon;
+	_rotation[0][1] = 0.0;
+	_rotation[0][2] = -sinLon;
+	_rotation[1][0] = -sinLat * sinLon;
+	_rotation[1][1] = cosLat;
+	_rotation[1][2] = -sinLat * cosLon;
+	_rotation[2][0] = cosLat * sinLon;
+	_rotation[2][1] = sinLat;
+	_rotation[2][2] = cosLat * cosLon;
 }
 
 
@@ -285,39 +399,60 @@ double Globe::lastVisibleLat(double lon) const
 }
 
 /**
- * Checks if a polar point is inside a certain polygon.
- * @param lon Longitude of the point.
- * @param lat Latitude of the point.
+ * Checks if a point is inside a certain polygon, straight
+ * from the unit vectors so it doesn't depend on the view.
+ * The polygon is split in a fan of triangles, and the point
+ * is inside a triangle if it's on the same side of the great
+ * circles through all its edges, on the same half of the world.
+ * @param v Pointer to the unit vector of the point.
  * @param poly Pointer to the polygon.
  * @return True if it's inside, False if it's outside.
  */
-bool Globe::insidePolygon(double lon, double lat, Polygon *poly) const
+bool Globe::insidePolygon(const double *v, Polygon *poly)
 {
-	bool backFace = true;
-	for (int i = 0; i < poly->getPoints(); i++)
-	{
-		backFace = backFace && pointBack(poly->getLongitude(i), poly->getLatitude(i));
-	}
-	if (backFace != pointBack(lon, lat))
+	const double *a = poly->getVector(0);
+	if (a[0] * v[0] + a[1] * v[1] + a[2] * v[2] <= 0)
 		return false;
 
-	bool c = false;
-	for (int i = 0; i < poly->getPoints(); i++)
+	for (int i = 1; i < poly->getPoints() - 1; i++)
 	{
-		int j = (i + 1) % poly->getPoints();
-
-		Sint16 x, y, x_i, x_j, y_i, y_j;
-		polarToCart(poly->getLongitude(i), poly->getLatitude(i), &x_i, &y_i);
-		polarToCart(poly->getLongitude(j), poly->getLatitude(j), &x_j, &y_j);
-		polarToCart(lon, lat, &x, &y);
+		const double *tri[3] = {a, poly->getVector(i), poly->getVector(i + 1)};
+		bool front = false, back = false;
+		for (int j = 0; j < 3; j++)
+		{
+			const double *p = tri[j], *q = tri[(j + 1) % 3];
+			double side = (p[1] * q[2] - p[2] * q[1]) * v[0] + (p[2] * q[0] - p[0] * q[2]) * v[1] + (p[0] * q[1] - p[1] * q[0]) * v[2];
+			if (side > 0)
+				front = true;
+			else if (side < 0)
+				back = true;
+		}
+		if (!(front && back))
+			return true;
+	}
+	return false;
+}
 
-		if ( ((y_i > y) != (y_j > y)) &&
-			 (x < (x_j - x_i) * (y - y_i) / (y_j - y_i) + x_i) )
+/**
+ * Finds the land polygon a polar point is in, looking
+ * only through the polygons indexed near the point.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return Pointer to the polygon, or 0 if it's in the ocean.
+ */
+Polygon *Globe::getLandPolygon(double lon, double lat) const
+{
+	double v[3];
+	polarToVector(lon, lat, v);
+	const std::vector<Polygon*> &candidates = _landIndex[PolarGrid::getCell(lon, lat)];
+	for (std::vector<Polygon*>::const_iterator i = candidates.begin(); i != candidates.end(); i++)
+	{
+		if (insidePolygon(v, *i))
 		{
-			c = !c;
+			return *i;
 		}
 	}
-	return c;
+	return 0;
 }
 
 /**
@@ -493,12 +628,7 @@ void Globe::center(double lon, double lat)
  */
 bool Globe::insideLand(double lon, double lat) const
 {
-	bool inside = false;
-	for (std::list<Polygon*>::iterator i = _game->getResourcePack()->getPolygons()->begin(); i != _game->getResourcePack()->getPolygons()->end() && !inside; i++)
-	{
-		inside = insidePolygon(lon, lat, *i);
-	}
-	return inside;
+	return getLandPolygon(lon, lat) != 0;
 }
 
 /**
@@ -512,26 +642,20 @@ void Globe::toggleDetail()
 }
 
 /**
- * Checks if a certain target is near a certain cartesian point
- * (within a circled area around it) over the globe.
- * @param target Pointer to target.
- * @param x X coordinate of point.
- * @param y Y coordinate of point.
- * @return True if it's near, false otherwise.
+ * Orders target marks the way they were added.
+ * @param a First mark.
+ * @param b Second mark.
+ * @return True if A was added before B.
  */
-bool Globe::targetNear(Target* target, int x, int y) const
+bool Globe::targetMarkLess(const TargetMark &a, const TargetMark &b)
 {
-	Sint16 tx, ty;
-	polarToCart(target->getLongitude(), target->getLatitude(), &tx, &ty);
-
-	int dx = x - tx;
-	int dy = y - ty;
-	return (dx * dx + dy * dy <= NEAR_RADIUS);
+	return a.order < b.order;
 }
 
 /**
  * Returns a list of all the targets currently near a certain
- * cartesian point over the globe.
+ * cartesian point over the globe, looking only through the
+ * cells of the picking grid around the point.
  * @param x X coordinate of point.
  * @param y Y coordinate of point.
  * @param craft Only get craft targets.
@@ -539,68 +663,404 @@ bool Globe::targetNear(Target* target, int x, int y) const
  */
 std::vector<Target*> Globe::getTargets(int x, int y, bool craft) const
 {
-	std::vector<Target*> v;
-	if (!craft)
+	std::vector<TargetMark> marks;
+	int reach = (int)ceil(sqrt((double)NEAR_RADIUS));
+	int rows = _targetCells.size() / _targetColumns;
+	int minCol = std::max(0, (x - reach) / TARGET_CELL_SIZE), maxCol = std::min(_targetColumns - 1, (x + reach) / TARGET_CELL_SIZE);
+	int minRow = std::max(0, (y - reach) / TARGET_CELL_SIZE), maxRow = std::min(rows - 1, (y + reach) / TARGET_CELL_SIZE);
+	for (int row = minRow; row <= maxRow; row++)
 	{
-		for (std::vector<Base*>::iterator i = _game->getSavedGame()->getBases()->begin(); i != _game->getSavedGame()->getBases()->end(); i++)
+		for (int col = minCol; col <= maxCol; col++)
 		{
-			if ((*i)->getLongitude() == 0.0 && (*i)->getLatitude() == 0.0)
-				continue;
-
-			if (targetNear((*i), x, y))
+			const std::vector<TargetMark> &cell = _targetCells[row * _targetColumns + col];
+			for (std::vector<TargetMark>::const_iterator i = cell.begin(); i != cell.end(); i++)
 			{
-				v.push_back(*i);
+				if (craft && i->base)
+					continue;
+
+				int dx = x - i->x;
+				int dy = y - i->y;
+				if (dx * dx + dy * dy <= NEAR_RADIUS)
+				{
+					marks.push_back(*i);
+				}
 			}
+		}
+	}
+	std::sort(marks.begin(), marks.end(), targetMarkLess);
+
+	std::vector<Target*> v;
+	for (std::vector<TargetMark>::iterator i = marks.begin(); i != marks.end(); i++)
+	{
+		v.push_back(i->target);
+	}
+	return v;
+}
+
+/**
+ * Puts a target in the picking grid at its position on
+ * the globe, if it's close enough to the surface to be clicked.
+ * @param target Pointer to target.
+ * @param base Whether it's a base or craft, which aren't picked for craft destinations.
+ */
+void Globe::addTargetMark(Target *target, bool base)
+{
+	Sint16 x, y;
+	polarToCart(target->getLongitude(), target->getLatitude(), &x, &y);
+	int reach = (int)ceil(sqrt((double)NEAR_RADIUS));
+	if (x < -reach || y < -reach || x >= getWidth() + reach || y >= getHeight() + reach)
+		return;
+
+	TargetMark mark;
+	mark.target = target;
+	mark.x = x;
+	mark.y = y;
+	mark.base = base;
+	mark.order = _targetMarks++;
+	int col = std::max(0, std::min(_targetColumns - 1, x / TARGET_CELL_SIZE));
+	int row = std::max(0, std::min((int)(_targetCells.size() / _targetColumns) - 1, y / TARGET_CELL_SIZE));
+	_targetCells[row * _targetColumns + col].push_back(mark);
+}
+
+/**
+ * Takes care of pre-calculating all the polygons currently visible
+ * on the globe and caching them so they only need to be recalculated
+ * when the globe is actually moved.
+ */
+void Globe::cachePolygons()
+{
+	updateRotation();
+	cache(_clusters[getPolygonLod()], &_cacheLand);
+	_landDaylight = -1;
+	_detailDirty = true;
+	draw();
+}
 
-			for (std::vector<Craft*>::iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end(); j++)
+/**
+ * Works out the center of a set of polygons on the globe
+ * and how far their furthest point is from it.
+ * @param polygons List of polygons.
+ * @param center Pointer to the output unit vector of the center.
+ * @return Cosine of the angle to the furthest point, or -1 if there's no center.
+ */
+double Globe::getBoundingCap(const std::vector<Polygon*> &polygons, double *center)
+{
+	center[0] = center[1] = center[2] = 0.0;
+	for (std::vector<Polygon*>::const_iterator i = polygons.begin(); i != polygons.end(); i++)
+	{
+		for (int j = 0; j < (*i)->getPoints(); j++)
+		{
+			center[0] += (*i)->getVector(j)[0];
+			center[1] += (*i)->getVector(j)[1];
+			center[2] += (*i)->getVector(j)[2];
+		}
+	}
+	double length = sqrt(center[0] * center[0] + center[1] * center[1] + center[2] * center[2]);
+	if (length <= 0.0)
+		return -1.0;
+
+	center[0] /= length;
+	center[1] /= length;
+	center[2] /= length;
+	double minDot = 1.0;
+	for (std::vector<Polygon*>::const_iterator i = polygons.begin(); i != polygons.end(); i++)
+	{
+		for (int j = 0; j < (*i)->getPoints(); j++)
+		{
+			const double *v = (*i)->getVector(j);
+			minDot = std::min(minDot, center[0] * v[0] + center[1] * v[1] + center[2] * v[2]);
+		}
+	}
+	return minDot;
+}
+
+/**
+ * Builds a coarser set of world polygons, by joining each
+ * polygon with a neighbour of the same texture when the
+ * two of them make up a single convex polygon of up to 4 points.
+ * @param polygons Pointer to list of polygons.
+ * @param merged Pointer to the list to fill with the new polygons.
+ */
+void Globe::mergePolygons(std::list<Polygon*> *polygons, std::list<Polygon*> *merged)
+{
+	std::vector<Polygon*> source(polygons->begin(), polygons->end());
+	typedef std::pair<double, double> Point;
+	std::map<std::pair<Point, Point>, std::vector<size_t> > edges;
+	for (size_t i = 0; i < source.size(); i++)
+	{
+		Polygon *p = source[i];
+		for (int j = 0; j < p->getPoints(); j++)
+		{
+			int k = (j + 1) % p->getPoints();
+			Point a = std::make_pair(p->getLongitude(j), p->getLatitude(j));
+			Point b = std::make_pair(p->getLongitude(k), p->getLatitude(k));
+			edges[std::make_pair(std::min(a, b), std::max(a, b))].push_back(i);
+		}
+	}
+
+	std::vector<bool> used(source.size(), false);
+	for (size_t i = 0; i < source.size(); i++)
+	{
+		if (used[i])
+			continue;
+
+		Polygon *p = source[i];
+		Polygon *joined = 0;
+		for (int j = 0; j < p->getPoints() && joined == 0; j++)
+		{
+			int k = (j + 1) % p->getPoints();
+			Point a = std::make_pair(p->getLongitude(j), p->getLatitude(j));
+			Point b = std::make_pair(p->getLongitude(k), p->getLatitude(k));
+			std::vector<size_t> &neighbours = edges[std::make_pair(std::min(a, b), std::max(a, b))];
+			for (std::vector<size_t>::iterator n = neighbours.begin(); n != neighbours.end() && joined == 0; n++)
 			{
-				if ((*j)->getLongitude() == (*i)->getLongitude() && (*j)->getLatitude() == (*i)->getLatitude() && (*j)->getDestination() == 0)
+				if (*n == i || used[*n] || source[*n]->getTexture() != p->getTexture())
 					continue;
-			
-				if (targetNear((*j), x, y))
+				joined = mergePolygon(p, source[*n]);
+				if (joined != 0)
 				{
-					v.push_back(*j);
+					used[*n] = true;
 				}
 			}
 		}
+		used[i] = true;
+		merged->push_back(joined != 0 ? joined : new Polygon(*p));
 	}
-	for (std::vector<Ufo*>::iterator i = _game->getSavedGame()->getUfos()->begin(); i != _game->getSavedGame()->getUfos()->end(); i++)
+}
+
+/**
+ * Joins two polygons that share an edge into one, as long as
+ * the result is convex and has no more than 4 points once the
+ * points left in the middle of straight edges are removed.
+ * Polygons touching the poles are left alone, since the
+ * longitude of their pole points means nothing.
+ * @param a Pointer to the first polygon.
+ * @param b Pointer to the second polygon.
+ * @return Pointer to the new polygon, or 0 if they can't be joined.
+ */
+Polygon *Globe::mergePolygon(Polygon *a, Polygon *b)
+{
+	for (int i = 0; i < a->getPoints(); i++)
 	{
-		if (!(*i)->getDetected())
-			continue;
-		
-		if (targetNear((*i), x, y))
+		if (fabs(a->getLatitude(i)) >= M_PI / 2 - 0.0001)
+			return 0;
+	}
+	for (int i = 0; i < b->getPoints(); i++)
+	{
+		if (fabs(b->getLatitude(i)) >= M_PI / 2 - 0.0001)
+			return 0;
+	}
+
+	// Find the shared edge, going one way in A and either way in B
+	std::vector<double> lon, lat;
+	for (int i = 0; i < a->getPoints() && lon.empty(); i++)
+	{
+		int i2 = (i + 1) % a->getPoints();
+		for (int j = 0; j < b->getPoints() && lon.empty(); j++)
 		{
-			v.push_back(*i);
+			int j2 = (j + 1) % b->getPoints();
+			int step;
+			if (a->getLongitude(i) == b->getLongitude(j2) && a->getLatitude(i) == b->getLatitude(j2) &&
+				a->getLongitude(i2) == b->getLongitude(j) && a->getLatitude(i2) == b->getLatitude(j))
+			{
+				step = 1;
+			}
+			else if (a->getLongitude(i) == b->getLongitude(j) && a->getLatitude(i) == b->getLatitude(j) &&
+				a->getLongitude(i2) == b->getLongitude(j2) && a->getLatitude(i2) == b->getLatitude(j2))
+			{
+				step = -1;
+			}
+			else
+			{
+				continue;
+			}
+
+			// All of A from the end of the edge round to its start, then the rest of B
+			for (int k = 0; k < a->getPoints(); k++)
+			{
+				int p = (i2 + k) % a->getPoints();
+				lon.push_back(a->getLongitude(p));
+				lat.push_back(a->getLatitude(p));
+			}
+			int start = (step == 1) ? j2 : j;
+			for (int k = 1; k < b->getPoints() - 1; k++)
+			{
+				int p = ((start + step * k) % b->getPoints() + b->getPoints()) % b->getPoints();
+				lon.push_back(b->getLongitude(p));
+				lat.push_back(b->getLatitude(p));
+			}
 		}
 	}
-	for (std::vector<Waypoint*>::iterator i = _game->getSavedGame()->getWaypoints()->begin(); i != _game->getSavedGame()->getWaypoints()->end(); i++)
+	if (lon.empty())
+		return 0;
+
+	// Drop the points in the middle of straight edges
+	bool removed = true;
+	while (removed && lon.size() > 3)
 	{
-		if (targetNear((*i), x, y))
+		removed = false;
+		for (size_t i = 0; i < lon.size(); i++)
 		{
-			v.push_back(*i);
+			size_t prev = (i + lon.size() - 1) % lon.size(), next = (i + 1) % lon.size();
+			double cross = (lon[i] - lon[prev]) * (lat[next] - lat[i]) - (lat[i] - lat[prev]) * (lon[next] - lon[i]);
+			if (fabs(cross) < 1e-9)
+			{
+				lon.erase(lon.begin() + i);
+				lat.erase(lat.begin() + i);
+				removed = true;
+				break;
+			}
 		}
 	}
-	return v;
+	if (lon.size() > 4)
+		return 0;
+
+	// Only keep convex results
+	int sign = 0;
+	for (size_t i = 0; i < lon.size(); i++)
+	{
+		size_t prev = (i + lon.size() - 1) % lon.size(), next = (i + 1) % lon.size();
+		double cross = (lon[i] - lon[prev]) * (lat[next] - lat[i]) - (lat[i] - lat[prev]) * (lon[next] - lon[i]);
+		int s = (cross > 0) ? 1 : -1;
+		if (fabs(cross) < 1e-9 || (sign != 0 && s != sign))
+			return 0;
+		sign = s;
+	}
+
+	Polygon *poly = new Polygon(lon.size());
+	for (size_t i = 0; i < lon.size(); i++)
+	{
+		poly->setLongitude(i, lon[i]);
+		poly->setLatitude(i, lat[i]);
+	}
+	poly->setTexture(a->getTexture());
+	return poly;
 }
 
 /**
- * Takes care of pre-calculating all the polygons currently visible
- * on the globe and caching them so they only need to be recalculated
- * when the globe is actually moved.
+ * Returns which set of polygons to draw the land with, using
+ * coarser ones as the globe gets smaller on screen, where the
+ * world polygons would only be a few pixels across.
+ * @return Level of detail, 0 is the original world polygons.
  */
-void Globe::cachePolygons()
+int Globe::getPolygonLod() const
 {
-	cache(_game->getResourcePack()->getPolygons(), &_cacheLand);
-	draw();
+	int lod = 0;
+	for (double radius = _radius[_zoom]; radius < LOD_RADIUS && lod < POLYGON_LODS - 1; radius *= 2)
+	{
+		lod++;
+	}
+	return lod;
 }
 
 /**
- * Caches a set of polygons.
+ * Groups the world polygons by where they are on the globe,
+ * and works out the smallest cap around each group, so whole
+ * groups that can't be seen can be skipped at once.
  * @param polygons Pointer to list of polygons.
+ * @param clusters Pointer to the list of clusters to fill.
+ */
+void Globe::buildClusters(std::list<Polygon*> *polygons, std::vector<PolygonCluster> *clusters)
+{
+	std::vector< std::vector<Polygon*> > cells(CLUSTER_COLUMNS * CLUSTER_ROWS);
+	for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); i++)
+	{
+		double v[3] = {0.0, 0.0, 0.0};
+		for (int j = 0; j < (*i)->getPoints(); j++)
+		{
+			v[0] += (*i)->getVector(j)[0];
+			v[1] += (*i)->getVector(j)[1];
+			v[2] += (*i)->getVector(j)[2];
+		}
+		double lon = atan2(v[0], v[2]) + M_PI;
+		double lat = atan2(v[1], sqrt(v[0] * v[0] + v[2] * v[2])) + M_PI / 2;
+		int col = std::min((int)(lon / (2 * M_PI) * CLUSTER_COLUMNS), CLUSTER_COLUMNS - 1);
+		int row = std::min((int)(lat / M_PI * CLUSTER_ROWS), CLUSTER_ROWS - 1);
+		cells[row * CLUSTER_COLUMNS + col].push_back(*i);
+	}
+
+	clusters->clear();
+	for (std::vector< std::vector<Polygon*> >::iterator i = cells.begin(); i != cells.end(); i++)
+	{
+		if (i->empty())
+			continue;
+
+		PolygonCluster cluster;
+		cluster.polygons = *i;
+		double minDot = getBoundingCap(*i, cluster.center);
+
+		if (minDot > 0.0)
+		{
+			// The cap is entirely behind when its center is further back than its radius,
+			// and it can't project further from its center than the chord of its radius
+			double radius = acos(std::min(minDot, 1.0));
+			cluster.backLimit = -sin(radius);
+			cluster.spread = 2 * sin(radius / 2);
+		}
+		else
+		{
+			// Too big to ever be culled
+			cluster.backLimit = -2.0;
+			cluster.spread = 2.0;
+		}
+		clusters->push_back(cluster);
+	}
+}
+
+/**
+ * Sorts the world polygons into a grid of longitude and
+ * latitude cells, by the area around them, so the land at
+ * a point can be found without going through the whole world.
+ * @param polygons Pointer to list of polygons.
+ */
+void Globe::buildLandIndex(std::list<Polygon*> *polygons)
+{
+	_landIndex.clear();
+	_landIndex.resize(PolarGrid::COLUMNS * PolarGrid::ROWS);
+	double cellLon = PolarGrid::getCellLongitude(), cellLat = PolarGrid::getCellLatitude();
+	for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); i++)
+	{
+		double center[3];
+		double minDot = getBoundingCap(std::vector<Polygon*>(1, *i), center);
+		double radius = (minDot > -1.0) ? acos(std::min(minDot, 1.0)) : M_PI;
+		double lat = asin(std::max(-1.0, std::min(center[1], 1.0)));
+		double lon = atan2(center[0], center[2]);
+
+		// Range of cells the cap covers, every column if it's around a pole
+		int minRow = std::max(0, (int)floor((lat - radius + M_PI / 2) / cellLat));
+		int maxRow = std::min(PolarGrid::ROWS - 1, (int)floor((lat + radius + M_PI / 2) / cellLat));
+		int minCol = 0, maxCol = PolarGrid::COLUMNS - 1;
+		if (fabs(lat) + radius < M_PI / 2)
+		{
+			double spread = asin(std::min(sin(radius) / cos(lat), 1.0));
+			minCol = (int)floor((lon - spread) / cellLon);
+			maxCol = (int)floor((lon + spread) / cellLon);
+		}
+		if (maxCol - minCol >= PolarGrid::COLUMNS)
+		{
+			minCol = 0;
+			maxCol = PolarGrid::COLUMNS - 1;
+		}
+
+		for (int row = minRow; row <= maxRow; row++)
+		{
+			for (int col = minCol; col <= maxCol; col++)
+			{
+				int wrapped = ((col % PolarGrid::COLUMNS) + PolarGrid::COLUMNS) % PolarGrid::COLUMNS;
+				_landIndex[row * PolarGrid::COLUMNS + wrapped].push_back(*i);
+			}
+		}
+	}
+}
+
+/**
+ * Caches the polygons that are in view, skipping whole
+ * clusters that are on the back of the globe or
+ * outside the globe's surface when zoomed in.
+ * @param clusters List of polygon clusters.
  * @param cache Pointer to cache.
  */
-void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
+void Globe::cache(const std::vector<PolygonCluster> &clusters, std::list<Polygon*> *cache)
 {
 	// Clear existing cache
 	for (std::list<Polygon*>::iterator i = cache->begin(); i != cache->end(); i++)
@@ -610,29 +1070,44 @@ void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
 	cache->clear();
 	
 	// Pre-calculate values to cache
-	for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); i++)
+	for (std::vector<PolygonCluster>::const_iterator c = clusters.begin(); c != clusters.end(); c++)
 	{
-		// Is quad on the back face?
-		bool backFace = true;
-		for (int j = 0; j < (*i)->getPoints(); j++)
-		{
-			backFace = backFace && pointBack((*i)->getLongitude(j), (*i)->getLatitude(j));
-		}
-		if (backFace)
+		// Is cluster on the back face?
+		const double *center = c->center;
+		if (_rotation[2][0] * center[0] + _rotation[2][1] * center[1] + _rotation[2][2] * center[2] < c->backLimit)
 			continue;
-		
-		Polygon* p = new Polygon(**i);
 
-		// Convert coordinates
-		for (int j = 0; j < p->getPoints(); j++)
+		// Is cluster outside the surface?
+		double spread = _radius[_zoom] * c->spread;
+		double x = _cenX + _radius[_zoom] * (_rotation[0][0] * center[0] + _rotation[0][1] * center[1] + _rotation[0][2] * center[2]);
+		double y = _cenY + _radius[_zoom] * (_rotation[1][0] * center[0] + _rotation[1][1] * center[1] + _rotation[1][2] * center[2]);
+		if (x + spread < 0 || x - spread > getWidth() || y + spread < 0 || y - spread > getHeight())
+			continue;
+
+		for (std::vector<Polygon*>::const_iterator i = c->polygons.begin(); i != c->polygons.end(); i++)
 		{
-			Sint16 x, y;
-			polarToCart(p->getLongitude(j), p->getLatitude(j), &x, &y);
-			p->setX(j, x);
-			p->setY(j, y);
-		}
+			// Is quad on the back face?
+			bool backFace = true;
+			for (int j = 0; j < (*i)->getPoints(); j++)
+			{
+				backFace = backFace && pointBack((*i)->getVector(j));
+			}
+			if (backFace)
+				continue;
+
+			Polygon* p = new Polygon(**i);
+
+			// Convert coordinates
+			for (int j = 0; j < p->getPoints(); j++)
+			{
+				Sint16 x, y;
+				vectorToCart(p->getVector(j), &x, &y);
+				p->setX(j, x);
+				p->setY(j, y);
+			}
 
-		cache->push_back(p);
+			cache->push_back(p);
+		}
 	}
 }
 
@@ -645,12 +1120,13 @@ void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
 void Globe::setPalette(SDL_Color *colors, int firstcolor, int ncolors)
 {
 	Surface::setPalette(colors, firstcolor, ncolors);
-	for (int shade = 0; shade < NUM_SHADES; shade++)
-	{
-		_texture[shade]->setPalette(colors, firstcolor, ncolors);
-	}
 	_countries->setPalette(colors, firstcolor, ncolors);
 	_markers->setPalette(colors, firstcolor, ncolors);
+	_ocean->setPalette(colors, firstcolor, ncolors);
+	for (std::map<std::pair<std::wstring, Uint8>, Text*>::iterator i = _labels.begin(); i != _labels.end(); i++)
+	{
+		i->second->setPalette(colors, firstcolor, ncolors);
+	}
 	_mkXcomBase->setPalette(colors, firstcolor, ncolors);
 	_mkAlienBase->setPalette(colors, firstcolor, ncolors);
 	_mkCraft->setPalette(colors, firstcolor, ncolors);
@@ -678,20 +1154,11 @@ void Globe::blink()
 {
 	_blink = !_blink;
 
-	int off = 0;
-	if (_blink)
-		off = -1;
-	else
-		off = 1;
-
-	_mkXcomBase->offset(off);
-	_mkAlienBase->offset(off);
-	_mkCraft->offset(off);
-	_mkWaypoint->offset(off);
-	_mkFlyingUfo->offset(off);
-	_mkLandedUfo->offset(off);
-	_mkCrashedUfo->offset(off);
-	_mkAlienSite->offset(off);
+	Surface *blinking[] = {_mkXcomBase, _mkAlienBase, _mkCraft, _mkWaypoint, _mkFlyingUfo, _mkLandedUfo, _mkCrashedUfo, _mkAlienSite};
+	for (int i = 0; i < 8; i++)
+	{
+		blinking[i]->getCrop()->x = _blink ? 0 : 3;
+	}
 
 	drawMarkers();
 }
@@ -718,14 +1185,27 @@ void Globe::rotate()
 }
 
 /**
- * Draws the whole globe, part by part.
+ * Draws the globe, part by part. Each part is kept on its own
+ * surface, so the ocean and land are only redrawn when the view
+ * or the daylight changes and the details when the view changes,
+ * while the markers that move around are redrawn every time.
  */
 void Globe::draw()
 {
-	clear();
-	drawOcean();
-	drawLand();
-	drawDetail();
+	ProfileMarker marker(PROF_GLOBE);
+	int daylight = (int)floor(_game->getSavedGame()->getTime()->getDaylight() * OCEAN_DAYLIGHT_STEPS);
+	if (_landDaylight != daylight)
+	{
+		clear();
+		drawOcean();
+		drawLand();
+		_landDaylight = daylight;
+	}
+	if (_detailDirty)
+	{
+		drawDetail();
+		_detailDirty = false;
+	}
 	drawMarkers();
 }
 
@@ -920,7 +1400,7 @@ void Globe::fillLongitudeSegments(double startLon, double endLon, int colourShif
 			dx[i+polyPointsX.size()] = polyPointsX2.at(polyPointsX2.size()-1-i);
 			dy[i+polyPointsX.size()] = polyPointsY2.at(polyPointsX2.size()-1-i);
 		}
-		drawPolygon(dx, dy, polyPointsX.size()+polyPointsX2.size(), Palette::blockOffset(12) + colourShift);
+		_ocean->drawPolygon(dx, dy, polyPointsX.size()+polyPointsX2.size(), Palette::blockOffset(12) + colourShift);
 	}
 
 	delete[] dx;
@@ -929,24 +1409,38 @@ void Globe::fillLongitudeSegments(double startLon, double endLon, int colourShif
 
 /**
  * Renders the ocean, shading it according to the time of day.
+ * The shades are only worked out again when the zoom, the center
+ * or the daylight (in steps of OCEAN_DAYLIGHT_STEPS a day) changes,
+ * otherwise the last ones are just copied onto the globe.
  */
 void Globe::drawOcean()
 {
-	double curTime = _game->getSavedGame()->getTime()->getDaylight();
-	double dayLon = -curTime * 2*M_PI;
-	double nightLon = dayLon + M_PI;
+	int daylight = (int)floor(_game->getSavedGame()->getTime()->getDaylight() * OCEAN_DAYLIGHT_STEPS);
+	if (_oceanZoom != (int)_zoom || _oceanDaylight != daylight || _oceanLon != _cenLon || _oceanLat != _cenLat)
+	{
+		_oceanZoom = _zoom;
+		_oceanDaylight = daylight;
+		_oceanLon = _cenLon;
+		_oceanLat = _cenLat;
+
+		double curTime = (double)daylight / OCEAN_DAYLIGHT_STEPS;
+		double dayLon = -curTime * 2*M_PI;
+		double nightLon = dayLon + M_PI;
 
-	lock();
+		_ocean->clear();
+		_ocean->lock();
 
-	drawCircle(_cenX, _cenY, (Sint16)floor(_radius[_zoom]), Palette::blockOffset(12)+28);
+		_ocean->drawCircle(_cenX, _cenY, (Sint16)floor(_radius[_zoom]), Palette::blockOffset(12)+28);
 
-	fillLongitudeSegments(dayLon   + QUAD_LONGITUDE, nightLon - QUAD_LONGITUDE, 0);
-	fillLongitudeSegments(dayLon - QUAD_LONGITUDE, dayLon, 16);
-	fillLongitudeSegments(dayLon, dayLon + QUAD_LONGITUDE, 8);
-	fillLongitudeSegments(nightLon - QUAD_LONGITUDE, nightLon, 8);
-	fillLongitudeSegments(nightLon, nightLon + QUAD_LONGITUDE, 16);
+		fillLongitudeSegments(dayLon   + QUAD_LONGITUDE, nightLon - QUAD_LONGITUDE, 0);
+		fillLongitudeSegments(dayLon - QUAD_LONGITUDE, dayLon, 16);
+		fillLongitudeSegments(dayLon, dayLon + QUAD_LONGITUDE, 8);
+		fillLongitudeSegments(nightLon - QUAD_LONGITUDE, nightLon, 8);
+		fillLongitudeSegments(nightLon, nightLon + QUAD_LONGITUDE, 16);
 
-	unlock();
+		_ocean->unlock();
+	}
+	_ocean->blit(this);
 }
 
 /**
@@ -955,50 +1449,63 @@ void Globe::drawOcean()
  */
 void Globe::drawLand()
 {
-	int _shades[] = {3, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3,
-					 4, 5, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 6, 5, 4};
-	double minLon = 100.0, maxLon = -100.0, curTime = _game->getSavedGame()->getTime()->getDaylight();
 	Sint16 x[4], y[4];
-	bool pole;
 
 	for (std::list<Polygon*>::iterator i = _cacheLand.begin(); i != _cacheLand.end(); i++)
 	{
-		minLon = 100.0;
-		maxLon = -100.0;
-		pole = false;
 		// Convert coordinates
 		for (int j = 0; j < (*i)->getPoints(); j++)
 		{
-			double tmpLon = (*i)->getLongitude(j);
-			double tmpLat = (*i)->getLatitude(j);
-
-			if (abs(tmpLat) < (M_PI/2 - 0.0001)) //pole vertexes have no longitude
-			{
-				if (tmpLon < minLon && tmpLon >= (maxLon - M_PI))
-					minLon = tmpLon;
-				if (tmpLon > maxLon && tmpLon <= (minLon + M_PI))
-					maxLon = tmpLon;
-			}
-			else
-			{
-				pole = true;
-			}
-
 			x[j] = (*i)->getX(j);
 			y[j] = (*i)->getY(j);
 		}
 
 		// Apply textures according to zoom and shade
 		int zoom = (2 - (int)floor(_zoom / 2.0)) * NUM_TEXTURES;
-		int shade = (int)((curTime + (((minLon + maxLon) / 2) / (2 * M_PI))) * NUM_LANDSHADES);
-		shade = _shades[shade % NUM_LANDSHADES];
-		if (pole)
+		int shade = getPolygonShade(*i);
+		drawTexturedPolygon(x, y, (*i)->getPoints(), _texture->getFrame((*i)->getTexture() + zoom), 0, 0, _shadeTables[shade]);
+		(*i)->setShade(shade);
+	}
+}
+
+/**
+ * Works out how lit a polygon is by the sun
+ * at the current time of day.
+ * @param poly Pointer to the polygon.
+ * @return Shade.
+ */
+int Globe::getPolygonShade(Polygon *poly) const
+{
+	int _shades[] = {3, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3,
+					 4, 5, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 6, 5, 4};
+	double minLon = 100.0, maxLon = -100.0, curTime = _game->getSavedGame()->getTime()->getDaylight();
+	bool pole = false;
+
+	for (int j = 0; j < poly->getPoints(); j++)
+	{
+		double tmpLon = poly->getLongitude(j);
+		double tmpLat = poly->getLatitude(j);
+
+		if (abs(tmpLat) < (M_PI/2 - 0.0001)) //pole vertexes have no longitude
 		{
-			shade = (int)(shade * 0.6 + 4 * (1 - 0.6)); // twilight zone
+			if (tmpLon < minLon && tmpLon >= (maxLon - M_PI))
+				minLon = tmpLon;
+			if (tmpLon > maxLon && tmpLon <= (minLon + M_PI))
+				maxLon = tmpLon;
+		}
+		else
+		{
+			pole = true;
 		}
-		drawTexturedPolygon(x, y, (*i)->getPoints(), _texture[shade]->getFrame((*i)->getTexture() + zoom), 0, 0);
-		(*i)->setShade(shade);
 	}
+
+	int shade = (int)((curTime + (((minLon + maxLon) / 2) / (2 * M_PI))) * NUM_LANDSHADES);
+	shade = _shades[shade % NUM_LANDSHADES];
+	if (pole)
+	{
+		shade = (int)(shade * 0.6 + 4 * (1 - 0.6)); // twilight zone
+	}
+	return shade;
 }
 
 /**
@@ -1024,12 +1531,12 @@ void Globe::drawDetail()
 			for (int j = 0; j < (*i)->getPoints() - 1; j++)
 			{
 				// Don't draw if polyline is facing back
-				if (pointBack((*i)->getLongitude(j), (*i)->getLatitude(j)) || pointBack((*i)->getLongitude(j + 1), (*i)->getLatitude(j + 1)))
+				if (pointBack((*i)->getVector(j)) || pointBack((*i)->getVector(j + 1)))
 					continue;
 
 				// Convert coordinates
-				polarToCart((*i)->getLongitude(j), (*i)->getLatitude(j), &x[0], &y[0]);
-				polarToCart((*i)->getLongitude(j + 1), (*i)->getLatitude(j + 1), &x[1], &y[1]);
+				vectorToCart((*i)->getVector(j), &x[0], &y[0]);
+				vectorToCart((*i)->getVector(j + 1), &x[1], &y[1]);
 
 				_countries->drawLine(x[0], y[0], x[1], y[1], Palette::blockOffset(10)+2);
 			}
@@ -1039,68 +1546,122 @@ void Globe::drawDetail()
 		_countries->unlock();
 	}
 
+	cacheDetail();
+
 	// Draw the country names
 	if (_zoom >= 2)
 	{
-		Text *label = new Text(80, 9, 0, 0);
-		label->setPalette(getPalette());
-		label->setFonts(_game->getResourcePack()->getFont("BIGLETS.DAT"), _game->getResourcePack()->getFont("SMALLSET.DAT"));
-		label->setAlign(ALIGN_CENTER);
-		label->setColor(Palette::blockOffset(15)-1);
-
 		Sint16 x, y;
-		for (std::vector<Country*>::iterator i = _game->getSavedGame()->getCountries()->begin(); i != _game->getSavedGame()->getCountries()->end(); i++)
+		size_t k = 0;
+		for (std::vector<Country*>::iterator i = _game->getSavedGame()->getCountries()->begin(); i != _game->getSavedGame()->getCountries()->end(); i++, k += 3)
 		{
+			const double *v = &_labelVectors[k];
+
 			// Don't draw if label is facing back
-			if (pointBack((*i)->getRules()->getLabelLongitude(), (*i)->getRules()->getLabelLatitude()))
+			if (pointBack(v))
 				continue;
 
 			// Convert coordinates
-			polarToCart((*i)->getRules()->getLabelLongitude(), (*i)->getRules()->getLabelLatitude(), &x, &y);
+			vectorToCart(v, &x, &y);
 
+			Text *label = getLabel(_game->getLanguage()->getString((*i)->getRules()->getType()), Palette::blockOffset(15)-1);
 			label->setX(x - 40);
 			label->setY(y);
-			label->setText(_game->getLanguage()->getString((*i)->getRules()->getType()));
 			label->blit(_countries);
 		}
-
-		delete label;
 	}
 
 	// Draw the city markers
 	if (_zoom >= 3)
 	{
-		Text *label = new Text(80, 9, 0, 0);
-		label->setPalette(getPalette());
-		label->setFonts(_game->getResourcePack()->getFont("BIGLETS.DAT"), _game->getResourcePack()->getFont("SMALLSET.DAT"));
-		label->setAlign(ALIGN_CENTER);
-		label->setColor(Palette::blockOffset(8)+10);
-
 		Sint16 x, y;
+		size_t k = 0;
 		for (std::vector<Region*>::iterator i = _game->getSavedGame()->getRegions()->begin(); i != _game->getSavedGame()->getRegions()->end(); i++)
 		{
-			for (std::vector<City*>::iterator j = (*i)->getRules()->getCities()->begin(); j != (*i)->getRules()->getCities()->end(); j++)
+			for (std::vector<City*>::iterator j = (*i)->getRules()->getCities()->begin(); j != (*i)->getRules()->getCities()->end(); j++, k += 3)
 			{
+				const double *v = &_cityVectors[k];
+
 				// Don't draw if city is facing back
-				if (pointBack((*j)->getLongitude(), (*j)->getLatitude()))
+				if (pointBack(v))
 					continue;
 
 				// Convert coordinates
-				polarToCart((*j)->getLongitude(), (*j)->getLatitude(), &x, &y);
+				vectorToCart(v, &x, &y);
 
 				_mkCity->setX(x - 1);
 				_mkCity->setY(y - 1);
 				_mkCity->setPalette(getPalette());
 				_mkCity->blit(_countries);
 
+				Text *label = getLabel(_game->getLanguage()->getString((*j)->getName()), Palette::blockOffset(8)+10);
 				label->setX(x - 40);
 				label->setY(y + 2);
-				label->setText(_game->getLanguage()->getString((*j)->getName()));
 				label->blit(_countries);
 			}
 		}
+	}
+}
+
+/**
+ * Returns the label for a country or city name, rendered
+ * the first time it's needed and kept for later, so the
+ * globe only has to blit it wherever the name goes.
+ * @param name Name to show.
+ * @param color Color of the label.
+ * @return Pointer to the label.
+ */
+Text *Globe::getLabel(const std::wstring &name, Uint8 color)
+{
+	std::pair<std::wstring, Uint8> key = std::make_pair(name, color);
+	std::map<std::pair<std::wstring, Uint8>, Text*>::iterator i = _labels.find(key);
+	if (i != _labels.end())
+		return i->second;
+
+	Text *label = new Text(80, 9, 0, 0);
+	label->setPalette(getPalette());
+	label->setFonts(_game->getResourcePack()->getFont("BIGLETS.DAT"), _game->getResourcePack()->getFont("SMALLSET.DAT"));
+	label->setAlign(ALIGN_CENTER);
+	label->setColor(color);
+	label->setText(name);
+	_labels[key] = label;
+	return label;
+}
 
-		delete label;
+/**
+ * Works out the unit vectors of the country labels and
+ * cities once, since they never move. The countries and
+ * regions of a game don't change while the globe is shown.
+ */
+void Globe::cacheDetail()
+{
+	std::vector<Country*> *countries = _game->getSavedGame()->getCountries();
+	if (_labelVectors.size() != countries->size() * 3)
+	{
+		_labelVectors.resize(countries->size() * 3);
+		for (size_t i = 0; i < countries->size(); i++)
+		{
+			polarToVector(countries->at(i)->getRules()->getLabelLongitude(), countries->at(i)->getRules()->getLabelLatitude(), &_labelVectors[i * 3]);
+		}
+	}
+
+	size_t cities = 0;
+	for (std::vector<Region*>::iterator i = _game->getSavedGame()->getRegions()->begin(); i != _game->getSavedGame()->getRegions()->end(); i++)
+	{
+		cities += (*i)->getRules()->getCities()->size();
+	}
+	if (_cityVectors.size() != cities * 3)
+	{
+		_cityVectors.clear();
+		for (std::vector<Region*>::iterator i = _game->getSavedGame()->getRegions()->begin(); i != _game->getSavedGame()->getRegions()->end(); i++)
+		{
+			for (std::vector<City*>::iterator j = (*i)->getRules()->getCities()->begin(); j != (*i)->getRules()->getCities()->end(); j++)
+			{
+				double v[3];
+				polarToVector((*j)->getLongitude(), (*j)->getLatitude(), v);
+				_cityVectors.insert(_cityVectors.end(), v, v + 3);
+			}
+		}
 	}
 }
 
@@ -1111,16 +1672,50 @@ void Globe::drawDetail()
 void Globe::drawMarkers()
 {
 	Sint16 x, y;
+	double v[3];
 	_markers->clear();
 
+	// Fill the picking grid with the same targets getTargets used to go through
+	for (std::vector< std::vector<TargetMark> >::iterator i = _targetCells.begin(); i != _targetCells.end(); i++)
+	{
+		i->clear();
+	}
+	_targetMarks = 0;
+	for (std::vector<Base*>::iterator i = _game->getSavedGame()->getBases()->begin(); i != _game->getSavedGame()->getBases()->end(); i++)
+	{
+		if ((*i)->getLongitude() == 0.0 && (*i)->getLatitude() == 0.0)
+			continue;
+
+		addTargetMark(*i, true);
+		for (std::vector<Craft*>::iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end(); j++)
+		{
+			if ((*j)->getLongitude() == (*i)->getLongitude() && (*j)->getLatitude() == (*i)->getLatitude() && (*j)->getDestination() == 0)
+				continue;
+
+			addTargetMark(*j, true);
+		}
+	}
+	for (std::vector<Ufo*>::iterator i = _game->getSavedGame()->getUfos()->begin(); i != _game->getSavedGame()->getUfos()->end(); i++)
+	{
+		if ((*i)->getDetected())
+		{
+			addTargetMark(*i, false);
+		}
+	}
+	for (std::vector<Waypoint*>::iterator i = _game->getSavedGame()->getWaypoints()->begin(); i != _game->getSavedGame()->getWaypoints()->end(); i++)
+	{
+		addTargetMark(*i, false);
+	}
+
 	// Draw the base markers
 	for (std::vector<Base*>::iterator i = _game->getSavedGame()->getBases()->begin(); i != _game->getSavedGame()->getBases()->end(); i++)
 	{
 		// Cheap hack to hide bases when they haven't been placed yet
+		polarToVector((*i)->getLongitude(), (*i)->getLatitude(), v);
 		if (((*i)->getLongitude() != 0.0 || (*i)->getLatitude() != 0.0) &&
-			!pointBack((*i)->getLongitude(), (*i)->getLatitude()))
+			!pointBack(v))
 		{
-			polarToCart((*i)->getLongitude(), (*i)->getLatitude(), &x, &y);
+			vectorToCart(v, &x, &y);
 
 			_mkXcomBase->setX(x - 1);
 			_mkXcomBase->setY(y - 1);
@@ -1130,10 +1725,13 @@ void Globe::drawMarkers()
 		for (std::vector<Craft*>::iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end(); j++)
 		{
 			// Hide crafts docked at base
-			if ((*j)->getStatus() != "STR_OUT" || pointBack((*j)->getLongitude(), (*j)->getLatitude()))
+			if ((*j)->getStatus() != CRAFT_OUT)
+				continue;
+			polarToVector((*j)->getLongitude(), (*j)->getLatitude(), v);
+			if (pointBack(v))
 				continue;
 
-			polarToCart((*j)->getLongitude(), (*j)->getLatitude(), &x, &y);
+			vectorToCart(v, &x, &y);
 
 			_mkCraft->setX(x - 1);
 			_mkCraft->setY(y - 1);
@@ -1144,10 +1742,11 @@ void Globe::drawMarkers()
 	// Draw the UFO markers
 	for (std::vector<Ufo*>::iterator i = _game->getSavedGame()->getUfos()->begin(); i != _game->getSavedGame()->getUfos()->end(); i++)
 	{
-		if (pointBack((*i)->getLongitude(), (*i)->getLatitude()))
+		polarToVector((*i)->getLongitude(), (*i)->getLatitude(), v);
+		if (pointBack(v))
 			continue;
 
-		polarToCart((*i)->getLongitude(), (*i)->getLatitude(), &x, &y);
+		vectorToCart(v, &x, &y);
 
 		if ((*i)->getDetected())
 		{
@@ -1169,10 +1768,11 @@ void Globe::drawMarkers()
 	// Draw the waypoint markers
 	for (std::vector<Waypoint*>::iterator i = _game->getSavedGame()->getWaypoints()->begin(); i != _game->getSavedGame()->getWaypoints()->end(); i++)
 	{
-		if (pointBack((*i)->getLongitude(), (*i)->getLatitude()))
+		polarToVector((*i)->getLongitude(), (*i)->getLatitude(), v);
+		if (pointBack(v))
 			continue;
 
-		polarToCart((*i)->getLongitude(), (*i)->getLatitude(), &x, &y);
+		vectorToCart(v, &x, &y);
 
 		_mkWaypoint->setX(x - 1);
 		_mkWaypoint->setY(y - 1);
@@ -1276,15 +1876,15 @@ void Globe::keyboardPress(Action *action, State *state)
  */
 void Globe::getPolygonTextureAndShade(double lon, double lat, int *texture, int *shade)
 {
-	*texture = -1;
-	for (std::list<Polygon*>::iterator i = _cacheLand.begin(); i != _cacheLand.end(); i++)
+	Polygon *poly = getLandPolygon(lon, lat);
+	if (poly == 0)
 	{
-		if(insidePolygon(lon, lat, *i))
-		{
-			*texture = ((Polygon*)(*i))->getTexture();
-			*shade = ((Polygon*)(*i))->getShade();
-			return;
-		}
+		*texture = -1;
+	}
+	else
+	{
+		*texture = poly->getTexture();
+		*shade = getPolygonShade(poly);
 	}
 }
 
@@ -21,18 +21,22 @@
 
 #include <vector>
 #include <list>
+#include <map>
+#include <string>
 #include "../Engine/InteractiveSurface.h"
 
 namespace OpenXcom
 {
 
 #define NUM_SHADES 8
+#define POLYGON_LODS 3
 
 class Game;
 class Polygon;
 class SurfaceSet;
 class Timer;
 class Target;
+class Text;
 
 /**
  * Interactive globe view of the world.
@@ -43,29 +47,85 @@ class Target;
 class Globe : public InteractiveSurface
 {
 private:
+	/// A group of world polygons close together, bounded by a cap on the globe.
+	struct PolygonCluster
+	{
+		double center[3];
+		double backLimit, spread;
+		std::vector<Polygon*> polygons;
+	};
+	std::list<Polygon*> _lodPolygons[POLYGON_LODS - 1];
+	std::vector<PolygonCluster> _clusters[POLYGON_LODS];
+	std::vector< std::vector<Polygon*> > _landIndex;
 	std::vector<double> _radius;
 	double _cenLon, _cenLat, _rotLon, _rotLat;
+	double _rotation[3][3];
+	std::vector<double> _labelVectors, _cityVectors;
 	Sint16 _cenX, _cenY;
 	unsigned int _zoom;
-	SurfaceSet *_texture[NUM_SHADES];
+	SurfaceSet *_texture;
+	Uint8 _shadeTables[NUM_SHADES][256];
 	Game *_game;
-	Surface *_markers, *_countries;
+	Surface *_markers, *_countries, *_ocean;
+	int _oceanZoom, _oceanDaylight, _landDaylight;
+	bool _detailDirty;
+	std::map<std::pair<std::wstring, Uint8>, Text*> _labels;
+	/// A target that can be picked on the globe, where it was last drawn.
+	struct TargetMark
+	{
+		Target *target;
+		Sint16 x, y;
+		bool base;
+		size_t order;
+	};
+	static bool targetMarkLess(const TargetMark &a, const TargetMark &b);
+	std::vector< std::vector<TargetMark> > _targetCells;
+	int _targetColumns, _targetMarks;
+	double _oceanLon, _oceanLat;
 	bool _blink, _detail;
 	Timer *_blinkTimer, *_rotTimer;
 	std::list<Polygon*> _cacheLand;
 	Surface *_mkXcomBase, *_mkAlienBase, *_mkCraft, *_mkWaypoint, *_mkCity;
 	Surface *_mkFlyingUfo, *_mkLandedUfo, *_mkCrashedUfo, *_mkAlienSite;
 
+	/// Converts polar coordinates to a unit vector.
+	static void polarToVector(double lon, double lat, double *v);
+	/// Converts a unit vector to cartesian coordinates.
+	void vectorToCart(const double *v, Sint16 *x, Sint16 *y) const;
 	/// Checks if a point is behind the globe.
 	bool pointBack(double lon, double lat) const;
+	/// Checks if a unit vector is behind the globe.
+	bool pointBack(const double *v) const;
+	/// Updates the rotation of the globe.
+	void updateRotation();
+	/// Caches the unit vectors of the country labels and cities.
+	void cacheDetail();
+	/// Gets the rendered label for a name.
+	Text *getLabel(const std::wstring &name, Uint8 color);
 	/// Return latitude of last visible to player point on given longitude.
 	double lastVisibleLat(double lon) const;
 	/// Checks if a point is inside a polygon.
-	bool insidePolygon(double lon, double lat, Polygon *poly) const;
-	/// Checks if a target is near a point.
-	bool targetNear(Target* target, int x, int y) const;
-	/// Caches a set of polygons.
-	void cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache);
+	static bool insidePolygon(const double *v, Polygon *poly);
+	/// Gets the land polygon at a point.
+	Polygon *getLandPolygon(double lon, double lat) const;
+	/// Adds a target to the picking grid.
+	void addTargetMark(Target *target, bool base);
+	/// Works out the smallest cap around a set of polygons.
+	static double getBoundingCap(const std::vector<Polygon*> &polygons, double *center);
+	/// Merges neighbouring polygons into a coarser set.
+	static void mergePolygons(std::list<Polygon*> *polygons, std::list<Polygon*> *merged);
+	/// Merges two neighbouring polygons into one.
+	static Polygon *mergePolygon(Polygon *a, Polygon *b);
+	/// Gets the level of detail of the polygons at the current zoom.
+	int getPolygonLod() const;
+	/// Groups the world polygons into clusters.
+	static void buildClusters(std::list<Polygon*> *polygons, std::vector<PolygonCluster> *clusters);
+	/// Indexes the world polygons by longitude and latitude.
+	void buildLandIndex(std::list<Polygon*> *polygons);
+	/// Caches the polygons of a set of clusters.
+	void cache(const std::vector<PolygonCluster> &clusters, std::list<Polygon*> *cache);
+	/// Gets the shade of a polygon at the current time of day.
+	int getPolygonShade(Polygon *poly) const;
 	/// Fills the ocean longitude segments.
 	void fillLongitudeSegments(double startLon, double endLon, int colourShift);
 public:
@@ -117,7 +177,7 @@ public:
 	void blink();
 	/// Rotates the globe.
 	void rotate();
-	/// Draws the whole globe.
+	/// Draws the parts of the globe that changed.
 	void draw();
 	/// Draws the ocean of the globe.
 	void drawOcean();
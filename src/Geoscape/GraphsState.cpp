@@ -17,15 +17,25 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "GraphsState.h"
+#include <algorithm>
 #include "../Engine/Game.h"
 #include "../Resource/ResourcePack.h"
 #include "../Engine/Palette.h"
 #include "../Engine/Surface.h"
 #include "../Engine/InteractiveSurface.h"
+#include "../Savegame/SavedGame.h"
+#include "../Savegame/Country.h"
+#include "../Savegame/Region.h"
+#include "../Savegame/MonthlyHistory.h"
 
 namespace OpenXcom
 {
 
+#define GRAPH_X 125
+#define GRAPH_Y 49
+#define GRAPH_WIDTH 190
+#define GRAPH_HEIGHT 128
+
 /**
  * Initializes all the elements in the Graphs screen.
  * @param game Pointer to the core game.
@@ -34,26 +44,205 @@ GraphsState::GraphsState(Game *game) : State(game)
 {
 	// Create objects
 	_bg = new Surface(320, 200, 0, 0);
+	_graph = new Surface(320, 200, 0, 0);
+	_btnUfoRegion = new InteractiveSurface(32, 24, 96, 0);
+	_btnUfoCountry = new InteractiveSurface(32, 24, 128, 0);
+	_btnXcomRegion = new InteractiveSurface(32, 24, 160, 0);
+	_btnXcomCountry = new InteractiveSurface(32, 24, 192, 0);
+	_btnIncome = new InteractiveSurface(32, 24, 224, 0);
+	_btnFinance = new InteractiveSurface(32, 24, 256, 0);
 	_btnGeoscape = new InteractiveSurface(32, 24, 288, 0);
+	for (int i = 0; i < GRAPH_MODES; i++)
+	{
+		_layers[i] = 0;
+	}
 	
 	// Set palette
 	_game->setPalette(_game->getResourcePack()->getPalette("PALETTES.DAT_2")->getColors());
 
 	add(_bg);
+	add(_graph);
+	add(_btnUfoRegion);
+	add(_btnUfoCountry);
+	add(_btnXcomRegion);
+	add(_btnXcomCountry);
+	add(_btnIncome);
+	add(_btnFinance);
 	add(_btnGeoscape);
 
 	// Set up objects
 	_game->getResourcePack()->getSurface("GRAPHS.SPK")->blit(_bg);
 
+	_btnUfoRegion->onMouseClick((ActionHandler)&GraphsState::btnUfoRegionClick);
+	_btnUfoCountry->onMouseClick((ActionHandler)&GraphsState::btnUfoCountryClick);
+	_btnXcomRegion->onMouseClick((ActionHandler)&GraphsState::btnXcomRegionClick);
+	_btnXcomCountry->onMouseClick((ActionHandler)&GraphsState::btnXcomCountryClick);
+	_btnIncome->onMouseClick((ActionHandler)&GraphsState::btnIncomeClick);
+	_btnFinance->onMouseClick((ActionHandler)&GraphsState::btnFinanceClick);
 	_btnGeoscape->onMouseClick((ActionHandler)&GraphsState::btnGeoscapeClick);
+
+	showGraph(GRAPH_UFO_REGION);
 }
 
 /**
- *
+ * Deletes the drawn graphs.
  */
 GraphsState::~GraphsState()
 {
-	
+	for (int i = 0; i < GRAPH_MODES; i++)
+	{
+		delete _layers[i];
+	}
+}
+
+/**
+ * Gathers the monthly histories that make up the lines of a graph.
+ * @param mode Graph to show.
+ * @param lines Vector to fill with the histories.
+ */
+void GraphsState::getLines(GraphMode mode, std::vector<const MonthlyHistory*> *lines)
+{
+	SavedGame *save = _game->getSavedGame();
+	switch (mode)
+	{
+	case GRAPH_UFO_REGION:
+	case GRAPH_XCOM_REGION:
+		for (std::vector<Region*>::iterator i = save->getRegions()->begin(); i != save->getRegions()->end(); i++)
+		{
+			lines->push_back(mode == GRAPH_UFO_REGION ? &(*i)->getAlienHistory() : &(*i)->getXcomHistory());
+		}
+		break;
+	case GRAPH_UFO_COUNTRY:
+	case GRAPH_XCOM_COUNTRY:
+	case GRAPH_INCOME:
+		for (std::vector<Country*>::iterator i = save->getCountries()->begin(); i != save->getCountries()->end(); i++)
+		{
+			if (mode == GRAPH_UFO_COUNTRY)
+				lines->push_back(&(*i)->getAlienHistory());
+			else if (mode == GRAPH_XCOM_COUNTRY)
+				lines->push_back(&(*i)->getXcomHistory());
+			else
+				lines->push_back(&(*i)->getFundingHistory());
+		}
+		break;
+	case GRAPH_FINANCE:
+		lines->push_back(&save->getFundsHistory());
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Draws the lines of a graph, one per history, scaled to
+ * fit all of them. The latest month is always on the right.
+ * @param mode Graph to draw.
+ * @param layer Surface to draw the lines on.
+ */
+void GraphsState::drawLayer(GraphMode mode, Surface *layer)
+{
+	std::vector<const MonthlyHistory*> lines;
+	getLines(mode, &lines);
+
+	double min = 0, max = 0;
+	for (std::vector<const MonthlyHistory*>::iterator i = lines.begin(); i != lines.end(); i++)
+	{
+		for (int m = 0; m < (*i)->size(); m++)
+		{
+			min = std::min(min, (double)(*i)->get(m));
+			max = std::max(max, (double)(*i)->get(m));
+		}
+	}
+	double range = (max > min) ? max - min : 1;
+
+	layer->lock();
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		const MonthlyHistory *line = lines[i];
+		Uint8 color = Palette::blockOffset((i % 14) + 1) + 4;
+		int offset = MonthlyHistory::MONTHS - line->size();
+		for (int m = 1; m < line->size(); m++)
+		{
+			Sint16 x1 = GRAPH_X + (offset + m - 1) * GRAPH_WIDTH / (MonthlyHistory::MONTHS - 1);
+			Sint16 x2 = GRAPH_X + (offset + m) * GRAPH_WIDTH / (MonthlyHistory::MONTHS - 1);
+			Sint16 y1 = (Sint16)(GRAPH_Y + GRAPH_HEIGHT - (line->get(m - 1) - min) * GRAPH_HEIGHT / range);
+			Sint16 y2 = (Sint16)(GRAPH_Y + GRAPH_HEIGHT - (line->get(m) - min) * GRAPH_HEIGHT / range);
+			layer->drawLine(x1, y1, x2, y2, color);
+		}
+	}
+	layer->unlock();
+}
+
+/**
+ * Shows one of the graphs. Each graph is only drawn the first
+ * time it's shown, since the history can't change while the
+ * screen is up, so switching graphs is just a blit.
+ * @param mode Graph to show.
+ */
+void GraphsState::showGraph(GraphMode mode)
+{
+	if (_layers[mode] == 0)
+	{
+		_layers[mode] = new Surface(_graph->getWidth(), _graph->getHeight());
+		_layers[mode]->setPalette(_graph->getPalette());
+		drawLayer(mode, _layers[mode]);
+	}
+	_graph->clear();
+	_layers[mode]->blit(_graph);
+}
+
+/**
+ * Shows the alien activity in each region.
+ * @param action Pointer to an action.
+ */
+void GraphsState::btnUfoRegionClick(Action *action)
+{
+	showGraph(GRAPH_UFO_REGION);
+}
+
+/**
+ * Shows the alien activity in each country.
+ * @param action Pointer to an action.
+ */
+void GraphsState::btnUfoCountryClick(Action *action)
+{
+	showGraph(GRAPH_UFO_COUNTRY);
+}
+
+/**
+ * Shows the X-Com activity in each region.
+ * @param action Pointer to an action.
+ */
+void GraphsState::btnXcomRegionClick(Action *action)
+{
+	showGraph(GRAPH_XCOM_REGION);
+}
+
+/**
+ * Shows the X-Com activity in each country.
+ * @param action Pointer to an action.
+ */
+void GraphsState::btnXcomCountryClick(Action *action)
+{
+	showGraph(GRAPH_XCOM_COUNTRY);
+}
+
+/**
+ * Shows the funding from each country.
+ * @param action Pointer to an action.
+ */
+void GraphsState::btnIncomeClick(Action *action)
+{
+	showGraph(GRAPH_INCOME);
+}
+
+/**
+ * Shows the player's funds.
+ * @param action Pointer to an action.
+ */
+void GraphsState::btnFinanceClick(Action *action)
+{
+	showGraph(GRAPH_FINANCE);
 }
 
 /**
@@ -19,13 +19,17 @@
 #ifndef OPENXCOM_GRAPHSSTATE_H
 #define OPENXCOM_GRAPHSSTATE_H
 
+#include <vector>
 #include "../Engine/State.h"
 
 namespace OpenXcom
 {
 
+enum GraphMode { GRAPH_UFO_REGION, GRAPH_UFO_COUNTRY, GRAPH_XCOM_REGION, GRAPH_XCOM_COUNTRY, GRAPH_INCOME, GRAPH_FINANCE, GRAPH_MODES };
+
 class Surface;
 class InteractiveSurface;
+class MonthlyHistory;
 
 /**
  * Graphs screen for displaying graphs of various
@@ -34,13 +38,32 @@ class InteractiveSurface;
 class GraphsState : public State
 {
 private:
-	Surface *_bg;
-	InteractiveSurface *_btnGeoscape;
+	Surface *_bg, *_graph;
+	InteractiveSurface *_btnUfoRegion, *_btnUfoCountry, *_btnXcomRegion, *_btnXcomCountry, *_btnIncome, *_btnFinance, *_btnGeoscape;
+	Surface *_layers[GRAPH_MODES];
+	/// Gets the histories shown in a graph.
+	void getLines(GraphMode mode, std::vector<const MonthlyHistory*> *lines);
+	/// Draws the lines of a graph.
+	void drawLayer(GraphMode mode, Surface *layer);
+	/// Shows a graph.
+	void showGraph(GraphMode mode);
 public:
 	/// Creates the Graphs state.
 	GraphsState(Game *game);
 	/// Cleans up the Graphs state.
 	~GraphsState();
+	/// Handler for clicking the UFO Region Activity icon.
+	void btnUfoRegionClick(Action *action);
+	/// Handler for clicking the UFO Country Activity icon.
+	void btnUfoCountryClick(Action *action);
+	/// Handler for clicking the XCom Region Activity icon.
+	void btnXcomRegionClick(Action *action);
+	/// Handler for clicking the XCom Country Activity icon.
+	void btnXcomCountryClick(Action *action);
+	/// Handler for clicking the Income icon.
+	void btnIncomeClick(Action *action);
+	/// Handler for clicking the Finance icon.
+	void btnFinanceClick(Action *action);
 	/// Handler for clicking the Geoscape icon.
 	void btnGeoscapeClick(Action *action);
 };
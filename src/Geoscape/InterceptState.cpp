@@ -101,7 +101,27 @@ InterceptState::InterceptState(Game *game, Globe *globe, Base *base) : State(gam
 	_lstCrafts->setBackground(_window);
 	_lstCrafts->setMargin(6);
 	_lstCrafts->onMouseClick((ActionHandler)&InterceptState::lstCraftsClick);
+}
+
+/**
+ *
+ */
+InterceptState::~InterceptState()
+{
+	
+}
 
+/**
+ * Updates the palette and fills the list with
+ * the crafts as they are right now, since the
+ * window can be reused after it's closed.
+ */
+void InterceptState::init()
+{
+	_game->setPalette(_game->getResourcePack()->getPalette("BACKPALS.DAT")->getColors(Palette::blockOffset(4)), Palette::backPos, 16);
+
+	_crafts.clear();
+	_lstCrafts->clearList();
 	int row = 0;
 	for (std::vector<Base*>::iterator i = _game->getSavedGame()->getBases()->begin(); i != _game->getSavedGame()->getBases()->end(); i++)
 	{
@@ -137,8 +157,8 @@ InterceptState::InterceptState(Game *game, Globe *globe, Base *base) : State(gam
 				ss << (*j)->getNumHWPs();
 			}
 			_crafts.push_back(*j);
-			_lstCrafts->addRow(4, (*j)->getName(_game->getLanguage()).c_str(), _game->getLanguage()->getString((*j)->getStatus()).c_str(), (*i)->getName().c_str(), ss.str().c_str());
-			if ((*j)->getStatus() == "STR_READY")
+			_lstCrafts->addRow(4, (*j)->getName(_game->getLanguage()).c_str(), _game->getLanguage()->getString((*j)->getStatusString()).c_str(), (*i)->getName().c_str(), ss.str().c_str());
+			if ((*j)->getStatus() == CRAFT_READY)
 			{
 				_lstCrafts->getCell(row, 1)->setColor(Palette::blockOffset(8)+10);
 			}
@@ -149,11 +169,13 @@ InterceptState::InterceptState(Game *game, Globe *globe, Base *base) : State(gam
 }
 
 /**
- *
+ * Only the window listing all crafts is reused,
+ * the ones for a single base are built each time.
+ * @return Reusable?
  */
-InterceptState::~InterceptState()
+bool InterceptState::isReusable() const
 {
-	
+	return _base == 0;
 }
 
 /**
@@ -172,7 +194,7 @@ void InterceptState::btnCancelClick(Action *action)
 void InterceptState::lstCraftsClick(Action *action)
 {
 	Craft* c = _crafts[_lstCrafts->getSelectedRow()];
-	if (c->getStatus() == "STR_READY")
+	if (c->getStatus() == CRAFT_READY)
 	{
 		_game->popState();
 		_game->pushState(new SelectDestinationState(_game, c, _globe));
@@ -52,6 +52,10 @@ public:
 	InterceptState(Game *game, Globe *globe, Base *base = 0);
 	/// Cleans up the Intercept state.
 	~InterceptState();
+	/// Updates the crafts list.
+	void init();
+	/// Checks if the window can be reused.
+	bool isReusable() const;
 	/// Handler for clicking the Cancel button.
 	void btnCancelClick(Action *action);
 	/// Handler for clicking the Crafts list.
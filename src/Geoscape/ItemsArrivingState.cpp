@@ -102,7 +102,7 @@ ItemsArrivingState::ItemsArrivingState(Game *game, GeoscapeState *state) : State
 	{
 		for (std::vector<Transfer*>::iterator j = (*i)->getTransfers()->begin(); j != (*i)->getTransfers()->end();)
 		{
-			if ((*j)->getHours() == 0)
+			if ((*j)->isDelivered())
 			{
 				std::wstringstream ss;
 				ss << (*j)->getQuantity();
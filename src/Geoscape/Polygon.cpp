@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Polygon.h"
+#include <cmath>
 
 namespace OpenXcom
 {
@@ -29,12 +30,14 @@ Polygon::Polygon(int points) : _points(points), _texture(0), _shade(0)
 {
 	_lat = new double[_points];
 	_lon = new double[_points];
+	_vec = new double[_points * 3];
 	_x = new Sint16[_points];
 	_y = new Sint16[_points];
 	for (int i = 0; i < _points; i++)
 	{
 		_lat[i] = 0.0;
 		_lon[i] = 0.0;
+		updateVector(i);
 		_x[i] = 0;
 		_y[i] = 0;
 	}
@@ -49,12 +52,16 @@ Polygon::Polygon(const Polygon& other)
 	_points = other._points;
 	_lat = new double[_points];
 	_lon = new double[_points];
+	_vec = new double[_points * 3];
 	_x = new Sint16[_points];
 	_y = new Sint16[_points];
 	for (int i = 0; i < _points; i++)
 	{
 		_lat[i] = other._lat[i];
 		_lon[i] = other._lon[i];
+		_vec[i * 3] = other._vec[i * 3];
+		_vec[i * 3 + 1] = other._vec[i * 3 + 1];
+		_vec[i * 3 + 2] = other._vec[i * 3 + 2];
 		_x[i] = other._x[i];
 		_y[i] = other._y[i];
 	}
@@ -69,6 +76,7 @@ Polygon::~Polygon()
 {
 	delete[] _lat;
 	delete[] _lon;
+	delete[] _vec;
 	delete[] _x;
 	delete[] _y;
 }
@@ -91,6 +99,7 @@ double Polygon::getLatitude(int i) const
 void Polygon::setLatitude(int i, double lat)
 {
 	_lat[i] = lat;
+	updateVector(i);
 }
 
 /**
@@ -111,6 +120,31 @@ double Polygon::getLongitude(int i) const
 void Polygon::setLongitude(int i, double lon)
 {
 	_lon[i] = lon;
+	updateVector(i);
+}
+
+/**
+ * Recalculates the unit vector pointing from the center
+ * of the world to a given point, so the globe can rotate
+ * it without working out the trigonometry every time.
+ * @param i Point number (0-max).
+ */
+void Polygon::updateVector(int i)
+{
+	_vec[i * 3] = cos(_lat[i]) * sin(_lon[i]);
+	_vec[i * 3 + 1] = sin(_lat[i]);
+	_vec[i * 3 + 2] = cos(_lat[i]) * cos(_lon[i]);
+}
+
+/**
+ * Returns the unit vector of a given point
+ * (X towards longitude 90, Y towards latitude 90, Z towards longitude 0).
+ * @param i Point number (0-max).
+ * @return Pointer to the point's X, Y and Z.
+ */
+const double *Polygon::getVector(int i) const
+{
+	return &_vec[i * 3];
 }
 
 /**
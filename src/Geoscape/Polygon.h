@@ -32,11 +32,13 @@ namespace OpenXcom
 class Polygon
 {
 private:
-	double *_lat, *_lon;
+	double *_lat, *_lon, *_vec;
 	Sint16 *_x, *_y;
 	int _points;
 	int _texture;
 	int _shade;
+	/// Updates the unit vector of a point.
+	void updateVector(int i);
 public:
 	/// Creates a polygon with a number of points.
 	Polygon(int points);
@@ -52,6 +54,8 @@ public:
 	double getLongitude(int i) const;
 	/// Sets the longitude of a point.
 	void setLongitude(int i, double lon);
+	/// Gets the unit vector of a point.
+	const double *getVector(int i) const;
 	/// Gets the X coordinate of a point.
 	Sint16 getX(int i) const;
 	/// Sets the X coordinate of a point.
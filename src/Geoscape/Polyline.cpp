@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Polyline.h"
+#include <cmath>
 
 namespace OpenXcom
 {
@@ -29,6 +30,13 @@ Polyline::Polyline(int points) : _points(points)
 {
 	_lat = new double[points];
 	_lon = new double[points];
+	_vec = new double[points * 3];
+	for (int i = 0; i < points; i++)
+	{
+		_lat[i] = 0.0;
+		_lon[i] = 0.0;
+		updateVector(i);
+	}
 }
 
 /**
@@ -38,6 +46,7 @@ Polyline::~Polyline()
 {
 	delete[] _lat;
 	delete[] _lon;
+	delete[] _vec;
 }
 
 /**
@@ -58,6 +67,7 @@ double Polyline::getLatitude(int i) const
 void Polyline::setLatitude(int i, double lat)
 {
 	_lat[i] = lat;
+	updateVector(i);
 }
 
 /**
@@ -78,6 +88,31 @@ double Polyline::getLongitude(int i) const
 void Polyline::setLongitude(int i, double lon)
 {
 	_lon[i] = lon;
+	updateVector(i);
+}
+
+/**
+ * Recalculates the unit vector pointing from the center
+ * of the world to a given point, so the globe can rotate
+ * it without working out the trigonometry every time.
+ * @param i Point number (0-max).
+ */
+void Polyline::updateVector(int i)
+{
+	_vec[i * 3] = cos(_lat[i]) * sin(_lon[i]);
+	_vec[i * 3 + 1] = sin(_lat[i]);
+	_vec[i * 3 + 2] = cos(_lat[i]) * cos(_lon[i]);
+}
+
+/**
+ * Returns the unit vector of a given point
+ * (X towards longitude 90, Y towards latitude 90, Z towards longitude 0).
+ * @param i Point number (0-max).
+ * @return Pointer to the point's X, Y and Z.
+ */
+const double *Polyline::getVector(int i) const
+{
+	return &_vec[i * 3];
 }
 
 /**
@@ -30,8 +30,10 @@ namespace OpenXcom
 class Polyline
 {
 private:
-	double *_lat, *_lon;
+	double *_lat, *_lon, *_vec;
 	const int _points;
+	/// Updates the unit vector of a point.
+	void updateVector(int i);
 public:
 	/// Creates a polyline with a number of points.
 	Polyline(int points);
@@ -45,6 +47,8 @@ public:
 	double getLongitude(int i) const;
 	/// Sets the longitude of a point.
 	void setLongitude(int i, double lon);
+	/// Gets the unit vector of a point.
+	const double *getVector(int i) const;
 	/// Gets the number of points of the polyline.
 	int getPoints() const;
 };
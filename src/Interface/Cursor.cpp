@@ -18,6 +18,8 @@
  */
 #include "Cursor.h"
 #include <cmath>
+#include <vector>
+#include <algorithm>
 #include "SDL.h"
 #include "../Engine/Action.h"
 
@@ -34,17 +36,20 @@ namespace OpenXcom
  * @param x X position in pixels.
  * @param y Y position in pixels.
  */
-Cursor::Cursor(int width, int height, int x, int y) : Surface(width, height, x, y), _color(0)
+Cursor::Cursor(int width, int height, int x, int y) : Surface(width, height, x, y), _color(0), _hardware(0), _scale(1)
 {
 	SDL_ShowCursor(SDL_DISABLE);
 }
 
 /**
- *
+ * Frees the system cursor, if there is one.
  */
 Cursor::~Cursor()
 {
-	
+	if (_hardware != 0)
+	{
+		SDL_FreeCursor(_hardware);
+	}
 }
 
 /**
@@ -101,6 +106,97 @@ void Cursor::draw()
 	}
 	this->setPixel(4, 8, --color);
 	unlock();
+
+	if (_hardware != 0)
+	{
+		createHardware();
+	}
+}
+
+/**
+ * Turns the cursor graphic into a system cursor, so the
+ * mouse can move without the screen being drawn again.
+ * System cursors only have black and white, so the darker
+ * shades of the cursor become black and the rest white.
+ * If the system can't make the cursor, it stays as it was.
+ */
+void Cursor::createHardware()
+{
+	int width = (getWidth() * _scale + 7) / 8 * 8;
+	int height = getHeight() * _scale;
+	std::vector<Uint8> data(width / 8 * height, 0), mask(width / 8 * height, 0);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < getWidth() * _scale; x++)
+		{
+			Uint8 pixel = getPixel(x / _scale, y / _scale);
+			if (pixel == 0)
+				continue;
+			int byte = y * width / 8 + x / 8;
+			Uint8 bit = 0x80 >> (x % 8);
+			mask[byte] |= bit;
+			if (pixel >= _color + 2)
+			{
+				data[byte] |= bit;
+			}
+		}
+	}
+
+	SDL_Cursor *cursor = SDL_CreateCursor(&data[0], &mask[0], width, height, 0, 0);
+	if (cursor == 0)
+		return;
+	SDL_SetCursor(cursor);
+	if (_hardware != 0)
+	{
+		SDL_FreeCursor(_hardware);
+	}
+	_hardware = cursor;
+	SDL_ShowCursor(SDL_ENABLE);
+}
+
+/**
+ * Changes whether the cursor is drawn by the system instead
+ * of being blitted on the screen every frame. The system
+ * cursor isn't scaled with the screen, so it's made bigger
+ * by a whole factor instead.
+ * @param hardware True for a system cursor.
+ * @param scale Times to enlarge the system cursor (1-2).
+ */
+void Cursor::setHardware(bool hardware, int scale)
+{
+	_scale = std::max(1, std::min(scale, 2));
+	if (hardware)
+	{
+		createHardware();
+	}
+	else if (_hardware != 0)
+	{
+		SDL_ShowCursor(SDL_DISABLE);
+		SDL_FreeCursor(_hardware);
+		_hardware = 0;
+	}
+}
+
+/**
+ * Returns whether the cursor is drawn by the system.
+ * @return True if it's a system cursor.
+ */
+bool Cursor::isHardware() const
+{
+	return _hardware != 0;
+}
+
+/**
+ * Blits the cursor onto another surface, unless the
+ * system is drawing it already.
+ * @param surface Pointer to surface to blit onto.
+ */
+void Cursor::blit(Surface *surface)
+{
+	if (_hardware == 0)
+	{
+		Surface::blit(surface);
+	}
 }
 
 }
@@ -35,7 +35,9 @@ class Cursor : public Surface
 {
 private:
 	Uint8 _color;
-
+	SDL_Cursor *_hardware;
+	int _scale;
+	void createHardware();
 public:
 	/// Creates a new cursor with the specified size and position.
 	Cursor(int width, int height, int x = 0, int y = 0);
@@ -49,6 +51,12 @@ public:
 	Uint8 getColor() const;
 	/// Draws the cursor.
 	void draw();
+	/// Sets whether the cursor is drawn by the system.
+	void setHardware(bool hardware, int scale = 1);
+	/// Gets whether the cursor is drawn by the system.
+	bool isHardware() const;
+	/// Blits the cursor onto another surface.
+	void blit(Surface *surface);
 };
 
 }
@@ -89,11 +89,18 @@ void FpsCounter::handle(Action *action)
 }
 
 /**
- * Advances frame counter.
+ * Advances frame counter, once for every frame rendered.
  */
-void FpsCounter::think()
+void FpsCounter::addFrame()
 {
 	_frames++;
+}
+
+/**
+ * Advances the update timer.
+ */
+void FpsCounter::think()
+{
 	_timer->think(0, this);
 }
 
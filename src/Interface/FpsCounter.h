@@ -51,6 +51,8 @@ public:
 	/// Handles keyboard events.
 	void handle(Action *action);
 	/// Advances frame counter.
+	void addFrame();
+	/// Advances the update timer.
 	void think();
 	// Updates FPS counter.
 	void update();
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ProfilerOverlay.h"
+#include <cstdio>
+#include <iostream>
+#include "../Engine/Palette.h"
+#include "../Engine/Action.h"
+#include "../Engine/Timer.h"
+#include "../Engine/Profiler.h"
+#include "../Engine/Exception.h"
+#include "../Savegame/SavedGame.h"
+
+#define GRAPH_SCALE 2
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a profiler overlay of the specified size.
+ * The graph takes one column per profiled frame on the right,
+ * the section times go on the left.
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @param x X position in pixels.
+ * @param y Y position in pixels.
+ */
+ProfilerOverlay::ProfilerOverlay(int width, int height, int x, int y) : Surface(width, height, x, y), _showMemory(false)
+{
+	_visible = false;
+
+	_timer = new Timer(250);
+	_timer->onTimer((SurfaceHandler)&ProfilerOverlay::draw);
+	_timer->start();
+}
+
+/**
+ * Deletes the update timer.
+ */
+ProfilerOverlay::~ProfilerOverlay()
+{
+	delete _timer;
+}
+
+/**
+ * Switches the overlay from hidden to the timings to the
+ * memory in use, turning the profiler on while it's shown,
+ * and saves the profiled frames on request.
+ * @param action Pointer to an action.
+ */
+void ProfilerOverlay::handle(Action *action)
+{
+	if (action->getDetails()->type == SDL_KEYDOWN && action->getDetails()->key.keysym.sym == SDLK_F6)
+	{
+		if (!_visible)
+		{
+			_visible = true;
+		}
+		else if (!_showMemory)
+		{
+			_showMemory = true;
+		}
+		else
+		{
+			_visible = false;
+			_showMemory = false;
+		}
+		Profiler::setEnabled(_visible);
+		draw();
+	}
+	else if (action->getDetails()->type == SDL_KEYDOWN && action->getDetails()->key.keysym.sym == SDLK_F7 && Profiler::isEnabled())
+	{
+		try
+		{
+			Profiler::save(USER_DIR "profile.csv");
+		}
+		catch (Exception &e)
+		{
+			std::cerr << "ERROR: " << e.what() << std::endl;
+		}
+	}
+}
+
+/**
+ * Advances the update timer while the overlay is shown.
+ */
+void ProfilerOverlay::think()
+{
+	if (_visible)
+	{
+		_timer->think(0, this);
+	}
+}
+
+/**
+ * Draws the average milliseconds of every section, the
+ * frame sections tinted like their bars on the graph, and
+ * the frame times stacked by section, with a line at 60 FPS.
+ */
+void ProfilerOverlay::draw()
+{
+	clear();
+	if (_showMemory)
+	{
+		drawMemory();
+		return;
+	}
+	int graphX = getWidth() - PROFILE_FRAMES;
+	for (int i = 0; i < PROF_SECTIONS; i++)
+	{
+		char s[32];
+		sprintf(s, "%-8s%5.1f", Profiler::getName((ProfileSection)i), Profiler::getAverageTime((ProfileSection)i) / 1000);
+		Uint8 color = (i < PROF_FRAME_SECTIONS) ? Palette::blockOffset(i + 1) + 4 : Palette::blockOffset(15) + 12;
+		drawString(0, i * 8, s, color);
+	}
+	for (int i = 0; i < PROFILE_FRAMES - 1; i++)
+	{
+		int x = getWidth() - 1 - i;
+		int y = getHeight();
+		for (int j = 0; j < PROF_FRAME_SECTIONS && y > 0; j++)
+		{
+			int h = (int)(Profiler::getFrameTime(i, (ProfileSection)j) / 1000 * GRAPH_SCALE);
+			if (h > y)
+				h = y;
+			if (h > 0)
+			{
+				drawLine(x, y - 1, x, y - h, Palette::blockOffset(j + 1) + 4);
+			}
+			y -= h;
+		}
+	}
+	int target = getHeight() - 1000 / 60 * GRAPH_SCALE;
+	drawLine(graphX, target, getWidth() - 1, target, Palette::blockOffset(15) + 12);
+}
+
+/**
+ * Draws the kilobytes counted for every memory tag,
+ * and their total.
+ */
+void ProfilerOverlay::drawMemory()
+{
+	long total = 0;
+	for (int i = 0; i < MEM_TAGS; i++)
+	{
+		char s[32];
+		sprintf(s, "%-8s%7ldK", Profiler::getMemoryName((MemoryTag)i), Profiler::getMemory((MemoryTag)i) / 1024);
+		drawString(0, i * 8, s, Palette::blockOffset(15) + 12);
+		total += Profiler::getMemory((MemoryTag)i);
+	}
+	char s[32];
+	sprintf(s, "%-8s%7ldK", "total", total / 1024);
+	drawString(0, MEM_TAGS * 8, s, Palette::blockOffset(1) + 4);
+}
+
+}
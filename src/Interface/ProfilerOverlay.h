@@ -0,0 +1,59 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_PROFILEROVERLAY_H
+#define OPENXCOM_PROFILEROVERLAY_H
+
+#include "../Engine/Surface.h"
+
+namespace OpenXcom
+{
+
+class Timer;
+class Action;
+
+/**
+ * Shows the time spent in each profiled section
+ * and a graph of the last frames, alongside the
+ * FPS counter, or the memory counted for each
+ * tag. F6 switches between them and off, and F7
+ * saves the frames to a CSV file.
+ */
+class ProfilerOverlay : public Surface
+{
+private:
+	Timer *_timer;
+	bool _showMemory;
+	/// Draws the memory in use.
+	void drawMemory();
+public:
+	/// Creates a new profiler overlay.
+	ProfilerOverlay(int width, int height, int x, int y);
+	/// Cleans up the profiler overlay.
+	~ProfilerOverlay();
+	/// Handles keyboard events.
+	void handle(Action *action);
+	/// Advances the update timer.
+	void think();
+	/// Draws the profiler overlay.
+	void draw();
+};
+
+}
+
+#endif
@@ -23,6 +23,24 @@
 namespace OpenXcom
 {
 
+std::map<Text::LayoutKey, Text::Layout> Text::_layouts;
+
+/**
+ * Orders layout keys, so they can be looked up in a map.
+ * @param other Key to compare to.
+ * @return True if this key comes first.
+ */
+bool Text::LayoutKey::operator<(const LayoutKey &other) const
+{
+	if (font != other.font)
+		return font < other.font;
+	if (small != other.small)
+		return small < other.small;
+	if (width != other.width)
+		return width < other.width;
+	return text < other.text;
+}
+
 /**
  * Sets up a blank text with the specified size and position.
  * @param width Width in pixels.
@@ -110,6 +128,11 @@ void Text::setFonts(Font *big, Font *small)
  */
 void Text::setText(const std::wstring &text)
 {
+	// lists often set the same text again, and it's already drawn
+	if (text == _text && !_lineHeight.empty())
+	{
+		return;
+	}
 	_text = text;
 	processText();
 }
@@ -190,8 +213,11 @@ void Text::setVerticalAlign(TextVAlign valign)
  */
 void Text::setColor(Uint8 color)
 {
-	_color = color;
-	draw();
+	if (color != _color)
+	{
+		_color = color;
+		draw();
+	}
 }
 
 /**
@@ -211,8 +237,11 @@ Uint8 Text::getColor() const
  */
 void Text::setSecondaryColor(Uint8 color)
 {
-	_color2 = color;
-	draw();
+	if (color != _color2)
+	{
+		_color2 = color;
+		draw();
+	}
 }
 
 /**
@@ -258,6 +287,8 @@ int Text::getTextWidth() const
 /**
  * Takes care of any text post-processing like calculating
  * line metrics for alignment and wordwrapping if necessary.
+ * The results are kept for every text, font and width, since
+ * the same strings keep coming back in lists and buttons.
  */
 void Text::processText()
 {
@@ -266,6 +297,21 @@ void Text::processText()
 		return;
 	}
 
+	LayoutKey key;
+	key.text = _text;
+	key.font = _font;
+	key.small = _small;
+	key.width = _wrap ? getWidth() : -1;
+	std::map<LayoutKey, Layout>::iterator cached = _layouts.find(key);
+	if (cached != _layouts.end())
+	{
+		_wrappedText = cached->second.wrappedText;
+		_lineWidth = cached->second.lineWidth;
+		_lineHeight = cached->second.lineHeight;
+		draw();
+		return;
+	}
+
 	std::wstring *s = &_text;
 
 	// Use a separate string for wordwrapping text
@@ -310,8 +356,9 @@ void Text::processText()
 		// Keep track of the width of the last line and word
 		else if (*c != 1)
 		{
-			width += font->getChar(*c)->getCrop()->w + font->getSpacing();
-			word += font->getChar(*c)->getCrop()->w + font->getSpacing();
+			int charWidth = font->getChar(*c).w + font->getSpacing();
+			width += charWidth;
+			word += charWidth;
 
 			// Wordwrap if the last word doesn't fit the line
 			if (_wrap && width > getWidth())
@@ -324,12 +371,25 @@ void Text::processText()
 		}
 	}
 
+	if (_layouts.size() >= MAX_TEXT_LAYOUTS)
+	{
+		_layouts.clear();
+	}
+	Layout &layout = _layouts[key];
+	layout.wrappedText = _wrappedText;
+	layout.lineWidth = _lineWidth;
+	layout.lineHeight = _lineHeight;
+
 	draw();
 }
 
 /**
  * Draws all the characters in the text with a really
  * nasty complex gritty text rendering algorithm logic stuff.
+ * Each character goes straight from the font onto the text,
+ * colored through a remap table on the way. The high contrast
+ * and invert effects are part of the table too, so the text
+ * doesn't need another pass once it's drawn.
  */
 void Text::draw()
 {
@@ -342,9 +402,29 @@ void Text::draw()
 
 	int x = 0, y = 0, line = 0, height = 0;
 	Font *font = _font;
-	Uint8 color = _color;
 	std::wstring *s = &_text;
 
+	// fonts are greyscale, coloring them is just offsetting every pixel
+	Uint8 colors[2][256];
+	for (int i = 0; i < 256; i++)
+	{
+		colors[0][i] = i + _color;
+		colors[1][i] = i + _color2;
+		for (int j = 0; j < 2; j++)
+		{
+			// same as Surface::multiply and Surface::invert, which leave blank pixels alone
+			if (_contrast)
+			{
+				colors[j][i] *= 3;
+			}
+			if (_invert && colors[j][i] != 0)
+			{
+				colors[j][i] += 2 * (_color + 3 - colors[j][i]);
+			}
+		}
+	}
+	int color = 0;
+
 	for (std::vector<int>::iterator i = _lineHeight.begin(); i != _lineHeight.end(); i++)
 	{
 		height += *i;
@@ -411,27 +491,14 @@ void Text::draw()
 		}
 		else if (*c == 1)
 		{
-			color = (color == _color ? _color2 : _color);
+			color = 1 - color;
 		}
 		else
 		{
-			Surface* chr = font->getChar(*c);
-			Surface letter = Surface(chr->getCrop()->w, chr->getCrop()->h, x, y);
-			letter.setPalette(getPalette());
-			chr->blit(&letter);
-			letter.offset(color);
-			letter.blit(this);
-			x += chr->getCrop()->w + font->getSpacing();
+			font->drawChar(*c, this, x, y, colors[color]);
+			x += font->getChar(*c).w + font->getSpacing();
 		}
 	}
-	if (_contrast)
-	{
-		this->multiply(3);
-	}
-	if (_invert)
-	{
-		this->invert(_color + 3);
-	}
 }
 
 }
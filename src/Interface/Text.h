@@ -22,6 +22,7 @@
 #include "../Engine/Surface.h"
 #include <vector>
 #include <string>
+#include <map>
 
 namespace OpenXcom
 {
@@ -31,6 +32,8 @@ class Font;
 enum TextHAlign { ALIGN_LEFT, ALIGN_CENTER, ALIGN_RIGHT };
 enum TextVAlign { ALIGN_TOP, ALIGN_MIDDLE, ALIGN_BOTTOM };
 
+#define MAX_TEXT_LAYOUTS 1024
+
 /**
  * Text string displayed on screen.
  * Takes the characters from a Font and puts them together on screen
@@ -47,6 +50,21 @@ private:
 	TextHAlign _align;
 	TextVAlign _valign;
 	Uint8 _color, _color2;
+	/// What the line breaks and metrics of a text depend on.
+	struct LayoutKey
+	{
+		std::wstring text;
+		Font *font, *small;
+		int width;
+		bool operator<(const LayoutKey &other) const;
+	};
+	/// Line breaks and metrics of a text.
+	struct Layout
+	{
+		std::wstring wrappedText;
+		std::vector<int> lineWidth, lineHeight;
+	};
+	static std::map<LayoutKey, Layout> _layouts;
 
 	/// Processes the contained text.
 	void processText();
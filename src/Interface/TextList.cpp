@@ -19,6 +19,7 @@
 #include "TextList.h"
 #include <cstdarg>
 #include <cmath>
+#include <algorithm>
 #include "../Engine/Action.h"
 #include "../Engine/Font.h"
 #include "../Engine/Palette.h"
@@ -95,14 +96,16 @@ void TextList::unpress(State *state)
  * @param col Column number.
  * @return Pointer to the requested Text.
  */
-Text *const TextList::getCell(int row, int col) const
+Text *const TextList::getCell(int row, int col)
 {
+	buildRow(row);
 	return _texts[row][col];
 }
 
 /**
- * Adds a new row of text to the list, automatically creating
- * the required Text objects lined up where they need to be.
+ * Adds a new row of text to the list. The Text objects for it
+ * are only created once the row is shown or one of its cells
+ * is asked for, so long lists don't need a surface per cell.
  * @param cols Number of columns.
  * @param ... Text for each cell in the new row.
  */
@@ -110,52 +113,35 @@ void TextList::addRow(int cols, ...)
 {
 	va_list args;
 	va_start(args, cols);
-	std::vector<Text*> temp;
+	RowData row;
+	row.font = _font;
+	row.color = _color;
+	row.color2 = _color2;
+	row.align = _align;
+	row.dot = _dot;
 	int rowX = 0;
 
 	for (int i = 0; i < cols; i++)
 	{
-		// Place text
-		Text* txt = new Text(_columns[i], _font->getHeight(), _margin + rowX, getY());
-		txt->setPalette(this->getPalette());
-		txt->setFonts(_big, _small);
-		txt->setColor(_color);
-		txt->setSecondaryColor(_color2);
-		txt->setAlign(_align);
-		if (_font == _big)
-		{
-			txt->setBig();
-		}
-		else
-		{
-			txt->setSmall();
-		}
-		txt->setText(va_arg(args, wchar_t*));
-
-		// Places dots between text
-		if (_dot && i < cols - 1)
-		{
-			std::wstring buf = txt->getText();
-			int w = txt->getTextWidth();
-			while (w < _columns[i])
-			{
-				w += _font->getChar('.')->getCrop()->w + _font->getSpacing();
-				buf += '.';
-			}
-			txt->setText(buf);
-		}
+		row.cells.push_back(va_arg(args, wchar_t*));
+		row.x.push_back(_margin + rowX);
+		row.width.push_back(_columns[i]);
+		rowX += _columns[i];
+	}
+	_texts.push_back(std::vector<Text*>());
+	_rows.push_back(row);
 
-		temp.push_back(txt);
-		if (_condensed)
-		{
-			rowX += txt->getTextWidth();
-		}
-		else
+	// condensed cells are placed by the width of the text before them, so they have to be made now
+	if (_condensed)
+	{
+		rowX = 0;
+		buildRow(_rows.size() - 1);
+		for (std::vector<Text*>::iterator i = _texts.back().begin(); i != _texts.back().end(); i++)
 		{
-			rowX += _columns[i];
+			(*i)->setX(_margin + rowX);
+			rowX += (*i)->getTextWidth();
 		}
 	}
-	_texts.push_back(temp);
 
 	// Place arrow buttons
 	if (_arrowPos != -1)
@@ -192,6 +178,54 @@ void TextList::addRow(int cols, ...)
 	updateArrows();
 }
 
+/**
+ * Creates the Text objects for a row of the list,
+ * lined up where they need to be, if they don't exist yet.
+ * @param row Row number.
+ */
+void TextList::buildRow(unsigned int row)
+{
+	if (!_texts[row].empty())
+		return;
+
+	RowData &data = _rows[row];
+	for (size_t i = 0; i < data.cells.size(); i++)
+	{
+		// Place text
+		Text* txt = new Text(data.width[i], data.font->getHeight(), data.x[i], getY());
+		txt->setPalette(this->getPalette());
+		txt->setFonts(_big, _small);
+		txt->setColor(data.color);
+		txt->setSecondaryColor(data.color2);
+		txt->setAlign(data.align);
+		if (data.font == _big)
+		{
+			txt->setBig();
+		}
+		else
+		{
+			txt->setSmall();
+		}
+		txt->setText(data.cells[i]);
+
+		// Places dots between text
+		if (data.dot && i < data.cells.size() - 1)
+		{
+			std::wstring buf = txt->getText();
+			int w = txt->getTextWidth();
+			while (w < data.width[i])
+			{
+				w += data.font->getChar('.').w + data.font->getSpacing();
+				buf += '.';
+			}
+			txt->setText(buf);
+		}
+
+		_texts[row].push_back(txt);
+	}
+	data.cells.clear();
+}
+
 /**
  * Changes the columns that the list contains.
  * While rows can be unlimited, columns need to be specified
@@ -523,6 +557,7 @@ void TextList::clearList()
 		u->clear();
 	}
 	_texts.clear();
+	_rows.clear();
 }
 
 /**
@@ -569,6 +604,7 @@ void TextList::draw()
 	clear();
 	for (unsigned int i = _scroll; i < _texts.size() && i < _scroll + _visibleRows; i++)
 	{
+		buildRow(i);
 		for (std::vector<Text*>::iterator j = _texts[i].begin(); j < _texts[i].end(); j++)
 		{
 			(*j)->setY((i - _scroll) * (_font->getHeight() + _font->getSpacing()));
@@ -625,6 +661,31 @@ void TextList::handle(Action *action, State *state)
 	}
 }
 
+/**
+ * Returns the area of the screen the text list and
+ * all its arrow buttons take mouse events in.
+ * @return Area in unscaled screen pixels.
+ */
+SDL_Rect TextList::getEventArea() const
+{
+	int x1 = getX(), y1 = getY(), x2 = getX() + getWidth(), y2 = getY() + getHeight();
+	x1 = std::min(x1, std::min(_up->getX(), _down->getX()));
+	y1 = std::min(y1, _up->getY());
+	x2 = std::max(x2, std::max(_up->getX() + _up->getWidth(), _down->getX() + _down->getWidth()));
+	y2 = std::max(y2, _down->getY() + _down->getHeight());
+	if (!_arrowLeft.empty())
+	{
+		x1 = std::min(x1, std::min(_arrowLeft.front()->getX(), _arrowRight.front()->getX()));
+		x2 = std::max(x2, std::max(_arrowLeft.front()->getX() + _arrowLeft.front()->getWidth(), _arrowRight.front()->getX() + _arrowRight.front()->getWidth()));
+	}
+	SDL_Rect area;
+	area.x = x1;
+	area.y = y1;
+	area.w = x2 - x1;
+	area.h = y2 - y1;
+	return area;
+}
+
 /**
  * Passes ticks to arrow buttons.
  */
@@ -20,6 +20,7 @@
 #define OPENXCOM_TEXTLIST_H
 
 #include <vector>
+#include <string>
 #include "../Engine/InteractiveSurface.h"
 #include "Text.h"
 
@@ -41,6 +42,17 @@ class TextList : public InteractiveSurface
 {
 private:
 	std::vector< std::vector<Text*> > _texts;
+	/// Contents and settings of a row whose cells haven't been made yet.
+	struct RowData
+	{
+		std::vector<std::wstring> cells;
+		std::vector<int> x, width;
+		Font *font;
+		Uint8 color, color2;
+		TextHAlign align;
+		bool dot;
+	};
+	std::vector<RowData> _rows;
 	std::vector<int> _columns;
 	Font *_big, *_small, *_font;
 	unsigned int _scroll, _visibleRows;
@@ -58,6 +70,8 @@ private:
 
 	/// Updates the arrow buttons.
 	void updateArrows();
+	/// Makes the cells of a row.
+	void buildRow(unsigned int row);
 public:
 	/// Creates a text list with the specified size and position.
 	TextList(int width, int height, int x = 0, int y = 0);
@@ -66,7 +80,7 @@ public:
 	/// Unpresses the surface.
 	void unpress(State *state);
 	/// Gets a certain cell in the text list.
-	Text *const getCell(int row, int col) const;
+	Text *const getCell(int row, int col);
 	/// Adds a new row to the text list.
 	void addRow(int cols, ...);
 	/// Sets the columns in the text list.
@@ -131,6 +145,8 @@ public:
 	void think();
 	/// Handles arrow buttons.
 	void handle(Action *action, State *state);
+	/// Gets the area the text list and its arrows take mouse events in.
+	SDL_Rect getEventArea() const;
 	/// Special handling for mouse presses.
 	void mousePress(Action *action, State *state);
 	/// Special handling for mouse releases.
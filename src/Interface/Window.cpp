@@ -21,6 +21,7 @@
 #include "../Engine/Timer.h"
 #include "../Engine/Sound.h"
 #include "../Engine/RNG.h"
+#include "../Engine/SurfacePool.h"
 
 #define POPUP_SPEED 0.075
 
@@ -38,7 +39,7 @@ Sound *Window::soundPopup[3] = {0, 0, 0};
  * @param y Y position in pixels.
  * @param popup Popup animation.
  */
-Window::Window(State *state, int width, int height, int x, int y, WindowPopup popup) : Surface(width, height, x, y), _bg(0), _color(0), _popup(popup), _popupStep(0.0), _state(state)
+Window::Window(State *state, int width, int height, int x, int y, WindowPopup popup) : Surface(width, height, x, y), _bg(0), _color(0), _popup(popup), _popupStep(0.0), _state(state), _frame(0), _redraw(true)
 {
 	_timer = new Timer(10);
 	_timer->onTimer((SurfaceHandler)&Window::popup);
@@ -54,11 +55,12 @@ Window::Window(State *state, int width, int height, int x, int y, WindowPopup po
 }
 
 /**
- * Deletes timers.
+ * Deletes timers and the popup frame.
  */
 Window::~Window()
 {
 	delete _timer;
+	SurfacePool::release(_frame);
 }
 
 /**
@@ -75,7 +77,9 @@ void Window::setBackground(Surface *bg)
 	}
 
 	_bg = bg;
-	draw();
+	_redraw = true;
+	if (_popupStep >= 1.0)
+		draw();
 }
 
 /**
@@ -92,7 +96,9 @@ void Window::setColor(Uint8 color)
 	}
 
 	_color = color;
-	draw();
+	_redraw = true;
+	if (_popupStep >= 1.0)
+		draw();
 }
 
 /**
@@ -119,7 +125,7 @@ void Window::popup()
 {
 	if (_popupStep == 0.0)
 	{
-		int sound = RNG::generate(0, 2);
+		int sound = RNG::generate(0, 2, RNG_COSMETIC);
 		if (soundPopup[sound] != 0)
 			soundPopup[sound]->play();
 	}
@@ -134,47 +140,35 @@ void Window::popup()
 				(*i)->show();
 		_popupStep = 1.0;
 		_timer->stop();
+		SurfacePool::release(_frame);
+		_frame = 0;
 	}
 	draw();
 }
 
 /**
- * Draws the bordered window with a graphic background.
+ * Draws the bordered window with a graphic background
+ * at its full size on a surface.
  * The background never moves with the window, it's
  * always aligned to the top-left corner of the screen
  * and cropped to fit the inside area.
+ * @param surface Pointer to surface to draw on.
  */
-void Window::draw()
+void Window::drawFrame(Surface *surface)
 {
 	SDL_Rect square;
 	Uint8 color = _color;
-	
-	clear();
-	
-	if (_popup == POPUP_HORIZONTAL || _popup == POPUP_BOTH)
-	{
-		square.x = (int)((getWidth() - getWidth() * _popupStep) / 2);
-		square.w = (int)(getWidth() * _popupStep);
-	}
-	else
-	{
-		square.x = 0;
-		square.w = getWidth();
-	}
-	if (_popup == POPUP_VERTICAL || _popup == POPUP_BOTH)
-	{
-		square.y = (int)((getHeight() - getHeight() * _popupStep) / 2);
-		square.h = (int)(getHeight() * _popupStep);
-	}
-	else
-	{
-		square.y = 0;
-		square.h = getHeight();
-	}
+
+	surface->clear();
+
+	square.x = 0;
+	square.y = 0;
+	square.w = getWidth();
+	square.h = getHeight();
 
 	for (int i = 0; i < 5; i++)
 	{
-		drawRect(&square, color);
+		surface->drawRect(&square, color);
 		if (i < 2)
 			color--;
 		else
@@ -191,7 +185,7 @@ void Window::draw()
 		else
 			square.h = 1;
 	}
-		
+
 	if (_bg != 0)
 	{
 		_bg->getCrop()->x = getX() + square.x;
@@ -200,7 +194,64 @@ void Window::draw()
 		_bg->getCrop()->h = square.h;
 		_bg->setX(square.x);
 		_bg->setY(square.y);
-		_bg->blit(this);
+		_bg->blit(surface);
+	}
+}
+
+/**
+ * Draws the window. While it's popping up, the finished
+ * window is only drawn once, and each step of the animation
+ * is just a growing part of it copied over.
+ */
+void Window::draw()
+{
+	if (_popupStep >= 1.0)
+	{
+		drawFrame(this);
+		return;
+	}
+
+	if (_frame == 0)
+	{
+		_frame = SurfacePool::acquire(getWidth(), getHeight());
+		_redraw = true;
+	}
+	_frame->setPalette(getPalette());
+	if (_redraw)
+	{
+		drawFrame(_frame);
+		_redraw = false;
+	}
+
+	SDL_Rect square;
+	if (_popup == POPUP_HORIZONTAL || _popup == POPUP_BOTH)
+	{
+		square.x = (int)((getWidth() - getWidth() * _popupStep) / 2);
+		square.w = (int)(getWidth() * _popupStep);
+	}
+	else
+	{
+		square.x = 0;
+		square.w = getWidth();
+	}
+	if (_popup == POPUP_VERTICAL || _popup == POPUP_BOTH)
+	{
+		square.y = (int)((getHeight() - getHeight() * _popupStep) / 2);
+		square.h = (int)(getHeight() * _popupStep);
+	}
+	else
+	{
+		square.y = 0;
+		square.h = getHeight();
+	}
+
+	clear();
+	if (square.w > 0 && square.h > 0)
+	{
+		*_frame->getCrop() = square;
+		_frame->setX(square.x);
+		_frame->setY(square.y);
+		_frame->blit(this);
 	}
 }
 
@@ -48,6 +48,10 @@ private:
 	double _popupStep;
 	Timer *_timer;
 	State *_state;
+	Surface *_frame;
+	bool _redraw;
+	/// Draws the finished window on a surface.
+	void drawFrame(Surface *surface);
 public:
 	static Sound *soundPopup[3];
 	/// Creates a new window with the specified size and position
@@ -64,7 +68,7 @@ public:
 	void think();
 	/// Popups the window.
 	void popup();
-	/// Draws the window.
+	/// Draws the window, or a step of its popup animation.
 	void draw();
 };
 
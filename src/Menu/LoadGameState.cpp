@@ -20,6 +20,7 @@
 #include <iostream>
 #include "yaml.h"
 #include "../Savegame/SavedGame.h"
+#include "../Savegame/SavedBattleGame.h"
 #include "../Engine/Game.h"
 #include "../Engine/Exception.h"
 #include "../Resource/ResourcePack.h"
@@ -129,6 +130,7 @@ void LoadGameState::lstSavesClick(Action *action)
 {
 	try
 	{
+		SavedGame::waitSaves();
 		_game->setRuleset(new XcomRuleset());
 		SavedGame *s = new SavedGame(DIFF_BEGINNER);
 		s->load(Language::wstrToUtf8(_lstSaves->getCell(_lstSaves->getSelectedRow(), 0)->getText()), _game->getRuleset());
@@ -139,6 +141,7 @@ void LoadGameState::lstSavesClick(Action *action)
 		}
 		else
 		{
+			_game->getSavedGame()->getBattleGame()->loadMap(_game->getResourcePack());
 			_game->setState(new BattlescapeState(_game));
 		}
 	}
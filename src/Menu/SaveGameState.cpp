@@ -162,6 +162,7 @@ void SaveGameState::edtSaveKeyPress(Action *action)
 	{
 		try
 		{
+			SavedGame::waitSaves();
 			if (_selected != "")
 			{
 				std::string oldName = USER_DIR + _selected + ".sav";
@@ -171,7 +172,7 @@ void SaveGameState::edtSaveKeyPress(Action *action)
 					throw Exception("Failed to overwrite save");
 				}
 			}
-			_game->getSavedGame()->save(Language::wstrToUtf8(_edtSave->getText()));
+			_game->getSavedGame()->saveBackground(Language::wstrToUtf8(_edtSave->getText()), saveDone, _game);
 		}
 		catch (Exception &e)
 		{
@@ -187,4 +188,20 @@ void SaveGameState::edtSaveKeyPress(Action *action)
 	}
 }
 
+/**
+ * Reports a save that failed while being written
+ * in the background, after this screen is gone.
+ * @param game Pointer to the core game.
+ * @param error Error message, empty if the save worked.
+ */
+void SaveGameState::saveDone(void *game, const std::string &error)
+{
+	if (!error.empty())
+	{
+		Game *g = (Game*)game;
+		std::cerr << "ERROR: " << error << std::endl;
+		g->pushState(new GeoscapeErrorState(g, "STR_SAVE_UNSUCCESSFUL"));
+	}
+}
+
 }
@@ -44,6 +44,7 @@ private:
 	TextList *_lstSaves;
 	TextEdit *_edtSave;
 	std::string _selected;
+	static void saveDone(void *game, const std::string &error);
 public:
 	/// Creates the Save Game state.
 	SaveGameState(Game *game);
@@ -17,12 +17,15 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "ResourcePack.h"
-#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+#include "../dirent.h"
 #include "../Engine/Palette.h"
 #include "../Engine/Font.h"
 #include "../Engine/Surface.h"
 #include "../Engine/SurfaceSet.h"
 #include "../Engine/Music.h"
+#include "../Engine/GMCat.h"
 #include "../Geoscape/Globe.h"
 #include "../Geoscape/Polygon.h"
 #include "../Geoscape/Polyline.h"
@@ -31,12 +34,19 @@
 namespace OpenXcom
 {
 
+#define LOFT_ALIGNMENT 32
+
+std::map<std::string, std::map<std::string, std::string> > ResourcePack::_folderEntries;
+SDL_mutex *ResourcePack::_folderMutex = SDL_CreateMutex();
+
 /**
  * Initializes a blank resource set pointing to a folder.
  * @param folder Subfolder to load resources from.
  */
-ResourcePack::ResourcePack(const std::string &folder) : _folder(folder), _palettes(), _fonts(), _surfaces(), _sets(), _polygons(), _musics()
+ResourcePack::ResourcePack(const std::string &folder) : _folder(folder), _palettes(), _fonts(), _surfaces(), _sets(), _polygons(), _musics(), _voxelData(), _loftBuffer(0), _lofts(0), _lazySurfaces(), _lazySets(), _cachedSurfaces(), _lazyMusics()
 {
+	memset(_palette.colors, 0, sizeof(_palette.colors));
+	_palette.version = 1;
 }
 
 /**
@@ -76,55 +86,90 @@ ResourcePack::~ResourcePack()
 	{
 		delete i->second;
 	}
+	delete[] _loftBuffer;
 }
 
 /**
  * Takes a filename and tries to figure out the existing
  * case-insensitive filename for it, for file operations.
+ * Every folder of the path after the DATA folder (or only the
+ * file itself, if there's none) is matched in any case against
+ * the folder's entries, which are only read once.
+ * Files can be looked up from any thread.
  * @param filename Original filename.
  * @return Correctly-cased filename or "" if it doesn't exist.
- * @note There's no actual method for figuring out the correct
- * filename on case-sensitive systems, this is just a workaround.
  */
 std::string ResourcePack::insensitive(const std::string &filename)
 {
-	std::string newName = filename;
-
 	// Ignore DATA folder
-	size_t i = newName.find("/DATA/");
+	size_t i = filename.find("/DATA/");
 	if (i != std::string::npos)
 		i += 6;
 	else
-		i = 0;
+		i = filename.rfind('/') + 1;
 
-	// Try lowercase and uppercase names
-	struct stat info;
-	if (stat(newName.c_str(), &info) == 0)
+	std::string newName = filename.substr(0, i);
+	SDL_mutexP(_folderMutex);
+	while (i < filename.size())
 	{
-		return newName;
-	}
-	else
-	{
-		for (std::string::iterator c = newName.begin() + i; c != newName.end(); c++)
-			*c = toupper(*c);
-		if (stat(newName.c_str(), &info) == 0)
-		{
-			return newName;
-		}
-		else
+		size_t end = std::min(filename.find('/', i), filename.size());
+		std::string name = filename.substr(i, end - i), lower = name;
+		for (std::string::iterator c = lower.begin(); c != lower.end(); c++)
+			*c = tolower(*c);
+
+		// the exact name wins over others with the same letters
+		const std::map<std::string, std::string> &entries = getFolderEntries(newName);
+		std::map<std::string, std::string>::const_iterator entry = entries.find(name);
+		if (entry == entries.end())
+			entry = entries.find(lower);
+		if (entry == entries.end())
 		{
-			for (std::string::iterator c = newName.begin() + i; c != newName.end(); c++)
-				*c = tolower(*c);
-			if (stat(newName.c_str(), &info) == 0)
-			{
-				return newName;
-			}
-			else
-			{
-				return "";
-			}
+			SDL_mutexV(_folderMutex);
+			return "";
 		}
+
+		newName += entry->second;
+		if (end < filename.size())
+			newName += "/";
+		i = end + 1;
 	}
+	SDL_mutexV(_folderMutex);
+	return newName;
+}
+
+/**
+ * Gets the entries of a folder, both by their own name and by
+ * their lowercase name. The folder is only read the first time,
+ * so looking up files doesn't touch the disk again.
+ * Only called with the folder mutex held.
+ * @param folder Path of the folder, with a trailing slash ("" for the current folder).
+ * @return Actual names of the entries.
+ */
+const std::map<std::string, std::string> &ResourcePack::getFolderEntries(const std::string &folder)
+{
+	std::map<std::string, std::map<std::string, std::string> >::iterator i = _folderEntries.find(folder);
+	if (i != _folderEntries.end())
+	{
+		return i->second;
+	}
+
+	std::map<std::string, std::string> &entries = _folderEntries[folder];
+	DIR *dp = opendir(folder.empty() ? "." : folder.c_str());
+	if (dp == 0)
+	{
+		return entries;
+	}
+	struct dirent *dirp;
+	while ((dirp = readdir(dp)) != 0)
+	{
+		std::string name = dirp->d_name, lower = name;
+		for (std::string::iterator c = lower.begin(); c != lower.end(); c++)
+			*c = tolower(*c);
+		entries.insert(std::make_pair(lower, name));
+		entries[name] = name;
+	}
+	closedir(dp);
+	return entries;
 }
 
 /**
@@ -150,22 +195,148 @@ Font *const ResourcePack::getFont(const std::string &name)
 
 /**
  * Returns a specific surface from the resource set.
+ * Cached surfaces are only kept until CACHED_SURFACES others
+ * have been used since, so they should be drawn right away
+ * instead of kept.
  * @param name Name of the surface.
  * @return Pointer to the surface.
  */
 Surface *const ResourcePack::getSurface(const std::string &name)
 {
-	return _surfaces[name];
+	std::map<std::string, Surface*>::iterator i = _surfaces.find(name);
+	if (i != _surfaces.end())
+	{
+		std::list<std::string>::iterator cached = std::find(_cachedSurfaces.begin(), _cachedSurfaces.end(), name);
+		if (cached != _cachedSurfaces.end())
+		{
+			_cachedSurfaces.splice(_cachedSurfaces.begin(), _cachedSurfaces, cached);
+		}
+		return i->second;
+	}
+
+	// load it now if it's waiting to be used
+	std::map<std::string, ImageFile>::iterator file = _lazySurfaces.find(name);
+	if (file == _lazySurfaces.end())
+	{
+		return 0;
+	}
+	Surface *surface = new Surface(file->second.width, file->second.height);
+	if (file->second.format == IMAGE_SPK)
+	{
+		surface->loadSpk(file->second.filename);
+	}
+	else
+	{
+		surface->loadScr(file->second.filename);
+	}
+	surface->setSharedPalette(&_palette);
+	_surfaces[name] = surface;
+	if (!file->second.cached)
+	{
+		_lazySurfaces.erase(file);
+		return surface;
+	}
+
+	// cached ones stay registered, so they can be loaded again once they're dropped
+	_cachedSurfaces.push_front(name);
+	while (_cachedSurfaces.size() > CACHED_SURFACES)
+	{
+		delete _surfaces[_cachedSurfaces.back()];
+		_surfaces.erase(_cachedSurfaces.back());
+		_cachedSurfaces.pop_back();
+	}
+	return surface;
+}
+
+/**
+ * Unloads all the cached surfaces, for when whatever
+ * used them is done. They're loaded again when asked for.
+ */
+void ResourcePack::releaseCachedSurfaces()
+{
+	for (std::list<std::string>::iterator i = _cachedSurfaces.begin(); i != _cachedSurfaces.end(); i++)
+	{
+		delete _surfaces[*i];
+		_surfaces.erase(*i);
+	}
+	_cachedSurfaces.clear();
 }
 
 /**
  * Returns a specific surface set from the resource set.
+ * The set stays the same for the lifetime of the pack, so callers
+ * drawing it often can look it up once and keep the pointer.
  * @param name Name of the surface set.
  * @return Pointer to the surface set.
  */
 SurfaceSet *const ResourcePack::getSurfaceSet(const std::string &name)
 {
-	return _sets[name];
+	std::map<std::string, SurfaceSet*>::iterator i = _sets.find(name);
+	if (i != _sets.end())
+	{
+		return i->second;
+	}
+
+	// load it now if it's waiting to be used
+	std::map<std::string, ImageFile>::iterator file = _lazySets.find(name);
+	if (file == _lazySets.end())
+	{
+		return 0;
+	}
+	SurfaceSet *set = new SurfaceSet(file->second.width, file->second.height);
+	if (file->second.format == IMAGE_DAT)
+	{
+		set->loadDat(file->second.filename);
+	}
+	else
+	{
+		set->loadPck(file->second.filename, file->second.tab);
+	}
+	set->setSharedPalette(&_palette);
+	_sets[name] = set;
+	_lazySets.erase(file);
+	return set;
+}
+
+/**
+ * Registers a surface to be loaded the first time it's asked for.
+ * @param name Name of the surface.
+ * @param filename Filename of the image.
+ * @param format Format of the image, SCR or SPK.
+ * @param width Width of the surface.
+ * @param height Height of the surface.
+ * @param cached Only keep the surface in the cache of recently used ones.
+ */
+void ResourcePack::addSurface(const std::string &name, const std::string &filename, ImageFormat format, int width, int height, bool cached)
+{
+	ImageFile file;
+	file.filename = filename;
+	file.format = format;
+	file.width = width;
+	file.height = height;
+	file.cached = cached;
+	_lazySurfaces[name] = file;
+}
+
+/**
+ * Registers a surface set to be loaded the first time it's asked for.
+ * @param name Name of the surface set.
+ * @param filename Filename of the image.
+ * @param tab Filename of the PCK offsets, if any.
+ * @param format Format of the image, PCK or DAT.
+ * @param width Width of the frames.
+ * @param height Height of the frames.
+ */
+void ResourcePack::addSurfaceSet(const std::string &name, const std::string &filename, const std::string &tab, ImageFormat format, int width, int height)
+{
+	ImageFile file;
+	file.filename = filename;
+	file.tab = tab;
+	file.format = format;
+	file.width = width;
+	file.height = height;
+	file.cached = false;
+	_lazySets[name] = file;
 }
 
 /**
@@ -193,7 +364,48 @@ std::list<Polyline*> *const ResourcePack::getPolylines()
  */
 Music *const ResourcePack::getMusic(const std::string &name)
 {
-	return _musics[name];
+	std::map<std::string, Music*>::iterator i = _musics.find(name);
+	if (i != _musics.end())
+	{
+		return i->second;
+	}
+
+	// load it now if it's waiting to be used, musics that weren't found stay silent
+	Music *music = 0;
+	std::map<std::string, MusicFile>::iterator file = _lazyMusics.find(name);
+	if (file != _lazyMusics.end() && file->second.track >= 0)
+	{
+		GMCatFile gmcat(file->second.filename.c_str());
+		music = gmcat.loadMIDI(file->second.track);
+	}
+	else
+	{
+		music = new Music();
+		if (file != _lazyMusics.end() && !file->second.filename.empty())
+		{
+			music->load(file->second.filename);
+		}
+	}
+	if (file != _lazyMusics.end())
+	{
+		_lazyMusics.erase(file);
+	}
+	_musics[name] = music;
+	return music;
+}
+
+/**
+ * Registers a music to be loaded the first time it's asked for.
+ * @param name Name of the music.
+ * @param filename Filename of the music, or of the GM.CAT it's in.
+ * @param track Track in the GM.CAT, -1 if the file is the music itself.
+ */
+void ResourcePack::addMusic(const std::string &name, const std::string &filename, int track)
+{
+	MusicFile file;
+	file.filename = filename;
+	file.track = track;
+	_lazyMusics[name] = file;
 }
 
 /**
@@ -218,24 +430,16 @@ Palette *const ResourcePack::getPalette(const std::string &name)
 
 /**
  * Changes the palette of all the graphics in the resource set.
+ * They all share one palette, so this just changes its colors,
+ * the graphics pick them up the next time they're blitted.
  * @param colors Pointer to the set of colors.
  * @param firstcolor Offset of the first color to replace.
  * @param ncolors Amount of colors to replace.
  */
 void ResourcePack::setPalette(SDL_Color *colors, int firstcolor, int ncolors)
 {
-	for (std::map<std::string, Font*>::iterator i = _fonts.begin(); i != _fonts.end(); i++)
-	{
-		i->second->getSurface()->setPalette(colors, firstcolor, ncolors);
-	}
-	for (std::map<std::string, Surface*>::iterator i = _surfaces.begin(); i != _surfaces.end(); i++)
-	{
-		i->second->setPalette(colors, firstcolor, ncolors);
-	}
-	for (std::map<std::string, SurfaceSet*>::iterator i = _sets.begin(); i != _sets.end(); i++)
-	{
-		i->second->setPalette(colors, firstcolor, ncolors);
-	}
+	memcpy(_palette.colors + firstcolor, colors, ncolors * sizeof(SDL_Color));
+	_palette.version++;
 }
 
 /**
@@ -247,4 +451,30 @@ std::vector<Uint16> *const ResourcePack::getVoxelData()
 	return &_voxelData;
 }
 
+/**
+ * Returns the voxel shapes (LOFTs) of the voxel data. Each one is a slab of 16 rows of 16 bits,
+ * 32 bytes aligned to 32 bytes, so a whole row or slab can be tested at once.
+ * They're packed from the voxel data the first time.
+ * @return Pointer to the first row of the first LOFT.
+ */
+const Uint16 *ResourcePack::getLofts()
+{
+	if (_lofts == 0)
+	{
+		_loftBuffer = new char[_voxelData.size() * sizeof(Uint16) + LOFT_ALIGNMENT];
+		_lofts = (Uint16*)(((size_t)_loftBuffer + LOFT_ALIGNMENT - 1) & ~(size_t)(LOFT_ALIGNMENT - 1));
+		std::copy(_voxelData.begin(), _voxelData.end(), _lofts);
+	}
+	return _lofts;
+}
+
+/**
+ * Returns the number of voxel shapes (LOFTs) in the voxel data.
+ * @return Number of LOFTs.
+ */
+int ResourcePack::getLoftCount() const
+{
+	return _voxelData.size() / 16;
+}
+
 }
@@ -24,6 +24,14 @@
 #include <list>
 #include <vector>
 #include "SDL.h"
+#include "../Engine/Surface.h"
+
+// handhelds keep fewer of the big screens around, they're just decoded again
+#ifdef DINGOO
+#define CACHED_SURFACES 2
+#else
+#define CACHED_SURFACES 4
+#endif
 
 namespace OpenXcom
 {
@@ -52,6 +60,22 @@ class MapBlock;
 class ResourcePack
 {
 protected:
+	/// Formats of images that can be loaded on first use.
+	enum ImageFormat { IMAGE_SCR, IMAGE_SPK, IMAGE_PCK, IMAGE_DAT };
+	/// An image file registered to be loaded on first use.
+	struct ImageFile
+	{
+		std::string filename, tab;
+		ImageFormat format;
+		int width, height;
+		bool cached;
+	};
+	/// A music file registered to be loaded on first use, a track of a GM.CAT or a file of its own.
+	struct MusicFile
+	{
+		std::string filename;
+		int track;
+	};
 	std::string _folder;
 	std::map<std::string, Palette*> _palettes;
 	std::map<std::string, Font*> _fonts;
@@ -62,6 +86,22 @@ protected:
 	std::list<Polyline*> _polylines;
 	std::map<std::string, Music*> _musics;
 	std::vector<Uint16> _voxelData;
+	char *_loftBuffer;
+	Uint16 *_lofts;
+	std::map<std::string, ImageFile> _lazySurfaces, _lazySets;
+	std::list<std::string> _cachedSurfaces;
+	std::map<std::string, MusicFile> _lazyMusics;
+	SharedPalette _palette;
+	static std::map<std::string, std::map<std::string, std::string> > _folderEntries;
+	static SDL_mutex *_folderMutex;
+	/// Gets the entries of a folder by lowercase name.
+	static const std::map<std::string, std::string> &getFolderEntries(const std::string &folder);
+	/// Registers a surface to load on first use.
+	void addSurface(const std::string &name, const std::string &filename, ImageFormat format, int width, int height, bool cached = false);
+	/// Registers a surface set to load on first use.
+	void addSurfaceSet(const std::string &name, const std::string &filename, const std::string &tab, ImageFormat format, int width, int height);
+	/// Registers a music to load on first use.
+	void addMusic(const std::string &name, const std::string &filename, int track = -1);
 public:
 	/// Create a new resource pack with a folder's contents.
 	ResourcePack(const std::string &folder);
@@ -75,6 +115,8 @@ public:
 	Font *const getFont(const std::string &name);
 	/// Gets a particular surface.
 	Surface *const getSurface(const std::string &name);
+	/// Unloads the surfaces that are only kept in the cache.
+	void releaseCachedSurfaces();
 	/// Gets a particular surface set.
 	SurfaceSet *const getSurfaceSet(const std::string &name);
 	/// Gets the list of world polygons.
@@ -91,6 +133,10 @@ public:
 	void setPalette(SDL_Color *colors, int firstcolor, int ncolors);
 	/// Gets list of voxel data.
 	std::vector<Uint16> *const getVoxelData();
+	/// Gets the voxel shapes packed in aligned slabs.
+	const Uint16 *getLofts();
+	/// Gets the number of voxel shapes.
+	int getLoftCount() const;
 };
 
 }
@@ -24,9 +24,8 @@
 #include "../Engine/Surface.h"
 #include "../Engine/SurfaceSet.h"
 #include "../Engine/Language.h"
-#include "../Engine/Music.h"
-#include "../Engine/GMCat.h"
 #include "../Engine/SoundSet.h"
+#include "../Engine/Profiler.h"
 #include "../Geoscape/Globe.h"
 #include "../Geoscape/Polygon.h"
 #include "../Geoscape/Polyline.h"
@@ -50,6 +49,7 @@ namespace OpenXcom
 XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(folder)
 {
 	// Load palettes
+	TraceMarker palettes("palettes");
 	for (int i = 0; i < 5; i++)
 	{
 		std::stringstream s1, s2;
@@ -65,7 +65,10 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 	_palettes[s2.str()] = new Palette();
 	_palettes[s2.str()]->loadDat(insensitive(s1.str()), 128);
 	
+	palettes.stop();
+
 	// Load fonts
+	TraceMarker fonts("fonts");
 	std::string font[] = {"BIGLETS.DAT",
 						  "SMALLSET.DAT"};
 	
@@ -79,9 +82,13 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 			_fonts[font[i]] = new Font(8, 9, 173, -1);
 		_fonts[font[i]]->getSurface()->loadScr(insensitive(s.str()));
 		_fonts[font[i]]->load();
+		_fonts[font[i]]->getSurface()->setSharedPalette(&_palette);
 	}
 		
+	fonts.stop();
+
 	// Load language graphics
+	TraceMarker languages("languages");
 	std::string lang[] = {"English",
 						  "French",
 						  "German",
@@ -93,16 +100,17 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 		std::stringstream s1, s2;
 		s1 << folder << "Language/" << lang[i] << ".geo";
 		s2 << lang[i] << ".geo";
-		_surfaces[s2.str()] = new Surface(64, 154);
-		_surfaces[s2.str()]->loadScr(insensitive(s1.str()));
+		addSurface(s2.str(), insensitive(s1.str()), IMAGE_SCR, 64, 154);
 	}
 
-	// Load surfaces
+	languages.stop();
+
+	// Register surfaces, they're only loaded once they're used
+	TraceMarker surfaces("surfaces");
 	{
 		std::stringstream s;
 		s << folder << "GEODATA/" << "INTERWIN.DAT";
-		_surfaces["INTERWIN.DAT"] = new Surface(160, 556);
-		_surfaces["INTERWIN.DAT"]->loadScr(insensitive(s.str()));
+		addSurface("INTERWIN.DAT", insensitive(s.str()), IMAGE_SCR, 160, 556);
 	}
 
 	std::string scrs[] = {"BACK01.SCR",
@@ -129,8 +137,7 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 	{
 		std::stringstream s;
 		s << folder << "GEOGRAPH/" << scrs[i];
-		_surfaces[scrs[i]] = new Surface(320, 200);
-		_surfaces[scrs[i]]->loadScr(insensitive(s.str()));
+		addSurface(scrs[i], insensitive(s.str()), IMAGE_SCR, 320, 200);
 	}
 
 	std::string spks[] = {"UP001.SPK",
@@ -181,11 +188,11 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 	{
 		std::stringstream s;
 		s << folder << "GEOGRAPH/" << spks[i];
-		_surfaces[spks[i]] = new Surface(320, 200);
-		_surfaces[spks[i]]->loadSpk(insensitive(s.str()));
+		// the Ufopaedia images are only shown one at a time
+		addSurface(spks[i], insensitive(s.str()), IMAGE_SPK, 320, 200, spks[i] != "GRAPHS.SPK");
 	}
 
-	// Load surface sets
+	// Register surface sets
 	std::string sets[] = {"BASEBITS.PCK",
 						  "INTICON.PCK",
 						  "TEXTURE.DAT"};
@@ -201,17 +208,18 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 			std::string tab = sets[i].substr(0, sets[i].length()-4) + ".TAB";
 			std::stringstream s2;
 			s2 << folder << "GEOGRAPH/" << tab;
-			_sets[sets[i]] = new SurfaceSet(32, 40);
-			_sets[sets[i]]->loadPck(insensitive(s.str()), insensitive(s2.str()));
+			addSurfaceSet(sets[i], insensitive(s.str()), insensitive(s2.str()), IMAGE_PCK, 32, 40);
 		}
 		else
 		{
-			_sets[sets[i]] = new SurfaceSet(32, 32);
-			_sets[sets[i]]->loadDat(insensitive(s.str()));
+			addSurfaceSet(sets[i], insensitive(s.str()), "", IMAGE_DAT, 32, 32);
 		}
 	}
 
+	surfaces.stop();
+
 	// Load polygons
+	TraceMarker polygons("polygons");
 	std::stringstream s;
 	s << folder << "GEODATA/" << "WORLD.DAT";
 	Globe::loadDat(insensitive(s.str()), &_polygons);
@@ -282,7 +290,10 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 	}
 	_polylines.push_back(l);
 
-	// Load musics
+	polygons.stop();
+
+	// Register musics, they're only converted once they're played
+	TraceMarker musics("musics");
 	std::string mus[] = {"GMDEFEND",
 						 "GMENBASE",
 						 "GMGEO1",
@@ -302,7 +313,6 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 
 	// Check which music version is available
 	bool cat = true;
-	GMCatFile *gmcat = 0;
 
 	std::stringstream musDos;
 	musDos << folder << "SOUND/GM.CAT";
@@ -310,7 +320,6 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 	if (stat(insensitive(musDos.str()).c_str(), &musInfo) == 0)
 	{
 		cat = true;
-		gmcat = new GMCatFile(insensitive(musDos.str()).c_str());
 	}
 	else
 	{
@@ -321,11 +330,12 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 	{
 		if (cat)
 		{
-			_musics[mus[i]] = gmcat->loadMIDI(tracks[i]);
+			addMusic(mus[i], insensitive(musDos.str()), tracks[i]);
 		}
 		else
 		{
-			_musics[mus[i]] = new Music();
+			// no file means no music
+			addMusic(mus[i], "");
 			for (int j = 0; j < 3; j++)
 			{
 				std::stringstream s;
@@ -333,15 +343,17 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 				struct stat info;
 				if (stat(insensitive(s.str()).c_str(), &info) == 0) 
 				{
-					_musics[mus[i]]->load(insensitive(s.str()));
+					addMusic(mus[i], insensitive(s.str()));
 					break;
 				}
 			}
 		}
 	}
-	delete gmcat;
+
+	musics.stop();
 
 	// Load sounds
+	TraceMarker sounds("sounds");
 	std::string catsId[] = {"GEO.CAT",
 							"BATTLE.CAT",
 							"INTRO.CAT"};
@@ -386,10 +398,12 @@ XcomResourcePack::XcomResourcePack(const std::string &folder) : ResourcePack(fol
 		}
 	}
 
-	TextButton::soundPress = _sounds["GEO.CAT"]->getSound(0);
-	Window::soundPopup[0] = _sounds["GEO.CAT"]->getSound(1);
-	Window::soundPopup[1] = _sounds["GEO.CAT"]->getSound(2);
-	Window::soundPopup[2] = _sounds["GEO.CAT"]->getSound(3);
+	TextButton::soundPress = _sounds["GEO.CAT"]->keepSound(0);
+	Window::soundPopup[0] = _sounds["GEO.CAT"]->keepSound(1);
+	Window::soundPopup[1] = _sounds["GEO.CAT"]->keepSound(2);
+	Window::soundPopup[2] = _sounds["GEO.CAT"]->keepSound(3);
+
+	sounds.stop();
 
 	loadBattlescapeResources(); // TODO load this at battlescape start, unload at battlescape end?
 }
@@ -404,34 +418,32 @@ XcomResourcePack::~XcomResourcePack()
 
 void XcomResourcePack::loadBattlescapeResources()
 {
-	// Load Battlescape ICONS
+	TraceMarker trace("battlescape resources");
+
+	// Register Battlescape ICONS
 	std::stringstream s;
 	s << _folder << "UFOGRAPH/" << "ICONS.PCK";
-	_surfaces["ICONS.PCK"] = new Surface(320, 200);
-	_surfaces["ICONS.PCK"]->loadSpk(insensitive(s.str()));
+	addSurface("ICONS.PCK", insensitive(s.str()), IMAGE_SPK, 320, 200);
 
 	s.str("");
 	std::stringstream s2;
 	s << _folder << "UFOGRAPH/" << "CURSOR.PCK";
 	s2 << _folder << "UFOGRAPH/" << "CURSOR.TAB";
-	_sets["CURSOR.PCK"] = new SurfaceSet(32, 40);
-	_sets["CURSOR.PCK"]->loadPck(insensitive(s.str()), insensitive(s2.str()));
+	addSurfaceSet("CURSOR.PCK", insensitive(s.str()), insensitive(s2.str()), IMAGE_PCK, 32, 40);
 
 	s.str("");
 	s2.str("");
 	s << _folder << "UFOGRAPH/" << "SMOKE.PCK";
 	s2 << _folder << "UFOGRAPH/" << "SMOKE.TAB";
-	_sets["SMOKE.PCK"] = new SurfaceSet(32, 40);
-	_sets["SMOKE.PCK"]->loadPck(insensitive(s.str()), insensitive(s2.str()));
+	addSurfaceSet("SMOKE.PCK", insensitive(s.str()), insensitive(s2.str()), IMAGE_PCK, 32, 40);
 
 	s.str("");
 	s2.str("");
 	s << _folder << "UFOGRAPH/" << "X1.PCK";
 	s2 << _folder << "UFOGRAPH/" << "X1.TAB";
-	_sets["X1.PCK"] = new SurfaceSet(160, 64);
-	_sets["X1.PCK"]->loadPck(insensitive(s.str()), insensitive(s2.str()));
+	addSurfaceSet("X1.PCK", insensitive(s.str()), insensitive(s2.str()), IMAGE_PCK, 160, 64);
 
-	// Load Battlescape Terrain (only blacks are loaded, others are loaded just in time)
+	// Register Battlescape Terrain (only blacks are registered, others are loaded just in time)
 	std::string bsets[] = {"BLANKS.PCK"};
 
 	for (int i = 0; i < 1; i++)
@@ -441,11 +453,10 @@ void XcomResourcePack::loadBattlescapeResources()
 		std::string tab = bsets[i].substr(0, bsets[i].length()-4) + ".TAB";
 		std::stringstream s2;
 		s2 << _folder << "TERRAIN/" << tab;
-		_sets[bsets[i]] = new SurfaceSet(32, 40);
-		_sets[bsets[i]]->loadPck(insensitive(s.str()), insensitive(s2.str()));
+		addSurfaceSet(bsets[i], insensitive(s.str()), insensitive(s2.str()), IMAGE_PCK, 32, 40);
 	}
 
-	// Load Battlescape units
+	// Register Battlescape units
 	std::string usets[] = {"SILACOID.PCK",
 							"CELATID.PCK",
 							"HANDOB.PCK",
@@ -475,15 +486,17 @@ void XcomResourcePack::loadBattlescapeResources()
 		std::string tab = usets[i].substr(0, usets[i].length()-4) + ".TAB";
 		std::stringstream s2;
 		s2 << _folder << "UNITS/" << tab;
-		_sets[usets[i]] = new SurfaceSet(32, 40);
-		_sets[usets[i]]->loadPck(insensitive(s.str()), insensitive(s2.str()));
+		addSurfaceSet(usets[i], insensitive(s.str()), insensitive(s2.str()), IMAGE_PCK, 32, 40);
 	}
 	s.str("");
 	s << _folder << "UNITS/" << "BIGOBS.PCK";
 	s2.str("");
 	s2 << _folder << "UNITS/" << "BIGOBS.TAB";
-	_sets["BIGOBS.PCK"] = new SurfaceSet(32, 48);
-	_sets["BIGOBS.PCK"]->loadPck(insensitive(s.str()), insensitive(s2.str()));
+	addSurfaceSet("BIGOBS.PCK", insensitive(s.str()), insensitive(s2.str()), IMAGE_PCK, 32, 48);
+
+	s.str("");
+	s << _folder << "GEODATA/" << "SCANG.DAT";
+	addSurfaceSet("SCANG.DAT", insensitive(s.str()), "", IMAGE_DAT, 4, 4);
 
 	s.str("");
 	s << _folder << "GEODATA/" << "LOFTEMPS.DAT";
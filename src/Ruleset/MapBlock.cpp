@@ -24,7 +24,7 @@ namespace OpenXcom
 /**
 * MapBlock construction
 */
-MapBlock::MapBlock(RuleTerrain *terrain, std::string name, int width, int length, bool landingZone):_terrain(terrain), _name(name), _width(width), _length(length), _landingZone(landingZone)
+MapBlock::MapBlock(RuleTerrain *terrain, std::string name, int width, int length, bool landingZone):_terrain(terrain), _name(name), _width(width), _length(length), _landingZone(landingZone), _frequency(1)
 {
 }
 
@@ -89,4 +89,24 @@ bool MapBlock::isLandingZone()
 	return _landingZone;
 }
 
+/**
+* Gets how often this mapblock is picked, compared
+* to the other mapblocks of its terrain.
+* @return frequency weight, 0 is never.
+*/
+int MapBlock::getFrequency()
+{
+	return _frequency;
+}
+
+/**
+* Sets how often this mapblock is picked, compared
+* to the other mapblocks of its terrain.
+* @param frequency frequency weight, 0 is never.
+*/
+void MapBlock::setFrequency(int frequency)
+{
+	_frequency = frequency;
+}
+
 }
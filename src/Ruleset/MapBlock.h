@@ -39,6 +39,7 @@ private:
 	std::string _name;
 	int _width, _length, _height;
 	bool _landingZone;
+	int _frequency;
 public:
 	MapBlock(RuleTerrain *terrain, std::string name, int width, int length, bool landingZone);
 	~MapBlock();
@@ -54,6 +55,10 @@ public:
 	void setHeight(int height);
 	/// Returns whether this mapblock is a landingzone.
 	bool isLandingZone();
+	/// Gets how often the mapblock is picked.
+	int getFrequency();
+	/// Sets how often the mapblock is picked.
+	void setFrequency(int frequency);
 };
 
 }
@@ -57,6 +57,22 @@ int MapData::getSprite(int frameID)
 	return _sprite[frameID];
 }
 
+/**
+* Get whether the object looks different in any of its animation frames.
+* @return bool
+*/
+bool MapData::isAnimated() const
+{
+	for (int i = 1; i < 8; i++)
+	{
+		if (_sprite[i] != _sprite[0])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
 * Set the sprite index for a certain frame.
 * @param frameID Animation frame
@@ -393,6 +409,54 @@ void MapData::setFuel(int value)
 	_fuel = value;
 }
 
+/**
+  * Get the power of the explosion when the object is destroyed,
+  * like fuel tanks and ufo power sources.
+  * @return power, 0 if it doesn't explode
+  */
+int MapData::getExplosive()
+{
+	return _explosive;
+}
+
+/**
+  * Get the type of the explosion when the object is destroyed.
+  * @return damage type
+  */
+ItemDamageType MapData::getExplosiveType()
+{
+	return _explosiveType;
+}
+
+/**
+  * Set the type and power of the explosion when the object is destroyed.
+  * @param type 0 for high explosive, 1 for smoke
+  * @param power
+  */
+void MapData::setExplosive(int type, int power)
+{
+	_explosiveType = (type == 1) ? DT_SMOKE : DT_HE;
+	_explosive = power;
+}
+
+/**
+  * Get the index of the block of the object in the minimap sprites (SCANG.DAT).
+  * @return index, 0 if it isn't shown on the minimap
+  */
+int MapData::getMiniMapIndex()
+{
+	return _miniMapIndex;
+}
+
+/**
+  * Set the index of the block of the object in the minimap sprites.
+  * @param value
+  */
+void MapData::setMiniMapIndex(int value)
+{
+	_miniMapIndex = value;
+}
+
 /// Get the loft index for a certain layer.
 int MapData::getLoftID(int layer)
 {
@@ -405,4 +469,28 @@ void MapData::setLoftID(int loft, int layer)
 	_loftID[layer] = loft;
 }
 
+/**
+ * Sets the voxel shapes of the 12 layers of this object, from its loft indices.
+ * Indices beyond the loaded shapes get the first one, which is empty.
+ * @param lofts packed voxel shapes, 16 rows each.
+ * @param loftCount number of shapes.
+ */
+void MapData::setLoftLayers(const Uint16 *lofts, int loftCount)
+{
+	for (int layer = 0; layer < 12; layer++)
+	{
+		_loftLayers[layer] = lofts + (_loftID[layer] < loftCount ? _loftID[layer] : 0) * 16;
+	}
+}
+
+/**
+ * Gets the voxel shape of a certain layer: 16 rows of 16 bits.
+ * @param layer 0-11, every layer is 2 voxels high.
+ * @return pointer to the first row.
+ */
+const Uint16 *MapData::getLoftLayer(int layer) const
+{
+	return _loftLayers[layer];
+}
+
 }
@@ -21,6 +21,7 @@
 
 #include <string>
 #include "../Ruleset/RuleItem.h"
+#include "SDL.h"
 
 namespace OpenXcom
 {
@@ -61,10 +62,12 @@ private:
 	SpecialTileType _specialType;
 	bool _isUfoDoor, _stopLOS, _isNoFloor, _isBigWall, _isGravLift, _isDoor, _blockFire, _blockSmoke;
 	int _yOffset, _TUWalk, _TUFly, _TUSlide, _terrainLevel, _footstepSound, _dieMCD, _altMCD, _objectType, _lightSource;
-	int _armor, _flammable, _fuel;
+	int _armor, _flammable, _fuel, _explosive, _miniMapIndex;
+	ItemDamageType _explosiveType;
 	int _sprite[8];
 	int _block[6];
 	int _loftID[12];
+	const Uint16 *_loftLayers[12];
 public:
 	MapData(MapDataSet *dataset);
 	~MapData();
@@ -76,6 +79,8 @@ public:
 	void setSprite(int frameID, int value);
 	/// Get whether this is an animated ufo door.
 	bool isUFODoor();
+	/// Get whether the sprite changes between animation frames.
+	bool isAnimated() const;
 	/// Can we walk over it.
 	bool isNoFloor();
 	/// Can we walk over it.
@@ -134,10 +139,24 @@ public:
 	int getFuel();
 	/// Set the amount of fuel.
 	void setFuel(int value);
+	/// Get the power of the explosion when the object is destroyed.
+	int getExplosive();
+	/// Get the type of the explosion when the object is destroyed.
+	ItemDamageType getExplosiveType();
+	/// Set the type and power of the explosion when the object is destroyed.
+	void setExplosive(int type, int power);
+	/// Get the index of the minimap block of the object.
+	int getMiniMapIndex();
+	/// Set the index of the minimap block of the object.
+	void setMiniMapIndex(int value);
 	/// Get the loft index for a certain layer.
 	int getLoftID(int layer);
 	/// Set the loft index for a certain layer.
 	void setLoftID(int loft, int layer);
+	/// Set the voxel shapes of all layers.
+	void setLoftLayers(const Uint16 *lofts, int loftCount);
+	/// Get the voxel shape of a certain layer.
+	const Uint16 *getLoftLayer(int layer) const;
 };
 
 }
@@ -29,11 +29,12 @@ namespace OpenXcom
 
 MapData *MapDataSet::_blankTile = 0;
 MapData *MapDataSet::_scourgedTile = 0;
+std::list<MapDataSet*> MapDataSet::_unused;
 
 /**
 * MapDataSet construction.
 */
-MapDataSet::MapDataSet(std::string name, int size):_name(name), _size(size), _objects(), _loaded(false)
+MapDataSet::MapDataSet(std::string name, int size):_name(name), _size(size), _objects(), _surfaceSet(0), _loaded(false), _references(0)
 {
 }
 
@@ -42,6 +43,7 @@ MapDataSet::MapDataSet(std::string name, int size):_name(name), _size(size), _ob
 */
 MapDataSet::~MapDataSet()
 {
+	_unused.remove(this);
 	unload();
 }
 
@@ -177,12 +179,15 @@ void MapDataSet::load(ResourcePack *res)
 		to->setArmor((int)mcd.Armor);
 		to->setFlammable((int)mcd.Flammable);
 		to->setFuel((int)mcd.Fuel);
+		to->setExplosive((int)mcd.HE_Type, (int)mcd.HE_Strength);
+		to->setMiniMapIndex((int)mcd.ScanG);
 
 		for (int layer = 0; layer < 12; layer++)
 		{
 			int loft = (int)mcd.LOFT[layer];
 			to->setLoftID(loft, layer);
 		}
+		to->setLoftLayers(res->getLofts(), res->getLoftCount());
 
 		// store the 2 tiles of blanks in a static - so they are accesible everywhere
 		if (_name.compare("BLANKS") == 0)
@@ -218,9 +223,49 @@ void MapDataSet::unload()
 	{
 		for (std::vector<MapData*>::iterator i = _objects.begin(); i != _objects.end(); i++)
 		{
+			if (*i == _blankTile)
+				_blankTile = 0;
+			if (*i == _scourgedTile)
+				_scourgedTile = 0;
 			delete *i;
 		}
+		_objects.clear();
 		delete _surfaceSet;
+		_surfaceSet = 0;
+		_loaded = false;
+	}
+}
+
+/**
+ * Loads the objects for a battle, unless they're still
+ * loaded from an earlier one, and keeps them loaded
+ * until every battle using them has released them.
+ * @param res The resourcepack.
+ */
+void MapDataSet::acquire(ResourcePack *res)
+{
+	if (_references++ == 0)
+	{
+		_unused.remove(this);
+	}
+	load(res);
+}
+
+/**
+ * Releases the objects once a battle is done with them.
+ * When no battle uses them anymore they stay loaded for a
+ * while, but the least recently used of the unused datafiles
+ * are unloaded so only MAPDATASET_CACHE of them are kept.
+ */
+void MapDataSet::release()
+{
+	if (--_references > 0)
+		return;
+	_unused.push_front(this);
+	while (_unused.size() > MAPDATASET_CACHE)
+	{
+		_unused.back()->unload();
+		_unused.pop_back();
 	}
 }
 
@@ -21,8 +21,15 @@
 
 #include <string>
 #include <vector>
+#include <list>
 #include "SDL.h"
 
+#ifdef DINGOO
+#define MAPDATASET_CACHE 1
+#else
+#define MAPDATASET_CACHE 8
+#endif
+
 namespace OpenXcom
 {
 
@@ -34,6 +41,8 @@ class ResourcePack;
  * Represents a Terrain Map Datafile.
  * Which corresponds to an Xcom MCD & PCK file.
  * The list of map datafiles is stored in RuleSet, but referenced in RuleTerrain.
+ * Battles acquire the datafiles they use and release them when they're over,
+ * and the last few unused ones are kept loaded in case the next battle needs them.
  * @sa http://www.ufopaedia.org/index.php?title=MCD
  */
 class MapDataSet
@@ -44,8 +53,10 @@ private:
 	std::vector<MapData*> _objects;
 	SurfaceSet *_surfaceSet;
 	bool _loaded;
+	int _references;
 	static MapData *_blankTile;
 	static MapData *_scourgedTile;
+	static std::list<MapDataSet*> _unused;
 public:
 	MapDataSet(std::string name, int size);
 	~MapDataSet();
@@ -63,6 +74,10 @@ public:
 	void load(ResourcePack *res);
 	///	Unload to free memory.
 	void unload();
+	/// Loads the objects for a battle that uses them.
+	void acquire(ResourcePack *res);
+	/// Lets go of the objects once a battle is done with them.
+	void release();
 	/// 
 	static MapData *getBlankFloorTile();
 	static MapData *getScourgedEarthTile();
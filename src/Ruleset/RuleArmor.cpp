@@ -26,7 +26,7 @@ namespace OpenXcom
  * type of armor.
  * @param type String defining the type.
  */
-RuleArmor::RuleArmor(std::string type, std::string spriteSheet) : _type(type), _spriteSheet(spriteSheet)
+RuleArmor::RuleArmor(std::string type, std::string spriteSheet) : _type(type), _spriteSheet(spriteSheet), _movementType(MT_WALK)
 {
 
 }
@@ -94,6 +94,16 @@ std::string RuleArmor::getCorpseItem() const
 {
 	return _corpseItem;
 }
+/// Set the way units wearing the armor move.
+void RuleArmor::setMovementType(MovementType movementType)
+{
+	_movementType = movementType;
+}
+/// Get the way units wearing the armor move.
+MovementType RuleArmor::getMovementType() const
+{
+	return _movementType;
+}
 
 
 }
@@ -21,6 +21,7 @@
 
 #include <vector>
 #include <string>
+#include "MapData.h"
 
 namespace OpenXcom
 {
@@ -36,6 +37,7 @@ class RuleArmor
 private:
 	std::string _type, _spriteSheet, _corpseItem;
 	int _frontArmor, _sideArmor, _rearArmor, _underArmor;
+	MovementType _movementType;
 
 public:
 	/// Creates a blank armor ruleset.
@@ -60,6 +62,10 @@ public:
 	void setCorpseItem(std::string corpseItem);
 	/// Get the corpse item.
 	std::string getCorpseItem() const;
+	/// Set the way units wearing the armor move.
+	void setMovementType(MovementType movementType);
+	/// Get the way units wearing the armor move.
+	MovementType getMovementType() const;
 };
 
 }
@@ -25,7 +25,7 @@ namespace OpenXcom
  * Creates a blank ruleset for a certain type of item.
  * @param type String defining the type.
  */
-RuleItem::RuleItem(std::string type) : _type(type), _size(0.0), _cost(0), _time(24), _damageType(DT_NONE), _accuracyAuto(0), _accuracySnap(0), _accuracyAimed(0), _battleType(BT_NONE), _twoHanded(false)
+RuleItem::RuleItem(std::string type) : _type(type), _size(0.0), _cost(0), _time(24), _weight(0), _bigSprite(0), _floorSprite(0), _handSprite(0), _bulletSprite(0), _fireSound(0), _hitSound(0), _hitAnimation(0), _power(0), _displayPriority(0), _width(0), _height(0), _compatibleAmmo(), _damageType(DT_NONE), _accuracyAuto(0), _accuracySnap(0), _accuracyAimed(0), _tuAuto(0), _tuSnap(0), _tuAimed(0), _ammoClip(0), _accuracyMelee(0), _tuMelee(0), _battleType(BT_NONE), _twoHanded(false), _waypoint(false), _sizeX(1), _sizeY(1)
 {
 }
 
@@ -36,6 +36,122 @@ RuleItem::~RuleItem()
 {
 }
 
+/**
+ * Loads the item from a YAML file. Only the stats
+ * in the node are changed, so a later ruleset can
+ * just change the ones it wants.
+ * @param node YAML node.
+ */
+void RuleItem::load(const YAML::Node &node)
+{
+	int a = 0;
+	for (YAML::Iterator i = node.begin(); i != node.end(); i++)
+	{
+		std::string key;
+		i.first() >> key;
+		if (key == "size")
+		{
+			i.second() >> _size;
+		}
+		else if (key == "cost")
+		{
+			i.second() >> _cost;
+		}
+		else if (key == "transferTime")
+		{
+			i.second() >> _time;
+		}
+		else if (key == "bigSprite")
+		{
+			i.second() >> _bigSprite;
+		}
+		else if (key == "floorSprite")
+		{
+			i.second() >> _floorSprite;
+		}
+		else if (key == "handSprite")
+		{
+			i.second() >> _handSprite;
+		}
+		else if (key == "bulletSprite")
+		{
+			i.second() >> _bulletSprite;
+		}
+		else if (key == "fireSound")
+		{
+			i.second() >> _fireSound;
+		}
+		else if (key == "hitSound")
+		{
+			i.second() >> _hitSound;
+		}
+		else if (key == "hitAnimation")
+		{
+			i.second() >> _hitAnimation;
+		}
+		else if (key == "power")
+		{
+			i.second() >> _power;
+		}
+		else if (key == "compatibleAmmo")
+		{
+			_compatibleAmmo.clear();
+			for (YAML::Iterator j = i.second().begin(); j != i.second().end(); j++)
+			{
+				std::string ammo;
+				*j >> ammo;
+				_compatibleAmmo.push_back(ammo);
+			}
+		}
+		else if (key == "damageType")
+		{
+			i.second() >> a;
+			_damageType = (ItemDamageType)a;
+		}
+		else if (key == "accuracyAuto")
+		{
+			i.second() >> _accuracyAuto;
+		}
+		else if (key == "accuracySnap")
+		{
+			i.second() >> _accuracySnap;
+		}
+		else if (key == "accuracyAimed")
+		{
+			i.second() >> _accuracyAimed;
+		}
+		else if (key == "tuAuto")
+		{
+			i.second() >> _tuAuto;
+		}
+		else if (key == "tuSnap")
+		{
+			i.second() >> _tuSnap;
+		}
+		else if (key == "tuAimed")
+		{
+			i.second() >> _tuAimed;
+		}
+		else if (key == "battleType")
+		{
+			i.second() >> a;
+			_battleType = (BattleType)a;
+		}
+		else if (key == "twoHanded")
+		{
+			i.second() >> _twoHanded;
+		}
+		else if (key == "invWidth")
+		{
+			i.second() >> _sizeX;
+		}
+		else if (key == "invHeight")
+		{
+			i.second() >> _sizeY;
+		}
+	}
+}
+
 /**
  * Returns the language string that names
  * this item. Each item type has a unique name.
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <vector>
+#include "yaml.h"
 
 enum ItemDamageType { DT_NONE, DT_AP, DT_IN, DT_HE, DT_LASER, DT_PLASMA, DT_STUN, DT_MELEE, DT_ACID, DT_SMOKE };
 enum BattleType { BT_NONE, BT_FIREARM, BT_AMMO, BT_MELEE, BT_GRENADE, BT_PROXIMITYGRENADE, BT_MEDIKIT, BT_SCANNER };
@@ -55,6 +56,8 @@ public:
 	RuleItem(std::string type);
 	/// Cleans up the item ruleset.
 	~RuleItem();
+	/// Loads item data from YAML.
+	void load(const YAML::Node& node);
 	/// Gets the item's type.
 	std::string getType() const;
 	/// Gets the item's size.
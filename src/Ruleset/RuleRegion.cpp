@@ -111,6 +111,34 @@ bool RuleRegion::insideRegion(double lon, double lat) const
 	return false;
 }
 
+/**
+ * Checks if any of the region's areas overlap an area
+ * of the world, so the region can be put in spatial indexes.
+ * @param lonMin Minimum longitude of the area (not wrapping around).
+ * @param lonMax Maximum longitude of the area.
+ * @param latMin Minimum latitude of the area.
+ * @param latMax Maximum latitude of the area.
+ * @return True if it overlaps, False otherwise.
+ */
+bool RuleRegion::overlapsRegion(double lonMin, double lonMax, double latMin, double latMax) const
+{
+	for (unsigned int i = 0; i < _lonMin.size(); i++)
+	{
+		bool inLon, inLat;
+
+		if (_lonMin[i] <= _lonMax[i])
+			inLon = (_lonMin[i] < lonMax && lonMin < _lonMax[i]);
+		else
+			inLon = (_lonMin[i] < lonMax || lonMin < _lonMax[i]);
+
+		inLat = (_latMin[i] < latMax && latMin < _latMax[i]);
+
+		if (inLon && inLat)
+			return true;
+	}
+	return false;
+}
+
 /**
  * Returns the list of cities contained.
  * @return Pointer to list.
@@ -54,6 +54,8 @@ public:
 	void addArea(double lonMin, double lonMax, double latMin, double latMax);
 	/// Checks if a point is inside the region.
 	bool insideRegion(double lon, double lat) const;
+	/// Checks if an area overlaps the region.
+	bool overlapsRegion(double lonMin, double lonMax, double latMin, double latMax) const;
 	/// Gets the cities in this region.
 	std::vector<City*> *const getCities();
 };
@@ -23,6 +23,7 @@
 #include "MapBlock.h"
 #include "MapDataSet.h"
 #include "../Engine/RNG.h"
+#include "../Engine/Exception.h"
 
 namespace OpenXcom
 {
@@ -30,7 +31,7 @@ namespace OpenXcom
 /**
 * RuleTerrain construction
 */
-RuleTerrain::RuleTerrain(const std::string &name) : _name(name)
+RuleTerrain::RuleTerrain(const std::string &name) : _name(name), _tableBlocks(0)
 {
 }
 
@@ -73,30 +74,92 @@ std::string RuleTerrain::getName()
 }
 
 /**
-* gets a random mapblock within the given constraints
-* @param maxsize maximum size of the mapblock (1 or 2)
+* builds the alias table of the mapblocks within the given constraints,
+* so one can be picked by frequency with a single random number (Vose's method)
+* @param maxsize maximum size of the mapblock (10 or 20)
 * @param landingzone whether this must be a landingzone (true) or don't care (false)
-* @return pointer to mapblock
+* @param table pointer to the table to fill
 */
-MapBlock* RuleTerrain::getRandomMapBlock(int maxsize, bool landingzone)
+void RuleTerrain::buildBlockTable(int maxsize, bool landingzone, MapBlockTable *table)
 {
-	MapBlock* mb = 0;
-
-	while (mb == 0)
+	int total = 0;
+	for (std::vector<MapBlock*>::iterator i = _mapBlocks.begin(); i != _mapBlocks.end(); i++)
 	{
-		int n = RNG::generate(0, _mapBlocks.size() - 1);
-		mb = _mapBlocks[n];
-		if (landingzone && !mb->isLandingZone())
+		if ((*i)->getFrequency() > 0 && maxsize >= (*i)->getWidth() && (!landingzone || (*i)->isLandingZone()))
 		{
-			mb = 0;
+			table->blocks.push_back(*i);
+			total += (*i)->getFrequency();
 		}
-		else if (maxsize < mb->getWidth())
+	}
+
+	int n = table->blocks.size();
+	table->chances.resize(n);
+	table->aliases.resize(n);
+	std::vector<int> small, large;
+	for (int i = 0; i < n; i++)
+	{
+		// scale so the average is 1, then split into the slots below and above it
+		table->chances[i] = (double)table->blocks[i]->getFrequency() * n / total;
+		table->aliases[i] = i;
+		if (table->chances[i] < 1.0)
+			small.push_back(i);
+		else
+			large.push_back(i);
+	}
+	while (!small.empty() && !large.empty())
+	{
+		int s = small.back(), l = large.back();
+		small.pop_back();
+		// the small slot is topped up with the large one
+		table->aliases[s] = l;
+		table->chances[l] -= 1.0 - table->chances[s];
+		if (table->chances[l] < 1.0)
 		{
-			mb = 0;
+			large.pop_back();
+			small.push_back(l);
 		}
 	}
-	
-	return mb;
+	// whatever is left over is full, give or take rounding
+	for (std::vector<int>::iterator i = small.begin(); i != small.end(); i++)
+		table->chances[*i] = 1.0;
+	for (std::vector<int>::iterator i = large.begin(); i != large.end(); i++)
+		table->chances[*i] = 1.0;
+}
+
+/**
+* gets a random mapblock within the given constraints, weighed by
+* the mapblock frequencies. The tables of candidates are built the
+* first time they're needed, and again if mapblocks were added.
+* @param maxsize maximum size of the mapblock (10 or 20)
+* @param landingzone whether this must be a landingzone (true) or don't care (false)
+* @return pointer to mapblock
+*/
+MapBlock* RuleTerrain::getRandomMapBlock(int maxsize, bool landingzone)
+{
+	if (_tableBlocks != _mapBlocks.size())
+	{
+		_blockTables.clear();
+		_tableBlocks = _mapBlocks.size();
+	}
+	std::pair<int, bool> key = std::make_pair(maxsize, landingzone);
+	std::map<std::pair<int, bool>, MapBlockTable>::iterator i = _blockTables.find(key);
+	if (i == _blockTables.end())
+	{
+		i = _blockTables.insert(std::make_pair(key, MapBlockTable())).first;
+		buildBlockTable(maxsize, landingzone, &i->second);
+	}
+
+	MapBlockTable *table = &i->second;
+	if (table->blocks.empty())
+	{
+		throw Exception("No mapblock of terrain " + _name + " fits");
+	}
+	int n = RNG::generate(0, (int)table->blocks.size() - 1, RNG_BATTLE);
+	if (RNG::generate(0.0, 1.0, RNG_BATTLE) >= table->chances[n])
+	{
+		n = table->aliases[n];
+	}
+	return table->blocks[n];
 }
 
 /**
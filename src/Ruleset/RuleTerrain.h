@@ -39,9 +39,19 @@ class MapData;
 class RuleTerrain
 {
 private:
+	/// Alias table of the mapblocks that fit some constraints, to pick one of them by frequency.
+	struct MapBlockTable
+	{
+		std::vector<MapBlock*> blocks;
+		std::vector<double> chances;
+		std::vector<int> aliases;
+	};
 	std::vector<MapDataSet*> _mapDataFiles;
 	std::vector<MapBlock*> _mapBlocks;
 	std::string _name;
+	std::map<std::pair<int, bool>, MapBlockTable> _blockTables;
+	size_t _tableBlocks;
+	void buildBlockTable(int maxsize, bool landingzone, MapBlockTable *table);
 public:
 	RuleTerrain(const std::string &name);
 	~RuleTerrain();
@@ -17,6 +17,9 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Ruleset.h"
+#include <fstream>
+#include "yaml.h"
+#include "../Engine/Exception.h"
 #include "SoldierNamePool.h"
 #include "RuleCountry.h"
 #include "RuleRegion.h"
@@ -34,6 +37,24 @@
 namespace OpenXcom
 {
 
+/**
+ * Looks up a rule by its string ID, without
+ * adding empty entries for unknown IDs.
+ * @param rules Map of rules.
+ * @param id Rule ID.
+ * @return Pointer to the rule, or 0 if there's none.
+ */
+template <typename T>
+static T *findRule(const std::map<std::string, T*> &rules, const std::string &id)
+{
+	typename std::map<std::string, T*>::const_iterator i = rules.find(id);
+	if (i == rules.end())
+	{
+		return 0;
+	}
+	return i->second;
+}
+
 /**
  * Creates a ruleset with blank sets of rules.
  */
@@ -100,6 +121,43 @@ Ruleset::~Ruleset()
 	}
 }
 
+/**
+ * Loads rules from a YAML ruleset file in the data folder,
+ * on top of the rules already in the ruleset. Rules with the
+ * ID of an existing one change it, the rest are added.
+ * @param filename Name of the ruleset, without the extension.
+ */
+void Ruleset::load(const std::string &filename)
+{
+	std::string s = "./DATA/Ruleset/" + filename + ".rul";
+	std::ifstream fin(s.c_str());
+	if (!fin)
+	{
+		throw Exception("Failed to load ruleset");
+	}
+	YAML::Parser parser(fin);
+	YAML::Node doc;
+	parser.GetNextDocument(doc);
+
+	if (const YAML::Node *items = doc.FindValue("items"))
+	{
+		for (YAML::Iterator i = items->begin(); i != items->end(); i++)
+		{
+			std::string type;
+			(*i)["type"] >> type;
+			RuleItem *rule = findRule(_items, type);
+			if (rule == 0)
+			{
+				rule = new RuleItem(type);
+				_items.insert(std::pair<std::string, RuleItem*>(type, rule));
+			}
+			rule->load(*i);
+		}
+	}
+
+	fin.close();
+}
+
 /**
  * Generates a brand new blank saved game.
  * @param diff Difficulty for the save.
@@ -126,9 +184,9 @@ std::vector<SoldierNamePool*> *const Ruleset::getPools()
  * @param id Country type.
  * @return Rules for the country.
  */
-RuleCountry *const Ruleset::getCountry(std::string id)
+RuleCountry *const Ruleset::getCountry(const std::string &id)
 {
-	return _countries[id];
+	return findRule(_countries, id);
 }
 
 /**
@@ -136,9 +194,9 @@ RuleCountry *const Ruleset::getCountry(std::string id)
  * @param id Region type.
  * @return Rules for the region.
  */
-RuleRegion *const Ruleset::getRegion(std::string id)
+RuleRegion *const Ruleset::getRegion(const std::string &id)
 {
-	return _regions[id];
+	return findRule(_regions, id);
 }
 
 /**
@@ -146,9 +204,9 @@ RuleRegion *const Ruleset::getRegion(std::string id)
  * @param id Facility type.
  * @return Rules for the facility.
  */
-RuleBaseFacility *const Ruleset::getBaseFacility(std::string id)
+RuleBaseFacility *const Ruleset::getBaseFacility(const std::string &id)
 {
-	return _facilities[id];
+	return findRule(_facilities, id);
 }
 
 /**
@@ -156,9 +214,9 @@ RuleBaseFacility *const Ruleset::getBaseFacility(std::string id)
  * @param id Craft type.
  * @return Rules for the craft.
  */
-RuleCraft *const Ruleset::getCraft(std::string id)
+RuleCraft *const Ruleset::getCraft(const std::string &id)
 {
-	return _crafts[id];
+	return findRule(_crafts, id);
 }
 
 /**
@@ -166,18 +224,18 @@ RuleCraft *const Ruleset::getCraft(std::string id)
  * @param id Craft weapon type.
  * @return Rules for the craft weapon.
  */
-RuleCraftWeapon *const Ruleset::getCraftWeapon(std::string id)
+RuleCraftWeapon *const Ruleset::getCraftWeapon(const std::string &id)
 {
-	return _craftWeapons[id];
+	return findRule(_craftWeapons, id);
 }
 /**
  * Returns the rules for the specified item.
  * @param id Item type.
  * @return Rules for the item.
  */
-RuleItem *const Ruleset::getItem(std::string id)
+RuleItem *const Ruleset::getItem(const std::string &id)
 {
-	return _items[id];
+	return findRule(_items, id);
 }
 
 /**
@@ -185,9 +243,9 @@ RuleItem *const Ruleset::getItem(std::string id)
  * @param id UFO type.
  * @return Rules for the UFO.
  */
-RuleUfo *const Ruleset::getUfo(std::string id)
+RuleUfo *const Ruleset::getUfo(const std::string &id)
 {
-	return _ufos[id];
+	return findRule(_ufos, id);
 }
 
 /**
@@ -195,9 +253,9 @@ RuleUfo *const Ruleset::getUfo(std::string id)
  * @param name terrain name.
  * @return Rules for the terrain.
  */
-RuleTerrain *const Ruleset::getTerrain(std::string name)
+RuleTerrain *const Ruleset::getTerrain(const std::string &name)
 {
-	return _terrains[name];
+	return findRule(_terrains, name);
 }
 
 /**
@@ -205,9 +263,9 @@ RuleTerrain *const Ruleset::getTerrain(std::string name)
  * @param name datafile name.
  * @return Rules for the datafile.
  */
-MapDataSet *const Ruleset::getMapDataSet(std::string name)
+MapDataSet *const Ruleset::getMapDataSet(const std::string &name)
 {
-	return _mapDataFiles[name];
+	return findRule(_mapDataFiles, name);
 }
 
 /**
@@ -215,9 +273,9 @@ MapDataSet *const Ruleset::getMapDataSet(std::string name)
  * @param name Unit name.
  * @return Rules for the units.
  */
-RuleSoldier *const Ruleset::getSoldier(std::string name)
+RuleSoldier *const Ruleset::getSoldier(const std::string &name)
 {
-	return _soldiers[name];
+	return findRule(_soldiers, name);
 }
 
 /**
@@ -225,9 +283,9 @@ RuleSoldier *const Ruleset::getSoldier(std::string name)
  * @param name Unit name.
  * @return Rules for the units.
  */
-RuleAlien *const Ruleset::getAlien(std::string name)
+RuleAlien *const Ruleset::getAlien(const std::string &name)
 {
-	return _aliens[name];
+	return findRule(_aliens, name);
 }
 
 /**
@@ -235,9 +293,9 @@ RuleAlien *const Ruleset::getAlien(std::string name)
  * @param name Armor name.
  * @return Rules for the armor.
  */
-RuleArmor *const Ruleset::getArmor(std::string name)
+RuleArmor *const Ruleset::getArmor(const std::string &name)
 {
-	return _armors[name];
+	return findRule(_armors, name);
 }
 
 /**
@@ -285,9 +343,9 @@ int Ruleset::getPersonnelTime() const
  * @param name Article name.
  * @return Article definition.
  */
-ArticleDefinition *Ruleset::getUfopaediaArticle(std::string name)
+ArticleDefinition *Ruleset::getUfopaediaArticle(const std::string &name)
 {
-	return _ufopaediaArticles[name];
+	return findRule(_ufopaediaArticles, name);
 }
 
 }
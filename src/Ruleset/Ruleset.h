@@ -72,36 +72,38 @@ public:
 	Ruleset();
 	/// Cleans up the ruleset.
 	virtual ~Ruleset();
+	/// Loads a ruleset from a YAML file.
+	void load(const std::string &filename);
 	/// Generates the starting saved game.
 	virtual SavedGame *newSave(GameDifficulty diff);
 	/// Gets the pool list for soldier names.
 	std::vector<SoldierNamePool*> *const getPools();
 	/// Gets the ruleset for a country type.
-	RuleCountry *const getCountry(std::string id);
+	RuleCountry *const getCountry(const std::string &id);
 	/// Gets the ruleset for a region type.
-	RuleRegion *const getRegion(std::string id);
+	RuleRegion *const getRegion(const std::string &id);
 	/// Gets the ruleset for a facility type.
-	RuleBaseFacility *const getBaseFacility(std::string id);
+	RuleBaseFacility *const getBaseFacility(const std::string &id);
 	/// Gets the ruleset for a craft type.
-	RuleCraft *const getCraft(std::string id);
+	RuleCraft *const getCraft(const std::string &id);
 	/// Gets the ruleset for a craft weapon type.
-	RuleCraftWeapon *const getCraftWeapon(std::string id);
+	RuleCraftWeapon *const getCraftWeapon(const std::string &id);
 	/// Gets the ruleset for an item type.
-	RuleItem *const getItem(std::string id);
+	RuleItem *const getItem(const std::string &id);
 	/// Gets the ruleset for a UFO type.
-	RuleUfo *const getUfo(std::string id);
+	RuleUfo *const getUfo(const std::string &id);
 	/// Gets terrains for battlescape games.
-	RuleTerrain *const getTerrain(std::string name);
+	RuleTerrain *const getTerrain(const std::string &name);
 	/// Gets mapdatafile for battlescape games.
-	MapDataSet *const getMapDataSet(std::string name);
+	MapDataSet *const getMapDataSet(const std::string &name);
 	/// Gets unit rules.
-	RuleSoldier *const getSoldier(std::string name);
+	RuleSoldier *const getSoldier(const std::string &name);
 	/// Gets unit rules.
-	RuleAlien *const getAlien(std::string name);
+	RuleAlien *const getAlien(const std::string &name);
 	/// Gets armor rules.
-	RuleArmor *const getArmor(std::string name);
+	RuleArmor *const getArmor(const std::string &name);
 	/// Gets Ufopaedia article definition.
-	ArticleDefinition *getUfopaediaArticle(std::string name);
+	ArticleDefinition *getUfopaediaArticle(const std::string &name);
 	/// Gets the cost of a soldier.
 	int getSoldierCost() const;
 	/// Gets the cost of an engineer.
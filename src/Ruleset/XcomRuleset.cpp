@@ -630,263 +630,7 @@ XcomRuleset::XcomRuleset() : Ruleset()
 	_craftWeapons.insert(std::pair<std::string, RuleCraftWeapon*>("STR_PLASMA_BEAM_UC", plasma));
 
 	// Add items
-	RuleItem *slauncher = new RuleItem("STR_STINGRAY_LAUNCHER");
-	slauncher->setSize(0.8f);
-	slauncher->setCost(16000);
-	slauncher->setTransferTime(48);
-
-	RuleItem *alauncher = new RuleItem("STR_AVALANCHE_LAUNCHER");
-	alauncher->setSize(1.0f);
-	alauncher->setCost(17000);
-	alauncher->setTransferTime(48);
-
-	RuleItem *icannon = new RuleItem("STR_CANNON");
-	icannon->setSize(1.5f);
-	icannon->setCost(30000);
-	icannon->setTransferTime(48);
-
-	RuleItem *smissile = new RuleItem("STR_STINGRAY_MISSILES");
-	smissile->setSize(0.4f);
-	smissile->setCost(3000);
-	smissile->setTransferTime(48);
-
-	RuleItem *amissile = new RuleItem("STR_AVALANCHE_MISSILES");
-	amissile->setSize(1.5f);
-	amissile->setCost(9000);
-	amissile->setTransferTime(48);
-
-	RuleItem *crounds = new RuleItem("STR_CANNON_ROUNDS_X50");
-	crounds->setSize(0.0f);
-	crounds->setCost(1240);
-	crounds->setTransferTime(96);
-
-	RuleItem *pistol = new RuleItem("STR_PISTOL");
-	pistol->setSize(0.1f);
-	pistol->setCost(800);
-	pistol->setBigSprite(3);
-	pistol->setHandSprite(96);
-	pistol->setBulletSprite(1);
-	pistol->setFireSound(4);
-	pistol->setAccuracySnap(60);
-	pistol->setAccuracyAimed(78);
-	pistol->getCompatibleAmmo()->push_back("STR_PISTOL_CLIP");
-	pistol->setBattleType(BT_FIREARM);
-	pistol->setSizeX(1);
-	pistol->setSizeY(2);
-
-	RuleItem *pclip = new RuleItem("STR_PISTOL_CLIP");
-	pclip->setSize(0.1f);
-	pclip->setCost(70);
-	pclip->setBigSprite(4);
-	pclip->setHandSprite(120);
-	pclip->setPower(26);
-	pclip->setDamageType(DT_AP);
-	pclip->setBattleType(BT_AMMO);
-	pclip->setHitAnimation(26);
-	pclip->setHitSound(22);
-	pclip->setSizeX(1);
-	pclip->setSizeY(1);
-	
-	RuleItem *rifle = new RuleItem("STR_RIFLE");
-	rifle->setSize(0.2f);
-	rifle->setCost(3000);
-	rifle->setBigSprite(1);
-	rifle->setHandSprite(0);
-	rifle->setTwoHanded(true);
-	rifle->setBulletSprite(2);
-	rifle->setFireSound(4);
-	rifle->setAccuracyAuto(35);
-	rifle->setAccuracySnap(60);
-	rifle->setAccuracyAimed(110);
-	rifle->getCompatibleAmmo()->push_back("STR_RIFLE_CLIP");
-	rifle->setBattleType(BT_FIREARM);
-	rifle->setSizeX(1);
-	rifle->setSizeY(3);
-
-	RuleItem *rclip = new RuleItem("STR_RIFLE_CLIP");
-	rclip->setSize(0.1f);
-	rclip->setCost(200);
-	rclip->setBigSprite(2);
-	rclip->setHandSprite(120);
-	rclip->setPower(30);
-	rclip->setDamageType(DT_AP);
-	rclip->setBattleType(BT_AMMO);
-	rclip->setHitAnimation(26);
-	rclip->setHitSound(22);
-	rclip->setSizeX(1);
-	rclip->setSizeY(1);
-
-	RuleItem *hcannon = new RuleItem("STR_HEAVY_CANNON");
-	hcannon->setSize(0.3f);
-	hcannon->setCost(6400);
-	hcannon->setBigSprite(11);
-	hcannon->setHandSprite(24);
-	hcannon->setTwoHanded(true);
-	hcannon->setBulletSprite(4);
-	hcannon->setFireSound(12);
-	hcannon->setAccuracySnap(60);
-	hcannon->setAccuracyAimed(90);
-	hcannon->getCompatibleAmmo()->push_back("STR_HC_AP_AMMO");
-	hcannon->getCompatibleAmmo()->push_back("STR_HC_HE_AMMO");
-	hcannon->getCompatibleAmmo()->push_back("STR_HC_IN_AMMO");
-	hcannon->setBattleType(BT_FIREARM);
-	hcannon->setSizeX(2);
-	hcannon->setSizeY(3);
-
-	RuleItem *hcap = new RuleItem("STR_HC_AP_AMMO");
-	hcap->setSize(0.1f);
-	hcap->setCost(300);
-	hcap->setBigSprite(12);
-	hcap->setHandSprite(120);
-	hcap->setPower(56);
-	hcap->setDamageType(DT_AP);
-	hcap->setBattleType(BT_AMMO);
-	hcap->setHitAnimation(26);
-	hcap->setHitSound(13);
-	hcap->setSizeX(1);
-	hcap->setSizeY(1);
-
-	RuleItem *hche = new RuleItem("STR_HC_HE_AMMO");
-	hche->setSize(0.1f);
-	hche->setCost(500);
-	hche->setBigSprite(13);
-	hche->setHandSprite(120);
-	hche->setPower(52);
-	hche->setDamageType(DT_HE);
-	hche->setBattleType(BT_AMMO);
-	hche->setHitAnimation(0);
-	hche->setHitSound(0);
-	hche->setSizeX(1);
-	hche->setSizeY(1);
-
-	RuleItem *hcin = new RuleItem("STR_HC_IN_AMMO");
-	hcin->setSize(0.1f);
-	hcin->setCost(400);
-	hcin->setBigSprite(14);
-	hcin->setHandSprite(120);
-	hcin->setPower(60);
-	hcin->setDamageType(DT_IN);
-	hcin->setBattleType(BT_AMMO);
-	hcin->setHitAnimation(0);
-	hcin->setHitSound(0);
-	hcin->setSizeX(1);
-	hcin->setSizeY(1);
-
-	RuleItem *acannon = new RuleItem("STR_AUTO_CANNON");
-	acannon->setSize(0.3f);
-	acannon->setCost(13500);
-	acannon->setBigSprite(7);
-	acannon->setHandSprite(32);
-	acannon->setTwoHanded(true);
-	acannon->setBulletSprite(3);
-	acannon->setFireSound(12);
-	acannon->setAccuracyAuto(32);
-	acannon->setAccuracySnap(56);
-	acannon->setAccuracyAimed(82);
-	acannon->getCompatibleAmmo()->push_back("STR_AC_AP_AMMO");
-	acannon->getCompatibleAmmo()->push_back("STR_AC_HE_AMMO");
-	acannon->getCompatibleAmmo()->push_back("STR_AC_IN_AMMO");
-	acannon->setBattleType(BT_FIREARM);
-	acannon->setSizeX(2);
-	acannon->setSizeY(3);
-	
-	RuleItem *acap = new RuleItem("STR_AC_AP_AMMO");
-	acap->setSize(0.1f);
-	acap->setCost(500);
-	acap->setBigSprite(8);
-	acap->setHandSprite(120);
-	acap->setPower(42);
-	acap->setDamageType(DT_AP);
-	acap->setBattleType(BT_AMMO);
-	acap->setHitSound(13);
-	acap->setHitAnimation(26);
-	acap->setSizeX(1);
-	acap->setSizeY(1);
-
-	RuleItem *rlauncher = new RuleItem("STR_ROCKET_LAUNCHER");
-	rlauncher->setSize(0.4f);
-	rlauncher->setCost(4000);
-	rlauncher->setBigSprite(15);
-	rlauncher->setHandSprite(9);
-	rlauncher->setTwoHanded(true);
-	rlauncher->setBulletSprite(0);
-	rlauncher->setFireSound(52);
-	rlauncher->setAccuracySnap(55);
-	rlauncher->setAccuracyAimed(115);
-	rlauncher->getCompatibleAmmo()->push_back("STR_SMALL_ROCKET");
-	rlauncher->setBattleType(BT_FIREARM);
-	rlauncher->setSizeX(2);
-	rlauncher->setSizeY(3);
-
-	RuleItem *srocket = new RuleItem("STR_SMALL_ROCKET");
-	srocket->setSize(0.2f);
-	srocket->setCost(600);
-	srocket->setBigSprite(16);
-	srocket->setHandSprite(120);
-	srocket->setPower(75);
-	srocket->setDamageType(DT_HE);
-	srocket->setBattleType(BT_AMMO);
-	srocket->setHitSound(0);
-	srocket->setHitAnimation(0);
-	srocket->setSizeX(1);
-	srocket->setSizeY(3);
-
-	RuleItem *grenade = new RuleItem("STR_GRENADE");
-	grenade->setSize(0.1f);
-	grenade->setCost(300);
-	grenade->setBigSprite(19);
-	grenade->setHandSprite(120);
-	grenade->setPower(50);
-	grenade->setDamageType(DT_HE);
-	grenade->setBattleType(BT_GRENADE);
-	grenade->setSizeX(1);
-	grenade->setSizeY(1);
-
-	RuleItem *sgrenade = new RuleItem("STR_SMOKE_GRENADE");
-	sgrenade->setSize(0.1f);
-	sgrenade->setCost(150);
-	sgrenade->setBigSprite(20);
-	sgrenade->setHandSprite(120);
-	sgrenade->setPower(60);
-	sgrenade->setDamageType(DT_SMOKE);
-	sgrenade->setBattleType(BT_GRENADE);
-	sgrenade->setSizeX(1);
-	sgrenade->setSizeY(1);
-
-	RuleItem *corpse = new RuleItem("STR_CORPSE");
-	corpse->setBigSprite(45);
-	corpse->setFloorSprite(39);
-	corpse->setSizeX(2);
-	corpse->setSizeY(3);
-
-	RuleItem *scorpse = new RuleItem("STR_SECTOID_CORPSE");
-	scorpse->setBigSprite(46);
-	scorpse->setFloorSprite(42);
-	scorpse->setSizeX(2);
-	scorpse->setSizeY(3);
-
-	_items.insert(std::pair<std::string, RuleItem*>("STR_STINGRAY_LAUNCHER", slauncher));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_AVALANCHE_LAUNCHER", alauncher));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_CANNON", icannon));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_STINGRAY_MISSILES", smissile));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_AVALANCHE_MISSILES", amissile));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_CANNON_ROUNDS_X50", crounds));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_PISTOL", pistol));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_PISTOL_CLIP", pclip));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_RIFLE", rifle));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_RIFLE_CLIP", rclip));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_HEAVY_CANNON", hcannon));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_HC_AP_AMMO", hcap));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_HC_HE_AMMO", hche));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_HC_IN_AMMO", hcin));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_AUTO_CANNON", acannon));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_AC_AP_AMMO", acap));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_ROCKET_LAUNCHER", rlauncher));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_SMALL_ROCKET", srocket));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_GRENADE", grenade));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_SMOKE_GRENADE", sgrenade));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_CORPSE", corpse));
-	_items.insert(std::pair<std::string, RuleItem*>("STR_SECTOID_CORPSE", scorpse));
+	load("Xcom1Ruleset");
 
 	// Add UFOs
 	RuleUfo *sscout = new RuleUfo("STR_SMALL_SCOUT");
@@ -1148,6 +892,7 @@ XcomRuleset::XcomRuleset() : Ruleset()
 
 	RuleArmor *flyingSuit = new RuleArmor("STR_FLYING_SUIT_UC", "XCOM_2.PCK");
 	flyingSuit->setArmor(110, 90, 80, 70);
+	flyingSuit->setMovementType(MT_FLY);
 
 	RuleArmor *sectoidSoldierArmor = new RuleArmor("SECTOID_ARMOR0", "SECTOID.PCK");
 	sectoidSoldierArmor->setArmor(4, 3, 2, 2);
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _USE_MATH_DEFINES
+#include "AlienSchedule.h"
+#include <cmath>
+#include "GameTime.h"
+#include "Ufo.h"
+#include "Waypoint.h"
+#include "../Engine/RNG.h"
+#include "../Ruleset/Ruleset.h"
+#include "../Ruleset/RuleUfo.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Initializes a schedule with nothing planned.
+ */
+AlienSchedule::AlienSchedule() : _spawns(), _slot(0), _slots(0), _next(0)
+{
+}
+
+/**
+ * Cleans up the schedule.
+ */
+AlienSchedule::~AlienSchedule()
+{
+}
+
+/**
+ * Loads the schedule from a YAML file.
+ * @param node YAML node.
+ */
+void AlienSchedule::load(const YAML::Node &node)
+{
+	node["slot"] >> _slot;
+	node["slots"] >> _slots;
+	const YAML::Node &spawns = node["spawns"];
+	_spawns.clear();
+	for (unsigned int i = 0; i < spawns.size(); i++)
+	{
+		UfoSpawn s;
+		spawns[i]["slot"] >> s.slot;
+		spawns[i]["type"] >> s.type;
+		spawns[i]["lon"] >> s.lon;
+		spawns[i]["lat"] >> s.lat;
+		spawns[i]["destLon"] >> s.destLon;
+		spawns[i]["destLat"] >> s.destLat;
+		spawns[i]["speed"] >> s.speed;
+		_spawns.push_back(s);
+	}
+	_next = 0;
+}
+
+/**
+ * Saves the UFOs still to come to a YAML file.
+ * @param out YAML emitter.
+ */
+void AlienSchedule::save(YAML::Emitter &out) const
+{
+	out << YAML::BeginMap;
+	out << YAML::Key << "slot" << YAML::Value << _slot;
+	out << YAML::Key << "slots" << YAML::Value << _slots;
+	out << YAML::Key << "spawns" << YAML::Value;
+	out << YAML::BeginSeq;
+	for (std::vector<UfoSpawn>::const_iterator i = _spawns.begin() + _next; i != _spawns.end(); i++)
+	{
+		out << YAML::Flow << YAML::BeginMap;
+		out << YAML::Key << "slot" << YAML::Value << i->slot;
+		out << YAML::Key << "type" << YAML::Value << i->type;
+		out << YAML::Key << "lon" << YAML::Value << i->lon;
+		out << YAML::Key << "lat" << YAML::Value << i->lat;
+		out << YAML::Key << "destLon" << YAML::Value << i->destLon;
+		out << YAML::Key << "destLat" << YAML::Value << i->destLat;
+		out << YAML::Key << "speed" << YAML::Value << i->speed;
+		out << YAML::EndMap;
+	}
+	out << YAML::EndSeq;
+	out << YAML::EndMap;
+}
+
+/**
+ * Works out all the UFOs the aliens send out from now until
+ * the end of the month, half an hour at a time. A new scout
+ * has an even chance of showing up every half hour, flying
+ * from anywhere on the globe to anywhere else.
+ * @param rule Pointer to ruleset.
+ * @param time Current game time, right on a half hour.
+ */
+void AlienSchedule::plan(Ruleset *rule, const GameTime *time)
+{
+	const char *types[] = { "STR_SMALL_SCOUT", "STR_MEDIUM_SCOUT", "STR_LARGE_SCOUT" };
+	_slot = 0;
+	_slots = (time->getMonthDays() - time->getDay()) * 48 + (23 - time->getHour()) * 2 + (time->getMinute() < 30 ? 2 : 1);
+	_spawns.clear();
+	_next = 0;
+	for (int i = 0; i < _slots; i++)
+	{
+		if (RNG::generate(1, 100) > 50)
+			continue;
+
+		UfoSpawn s;
+		s.slot = i;
+		s.type = types[RNG::generate(0, 2)];
+		s.lon = RNG::generate(0.0, 2*M_PI);
+		s.lat = RNG::generate(-M_PI/2, M_PI/2);
+		s.destLon = RNG::generate(0.0, 2*M_PI);
+		s.destLat = RNG::generate(-M_PI/2, M_PI/2);
+		int maxSpeed = rule->getUfo(s.type)->getMaxSpeed();
+		s.speed = RNG::generate(maxSpeed / 4, maxSpeed / 2);
+		_spawns.push_back(s);
+	}
+}
+
+/**
+ * Returns whether the schedule still has half hours
+ * of the month left to go through.
+ * @return True if it's planned.
+ */
+bool AlienSchedule::isPlanned() const
+{
+	return _slot < _slots;
+}
+
+/**
+ * Sends out the UFOs planned for the current half hour,
+ * and moves on to the next one.
+ * @param rule Pointer to ruleset.
+ * @param ufos Pointer to the list of UFOs on the globe.
+ */
+void AlienSchedule::advance(Ruleset *rule, std::vector<Ufo*> *ufos)
+{
+	for (; _next < _spawns.size() && _spawns[_next].slot <= _slot; _next++)
+	{
+		const UfoSpawn &s = _spawns[_next];
+		Ufo *u = new Ufo(rule->getUfo(s.type));
+		u->setLongitude(s.lon);
+		u->setLatitude(s.lat);
+		Waypoint *w = new Waypoint();
+		w->setLongitude(s.destLon);
+		w->setLatitude(s.destLat);
+		u->setDestination(w);
+		u->setSpeed(s.speed);
+		ufos->push_back(u);
+	}
+	_slot++;
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_ALIENSCHEDULE_H
+#define OPENXCOM_ALIENSCHEDULE_H
+
+#include <string>
+#include <vector>
+#include "yaml.h"
+
+namespace OpenXcom
+{
+
+class Ruleset;
+class GameTime;
+class Ufo;
+
+/**
+ * The alien activity planned for the rest of the month.
+ * Every UFO the aliens send out is worked out when the month
+ * starts, down to the half hour it shows up, where it comes
+ * from and where it's headed, and only turned into a UFO on
+ * the globe once its half hour comes around.
+ */
+class AlienSchedule
+{
+private:
+	/// A UFO planned to show up at a certain half hour.
+	struct UfoSpawn
+	{
+		int slot;
+		std::string type;
+		double lon, lat, destLon, destLat;
+		int speed;
+	};
+	std::vector<UfoSpawn> _spawns;
+	int _slot, _slots;
+	size_t _next;
+public:
+	/// Creates an empty schedule.
+	AlienSchedule();
+	/// Cleans up the schedule.
+	~AlienSchedule();
+	/// Loads the schedule from YAML.
+	void load(const YAML::Node& node);
+	/// Saves the schedule to YAML.
+	void save(YAML::Emitter& out) const;
+	/// Plans the alien activity for the rest of the month.
+	void plan(Ruleset *rule, const GameTime *time);
+	/// Gets whether there's any of the month left to go through.
+	bool isPlanned() const;
+	/// Moves on half an hour, sending out the UFOs due.
+	void advance(Ruleset *rule, std::vector<Ufo*> *ufos);
+};
+
+}
+
+#endif
@@ -39,7 +39,7 @@ namespace OpenXcom
  * Initializes an empty base.
  * @param rule Pointer to ruleset.
  */
-Base::Base(Ruleset *rule) : Target(), _rule(rule), _name(L""), _facilities(), _soldiers(), _crafts(), _scientists(0), _engineers(0)
+Base::Base(Ruleset *rule) : Target(), _rule(rule), _name(L""), _facilities(), _soldiers(), _crafts(), _transfers(), _projects(), _scientists(0), _engineers(0), _totals(), _totalsDirty(true)
 {
 	_items = new ItemContainer();
 }
@@ -61,15 +61,19 @@ Base::~Base()
 	{
 		delete *i;
 	}
+	for (std::vector<Project*>::iterator i = _projects.begin(); i != _projects.end(); i++)
+	{
+		delete *i;
+	}
 	delete _items;
 }
 
 /**
- * Loads the base from a YAML file.
+ * Loads the base from a YAML file. Only the base itself
+ * is changed, so several bases can be loaded at once.
  * @param node YAML node.
- * @param save Pointer to saved game.
  */
-void Base::load(const YAML::Node &node, SavedGame *save)
+void Base::load(const YAML::Node &node)
 {
 	unsigned int size = 0;
 
@@ -78,27 +82,95 @@ void Base::load(const YAML::Node &node, SavedGame *save)
 	node["name"] >> name;
 	_name = Language::utf8ToWstr(name);
 
-	size = node["facilities"].size();
+	const YAML::Node &facilities = node["facilities"];
+	size = facilities.size();
 	for (unsigned int i = 0; i < size; i++)
 	{
 		int x, y;
-		node["facilities"][i]["x"] >> x;
-		node["facilities"][i]["y"] >> y;
+		facilities[i]["x"] >> x;
+		facilities[i]["y"] >> y;
 		std::string type;
-		node["facilities"][i]["type"] >> type;
+		facilities[i]["type"] >> type;
 		BaseFacility *f = new BaseFacility(_rule->getBaseFacility(type), this, x, y);
-		f->load(node["facilities"][i]);
+		f->load(facilities[i]);
 		_facilities.push_back(f);
 	}
+	_totalsDirty = true;
 
-	size = node["crafts"].size();
+	const YAML::Node &crafts = node["crafts"];
+	size = crafts.size();
 	for (unsigned int i = 0; i < size; i++)
 	{
 		std::string type;
-		node["crafts"][i]["type"] >> type;
+		crafts[i]["type"] >> type;
 		Craft *c = new Craft(_rule->getCraft(type), this);
-		c->load(node["crafts"][i], _rule);
-		if (const YAML::Node *pName = node["crafts"][i].FindValue("dest"))
+		c->load(crafts[i], _rule);
+		_crafts.push_back(c);
+	}
+
+	const YAML::Node &soldiers = node["soldiers"];
+	size = soldiers.size();
+	for (unsigned int i = 0; i < size; i++)
+	{
+		Soldier *s = new Soldier(_rule->getSoldier("XCOM"), _rule->getArmor("STR_NONE_UC"));
+		s->load(soldiers[i]);
+		if (const YAML::Node *pName = soldiers[i].FindValue("craft"))
+		{
+			std::string type;
+			int id;
+			(*pName)["type"] >> type;
+			(*pName)["id"] >> id;
+			for (std::vector<Craft*>::iterator i = _crafts.begin(); i != _crafts.end(); i++)
+			{
+				if ((*i)->getRules()->getType() == type && (*i)->getId() == id)
+				{
+					s->setCraft(*i);
+					break;
+				}
+			}
+		}
+		_soldiers.push_back(s);
+	}
+
+	_items->load(node["items"]);
+	node["scientists"] >> _scientists;
+	node["engineers"] >> _engineers;
+
+	const YAML::Node &transfers = node["transfers"];
+	size = transfers.size();
+	for (unsigned int i = 0; i < size; i++)
+	{
+		Transfer *t = new Transfer(0);
+		t->load(transfers[i], this, _rule);
+		_transfers.push_back(t);
+	}
+
+	if (const YAML::Node *pName = node.FindValue("projects"))
+	{
+		size = pName->size();
+		for (unsigned int i = 0; i < size; i++)
+		{
+			Project *p = new Project(PROJECT_RESEARCH, "", 0);
+			p->load((*pName)[i]);
+			_projects.push_back(p);
+		}
+	}
+}
+
+/**
+ * Loads the destinations of the base's crafts from a YAML file.
+ * They point at UFOs and waypoints of the whole game,
+ * so this is done after all the bases are loaded.
+ * @param node YAML node.
+ * @param save Pointer to saved game.
+ */
+void Base::loadCraftDestinations(const YAML::Node &node, SavedGame *save)
+{
+	const YAML::Node &crafts = node["crafts"];
+	for (unsigned int j = 0; j < crafts.size() && j < _crafts.size(); j++)
+	{
+		Craft *c = _crafts[j];
+		if (const YAML::Node *pName = crafts[j].FindValue("dest"))
 		{
 			std::string type;
 			int id;
@@ -131,44 +203,6 @@ void Base::load(const YAML::Node &node, SavedGame *save)
 				}
 			}
 		}
-		_crafts.push_back(c);
-	}
-
-	size = node["soldiers"].size();
-	for (unsigned int i = 0; i < size; i++)
-	{
-		Soldier *s = new Soldier(_rule->getSoldier("XCOM"), _rule->getArmor("STR_NONE_UC"));
-		s->load(node["soldiers"][i]);
-		if (const YAML::Node *pName = node["soldiers"][i].FindValue("craft"))
-		{
-			std::string type;
-			int id;
-			(*pName)["type"] >> type;
-			(*pName)["id"] >> id;
-			for (std::vector<Craft*>::iterator i = _crafts.begin(); i != _crafts.end(); i++)
-			{
-				if ((*i)->getRules()->getType() == type && (*i)->getId() == id)
-				{
-					s->setCraft(*i);
-					break;
-				}
-			}
-		}
-		_soldiers.push_back(s);
-	}
-
-	_items->load(node["items"]);
-	node["scientists"] >> _scientists;
-	node["engineers"] >> _engineers;
-
-	size = node["transfers"].size();
-	for (unsigned int i = 0; i < size; i++)
-	{
-		int hours;
-		node["transfers"][i]["hours"] >> hours;
-		Transfer *t = new Transfer(hours);
-		t->load(node["transfers"][i], this, _rule);
-		_transfers.push_back(t);
 	}
 }
 
@@ -208,6 +242,17 @@ void Base::save(YAML::Emitter &out) const
 	out << YAML::Key << "transfers" << YAML::Value;
 	out << YAML::BeginSeq;
 	for (std::vector<Transfer*>::const_iterator i = _transfers.begin(); i != _transfers.end(); i++)
+	{
+		// delivered transfers are already part of the base
+		if (!(*i)->isDelivered())
+		{
+			(*i)->save(out);
+		}
+	}
+	out << YAML::EndSeq;
+	out << YAML::Key << "projects" << YAML::Value;
+	out << YAML::BeginSeq;
+	for (std::vector<Project*>::const_iterator i = _projects.begin(); i != _projects.end(); i++)
 	{
 		(*i)->save(out);
 	}
@@ -252,6 +297,7 @@ void Base::setName(const std::wstring &name)
  */
 std::vector<BaseFacility*> *const Base::getFacilities()
 {
+	_totalsDirty = true;
 	return &_facilities;
 }
 
@@ -283,6 +329,16 @@ std::vector<Transfer*> *const Base::getTransfers()
 	return &_transfers;
 }
 
+/**
+ * Returns the list of research and manufacturing
+ * projects going on in the base.
+ * @return Pointer to the project list.
+ */
+std::vector<Project*> *const Base::getProjects()
+{
+	return &_projects;
+}
+
 /**
  * Returns the list of items in the base.
  * @return Pointer to the item list.
@@ -381,7 +437,7 @@ int Base::getAvailableScientists() const
  */
 int Base::getTotalScientists() const
 {
-	int total = _scientists;
+	int total = _scientists + getAssignedStaff(PROJECT_RESEARCH);
 	for (std::vector<Transfer*>::const_iterator i = _transfers.begin(); i != _transfers.end(); i++)
 	{
 		if ((*i)->getType() == TRANSFER_SCIENTIST)
@@ -409,7 +465,7 @@ int Base::getAvailableEngineers() const
  */
 int Base::getTotalEngineers() const
 {
-	int total = _engineers;
+	int total = _engineers + getAssignedStaff(PROJECT_MANUFACTURE);
 	for (std::vector<Transfer*>::const_iterator i = _transfers.begin(); i != _transfers.end(); i++)
 	{
 		if ((*i)->getType() == TRANSFER_ENGINEER)
@@ -437,15 +493,8 @@ int Base::getUsedQuarters() const
  */
 int Base::getAvailableQuarters() const
 {
-	int total = 0;
-	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); i++)
-	{
-		if ((*i)->getBuildTime() == 0)
-		{
-			total += (*i)->getRules()->getPersonnel();
-		}
-	}
-	return total;
+	updateTotals();
+	return _totals.quarters;
 }
 
 /**
@@ -477,15 +526,8 @@ int Base::getUsedStores() const
  */
 int Base::getAvailableStores() const
 {
-	int total = 0;
-	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); i++)
-	{
-		if ((*i)->getBuildTime() == 0)
-		{
-			total += (*i)->getRules()->getStorage();
-		}
-	}
-	return total;
+	updateTotals();
+	return _totals.stores;
 }
 
 /**
@@ -495,7 +537,7 @@ int Base::getAvailableStores() const
  */
 int Base::getUsedLaboratories() const
 {
-	return 0;
+	return getAssignedStaff(PROJECT_RESEARCH);
 }
 
 /**
@@ -505,15 +547,8 @@ int Base::getUsedLaboratories() const
  */
 int Base::getAvailableLaboratories() const
 {
-	int total = 0;
-	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); i++)
-	{
-		if ((*i)->getBuildTime() == 0)
-		{
-			total += (*i)->getRules()->getLaboratories();
-		}
-	}
-	return total;
+	updateTotals();
+	return _totals.laboratories;
 }
 
 /**
@@ -523,7 +558,7 @@ int Base::getAvailableLaboratories() const
  */
 int Base::getUsedWorkshops() const
 {
-	return 0;
+	return getAssignedStaff(PROJECT_MANUFACTURE);
 }
 
 /**
@@ -533,15 +568,8 @@ int Base::getUsedWorkshops() const
  */
 int Base::getAvailableWorkshops() const
 {
-	int total = 0;
-	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); i++)
-	{
-		if ((*i)->getBuildTime() == 0)
-		{
-			total += (*i)->getRules()->getWorkshops();
-		}
-	}
-	return total;
+	updateTotals();
+	return _totals.workshops;
 }
 
 /**
@@ -569,15 +597,8 @@ int Base::getUsedHangars() const
  */
 int Base::getAvailableHangars() const
 {
-	int total = 0;
-	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); i++)
-	{
-		if ((*i)->getBuildTime() == 0)
-		{
-			total += (*i)->getRules()->getCrafts();
-		}
-	}
-	return total;
+	updateTotals();
+	return _totals.hangars;
 }
 
 /**
@@ -587,15 +608,8 @@ int Base::getAvailableHangars() const
  */
 int Base::getDefenceValue() const
 {
-	int total = 0;
-	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); i++)
-	{
-		if ((*i)->getBuildTime() == 0)
-		{
-			total += (*i)->getRules()->getDefenceValue();
-		}
-	}
-	return total;
+	updateTotals();
+	return _totals.defence;
 }
 
 /**
@@ -605,15 +619,8 @@ int Base::getDefenceValue() const
  */
 int Base::getShortRangeDetection() const
 {
-	int total = 0;
-	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); i++)
-	{
-		if ((*i)->getBuildTime() == 0 && (*i)->getRules()->getRadarRange() == 1500)
-		{
-			total++;
-		}
-	}
-	return total;
+	updateTotals();
+	return _totals.shortRange;
 }
 
 /**
@@ -623,15 +630,8 @@ int Base::getShortRangeDetection() const
  */
 int Base::getLongRangeDetection() const
 {
-	int total = 0;
-	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); i++)
-	{
-		if ((*i)->getBuildTime() == 0 && (*i)->getRules()->getRadarRange() > 1500)
-		{
-			total++;
-		}
-	}
-	return total;
+	updateTotals();
+	return _totals.longRange;
 }
 
 /**
@@ -677,8 +677,8 @@ int Base::getPersonnelMaintenance() const
 {
 	int total = 0;
 	total += _soldiers.size() * _rule->getSoldierCost();
-	total += _engineers * _rule->getEngineerCost();
-	total += _scientists * _rule->getScientistCost();
+	total += (_engineers + getAssignedStaff(PROJECT_MANUFACTURE)) * _rule->getEngineerCost();
+	total += (_scientists + getAssignedStaff(PROJECT_RESEARCH)) * _rule->getScientistCost();
 	return total;
 }
 
@@ -689,25 +689,80 @@ int Base::getPersonnelMaintenance() const
  */
 int Base::getFacilityMaintenance() const
 {
-	int total = 0;
+	updateTotals();
+	return _totals.maintenance;
+}
+
+/**
+ * Returns the total amount of all the maintenance
+ * monthly costs in the base.
+ * @return Maintenance costs.
+ */
+int Base::getMonthlyMaintenace() const
+{
+	return getCraftMaintenance() + getPersonnelMaintenance() + getFacilityMaintenance();
+}
+
+/**
+ * Recalculates the totals of all the finished
+ * facilities in the base, if they've changed
+ * since the last time.
+ */
+void Base::updateTotals() const
+{
+	if (!_totalsDirty)
+		return;
+	_totals.quarters = 0;
+	_totals.stores = 0;
+	_totals.laboratories = 0;
+	_totals.workshops = 0;
+	_totals.hangars = 0;
+	_totals.defence = 0;
+	_totals.shortRange = 0;
+	_totals.longRange = 0;
+	_totals.maintenance = 0;
 	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); i++)
 	{
 		if ((*i)->getBuildTime() == 0)
 		{
-			total += (*i)->getRules()->getMonthlyCost();
+			RuleBaseFacility *rule = (*i)->getRules();
+			_totals.quarters += rule->getPersonnel();
+			_totals.stores += rule->getStorage();
+			_totals.laboratories += rule->getLaboratories();
+			_totals.workshops += rule->getWorkshops();
+			_totals.hangars += rule->getCrafts();
+			_totals.defence += rule->getDefenceValue();
+			if (rule->getRadarRange() == 1500)
+			{
+				_totals.shortRange++;
+			}
+			else if (rule->getRadarRange() > 1500)
+			{
+				_totals.longRange++;
+			}
+			_totals.maintenance += rule->getMonthlyCost();
 		}
 	}
-	return total;
+	_totalsDirty = false;
 }
 
 /**
- * Returns the total amount of all the maintenance
- * monthly costs in the base.
- * @return Maintenance costs.
+ * Adds up the scientists or engineers working
+ * on the base's projects of a certain type.
+ * @param type Research or manufacturing.
+ * @return Number of staff.
  */
-int Base::getMonthlyMaintenace() const
+int Base::getAssignedStaff(ProjectType type) const
 {
-	return getCraftMaintenance() + getPersonnelMaintenance() + getFacilityMaintenance();
+	int total = 0;
+	for (std::vector<Project*>::const_iterator i = _projects.begin(); i != _projects.end(); i++)
+	{
+		if ((*i)->getType() == type)
+		{
+			total += (*i)->getStaff();
+		}
+	}
+	return total;
 }
 
 }
@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 #include "yaml.h"
+#include "Project.h"
 
 namespace OpenXcom
 {
@@ -50,15 +51,27 @@ private:
 	std::vector<Soldier*> _soldiers;
 	std::vector<Craft*> _crafts;
 	std::vector<Transfer*> _transfers;
+	std::vector<Project*> _projects;
 	ItemContainer *_items;
 	int _scientists, _engineers;
+	/// Totals of the finished facilities in the base.
+	struct FacilityTotals
+	{
+		int quarters, stores, laboratories, workshops, hangars, defence, shortRange, longRange, maintenance;
+	};
+	mutable FacilityTotals _totals;
+	mutable bool _totalsDirty;
+	void updateTotals() const;
+	int getAssignedStaff(ProjectType type) const;
 public:
 	/// Creates a new base.
 	Base(Ruleset *rule);
 	/// Cleans up the base.
 	~Base();
 	/// Loads the base from YAML.
-	void load(const YAML::Node& node, SavedGame *save);
+	void load(const YAML::Node& node);
+	/// Loads the destinations of the base's crafts from YAML.
+	void loadCraftDestinations(const YAML::Node& node, SavedGame *save);
 	/// Saves the base to YAML.
 	void save(YAML::Emitter& out) const;
 	/// Saves the base's ID to YAML.
@@ -75,6 +88,8 @@ public:
 	std::vector<Craft*> *const getCrafts();
 	/// Gets the base's transfers.
 	std::vector<Transfer*> *const getTransfers();
+	/// Gets the base's research and manufacturing projects.
+	std::vector<Project*> *const getProjects();
 	/// Gets the base's items.
 	ItemContainer *const getItems();
 	/// Gets the base's scientists.
@@ -27,7 +27,7 @@ namespace OpenXcom
  * Initializes a item of the specified type.
  * @param rules Pointer to ruleset.
  */
-BattleItem::BattleItem(RuleItem *rules) : _rules(rules), _owner(0), _ammoItem(0)
+BattleItem::BattleItem(RuleItem *rules) : _rules(rules), _owner(0), _inventorySlot(RIGHT_HAND), _ammoItem(0)
 {
 	_itemProperty[0] = 0;
 	_itemProperty[1] = 0;
@@ -108,10 +108,18 @@ BattleUnit *BattleItem::getOwner() const
 	return _owner;
 }
 
-/// Sets the item's owner.
+/// Sets the item's owner, moving it out of the old owner's inventory slot and into the new one's.
 void BattleItem::setOwner(BattleUnit *owner)
 {
+	if (_owner && _owner->getItem(_inventorySlot) == this)
+	{
+		_owner->setItem(_inventorySlot, 0);
+	}
 	_owner = owner;
+	if (_owner)
+	{
+		_owner->setItem(_inventorySlot, this);
+	}
 }
 
 /// Gets the item's inventory slot.
@@ -120,10 +128,18 @@ InventorySlot BattleItem::getSlot() const
 	return _inventorySlot;
 }
 
-/// Sets the item's inventory slot.
+/// Sets the item's inventory slot, moving it to that slot of its owner's inventory.
 void BattleItem::setSlot(InventorySlot slot)
 {
+	if (_owner && _owner->getItem(_inventorySlot) == this)
+	{
+		_owner->setItem(_inventorySlot, 0);
+	}
 	_inventorySlot = slot;
+	if (_owner)
+	{
+		_owner->setItem(_inventorySlot, this);
+	}
 }
 
 /// Gets the item's ammo item.
@@ -34,7 +34,7 @@ namespace OpenXcom
  * @param rules Pointer to RuleUnit object.
  * @param faction Which faction the units belongs to.
  */
-BattleUnit::BattleUnit(Unit *unit, UnitFaction faction) : _unit(unit), _faction(faction), _id(0), _pos(Position()), _lastPos(Position()), _direction(0), _status(STATUS_STANDING), _walkPhase(0), _fallPhase(0), _cached(false), _kneeled(false)
+BattleUnit::BattleUnit(Unit *unit, UnitFaction faction) : _unit(unit), _faction(faction), _id(0), _pos(Position()), _lastPos(Position()), _direction(0), _verticalDirection(0), _status(STATUS_STANDING), _walkPhase(0), _fallPhase(0), _fovPos(Position()), _fovDirection(-1), _fovCached(false), _cached(false), _kneeled(false), _rightHandItem(0), _leftHandItem(0)
 {
 	_tu = unit->getTimeUnits();
 	_energy = unit->getStamina();
@@ -199,12 +199,20 @@ UnitStatus BattleUnit::getStatus()
 
 /**
  * startWalking
- * @param direction
+ * @param direction 8 and 9 are flying up and down, the unit keeps facing the same way.
  * @param destination
  */
 void BattleUnit::startWalking(int direction, const Position &destination)
 {
-	_direction = direction;
+	if (direction < 8)
+	{
+		_direction = direction;
+		_verticalDirection = 0;
+	}
+	else
+	{
+		_verticalDirection = direction;
+	}
 	_status = STATUS_WALKING;
 	_walkPhase = 0;
 	_destination = destination;
@@ -217,8 +225,8 @@ void BattleUnit::keepWalking()
 {
 	int middle, end;
 	// diagonal walking takes double the steps
-	middle = 4 + 4 * (_direction % 2);
-	end = 8 + 8 * (_direction % 2);
+	middle = 4 + 4 * (_direction % 2 && !_verticalDirection);
+	end = 8 + 8 * (_direction % 2 && !_verticalDirection);
 
 	_walkPhase++;
 
@@ -257,6 +265,15 @@ int BattleUnit::getDiagonalWalkingPhase() const
 	return (_walkPhase / 8) * 8;
 }
 
+/*
+ * Gets whether the unit is flying straight up or down.
+ * return direction 8 for up, 9 for down, 0 when walking or standing
+ */
+int BattleUnit::getVerticalDirection() const
+{
+	return _status == STATUS_WALKING ? _verticalDirection : 0;
+}
+
 /**
  * Look at a point.
  * @param point.
@@ -351,6 +368,34 @@ bool BattleUnit::isCached() const
 	return _cached;
 }
 
+/**
+ * Gets the item the unit holds in an inventory slot.
+ * Kept up to date by the items themselves when their owner or slot changes.
+ * @param slot Inventory slot.
+ * @return Pointer to the item, or 0 if the slot is empty.
+ */
+BattleItem *BattleUnit::getItem(InventorySlot slot) const
+{
+	return slot == LEFT_HAND ? _leftHandItem : _rightHandItem;
+}
+
+/**
+ * Changes the item the unit holds in an inventory slot.
+ * @param slot Inventory slot.
+ * @param item Pointer to the item, or 0 to empty the slot.
+ */
+void BattleUnit::setItem(InventorySlot slot, BattleItem *item)
+{
+	if (slot == LEFT_HAND)
+	{
+		_leftHandItem = item;
+	}
+	else
+	{
+		_rightHandItem = item;
+	}
+}
+
 /**
  * Kneel down and spend TUs.
  * @param to kneel or to stand up
@@ -518,18 +563,27 @@ void BattleUnit::setTimeUnits(int tu)
 
 /**
  * Add this unit to the list of visible units. Returns true if this is a new one.
+ * Units are flagged by ID, so duplicates are found without a search,
+ * and units that weren't seen the last time are noted as spotted.
  * @param unit
  */
 bool BattleUnit::addToVisibleUnits(BattleUnit *unit)
 {
-	for (std::vector<BattleUnit*>::iterator i = _visibleUnits.begin(); i != _visibleUnits.end(); i++)
+	size_t id = unit->getId();
+	if (id >= _seenUnits.size())
 	{
-		if ((BattleUnit*)(*i) == unit)
-		{
-			return false;
-		}
+		_seenUnits.resize(id + 1, false);
 	}
+	if (_seenUnits[id])
+	{
+		return false;
+	}
+	_seenUnits[id] = true;
 	_visibleUnits.push_back(unit);
+	if (id >= _lastSeenUnits.size() || !_lastSeenUnits[id])
+	{
+		_spottedUnits.push_back(unit);
+	}
 	return true;
 }
 
@@ -539,11 +593,129 @@ std::vector<BattleUnit*> *BattleUnit::getVisibleUnits()
 }
 
 /**
- * Clear visible units.
+ * Clear visible units, keeping the ones seen so far
+ * to tell which units get spotted and lost next.
  */
 void BattleUnit::clearVisibleUnits()
 {
+	_lastVisibleUnits.swap(_visibleUnits);
+	_lastSeenUnits.swap(_seenUnits);
 	_visibleUnits.clear();
+	_seenUnits.assign(_lastSeenUnits.size(), false);
+	_spottedUnits.clear();
+	_lostUnits.clear();
+}
+
+/**
+ * Once all visible units are added again, notes the units
+ * that were visible before but aren't anymore.
+ */
+void BattleUnit::finishVisibleUnits()
+{
+	for (std::vector<BattleUnit*>::iterator i = _lastVisibleUnits.begin(); i != _lastVisibleUnits.end(); i++)
+	{
+		if (!_seenUnits[(*i)->getId()])
+		{
+			_lostUnits.push_back(*i);
+		}
+	}
+}
+
+/**
+ * Gets the units that came into sight with the last field of view
+ * calculation, which weren't visible the time before.
+ * @return pointer to the list of units
+ */
+std::vector<BattleUnit*> *BattleUnit::getSpottedUnits()
+{
+	return &_spottedUnits;
+}
+
+/**
+ * Gets the units that went out of sight with the last field of view
+ * calculation, which were visible the time before.
+ * @return pointer to the list of units
+ */
+std::vector<BattleUnit*> *BattleUnit::getLostUnits()
+{
+	return &_lostUnits;
+}
+
+/**
+ * Add a tile to the list of tiles this unit's field of view covers.
+ * @param tile
+ * @param rays the rays of the field of view that saw the tile, one bit each.
+ */
+void BattleUnit::addToVisibleTiles(Tile *tile, unsigned int rays)
+{
+	_visibleTiles.push_back(tile);
+	_visibleRays.push_back(rays);
+}
+
+/**
+ * Get the list of tiles from the last full field of view calculation.
+ * @return pointer to the list of visible tiles
+ */
+std::vector<Tile*> *BattleUnit::getVisibleTiles()
+{
+	return &_visibleTiles;
+}
+
+/**
+ * Get the rays of the field of view that saw each of the visible tiles,
+ * so the tiles that stay in view when the unit turns can be told apart.
+ * @return pointer to the list of rays, in the same order as the visible tiles.
+ */
+std::vector<unsigned int> *BattleUnit::getVisibleRays()
+{
+	return &_visibleRays;
+}
+
+/**
+ * Clear visible tiles.
+ */
+void BattleUnit::clearVisibleTiles()
+{
+	_visibleTiles.clear();
+	_visibleRays.clear();
+	_fovCached = false;
+}
+
+/**
+ * Sets the field of view cache flag. When set, the visible tiles are bound to the current
+ * position and direction of the unit.
+ * @param cached
+ */
+void BattleUnit::setFOVCached(bool cached)
+{
+	_fovCached = cached;
+	_fovPos = _pos;
+	_fovDirection = _direction;
+}
+
+/**
+ * Check if the visible tiles can be reused. This is no longer the case when the unit moved or turned,
+ * or when the terrain or lighting around the unit changed.
+ * @return bool
+ */
+bool BattleUnit::isFOVCached() const
+{
+	return _fovCached && _fovPos == _pos && _fovDirection == _direction;
+}
+
+/**
+ * Check if the unit only turned one step since the visible tiles were cached,
+ * so half of them can be kept.
+ * @return 1 if it turned clockwise, -1 if it turned counter-clockwise, 0 otherwise.
+ */
+int BattleUnit::getFOVTurn() const
+{
+	if (!_fovCached || _fovPos != _pos)
+	{
+		return 0;
+	}
+	int turn = (_direction - _fovDirection + 8) % 8;
+	return turn == 1 ? 1 : turn == 7 ? -1 : 0;
 }
 
 /**
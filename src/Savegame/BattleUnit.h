@@ -23,6 +23,7 @@
 #include <string>
 #include "../Battlescape/Position.h"
 #include "Soldier.h"
+#include "BattleItem.h"
 
 namespace OpenXcom
 {
@@ -47,12 +48,17 @@ private:
 	int _id;
 	Position _pos;
 	Position _lastPos;
-	int _direction, _toDirection;
+	int _direction, _toDirection, _verticalDirection;
 	Position _destination;
 	UnitStatus _status;
 	int _walkPhase, _fallPhase;
-	std::vector<BattleUnit *> _visibleUnits;
+	std::vector<BattleUnit *> _visibleUnits, _lastVisibleUnits, _spottedUnits, _lostUnits;
+	std::vector<bool> _seenUnits, _lastSeenUnits;
 	std::vector<Tile *> _visibleTiles;
+	std::vector<unsigned int> _visibleRays;
+	Position _fovPos;
+	int _fovDirection;
+	bool _fovCached;
 	int _tu, _energy, _health, _morale;
 	bool _cached, _kneeled;
 	BattleItem *_rightHandItem, *_leftHandItem;
@@ -91,6 +97,8 @@ public:
 	int getWalkingPhase() const;
 	/// Gets the walking phase for diagonal walking
 	int getDiagonalWalkingPhase() const;
+	/// Gets whether the unit is flying up or down
+	int getVerticalDirection() const;
 	/// Gets the unit's destination when walking
 	const Position &getDestination() const;
 	/// Look at a certain point.
@@ -109,6 +117,10 @@ public:
 	void setCached(bool cached);
 	/// If this unit is cached on the battlescape.
 	bool isCached() const;
+	/// Gets the item in one of the unit's inventory slots.
+	BattleItem *getItem(InventorySlot slot) const;
+	/// Sets the item in one of the unit's inventory slots.
+	void setItem(InventorySlot slot, BattleItem *item);
 	/// Kneel down.
 	void kneel(bool kneeled);
 	/// Is kneeled?
@@ -143,6 +155,26 @@ public:
 	std::vector<BattleUnit*> *getVisibleUnits();
 	/// Clear visible units.
 	void clearVisibleUnits();
+	/// Work out which units went out of sight.
+	void finishVisibleUnits();
+	/// Get the units that came into sight since the last field of view.
+	std::vector<BattleUnit*> *getSpottedUnits();
+	/// Get the units that went out of sight since the last field of view.
+	std::vector<BattleUnit*> *getLostUnits();
+	/// Add tile to visible tiles.
+	void addToVisibleTiles(Tile *tile, unsigned int rays = 0);
+	/// Get the list of visible tiles.
+	std::vector<Tile*> *getVisibleTiles();
+	/// Get the rays that saw each of the visible tiles.
+	std::vector<unsigned int> *getVisibleRays();
+	/// Clear visible tiles.
+	void clearVisibleTiles();
+	/// Mark the visible tiles as up to date for the current position and direction.
+	void setFOVCached(bool cached);
+	/// Are the visible tiles still valid?
+	bool isFOVCached() const;
+	/// Which way the unit turned a step since the visible tiles were cached.
+	int getFOVTurn() const;
 	/// Calculate firing accuracy.
 	double getFiringAccuracy(int baseAccuracy);
 	/// Calculate throwing accuracy.
@@ -28,7 +28,7 @@ namespace OpenXcom
  * @param rules Pointer to ruleset.
  * @param gen Generate new funding.
  */
-Country::Country(RuleCountry *rules, bool gen) : _rules(rules), _funding(0), _change(0), _activityXcom(0), _activityAlien(0)
+Country::Country(RuleCountry *rules, bool gen) : _rules(rules), _funding(0), _change(0), _activityXcom(0), _activityAlien(0), _fundingHistory(), _xcomHistory(), _alienHistory()
 {
 	if (gen)
 	{
@@ -53,6 +53,12 @@ void Country::load(const YAML::Node &node)
 	node["change"] >> _change;
 	node["activityXcom"] >> _activityXcom;
 	node["activityAlien"] >> _activityAlien;
+	if (const YAML::Node *pName = node.FindValue("history"))
+	{
+		_fundingHistory.load((*pName)["funding"]);
+		_xcomHistory.load((*pName)["activityXcom"]);
+		_alienHistory.load((*pName)["activityAlien"]);
+	}
 }
 
 /**
@@ -67,6 +73,15 @@ void Country::save(YAML::Emitter &out) const
 	out << YAML::Key << "change" << YAML::Value << _change;
 	out << YAML::Key << "activityXcom" << YAML::Value << _activityXcom;
 	out << YAML::Key << "activityAlien" << YAML::Value << _activityAlien;
+	out << YAML::Key << "history" << YAML::Value;
+	out << YAML::BeginMap;
+	out << YAML::Key << "funding" << YAML::Value;
+	_fundingHistory.save(out);
+	out << YAML::Key << "activityXcom" << YAML::Value;
+	_xcomHistory.save(out);
+	out << YAML::Key << "activityAlien" << YAML::Value;
+	_alienHistory.save(out);
+	out << YAML::EndMap;
 	out << YAML::EndMap;
 }
 
@@ -106,4 +121,45 @@ int Country::getChange() const
 	return _change;
 }
 
+/**
+ * Adds the country's funding and activity of the month
+ * that just ended to its history, and starts counting
+ * the activity of the new month from scratch.
+ */
+void Country::endMonth()
+{
+	_fundingHistory.add(_funding);
+	_xcomHistory.add(_activityXcom);
+	_alienHistory.add(_activityAlien);
+	_activityXcom = 0;
+	_activityAlien = 0;
+}
+
+/**
+ * Returns the country's monthly funding over the last months.
+ * @return Funding history.
+ */
+const MonthlyHistory &Country::getFundingHistory() const
+{
+	return _fundingHistory;
+}
+
+/**
+ * Returns the X-Com activity in the country over the last months.
+ * @return Activity history.
+ */
+const MonthlyHistory &Country::getXcomHistory() const
+{
+	return _xcomHistory;
+}
+
+/**
+ * Returns the alien activity in the country over the last months.
+ * @return Activity history.
+ */
+const MonthlyHistory &Country::getAlienHistory() const
+{
+	return _alienHistory;
+}
+
 }
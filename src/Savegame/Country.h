@@ -20,6 +20,7 @@
 #define OPENXCOM_COUNTRY_H
 
 #include "yaml.h"
+#include "MonthlyHistory.h"
 
 namespace OpenXcom
 {
@@ -37,6 +38,7 @@ private:
 	RuleCountry *_rules;
 	int _funding, _change;
 	int _activityXcom, _activityAlien;
+	MonthlyHistory _fundingHistory, _xcomHistory, _alienHistory;
 public:
 	/// Creates a new country of the specified type.
 	Country(RuleCountry *rules, bool gen = true);
@@ -54,6 +56,14 @@ public:
 	void setFunding(int funding);
 	/// Gets the country's funding change.
 	int getChange() const;
+	/// Records the month's funding and activity in the history.
+	void endMonth();
+	/// Gets the country's funding over the last months.
+	const MonthlyHistory &getFundingHistory() const;
+	/// Gets the country's X-Com activity over the last months.
+	const MonthlyHistory &getXcomHistory() const;
+	/// Gets the country's alien activity over the last months.
+	const MonthlyHistory &getAlienHistory() const;
 };
 
 }
@@ -39,7 +39,7 @@ namespace OpenXcom
  * @param base Pointer to base of origin.
  * @param ids List of craft IDs (Leave NULL for no ID).
  */
-Craft::Craft(RuleCraft *rules, Base *base, std::map<std::string, int> *ids) : MovingTarget(), _rules(rules), _base(base), _id(0), _fuel(0), _damage(0), _weapons(), _status("STR_READY"), _lowFuel(false), _inBattlescape(false)
+Craft::Craft(RuleCraft *rules, Base *base, std::map<std::string, int> *ids) : MovingTarget(), _rules(rules), _base(base), _id(0), _fuel(0), _damage(0), _weapons(), _status(CRAFT_READY), _lowFuel(false), _inBattlescape(false)
 {
 	_items = new ItemContainer();
 	if (ids != 0)
@@ -79,21 +79,29 @@ void Craft::load(const YAML::Node &node, Ruleset *rule)
 	node["fuel"] >> _fuel;
 	node["damage"] >> _damage;
 
-	size = node["weapons"].size();
+	const YAML::Node &weapons = node["weapons"];
+	size = weapons.size();
 	for (unsigned int i = 0; i < size; i++)
 	{
 		std::string type;
-		node["weapons"][i]["type"] >> type;
+		weapons[i]["type"] >> type;
 		if (type != "0")
 		{
 			CraftWeapon *w = new CraftWeapon(rule->getCraftWeapon(type), 0);
-			w->load(node["weapons"][i]);
+			w->load(weapons[i]);
 			_weapons[i] = w;
 		}
 	}
 
 	_items->load(node["items"]);
-	node["status"] >> _status;
+	std::string status;
+	node["status"] >> status;
+	for (int i = CRAFT_REPAIRS; i >= CRAFT_READY; i--)
+	{
+		_status = (CraftStatus)i;
+		if (getStatusString() == status)
+			break;
+	}
 	node["lowFuel"] >> _lowFuel;
 	node["inBattlescape"] >> _inBattlescape;
 }
@@ -127,7 +135,7 @@ void Craft::save(YAML::Emitter &out) const
 	out << YAML::EndSeq;
 	out << YAML::Key << "items" << YAML::Value;
 	_items->save(out);
-	out << YAML::Key << "status" << YAML::Value << _status;
+	out << YAML::Key << "status" << YAML::Value << getStatusString();
 	out << YAML::Key << "lowFuel" << YAML::Value << _lowFuel;
 	out << YAML::Key << "inBattlescape" << YAML::Value << _inBattlescape;
 	out << YAML::EndMap;
@@ -196,18 +204,40 @@ void Craft::setBase(Base *base)
 
 /**
  * Returns the current status of the craft.
- * @return Status string.
+ * @return Status.
  */
-std::string Craft::getStatus() const
+CraftStatus Craft::getStatus() const
 {
 	return _status;
 }
 
+/**
+ * Returns the string ID of the current status of the craft,
+ * for showing it to the player and storing it in saves.
+ * @return Status string.
+ */
+std::string Craft::getStatusString() const
+{
+	switch (_status)
+	{
+	case CRAFT_OUT:
+		return "STR_OUT";
+	case CRAFT_REFUELLING:
+		return "STR_REFUELLING";
+	case CRAFT_REARMING:
+		return "STR_REARMING";
+	case CRAFT_REPAIRS:
+		return "STR_REPAIRS";
+	default:
+		return "STR_READY";
+	}
+}
+
 /**
  * Changes the current status of the craft.
- * @param status Status string.
+ * @param status Status.
  */
-void Craft::setStatus(std::string status)
+void Craft::setStatus(CraftStatus status)
 {
 	_status = status;
 }
@@ -405,8 +435,7 @@ void Craft::setLowFuel(bool low)
  */
 double Craft::getDistanceFromBase() const
 {
-	double dLon, dLat;
-	return getDistance(_base, &dLon, &dLat);
+	return getDistance(_base);
 }
 
 /**
@@ -429,6 +458,55 @@ int Craft::getFuelLimit() const
 	return (int)floor(getFuelConsumption() * getDistanceFromBase() / (getRadianSpeed() * 120));
 }
 
+/**
+ * Predicts how long the craft will take to reach its
+ * destination at its current speed, assuming the
+ * destination stays where it is.
+ * @return Time in minutes, or -1 if it's not going anywhere.
+ */
+int Craft::getTimeToArrival() const
+{
+	if (_dest == 0 || _speed == 0)
+	{
+		return -1;
+	}
+	double steps = getRouteLeft() / getRadianSpeed();
+	// Each step is 5 seconds.
+	return (int)ceil(steps * 5 / 60);
+}
+
+/**
+ * Predicts how long the craft can keep flying on its
+ * current route before its fuel drops to the amount
+ * needed to make it back to base, following the fuel
+ * consumption that happens every 10 minutes.
+ * @return Time in minutes, or -1 if the craft isn't using fuel.
+ */
+int Craft::getTimeToFuelLimit() const
+{
+	int consumption = getFuelConsumption();
+	if (consumption == 0)
+	{
+		return -1;
+	}
+	for (int time = 0; ; time += 10)
+	{
+		int fuel = _fuel - consumption * time / 10;
+		// The craft stops moving once it arrives
+		double lon = _lon, lat = _lat;
+		if (_dest != 0)
+		{
+			getRoutePosition(_legDone + time * 12.0 * getRadianSpeed(), &lon, &lat);
+		}
+		double distance = getDistance(lon, lat, _base->getLongitude(), _base->getLatitude());
+		int limit = (int)floor(consumption * distance / (getRadianSpeed() * 120));
+		if (fuel <= limit)
+		{
+			return time;
+		}
+	}
+}
+
 /**
  * Sends the craft back to its origin base.
  */
@@ -442,12 +520,11 @@ void Craft::returnToBase()
  */
 void Craft::think()
 {
-	if (_dest != 0)
+	if (destinationMoved())
 	{
 		calculateSpeed();
 	}
-	setLongitude(_lon + _speedLon);
-	setLatitude(_lat + _speedLat);
+	moveAlongRoute();
 	if (_dest != 0 && finishedRoute())
 	{
 		_lon = _dest->getLongitude();
@@ -469,15 +546,15 @@ void Craft::think()
 
 			if (_damage > 0)
 			{
-				_status = "STR_REPAIRS";
+				_status = CRAFT_REPAIRS;
 			}
 			else if (available != full)
 			{
-				_status = "STR_REARMING";
+				_status = CRAFT_REARMING;
 			}
 			else
 			{
-				_status = "STR_REFUELLING";
+				_status = CRAFT_REFUELLING;
 			}
 			setSpeed(0);
 			setDestination(0);
@@ -523,7 +600,7 @@ void Craft::repair()
 	setDamage(_damage - _rules->getRepairRate());
 	if (_damage <= 0)
 	{
-		_status = "STR_REARMING";
+		_status = CRAFT_REARMING;
 	}
 }
 
@@ -536,7 +613,7 @@ void Craft::refuel()
 	setFuel(_fuel + _rules->getRefuelRate());
 	if (_fuel >= _rules->getMaxFuel())
 	{
-		_status = "STR_READY";
+		_status = CRAFT_READY;
 	}
 }
 
@@ -551,7 +628,7 @@ std::string Craft::rearm()
 	{
 		if (i == _weapons.end())
 		{
-			_status = "STR_REFUELLING";
+			_status = CRAFT_REFUELLING;
 			break;
 		}
 		if (*i != 0 && (*i)->isRearming())
@@ -26,6 +26,8 @@
 namespace OpenXcom
 {
 
+enum CraftStatus { CRAFT_READY, CRAFT_OUT, CRAFT_REFUELLING, CRAFT_REARMING, CRAFT_REPAIRS };
+
 class RuleCraft;
 class Base;
 class Soldier;
@@ -47,7 +49,7 @@ private:
 	int _id, _fuel, _damage;
 	std::vector<CraftWeapon*> _weapons;
 	ItemContainer *_items;
-	std::string _status;
+	CraftStatus _status;
 	bool _lowFuel;
 	bool _inBattlescape;
 public:
@@ -72,9 +74,11 @@ public:
 	/// Sets the craft's base.
 	void setBase(Base *base);
 	/// Gets the craft's status.
-	std::string getStatus() const;
+	CraftStatus getStatus() const;
+	/// Gets the craft's status string.
+	std::string getStatusString() const;
 	/// Sets the craft's status.
-	void setStatus(std::string status);
+	void setStatus(CraftStatus status);
 	/// Sets the craft's destination.
 	void setDestination(Target *dest);
 	/// Gets the craft's amount of weapons.
@@ -111,6 +115,10 @@ public:
 	int getFuelConsumption() const;
 	/// Gets the craft's minimum fuel limit.
 	int getFuelLimit() const;
+	/// Gets the craft's time left until it reaches its destination.
+	int getTimeToArrival() const;
+	/// Gets the craft's time left until it hits its minimum fuel limit.
+	int getTimeToFuelLimit() const;
 	/// Returns the craft to its base.
 	void returnToBase();
 	/// Checks if a target is inside the craft's radar.
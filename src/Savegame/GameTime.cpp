@@ -84,10 +84,6 @@ void GameTime::save(YAML::Emitter &out) const
 TimeTrigger GameTime::advance()
 {
 	TimeTrigger trigger = TIME_5SEC;
-	int monthDays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-	// Leap year
-	if ((_year % 4 == 0) && !(_year % 100 == 0 && _year % 400 != 0))
-		monthDays[1]++;
 
 	_second += 5;
 
@@ -121,7 +117,7 @@ TimeTrigger GameTime::advance()
 	{
 		_weekday = 1;
 	}
-	if (_day > monthDays[_month - 1])
+	if (_day > getMonthDays())
 	{
 		_day = 1;
 		_month++;
@@ -136,6 +132,41 @@ TimeTrigger GameTime::advance()
 	return trigger;
 }
 
+/**
+ * Returns how many times the time has to advance before it
+ * sends out anything longer than the 5 second trigger.
+ * @return Number of 5 second steps, the last one being the 10 minute trigger.
+ */
+int GameTime::getStepsToTrigger() const
+{
+	return (60 - _second) / 5 + (9 - _minute % 10) * 12;
+}
+
+/**
+ * Advances the ingame time by several 5 second steps at once,
+ * for when nothing happens in between them.
+ * @param steps Number of steps, has to be less than getStepsToTrigger().
+ */
+void GameTime::skip(int steps)
+{
+	int seconds = _minute * 60 + _second + steps * 5;
+	_minute = seconds / 60;
+	_second = seconds % 60;
+}
+
+/**
+ * Returns how many days there are in the current ingame month.
+ * @return Days (28-31).
+ */
+int GameTime::getMonthDays() const
+{
+	int monthDays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	// Leap year
+	if ((_year % 4 == 0) && !(_year % 100 == 0 && _year % 400 != 0))
+		monthDays[1]++;
+	return monthDays[_month - 1];
+}
+
 /**
  * Returns the current ingame second.
  * @return Second (0-59).
@@ -50,6 +50,12 @@ public:
 	void save(YAML::Emitter& out) const;
 	/// Advances the time by 5 seconds.
 	TimeTrigger advance();
+	/// Gets the number of 5 second steps until the next 10 minute trigger.
+	int getStepsToTrigger() const;
+	/// Advances the time by several 5 second steps without triggers.
+	void skip(int steps);
+	/// Gets the number of days in the ingame month.
+	int getMonthDays() const;
 	/// Gets the ingame second.
 	int getSecond() const;
 	/// Gets the ingame minute.
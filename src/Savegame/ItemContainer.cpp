@@ -26,7 +26,7 @@ namespace OpenXcom
 /**
  * Initializes an item container with no contents.
  */
-ItemContainer::ItemContainer() : _qty()
+ItemContainer::ItemContainer() : _qty(), _sizeRule(0), _totalSize(0.0)
 {
 }
 
@@ -44,6 +44,7 @@ ItemContainer::~ItemContainer()
 void ItemContainer::load(const YAML::Node &node)
 {
 	node >> _qty;
+	_sizeRule = 0;
 }
 
 /**
@@ -67,6 +68,7 @@ void ItemContainer::addItem(const std::string &id, int qty)
 		_qty[id] = 0;
 	}
 	_qty[id] += qty;
+	_sizeRule = 0;
 }
 
 /**
@@ -88,6 +90,7 @@ void ItemContainer::removeItem(const std::string &id, int qty)
 	{
 		_qty.erase(id);
 	}
+	_sizeRule = 0;
 }
 
 /**
@@ -125,26 +128,34 @@ int ItemContainer::getTotalQuantity() const
 
 /**
  * Returns the total size of the items in the container.
+ * The total is kept until the contents change, so store
+ * space checks don't look up every item's rules again.
  * @param rule Pointer to ruleset.
  * @return Total item size.
  */
-double ItemContainer::getTotalSize(Ruleset *rule) const
+double ItemContainer::getTotalSize(Ruleset *rule)
 {
-	double total = 0;
-	for (std::map<std::string, int>::const_iterator i = _qty.begin(); i != _qty.end(); i++)
+	if (_sizeRule != rule)
 	{
-		total += rule->getItem(i->first)->getSize() * i->second;
+		_totalSize = 0;
+		for (std::map<std::string, int>::const_iterator i = _qty.begin(); i != _qty.end(); i++)
+		{
+			_totalSize += rule->getItem(i->first)->getSize() * i->second;
+		}
+		_sizeRule = rule;
 	}
-	return total;
+	return _totalSize;
 }
 
 /**
  * Returns all the items currently contained within.
+ * The contents can only be changed through addItem()
+ * and removeItem(), so the stored total size stays right.
  * @return List of contents.
  */
-std::map<std::string, int> *const ItemContainer::getContents()
+const std::map<std::string, int> &ItemContainer::getContents() const
 {
-	return &_qty;
+	return _qty;
 }
 
 }
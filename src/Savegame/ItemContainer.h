@@ -37,6 +37,8 @@ class ItemContainer
 {
 private:
 	std::map<std::string, int> _qty;
+	Ruleset *_sizeRule;
+	double _totalSize;
 public:
 	/// Creates an empty item container.
 	ItemContainer();
@@ -55,9 +57,9 @@ public:
 	/// Gets the total quantity of items in the container.
 	int getTotalQuantity() const;
 	/// Gets the total size of items in the container.
-	double getTotalSize(Ruleset *rule) const;
+	double getTotalSize(Ruleset *rule);
 	/// Gets all the items in the container.
-	std::map<std::string, int> *const getContents();
+	const std::map<std::string, int> &getContents() const;
 };
 
 }
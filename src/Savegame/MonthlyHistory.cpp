@@ -0,0 +1,111 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MonthlyHistory.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Initializes a history with no months in it.
+ */
+MonthlyHistory::MonthlyHistory() : _first(0), _size(0)
+{
+	for (int i = 0; i < MONTHS; i++)
+	{
+		_values[i] = 0;
+	}
+}
+
+/**
+ *
+ */
+MonthlyHistory::~MonthlyHistory()
+{
+}
+
+/**
+ * Loads the history from a YAML file, oldest month first.
+ * Only the latest months fitting in the history are kept.
+ * @param node YAML node.
+ */
+void MonthlyHistory::load(const YAML::Node &node)
+{
+	_first = 0;
+	_size = 0;
+	for (unsigned int i = 0; i < node.size(); i++)
+	{
+		int value;
+		node[i] >> value;
+		add(value);
+	}
+}
+
+/**
+ * Saves the history to a YAML file, oldest month first.
+ * @param out YAML emitter.
+ */
+void MonthlyHistory::save(YAML::Emitter &out) const
+{
+	out << YAML::Flow << YAML::BeginSeq;
+	for (int i = 0; i < _size; i++)
+	{
+		out << get(i);
+	}
+	out << YAML::EndSeq;
+}
+
+/**
+ * Adds the value of the month that just ended to the
+ * history, taking the place of the oldest one when full.
+ * @param value Value of the month.
+ */
+void MonthlyHistory::add(int value)
+{
+	if (_size < MONTHS)
+	{
+		_values[(_first + _size) % MONTHS] = value;
+		_size++;
+	}
+	else
+	{
+		_values[_first] = value;
+		_first = (_first + 1) % MONTHS;
+	}
+}
+
+/**
+ * Returns how many months are in the history so far.
+ * @return Number of months.
+ */
+int MonthlyHistory::size() const
+{
+	return _size;
+}
+
+/**
+ * Returns the value of a month in the history.
+ * @param month Month, 0 being the oldest one kept.
+ * @return Value of the month.
+ */
+int MonthlyHistory::get(int month) const
+{
+	return _values[(_first + month) % MONTHS];
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_MONTHLYHISTORY_H
+#define OPENXCOM_MONTHLYHISTORY_H
+
+#include "yaml.h"
+
+namespace OpenXcom
+{
+
+/**
+ * The values of some statistic over the last months,
+ * like a country's funding or the alien activity in a region.
+ * Only the most recent months are kept, in a fixed ring,
+ * so a long campaign doesn't make the history any bigger.
+ */
+class MonthlyHistory
+{
+public:
+	static const int MONTHS = 12;
+private:
+	int _values[MONTHS];
+	int _first, _size;
+public:
+	/// Creates an empty history.
+	MonthlyHistory();
+	/// Cleans up the history.
+	~MonthlyHistory();
+	/// Loads the history from YAML.
+	void load(const YAML::Node& node);
+	/// Saves the history to YAML.
+	void save(YAML::Emitter& out) const;
+	/// Adds the value of a month that just ended.
+	void add(int value);
+	/// Gets the number of months in the history.
+	int size() const;
+	/// Gets the value of a month in the history.
+	int get(int month) const;
+};
+
+}
+
+#endif
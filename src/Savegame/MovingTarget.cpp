@@ -23,11 +23,30 @@
 namespace OpenXcom
 {
 
+/**
+ * Converts globe coordinates into a unit vector
+ * from the center of the globe.
+ * @param lon Longitude in radian.
+ * @param lat Latitude in radian.
+ * @param v Returned vector.
+ */
+static void toVector(double lon, double lat, double *v)
+{
+	v[0] = cos(lat) * cos(lon);
+	v[1] = cos(lat) * sin(lon);
+	v[2] = sin(lat);
+}
+
 /**
  * Initializes a moving target with blank coordinates.
  */
-MovingTarget::MovingTarget() : Target(), _dest(0), _speedLon(0.0), _speedLat(0.0), _speed(0)
+MovingTarget::MovingTarget() : Target(), _dest(0), _speedLon(0.0), _speedLat(0.0), _speed(0), _destLon(0.0), _destLat(0.0), _legLength(0.0), _legDone(0.0), _routeId(0), _destRouteId(0)
 {
+	for (int i = 0; i < 3; i++)
+	{
+		_legStart[i] = 0.0;
+		_legTangent[i] = 0.0;
+	}
 }
 
 MovingTarget::~MovingTarget()
@@ -41,8 +60,6 @@ MovingTarget::~MovingTarget()
 void MovingTarget::load(const YAML::Node &node)
 {
 	Target::load(node);
-	node["speedLon"] >> _speedLon;
-	node["speedLat"] >> _speedLat;
 	node["speed"] >> _speed;
 }
 
@@ -58,8 +75,6 @@ void MovingTarget::save(YAML::Emitter &out) const
 		out << YAML::Key << "dest" << YAML::Value;
 		_dest->saveId(out);
 	}
-	out << YAML::Key << "speedLon" << YAML::Value << _speedLon;
-	out << YAML::Key << "speedLat" << YAML::Value << _speedLat;
 	out << YAML::Key << "speed" << YAML::Value << _speed;
 }
 
@@ -131,60 +146,220 @@ double MovingTarget::getRadianSpeed() const
 }
 
 /**
- * Returns the distance between this moving target and any other
- * target on the globe, accounting for the wrap-around.
+ * Returns the great-circle distance between two points on the globe.
+ * @param lon1 Longitude of the first point.
+ * @param lat1 Latitude of the first point.
+ * @param lon2 Longitude of the second point.
+ * @param lat2 Latitude of the second point.
+ * @return Distance in radian.
+ */
+double MovingTarget::getDistance(double lon1, double lat1, double lon2, double lat2)
+{
+	double a[3], b[3];
+	toVector(lon1, lat1, a);
+	toVector(lon2, lat2, b);
+	double cosine = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	if (cosine > 1.0)
+		cosine = 1.0;
+	else if (cosine < -1.0)
+		cosine = -1.0;
+	return acos(cosine);
+}
+
+/**
+ * Returns the great-circle distance between this
+ * moving target and any other target on the globe.
  * @param target Pointer to other target.
- * @param dLon Returned longitude difference.
- * @param dLat Returned latitude difference.
- * @returns Distance in radian.
+ * @return Distance in radian.
  */
-double MovingTarget::getDistance(Target *target, double *dLon, double *dLat) const
+double MovingTarget::getDistance(const Target *target) const
 {
-	double minLength = 2*M_PI, lat = target->getLatitude();
-	for (double lon = target->getLongitude() - 2*M_PI; lon <= target->getLongitude() + 2*M_PI; lon += 2*M_PI)
-	{
-		double dx = lon - _lon;
-		double dy = lat - _lat;
-		double length = sqrt(dx * dx + dy * dy);
-		if (length < minLength)
-		{
-			minLength = length;
-			*dLon = dx;
-			*dLat = dy;
-		}
-	}
-	return minLength;
+	return getDistance(_lon, _lat, target->getLongitude(), target->getLatitude());
 }
 
 /**
- * Calculates the speed vector for the moving target
- * based on the current raw speed and destination.
+ * Returns how much of the current route is left to travel.
+ * @return Distance in radian.
+ */
+double MovingTarget::getRouteLeft() const
+{
+	if (_dest == 0)
+		return 0.0;
+	return _legLength - _legDone;
+}
+
+/**
+ * Works out the great-circle route from the current position
+ * to the destination: the start and the direction it heads in,
+ * as unit vectors, and its length. Every position along it is
+ * then a rotation of the start, with no need to correct the
+ * heading on the way. The speed vector is the heading at the
+ * start, in radians per 5 seconds.
+ * A destination that moves itself is headed off where it
+ * can be caught, rather than chased.
  */
 void MovingTarget::calculateSpeed()
 {
+	_legDone = 0.0;
+	_routeId++;
 	if (_dest != 0)
 	{
-		double dLon, dLat;
-		double length = getDistance(_dest, &dLon, &dLat);
-		_speedLon = dLon / length * getRadianSpeed();
-		_speedLat = dLat / length * getRadianSpeed();
+		double aimLon = _dest->getLongitude(), aimLat = _dest->getLatitude();
+		const MovingTarget *target = dynamic_cast<const MovingTarget*>(_dest);
+		if (target != 0)
+		{
+			getIntercept(target, &aimLon, &aimLat);
+			_destRouteId = target->getRouteId();
+		}
+		double end[3];
+		toVector(_lon, _lat, _legStart);
+		toVector(aimLon, aimLat, end);
+		_legLength = getDistance(_lon, _lat, aimLon, aimLat);
+		// the part of the end at right angles to the start is the heading
+		double cosine = cos(_legLength), sine = sin(_legLength);
+		for (int i = 0; i < 3; i++)
+		{
+			_legTangent[i] = (sine > 1e-9) ? (end[i] - _legStart[i] * cosine) / sine : 0.0;
+		}
+		// the heading split into longitude and latitude at the start
+		double alongLon = -sin(_lon) * _legTangent[0] + cos(_lon) * _legTangent[1];
+		double alongLat = -sin(_lat) * cos(_lon) * _legTangent[0] - sin(_lat) * sin(_lon) * _legTangent[1] + cos(_lat) * _legTangent[2];
+		double lonScale = (cos(_lat) > 1e-9) ? 1 / cos(_lat) : 0.0;
+		_speedLon = alongLon * lonScale * getRadianSpeed();
+		_speedLat = alongLat * getRadianSpeed();
+		_destLon = _dest->getLongitude();
+		_destLat = _dest->getLatitude();
 	}
 	else
 	{
+		_legLength = 0.0;
 		_speedLon = 0;
 		_speedLat = 0;
 	}
 }
 
 /**
- * Checks if the moving target has finished its route by checking
- * if it has exceeded the destination position based on the speed vector.
+ * Returns the position a certain distance along the route,
+ * without moving there, to predict where the moving target
+ * will be. It stops at the destination.
+ * @param distance Distance along the route in radian.
+ * @param lon Returned longitude.
+ * @param lat Returned latitude.
+ */
+void MovingTarget::getRoutePosition(double distance, double *lon, double *lat) const
+{
+	if (distance > _legLength)
+		distance = _legLength;
+	double cosine = cos(distance), sine = sin(distance);
+	double v[3];
+	for (int i = 0; i < 3; i++)
+	{
+		v[i] = _legStart[i] * cosine + _legTangent[i] * sine;
+	}
+	double z = v[2];
+	if (z > 1.0)
+		z = 1.0;
+	else if (z < -1.0)
+		z = -1.0;
+	*lat = asin(z);
+	*lon = atan2(v[1], v[0]);
+}
+
+/**
+ * Moves the moving target one 5 second step along its route.
+ */
+void MovingTarget::moveAlongRoute()
+{
+	if (_dest == 0)
+		return;
+	_legDone += getRadianSpeed();
+	double lon, lat;
+	getRoutePosition(_legDone, &lon, &lat);
+	setLongitude(lon);
+	setLatitude(lat);
+}
+
+/**
+ * Checks if the moving target has finished its route,
+ * by how far along the route it's gone.
  * @return True if it has, False otherwise.
  */
 bool MovingTarget::finishedRoute() const
 {
-	return (((_speedLon > 0 && _lon >= _dest->getLongitude()) || (_speedLon < 0 && _lon <= _dest->getLongitude()) || _speedLon == 0) &&
-			((_speedLat > 0 && _lat >= _dest->getLatitude()) || (_speedLat < 0 && _lat <= _dest->getLatitude()) || _speedLat == 0));
+	return (_legDone >= _legLength);
+}
+
+/**
+ * Checks if the destination has changed position since the
+ * route was last calculated. The route heads in a straight
+ * line, so it only needs updating when it has. A destination
+ * that moves itself was headed off along its own route, so
+ * that only counts when it changes route.
+ * @return True if it has, False otherwise.
+ */
+bool MovingTarget::destinationMoved() const
+{
+	if (_dest == 0)
+		return false;
+	const MovingTarget *target = dynamic_cast<const MovingTarget*>(_dest);
+	if (target != 0)
+		return (target->getRouteId() != _destRouteId);
+	return (_dest->getLongitude() != _destLon || _dest->getLatitude() != _destLat);
+}
+
+/**
+ * Returns the ID of the current route, which changes
+ * every time the route is worked out again.
+ * @return Route ID.
+ */
+int MovingTarget::getRouteId() const
+{
+	return _routeId;
+}
+
+/**
+ * Predicts where this moving target can meet another one that
+ * keeps going along its route at its speed. Both positions are
+ * closed-form, so the meeting time is found by bisection between
+ * now and the end of the other one's route, to within a step.
+ * One that can't be caught before it finishes its route is met
+ * at its destination.
+ * @param target Pointer to the other moving target.
+ * @param lon Returned longitude of the meeting point.
+ * @param lat Returned latitude of the meeting point.
+ * @return Time until they meet, in 5 second steps, or -1 if this one isn't moving.
+ */
+double MovingTarget::getIntercept(const MovingTarget *target, double *lon, double *lat) const
+{
+	*lon = target->getLongitude();
+	*lat = target->getLatitude();
+	double speed = getRadianSpeed();
+	if (speed <= 0.0)
+		return -1;
+	double targetSpeed = target->getRadianSpeed();
+	if (target->getDestination() == 0 || targetSpeed <= 0.0)
+		return getDistance(_lon, _lat, *lon, *lat) / speed;
+
+	// by the end of the target's route, can we be there?
+	double end = target->getRouteLeft() / targetSpeed;
+	target->getRoutePosition(target->_legDone + end * targetSpeed, lon, lat);
+	double arrival = getDistance(_lon, _lat, *lon, *lat) / speed;
+	if (arrival >= end)
+		return arrival;
+
+	double low = 0.0, high = end;
+	for (int i = 0; i < 32 && high - low > 0.5; i++)
+	{
+		double mid = (low + high) / 2;
+		double midLon, midLat;
+		target->getRoutePosition(target->_legDone + mid * targetSpeed, &midLon, &midLat);
+		if (getDistance(_lon, _lat, midLon, midLat) <= mid * speed)
+			high = mid;
+		else
+			low = mid;
+	}
+	target->getRoutePosition(target->_legDone + high * targetSpeed, lon, lat);
+	return high;
 }
 
 /**
@@ -34,9 +34,17 @@ protected:
 	Target *_dest;
 	double _speedLon, _speedLat;
 	int _speed;
-	
+	double _destLon, _destLat;
+	double _legStart[3], _legTangent[3];
+	double _legLength, _legDone;
+	int _routeId, _destRouteId;
+
+	/// Gets the position a certain distance along the route.
+	void getRoutePosition(double distance, double *lon, double *lat) const;
 	/// Has the moving target finished its route?
 	bool finishedRoute() const;
+	/// Has the destination moved since the speed vector was calculated?
+	bool destinationMoved() const;
 	/// Calculates a new speed vector to the destination.
 	virtual void calculateSpeed();
 public:
@@ -58,8 +66,18 @@ public:
 	void setSpeed(int speed);
 	/// Gets the moving target's speed in radian.
 	double getRadianSpeed() const;
+	/// Gets the distance between two points on the globe.
+	static double getDistance(double lon1, double lat1, double lon2, double lat2);
 	/// Gets the distance to another target.
-	double getDistance(Target *target, double *dLon, double *dLat) const;
+	double getDistance(const Target *target) const;
+	/// Gets the distance left to the destination.
+	double getRouteLeft() const;
+	/// Moves the moving target along its route.
+	void moveAlongRoute();
+	/// Gets the ID of the moving target's current route.
+	int getRouteId() const;
+	/// Predicts where this moving target can catch up with another.
+	double getIntercept(const MovingTarget *target, double *lon, double *lat) const;
 	/// Has the moving target reached its destination?
 	bool reachedDestination() const;
 };
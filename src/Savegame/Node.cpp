@@ -17,7 +17,6 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Node.h"
-#include "NodeLink.h"
 
 namespace OpenXcom
 {
@@ -35,11 +34,6 @@ namespace OpenXcom
  */
 Node::Node(int id, Position pos, int segment, int type, int rank, int flags, int reserved, int priority) : _id(id), _pos(pos), _segment(segment), _type(type), _rank(rank), _flags(flags), _reserved(reserved), _priority(priority)
 {
-	_nodeLinks[0] = 0;
-	_nodeLinks[1] = 0;
-	_nodeLinks[2] = 0;
-	_nodeLinks[3] = 0;
-	_nodeLinks[4] = 0;
 }
 
 /**
@@ -47,23 +41,38 @@ Node::Node(int id, Position pos, int segment, int type, int rank, int flags, int
  */
 Node::~Node()
 {
-	delete _nodeLinks[0];
-	delete _nodeLinks[1];
-	delete _nodeLinks[2];
-	delete _nodeLinks[3];
-	delete _nodeLinks[4];
 }
 
 /**
- * Assign a node link to this node.
- * @param link pointer to the link
+ * Gets the ID of the node, which is its index in the battle's list of nodes.
+ * @return ID
+ */
+int Node::getId() const
+{
+	return _id;
+}
+
+/**
+ * Assign a node link to this node. Links are kept inside
+ * the node, so they don't need allocating on their own.
+ * @param link the link
  * @param index 0-4
  */
-void Node::assignNodeLink(NodeLink *link, int index)
+void Node::assignNodeLink(const NodeLink &link, int index)
 {
 	_nodeLinks[index] = link;
 }
 
+/**
+ * Gets one of the links to other nodes.
+ * @param index 0-4
+ * @return the link
+ */
+const NodeLink &Node::getNodeLink(int index) const
+{
+	return _nodeLinks[index];
+}
+
 /**
  * Get the rank of units that can spawn on this node.
  * @return noderank
@@ -20,12 +20,11 @@
 #define OPENXCOM_NODE_H
 
 #include "../Battlescape/Position.h"
+#include "NodeLink.h"
 
 namespace OpenXcom
 {
 
-class NodeLink;
-
 enum NodeRank{SCOUT=0, XCOM, SOLDIER, NAVIGATOR, LEADER, ENGINEER, MISC1, MEDIC, MISC2};
 			
 
@@ -39,7 +38,7 @@ private:
 	int _id;
 	Position _pos;
 	int _segment;
-	NodeLink *_nodeLinks[5];
+	NodeLink _nodeLinks[5];
 	int _type;
 	int _rank;
 	int _flags;
@@ -50,10 +49,12 @@ public:
 	Node(int id, Position pos, int segment, int type, int rank, int flags, int reserved, int priority);
 	/// Cleans up the Node.
 	~Node();
-	/// get the node's paths
-	//NodeLink *getNodeLink(int index);
+	/// Gets the node's ID.
+	int getId() const;
+	/// Gets one of the node's paths.
+	const NodeLink &getNodeLink(int index) const;
 	/// Assigns a link to this node
-	void assignNodeLink(NodeLink *link, int index);
+	void assignNodeLink(const NodeLink &link, int index);
 	/// Gets node's rank.
 	NodeRank getRank() const;
 	/// Gets node's priorty.
@@ -21,13 +21,20 @@
 namespace OpenXcom
 {
 
+/**
+ * Initializes a NodeLink that doesn't lead anywhere.
+ */
+NodeLink::NodeLink(): _connectedNodeID(-1), _distance(0), _travelType(0), _connectedNode(0)
+{
+}
+
 /**
  * Initializes a NodeLink.
  * @param connectedNodeID
  * @param distance
  * @param travelType
  */
-NodeLink::NodeLink(int connectedNodeID, int distance, int travelType): _connectedNodeID(connectedNodeID), _distance(distance), _travelType(travelType)
+NodeLink::NodeLink(int connectedNodeID, int distance, int travelType): _connectedNodeID(connectedNodeID), _distance(distance), _travelType(travelType), _connectedNode(0)
 {
 }
 
@@ -38,4 +45,22 @@ NodeLink::~NodeLink()
 {
 }
 
+/**
+ * Gets the ID of the node this link leads to.
+ * @return node ID, negative if it leads off the map or nowhere.
+ */
+int NodeLink::getConnectedNodeID() const
+{
+	return _connectedNodeID;
+}
+
+/**
+ * Gets the length of the link.
+ * @return distance in tiles.
+ */
+int NodeLink::getDistance() const
+{
+	return _distance;
+}
+
 }
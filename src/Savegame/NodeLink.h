@@ -35,10 +35,16 @@ private:
 	int _travelType;
 	Node *_connectedNode;
 public:
+	/// Creates an unconnected nodelink.
+	NodeLink();
 	/// Creates a nodelink.
 	NodeLink(int connectedNodeID, int distance, int travelType);
 	/// Cleans up the nodelink.
 	~NodeLink();
+	/// Gets the ID of the node it leads to.
+	int getConnectedNodeID() const;
+	/// Gets the length of the link.
+	int getDistance() const;
 };
 
 }
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Project.h"
+#include "Base.h"
+#include "ItemContainer.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Initializes a project with no staff.
+ * @param type Research or manufacturing.
+ * @param name Research topic or item being made.
+ * @param cost Man-hours of work each result takes.
+ * @param amount Amount of results to make.
+ */
+Project::Project(ProjectType type, const std::string &name, int cost, int amount) : _type(type), _name(name), _cost(cost), _amount(amount), _produced(0), _work(0), _since(0), _staff(0)
+{
+}
+
+/**
+ * Cleans up the project.
+ */
+Project::~Project()
+{
+}
+
+/**
+ * Loads the project from a YAML file.
+ * @param node YAML node.
+ */
+void Project::load(const YAML::Node &node)
+{
+	int a;
+	node["type"] >> a;
+	_type = (ProjectType)a;
+	node["name"] >> _name;
+	node["cost"] >> _cost;
+	node["amount"] >> _amount;
+	node["produced"] >> _produced;
+	node["work"] >> _work;
+	node["since"] >> _since;
+	node["staff"] >> _staff;
+}
+
+/**
+ * Saves the project to a YAML file.
+ * @param out YAML emitter.
+ */
+void Project::save(YAML::Emitter &out) const
+{
+	out << YAML::BeginMap;
+	out << YAML::Key << "type" << YAML::Value << _type;
+	out << YAML::Key << "name" << YAML::Value << _name;
+	out << YAML::Key << "cost" << YAML::Value << _cost;
+	out << YAML::Key << "amount" << YAML::Value << _amount;
+	out << YAML::Key << "produced" << YAML::Value << _produced;
+	out << YAML::Key << "work" << YAML::Value << _work;
+	out << YAML::Key << "since" << YAML::Value << _since;
+	out << YAML::Key << "staff" << YAML::Value << _staff;
+	out << YAML::EndMap;
+}
+
+/**
+ * Returns whether the project is research or manufacturing.
+ * @return Project type.
+ */
+ProjectType Project::getType() const
+{
+	return _type;
+}
+
+/**
+ * Returns the research topic or item being made.
+ * @return Name ID.
+ */
+std::string Project::getName() const
+{
+	return _name;
+}
+
+/**
+ * Returns how many man-hours of work each
+ * result of the project takes.
+ * @return Man-hours.
+ */
+int Project::getCost() const
+{
+	return _cost;
+}
+
+/**
+ * Returns how many results the project makes in total.
+ * Research only ever makes one.
+ * @return Amount.
+ */
+int Project::getAmount() const
+{
+	return _amount;
+}
+
+/**
+ * Returns how many results the project has made so far.
+ * @return Amount.
+ */
+int Project::getProduced() const
+{
+	return _produced;
+}
+
+/**
+ * Returns how many scientists or engineers
+ * are working on the project.
+ * @return Staff.
+ */
+int Project::getStaff() const
+{
+	return _staff;
+}
+
+/**
+ * Changes the staff on the project. The work done at the
+ * old rate is counted up first, so the new rate only
+ * applies from now on.
+ * @param staff New amount of staff.
+ * @param now Hours passed in the game.
+ */
+void Project::setStaff(int staff, int now)
+{
+	_work = getWork(now);
+	_since = now;
+	_staff = staff;
+}
+
+/**
+ * Returns how many man-hours of work have gone into the
+ * project by a certain hour, at the current staff.
+ * @param now Hours passed in the game.
+ * @return Man-hours.
+ */
+int Project::getWork(int now) const
+{
+	return _work + _staff * (now - _since);
+}
+
+/**
+ * Returns the hour the next result of the project is due,
+ * which only changes when the staff does.
+ * @return Hour, or -1 if it will never be due.
+ */
+int Project::getDue() const
+{
+	if (_staff == 0 || isFinished())
+	{
+		return -1;
+	}
+	int left = (_produced + 1) * _cost - _work;
+	if (left <= 0)
+	{
+		return _since;
+	}
+	return _since + (left + _staff - 1) / _staff;
+}
+
+/**
+ * Hands out all the results of the project due by now.
+ * Manufactured items go straight into the base stores.
+ * @param base Pointer to the base of the project.
+ * @param now Hours passed in the game.
+ * @return True if the project is finished.
+ */
+bool Project::advance(Base *base, int now)
+{
+	int work = getWork(now);
+	while (!isFinished() && work >= (_produced + 1) * _cost)
+	{
+		_produced++;
+		if (_type == PROJECT_MANUFACTURE)
+		{
+			base->getItems()->addItem(_name);
+		}
+	}
+	return isFinished();
+}
+
+/**
+ * Returns whether all the results of the project are made.
+ * @return True if it's finished.
+ */
+bool Project::isFinished() const
+{
+	return _produced >= _amount;
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2010 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_PROJECT_H
+#define OPENXCOM_PROJECT_H
+
+#include <string>
+#include "yaml.h"
+
+namespace OpenXcom
+{
+
+enum ProjectType { PROJECT_RESEARCH, PROJECT_MANUFACTURE };
+
+class Base;
+
+/**
+ * Represents a research or manufacturing project in a base.
+ * Work goes at a steady rate of one man-hour per hour for each
+ * scientist or engineer on the project, so instead of ticking
+ * every hour the project only keeps the work done up to the
+ * last time its staff changed, and when each result is due
+ * follows straight from that.
+ */
+class Project
+{
+private:
+	ProjectType _type;
+	std::string _name;
+	int _cost, _amount, _produced;
+	int _work, _since, _staff;
+public:
+	/// Creates a new project.
+	Project(ProjectType type, const std::string &name, int cost, int amount = 1);
+	/// Cleans up the project.
+	~Project();
+	/// Loads the project from YAML.
+	void load(const YAML::Node& node);
+	/// Saves the project to YAML.
+	void save(YAML::Emitter& out) const;
+	/// Gets the type of the project.
+	ProjectType getType() const;
+	/// Gets the name of the project.
+	std::string getName() const;
+	/// Gets the man-hours each result takes.
+	int getCost() const;
+	/// Gets the amount of results to make.
+	int getAmount() const;
+	/// Gets the amount of results made.
+	int getProduced() const;
+	/// Gets the staff on the project.
+	int getStaff() const;
+	/// Changes the staff on the project.
+	void setStaff(int staff, int now);
+	/// Gets the man-hours of work done.
+	int getWork(int now) const;
+	/// Gets the hour the next result is due.
+	int getDue() const;
+	/// Hands out the results due.
+	bool advance(Base *base, int now);
+	/// Gets whether the project is finished.
+	bool isFinished() const;
+};
+
+}
+
+#endif
@@ -26,7 +26,7 @@ namespace OpenXcom
  * Initializes a region of the specified type.
  * @param rules Pointer to ruleset.
  */
-Region::Region(RuleRegion *rules): _rules(rules), _activityXcom(0), _activityAlien(0)
+Region::Region(RuleRegion *rules): _rules(rules), _activityXcom(0), _activityAlien(0), _xcomHistory(), _alienHistory()
 {
 }
 
@@ -45,6 +45,11 @@ void Region::load(const YAML::Node &node)
 {
 	node["activityXcom"] >> _activityXcom;
 	node["activityAlien"] >> _activityAlien;
+	if (const YAML::Node *pName = node.FindValue("history"))
+	{
+		_xcomHistory.load((*pName)["activityXcom"]);
+		_alienHistory.load((*pName)["activityAlien"]);
+	}
 }
 
 /**
@@ -57,6 +62,13 @@ void Region::save(YAML::Emitter &out) const
 	out << YAML::Key << "type" << YAML::Value << _rules->getType();
 	out << YAML::Key << "activityXcom" << YAML::Value << _activityXcom;
 	out << YAML::Key << "activityAlien" << YAML::Value << _activityAlien;
+	out << YAML::Key << "history" << YAML::Value;
+	out << YAML::BeginMap;
+	out << YAML::Key << "activityXcom" << YAML::Value;
+	_xcomHistory.save(out);
+	out << YAML::Key << "activityAlien" << YAML::Value;
+	_alienHistory.save(out);
+	out << YAML::EndMap;
 	out << YAML::EndMap;
 }
 
@@ -69,4 +81,35 @@ RuleRegion *const Region::getRules() const
 	return _rules;
 }
 
+/**
+ * Adds the region's activity of the month that just ended
+ * to its history, and starts counting the activity of
+ * the new month from scratch.
+ */
+void Region::endMonth()
+{
+	_xcomHistory.add(_activityXcom);
+	_alienHistory.add(_activityAlien);
+	_activityXcom = 0;
+	_activityAlien = 0;
+}
+
+/**
+ * Returns the X-Com activity in the region over the last months.
+ * @return Activity history.
+ */
+const MonthlyHistory &Region::getXcomHistory() const
+{
+	return _xcomHistory;
+}
+
+/**
+ * Returns the alien activity in the region over the last months.
+ * @return Activity history.
+ */
+const MonthlyHistory &Region::getAlienHistory() const
+{
+	return _alienHistory;
+}
+
 }
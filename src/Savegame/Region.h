@@ -21,6 +21,7 @@
 
 #include <vector>
 #include "yaml.h"
+#include "MonthlyHistory.h"
 
 namespace OpenXcom
 {
@@ -37,6 +38,7 @@ class Region
 private:
 	RuleRegion *_rules;
 	int _activityXcom, _activityAlien;
+	MonthlyHistory _xcomHistory, _alienHistory;
 public:
 	/// Creates a new region of the specified type.
 	Region(RuleRegion *rules);
@@ -48,6 +50,12 @@ public:
 	void save(YAML::Emitter& out) const;
 	/// Gets the region's ruleset.
 	RuleRegion *const getRules() const;
+	/// Records the month's activity in the history.
+	void endMonth();
+	/// Gets the region's X-Com activity over the last months.
+	const MonthlyHistory &getXcomHistory() const;
+	/// Gets the region's alien activity over the last months.
+	const MonthlyHistory &getAlienHistory() const;
 };
 
 }
@@ -18,28 +18,52 @@
  */
 
 
+#include <cstring>
+#include <new>
+#include <map>
+#include <queue>
+#include <functional>
 #include "SavedBattleGame.h"
 #include "SavedGame.h"
 #include "Tile.h"
 #include "Node.h"
 #include "SDL.h"
 #include "../Ruleset/MapDataSet.h"
+#include "../Ruleset/MapData.h"
+#include "../Ruleset/Ruleset.h"
 #include "../Battlescape/Pathfinding.h"
 #include "../Battlescape/TerrainModifier.h"
 #include "../Battlescape/Position.h"
 #include "../Resource/ResourcePack.h"
+#include "../Engine/Profiler.h"
+#include "../Engine/StateHash.h"
 
 namespace OpenXcom
 {
 
 std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len);
+std::string base64_decode(std::string const& encoded_string);
+
+/// Voxel shape of the missing terrain objects.
+static const Uint16 emptyLoft[16] = {0};
 
 /**
  * Initializes a brand new battlescape saved game.
  */
-SavedBattleGame::SavedBattleGame() : _tiles(), _nodes(), _units(), _side(FACTION_PLAYER), _turn(1), _debugMode(false)
+SavedBattleGame::SavedBattleGame() : _acquiredMapDataSets(0), _tiles(0), _tileStore(0), _nodes(), _nodeStores(), _nodeDistances(), _units(), _unitBuckets(), _bucketsWide(0), _items(), _itemStores(), _itemStoreUsed(ITEM_STORE_SIZE), _pathfinding(0), _terrainModifier(0), _side(FACTION_PLAYER), _turn(1), _debugMode(false), _terrainVersion(0)
 {
+	for (int i = 0; i < 3; i++)
+	{
+		_visibleDirty[i] = true;
+	}
 
+	// the first entry of the terrain table stands for missing objects
+	_terrainTUCosts.resize(3, 0);
+	_terrainFlags.push_back(TERRAIN_NO_FLOOR);
+	_terrainLights.push_back(0);
+	_terrainBlocks.resize(BLOCKAGE_CHANNELS, 0);
+	_terrainLevels.push_back(0);
+	_terrainLofts.resize(12, emptyLoft);
 }
 
 /** 
@@ -47,15 +71,32 @@ SavedBattleGame::SavedBattleGame() : _tiles(), _nodes(), _units(), _side(FACTION
  */
 SavedBattleGame::~SavedBattleGame()
 {
-	for (int i = 0; i < _height * _length * _width; i++)
+	for (size_t i = 0; i < _acquiredMapDataSets; i++)
 	{
-		delete _tiles[i];
+		if (_mapDataFiles[i] != 0)
+		{
+			_mapDataFiles[i]->release();
+		}
+	}
+
+	if (_tileStore)
+	{
+		for (int i = 0; i < _height * _length * _width; i++)
+		{
+			_tileStore[i].~Tile();
+		}
+		::operator delete(_tileStore);
+		Profiler::addMemory(MEM_TILES, -(long)((sizeof(Tile) + sizeof(Tile*)) * _height * _length * _width));
 	}
 	delete[] _tiles;
 
 	for (std::vector<Node*>::iterator i = _nodes.begin(); i != _nodes.end(); i++)
 	{
-		delete *i;
+		(*i)->~Node();
+	}
+	for (std::vector<Node*>::iterator i = _nodeStores.begin(); i != _nodeStores.end(); i++)
+	{
+		::operator delete(*i);
 	}
 
 	for (std::vector<BattleUnit*>::iterator i = _units.begin(); i != _units.end(); i++)
@@ -65,7 +106,11 @@ SavedBattleGame::~SavedBattleGame()
 
 	for (std::vector<BattleItem*>::iterator i = _items.begin(); i != _items.end(); i++)
 	{
-		delete *i;
+		(*i)->~BattleItem();
+	}
+	for (std::vector<BattleItem*>::iterator i = _itemStores.begin(); i != _itemStores.end(); i++)
+	{
+		::operator delete(*i);
 	}
 
 	delete _pathfinding;
@@ -74,26 +119,96 @@ SavedBattleGame::~SavedBattleGame()
 
 /**
  * Loads the saved battle game from a YAML file.
+ * The map itself is only filled in by loadMap(),
+ * once the terrain can be loaded.
  * @param node YAML node.
+ * @param rule Ruleset for the saved game.
  */
-void SavedBattleGame::load(const YAML::Node &node)
+void SavedBattleGame::load(const YAML::Node &node, Ruleset *rule)
 {
 	unsigned int size = 0;
 
 	node["width"] >> _width;
 	node["length"] >> _length;
 	node["height"] >> _height;
+	node["globalshade"] >> _globalShade;
 
-	size = node["mapdatafiles"].size();
+	const YAML::Node &mapdatafiles = node["mapdatafiles"];
+	size = mapdatafiles.size();
 	for (unsigned int i = 0; i < size; i++)
 	{
 		std::string name;
-		node["mapdatafiles"][i] >> name;
-		// now we have the names of the mapdatafiles, but we need to find the mapadatafile objects themselves...
-		// no idea to do this atm
-		// will figure this out some time
+		mapdatafiles[i] >> name;
+		_mapDataFiles.push_back(rule->getMapDataSet(name));
 	}
 
+	std::string tiles;
+	node["tiles"] >> tiles;
+	_tileData = base64_decode(tiles);
+}
+
+/**
+ * Loads the terrain of a loaded battle game and fills
+ * in its tiles from the saved tile data.
+ * @param res Pointer to resource pack.
+ */
+void SavedBattleGame::loadMap(ResourcePack *res)
+{
+	TraceMarker trace("load battle map");
+	for (size_t i = _acquiredMapDataSets; i < _mapDataFiles.size(); i++)
+	{
+		if (_mapDataFiles[i] != 0)
+		{
+			_mapDataFiles[i]->acquire(res);
+			addTerrainObjects(_mapDataFiles[i]);
+		}
+	}
+	_acquiredMapDataSets = _mapDataFiles.size();
+
+	initMap(_width, _length, _height);
+	initUtilities(res);
+
+	const unsigned char *data = (const unsigned char*)_tileData.c_str();
+	size_t pos = 0;
+	int i = 0;
+	while (i < _height * _length * _width && pos < _tileData.length())
+	{
+		// a run of empty tiles
+		if (data[pos] == TILE_EMPTY_RUN)
+		{
+			if (pos + 3 > _tileData.length())
+				break;
+			i += data[pos + 1] | (data[pos + 2] << 8);
+			pos += 3;
+			continue;
+		}
+		if (pos + TILE_DATA_SIZE > _tileData.length())
+			break;
+		for (int part = 0; part < 4; part++)
+		{
+			unsigned int set = data[pos + part * 2], object = data[pos + part * 2 + 1];
+			if (set < _mapDataFiles.size() && _mapDataFiles[set] != 0 && object < _mapDataFiles[set]->getObjects()->size())
+			{
+				_tiles[i]->setMapData(_mapDataFiles[set]->getObjects()->at(object), part);
+			}
+		}
+		if (data[pos + 8] > 0)
+		{
+			_tiles[i]->setFire(data[pos + 8]);
+		}
+		if (data[pos + 9] > 0)
+		{
+			_tiles[i]->addSmoke(data[pos + 9]);
+		}
+		_tiles[i]->setDiscovered((data[pos + 10] & 1) != 0);
+		pos += TILE_DATA_SIZE;
+		i++;
+	}
+	_tileData.clear();
+
+	_terrainModifier->calculateSunShading();
+	_terrainModifier->calculateTerrainLighting();
+	_terrainModifier->calculateUnitLighting();
 }
 
 /**
@@ -102,14 +217,12 @@ void SavedBattleGame::load(const YAML::Node &node)
  */
 void SavedBattleGame::save(YAML::Emitter &out) const
 {
-/** 
-* under construction
-*/
 	out << YAML::BeginMap;
 
 	out << YAML::Key << "width" << YAML::Value << _width;
 	out << YAML::Key << "length" << YAML::Value << _length;
 	out << YAML::Key << "height" << YAML::Value << _height;
+	out << YAML::Key << "globalshade" << YAML::Value << _globalShade;
 
 	out << YAML::Key << "mapdatafiles" << YAML::Value;
 	out << YAML::BeginSeq;
@@ -119,45 +232,71 @@ void SavedBattleGame::save(YAML::Emitter &out) const
 	}
 	out << YAML::EndSeq;
 
+	// Number every object by its datafile and its place in that file
+	std::map<MapData*, std::pair<Uint8, Uint8> > objectIds;
+	for (size_t i = 0; i < _mapDataFiles.size() && i < TILE_NO_OBJECT; i++)
+	{
+		std::vector<MapData*> *objects = _mapDataFiles[i]->getObjects();
+		for (size_t j = 0; j < objects->size() && j < 256; j++)
+		{
+			objectIds.insert(std::make_pair(objects->at(j), std::make_pair((Uint8)i, (Uint8)j)));
+		}
+	}
+
 	/* Every tile is 8 bytes, 2 bytes per object(ground,west,north,object) */
 	/* 1 byte for the datafile ID, 1 byte for the relative object ID in that file */
-	/* Value 0xFF means the next two bytes are the number of empty objects */
+	/* followed by 1 byte each for the fire, the smoke and the flags (1 = discovered) */
+	/* Value 0xFF means the next two bytes are the number of empty tiles */
 	/* The binary data is then base64 encoded to save as a string */
-	/*Uint8 tileData[8];
-	Uint16 empties = 0;
 	std::string tilesData;
+	Uint16 empties = 0;
 	for (int i = 0; i < _height * _length * _width; i++)
 	{
-		if (_tiles[i]->isVoid())
+		Tile *tile = _tiles[i];
+		bool empty = tile->isVoid() && tile->getFire() == 0 && tile->getSmoke() == 0;
+		if (empty)
 		{
 			empties++;
 		}
-		else
+		// if we had empty tiles before
+		// write them now
+		if (empties && (!empty || empties == 0xFFFF))
+		{
+			tilesData += (char)TILE_EMPTY_RUN;
+			tilesData += (char)(empties & 0xFF);
+			tilesData += (char)(empties >> 8);
+			empties = 0;
+		}
+		if (empty)
 		{
-			// if we had empty tiles before
-			// write them now
-			if (empties)
+			continue;
+		}
+		// now write 4x2 bytes
+		for (int part = 0; part < 4; part++)
+		{
+			std::map<MapData*, std::pair<Uint8, Uint8> >::const_iterator id = objectIds.find(tile->getMapData(part));
+			if (id == objectIds.end())
 			{
-				tilesData += 0xFF;
-				tilesData += empties;
-				empties = 0;
+				tilesData += (char)TILE_NO_OBJECT;
+				tilesData += (char)0;
 			}
-			// now write 4x2 bytes
-			for (int part = 0; part < 4; part++)
+			else
 			{
-				MapDataSet *mds = _tiles[i]->getMapData(part)->getDataset();
-				tilesData += (Uint8)(std::find(_mapDataFiles.begin(), _mapDataFiles.end(), mds) - _mapDataFiles.begin());
-				tilesData += (Uint8)(std::find(mds->getObjects()->begin(), mds->getObjects()->end(), _tiles[i]->getMapData(part)) - mds->getObjects()->begin());
+				tilesData += (char)id->second.first;
+				tilesData += (char)id->second.second;
 			}
 		}
+		tilesData += (char)std::min(tile->getFire(), 255);
+		tilesData += (char)std::min(tile->getSmoke(), 255);
+		tilesData += (char)(tile->isDiscovered() ? 1 : 0);
 	}
 	if (empties)
 	{
-		tilesData += 0xFF;
-		tilesData += empties;
+		tilesData += (char)TILE_EMPTY_RUN;
+		tilesData += (char)(empties & 0xFF);
+		tilesData += (char)(empties >> 8);
 	}
-	//out << YAML::Key << "tiles" << YAML::WriteBinary(tilesData, tilesData.length());
-	out << YAML::Key << "tiles" << base64_encode((unsigned char*)(tilesData.c_str()), tilesData.length());*/
+	out << YAML::Key << "tiles" << YAML::Value << base64_encode((const unsigned char*)tilesData.c_str(), tilesData.length());
 
 	out << YAML::Key << "units" << YAML::Value;
 	out << YAML::BeginSeq;
@@ -188,7 +327,9 @@ Tile **SavedBattleGame::getTiles()
 }
 
 /** 
- * Initializes the array of tiles + creates a pathfinding object.
+ * Initializes the array of tiles and creates the tile objects.
+ * All tiles are stored in one block of memory in index order, so sweeps over the whole map
+ * don't jump around the heap.
  * @param width
  * @param length
  * @param height
@@ -199,12 +340,54 @@ void SavedBattleGame::initMap(int width, int length, int height)
 	_length = length;
 	_height = height;
 	_tiles = new Tile*[_height * _length * _width];
+	_tileStore = static_cast<Tile*>(::operator new(sizeof(Tile) * _height * _length * _width));
+	Profiler::addMemory(MEM_TILES, (sizeof(Tile) + sizeof(Tile*)) * _height * _length * _width);
+
+	// units are kept in buckets of columns of tiles, so we can quickly find the ones near a position
+	_bucketsWide = (_width + UNIT_BUCKET_SIZE - 1) / UNIT_BUCKET_SIZE;
+	_unitBuckets.clear();
+	_unitBuckets.resize(_bucketsWide * ((_length + UNIT_BUCKET_SIZE - 1) / UNIT_BUCKET_SIZE));
+
+	// tile flags are packed 32 to a word
+	for (int layer = 0; layer < TILE_LAYERS; layer++)
+	{
+		_tileLayers[layer].clear();
+		_tileLayers[layer].resize((_height * _length * _width + 31) / 32, 0);
+	}
+
+	// the sky levels are calculated once the terrain is loaded
+	_skyLevels.clear();
+
+	for (int i = 0; i < _height * _length * _width; i++)
+	{
+		Position pos;
+		getTileCoords(i, &pos.x, &pos.y, &pos.z);
+		_tiles[i] = new (&_tileStore[i]) Tile(pos, this);
+	}
+
+	_activeTiles.clear();
+	_animatedTiles.clear();
+	_itemTiles.clear();
+
+	// new tiles don't block anything until their objects are set
+	_blockages.assign(_height * _length * _width * BLOCKAGE_CHANNELS * 4, 0);
+	_tileObjects.assign(_height * _length * _width * 4, TERRAIN_NONE);
+
+	// the minimap draws all tiles the first time anyway
+	_miniMapTiles.clear();
+
+	// new tiles are not cached yet
+	_uncachedTiles.clear();
+	for (int i = 0; i < _height * _length * _width; i++)
+	{
+		_uncachedTiles.push_back(i);
+	}
 }
 
 void SavedBattleGame::initUtilities(ResourcePack *res)
 {
 	_pathfinding = new Pathfinding(this);
-	_terrainModifier = new TerrainModifier(this, res->getVoxelData());
+	_terrainModifier = new TerrainModifier(this, res->getLofts());
 }
 
 /** 
@@ -309,6 +492,486 @@ Tile *SavedBattleGame::getTile(const Position& pos)
 	return _tiles[getTileIndex(pos)];
 }
 
+/**
+ * Gets a flag of a tile.
+ * @param layer The flag layer.
+ * @param index Tile index.
+ * @return flag
+ */
+bool SavedBattleGame::getTileFlag(TileLayer layer, int index) const
+{
+	return (_tileLayers[layer][index >> 5] & (1u << (index & 31))) != 0;
+}
+
+/**
+ * Sets a flag of a tile.
+ * @param layer The flag layer.
+ * @param index Tile index.
+ * @param flag
+ */
+void SavedBattleGame::setTileFlag(TileLayer layer, int index, bool flag)
+{
+	if (flag)
+		_tileLayers[layer][index >> 5] |= (1u << (index & 31));
+	else
+		_tileLayers[layer][index >> 5] &= ~(1u << (index & 31));
+}
+
+/**
+ * Clears a flag for all tiles at once.
+ * @param layer The flag layer.
+ */
+void SavedBattleGame::clearTileLayer(TileLayer layer)
+{
+	if (!_tileLayers[layer].empty())
+	{
+		memset(&_tileLayers[layer][0], 0, _tileLayers[layer].size() * sizeof(Uint32));
+	}
+}
+
+/**
+ * Marks the visible tiles of a faction as outdated, call this when the field of view of one of its units changed.
+ * @param faction
+ */
+void SavedBattleGame::setVisibleTilesDirty(UnitFaction faction)
+{
+	_visibleDirty[faction] = true;
+}
+
+/**
+ * Rebuilds the visible tile layer of a faction. It is the combined field of view of all its units that are still standing.
+ * @param faction
+ */
+void SavedBattleGame::updateVisibleTiles(UnitFaction faction)
+{
+	TileLayer layer = (TileLayer)(LAYER_VISIBLE_PLAYER + faction);
+
+	clearTileLayer(layer);
+	for (std::vector<BattleUnit*>::iterator i = _units.begin(); i != _units.end(); i++)
+	{
+		if ((*i)->getFaction() == faction && !(*i)->isOut())
+		{
+			for (std::vector<Tile*>::iterator j = (*i)->getVisibleTiles()->begin(); j != (*i)->getVisibleTiles()->end(); j++)
+			{
+				setTileFlag(layer, getTileIndex((*j)->getPosition()), true);
+			}
+		}
+	}
+	_visibleDirty[faction] = false;
+}
+
+/**
+ * Checks if a tile is in the field of view of any unit of a faction.
+ * @param faction
+ * @param index Tile index.
+ * @return bool
+ */
+bool SavedBattleGame::isTileVisible(UnitFaction faction, int index)
+{
+	if (_visibleDirty[faction])
+	{
+		updateVisibleTiles(faction);
+	}
+	return getTileFlag((TileLayer)(LAYER_VISIBLE_PLAYER + faction), index);
+}
+
+/**
+ * Gets the packed visible tile layer of a faction, for bitwise queries over the whole map.
+ * Bit (index & 31) of word (index >> 5) is set when the tile with that index is visible.
+ * @param faction
+ * @return pointer to the packed flags
+ */
+const std::vector<Uint32> *SavedBattleGame::getVisibleTiles(UnitFaction faction)
+{
+	if (_visibleDirty[faction])
+	{
+		updateVisibleTiles(faction);
+	}
+	return &_tileLayers[LAYER_VISIBLE_PLAYER + faction];
+}
+
+/**
+ * Adds a tile to the list of tiles that need to be re-cached, so the map doesn't have to check all tiles.
+ * @param index Tile index.
+ */
+void SavedBattleGame::addUncachedTile(int index)
+{
+	_uncachedTiles.push_back(index);
+}
+
+/**
+ * Gets the list of tiles that need to be re-cached.
+ * @return pointer to the list of tile indices.
+ */
+std::vector<int> *SavedBattleGame::getUncachedTiles()
+{
+	return &_uncachedTiles;
+}
+
+/**
+ * Adds a tile to the tiles whose minimap block needs to be redrawn, because its objects
+ * changed or it just got discovered. Tiles already waiting aren't added again.
+ * @param index Tile index.
+ */
+void SavedBattleGame::addMiniMapTile(int index)
+{
+	if (!getTileFlag(LAYER_MINIMAP, index))
+	{
+		setTileFlag(LAYER_MINIMAP, index, true);
+		_miniMapTiles.push_back(index);
+	}
+}
+
+/**
+ * Gets the tiles whose minimap block needs to be redrawn.
+ * Whoever redraws them clears their minimap flag.
+ * @return pointer to the list of tile indices.
+ */
+std::vector<int> *SavedBattleGame::getMiniMapTiles()
+{
+	return &_miniMapTiles;
+}
+
+/**
+ * Adds a tile to the tiles that are burning or smoking, so turn preparations don't have to check all tiles.
+ * Tiles that stopped burning and smoking are removed by the turn preparations.
+ * @param index Tile index.
+ */
+void SavedBattleGame::addActiveTile(int index)
+{
+	_activeTiles.insert(index);
+}
+
+/**
+ * Gets the tiles that are burning or smoking, in tile index order.
+ * @return pointer to the set of tile indices.
+ */
+std::set<int> *SavedBattleGame::getActiveTiles()
+{
+	return &_activeTiles;
+}
+
+/**
+ * Adds a tile to the tiles with animated objects or ufo doors opening, so the map animation doesn't have to go through all tiles.
+ * Tiles that stopped animating are removed by the map animation.
+ * @param index Tile index.
+ */
+void SavedBattleGame::addAnimatedTile(int index)
+{
+	_animatedTiles.insert(index);
+}
+
+/**
+ * Gets the tiles that animate, in tile index order.
+ * @return pointer to the set of tile indices.
+ */
+std::set<int> *SavedBattleGame::getAnimatedTiles()
+{
+	return &_animatedTiles;
+}
+
+/**
+ * Gets the tiles that have items lying on them, in tile index order, so looking for
+ * items on the ground doesn't have to go through all tiles. Kept up to date by the tiles.
+ * @return pointer to the set of tile indices.
+ */
+std::set<int> *SavedBattleGame::getItemTiles()
+{
+	return &_itemTiles;
+}
+
+/**
+ * Gets the version of the terrain: it goes up every time terrain is destroyed, a door changes or a unit moves,
+ * so cached results that depend on the map can tell when they're outdated.
+ * @return version
+ */
+int SavedBattleGame::getTerrainVersion() const
+{
+	return _terrainVersion;
+}
+
+/**
+ * Records a change of a tile: its objects changed, one of its ufo doors opened or closed or a unit
+ * came or left. The terrain version goes up, and everything that keeps results depending on the tile
+ * is told exactly what changed, so it only has to forget those results.
+ * @param index Tile index.
+ * @param part Tile part that changed, -1 for units.
+ * @param type What changed.
+ */
+void SavedBattleGame::changeTerrain(int index, int part, TerrainChangeType type)
+{
+	TerrainChange change = { index, part, type, ++_terrainVersion };
+
+	if (type != CHANGE_UNIT)
+	{
+		updateBlockage(index);
+	}
+	if (type == CHANGE_OBJECT && part == O_FLOOR)
+	{
+		updateSkyLevel(index % _width, (index / _width) % _length);
+	}
+	if (type == CHANGE_OBJECT)
+	{
+		addMiniMapTile(index);
+	}
+	if (_pathfinding)
+	{
+		_pathfinding->changeTerrain(change);
+	}
+}
+
+/**
+ * Gets the lowest level of a column of tiles that is exposed to the sky, this is the level of the highest floor.
+ * Tiles below it are covered by that floor. The sky levels of all columns are calculated the first time.
+ * @param x
+ * @param y
+ * @return level
+ */
+int SavedBattleGame::getSkyLevel(int x, int y)
+{
+	if (_skyLevels.empty())
+	{
+		_skyLevels.resize(_width * _length, 0);
+		for (int i = 0; i < _width * _length; i++)
+		{
+			updateSkyLevel(i % _width, i / _width);
+		}
+	}
+	return _skyLevels[y * _width + x];
+}
+
+/**
+ * Updates the sky level of a column of tiles, by searching the highest floor from the top down.
+ * @param x
+ * @param y
+ */
+void SavedBattleGame::updateSkyLevel(int x, int y)
+{
+	if (_skyLevels.empty())
+		return;
+
+	int z = _height - 1;
+	while (z > 0 && getTile(Position(x, y, z))->getMapData(O_FLOOR) == 0)
+	{
+		z--;
+	}
+	_skyLevels[y * _width + x] = z;
+}
+
+/**
+ * Gets the blockage channel of a damage type: the damage types that
+ * no wall or object blocks all share the first one.
+ * @param type Damage type.
+ * @return Channel in the blockage grid.
+ */
+static int getBlockageChannel(ItemDamageType type)
+{
+	switch (type)
+	{
+	case DT_NONE:
+		return BlockageChannel<DT_NONE>::value;
+	case DT_HE:
+		return BlockageChannel<DT_HE>::value;
+	case DT_SMOKE:
+		return BlockageChannel<DT_SMOKE>::value;
+	case DT_IN:
+		return BlockageChannel<DT_IN>::value;
+	case DT_STUN:
+		return BlockageChannel<DT_STUN>::value;
+	default:
+		return BlockageChannel<DT_AP>::value;
+	}
+}
+
+/**
+ * Gets the amount a certain wall, floor or object of a tile blocks, from the blockage grid.
+ * This is just a lookup, the grid is kept up to date whenever tiles change.
+ * @param index Tile index.
+ * @param part Tile part.
+ * @param type Damage type.
+ * @return amount of blockage
+ */
+int SavedBattleGame::getBlockage(int index, int part, ItemDamageType type) const
+{
+	return _blockages[(index * BLOCKAGE_CHANNELS + getBlockageChannel(type)) * 4 + part];
+}
+
+/**
+ * Works out how much each part of a tile blocks every type of damage, for the blockage grid.
+ * Called whenever the objects on the tile change or one of its ufo doors opens or closes.
+ * @param index Tile index.
+ */
+void SavedBattleGame::updateBlockage(int index)
+{
+	static const ItemDamageType types[BLOCKAGE_CHANNELS] = {DT_AP, DT_NONE, DT_HE, DT_SMOKE, DT_IN, DT_STUN};
+	if (_blockages.empty())
+		return;
+
+	Tile *tile = _tiles[index];
+	for (int channel = 0; channel < BLOCKAGE_CHANNELS; channel++)
+	{
+		for (int part = 0; part < 4; part++)
+		{
+			int blockage = 0;
+			if (part == O_FLOOR && tile->getMapData(O_FLOOR))
+			{
+				// blockage modifiers of floors in ufo only counted for horizontal stuff, so this is kind of an experiment
+				if (types[channel] == DT_HE)
+					blockage = 15;
+				else
+					blockage = 255;
+			}
+			else if (part != O_FLOOR)
+			{
+				blockage = getTerrainBlock(getTileObject(index, part), types[channel]);
+
+				// open ufo doors are actually still closed behind the scenes
+				// so a special trick is needed to see if they are open, if they are, they obviously don't block anything
+				if (tile->isUfoDoorOpen(part))
+					blockage = 0;
+			}
+			_blockages[(index * BLOCKAGE_CHANNELS + channel) * 4 + part] = std::min(blockage, 255);
+		}
+	}
+}
+
+/**
+ * Gets the ID of a terrain object in the terrain table, the flat copy of the properties
+ * of all the objects used by the battle that the terrain hot loops walk instead of the objects.
+ * Objects that aren't in the table yet are added to it.
+ * @param object Pointer to the terrain object, or 0 for none.
+ * @return Terrain table ID.
+ */
+int SavedBattleGame::getTerrainId(MapData *object)
+{
+	if (object == 0)
+		return TERRAIN_NONE;
+
+	std::map<MapData*, Uint16>::iterator i = _terrainIds.find(object);
+	if (i != _terrainIds.end())
+		return i->second;
+
+	static const ItemDamageType types[BLOCKAGE_CHANNELS] = {DT_AP, DT_NONE, DT_HE, DT_SMOKE, DT_IN, DT_STUN};
+	int id = _terrainLevels.size();
+	_terrainIds[object] = id;
+	_terrainTUCosts.push_back(std::min(object->getTUCost(MT_WALK), 255));
+	_terrainTUCosts.push_back(std::min(object->getTUCost(MT_FLY), 255));
+	_terrainTUCosts.push_back(std::min(object->getTUCost(MT_SLIDE), 255));
+	_terrainFlags.push_back((object->isDoor() ? TERRAIN_DOOR : 0) | (object->isUFODoor() ? TERRAIN_UFO_DOOR : 0) | (object->isNoFloor() ? TERRAIN_NO_FLOOR : 0) | (object->isBigWall() ? TERRAIN_BIG_WALL : 0));
+	_terrainLights.push_back(object->getLightSource());
+	for (int channel = 0; channel < BLOCKAGE_CHANNELS; channel++)
+	{
+		_terrainBlocks.push_back(std::min(object->getBlock(types[channel]), 255));
+	}
+	_terrainLevels.push_back(object->getTerrainLevel());
+	for (int layer = 0; layer < 12; layer++)
+	{
+		_terrainLofts.push_back(object->getLoftLayer(layer));
+	}
+	return id;
+}
+
+/**
+ * Adds all the objects of a map datafile to the terrain table,
+ * so the objects of a datafile get consecutive IDs.
+ * @param dataSet Pointer to the loaded map datafile.
+ */
+void SavedBattleGame::addTerrainObjects(MapDataSet *dataSet)
+{
+	for (std::vector<MapData*>::iterator i = dataSet->getObjects()->begin(); i != dataSet->getObjects()->end(); i++)
+	{
+		getTerrainId(*i);
+	}
+}
+
+/**
+ * Sets the terrain object of a part of a tile in the terrain table.
+ * Called whenever the objects on the tile change.
+ * @param index Tile index.
+ * @param part Tile part.
+ * @param object Pointer to the terrain object, or 0 for none.
+ */
+void SavedBattleGame::setTileObject(int index, int part, MapData *object)
+{
+	if (_tileObjects.empty())
+		return;
+	_tileObjects[index * 4 + part] = getTerrainId(object);
+}
+
+/**
+ * Gets the terrain table ID of the object on a part of a tile.
+ * @param index Tile index.
+ * @param part Tile part.
+ * @return Terrain table ID, TERRAIN_NONE if there's no object.
+ */
+int SavedBattleGame::getTileObject(int index, int part) const
+{
+	return _tileObjects[index * 4 + part];
+}
+
+/**
+ * Gets the TU cost of moving over a terrain object.
+ * @param id Terrain table ID.
+ * @param movementType Movement type.
+ * @return TU cost, 255 if it can't be moved over.
+ */
+int SavedBattleGame::getTerrainTUCost(int id, MovementType movementType) const
+{
+	return _terrainTUCosts[id * 3 + movementType];
+}
+
+/**
+ * Gets the flags of a terrain object.
+ * @param id Terrain table ID.
+ * @return TerrainFlag bits.
+ */
+int SavedBattleGame::getTerrainFlags(int id) const
+{
+	return _terrainFlags[id];
+}
+
+/**
+ * Gets the offset units and items standing on a terrain object are raised by.
+ * @param id Terrain table ID.
+ * @return Terrain level in pixels.
+ */
+int SavedBattleGame::getTerrainLevel(int id) const
+{
+	return _terrainLevels[id];
+}
+
+/**
+ * Gets the amount of light a terrain object is emitting.
+ * @param id Terrain table ID.
+ * @return Light power.
+ */
+int SavedBattleGame::getTerrainLight(int id) const
+{
+	return _terrainLights[id];
+}
+
+/**
+ * Gets how much a terrain object blocks a type of damage.
+ * @param id Terrain table ID.
+ * @param type Damage type.
+ * @return amount of blockage (0-255)
+ */
+int SavedBattleGame::getTerrainBlock(int id, ItemDamageType type) const
+{
+	return _terrainBlocks[id * BLOCKAGE_CHANNELS + getBlockageChannel(type)];
+}
+
+/**
+ * Gets the voxel shape of a layer of a terrain object.
+ * @param id Terrain table ID.
+ * @param layer 0-11, every layer is 2 voxels high.
+ * @return pointer to the 16 rows of the shape.
+ */
+const Uint16 *SavedBattleGame::getTerrainLoft(int id, int layer) const
+{
+	return _terrainLofts[id * 12 + layer];
+}
+
 /**
  * Gets the currently selected unit
  * @return pointer to BattleUnit.
@@ -374,23 +1037,92 @@ BattleUnit *SavedBattleGame::selectNextPlayerUnit()
 
 /**
  * Select unit with position on map.
+ * Only the units in the bucket around the position are checked, so this is cheap enough for the map drawing.
  * @param pos Position
  * @return pointer to BattleUnit - 0 when nothing found
  */
 BattleUnit *SavedBattleGame::selectUnit(const Position& pos)
 {
-	BattleUnit *bu = 0;
+	if (_unitBuckets.empty())
+	{
+		return 0;
+	}
 
-	for (std::vector<BattleUnit*>::iterator i = _units.begin(); i != _units.end(); i++)
+	std::vector<BattleUnit*> *bucket = &_unitBuckets[getUnitBucketIndex(pos)];
+	for (std::vector<BattleUnit*>::iterator i = bucket->begin(); i != bucket->end(); i++)
 	{
 		if ((*i)->getPosition() == pos && !(*i)->isOut())
 		{
-			bu = *i;
-			break;
+			return *i;
 		}
 	}
 
-	return bu;
+	return 0;
+}
+
+/**
+ * Gets the index of the unit bucket covering a position. Positions outside the map go in the nearest bucket.
+ * @param pos Position
+ * @return bucket index
+ */
+int SavedBattleGame::getUnitBucketIndex(const Position& pos) const
+{
+	int x = std::max(0, std::min(pos.x, _width - 1)) / UNIT_BUCKET_SIZE;
+	int y = std::max(0, std::min(pos.y, _length - 1)) / UNIT_BUCKET_SIZE;
+	return y * _bucketsWide + x;
+}
+
+/**
+ * Moves a unit from the bucket of its last position to the bucket of its current position.
+ * Call this whenever a unit is placed on the map or moves to another tile.
+ * @param unit pointer to BattleUnit
+ */
+void SavedBattleGame::updateUnitBucket(BattleUnit *unit)
+{
+	std::vector<BattleUnit*> *bucket = &_unitBuckets[getUnitBucketIndex(unit->getLastPosition())];
+	std::vector<BattleUnit*>::iterator i = std::find(bucket->begin(), bucket->end(), unit);
+	if (i != bucket->end())
+	{
+		bucket->erase(i);
+	}
+	else
+	{
+		// not where we expected it, it could be in any bucket
+		for (std::vector<std::vector<BattleUnit*> >::iterator j = _unitBuckets.begin(); j != _unitBuckets.end(); j++)
+		{
+			j->erase(std::remove(j->begin(), j->end(), unit), j->end());
+		}
+	}
+	_unitBuckets[getUnitBucketIndex(unit->getPosition())].push_back(unit);
+}
+
+/**
+ * Gets the units within a square range of a position, on all levels.
+ * @param pos Position
+ * @param range Range in tiles.
+ * @param units List to add the units to.
+ */
+void SavedBattleGame::getUnitsInRange(const Position& pos, int range, std::vector<BattleUnit*> *units)
+{
+	int minX = getUnitBucketIndex(Position(pos.x - range, pos.y - range, 0)) % _bucketsWide;
+	int maxX = getUnitBucketIndex(Position(pos.x + range, pos.y - range, 0)) % _bucketsWide;
+	int minY = getUnitBucketIndex(Position(pos.x - range, pos.y - range, 0)) / _bucketsWide;
+	int maxY = getUnitBucketIndex(Position(pos.x - range, pos.y + range, 0)) / _bucketsWide;
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			std::vector<BattleUnit*> *bucket = &_unitBuckets[y * _bucketsWide + x];
+			for (std::vector<BattleUnit*>::iterator i = bucket->begin(); i != bucket->end(); i++)
+			{
+				if (abs((*i)->getPosition().x - pos.x) <= range && abs((*i)->getPosition().y - pos.y) <= range)
+				{
+					units->push_back(*i);
+				}
+			}
+		}
+	}
 }
 
 /**
@@ -402,6 +1134,123 @@ std::vector<Node*> *SavedBattleGame::getNodes()
 	return &_nodes;
 }
 
+/**
+ * Gets a block of memory for a number of nodes, which
+ * the battlegame frees along with them. Each node is built
+ * in it with placement new and then added to the list
+ * of nodes, so all nodes of a map block sit together.
+ * @param count Number of nodes.
+ * @return Pointer to the first node.
+ */
+Node *SavedBattleGame::allocateNodes(int count)
+{
+	Node *store = static_cast<Node*>(::operator new(sizeof(Node) * count));
+	_nodeStores.push_back(store);
+	_nodeDistances.clear();
+	return store;
+}
+
+/**
+ * Creates a new item and adds it to the list of items. Items are built
+ * with placement new in blocks of ITEM_STORE_SIZE, which the battlegame
+ * frees along with them, so they must never be deleted on their own.
+ * @param rules Pointer to the item rules.
+ * @return Pointer to the new item.
+ */
+BattleItem *SavedBattleGame::createItem(RuleItem *rules)
+{
+	if (_itemStoreUsed == ITEM_STORE_SIZE)
+	{
+		_itemStores.push_back(static_cast<BattleItem*>(::operator new(sizeof(BattleItem) * ITEM_STORE_SIZE)));
+		_itemStoreUsed = 0;
+	}
+	BattleItem *item = new (_itemStores.back() + _itemStoreUsed++) BattleItem(rules);
+	_items.push_back(item);
+	return item;
+}
+
+/**
+ * Calculates the shortest distance between every two nodes along the node links,
+ * with a search from every node. The node graph doesn't change during a battle,
+ * so this only happens once when it's generated (or on the first query), and node
+ * distance queries become table lookups.
+ */
+void SavedBattleGame::calculateNodeDistances()
+{
+	int n = _nodes.size();
+	_nodeDistances.assign(n * n, NODE_UNREACHABLE);
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >, std::greater<std::pair<int, int> > > queue;
+	for (int from = 0; from < n; from++)
+	{
+		Uint16 *distances = &_nodeDistances[from * n];
+		distances[from] = 0;
+		queue.push(std::make_pair(0, from));
+		while (!queue.empty())
+		{
+			int distance = queue.top().first;
+			int node = queue.top().second;
+			queue.pop();
+			if (distance > distances[node])
+				continue;
+			for (int i = 0; i < 5; i++)
+			{
+				const NodeLink &link = _nodes[node]->getNodeLink(i);
+				int to = link.getConnectedNodeID();
+				// negative links lead off the map
+				if (to < 0 || to >= n)
+					continue;
+				int next = std::min(distance + std::max(1, link.getDistance()), NODE_UNREACHABLE - 1);
+				if (next < distances[to])
+				{
+					distances[to] = next;
+					queue.push(std::make_pair(next, to));
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Gets the distance from one node to another, following the node links.
+ * @param from Pointer to the starting node.
+ * @param to Pointer to the destination node.
+ * @return distance in tiles, -1 if the destination can't be reached.
+ */
+int SavedBattleGame::getNodeDistance(const Node *from, const Node *to)
+{
+	if (_nodeDistances.size() != _nodes.size() * _nodes.size())
+	{
+		calculateNodeDistances();
+	}
+	int distance = _nodeDistances[from->getId() * _nodes.size() + to->getId()];
+	return distance == NODE_UNREACHABLE ? -1 : distance;
+}
+
+/**
+ * Gets the node of a certain rank that's nearest to another node,
+ * following the node links.
+ * @param from Pointer to the starting node.
+ * @param rank Rank of the node.
+ * @return Pointer to the node, 0 if no node of that rank can be reached.
+ */
+Node *SavedBattleGame::getNearestNode(const Node *from, NodeRank rank)
+{
+	Node *nearest = 0;
+	int best = -1;
+	for (std::vector<Node*>::iterator i = _nodes.begin(); i != _nodes.end(); i++)
+	{
+		if ((*i)->getRank() != rank)
+			continue;
+		int distance = getNodeDistance(from, *i);
+		if (distance != -1 && (best == -1 || distance < best))
+		{
+			nearest = *i;
+			best = distance;
+		}
+	}
+	return nearest;
+}
+
 /**
  * Gets the list of units.
  * @return pointer to the list of units
@@ -448,19 +1297,28 @@ std::vector<MapDataSet*> *SavedBattleGame::getMapDataSets()
 }
 
 /**
-* get an item from a specific unit and slot
-* @return 
-*/
+ * Adds a map datafile to the ones the battle uses, loading it
+ * if needed. The battle releases it again when it's over.
+ * @param dataSet Pointer to the map datafile.
+ * @param res Pointer to resource pack.
+ */
+void SavedBattleGame::addMapDataSet(MapDataSet *dataSet, ResourcePack *res)
+{
+	dataSet->acquire(res);
+	_mapDataFiles.push_back(dataSet);
+	addTerrainObjects(dataSet);
+	_acquiredMapDataSets = _mapDataFiles.size();
+}
+
+/**
+ * Gets the item a unit holds in an inventory slot.
+ * @param unit Pointer to the unit.
+ * @param slot Inventory slot.
+ * @return Pointer to the item, or 0 if the slot is empty.
+ */
 BattleItem *SavedBattleGame::getItemFromUnit(BattleUnit *unit, InventorySlot slot)
 {
-	for (std::vector<BattleItem*>::iterator i = _items.begin(); i != _items.end(); i++)
-	{
-		if ((*i)->getOwner() == unit && (*i)->getSlot() == slot)
-		{
-			return *i;
-		}
-	}
-	return 0;
+	return unit->getItem(slot);
 }
 
 UnitFaction SavedBattleGame::getSide() const
@@ -486,13 +1344,20 @@ void SavedBattleGame::endTurn()
 		_side = FACTION_PLAYER;
 	}
 
+	// the side that starts its turn sees the map as it is now
+	std::vector<BattleUnit*> side;
 	for (std::vector<BattleUnit*>::iterator i = _units.begin(); i != _units.end(); i++)
 	{
 		if ((*i)->getFaction() == _side)
 		{
 			(*i)->setTimeUnits((*i)->getUnit()->getTimeUnits());
+			if (!(*i)->isOut())
+			{
+				side.push_back(*i);
+			}
 		}
 	}
+	_terrainModifier->calculateFOV(&side);
 
 	_selectedUnit = 0;
 	selectNextPlayerUnit();
@@ -513,6 +1378,69 @@ bool SavedBattleGame::getDebugMode() const
 	return _debugMode;
 }
 
+/**
+ * Adds the state of the battle to the digests of its parts:
+ * the terrain objects and what they block, the light, smoke
+ * and fire of every tile, the units, and what each side
+ * has discovered and can see.
+ * @param parts Array of HASH_PARTS digests.
+ */
+void SavedBattleGame::hash(StateHash *parts) const
+{
+	StateHash *terrain = &parts[HASH_TERRAIN];
+	for (std::vector<Uint16>::const_iterator i = _tileObjects.begin(); i != _tileObjects.end(); i++)
+	{
+		terrain->add(*i);
+	}
+	if (!_blockages.empty())
+	{
+		terrain->add(&_blockages[0], _blockages.size());
+	}
+
+	int tiles = _width * _length * _height;
+	for (int i = 0; i < tiles; i++)
+	{
+		_tiles[i]->hash(&parts[HASH_LIGHTING]);
+	}
+
+	StateHash *units = &parts[HASH_UNITS];
+	units->add(_side);
+	units->add(_turn);
+	for (std::vector<BattleUnit*>::const_iterator i = _units.begin(); i != _units.end(); i++)
+	{
+		BattleUnit *unit = *i;
+		units->add(unit->getId());
+		units->add(unit->getPosition().x);
+		units->add(unit->getPosition().y);
+		units->add(unit->getPosition().z);
+		units->add(unit->getDirection());
+		units->add(unit->getStatus());
+		units->add(unit->getTimeUnits());
+		units->add(unit->getEnergy());
+		units->add(unit->getHealth());
+		units->add(unit->getMorale());
+		units->add(unit->isKneeled());
+	}
+
+	StateHash *visibility = &parts[HASH_VISIBILITY];
+	for (int layer = LAYER_DISCOVERED; layer <= LAYER_VISIBLE_NEUTRAL; layer++)
+	{
+		for (std::vector<Uint32>::const_iterator i = _tileLayers[layer].begin(); i != _tileLayers[layer].end(); i++)
+		{
+			visibility->add((int)*i);
+		}
+	}
+	for (std::vector<BattleUnit*>::const_iterator i = _units.begin(); i != _units.end(); i++)
+	{
+		std::vector<BattleUnit*> *visible = (*i)->getVisibleUnits();
+		visibility->add((int)visible->size());
+		for (std::vector<BattleUnit*>::const_iterator j = visible->begin(); j != visible->end(); j++)
+		{
+			visibility->add((*j)->getId());
+		}
+	}
+}
+
 /** under construction
 *
 */
@@ -22,13 +22,36 @@
 #include <iostream>
 #include <algorithm>
 #include <vector>
+#include <set>
+#include <map>
 #include "yaml.h"
+#include "SDL.h"
 #include "BattleItem.h"
 #include "BattleUnit.h"
+#include "Node.h"
+#include "../Ruleset/RuleItem.h"
+#include "../Ruleset/MapData.h"
+
+#define UNIT_BUCKET_SIZE 10
+#define BLOCKAGE_CHANNELS 6
+#define TILE_DATA_SIZE 11
+#define TILE_EMPTY_RUN 0xFF
+#define TILE_NO_OBJECT 0xFE
+#define NODE_UNREACHABLE 0xFFFF
+#define ITEM_STORE_SIZE 64
+#define TERRAIN_NONE 0
 
 namespace OpenXcom
 {
 
+/// The channel of the blockage grid a damage type known at compile time uses, all the ones no terrain blocks share the first.
+template <ItemDamageType type> struct BlockageChannel { enum { value = 0 }; };
+template <> struct BlockageChannel<DT_NONE> { enum { value = 1 }; };
+template <> struct BlockageChannel<DT_HE> { enum { value = 2 }; };
+template <> struct BlockageChannel<DT_SMOKE> { enum { value = 3 }; };
+template <> struct BlockageChannel<DT_IN> { enum { value = 4 }; };
+template <> struct BlockageChannel<DT_STUN> { enum { value = 5 }; };
+
 class Tile;
 class SavedGame;
 class MapDataSet;
@@ -43,12 +66,43 @@ class Pathfinding;
 class TerrainModifier;
 class BattleItem;
 class Item;
+class Ruleset;
+class RuleItem;
+class StateHash;
 
 /**
  * Enumator containing all the possible mission types.
  */
 enum MissionType { MISS_UFORECOVERY, MISS_UFOASSAULT, MISS_TERROR, MISS_ALIENBASE, MISS_BASEDEFENSE, MISS_CYDONIA };
 
+/**
+ * Enumator containing the packed per-tile flag layers.
+ * The visible layers are in the same order as the unit factions.
+ * The minimap layer holds the tiles whose minimap block is outdated.
+ */
+enum TileLayer { LAYER_CHECKED, LAYER_DISCOVERED, LAYER_VISIBLE_PLAYER, LAYER_VISIBLE_HOSTILE, LAYER_VISIBLE_NEUTRAL, LAYER_MINIMAP, TILE_LAYERS };
+
+/**
+ * Enumator containing the flags of the terrain objects in the terrain table.
+ * Missing objects have no floor, like objects that are flagged so.
+ */
+enum TerrainFlag { TERRAIN_DOOR = 1, TERRAIN_UFO_DOOR = 2, TERRAIN_NO_FLOOR = 4, TERRAIN_BIG_WALL = 8 };
+
+/**
+ * Enumator containing the kinds of changes of a tile that cached results can depend on.
+ */
+enum TerrainChangeType { CHANGE_OBJECT, CHANGE_DOOR, CHANGE_UNIT };
+
+/**
+ * A change of a tile, handed to everything that keeps results depending on the terrain.
+ */
+struct TerrainChange
+{
+	int index, part;
+	TerrainChangeType type;
+	int version;
+};
+
 /**
  * The battlescape data that gets written to disk when the game is saved.
  * A saved game holds all the variable info in a game like mapdata
@@ -59,11 +113,17 @@ class SavedBattleGame
 private:
 	int _width, _length, _height;
 	std::vector<MapDataSet*> _mapDataFiles;
-	Tile **_tiles; 
+	size_t _acquiredMapDataSets;
+	Tile **_tiles;
+	Tile *_tileStore;
 	BattleUnit *_selectedUnit;
-	std::vector<Node*> _nodes;
+	std::vector<Node*> _nodes, _nodeStores;
+	std::vector<Uint16> _nodeDistances;
 	std::vector<BattleUnit*> _units;
-	std::vector<BattleItem*> _items;
+	std::vector<std::vector<BattleUnit*> > _unitBuckets;
+	int _bucketsWide;
+	std::vector<BattleItem*> _items, _itemStores;
+	int _itemStoreUsed;
 	Pathfinding *_pathfinding;
 	TerrainModifier *_terrainModifier;
 	MissionType _missionType;
@@ -71,13 +131,36 @@ private:
 	UnitFaction _side;
 	int _turn;
 	bool _debugMode;
+	std::vector<Uint32> _tileLayers[TILE_LAYERS];
+	bool _visibleDirty[3];
+	std::vector<int> _skyLevels;
+	std::vector<Uint8> _blockages;
+	std::map<MapData*, Uint16> _terrainIds;
+	std::vector<Uint16> _tileObjects;
+	std::vector<Uint8> _terrainTUCosts, _terrainFlags, _terrainLights, _terrainBlocks;
+	std::vector<Sint8> _terrainLevels;
+	std::vector<const Uint16*> _terrainLofts;
+	std::vector<int> _uncachedTiles, _miniMapTiles;
+	int _terrainVersion;
+	std::set<int> _activeTiles, _animatedTiles, _itemTiles;
+	std::string _tileData;
+	/// Rebuilds the visible tile layer of a faction from the field of view of its units.
+	void updateVisibleTiles(UnitFaction faction);
+	/// Gets the index of the unit bucket covering a position.
+	int getUnitBucketIndex(const Position& pos) const;
+	/// Gets the terrain table ID of a terrain object, adding it when it's new.
+	int getTerrainId(MapData *object);
+	/// Adds the terrain objects of a map datafile to the terrain table.
+	void addTerrainObjects(MapDataSet *dataSet);
 public:
 	/// Creates a new battle save, based on current generic save.
 	SavedBattleGame();
 	/// Cleans up the saved game.
 	~SavedBattleGame();
 	/// Loads a saved battle game from YAML.
-	void load(const YAML::Node& node);
+	void load(const YAML::Node& node, Ruleset *rule);
+	/// Loads the terrain and fills in the saved tiles.
+	void loadMap(ResourcePack *res);
 	/// Saves a saved battle game to YAML.
 	void save(YAML::Emitter& out) const;
 	/// Set the dimensions of the map and initializes it.
@@ -86,6 +169,8 @@ public:
 	void initUtilities(ResourcePack *res);
 	/// Gets the game's mapdatafiles.
 	std::vector<MapDataSet*> *getMapDataSets();
+	/// Adds a map datafile used by the battle.
+	void addMapDataSet(MapDataSet *dataSet, ResourcePack *res);
 	/// Set the mission type.
 	void setMissionType(MissionType missionType);
 	/// Get the mission type.
@@ -98,6 +183,16 @@ public:
 	Tile **getTiles();
 	/// Get pointer to the list of nodes.
 	std::vector<Node*> *getNodes();
+	/// Gets memory for nodes to be built in.
+	Node *allocateNodes(int count);
+	/// Creates a new item and adds it to the list of items.
+	BattleItem *createItem(RuleItem *rules);
+	/// Calculates the distances between all nodes.
+	void calculateNodeDistances();
+	/// Gets the distance from one node to another along the node links.
+	int getNodeDistance(const Node *from, const Node *to);
+	/// Gets the nearest node of a certain rank along the node links.
+	Node *getNearestNode(const Node *from, NodeRank rank);
 	/// Get pointer to the list of items.
 	std::vector<BattleItem*> *getItems();
 	/// Get pointer to the list of units.
@@ -114,6 +209,68 @@ public:
 	void getTileCoords(int index, int *x, int *y, int *z);
 	/// Gets the tile at certain position.
 	Tile *getTile(const Position& pos);
+	/// Gets a flag of a tile.
+	bool getTileFlag(TileLayer layer, int index) const;
+	/// Sets a flag of a tile.
+	void setTileFlag(TileLayer layer, int index, bool flag);
+	/// Clears a flag for all tiles.
+	void clearTileLayer(TileLayer layer);
+	/// Marks the visible tiles of a faction as outdated.
+	void setVisibleTilesDirty(UnitFaction faction);
+	/// Checks if a tile is seen by a faction.
+	bool isTileVisible(UnitFaction faction, int index);
+	/// Gets the packed visible tile layer of a faction.
+	const std::vector<Uint32> *getVisibleTiles(UnitFaction faction);
+	/// Adds a tile to the list of tiles that need to be re-cached.
+	void addUncachedTile(int index);
+	/// Gets the list of tiles that need to be re-cached.
+	std::vector<int> *getUncachedTiles();
+	/// Adds a tile to the tiles whose minimap block needs to be redrawn.
+	void addMiniMapTile(int index);
+	/// Gets the tiles whose minimap block needs to be redrawn.
+	std::vector<int> *getMiniMapTiles();
+	/// Adds a tile to the tiles that are burning or smoking.
+	void addActiveTile(int index);
+	/// Gets the tiles that are burning or smoking.
+	std::set<int> *getActiveTiles();
+	/// Adds a tile to the tiles that animate.
+	void addAnimatedTile(int index);
+	/// Gets the tiles that animate.
+	std::set<int> *getAnimatedTiles();
+	/// Gets the tiles that have items lying on them.
+	std::set<int> *getItemTiles();
+	/// Gets the version of the terrain and the units on it.
+	int getTerrainVersion() const;
+	/// Records a change of a tile and lets the cached results that depend on it know.
+	void changeTerrain(int index, int part, TerrainChangeType type);
+	/// Gets the lowest level of a column of tiles that is exposed to the sky.
+	int getSkyLevel(int x, int y);
+	/// Updates the sky level of a column of tiles after its floors changed.
+	void updateSkyLevel(int x, int y);
+	/// Gets how much a part of a tile blocks a type of damage.
+	int getBlockage(int index, int part, ItemDamageType type) const;
+	/// Gets how much a part of a tile blocks a type of damage known at compile time.
+	template <ItemDamageType type> int getBlockage(int index, int part) const;
+	/// Updates how much the parts of a tile block after they changed.
+	void updateBlockage(int index);
+	/// Sets the terrain object of a part of a tile in the terrain table.
+	void setTileObject(int index, int part, MapData *object);
+	/// Gets the terrain table ID of the object on a part of a tile.
+	int getTileObject(int index, int part) const;
+	/// Gets the TU cost of moving over a terrain object.
+	int getTerrainTUCost(int id, MovementType movementType) const;
+	/// Gets the flags of a terrain object.
+	int getTerrainFlags(int id) const;
+	/// Gets the terrain level of a terrain object.
+	int getTerrainLevel(int id) const;
+	/// Gets the amount of light a terrain object is emitting.
+	int getTerrainLight(int id) const;
+	/// Gets how much a terrain object blocks a type of damage.
+	int getTerrainBlock(int id, ItemDamageType type) const;
+	/// Gets how much a terrain object blocks a type of damage known at compile time.
+	template <ItemDamageType type> int getTerrainBlock(int id) const;
+	/// Gets the voxel shape of a layer of a terrain object.
+	const Uint16 *getTerrainLoft(int id, int layer) const;
 	/// get the currently selected unit
 	BattleUnit *getSelectedUnit();
 	/// set the currently selected unit
@@ -124,6 +281,10 @@ public:
 	BattleUnit *selectUnit(const Position& pos);
 	/// select unit with position on map
 	BattleUnit *selectUnit(Tile *tile);
+	/// Moves a unit to the bucket of its current position.
+	void updateUnitBucket(BattleUnit *unit);
+	/// Gets the units within range of a position.
+	void getUnitsInRange(const Position& pos, int range, std::vector<BattleUnit*> *units);
 	/// get the pathfinding object
 	Pathfinding *getPathfinding();
 	/// get the terrainmodifier object
@@ -135,9 +296,33 @@ public:
 	void endTurn();
 	void setDebugMode();
 	bool getDebugMode() const;
+	/// Adds the state of the battle to the digests of its parts.
+	void hash(StateHash *parts) const;
 
 };
 
+/**
+ * Gets the amount a part of a tile blocks, like getBlockage(index, part, type),
+ * but with the channel worked out at compile time, so the lookup can be inlined.
+ * @param index Tile index.
+ * @param part Tile part.
+ * @return amount of blockage
+ */
+template <ItemDamageType type> int SavedBattleGame::getBlockage(int index, int part) const
+{
+	return _blockages[(index * BLOCKAGE_CHANNELS + BlockageChannel<type>::value) * 4 + part];
+}
+
+/**
+ * Gets how much a terrain object blocks a type of damage known at compile time.
+ * @param id Terrain table ID.
+ * @return amount of blockage (0-255)
+ */
+template <ItemDamageType type> int SavedBattleGame::getTerrainBlock(int id) const
+{
+	return _terrainBlocks[id * BLOCKAGE_CHANNELS + BlockageChannel<type>::value];
+}
+
 }
 
 #endif
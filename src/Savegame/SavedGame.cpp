@@ -18,15 +18,23 @@
  */
 #include "SavedGame.h"
 #include <fstream>
+#include <cstdio>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include "../dirent.h"
 #include "yaml.h"
+#include "SDL.h"
 #include "../Ruleset/Ruleset.h"
+#include "../Ruleset/RuleRegion.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Language.h"
 #include "../Interface/TextList.h"
 #include "../Engine/Exception.h"
+#include "../Engine/Profiler.h"
+#include "../Engine/JobPool.h"
+#include "../Engine/StateHash.h"
+#include "../Engine/PolarGrid.h"
 #include "SavedBattleGame.h"
 #include "GameTime.h"
 #include "Country.h"
@@ -36,19 +44,25 @@
 #include "Ufo.h"
 #include "Waypoint.h"
 #include "UfopaediaSaved.h"
+#include "AlienSchedule.h"
+#include "Transfer.h"
+#include "Project.h"
 
 namespace OpenXcom
 {
 
+JobGroup SavedGame::_saving;
+
 /**
  * Initializes a brand new saved game according to the specified difficulty.
  * @param difficulty Game difficulty.
  */
-SavedGame::SavedGame(GameDifficulty difficulty) : _difficulty(difficulty), _funds(0), _countries(), _regions(), _bases(), _ufos(), _craftId(), _waypoints(), _ufoId(1), _waypointId(1), _battleGame(0)
+SavedGame::SavedGame(GameDifficulty difficulty) : _difficulty(difficulty), _funds(0), _fundsHistory(), _countries(), _regions(), _regionIndex(), _bases(), _ufos(), _craftId(), _waypoints(), _ufoId(1), _waypointId(1), _battleGame(0), _hoursPassed(0), _arrivals(), _results(), _researched()
 {
 	RNG::init();
 	_time = new GameTime(6, 1, 1, 1999, 12, 0, 0);
 	_ufopaedia = new UfopaediaSaved();
+	_alienSchedule = new AlienSchedule();
 }
 
 /** 
@@ -79,6 +93,7 @@ SavedGame::~SavedGame()
 	}
 	delete _battleGame;
 	delete _ufopaedia;
+	delete _alienSchedule;
 }
 
 /**
@@ -89,6 +104,7 @@ SavedGame::~SavedGame()
  */
 void SavedGame::getList(TextList *list, Language *lang)
 {
+	TraceMarker trace("list saves");
 	DIR *dp = opendir(USER_DIR);
     if (dp == 0)
 	{
@@ -110,7 +126,25 @@ void SavedGame::getList(TextList *list, Language *lang)
 		{
 			throw Exception("Failed to load savegame");
 		}
-		YAML::Parser parser(fin);
+		// Only the brief info at the start is needed, so stop
+		// reading before the full game data document
+		std::stringstream header;
+		std::string line;
+		bool content = false;
+		while (std::getline(fin, line))
+		{
+			if (line.compare(0, 3, "---") == 0)
+			{
+				if (content)
+					break;
+			}
+			else
+			{
+				content = true;
+			}
+			header << line << std::endl;
+		}
+		YAML::Parser parser(header);
 		YAML::Node doc;
 		
 		parser.GetNextDocument(doc);
@@ -128,6 +162,29 @@ void SavedGame::getList(TextList *list, Language *lang)
     closedir(dp);
 }
 
+/**
+ * Loads a base of a saved game, on a worker thread.
+ * Errors are stored so the main thread can report them.
+ * @param data Pointer to the list of BaseLoads.
+ * @param index Index of the base to load.
+ */
+void SavedGame::loadBase(void *data, int index)
+{
+	BaseLoad *load = &(*(std::vector<BaseLoad>*)data)[index];
+	try
+	{
+		load->base->load(*load->node);
+	}
+	catch (Exception &e)
+	{
+		load->error = e.what();
+	}
+	catch (YAML::Exception &e)
+	{
+		load->error = e.what();
+	}
+}
+
 /**
  * Loads a saved game's contents from a YAML file.
  * @note Assumes the saved game is blank.
@@ -136,6 +193,7 @@ void SavedGame::getList(TextList *list, Language *lang)
  */
 void SavedGame::load(const std::string &filename, Ruleset *rule)
 {
+	TraceMarker trace("load game", filename.c_str());
 	unsigned int size = 0;
 
 	std::string s = USER_DIR + filename + ".sav";
@@ -163,80 +221,132 @@ void SavedGame::load(const std::string &filename, Ruleset *rule)
 	doc["difficulty"] >> a;
 	_difficulty = (GameDifficulty)a;
 	doc["funds"] >> _funds;
+	if (const YAML::Node *pName = doc.FindValue("fundsHistory"))
+	{
+		_fundsHistory.load(*pName);
+	}
+	if (const YAML::Node *pName = doc.FindValue("hoursPassed"))
+	{
+		*pName >> _hoursPassed;
+	}
+	if (const YAML::Node *pName = doc.FindValue("researched"))
+	{
+		*pName >> _researched;
+	}
+
+	if (const YAML::Node *pName = doc.FindValue("rng"))
+	{
+		for (unsigned int i = 0; i < pName->size() && i < RNG_STREAMS; i++)
+		{
+			Uint32 state[RNG_STATE_SIZE];
+			for (int j = 0; j < RNG_STATE_SIZE; j++)
+			{
+				(*pName)[i][j] >> state[j];
+			}
+			RNG::setState((RNGStream)i, state);
+		}
+	}
 
-	size = doc["countries"].size();
+	const YAML::Node &countries = doc["countries"];
+	size = countries.size();
 	for (unsigned int i = 0; i < size; i++)
 	{
 		std::string type;
-		doc["countries"][i]["type"] >> type;
+		countries[i]["type"] >> type;
 		Country *c = new Country(rule->getCountry(type), false);
-		c->load(doc["countries"][i]);
+		c->load(countries[i]);
 		_countries.push_back(c);
 	}
 
-	size = doc["regions"].size();
+	const YAML::Node &regions = doc["regions"];
+	size = regions.size();
 	for (unsigned int i = 0; i < size; i++)
 	{
 		std::string type;
-		doc["regions"][i]["type"] >> type;
+		regions[i]["type"] >> type;
 		Region *r = new Region(rule->getRegion(type));
-		r->load(doc["regions"][i]);
+		r->load(regions[i]);
 		_regions.push_back(r);
 	}
 	
-	size = doc["ufos"].size();
+	const YAML::Node &ufos = doc["ufos"];
+	size = ufos.size();
 	for (unsigned int i = 0; i < size; i++)
 	{
 		std::string type;
-		doc["ufos"][i]["type"] >> type;
+		ufos[i]["type"] >> type;
 		Ufo *u = new Ufo(rule->getUfo(type));
-		u->load(doc["ufos"][i]);
+		u->load(ufos[i]);
 		_ufos.push_back(u);
 	}
 
 	doc["craftId"] >> _craftId;
 
-	size = doc["waypoints"].size();
+	const YAML::Node &waypoints = doc["waypoints"];
+	size = waypoints.size();
 	for (unsigned int i = 0; i < size; i++)
 	{
 		Waypoint *w = new Waypoint();
-		w->load(doc["waypoints"][i]);
+		w->load(waypoints[i]);
 		_waypoints.push_back(w);
 	}
 
 	doc["ufoId"] >> _ufoId;
 	doc["waypointId"] >> _waypointId;
+	if (const YAML::Node *pName = doc.FindValue("alienSchedule"))
+	{
+		_alienSchedule->load(*pName);
+	}
 
-	size = doc["bases"].size();
+	// Bases only refer to each other through their crafts'
+	// destinations, so they're loaded in parallel and linked after
+	const YAML::Node &bases = doc["bases"];
+	size = bases.size();
+	std::vector<BaseLoad> loads;
 	for (unsigned int i = 0; i < size; i++)
 	{
 		Base *b = new Base(rule);
-		b->load(doc["bases"][i], this);
 		_bases.push_back(b);
+		BaseLoad load = { b, &bases[i], "" };
+		loads.push_back(load);
 	}
+	JobPool::parallelFor(size, loadBase, &loads);
+	for (unsigned int i = 0; i < size; i++)
+	{
+		if (!loads[i].error.empty())
+		{
+			throw Exception(loads[i].error);
+		}
+		_bases[i]->loadCraftDestinations(bases[i], this);
+		for (std::vector<Transfer*>::iterator j = _bases[i]->getTransfers()->begin(); j != _bases[i]->getTransfers()->end(); j++)
+		{
+			if (!(*j)->isDelivered())
+			{
+				_arrivals.push(std::make_pair((*j)->getArrival(), std::make_pair(*j, _bases[i])));
+			}
+		}
+	}
+
+	scheduleProjects();
 
 	if (const YAML::Node *pName = doc.FindValue("battleGame"))
 	{
 		_battleGame = new SavedBattleGame();
-		_battleGame->load(*pName);
+		_battleGame->load(*pName, rule);
 	}
 	
 	fin.close();
 }
 
 /**
- * Saves a saved game's contents to a YAML file.
- * @param filename YAML filename.
+ * Serializes a saved game's contents to YAML text. This is all
+ * the saving that needs the game itself, so once it's done the
+ * game can carry on while the text gets written out.
+ * @return YAML text of the save.
  */
-void SavedGame::save(const std::string &filename) const
+std::string SavedGame::serialize() const
 {
-	std::string s = USER_DIR + filename + ".sav";
-	std::ofstream sav(s.c_str());
-	if (!sav)
-	{
-		throw Exception("Failed to save savegame");
-	}
-
+	TraceMarker trace("serialize game");
 	YAML::Emitter out;
 
 	// Saves the brief game info used in the saves list
@@ -252,6 +362,23 @@ void SavedGame::save(const std::string &filename) const
 	out << YAML::BeginMap;
 	out << YAML::Key << "difficulty" << YAML::Value << _difficulty;
 	out << YAML::Key << "funds" << YAML::Value << _funds;
+	out << YAML::Key << "fundsHistory" << YAML::Value;
+	_fundsHistory.save(out);
+	out << YAML::Key << "hoursPassed" << YAML::Value << _hoursPassed;
+	out << YAML::Key << "researched" << YAML::Value << YAML::Flow << _researched;
+	out << YAML::Key << "rng" << YAML::Value;
+	out << YAML::BeginSeq;
+	for (int i = 0; i < RNG_STREAMS; i++)
+	{
+		const Uint32 *state = RNG::getState((RNGStream)i);
+		out << YAML::Flow << YAML::BeginSeq;
+		for (int j = 0; j < RNG_STATE_SIZE; j++)
+		{
+			out << state[j];
+		}
+		out << YAML::EndSeq;
+	}
+	out << YAML::EndSeq;
 	out << YAML::Key << "countries" << YAML::Value;
 	out << YAML::BeginSeq;
 	for (std::vector<Country*>::const_iterator i = _countries.begin(); i != _countries.end(); i++)
@@ -290,6 +417,8 @@ void SavedGame::save(const std::string &filename) const
 	out << YAML::EndSeq;
 	out << YAML::Key << "ufoId" << YAML::Value << _ufoId;
 	out << YAML::Key << "waypointId" << YAML::Value << _waypointId;
+	out << YAML::Key << "alienSchedule" << YAML::Value;
+	_alienSchedule->save(out);
 	if (_battleGame != 0)
 	{
 		out << YAML::Key << "battleGame" << YAML::Value;
@@ -297,8 +426,137 @@ void SavedGame::save(const std::string &filename) const
 	}
 	out << YAML::EndMap;
 
-	sav << out.c_str() << std::endl << out.c_str();
+	return out.c_str();
+}
+
+/**
+ * Writes the YAML text of a save to its file. Doesn't touch
+ * the saved game, so it's safe to run on any thread.
+ * @param filename YAML filename.
+ * @param text YAML text of the save.
+ */
+void SavedGame::write(const std::string &filename, const std::string &text)
+{
+	TraceMarker trace("write game", filename.c_str());
+	// Write to a temporary file first so a failed save
+	// doesn't leave the old one half overwritten
+	std::string s = USER_DIR + filename + ".sav";
+	std::string tmp = USER_DIR + filename + ".tmp";
+	std::ofstream sav(tmp.c_str());
+	if (!sav)
+	{
+		throw Exception("Failed to save savegame");
+	}
+	sav << text << std::endl;
 	sav.close();
+	if (!sav)
+	{
+		remove(tmp.c_str());
+		throw Exception("Failed to save savegame");
+	}
+	// Some platforms can't rename over an existing file
+	if (rename(tmp.c_str(), s.c_str()) != 0)
+	{
+		remove(s.c_str());
+		if (rename(tmp.c_str(), s.c_str()) != 0)
+		{
+			throw Exception("Failed to save savegame");
+		}
+	}
+}
+
+/**
+ * Saves a saved game's contents to a YAML file.
+ * @param filename YAML filename.
+ */
+void SavedGame::save(const std::string &filename) const
+{
+	waitSaves();
+	write(filename, serialize());
+}
+
+/**
+ * Saves a saved game's contents to a YAML file. The game is
+ * serialized straight away, but the file is written on the
+ * job pool, so the game can go on meanwhile. The callback is
+ * run on the main thread once the file is done.
+ * @param filename YAML filename.
+ * @param callback Function to call when the save is over, or 0 for none.
+ * @param data Data to pass to the callback.
+ */
+void SavedGame::saveBackground(const std::string &filename, SaveCallback callback, void *data) const
+{
+	// one at a time, so saves to the same file land in order
+	waitSaves();
+	SaveWrite *save = new SaveWrite();
+	save->filename = filename;
+	save->text = serialize();
+	save->callback = callback;
+	save->data = data;
+	JobPool::run(&_saving, writeSave, save);
+}
+
+/**
+ * Waits for the saves still being written in the background,
+ * for anything that's about to read or replace save files.
+ */
+void SavedGame::waitSaves()
+{
+	JobPool::wait(&_saving);
+}
+
+/**
+ * Entry point of the background save job.
+ * @param data Pointer to the save being written.
+ * @return Always 0.
+ */
+int SavedGame::writeSave(void *data)
+{
+	SaveWrite *save = (SaveWrite*)data;
+	try
+	{
+		write(save->filename, save->text);
+	}
+	catch (Exception &e)
+	{
+		save->error = e.what();
+	}
+	save->text.clear();
+	JobPool::post(finishSave, save);
+	return 0;
+}
+
+/**
+ * Reports a background save as done on the main thread.
+ * @param data Pointer to the save written.
+ * @return Always 0.
+ */
+int SavedGame::finishSave(void *data)
+{
+	SaveWrite *save = (SaveWrite*)data;
+	if (save->callback != 0)
+	{
+		save->callback(save->data, save->error);
+	}
+	delete save;
+	return 0;
+}
+
+/**
+ * Adds the state of the game to the digests of its parts:
+ * everything that gets saved, the random streams, and the
+ * battle state that only lives in memory, like lighting
+ * and what the units can see.
+ * @param parts Array of HASH_PARTS digests.
+ */
+void SavedGame::hash(StateHash *parts) const
+{
+	RNG::hash(&parts[HASH_RNG]);
+	parts[HASH_GAME].add(serialize());
+	if (_battleGame != 0)
+	{
+		_battleGame->hash(parts);
+	}
 }
 
 /**
@@ -321,11 +579,31 @@ void SavedGame::setFunds(int funds)
 
 /**
  * Gives the player his monthly funds, taking in account
- * all maintenance and profit costs.
+ * all maintenance and profit costs, and puts the month
+ * that ended in the history of the funds, countries
+ * and regions.
  */
 void SavedGame::monthlyFunding()
 {
 	_funds += getCountryFunding() - getBaseMaintenance();
+	_fundsHistory.add(_funds);
+	for (std::vector<Country*>::iterator i = _countries.begin(); i != _countries.end(); i++)
+	{
+		(*i)->endMonth();
+	}
+	for (std::vector<Region*>::iterator i = _regions.begin(); i != _regions.end(); i++)
+	{
+		(*i)->endMonth();
+	}
+}
+
+/**
+ * Returns the player's funds at the end of each of the last months.
+ * @return Funds history.
+ */
+const MonthlyHistory &SavedGame::getFundsHistory() const
+{
+	return _fundsHistory;
 }
 
 /**
@@ -369,6 +647,54 @@ std::vector<Region*> *const SavedGame::getRegions()
 	return &_regions;
 }
 
+/**
+ * Sorts the regions into the cells of the world grid they
+ * overlap, so a point only has to be checked against the
+ * few regions around it instead of all of them.
+ * Regions keep their list order within each cell.
+ */
+void SavedGame::buildRegionIndex()
+{
+	_regionIndex.clear();
+	_regionIndex.resize(PolarGrid::COLUMNS * PolarGrid::ROWS);
+	for (unsigned int cell = 0; cell < _regionIndex.size(); cell++)
+	{
+		double lonMin, lonMax, latMin, latMax;
+		PolarGrid::getCellArea(cell, &lonMin, &lonMax, &latMin, &latMax);
+		for (std::vector<Region*>::iterator i = _regions.begin(); i != _regions.end(); i++)
+		{
+			if ((*i)->getRules()->overlapsRegion(lonMin, lonMax, latMin, latMax))
+			{
+				_regionIndex[cell].push_back(*i);
+			}
+		}
+	}
+}
+
+/**
+ * Returns the world region a point is in, looking it up
+ * through the grid cell it falls in.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return Pointer to the region, or 0 if it's in none.
+ */
+Region *SavedGame::locateRegion(double lon, double lat)
+{
+	if (_regionIndex.empty())
+	{
+		buildRegionIndex();
+	}
+	const std::vector<Region*> &candidates = _regionIndex[PolarGrid::getCell(lon, lat)];
+	for (std::vector<Region*>::const_iterator i = candidates.begin(); i != candidates.end(); i++)
+	{
+		if ((*i)->getRules()->insideRegion(lon, lat))
+		{
+			return *i;
+		}
+	}
+	return 0;
+}
+
 /**
  * Returns the list of player bases.
  * @return Pointer to base list.
@@ -499,4 +825,178 @@ UfopaediaSaved *SavedGame::getUfopaedia()
 	return _ufopaedia;
 }
 
+/**
+ * Returns the alien activity planned for the rest of the month.
+ * @return Pointer to the schedule.
+ */
+AlienSchedule *SavedGame::getAlienSchedule()
+{
+	return _alienSchedule;
+}
+
+/**
+ * Returns how many hours have passed since the game
+ * started, which transfers are scheduled by.
+ * @return Hours passed.
+ */
+int SavedGame::getHoursPassed() const
+{
+	return _hoursPassed;
+}
+
+/**
+ * Puts a transfer in transit to a base, scheduled
+ * to arrive once its hours in-transit have passed.
+ * @param base Pointer to destination base.
+ * @param transfer Pointer to the transfer.
+ */
+void SavedGame::addTransfer(Base *base, Transfer *transfer)
+{
+	transfer->schedule(_hoursPassed);
+	base->getTransfers()->push_back(transfer);
+	_arrivals.push(std::make_pair(transfer->getArrival(), std::make_pair(transfer, base)));
+}
+
+/**
+ * Puts every project of every base back in order of when
+ * its next result is due. Only needed when a project's
+ * staff changes, since that's all that moves the due hour.
+ */
+void SavedGame::scheduleProjects()
+{
+	_results = std::priority_queue<ProjectResult, std::vector<ProjectResult>, std::greater<ProjectResult> >();
+	for (std::vector<Base*>::iterator i = _bases.begin(); i != _bases.end(); i++)
+	{
+		for (std::vector<Project*>::iterator j = (*i)->getProjects()->begin(); j != (*i)->getProjects()->end(); j++)
+		{
+			if ((*j)->getDue() != -1)
+			{
+				_results.push(std::make_pair((*j)->getDue(), std::make_pair(*j, *i)));
+			}
+		}
+	}
+}
+
+/**
+ * Starts a new project in a base, counting its
+ * work from the current hour.
+ * @param base Pointer to the base.
+ * @param project Pointer to the project.
+ */
+void SavedGame::addProject(Base *base, Project *project)
+{
+	project->setStaff(project->getStaff(), _hoursPassed);
+	base->getProjects()->push_back(project);
+	if (project->getDue() != -1)
+	{
+		_results.push(std::make_pair(project->getDue(), std::make_pair(project, base)));
+	}
+}
+
+/**
+ * Moves scientists or engineers of a base on or off a
+ * project, and works out again when its results are due.
+ * @param base Pointer to the base of the project.
+ * @param project Pointer to the project.
+ * @param staff New amount of staff on the project.
+ */
+void SavedGame::setProjectStaff(Base *base, Project *project, int staff)
+{
+	int change = staff - project->getStaff();
+	if (project->getType() == PROJECT_RESEARCH)
+	{
+		base->setScientists(base->getScientists() - change);
+	}
+	else
+	{
+		base->setEngineers(base->getEngineers() - change);
+	}
+	project->setStaff(staff, _hoursPassed);
+	scheduleProjects();
+}
+
+/**
+ * Stops a project in a base, sending its staff back
+ * to the base. Any work done on it is lost.
+ * @param base Pointer to the base of the project.
+ * @param project Pointer to the project.
+ */
+void SavedGame::cancelProject(Base *base, Project *project)
+{
+	removeProject(base, project);
+	scheduleProjects();
+}
+
+/**
+ * Takes a project out of a base and sends its staff back,
+ * without touching the schedule of the other projects.
+ * @param base Pointer to the base of the project.
+ * @param project Pointer to the project.
+ */
+void SavedGame::removeProject(Base *base, Project *project)
+{
+	if (project->getType() == PROJECT_RESEARCH)
+	{
+		base->setScientists(base->getScientists() + project->getStaff());
+	}
+	else
+	{
+		base->setEngineers(base->getEngineers() + project->getStaff());
+	}
+	std::vector<Project*>::iterator i = std::find(base->getProjects()->begin(), base->getProjects()->end(), project);
+	if (i != base->getProjects()->end())
+	{
+		base->getProjects()->erase(i);
+	}
+	delete project;
+}
+
+/**
+ * Returns whether a research project on a topic has been finished.
+ * @param name Research topic.
+ * @return True if it's researched.
+ */
+bool SavedGame::isResearched(const std::string &name) const
+{
+	return std::find(_researched.begin(), _researched.end(), name) != _researched.end();
+}
+
+/**
+ * Advances the game by an hour. The transfers and project
+ * results are kept in order of when they're due, so only
+ * the ones that are due get looked at, however many are
+ * in transit or being worked on.
+ * @return Whether any transfer arrived.
+ */
+bool SavedGame::advanceHour()
+{
+	_hoursPassed++;
+	bool arrived = false;
+	while (!_arrivals.empty() && _arrivals.top().first <= _hoursPassed)
+	{
+		_arrivals.top().second.first->arrive(_arrivals.top().second.second);
+		_arrivals.pop();
+		arrived = true;
+	}
+	while (!_results.empty() && _results.top().first <= _hoursPassed)
+	{
+		Project *project = _results.top().second.first;
+		Base *base = _results.top().second.second;
+		_results.pop();
+		if (project->advance(base, _hoursPassed))
+		{
+			if (project->getType() == PROJECT_RESEARCH)
+			{
+				_researched.push_back(project->getName());
+			}
+			removeProject(base, project);
+		}
+		else
+		{
+			_results.push(std::make_pair(project->getDue(), std::make_pair(project, base)));
+		}
+	}
+	return arrived;
+}
+
 }
@@ -22,9 +22,18 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <queue>
+#include <functional>
+#include "../Engine/JobPool.h"
+#include "MonthlyHistory.h"
 
 #define USER_DIR "./USER/"
 
+namespace YAML
+{
+class Node;
+}
+
 namespace OpenXcom
 {
 
@@ -39,6 +48,13 @@ class SavedBattleGame;
 class TextList;
 class Language;
 class UfopaediaSaved;
+class AlienSchedule;
+class Transfer;
+class Project;
+class StateHash;
+
+/// Called on the main thread once a background save is over, with the error if it failed.
+typedef void (*SaveCallback)(void *data, const std::string &error);
 
 /**
  * Enumator containing all the possible game difficulties.
@@ -56,8 +72,12 @@ private:
 	GameDifficulty _difficulty;
 	GameTime *_time;
 	int _funds;
+	MonthlyHistory _fundsHistory;
 	std::vector<Country*> _countries;
 	std::vector<Region*> _regions;
+	/// Regions that might contain each cell of the world grid.
+	std::vector<std::vector<Region*> > _regionIndex;
+	void buildRegionIndex();
 	std::vector<Base*> _bases;
 	std::vector<Ufo*> _ufos;
 	std::map<std::string, int> _craftId;
@@ -65,6 +85,36 @@ private:
 	int _ufoId, _waypointId;
 	SavedBattleGame *_battleGame;
 	UfopaediaSaved *_ufopaedia;
+	AlienSchedule *_alienSchedule;
+	int _hoursPassed;
+	/// A transfer due at a certain hour, and the base it's going to.
+	typedef std::pair<int, std::pair<Transfer*, Base*> > TransferArrival;
+	std::priority_queue<TransferArrival, std::vector<TransferArrival>, std::greater<TransferArrival> > _arrivals;
+	/// A project with a result due at a certain hour, and the base it's in.
+	typedef std::pair<int, std::pair<Project*, Base*> > ProjectResult;
+	std::priority_queue<ProjectResult, std::vector<ProjectResult>, std::greater<ProjectResult> > _results;
+	std::vector<std::string> _researched;
+	void scheduleProjects();
+	void removeProject(Base *base, Project *project);
+	/// A base being loaded on its own thread.
+	struct BaseLoad
+	{
+		Base *base;
+		const YAML::Node *node;
+		std::string error;
+	};
+	static void loadBase(void *data, int index);
+	/// A save being written on its own thread.
+	struct SaveWrite
+	{
+		std::string filename, text, error;
+		SaveCallback callback;
+		void *data;
+	};
+	static JobGroup _saving;
+	static int writeSave(void *data);
+	static int finishSave(void *data);
+	static void write(const std::string &filename, const std::string &text);
 public:
 	/// Creates a new save with a certain difficulty.
 	SavedGame(GameDifficulty difficulty);
@@ -74,14 +124,24 @@ public:
 	static void getList(TextList *list, Language *lang);
 	/// Loads a saved game from YAML.
 	void load(const std::string &filename, Ruleset *rule);
+	/// Serializes a saved game to YAML text.
+	std::string serialize() const;
 	/// Saves a saved game to YAML.
 	void save(const std::string &filename) const;
+	/// Saves a saved game to YAML, writing it out in the background.
+	void saveBackground(const std::string &filename, SaveCallback callback, void *data) const;
+	/// Waits for the saves being written in the background.
+	static void waitSaves();
+	/// Adds the state of the game to the digests of its parts.
+	void hash(StateHash *parts) const;
 	/// Gets the current funds.
 	int getFunds() const;
 	/// Sets new funds.
 	void setFunds(int funds);
 	/// Handles monthly funding.
 	void monthlyFunding();
+	/// Gets the funds at the end of the last months.
+	const MonthlyHistory &getFundsHistory() const;
 	/// Gets the current game time.
 	GameTime *const getTime() const;
 	/// Gets the list of countries.
@@ -90,6 +150,8 @@ public:
 	int getCountryFunding() const;
 	/// Gets the list of regions.
 	std::vector<Region*> *const getRegions();
+	/// Gets the region containing a point.
+	Region *locateRegion(double lon, double lat);
 	/// Gets the list of bases.
 	std::vector<Base*> *const getBases();
 	/// Gets the total base maintenance.
@@ -112,6 +174,22 @@ public:
 	void endBattle();
 	/// Gets the current Ufopaedia parameters.
 	UfopaediaSaved *getUfopaedia();
+	/// Gets the planned alien activity.
+	AlienSchedule *getAlienSchedule();
+	/// Gets the hours passed in the game.
+	int getHoursPassed() const;
+	/// Sends a transfer to a base.
+	void addTransfer(Base *base, Transfer *transfer);
+	/// Starts a project in a base.
+	void addProject(Base *base, Project *project);
+	/// Changes the staff on a project.
+	void setProjectStaff(Base *base, Project *project, int staff);
+	/// Cancels a project in a base.
+	void cancelProject(Base *base, Project *project);
+	/// Gets whether a research topic is done.
+	bool isResearched(const std::string &name) const;
+	/// Advances the game by an hour, delivering the transfers and project results due.
+	bool advanceHour();
 };
 
 }
@@ -17,14 +17,18 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Tile.h"
+#include <algorithm>
 #include "../Ruleset/MapData.h"
 #include "../Ruleset/MapDataSet.h"
 #include "../Engine/SurfaceSet.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Exception.h"
+#include "../Engine/StateHash.h"
 #include "BattleUnit.h"
 #include "BattleItem.h"
 #include "../Ruleset/RuleItem.h"
+#include "SavedBattleGame.h"
+#include "../Battlescape/Pathfinding.h"
 
 namespace OpenXcom
 {
@@ -32,9 +36,11 @@ namespace OpenXcom
 /**
 * constructor
 * @param pos Position.
+* @param save Pointer to the battle game that holds the flag layers of the tile.
 */
-Tile::Tile(const Position& pos): _discovered(false), _smoke(0), _fire(0),  _explosive(0), _pos(pos), _cached(false), _unit(0)
+Tile::Tile(const Position& pos, SavedBattleGame *save): _save(save), _smoke(0), _fire(0),  _explosive(0), _pos(pos), _cached(false), _unit(0), _topItemSprite(-1), _voxelSummary(VOXELS_UNKNOWN)
 {
+	_index = _save->getTileIndex(pos);
 	for (int i = 0; i < 4; i++)
 	{
 		_objects[i] = 0;
@@ -77,7 +83,14 @@ MapData *Tile::getMapData(int part)
 void Tile::setMapData(MapData *dat, int part)
 {
 	_objects[part] = dat;
+	_voxelSummary = VOXELS_UNKNOWN;
 	setCached(false);
+	_save->setTileObject(_index, part, dat);
+	if (dat && dat->isAnimated())
+	{
+		_save->addAnimatedTile(_index);
+	}
+	_save->changeTerrain(_index, part, CHANGE_OBJECT);
 }
 
 /**
@@ -189,6 +202,8 @@ int Tile::openDoor(int part)
 	if (_objects[part]->isUFODoor() && _currentFrame[part] == 0) // ufo door part 0 - door is closed
 	{
 		_currentFrame[part] = 1; // start opening door
+		_save->addAnimatedTile(_index);
+		_save->changeTerrain(_index, part, CHANGE_DOOR);
 		return 1;
 	}
 	if (_objects[part]->isUFODoor() && _currentFrame[part] != 7) // ufo door != part 7 - door is still opening
@@ -223,18 +238,42 @@ int Tile::closeUfoDoor()
 			_currentFrame[part] = 0;
 			retval = 1;
 			setCached(false);
+			_save->changeTerrain(_index, part, CHANGE_DOOR);
 		}
 	}
 
 	return retval;
 }
 
+/**
+ * Gets how much of the tile is filled by the voxels of its terrain objects, so rays can skip empty tiles.
+ * It's unknown until the TerrainModifier calculates it, and again after the objects of the tile changed.
+ * @return summary
+ */
+VoxelSummary Tile::getVoxelSummary() const
+{
+	return _voxelSummary;
+}
+
+/**
+ * Sets how much of the tile is filled by the voxels of its terrain objects.
+ * @param summary
+ */
+void Tile::setVoxelSummary(VoxelSummary summary)
+{
+	_voxelSummary = summary;
+}
+
 /**
  * Sets the tile's cache flag. Set when objects or lighting on this tile changed.
  * @param cached
  */
 void Tile::setCached(bool cached)
 {
+	if (_cached && !cached)
+	{
+		_save->addUncachedTile(_index);
+	}
 	_cached = cached;
 }
 
@@ -254,9 +293,10 @@ bool Tile::isCached()
  */
 void Tile::setDiscovered(bool flag)
 {
-	if (_discovered != flag)
+	if (_save->getTileFlag(LAYER_DISCOVERED, _index) != flag)
 	{
-		_discovered = flag;
+		_save->setTileFlag(LAYER_DISCOVERED, _index, flag);
+		_save->addMiniMapTile(_index);
 		setCached(false);
 	}
 }
@@ -267,7 +307,7 @@ void Tile::setDiscovered(bool flag)
  */
 bool Tile::isDiscovered()
 {
-	return _discovered;
+	return _save->getTileFlag(LAYER_DISCOVERED, _index);
 }
 
 
@@ -295,13 +335,16 @@ void Tile::addLight(int light, int layer)
 /**
  * Tiles that have their light amount changed, need to be re-cached.
  * @param layer Light is seperated in 3 layers: Ambient, Static and Dynamic.
+ * @return bool True when the light amount changed.
  */
-void Tile::checkForChangedLight(int layer)
+bool Tile::checkForChangedLight(int layer)
 {
 	if (_lastLight[layer] != _light[layer])
 	{
 		setCached(false);
+		return true;
 	}
+	return false;
 }
 
 /**
@@ -345,8 +388,6 @@ void Tile::destroy(int part)
 		/* replace with scourched earth */
 		setMapData(MapDataSet::getScourgedEarthTile(), O_FLOOR);
 	}
-
-
 }
 
 /* damage terrain  - check against armor*/
@@ -410,7 +451,7 @@ void Tile::detonate()
 		int flam = getFlammability();
 		if (flam <= 20)
 		{
-			if (RNG::generate(0, 20) - flam >= 0)
+			if (RNG::generate(0, 20, RNG_COMBAT) - flam >= 0)
 			{
 				ignite();
 			}
@@ -496,6 +537,26 @@ void Tile::animate()
 	}
 }
 
+/**
+ * Check if any of the tile parts still animate: objects that look
+ * different between frames, except ufo doors that are closed or open.
+ * @return bool
+ */
+bool Tile::isAnimated()
+{
+	for (int i=0; i < 4; i++)
+	{
+		if (_objects[i] && _objects[i]->isAnimated())
+		{
+			if (!_objects[i]->isUFODoor() || (_currentFrame[i] != 0 && _currentFrame[i] != 7))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 /**
  * Get the sprite of a certain part of the tile.
  * @param part
@@ -513,6 +574,7 @@ Surface *Tile::getSprite(int part)
 void Tile::setUnit(BattleUnit *unit)
 {
 	_unit = unit;
+	_save->changeTerrain(_index, -1, CHANGE_UNIT);
 }
 
 /**
@@ -534,7 +596,11 @@ BattleUnit *Tile::getUnit()
 void Tile::setFire(int fire)
 {
 	_fire = fire;
-	_animationOffset = RNG::generate(0,3);
+	_animationOffset = RNG::generate(0, 3, RNG_COSMETIC);
+	if (_fire > 0)
+	{
+		_save->addActiveTile(_index);
+	}
 }
 
 /**
@@ -554,7 +620,11 @@ void Tile::addSmoke(int smoke)
 {
 	_smoke += smoke;
 	if (_smoke > 40) _smoke = 40;
-	_animationOffset = RNG::generate(0,3);
+	_animationOffset = RNG::generate(0, 3, RNG_COSMETIC);
+	if (_smoke > 0)
+	{
+		_save->addActiveTile(_index);
+	}
 }
 
 /**
@@ -583,25 +653,61 @@ int Tile::getAnimationOffset()
 void Tile::addItem(BattleItem *item)
 {
 	_inventory.push_back(item);
-	setCached(false);
+	if (_inventory.size() == 1)
+	{
+		_topItemSprite = item->getRules()->getFloorSprite();
+		_save->getItemTiles()->insert(_index);
+		setCached(false);
+	}
 }
 
 /**
- * Get the topmost item sprite to draw on the battlescape.
- * @return item sprite ID in floorob, or -1 when no item
+ * Remove an item from the tile.
+ * @param item
  */
-int Tile::getTopItemSprite()
+void Tile::removeItem(BattleItem *item)
 {
-	if (_inventory.size() > 0)
+	std::vector<BattleItem*>::iterator i = std::find(_inventory.begin(), _inventory.end(), item);
+	if (i == _inventory.end())
 	{
-		return _inventory.at(0)->getRules()->getFloorSprite();
+		return;
 	}
-	else
+	bool top = i == _inventory.begin();
+	_inventory.erase(i);
+	if (_inventory.empty())
+	{
+		_topItemSprite = -1;
+		_save->getItemTiles()->erase(_index);
+	}
+	else if (top)
+	{
+		_topItemSprite = _inventory.front()->getRules()->getFloorSprite();
+	}
+	if (top)
 	{
-		return -1;
+		setCached(false);
 	}
 }
 
+/**
+ * Get the items lying on the tile, the first one is the one drawn.
+ * @return pointer to the list of items.
+ */
+std::vector<BattleItem*> *Tile::getInventory()
+{
+	return &_inventory;
+}
+
+/**
+ * Get the topmost item sprite to draw on the battlescape.
+ * It's kept when items are added or removed, so this is just a lookup.
+ * @return item sprite ID in floorob, or -1 when no item
+ */
+int Tile::getTopItemSprite() const
+{
+	return _topItemSprite;
+}
+
 /**
  * New turn preparations. Decrease smoke and fire timers.
  */
@@ -646,7 +752,7 @@ void Tile::prepareNewTurn()
  */
 void Tile::setChecked(bool flag)
 {
-	_checked = flag;
+	_save->setTileFlag(LAYER_CHECKED, _index, flag);
 }
 
 /**
@@ -655,7 +761,23 @@ void Tile::setChecked(bool flag)
  */
 bool Tile::getChecked()
 {
-	return _checked;
+	return _save->getTileFlag(LAYER_CHECKED, _index);
+}
+
+/**
+ * Adds the state of the tile that changes during a battle,
+ * its light layers, smoke and fire, to a digest.
+ * @param hash Pointer to the digest.
+ */
+void Tile::hash(StateHash *hash) const
+{
+	for (int i = 0; i < LIGHTLAYERS; i++)
+	{
+		hash->add(_light[i]);
+	}
+	hash->add(_smoke);
+	hash->add(_fire);
+	hash->add(_explosive);
 }
 
 }
@@ -33,6 +33,11 @@ class Surface;
 class MapData;
 class BattleUnit;
 class BattleItem;
+class SavedBattleGame;
+class StateHash;
+
+/// How much of a tile is filled by the voxels of its terrain objects.
+enum VoxelSummary { VOXELS_UNKNOWN, VOXELS_EMPTY, VOXELS_MIXED, VOXELS_SOLID };
 
 /**
  * Basic element of which a battle map is build.
@@ -43,7 +48,8 @@ class Tile
 protected:
 	MapData *_objects[4];
 	int _currentFrame[4];
-	bool _discovered, _checked;
+	SavedBattleGame *_save;
+	int _index;
 	int _light[LIGHTLAYERS];
 	int _lastLight[LIGHTLAYERS];
 	int _smoke;
@@ -53,10 +59,12 @@ protected:
 	bool _cached;
 	BattleUnit *_unit;
 	std::vector<BattleItem *> _inventory;
+	int _topItemSprite;
 	int _animationOffset;
+	VoxelSummary _voxelSummary;
 public:
 	/// Creates a tile.
-	Tile(const Position& pos);
+	Tile(const Position& pos, SavedBattleGame *save);
 	/// Cleans up a tile.
 	~Tile();
 	/// Gets a pointer to the mapdata for a specific part of the tile.
@@ -83,6 +91,10 @@ public:
 	bool isUfoDoorOpen(int part);
 	/// Close ufo door.
 	int closeUfoDoor();
+	/// Gets how much of the tile is filled by voxels.
+	VoxelSummary getVoxelSummary() const;
+	/// Sets how much of the tile is filled by voxels.
+	void setVoxelSummary(VoxelSummary summary);
 	/// Set the cached flag.
 	void setCached(bool cached);
 	/// Check if tile is cached.
@@ -96,7 +108,7 @@ public:
 	/// Add light to this tile.
 	void addLight(int light, int layer);
 	/// Checks if the light on this tile has changed.
-	void checkForChangedLight(int layer);
+	bool checkForChangedLight(int layer);
 	/// Get the shade amount.
 	int getShade();
 	/// Destroy a tile part.
@@ -109,6 +121,8 @@ public:
 	void detonate();
 	/// Animated the tile parts.
 	void animate();
+	/// Check if any tile part is animated.
+	bool isAnimated();
 	/// Get object sprites.
 	Surface *getSprite(int part);
 	/// Set a unit on this tile.
@@ -131,14 +145,20 @@ public:
 	int getAnimationOffset();
 	/// Add item
 	void addItem(BattleItem *item);
+	/// Remove item
+	void removeItem(BattleItem *item);
+	/// Get the items on the tile.
+	std::vector<BattleItem*> *getInventory();
 	/// Get top-most item
-	int getTopItemSprite();
+	int getTopItemSprite() const;
 	/// Decrease fire and smoke timers.
 	void prepareNewTurn();
 	/// Set whether we checked this tile.
 	void setChecked(bool flag);
 	/// Get whether we checked this tile.
 	bool getChecked();
+	/// Adds the tile's lighting, smoke and fire to a digest.
+	void hash(StateHash *hash) const;
 
 };
 
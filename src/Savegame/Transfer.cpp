@@ -31,7 +31,7 @@ namespace OpenXcom
  * Initializes a transfer.
  * @param hours Hours in-transit.
  */
-Transfer::Transfer(int hours) : _hours(hours), _soldier(0), _craft(0), _itemId(""), _itemQty(0), _scientists(0), _engineers(0), _delivered(false)
+Transfer::Transfer(int hours) : _hours(hours), _arrival(-1), _soldier(0), _craft(0), _itemId(""), _itemQty(0), _scientists(0), _engineers(0), _delivered(false)
 {
 }
 
@@ -55,7 +55,15 @@ Transfer::~Transfer()
  */
 void Transfer::load(const YAML::Node &node, Base *base, Ruleset *rule)
 {
-	node["hours"] >> _hours;
+	// older saves only kept the hours left, counted from hour 0
+	if (const YAML::Node *pName = node.FindValue("arrival"))
+	{
+		*pName >> _arrival;
+	}
+	else
+	{
+		node["hours"] >> _arrival;
+	}
 	if (const YAML::Node *pName = node.FindValue("soldier"))
 	{
 		_soldier = new Soldier(rule->getSoldier("XCOM"), rule->getArmor("STR_NONE_UC"));
@@ -81,7 +89,11 @@ void Transfer::load(const YAML::Node &node, Base *base, Ruleset *rule)
 	{
 		*pName >> _engineers;
 	}
-	node["delivered"] >> _delivered;
+	_delivered = false;
+	if (const YAML::Node *pName = node.FindValue("delivered"))
+	{
+		*pName >> _delivered;
+	}
 }
 
 /**
@@ -91,7 +103,7 @@ void Transfer::load(const YAML::Node &node, Base *base, Ruleset *rule)
 void Transfer::save(YAML::Emitter &out) const
 {
 	out << YAML::BeginMap;
-	out << YAML::Key << "hours" << YAML::Value << _hours;
+	out << YAML::Key << "arrival" << YAML::Value << _arrival;
 	if (_soldier != 0)
 	{
 		out << YAML::Key << "soldier" << YAML::Value;
@@ -201,14 +213,48 @@ std::wstring Transfer::getName(Language *lang) const
 	return lang->getString(_itemId);
 }
 
+/**
+ * Schedules the transfer to arrive once its
+ * hours in-transit have passed.
+ * @param now Hours passed in the game.
+ */
+void Transfer::schedule(int now)
+{
+	_arrival = now + _hours;
+}
+
+/**
+ * Returns the hour the transfer arrives at its destination.
+ * @return Hours passed in the game when it arrives.
+ */
+int Transfer::getArrival() const
+{
+	return _arrival;
+}
+
 /**
  * Returns the time remaining until the
  * transfer arrives at its destination.
+ * @param now Hours passed in the game.
  * @return Amount of hours.
  */
-int Transfer::getHours() const
+int Transfer::getHours(int now) const
+{
+	if (_delivered)
+		return 0;
+	if (_arrival < 0)
+		return _hours;
+	return _arrival - now;
+}
+
+/**
+ * Returns whether the transfer has arrived
+ * at its destination yet.
+ * @return Delivered?
+ */
+bool Transfer::isDelivered() const
 {
-	return _hours;
+	return _delivered;
 }
 
 /**
@@ -258,37 +304,35 @@ TransferType Transfer::getType() const
 }
 
 /**
- * Advances the transfer and takes care of
- * the delivery once it's arrived.
+ * Delivers the transfer to its destination,
+ * once it's arrived. A transfer is only ever delivered once.
  * @param base Pointer to destination base.
  */
-void Transfer::advance(Base *base)
+void Transfer::arrive(Base *base)
 {
-	_hours--;
-	if (_hours == 0)
+	if (_delivered)
+		return;
+	if (_soldier != 0)
+	{
+		base->getSoldiers()->push_back(_soldier);
+	}
+	else if (_craft != 0)
+	{
+		base->getCrafts()->push_back(_craft);
+	}
+	else if (_itemQty != 0)
+	{
+		base->getItems()->addItem(_itemId, _itemQty);
+	}
+	else if (_scientists != 0)
+	{
+		base->setScientists(base->getScientists() + _scientists);
+	}
+	else if (_engineers != 0)
 	{
-		if (_soldier != 0)
-		{
-			base->getSoldiers()->push_back(_soldier);
-		}
-		else if (_craft != 0)
-		{
-			base->getCrafts()->push_back(_craft);
-		}
-		else if (_itemQty != 0)
-		{
-			base->getItems()->addItem(_itemId, _itemQty);
-		}
-		else if (_scientists != 0)
-		{
-			base->setScientists(base->getScientists() + _scientists);
-		}
-		else if (_engineers != 0)
-		{
-			base->setEngineers(base->getEngineers() + _engineers);
-		}
-		_delivered = true;
+		base->setEngineers(base->getEngineers() + _engineers);
 	}
+	_delivered = true;
 }
 
 }
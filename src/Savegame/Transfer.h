@@ -41,7 +41,7 @@ class Ruleset;
 class Transfer
 {
 private:
-	int _hours;
+	int _hours, _arrival;
 	Soldier *_soldier;
 	Craft *_craft;
 	std::string _itemId;
@@ -70,14 +70,20 @@ public:
 	void setEngineers(int engineers);
 	/// Gets the name of the transfer.
 	std::wstring getName(Language *lang) const;
+	/// Schedules the transfer to arrive some hours from now.
+	void schedule(int now);
+	/// Gets the hour the transfer arrives.
+	int getArrival() const;
 	/// Gets the hours remaining of the transfer.
-	int getHours() const;
+	int getHours(int now) const;
+	/// Gets whether the transfer has arrived.
+	bool isDelivered() const;
 	/// Gets the quantity of the transfer.
 	int getQuantity() const;
 	/// Gets the type of the transfer.
 	TransferType getType() const;
-	/// Advances the transfer.
-	void advance(Base *base);
+	/// Delivers the transfer.
+	void arrive(Base *base);
 };
 
 }
@@ -63,6 +63,7 @@ void Ufo::load(const YAML::Node &node)
 	_dest = new Waypoint();
 	_dest->setLongitude(lon);
 	_dest->setLatitude(lat);
+	calculateSpeed();
 }
 
 /**
@@ -295,8 +296,7 @@ void Ufo::think()
 {
 	if (!isCrashed())
 	{
-		setLongitude(_lon + _speedLon);
-		setLatitude(_lat + _speedLat);
+		moveAlongRoute();
 		if (_dest != 0 && finishedRoute())
 		{
 			_lon = _dest->getLongitude();
@@ -109,6 +109,22 @@ namespace OpenXcom {
 
 		return _visible_articles[_current_index];
 	}
+	
+	/**
+	 * get an article near the current one in the list, looping around
+	 * like the navigation does, without changing the current index.
+	 * @param offset Number of articles to move, negative to go back.
+	 * @returns Article definition of the article, 0 on error.
+	 */
+	ArticleDefinition *UfopaediaSaved::getNeighbourArticle(int offset) const
+	{
+		int size = _visible_articles.size();
+		if (size == 0)
+		{
+			return 0;
+		}
+		return _visible_articles[((int)_current_index + offset % size + size) % size];
+	}
 
 	
 	/**
@@ -66,6 +66,9 @@ namespace OpenXcom
 		/// article navigation to previous article.
 		ArticleDefinition *goPrevArticle();
 		
+		/// get the article next to the current one, without moving to it.
+		ArticleDefinition *getNeighbourArticle(int offset) const;
+		
 		/// load a vector with article ids that are currently visible of a given section.
 		void getSectionList(std::string section, ArticleDefinitionList &data);
 		
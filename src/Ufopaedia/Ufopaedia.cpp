@@ -72,6 +72,38 @@ namespace OpenXcom
 		return 0;
 	}
 	
+	/**
+	 * Loads the images of the previous and next articles, so flipping through
+	 * them doesn't wait for the disk. They go in the resource pack's cache
+	 * along with the current one, and only the last few stay there.
+	 * @param game Pointer to actual game.
+	 */
+	void Ufopaedia::prefetchArticles(Game *game)
+	{
+		for (int offset = -1; offset <= 1; offset += 2)
+		{
+			ArticleDefinition *article = game->getSavedGame()->getUfopaedia()->getNeighbourArticle(offset);
+			if (article == 0)
+			{
+				continue;
+			}
+			switch(article->getType())
+			{
+				case UFOPAEDIA_TYPE_CRAFT:
+					game->getResourcePack()->getSurface(static_cast<ArticleDefinitionCraft *> (article)->image_id);
+					break;
+				case UFOPAEDIA_TYPE_CRAFT_WEAPON:
+					game->getResourcePack()->getSurface(static_cast<ArticleDefinitionCraftWeapon *> (article)->image_id);
+					break;
+				case UFOPAEDIA_TYPE_TEXTIMAGE:
+					game->getResourcePack()->getSurface(static_cast<ArticleDefinitionTextImage *> (article)->image_id);
+					break;
+				default:
+					break;
+			}
+		}
+	}
+	
 	/**
 	 * Set UPSaved index and open the new state.
 	 * @param game Pointer to actual game.
@@ -81,6 +113,7 @@ namespace OpenXcom
 	{
 		game->getSavedGame()->getUfopaedia()->setCurrentArticle(article);
 		game->pushState(createArticleState(game, article));
+		prefetchArticles(game);
 	}
 
 	/**
@@ -100,7 +133,12 @@ namespace OpenXcom
 	 */
 	void Ufopaedia::open(Game *game)
 	{
-		game->pushState(new UfopaediaStartState(game));
+		UfopaediaStartState *state = game->getCachedState<UfopaediaStartState>();
+		if (state == 0)
+		{
+			state = new UfopaediaStartState(game);
+		}
+		game->pushState(state);
 	}
 	
 	/**
@@ -114,6 +152,7 @@ namespace OpenXcom
 		{
 			game->popState();
 			game->pushState(createArticleState(game, article));
+			prefetchArticles(game);
 		}
 	}
 	
@@ -128,6 +167,7 @@ namespace OpenXcom
 		{
 			game->popState();
 			game->pushState(createArticleState(game, article));
+			prefetchArticles(game);
 		}
 	}
 	
@@ -75,6 +75,9 @@ namespace OpenXcom
 		
 		/// create a new state object from article definition.
 		static ArticleState *createArticleState(Game *game, ArticleDefinition *article);
+		
+		/// load the images of the articles around the current one.
+		static void prefetchArticles(Game *game);
 	};
 }
 
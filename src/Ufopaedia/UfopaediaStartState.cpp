@@ -83,14 +83,36 @@ namespace OpenXcom
 	}
 	
 	UfopaediaStartState::~UfopaediaStartState()
-	{}
+	{
+	}
 	
+	/**
+	 * Sets the palette, which the Geoscape and the
+	 * articles change while the screen is kept.
+	 */
+	void UfopaediaStartState::init()
+	{
+		_game->setPalette(_game->getResourcePack()->getPalette("PALETTES.DAT_0")->getColors());
+	}
+
+	/**
+	 * Keeps the screen around after it's closed,
+	 * to open it again straight away next time.
+	 * @return Always true.
+	 */
+	bool UfopaediaStartState::isReusable() const
+	{
+		return true;
+	}
+
 	/**
 	 * Returns to the previous screen.
 	 * @param action Pointer to an action.
 	 */
 	void UfopaediaStartState::btnOkClick(Action *action)
 	{
+		// the article images aren't needed until the Ufopaedia is opened again
+		_game->getResourcePack()->releaseCachedSurfaces();
 		_game->popState();
 //		_game->quit();
 	}
@@ -42,6 +42,10 @@ namespace OpenXcom
 	public:
 		UfopaediaStartState(Game *game);
 		virtual ~UfopaediaStartState();
+		/// Updates the palette.
+		void init();
+		/// The start screen never changes, so it's always reused.
+		bool isReusable() const;
 		
 	protected:
 		Window *_window;
@@ -21,7 +21,10 @@
 #include "Engine/CrossPlatform.h"
 #include "Engine/Game.h"
 #include "Engine/Screen.h"
+#include "Engine/Profiler.h"
+#include "Interface/Cursor.h"
 #include "Menu/StartState.h"
+#include "Battlescape/BattlescapeState.h"
 
 /** @mainpage
  * @author SupSuper
@@ -53,18 +56,34 @@ int main(int argc, char** args)
 		// Handles command line arguments
 		int width = 640;
 		int height = 400;
+		bool hardwareCursor = false;
 		for (int i = 1; i < argc; i++)
 		{
 			if (strcmp(args[i], "-fullscreen") == 0)
 				game->getScreen()->setFullscreen(true);
+			if (strcmp(args[i], "-hwcursor") == 0)
+				hardwareCursor = true;
 			if (strcmp(args[i], "-width") == 0 && argc > i + 1)
 				width = atoi(args[i+1]);
 			if (strcmp(args[i], "-height") == 0 && argc > i + 1)
 				height = atoi(args[i+1]);
+			if (strcmp(args[i], "-trace") == 0 && argc > i + 1)
+				Profiler::startTrace(args[i+1]);
+			if (strcmp(args[i], "-opengl") == 0 && argc > i + 1)
+				game->getScreen()->setOpenGL(true, strcmp(args[i+1], "linear") == 0);
+			if (strcmp(args[i], "-fastcombat") == 0 && argc > i + 1)
+				BattlescapeState::setFastCombat(strcmp(args[i+1], "all") == 0 ? FAST_COMBAT_ALL : FAST_COMBAT_HIDDEN);
+			if (strcmp(args[i], "-record") == 0 && argc > i + 1)
+				BattlescapeState::setRecording(args[i+1]);
+			if (strcmp(args[i], "-replay") == 0 && argc > i + 1)
+				BattlescapeState::setReplay(args[i+1]);
 		}
 		game->getScreen()->setResolution(width, height);
+		if (hardwareCursor)
+			game->getCursor()->setHardware(true, (int)game->getScreen()->getXScale());
 		game->setState(new StartState(game));
 		game->run();
+		Profiler::stopTrace();
 #ifndef _DEBUG
 	}
 	catch (std::exception &e)